@@ -0,0 +1,1114 @@
+// triangle_bench: times ofxTriangleMeshCore on a fixed set of synthetic contours.
+// no openFrameworks, no window, no GL, so it runs on any build box:
+//
+//      cmake -S . -B build && cmake --build build && ./build/triangle_bench
+//
+//      triangle_bench [-n iterations] [-s name filter] [-v] [-j threads]
+//
+// -v adds the per phase times and counters of the last run of every case.
+// at the end, a frame's worth of small blobs is meshed one after the other, and as one ofxTriangleMeshBatch
+// (-j picks its number of threads, 0 = every core).  then a big blob that moves a few points every frame
+// is meshed from scratch and with ofxTriangleMeshLive, and a set of shapes that keep coming back
+// is meshed from scratch and through an ofxTriangleMeshCache.  last, shapes of very different sizes are meshed
+// with triangle's memory from malloc() (a new core every time, and one kept core) and from an arena, and
+// unordered point clouds are triangulated with each of triangle's delaunay algorithms.  the bigger shapes are
+// also meshed in vertex cache order, with the simulated cache misses per triangle (acmr) before and after.
+// then a cloud of particles is tested against blobs with isPointInsidePolygon() and an ofxTriangleMeshPolygon,
+// and triangle's exact predicates are timed per test, one call per point or a batch of points per call.
+// last, a tight angle constraint on the bigger shapes is refined in one go, and a slice of time per frame,
+// and a blob is meshed with a fine and a coarse size constraint, and with a sizing field that is fine in one spot.
+// at the very end, a contour traced from an image (a point per pixel) is simplified before it's meshed.
+// clouds with duplicate points are checked against the original triangle.c's output (-s duplicates).
+// every shape is meshed in both modes, with and without an angle constraint.
+// the centroid filter is (triangles x contour points), so it is skipped for the big shapes.
+
+#include "ofxTriangleMeshCore.h"
+#include "ofxTriangleMeshBatch.h"
+#include "ofxTriangleMeshLive.h"
+#include "ofxTriangleMeshCache.h"
+#include "ofxTriangleMeshPolygon.h"
+#include "ofxTriangleMeshSizing.h"
+#include "triangle.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+struct benchShape {
+    string name;
+    vector < vector < float > > outlines;      // x0 y0 x1 y1 ...
+    vector < vector < float > > holes;
+    int numPoints() const {
+        int n = 0;
+        for (int i = 0; i < outlines.size(); i++) n += outlines[i].size() / 2;
+        for (int i = 0; i < holes.size(); i++) n += holes[i].size() / 2;
+        return n;
+    }
+};
+
+
+// same numbers on every machine, so runs can be compared
+static unsigned int benchSeed = 12345;
+static float benchRandom(){
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+    return (benchSeed >> 8) / 16777216.0f;
+}
+
+static void addPoint(vector < float > & ring, float x, float y){
+    ring.push_back(x);
+    ring.push_back(y);
+}
+
+static vector < float > makeEllipse(float cx, float cy, float rx, float ry, int n, bool clockwise = false){
+    vector < float > ring;
+    for (int i = 0; i < n; i++){
+        float t = (clockwise ? -1 : 1) * i * 2 * M_PI / n;
+        addPoint(ring, cx + rx * cos(t), cy + ry * sin(t));
+    }
+    return ring;
+}
+
+static vector < float > makeStar(int spikes, float inner, float outer, int pointsPerEdge){
+    vector < float > ring;
+    int n = spikes * 2;
+    for (int i = 0; i < n; i++){
+        float t0 = i * 2 * M_PI / n;
+        float t1 = (i + 1) * 2 * M_PI / n;
+        float r0 = (i % 2) ? inner : outer;
+        float r1 = (i % 2) ? outer : inner;
+        for (int j = 0; j < pointsPerEdge; j++){
+            float k = j / (float) pointsPerEdge;
+            addPoint(ring, (1 - k) * r0 * cos(t0) + k * r1 * cos(t1), (1 - k) * r0 * sin(t0) + k * r1 * sin(t1));
+        }
+    }
+    return ring;
+}
+
+// a thick band wound around itself: out along one edge, back along the other
+static vector < float > makeSpiral(float turns, float width, int n){
+    vector < float > ring;
+    float maxT = turns * 2 * M_PI;
+    for (int i = 0; i <= n; i++){
+        float t = maxT * i / n;
+        float r = 10 + t * (width * 2 / (2 * M_PI));
+        addPoint(ring, r * cos(t), r * sin(t));
+    }
+    for (int i = n; i >= 0; i--){
+        float t = maxT * i / n;
+        float r = 10 + t * (width * 2 / (2 * M_PI)) + width;
+        addPoint(ring, r * cos(t), r * sin(t));
+    }
+    return ring;
+}
+
+static vector < float > makeBlob(float radius, int n, float noise){
+    vector < float > ring;
+    float phase[4];
+    for (int k = 0; k < 4; k++) phase[k] = benchRandom() * 2 * M_PI;
+    for (int i = 0; i < n; i++){
+        float t = i * 2 * M_PI / n;
+        float r = radius * (1 + 0.2f * sin(3 * t + phase[0]) + 0.1f * sin(7 * t + phase[1]) + 0.05f * sin(13 * t + phase[2]));
+        r += radius * noise * (benchRandom() - 0.5f);
+        addPoint(ring, r * cos(t), r * sin(t));
+    }
+    return ring;
+}
+
+// glyph outlines, in the style of a font's quadratic contours: on-curve points with
+// optional off-curve controls, flattened into 'steps' pieces per curve.
+
+struct glyphPoint { float x, y; bool onCurve; };
+
+static vector < float > flattenGlyphContour(const glyphPoint * pts, int n, int steps, float scale){
+    vector < float > ring;
+    for (int i = 0; i < n; i++){
+        const glyphPoint & p = pts[i];
+        if (!p.onCurve) continue;
+        const glyphPoint & next = pts[(i + 1) % n];
+        addPoint(ring, p.x * scale, p.y * scale);
+        if (next.onCurve) continue;
+        const glyphPoint & end = pts[(i + 2) % n];
+        for (int s = 1; s < steps; s++){
+            float t = s / (float) steps;
+            float a = (1 - t) * (1 - t), b = 2 * (1 - t) * t, c = t * t;
+            addPoint(ring, (a * p.x + b * next.x + c * end.x) * scale, (a * p.y + b * next.y + c * end.y) * scale);
+        }
+    }
+    return ring;
+}
+
+static const glyphPoint glyphA[] = {
+    {0,0,true}, {22,0,true}, {32,30,true}, {68,30,true}, {78,0,true}, {100,0,true}, {62,100,true}, {38,100,true}
+};
+static const glyphPoint glyphACounter[] = {
+    {38,48,true}, {50,82,true}, {62,48,true}
+};
+static const glyphPoint glyphB[] = {
+    {0,0,true}, {55,0,true}, {90,0,false}, {90,28,true}, {90,50,false}, {65,54,true},
+    {85,60,false}, {85,78,true}, {85,100,false}, {52,100,true}, {0,100,true}
+};
+static const glyphPoint glyphBUpper[] = {
+    {20,60,true}, {20,84,true}, {48,84,true}, {65,84,false}, {65,72,true}, {65,60,false}, {48,60,true}
+};
+static const glyphPoint glyphBLower[] = {
+    {20,16,true}, {20,44,true}, {52,44,true}, {70,44,false}, {70,30,true}, {70,16,false}, {52,16,true}
+};
+static const glyphPoint glyphS[] = {
+    {10,12,true}, {30,-4,false}, {55,-4,true}, {92,-4,false}, {92,28,true}, {92,50,false}, {55,58,true},
+    {30,63,false}, {30,75,true}, {30,86,false}, {52,86,true}, {70,86,false}, {82,74,true}, {94,88,true},
+    {78,104,false}, {52,104,true}, {10,104,false}, {10,75,true}, {10,50,false}, {48,44,true},
+    {72,40,false}, {72,28,true}, {72,14,false}, {55,14,true}, {32,14,false}, {20,28,true}
+};
+
+static void addGlyph(vector < benchShape > & shapes, const string & name, int steps,
+                     const glyphPoint * outline, int nOutline,
+                     const glyphPoint * hole1 = NULL, int nHole1 = 0,
+                     const glyphPoint * hole2 = NULL, int nHole2 = 0){
+    benchShape shape;
+    shape.name = name;
+    shape.outlines.push_back(flattenGlyphContour(outline, nOutline, steps, 4));
+    if (hole1 != NULL) shape.holes.push_back(flattenGlyphContour(hole1, nHole1, steps, 4));
+    if (hole2 != NULL) shape.holes.push_back(flattenGlyphContour(hole2, nHole2, steps, 4));
+    shapes.push_back(shape);
+}
+
+#define GLYPH(g) g, (int) (sizeof(g) / sizeof(g[0]))
+
+static vector < benchShape > makeCorpus(){
+
+    vector < benchShape > shapes;
+    benchShape shape;
+
+    int circleSizes[] = { 64, 1024, 16384 };
+    for (int i = 0; i < 3; i++){
+        shape = benchShape();
+        char name[64];
+        sprintf(name, "circle %d", circleSizes[i]);
+        shape.name = name;
+        shape.outlines.push_back(makeEllipse(0, 0, 300, 300, circleSizes[i]));
+        shapes.push_back(shape);
+    }
+
+    shape = benchShape();
+    shape.name = "star 5";
+    shape.outlines.push_back(makeStar(5, 100, 300, 40));
+    shapes.push_back(shape);
+
+    shape = benchShape();
+    shape.name = "star 200";
+    shape.outlines.push_back(makeStar(200, 200, 300, 10));
+    shapes.push_back(shape);
+
+    shape = benchShape();
+    shape.name = "spiral";
+    shape.outlines.push_back(makeSpiral(5, 20, 2000));
+    shapes.push_back(shape);
+
+    shape = benchShape();
+    shape.name = "blob";
+    shape.outlines.push_back(makeBlob(300, 2000, 0.05f));
+    shapes.push_back(shape);
+
+    shape = benchShape();
+    shape.name = "blob noisy";
+    shape.outlines.push_back(makeBlob(300, 8000, 0.2f));
+    shapes.push_back(shape);
+
+    shape = benchShape();
+    shape.name = "blob holes";
+    shape.outlines.push_back(makeEllipse(0, 0, 400, 400, 2000));
+    for (int i = 0; i < 6; i++){
+        float t = i * 2 * M_PI / 6;
+        vector < float > hole = makeBlob(60, 300, 0.1f);
+        for (int j = 0; j < hole.size(); j += 2){
+            hole[j] += 220 * cos(t);
+            hole[j + 1] += 220 * sin(t);
+        }
+        shape.holes.push_back(hole);
+    }
+    shapes.push_back(shape);
+
+    addGlyph(shapes, "glyph A", 8, GLYPH(glyphA), GLYPH(glyphACounter));
+    addGlyph(shapes, "glyph B", 16, GLYPH(glyphB), GLYPH(glyphBUpper), GLYPH(glyphBLower));
+    addGlyph(shapes, "glyph S", 16, GLYPH(glyphS));
+
+    shape = benchShape();
+    shape.name = "glyph O";
+    shape.outlines.push_back(makeEllipse(200, 200, 180, 200, 96));
+    shape.holes.push_back(makeEllipse(200, 200, 110, 140, 72));
+    shapes.push_back(shape);
+
+    return shapes;
+}
+
+
+struct benchResult {
+    int triangles;
+    double medianMicros;
+    double minMicros;
+    size_t memory;
+    ofxTriangleMeshStats stats;
+};
+
+// cacheSize > 0 puts the mesh in vertex cache order for a cache that big
+static benchResult runBench(const benchShape & shape, ofxTriangleMeshMode mode, float angle, int iterations, int cacheSize = 0){
+
+    vector < ofxTriangleMeshPoints > outlines, holes;
+    for (int i = 0; i < shape.outlines.size(); i++){
+        outlines.push_back(ofxTriangleMeshPoints(&shape.outlines[i][0], shape.outlines[i].size() / 2));
+    }
+    for (int i = 0; i < shape.holes.size(); i++){
+        holes.push_back(ofxTriangleMeshPoints(&shape.holes[i][0], shape.holes[i].size() / 2));
+    }
+
+    ofxTriangleMeshCore core;
+    core.setMode(mode);
+    core.setVertexCacheOrder(cacheSize > 0, cacheSize);
+
+    vector < double > times;
+
+    // one extra run to warm the workspace up, it isn't timed
+    for (int it = -1; it < iterations; it++){
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (holes.empty() && outlines.size() == 1){
+            core.triangulate(outlines[0], angle, -1);
+        } else {
+            core.triangulate(outlines, holes, angle, -1);
+        }
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+    }
+
+    sort(times.begin(), times.end());
+
+    benchResult result;
+    result.triangles = core.getNumTriangles();
+    result.medianMicros = times[times.size() / 2];
+    result.minMicros = times[0];
+    result.memory = core.workspace.getMemoryUsage();
+    result.stats = core.getStats();
+    return result;
+}
+
+
+static double median(vector < double > & times){
+    sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// the same contours, one after the other on one core, and then as one batch
+static void runBatchBench(const vector < vector < float > > & blobs, ofxTriangleMeshMode mode, float angle, int threads, int iterations){
+
+    vector < ofxTriangleMeshPoints > contours;
+    for (int i = 0; i < blobs.size(); i++){
+        contours.push_back(ofxTriangleMeshPoints(&blobs[i][0], blobs[i].size() / 2));
+    }
+
+    ofxTriangleMeshCore core;
+    core.setMode(mode);
+    ofxTriangleMeshBatch batch(threads);
+    batch.setMode(mode);
+
+    vector < double > serialTimes, batchTimes;
+    int serialTriangles = 0;
+
+    for (int it = -1; it < iterations; it++){
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        serialTriangles = 0;
+        for (int i = 0; i < contours.size(); i++){
+            core.triangulate(contours[i], angle, -1);
+            serialTriangles += core.getNumTriangles();
+        }
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        if (it >= 0) serialTimes.push_back(chrono::duration < double, micro > (end - start).count());
+
+        start = chrono::steady_clock::now();
+        batch.triangulate(contours, angle, -1);
+        end = chrono::steady_clock::now();
+        if (it >= 0) batchTimes.push_back(chrono::duration < double, micro > (end - start).count());
+    }
+
+    double serialMicros = median(serialTimes);
+    double batchMicros = median(batchTimes);
+
+    printf("%-12s %7d  %-11s %5s %9d %12.1f %12.1f   %d threads, %.2fx%s\n", "blobs", (int) blobs.size(),
+           mode == OFX_TRIANGLE_MESH_CONSTRAINED ? "constrained" : "filter", angle < 0 ? "-" : "28",
+           batch.getStats().triangles, serialMicros, batchMicros, batch.getNumThreads(), serialMicros / batchMicros,
+           batch.getStats().triangles == serialTriangles ? "" : "  (triangle counts differ!)");
+}
+
+
+// a blob that moves a few of its points a little every frame, from scratch every frame and kept live
+static void runLiveBench(int numPoints, int movesPerFrame, int frames){
+
+    vector < float > blob = makeBlob(300, numPoints, 0.01f);
+    ofxTriangleMeshPoints contour(&blob[0], numPoints);
+
+    ofxTriangleMeshCore core;
+    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+    ofxTriangleMeshLive live;
+    live.update(contour);
+
+    vector < double > coreTimes, liveTimes;
+    int edited = 0;
+    bool bSame = true;
+
+    for (int f = 0; f < frames; f++){
+
+        for (int k = 0; k < movesPerFrame; k++){
+            int i = (int) (benchRandom() * numPoints) % numPoints;
+            float t = i * 2 * M_PI / numPoints;
+            float dr = 0.2f * (benchRandom() - 0.5f);
+            blob[i * 2 + 0] += dr * cos(t);
+            blob[i * 2 + 1] += dr * sin(t);
+        }
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        core.triangulate(contour);
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        coreTimes.push_back(chrono::duration < double, micro > (end - start).count());
+
+        start = chrono::steady_clock::now();
+        live.update(contour);
+        end = chrono::steady_clock::now();
+        liveTimes.push_back(chrono::duration < double, micro > (end - start).count());
+
+        if (live.getNumEdits() >= 0) edited++;
+        bSame = bSame && live.getNumTriangles() == core.getNumTriangles();
+    }
+
+    double coreMicros = median(coreTimes);
+    double liveMicros = median(liveTimes);
+
+    printf("%-12s %7d %7d %9d %12.1f %12.1f   %.2fx, %d of %d frames edited%s\n", "blob", numPoints, movesPerFrame,
+           live.getNumTriangles(), coreMicros, liveMicros, coreMicros / liveMicros, edited, frames,
+           bSame ? "" : "  (triangle counts differ!)");
+}
+
+
+// shapes picked at random from a set, like glyphs of a text or recurring masks.  the cache holds
+// about cachedShapes of them, so with more shapes than that some are evicted and meshed again.
+static void runCacheBench(int numShapes, int cachedShapes, int draws){
+
+    vector < vector < float > > shapes;
+    for (int i = 0; i < numShapes; i++) shapes.push_back(makeStar(5 + i % 7, 40 + i, 100, 20));
+
+    ofxTriangleMeshCore core;
+    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+
+    // the size of one entry, to set the cap from
+    ofxTriangleMeshCache cache(1 << 30);
+    vector < ofxTriangleMeshPoints > rings(1, ofxTriangleMeshPoints(&shapes[0][0], shapes[0].size() / 2));
+    double settings[] = { 28 };
+    cache.setKey(rings, settings, 1);
+    core.triangulate(rings[0], 28);
+    cache.store(core.points, core.indices, core.stats);
+    cache.setMaxBytes(cache.getBytes() * cachedShapes);
+    cache.clear();
+
+    vector < int > order;
+    for (int i = 0; i < draws; i++) order.push_back((int) (benchRandom() * numShapes) % numShapes);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < draws; i++){
+        core.triangulate(ofxTriangleMeshPoints(&shapes[order[i]][0], shapes[order[i]].size() / 2), 28);
+    }
+    chrono::steady_clock::time_point end = chrono::steady_clock::now();
+    double scratchMicros = chrono::duration < double, micro > (end - start).count() / draws;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < draws; i++){
+        rings[0] = ofxTriangleMeshPoints(&shapes[order[i]][0], shapes[order[i]].size() / 2);
+        cache.setKey(rings, settings, 1);
+        if (!cache.find(core.points, core.indices, core.stats)){
+            core.triangulate(rings[0], 28);
+            cache.store(core.points, core.indices, core.stats);
+        }
+    }
+    end = chrono::steady_clock::now();
+    double cachedMicros = chrono::duration < double, micro > (end - start).count() / draws;
+
+    printf("%-12s %7d %7d %12.1f %12.1f   %.2fx, %lld hits %lld misses %lld evictions, %.1f KB\n", "stars", numShapes,
+           cachedShapes, scratchMicros, cachedMicros, scratchMicros / cachedMicros,
+           cache.getHits(), cache.getMisses(), cache.getEvictions(), cache.getBytes() / 1024.0);
+}
+
+
+// blobs of 50 to 2000 points, one after the other.  a new core each time allocates
+// everything, a kept one only when a shape is bigger than any before; the arena takes it all back per call.
+static void runArenaBench(int numShapes, int iterations){
+
+    vector < vector < float > > shapes;
+    for (int i = 0; i < numShapes; i++) shapes.push_back(makeBlob(20 + 200 * benchRandom(), 50 + (int) (1950 * benchRandom()), 0.1f));
+
+    const char * names[] = { "new core", "kept core", "arena" };
+
+    ofxTriangleMeshCore kept;
+    ofxTriangleMeshCore arena;
+    kept.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+    arena.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+    arena.workspace.setArena(1 << 20);
+
+    for (int which = 0; which < 3; which++){
+
+        vector < double > times;
+        long allocations = 0;
+        int triangles = 0;
+
+        // one extra pass to warm up, it isn't timed
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int i = 0; i < numShapes; i++){
+                ofxTriangleMeshPoints contour(&shapes[i][0], shapes[i].size() / 2);
+                if (which == 0){
+                    ofxTriangleMeshCore core;
+                    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+                    core.triangulate(contour);
+                    if (it == 0){
+                        allocations += core.getStats().allocations;
+                        triangles += core.getNumTriangles();
+                    }
+                } else {
+                    ofxTriangleMeshCore & core = (which == 1) ? kept : arena;
+                    core.triangulate(contour);
+                    if (it == 0){
+                        allocations += core.getStats().allocations;
+                        triangles += core.getNumTriangles();
+                    }
+                }
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count() / numShapes);
+        }
+
+        ofxTriangleMeshCore & core = (which == 2) ? arena : kept;
+        printf("%-12s %7d %9d %12.1f %12.2f %10.1f\n", names[which], numShapes, triangles, median(times),
+               (double) allocations / numShapes, (which == 0) ? 0.0 : core.workspace.getMemoryUsage() / 1024.0);
+    }
+}
+
+
+// a shape as triangle hands it back, and in vertex cache order: what the cache misses go down to, and what that costs.
+static void runOrderBench(const benchShape & shape, float angle, int cacheSize, int iterations){
+
+    benchResult plain = runBench(shape, OFX_TRIANGLE_MESH_CONSTRAINED, angle, iterations);
+    benchResult ordered = runBench(shape, OFX_TRIANGLE_MESH_CONSTRAINED, angle, iterations, cacheSize);
+
+    printf("%-12s %7d %5s %6d %9d %9.3f %9.3f %12.1f %12.1f\n", shape.name.c_str(), shape.numPoints(), angle > 0 ? "28" : "-",
+           cacheSize, ordered.triangles, ordered.stats.acmrBefore, ordered.stats.acmrAfter, plain.medianMicros, ordered.medianMicros);
+}
+
+
+// random points, no contour: triangle on its own, with a workspace, for each way it can build the delaunay triangulation.
+// plain incremental insertion ("i") is left out above 100k points, it gets too slow.
+static void runAlgorithmBench(int numPoints, int iterations){
+
+    vector < double > cloud;
+    for (int i = 0; i < numPoints * 2; i++) cloud.push_back(1000 * benchRandom());
+
+    // "d and c t" is divide and conquer on one thread per core, same mesh as "d and c"
+    const char * names[] = { "d and c", "d and c t", "sweepline", "incremental", "brio" };
+    const char * switches[] = { "zQ", "zQt", "zQF", "zQi", "zQb" };
+
+    struct triangulateworkspace * ws = triworkspacenew();
+
+    for (int which = 0; which < 5; which++){
+
+        if (which == 3 && numPoints > 100000) continue;
+
+        vector < double > times;
+        int triangles = 0;
+        struct triangulatestats stats;
+
+        for (int it = -1; it < iterations; it++){
+            struct triangulateio in, out;
+            memset(&in, 0, sizeof(in));
+            memset(&out, 0, sizeof(out));
+            in.pointlist = &cloud[0];
+            in.numberofpoints = numPoints;
+
+            char flags[8];
+            strcpy(flags, switches[which]);
+
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            triangulatews(flags, &in, &out, NULL, ws);
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+            triangles = out.numberoftriangles;
+        }
+
+        // what the mesh itself took: half as much for the triangles with -DOFXTRIANGLEMESH_INDEX32=ON
+        triworkspacestats(ws, &stats);
+        printf("%-12s %7d %9d %12.1f %10.1f\n", names[which], numPoints, triangles, median(times),
+               (stats.trianglepoolbytes + stats.vertexpoolbytes) / 1024.0);
+    }
+
+    triworkspacefree(ws);
+}
+
+
+// small blobs, as the wrapper meshes them, with the settings as a switch string that is built and parsed
+// every call (as the wrapper used to), or as a triangulateparams.
+static void runParamsBench(int numShapes, int numPoints, float angle, int iterations){
+
+    vector < vector < double > > shapes;
+    vector < int > segments;
+    for (int i = 0; i < numShapes; i++){
+        vector < float > blob = makeBlob(20 + 40 * benchRandom(), numPoints, 0.1f);
+        shapes.push_back(vector < double > (blob.begin(), blob.end()));
+    }
+    for (int i = 0; i < numPoints; i++){
+        segments.push_back(i);
+        segments.push_back((i + 1) % numPoints);
+    }
+
+    const char * names[] = { "switches", "params" };
+
+    struct triangulateworkspace * ws = triworkspacenew();
+
+    for (int which = 0; which < 2; which++){
+
+        vector < double > times;
+        int triangles = 0;
+
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (int i = 0; i < numShapes; i++){
+                struct triangulateio in, out;
+                memset(&in, 0, sizeof(in));
+                memset(&out, 0, sizeof(out));
+                in.pointlist = &shapes[i][0];
+                in.numberofpoints = numPoints;
+                in.segmentlist = &segments[0];
+                in.numberofsegments = numPoints;
+
+                if (which == 0){
+                    char flags[64];
+                    char * flag = flags;
+                    flag += sprintf(flag, "zYQpP");
+                    if (angle > 0) flag += sprintf(flag, "q%g", angle);
+                    triangulatews(flags, &in, &out, NULL, ws);
+                } else {
+                    struct triangulateparams params;
+                    triparamsinit(&params);
+                    params.nobisect = 1;
+                    params.poly = params.nopolywritten = 1;
+                    if (angle > 0) params.minangle = angle;
+                    triangulatewith(&params, &in, &out, NULL, ws);
+                }
+                if (it == 0) triangles += out.numberoftriangles;
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count() / numShapes);
+        }
+
+        printf("%-12s %7d %5s %9d %12.2f\n", names[which], numPoints, angle > 0 ? "28" : "-", triangles, median(times));
+    }
+
+    triworkspacefree(ws);
+}
+
+
+// particles against a contour: the reference test per point, the prepared polygon per point, and all points in one call.
+// "inside" counts the points inside, it has to be the same for all three.
+static void runPolygonBench(int numPoints, int numParticles, int iterations){
+
+    vector < float > blob = makeBlob(300, numPoints, 0.2f);
+    ofxTriangleMeshPoints contour(&blob[0], numPoints);
+
+    vector < float > particles;
+    for (int i = 0; i < numParticles * 2; i++) particles.push_back(800 * benchRandom() - 400);
+    ofxTriangleMeshPoints points(&particles[0], numParticles);
+
+    ofxTriangleMeshPolygon polygon;
+    vector < unsigned char > inside(numParticles);
+
+    const char * names[] = { "reference", "prepared", "batch" };
+
+    for (int which = 0; which < 3; which++){
+
+        vector < double > times;
+        int numInside = 0;
+
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            numInside = 0;
+            if (which == 0){
+                for (int i = 0; i < numParticles; i++){
+                    numInside += ofxTriangleMeshCore::isPointInsidePolygon(contour, particles[i * 2], particles[i * 2 + 1]);
+                }
+            } else {
+                // the bands are made again every time, as for a blob that moves every frame
+                polygon.setup(contour);
+                if (which == 1){
+                    for (int i = 0; i < numParticles; i++) numInside += polygon.isInside(particles[i * 2], particles[i * 2 + 1]);
+                } else {
+                    polygon.isInside(points, &inside[0]);
+                    for (int i = 0; i < numParticles; i++) numInside += inside[i];
+                }
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+        }
+
+        printf("%-12s %7d %9d %5d %8d %12.1f\n", names[which], numPoints, numParticles,
+               (which == 0) ? 1 : ofxTriangleMeshPolygon::getLanes(), numInside, median(times));
+    }
+}
+
+
+// the predicates triangle's meshing runs on, a call per test or (incircle) a batch of points per call.
+// random points almost never need the exact fallback, points on a small grid (collinear / cocircular) often do.
+static void runPredicateBench(bool bGrid, int numPoints, int iterations){
+
+    vector < double > points;
+    for (int i = 0; i < numPoints * 2; i++) points.push_back(bGrid ? (double) (int) (8 * benchRandom()) : 1000 * benchRandom());
+    double a[2] = { 0, 0 }, b[2] = { 7, 0 }, c[2] = { 7, 7 };
+    if (!bGrid){
+        a[0] = 100; a[1] = 150;  b[0] = 900; b[1] = 200;  c[0] = 500; c[1] = 800;
+    }
+
+    vector < double > results(numPoints);
+    const char * names[] = { "orient", "incircle", "incircles" };
+
+    for (int which = 0; which < 3; which++){
+
+        vector < double > times;
+        int positive = 0;
+
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            if (which == 0){
+                for (int i = 0; i < numPoints; i++) results[i] = triorient(a, b, &points[i * 2]);
+            } else if (which == 1){
+                for (int i = 0; i < numPoints; i++) results[i] = triincircle(a, b, c, &points[i * 2]);
+            } else {
+                triincircles(a, b, c, &points[0], numPoints, &results[0]);
+            }
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, nano > (end - start).count() / numPoints);
+        }
+
+        for (int i = 0; i < numPoints; i++) positive += (results[i] > 0);
+        printf("%-12s %7s %9d %9d %12.2f\n", names[which], bGrid ? "grid" : "random", numPoints, positive, median(times));
+    }
+}
+
+
+// a tight angle constraint refined in one go, and then a few milliseconds per frame with refine():
+// how long until there is a first mesh, the longest frame, and what the frames add up to.
+static void runRefineBench(const benchShape & shape, float angle, float sliceMillis){
+
+    vector < ofxTriangleMeshPoints > outlines, holes;
+    for (int i = 0; i < shape.outlines.size(); i++){
+        outlines.push_back(ofxTriangleMeshPoints(&shape.outlines[i][0], shape.outlines[i].size() / 2));
+    }
+    for (int i = 0; i < shape.holes.size(); i++){
+        holes.push_back(ofxTriangleMeshPoints(&shape.holes[i][0], shape.holes[i].size() / 2));
+    }
+
+    ofxTriangleMeshCore core;
+    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+
+    // warm up, then one go
+    core.triangulate(outlines, holes, angle, -1);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    core.triangulate(outlines, holes, angle, -1);
+    double wholeMicros = chrono::duration < double, micro > (chrono::steady_clock::now() - start).count();
+    int wholeTriangles = core.getNumTriangles();
+
+    core.setBudget(-1, -1, sliceMillis);
+
+    vector < double > frames;
+    start = chrono::steady_clock::now();
+    core.triangulate(outlines, holes, angle, -1);
+    frames.push_back(chrono::duration < double, micro > (chrono::steady_clock::now() - start).count());
+    int firstTriangles = core.getNumTriangles();
+
+    while (core.isRefining()){
+        start = chrono::steady_clock::now();
+        core.refine(-1, sliceMillis);
+        frames.push_back(chrono::duration < double, micro > (chrono::steady_clock::now() - start).count());
+    }
+
+    double totalMicros = 0;
+    for (int i = 0; i < frames.size(); i++) totalMicros += frames[i];
+
+    printf("%-12s %7d %5.0f %6.1f %9d %12.1f %9d %7d %12.1f %12.1f %12.1f%s\n", shape.name.c_str(), shape.numPoints(), angle,
+           sliceMillis, wholeTriangles, wholeMicros, firstTriangles, (int) frames.size(), frames[0],
+           *max_element(frames.begin(), frames.end()), totalMicros,
+           core.getNumTriangles() == wholeTriangles ? "" : "  (triangle counts differ)");
+}
+
+
+// a blob with a fine size constraint everywhere, a coarse one, and a sizing field that is as fine as the first
+// around one spot and as coarse as the second far from it.  then the lookup on its own, per test.
+static void runSizingBench(int numPoints, float minArea, float maxArea, int iterations){
+
+    vector < float > blob = makeBlob(300, numPoints, 0.2f);
+    ofxTriangleMeshPoints contour(&blob[0], numPoints);
+
+    // a spot of detail on the left of the blob, on a 64 x 64 grid over it
+    int gridSize = 64;
+    vector < float > density(gridSize * gridSize);
+    for (int j = 0; j < gridSize; j++){
+        for (int i = 0; i < gridSize; i++){
+            float dx = (i + 0.5f) / gridSize - 0.3f;
+            float dy = (j + 0.5f) / gridSize - 0.5f;
+            density[j * gridSize + i] = expf(-(dx * dx + dy * dy) / 0.02f);
+        }
+    }
+    ofxTriangleMeshSizing sizing;
+    sizing.setupFromDensity(&density[0], gridSize, gridSize, 1, -400, -400, 800, 800, minArea, maxArea);
+
+    ofxTriangleMeshCore core;
+    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+
+    const char * names[] = { "fine", "coarse", "field" };
+
+    for (int which = 0; which < 3; which++){
+
+        core.setSizing((which == 2) ? &sizing : NULL);
+        float area = (which == 0) ? minArea : (which == 1) ? maxArea : -1;
+
+        vector < double > times;
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            core.triangulate(contour, 25, area);
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+        }
+
+        printf("%-12s %7d %9.0f %9.0f %9d %12.1f\n", names[which], numPoints, (which == 1) ? maxArea : minArea,
+               (which == 0) ? minArea : maxArea, core.getNumTriangles(), median(times));
+    }
+
+    // random spots, 3 at a time as triangle's corners
+    int numTests = 1000000;
+    vector < double > corners;
+    for (int i = 0; i < numTests * 2 + 4; i++) corners.push_back(800 * benchRandom() - 400);
+
+    vector < double > times;
+    int tooBig = 0;
+    for (int it = -1; it < iterations; it++){
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        tooBig = 0;
+        for (int i = 0; i < numTests; i++){
+            tooBig += sizing.isTooBig(&corners[i * 2], &corners[i * 2 + 2], &corners[i * 2 + 4], 1000);
+        }
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        if (it >= 0) times.push_back(chrono::duration < double, nano > (end - start).count() / numTests);
+    }
+
+    printf("%-12s %7d %9s %9s %9d %12.2f ns / test, %d KB\n", "lookup", numTests, "", "", tooBig, median(times),
+           (int) (sizing.getMemoryUsage() / 1024));
+}
+
+
+// a smooth blob as a tracker would hand it over, on the pixel grid with a point per pixel step,
+// meshed with a 28 degree constraint as it is, and simplified first with both methods, with and without resampling.
+// visvalingam's tolerance is an area (its square), so it gets a bigger one to drop about as many points.
+static void runSimplifyBench(float radius, int iterations){
+
+    vector < float > blob = makeBlob(radius, (int) (2 * M_PI * radius * 2), 0);
+    vector < float > traced;
+    for (int i = 0; i < blob.size() / 2; i++){
+        float x = roundf(blob[i * 2 + 0]);
+        float y = roundf(blob[i * 2 + 1]);
+        int n = traced.size();
+        if (n > 0 && traced[n - 2] == x && traced[n - 1] == y) continue;
+        addPoint(traced, x, y);
+    }
+    ofxTriangleMeshPoints contour(&traced[0], traced.size() / 2);
+
+    ofxTriangleMeshCore core;
+    core.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
+
+    const char * names[] = { "none", "douglas", "douglas", "visvalingam", "visvalingam" };
+
+    for (int which = 0; which < 5; which++){
+
+        float tolerance = (which == 0) ? 0 : (which < 3) ? 1 : 3;
+        float maxEdgeLength = (which == 2 || which == 4) ? radius / 10 : -1;
+        core.setSimplify(tolerance, (which < 3) ? OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER : OFX_TRIANGLE_MESH_VISVALINGAM, maxEdgeLength);
+
+        vector < double > times;
+        for (int it = -1; it < iterations; it++){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            core.triangulate(contour, 28, -1);
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+        }
+
+        const ofxTriangleMeshStats & stats = core.getStats();
+        printf("%-12s %9.1f %9.0f %7d %7d %9d %12.1f\n", names[which], tolerance, maxEdgeLength,
+               stats.contourPoints, stats.inputPoints, stats.triangles, median(times));
+    }
+}
+
+
+// points on a coarse grid, so many of them land on the same spot.  triangle keeps one of each and the
+// rest are dropped; which one is kept shows up in the triangle and marker lists, so those are hashed and
+// checked against what the original triangle.c (quicksort only, no radix sort) gives for the same cloud.
+
+struct duplicateCase {
+    int numPoints;
+    int grid;
+    const char * switches;
+    unsigned long long baseline;
+};
+
+static unsigned long long hashBytes(const void * data, size_t n, unsigned long long h){
+    const unsigned char * bytes = (const unsigned char *) data;
+    for (size_t i = 0; i < n; i++){
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static void runDuplicateBench(const duplicateCase & dup, int iterations){
+
+    // its own seed, so the cloud (and the baseline) don't depend on which other sections ran
+    benchSeed = dup.numPoints + dup.grid;
+    vector < double > cloud;
+    for (int i = 0; i < dup.numPoints * 2; i++) cloud.push_back((int) (dup.grid * benchRandom()));
+
+    vector < double > times;
+    int triangles = 0;
+    unsigned long long hash = 0;
+
+    for (int it = -1; it < iterations; it++){
+        struct triangulateio in, out;
+        memset(&in, 0, sizeof(in));
+        memset(&out, 0, sizeof(out));
+        in.pointlist = &cloud[0];
+        in.numberofpoints = dup.numPoints;
+
+        char flags[8];
+        strcpy(flags, dup.switches);
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        triangulate(flags, &in, &out, NULL);
+        chrono::steady_clock::time_point end = chrono::steady_clock::now();
+        if (it >= 0) times.push_back(chrono::duration < double, micro > (end - start).count());
+
+        triangles = out.numberoftriangles;
+        hash = 1469598103934665603ull;
+        hash = hashBytes(out.trianglelist, out.numberoftriangles * 3 * sizeof(int), hash);
+        hash = hashBytes(out.pointmarkerlist, out.numberofpoints * sizeof(int), hash);
+        trifree(out.pointlist);
+        trifree(out.pointmarkerlist);
+        trifree(out.trianglelist);
+    }
+
+    printf("%-12s %7d %5d %9d %12.1f %016llx %s\n", dup.switches, dup.numPoints, dup.grid, triangles, median(times),
+           hash, hash == dup.baseline ? "same" : "DIFFERENT");
+}
+
+
+int main(int argc, char ** argv){
+
+    int iterations = 10;
+    const char * nameFilter = NULL;
+    bool bVerbose = false;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            iterations = max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            nameFilter = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0){
+            bVerbose = true;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+            threads = max(0, atoi(argv[++i]));
+        } else {
+            printf("usage: %s [-n iterations] [-s name filter] [-v] [-j threads]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    vector < benchShape > shapes = makeCorpus();
+
+    printf("%-12s %7s  %-11s %5s %9s %12s %12s %10s\n", "shape", "points", "mode", "q", "triangles", "median us", "min us", "memory KB");
+
+    for (int i = 0; i < shapes.size(); i++){
+
+        const benchShape & shape = shapes[i];
+        if (nameFilter != NULL && shape.name.find(nameFilter) == string::npos) continue;
+
+        for (int m = 0; m < 2; m++){
+
+            ofxTriangleMeshMode mode = (m == 0) ? OFX_TRIANGLE_MESH_FILTER_CENTROIDS : OFX_TRIANGLE_MESH_CONSTRAINED;
+
+            // the filter only works on one contour, and is too slow to bother with on big ones
+            if (mode == OFX_TRIANGLE_MESH_FILTER_CENTROIDS && (shape.outlines.size() != 1 || !shape.holes.empty() || shape.numPoints() > 4096)) continue;
+
+            for (int q = 0; q < 2; q++){
+                float angle = (q == 0) ? -1 : 28;
+                benchResult result = runBench(shape, mode, angle, iterations);
+                printf("%-12s %7d  %-11s %5s %9d %12.1f %12.1f %10.1f\n", shape.name.c_str(), shape.numPoints(),
+                       mode == OFX_TRIANGLE_MESH_CONSTRAINED ? "constrained" : "filter",
+                       q == 0 ? "-" : "28", result.triangles, result.medianMicros, result.minMicros, result.memory / 1024.0);
+                if (bVerbose){
+                    const ofxTriangleMeshStats & st = result.stats;
+                    printf("    us: input %.1f delaunay %.1f segments %.1f holes %.1f quality %.1f output %.1f wrapper %.1f\n",
+                           st.inputNanos / 1000.0, st.delaunayNanos / 1000.0, st.segmentNanos / 1000.0, st.holeNanos / 1000.0,
+                           st.qualityNanos / 1000.0, st.outputNanos / 1000.0, st.wrapperNanos / 1000.0);
+                    printf("    incircle %ld orient %ld circumcenter %ld steiner %d  pool KB: vertex %.1f triangle %.1f subseg %.1f\n",
+                           st.incircleTests, st.orientationTests, st.circumcenters, st.steinerPoints,
+                           st.vertexPoolBytes / 1024.0, st.trianglePoolBytes / 1024.0, st.subsegPoolBytes / 1024.0);
+                    printf("    allocations %ld (%.1f KB)\n", st.allocations, st.allocatedBytes / 1024.0);
+                }
+            }
+        }
+    }
+
+    // 256 tracked blobs of 200 points each, as in a busy frame of a tracker
+    if (nameFilter == NULL || string("blobs").find(nameFilter) != string::npos){
+
+        vector < vector < float > > blobs;
+        for (int i = 0; i < 256; i++) blobs.push_back(makeBlob(20 + 40 * benchRandom(), 200, 0.1f));
+
+        printf("\n%-12s %7s  %-11s %5s %9s %12s %12s\n", "batch", "shapes", "mode", "q", "triangles", "serial us", "batch us");
+        for (int m = 0; m < 2; m++){
+            ofxTriangleMeshMode mode = (m == 0) ? OFX_TRIANGLE_MESH_FILTER_CENTROIDS : OFX_TRIANGLE_MESH_CONSTRAINED;
+            for (int q = 0; q < 2; q++){
+                runBatchBench(blobs, mode, (q == 0) ? -1 : 28, threads, iterations);
+            }
+        }
+    }
+
+    // one contour that changes a little every frame
+    if (nameFilter == NULL || string("live").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %7s %9s %12s %12s\n", "live", "points", "moves", "triangles", "scratch us", "live us");
+        runLiveBench(1000, 4, iterations * 10);
+        runLiveBench(10000, 4, iterations * 10);
+        runLiveBench(10000, 64, iterations * 10);
+    }
+
+    // shapes that keep coming back, meshed every time or kept in a cache
+    if (nameFilter == NULL || string("cache").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %7s %12s %12s\n", "cache", "shapes", "cached", "scratch us", "cached us");
+        runCacheBench(32, 64, iterations * 100);
+        runCacheBench(64, 32, iterations * 100);
+    }
+
+    // triangle's memory from malloc() or from an arena
+    if (nameFilter == NULL || string("arena").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %9s %12s %12s %10s\n", "memory", "shapes", "triangles", "us / shape", "allocs", "memory KB");
+        runArenaBench(64, iterations);
+    }
+
+    // the settings of a call as a switch string or as a struct
+    if (nameFilter == NULL || string("params").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %5s %9s %12s\n", "settings", "points", "q", "triangles", "us / shape");
+        runParamsBench(256, 16, -1, iterations * 10);
+        runParamsBench(256, 16, 28, iterations * 10);
+        runParamsBench(256, 200, 28, iterations);
+    }
+
+    // the bigger shapes, in vertex cache order for a cache of 16 and of 32 points
+    if (nameFilter == NULL || string("order").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %5s %6s %9s %9s %9s %12s %12s\n", "order", "points", "q", "cache", "triangles", "acmr in", "acmr out", "plain us", "ordered us");
+        for (int i = 0; i < shapes.size(); i++){
+            if (shapes[i].numPoints() < 1000) continue;
+            for (int q = 0; q < 2; q++){
+                runOrderBench(shapes[i], (q == 0) ? -1 : 28, 16, iterations);
+                runOrderBench(shapes[i], (q == 0) ? -1 : 28, 32, iterations);
+            }
+        }
+    }
+
+    // point clouds, with every delaunay algorithm
+    if (nameFilter == NULL || string("algorithms").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %9s %12s %10s\n", "algorithm", "points", "triangles", "median us", "mesh KB");
+        runAlgorithmBench(10000, iterations);
+        runAlgorithmBench(100000, iterations);
+        runAlgorithmBench(1000000, max(1, iterations / 10));
+    }
+
+    // particles hit tested against a blob
+    if (nameFilter == NULL || string("polygon").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %9s %5s %8s %12s\n", "polygon", "points", "particles", "lanes", "inside", "median us");
+        runPolygonBench(200, 10000, iterations);
+        runPolygonBench(2000, 10000, iterations);
+        runPolygonBench(2000, 100000, iterations);
+    }
+
+    // orientation and incircle tests, on their own
+    if (nameFilter == NULL || string("predicates").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %9s %9s %12s\n", "predicate", "points", "tests", "positive", "ns / test");
+        runPredicateBench(false, 1000000, iterations);
+        runPredicateBench(true, 1000000, iterations);
+    }
+
+    // the bigger shapes at 33 degrees, where refining takes a while: all at once, or 2 ms a frame
+    if (nameFilter == NULL || string("refine").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %5s %6s %9s %12s %9s %7s %12s %12s %12s\n", "refine", "points", "q", "ms", "triangles", "whole us",
+               "first", "frames", "first us", "longest us", "total us");
+        for (int i = 0; i < shapes.size(); i++){
+            if (shapes[i].numPoints() < 1000) continue;
+            runRefineBench(shapes[i], 33, 2);
+        }
+    }
+
+    // one area for the whole blob, or a sizing field
+    if (nameFilter == NULL || string("sizing").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %7s %9s %9s %9s %12s\n", "sizing", "points", "min area", "max area", "triangles", "median us");
+        runSizingBench(2000, 4, 400, iterations);
+    }
+
+    // traced contours, as they come and simplified
+    if (nameFilter == NULL || string("simplify").find(nameFilter) != string::npos){
+
+        printf("\n%-12s %9s %9s %7s %7s %9s %12s\n", "simplify", "tolerance", "max edge", "contour", "input", "triangles", "median us");
+        runSimplifyBench(200, iterations);
+        runSimplifyBench(1000, max(1, iterations / 5));
+    }
+
+    // clouds with duplicate points: the same mesh as the original triangle.c, whichever sort ran
+    if (nameFilter == NULL || string("duplicates").find(nameFilter) != string::npos){
+
+        // the hashes of the original triangle.c's output (REAL = double, 32-bit int)
+        const duplicateCase cases[] = {
+            { 1000, 50, "zQ", 0x415102b52b747feaull },
+            { 20000, 50, "zQ", 0xdb32fbee2c545c5bull },
+            { 20000, 50, "zQF", 0x0d8ca7c83c9335f5ull },
+            { 200000, 50, "zQ", 0x6216bc8299b1aad0ull },
+            { 200000, 1000, "zQ", 0xaf6ea94300b4963eull },
+        };
+
+        printf("\n%-12s %7s %5s %9s %12s %16s\n", "duplicates", "points", "grid", "triangles", "median us", "hash");
+        for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+            runDuplicateBench(cases[i], cases[i].numPoints > 100000 ? max(1, iterations / 10) : iterations);
+        }
+    }
+
+    return 0;
+}
@@ -3,6 +3,9 @@
 //--------------------------------------------------------------
 void testApp::setup(){
 
+    // use the contour edges as segments, so triangle removes the outside of the shape for us
+    // (see ofxTriangleMesh.h for the different modes)
+    mesh.setMode(OFX_TRIANGLE_MESH_CONSTRAINED);
     
 }
 
@@ -121,6 +121,13 @@
 /*    Computational Geometry 4(1):387-421, 1989, would yield an expected     */
 /*    O(n^{4/3}) bound on running time.                                      */
 /*                                                                           */
+/*  The -b switch inserts the vertices in a biased randomized insertion      */
+/*    order, from Nina Amenta, Sunghee Choi, and Gunter Rote, "Incremental   */
+/*    Constructions con BRIO," Proceedings of the Nineteenth Annual          */
+/*    Symposium on Computational Geometry, ACM, pp. 211-219, 2003.  Each     */
+/*    round is sorted along a Hilbert curve, so that each vertex is found by */
+/*    walking from the one inserted before it, and that walk is short.       */
+/*                                                                           */
 /*  The O(n log n) sweepline Delaunay triangulation algorithm is taken from  */
 /*    Steven Fortune, "A Sweepline Algorithm for Voronoi Diagrams",          */
 /*    Algorithmica 2(2):153-174, 1987.  A random sample of edges on the      */
@@ -231,6 +238,22 @@
 
 #define NO_TIMER 
 
+/* The -t switch runs the divide-and-conquer triangulation on several        */
+/*   threads, using std::thread.  If your compiler has no <thread>, define   */
+/*   the NO_THREADS symbol; -t is then accepted and ignored.                 */
+
+/* #define NO_THREADS */
+
+/* On a 64-bit machine, each pointer a triangle or subsegment holds takes    */
+/*   eight bytes.  Define the INDEX32 symbol to store them as 32-bit offsets */
+/*   instead, into a range of addresses that each mesh reserves for its      */
+/*   triangles, subsegments, and vertices.  The orientation stays in the low */
+/*   bits, as in a pointer.  A triangle shrinks from 48 to 24 bytes (from 72 */
+/*   to 40 with segments), a subsegment from 72 to 40, and the output is the */
+/*   same.  A mesh can then use at most INDEXSPACE bytes (see below).        */
+
+/* #define INDEX32 */
+
 /* To insert lots of self-checks for internal errors, define the SELF_CHECK  */
 /*   symbol.  This will slow down the program significantly.  It is best to  */
 /*   define the symbol using the -DSELF_CHECK compiler switch, but you could */
@@ -338,6 +361,43 @@
 
 #define SAMPLERATE 10
 
+/* Used for the biased randomized insertion order (BRIO) of the -b switch.   */
+/*   Rounds of vertices are halved until one is no bigger than this.  Within */
+/*   a round, vertices are sorted along a Hilbert curve through a grid of    */
+/*   2^HILBERTBITS by 2^HILBERTBITS cells.                                   */
+
+#define BRIOMINROUND 64
+#define HILBERTBITS 16
+
+/* Used by the -t switch.  Divide-and-conquer subproblems with fewer than    */
+/*   this many vertices are never split between threads.                     */
+
+#define THREADGRAIN 16384
+
+/* Used to sort the vertices for divide-and-conquer.  Arrays of at least     */
+/*   RADIXMIN vertices are radix sorted, RADIXBITS bits at a time; smaller   */
+/*   ones are quicksorted.                                                   */
+
+#define RADIXMIN 1024
+#define RADIXBITS 11
+
+/* Used by INDEX32.  Each mesh reserves INDEXSPACE bytes of addresses (or    */
+/*   fewer, if the system won't hand out that many), and makes memory of     */
+/*   them usable INDEXCOMMIT bytes or more at a time.  The offsets count     */
+/*   two-byte units, so 32 bits reach eight gigabytes.                       */
+
+#define INDEXSPACE 0x200000000ul
+#define INDEXCOMMIT 0x100000ul
+
+/* The tests testtriangle() makes, chosen from the switches once per call.   */
+/*   QUALITYANGLE:  the minimum angle only (-q).  QUALITYAREA:  a fixed      */
+/*   maximum area as well (-a with a number).  QUALITYANY:  whatever the     */
+/*   switches say (-a without a number, -u).                                 */
+
+#define QUALITYANGLE 0
+#define QUALITYAREA 1
+#define QUALITYANY 2
+
 /* A number that speaks for itself, every kissable digit.                    */
 
 #define PI 3.141592653589793238462643383279502884197169399375105820974944592308
@@ -363,9 +423,28 @@
 #ifdef LINUX
 #include <fpu_control.h>
 #endif /* LINUX */
+#ifndef NO_THREADS
+#include <thread>
+#include <exception>
+#include <system_error>
+#endif /* not NO_THREADS */
+#ifdef INDEX32
+#ifdef _WIN32
+#undef VOID                                 /* <windows.h> has its own VOID. */
+#include <windows.h>
+#undef VOID
+#define VOID int
+#else /* not _WIN32 */
+#include <sys/mman.h>
+#endif /* not _WIN32 */
+#endif /* INDEX32 */
 #ifdef TRILIBRARY
 #include "triangle.h"
-#endif /* TRILIBRARY */
+#include <chrono>
+#else /* not TRILIBRARY */
+#define TRI_ERROR_MEMORY    2   /* Exit codes, as in "Errors" in triangle.h. */
+#define TRI_ERROR_INTERNAL  3
+#endif /* not TRILIBRARY */
 
 /* A few forward declarations.                                               */
 
@@ -512,8 +591,13 @@ enum finddirectionresult {WITHIN, LEFTCOLLINEAR, RIGHTCOLLINEAR};
 /*   pointers for nodes, when the user asks for high-order elements.         */
 /*   Because the size and structure of a `triangle' is not decided until     */
 /*   runtime, I haven't simply declared the type `triangle' as a struct.     */
+/*   With INDEX32, the pointers are 32-bit offsets instead (see indexptr()). */
 
+#ifdef INDEX32
+typedef unsigned int triangle;
+#else /* not INDEX32 */
 typedef REAL **triangle;            /* Really:  typedef triangle *triangle   */
+#endif /* not INDEX32 */
 
 /* An oriented triangle:  includes a pointer to a triangle and orientation.  */
 /*   The orientation denotes an edge of the triangle.  Hence, there are      */
@@ -530,7 +614,11 @@ struct otri {
 /*   pointers to adjoining triangles, plus one boundary marker, plus one     */
 /*   segment number.                                                         */
 
+#ifdef INDEX32
+typedef unsigned int subseg;
+#else /* not INDEX32 */
 typedef REAL **subseg;                  /* Really:  typedef subseg *subseg   */
+#endif /* not INDEX32 */
 
 /* An oriented subsegment:  includes a pointer to a subsegment and an        */
 /*   orientation.  The orientation denotes a side of the edge.  Hence, there */
@@ -610,6 +698,25 @@ struct splaynode {
   struct splaynode *lchild, *rchild;              /* Children in splay tree. */
 };
 
+/* Where a mesh gets its memory:  from its allocator (see "Allocators" in    */
+/*   triangle.h), or from malloc() and free() if `allocator.allocate' is     */
+/*   NULL.  The counts are those of the current call.                        */
+
+struct trimemory {
+  struct triallocator allocator;
+  long allocations, releases;
+  unsigned long allocatedbytes;
+};
+
+/* Where triangles, subsegments, and vertices get their memory:  from the    */
+/*   index space with INDEX32 (see "Index space"), otherwise as the rest.    */
+
+#ifdef INDEX32
+#define recordmemory(m)  (&(m)->indexmemory)
+#else /* not INDEX32 */
+#define recordmemory(m)  (&(m)->memory)
+#endif /* not INDEX32 */
+
 /* A type used to allocate memory.  firstblock is the first block of items.  */
 /*   nowblock is the block from which items are currently being allocated.   */
 /*   nextitem points to the next slab of free memory for an item.            */
@@ -624,6 +731,8 @@ struct splaynode {
 /*   to be traversed.  pathitemsleft is the number of items that remain to   */
 /*   be traversed in pathblock.                                              */
 /*                                                                           */
+/* memory is where the blocks come from; NULL means malloc().                */
+/*                                                                           */
 /* alignbytes determines how new records should be aligned in memory.        */
 /*   itembytes is the length of a record in bytes (after rounding up).       */
 /*   itemsperblock is the number of items allocated at once in a single      */
@@ -646,10 +755,13 @@ struct memorypool {
   long items, maxitems;
   int unallocateditems;
   int pathitemsleft;
+  struct trimemory *memory;
 };
 
 
-/* Global constants.                                                         */
+/* Global constants.  They are computed once by exactinit(), the first time  */
+/*   any mesh is initialized, and only read after that, so several threads   */
+/*   can triangulate at the same time (each with its own mesh).              */
 
 REAL splitter;       /* Used to split REAL factors for exact multiplication. */
 REAL epsilon;                             /* Floating-point machine epsilon. */
@@ -658,10 +770,6 @@ REAL ccwerrboundA, ccwerrboundB, ccwerrboundC;
 REAL iccerrboundA, iccerrboundB, iccerrboundC;
 REAL o3derrboundA, o3derrboundB, o3derrboundC;
 
-/* Random number seed is not constant, but I've made it global anyway.       */
-
-unsigned long randomseed;                     /* Current random number seed. */
-
 
 /* Mesh data structure.  Triangle operates on only one mesh, but the mesh    */
 /*   structure is used (instead of global variables) to allow reentrancy.    */
@@ -718,6 +826,7 @@ struct mesh {
   int checkquality;                  /* Has quality triangulation begun yet? */
   int readnodefile;                           /* Has a .node file been read? */
   long samples;              /* Number of random samples for point location. */
+  int walklocate;                /* Walk from `recenttri', without sampling? */
 
   long incirclecount;                 /* Number of incircle tests performed. */
   long counterclockcount;     /* Number of counterclockwise tests performed. */
@@ -726,6 +835,8 @@ struct mesh {
   long circumcentercount;  /* Number of circumcenter calculations performed. */
   long circletopcount;       /* Number of circle top calculations performed. */
 
+  unsigned long randomseed;                   /* Current random number seed. */
+
 /* Triangular bounding box vertices.                                         */
 
   vertex infvertex1, infvertex2, infvertex3;
@@ -747,6 +858,41 @@ struct mesh {
 
   struct otri recenttri;
 
+/* Where the pools and the arrays the mesh works with come from.            */
+
+  struct trimemory memory;
+
+#ifdef INDEX32
+/* The range of addresses the triangles, subsegments, and vertices come      */
+/*   from, and the bytes of it handed out, usable, and reserved (see         */
+/*   "Index space").  `indexmemory' hands it out.                            */
+
+  char *indexbase;
+  unsigned long indexused, indexcommitted, indexreserved;
+  struct trimemory indexmemory;
+#endif /* INDEX32 */
+
+/* Set when the mesh belongs to a workspace (see triangulatews()).  Memory   */
+/*   pools are then restarted instead of freed, and the arrays below are     */
+/*   kept from one triangulation to the next.                                */
+
+  int keeppools;
+  int dummytribytes, dummysubbytes;     /* Sizes of `dummytri', `dummysub'. */
+  vertex *sortarray;             /* Vertex array used by divconqdelaunay(). */
+  int sortarraysize;
+  struct sortvertex *sortkeys;            /* Keys used by vertexradixsort(). */
+  int sortkeyssize;                      /* Vertices that fit in `sortkeys', */
+                                          /* with scratch space for as many. */
+
+/* The budget of the current triangulation (see budgetleft()).               */
+
+  long maxtriangles;            /* Stop refining at this many; 0 = no limit. */
+  long maxvertices;              /* And at this many vertices; 0 = no limit. */
+  long long deadline;         /* Stop refining at this triclock(); 0 = none. */
+  int clockcountdown;        /* Budget checks until the clock is read again. */
+  int outofbudget;                  /* Was refinement stopped by the budget? */
+  int steinerkept;              /* `steinerleft' when the budget stopped it. */
+
 };                                                  /* End of `struct mesh'. */
 
 
@@ -765,6 +911,8 @@ struct behavior {
 /*   fixedarea: -a switch with number.                                       */
 /*     maxarea: maximum area bound, specified after -a switch.               */
 /*   usertest: -u switch.                                                    */
+/*     unsuitable: the caller's test for -u, with `unsuitabledata'; NULL     */
+/*       for triunsuitable().                                                */
 /*   regionattrib: -A switch.  convex: -c switch.                            */
 /*   weighted: 1 for -w switch, 2 for -W switch.  jettison: -j switch        */
 /*   firstnumber: inverse of -z switch.  All items are numbered starting     */
@@ -778,13 +926,17 @@ struct behavior {
 /*   order: element order, specified after -o switch.                        */
 /*   nobisect: count of how often -Y switch is selected.                     */
 /*   steiner: maximum number of Steiner points, specified after -S switch.   */
-/*   incremental: -i switch.  sweepline: -F switch.                          */
+/*   incremental: -i or -b switch.  sweepline: -F switch.  brio: -b switch.  */
 /*   dwyer: inverse of -l switch.                                            */
+/*   threads: number of threads, specified after -t switch (0 for as many    */
+/*     as the machine has cores).                                            */
 /*   splitseg: -s switch.                                                    */
 /*   conformdel: -D switch.  docheck: -C switch.                             */
 /*   quiet: -Q switch.  verbose: count of how often -V switch is selected.   */
 /*   usesegments: -p, -r, -q, or -c switch; determines whether segments are  */
 /*     used at all.                                                          */
+/*   qualitytest: which testtriangle() the switches need (QUALITYANGLE,      */
+/*     QUALITYAREA, or QUALITYANY).                                          */
 /*                                                                           */
 /* Read the instructions to find out the meaning of these switches.          */
 
@@ -794,16 +946,20 @@ struct behavior {
   int edgesout, voronoi, neighbors, geomview;
   int nobound, nopolywritten, nonodewritten, noelewritten, noiterationnum;
   int noholes, noexact, conformdel;
-  int incremental, sweepline, dwyer;
+  int incremental, sweepline, brio, dwyer;
   int splitseg;
   int docheck;
   int quiet, verbose;
   int usesegments;
+  int qualitytest;
   int order;
   int nobisect;
   int steiner;
+  int threads;
   REAL minangle, goodangle, offconstant;
   REAL maxarea;
+  int (*unsuitable)(vertex, vertex, vertex, REAL, VOID *);
+  VOID *unsuitabledata;
 
 /* Variables for file names.                                                 */
 
@@ -944,21 +1100,81 @@ int minus1mod3[3] = {2, 0, 1};
 /*                                                                           */
 /*                                                                           */
 
+/* With INDEX32, indexptr() turns an offset into the mesh's index space     */
+/*   into a pointer, and indexslot() turns a pointer back into an offset.    */
+/*   The offsets count two-byte units.  Triangles, subsegments, and vertices */
+/*   are aligned to eight-byte boundaries, so the two least significant     */
+/*   bits of an offset are zero, as those of a pointer are.  No record       */
+/*   starts at offset zero, which stands for a NULL vertex.                  */
+/*                                                                           */
+/* encodetri(), encodesub(), and encodevertex() store a pointer to a         */
+/*   triangle, a subsegment, or a vertex in a triangle or a subsegment, and  */
+/*   decodevertex() reads a vertex back.  Without INDEX32 they only cast.    */
+
+#ifdef INDEX32
+
+#define indexptr(offset)  (m->indexbase + ((unsigned long) (offset) << 1))
+
+#define indexslot(ptr)                                                        \
+  ((unsigned int) ((unsigned long) ((char *) (ptr) - m->indexbase) >> 1))
+
+#define encodetri(triptr)  ((triangle) indexslot(triptr))
+
+#define encodesub(subptr)  ((subseg) indexslot(subptr))
+
+#define encodevertex(vertexptr)                                               \
+  ((vertex) (vertexptr) == (vertex) NULL ? (triangle) 0 :                     \
+                                           (triangle) indexslot(vertexptr))
+
+#define decodevertex(offset)                                                  \
+  ((offset) == 0 ? (vertex) NULL : (vertex) indexptr(offset))
+
+#else /* not INDEX32 */
+
+#define encodetri(triptr)  ((triangle) (triptr))
+
+#define encodesub(subptr)  ((subseg) (subptr))
+
+#define encodevertex(vertexptr)  ((triangle) (vertexptr))
+
+#define decodevertex(offset)  ((vertex) (offset))
+
+#endif /* not INDEX32 */
+
 /* decode() converts a pointer to an oriented triangle.  The orientation is  */
 /*   extracted from the two least significant bits of the pointer.           */
 
+#ifdef INDEX32
+
+#define decode(ptr, otri)                                                     \
+  (otri).orient = (int) ((ptr) & 3u);                                         \
+  (otri).tri = (triangle *) indexptr((ptr) ^ (unsigned int) (otri).orient)
+
+#else /* not INDEX32 */
+
 #define decode(ptr, otri)                                                     \
   (otri).orient = (int) ((unsigned long) (ptr) & (unsigned long) 3l);         \
   (otri).tri = (triangle *)                                                   \
                   ((unsigned long) (ptr) ^ (unsigned long) (otri).orient)
 
+#endif /* not INDEX32 */
+
 /* encode() compresses an oriented triangle into a single pointer.  It       */
 /*   relies on the assumption that all triangles are aligned to four-byte    */
 /*   boundaries, so the two least significant bits of (otri).tri are zero.   */
 
+#ifdef INDEX32
+
+#define encode(otri)                                                          \
+  (triangle) (indexslot((otri).tri) | (unsigned int) (otri).orient)
+
+#else /* not INDEX32 */
+
 #define encode(otri)                                                          \
   (triangle) ((unsigned long) (otri).tri | (unsigned long) (otri).orient)
 
+#endif /* not INDEX32 */
+
 /* The following handle manipulation primitives are all described by Guibas  */
 /*   and Stolfi.  However, Guibas and Stolfi use an edge-based data          */
 /*   structure, whereas I use a triangle-based data structure.               */
@@ -1073,22 +1289,22 @@ int minus1mod3[3] = {2, 0, 1};
 /* triangle.                                                                 */
 
 #define org(otri, vertexptr)                                                  \
-  vertexptr = (vertex) (otri).tri[plus1mod3[(otri).orient] + 3]
+  vertexptr = decodevertex((otri).tri[plus1mod3[(otri).orient] + 3])
 
 #define dest(otri, vertexptr)                                                 \
-  vertexptr = (vertex) (otri).tri[minus1mod3[(otri).orient] + 3]
+  vertexptr = decodevertex((otri).tri[minus1mod3[(otri).orient] + 3])
 
 #define apex(otri, vertexptr)                                                 \
-  vertexptr = (vertex) (otri).tri[(otri).orient + 3]
+  vertexptr = decodevertex((otri).tri[(otri).orient + 3])
 
 #define setorg(otri, vertexptr)                                               \
-  (otri).tri[plus1mod3[(otri).orient] + 3] = (triangle) vertexptr
+  (otri).tri[plus1mod3[(otri).orient] + 3] = encodevertex(vertexptr)
 
 #define setdest(otri, vertexptr)                                              \
-  (otri).tri[minus1mod3[(otri).orient] + 3] = (triangle) vertexptr
+  (otri).tri[minus1mod3[(otri).orient] + 3] = encodevertex(vertexptr)
 
 #define setapex(otri, vertexptr)                                              \
-  (otri).tri[(otri).orient + 3] = (triangle) vertexptr
+  (otri).tri[(otri).orient + 3] = encodevertex(vertexptr)
 
 /* Bond two triangles together.                                              */
 
@@ -1102,7 +1318,7 @@ int minus1mod3[3] = {2, 0, 1};
 /*   it doesn't matter.                                                      */
 
 #define dissolve(otri)                                                        \
-  (otri).tri[(otri).orient] = (triangle) m->dummytri
+  (otri).tri[(otri).orient] = encodetri(m->dummytri)
 
 /* Copy an oriented triangle.                                                */
 
@@ -1119,6 +1335,16 @@ int minus1mod3[3] = {2, 0, 1};
 /* Primitives to infect or cure a triangle with the virus.  These rely on    */
 /*   the assumption that all subsegments are aligned to four-byte boundaries.*/
 
+#ifdef INDEX32
+
+#define infect(otri)                                                          \
+  (otri).tri[6] = (otri).tri[6] | 2u
+
+#define uninfect(otri)                                                        \
+  (otri).tri[6] = (otri).tri[6] & ~ 2u
+
+#else /* not INDEX32 */
+
 #define infect(otri)                                                          \
   (otri).tri[6] = (triangle)                                                  \
                     ((unsigned long) (otri).tri[6] | (unsigned long) 2l)
@@ -1127,11 +1353,21 @@ int minus1mod3[3] = {2, 0, 1};
   (otri).tri[6] = (triangle)                                                  \
                     ((unsigned long) (otri).tri[6] & ~ (unsigned long) 2l)
 
+#endif /* not INDEX32 */
+
 /* Test a triangle for viral infection.                                      */
 
+#ifdef INDEX32
+
+#define infected(otri)  (((otri).tri[6] & 2u) != 0u)
+
+#else /* not INDEX32 */
+
 #define infected(otri)                                                        \
   (((unsigned long) (otri).tri[6] & (unsigned long) 2l) != 0l)
 
+#endif /* not INDEX32 */
+
 /* Check or set a triangle's attributes.                                     */
 
 #define elemattribute(otri, attnum)                                           \
@@ -1150,7 +1386,19 @@ int minus1mod3[3] = {2, 0, 1};
 /* Check or set a triangle's deallocation.  Its second pointer is set to     */
 /*   NULL to indicate that it is not allocated.  (Its first pointer is used  */
 /*   for the stack of dead items.)  Its fourth pointer (its first vertex)    */
-/*   is set to NULL in case a `badtriang' structure points to it.            */
+/*   is set to NULL in case a `badtriang' structure points to it.  With      */
+/*   INDEX32, the stack of dead items takes the first two offsets, so the    */
+/*   third (which no living triangle has at zero) marks the triangle dead.   */
+
+#ifdef INDEX32
+
+#define deadtri(tria)  ((tria)[2] == (triangle) 0)
+
+#define killtri(tria)                                                         \
+  (tria)[2] = (triangle) 0;                                                   \
+  (tria)[3] = (triangle) 0
+
+#else /* not INDEX32 */
 
 #define deadtri(tria)  ((tria)[1] == (triangle) NULL)
 
@@ -1158,6 +1406,8 @@ int minus1mod3[3] = {2, 0, 1};
   (tria)[1] = (triangle) NULL;                                                \
   (tria)[3] = (triangle) NULL
 
+#endif /* not INDEX32 */
+
 /********* Primitives for subsegments                                *********/
 /*                                                                           */
 /*                                                                           */
@@ -1167,18 +1417,37 @@ int minus1mod3[3] = {2, 0, 1};
 /*   least significant bits (one for orientation, one for viral infection)   */
 /*   are masked out to produce the real pointer.                             */
 
+#ifdef INDEX32
+
+#define sdecode(sptr, osub)                                                   \
+  (osub).ssorient = (int) ((sptr) & 1u);                                      \
+  (osub).ss = (subseg *) indexptr((sptr) & ~ 3u)
+
+#else /* not INDEX32 */
+
 #define sdecode(sptr, osub)                                                   \
   (osub).ssorient = (int) ((unsigned long) (sptr) & (unsigned long) 1l);      \
   (osub).ss = (subseg *)                                                      \
               ((unsigned long) (sptr) & ~ (unsigned long) 3l)
 
+#endif /* not INDEX32 */
+
 /* sencode() compresses an oriented subsegment into a single pointer.  It    */
 /*   relies on the assumption that all subsegments are aligned to two-byte   */
 /*   boundaries, so the least significant bit of (osub).ss is zero.          */
 
+#ifdef INDEX32
+
+#define sencode(osub)                                                         \
+  (subseg) (indexslot((osub).ss) | (unsigned int) (osub).ssorient)
+
+#else /* not INDEX32 */
+
 #define sencode(osub)                                                         \
   (subseg) ((unsigned long) (osub).ss | (unsigned long) (osub).ssorient)
 
+#endif /* not INDEX32 */
+
 /* ssym() toggles the orientation of a subsegment.                           */
 
 #define ssym(osub1, osub2)                                                    \
@@ -1214,28 +1483,28 @@ int minus1mod3[3] = {2, 0, 1};
 /*   subsegment or the segment that includes it.                             */
 
 #define sorg(osub, vertexptr)                                                 \
-  vertexptr = (vertex) (osub).ss[2 + (osub).ssorient]
+  vertexptr = decodevertex((osub).ss[2 + (osub).ssorient])
 
 #define sdest(osub, vertexptr)                                                \
-  vertexptr = (vertex) (osub).ss[3 - (osub).ssorient]
+  vertexptr = decodevertex((osub).ss[3 - (osub).ssorient])
 
 #define setsorg(osub, vertexptr)                                              \
-  (osub).ss[2 + (osub).ssorient] = (subseg) vertexptr
+  (osub).ss[2 + (osub).ssorient] = (subseg) encodevertex(vertexptr)
 
 #define setsdest(osub, vertexptr)                                             \
-  (osub).ss[3 - (osub).ssorient] = (subseg) vertexptr
+  (osub).ss[3 - (osub).ssorient] = (subseg) encodevertex(vertexptr)
 
 #define segorg(osub, vertexptr)                                               \
-  vertexptr = (vertex) (osub).ss[4 + (osub).ssorient]
+  vertexptr = decodevertex((osub).ss[4 + (osub).ssorient])
 
 #define segdest(osub, vertexptr)                                              \
-  vertexptr = (vertex) (osub).ss[5 - (osub).ssorient]
+  vertexptr = decodevertex((osub).ss[5 - (osub).ssorient])
 
 #define setsegorg(osub, vertexptr)                                            \
-  (osub).ss[4 + (osub).ssorient] = (subseg) vertexptr
+  (osub).ss[4 + (osub).ssorient] = (subseg) encodevertex(vertexptr)
 
 #define setsegdest(osub, vertexptr)                                           \
-  (osub).ss[5 - (osub).ssorient] = (subseg) vertexptr
+  (osub).ss[5 - (osub).ssorient] = (subseg) encodevertex(vertexptr)
 
 /* These primitives read or set a boundary marker.  Boundary markers are     */
 /*   used to hold user-defined tags for setting boundary conditions in       */
@@ -1256,7 +1525,7 @@ int minus1mod3[3] = {2, 0, 1};
 /*   subsegment will still think it's connected to this subsegment.          */
 
 #define sdissolve(osub)                                                       \
-  (osub).ss[(osub).ssorient] = (subseg) m->dummysub
+  (osub).ss[(osub).ssorient] = encodesub(m->dummysub)
 
 /* Copy a subsegment.                                                        */
 
@@ -1273,7 +1542,19 @@ int minus1mod3[3] = {2, 0, 1};
 /* Check or set a subsegment's deallocation.  Its second pointer is set to   */
 /*   NULL to indicate that it is not allocated.  (Its first pointer is used  */
 /*   for the stack of dead items.)  Its third pointer (its first vertex)     */
-/*   is set to NULL in case a `badsubseg' structure points to it.            */
+/*   is set to NULL in case a `badsubseg' structure points to it.  With      */
+/*   INDEX32, the stack of dead items takes the first two offsets, so the    */
+/*   seventh (which no living subsegment has at zero) marks it dead.         */
+
+#ifdef INDEX32
+
+#define deadsubseg(sub)  ((sub)[6] == (subseg) 0)
+
+#define killsubseg(sub)                                                       \
+  (sub)[6] = (subseg) 0;                                                      \
+  (sub)[2] = (subseg) 0
+
+#else /* not INDEX32 */
 
 #define deadsubseg(sub)  ((sub)[1] == (subseg) NULL)
 
@@ -1281,6 +1562,8 @@ int minus1mod3[3] = {2, 0, 1};
   (sub)[1] = (subseg) NULL;                                                   \
   (sub)[2] = (subseg) NULL
 
+#endif /* not INDEX32 */
+
 /********* Primitives for interacting triangles and subsegments      *********/
 /*                                                                           */
 /*                                                                           */
@@ -1307,12 +1590,12 @@ int minus1mod3[3] = {2, 0, 1};
 /* Dissolve a bond (from the triangle side).                                 */
 
 #define tsdissolve(otri)                                                      \
-  (otri).tri[6 + (otri).orient] = (triangle) m->dummysub
+  (otri).tri[6 + (otri).orient] = (triangle) encodesub(m->dummysub)
 
 /* Dissolve a bond (from the subsegment side).                               */
 
 #define stdissolve(osub)                                                      \
-  (osub).ss[6 + (osub).ssorient] = (subseg) m->dummytri
+  (osub).ss[6 + (osub).ssorient] = (subseg) encodetri(m->dummytri)
 
 /********* Primitives for vertices                                   *********/
 /*                                                                           */
@@ -1417,6 +1700,18 @@ REAL area;                                      /* The area of the triangle. */
 /**                                                                         **/
 /**                                                                         **/
 
+/* As a library, Triangle doesn't end the program when something goes      */
+/*   wrong.  triexit() throws the status back to triangulatews() instead,    */
+/*   which returns it to the caller (see "Errors" in triangle.h).            */
+
+#ifdef TRILIBRARY
+
+struct trierror {
+  int status;
+};
+
+#endif /* TRILIBRARY */
+
 #ifdef ANSI_DECLARATORS
 void triexit(int status)
 #else /* not ANSI_DECLARATORS */
@@ -1425,7 +1720,14 @@ int status;
 #endif /* not ANSI_DECLARATORS */
 
 {
+#ifdef TRILIBRARY
+  struct trierror error;
+
+  error.status = status;
+  throw error;
+#else /* not TRILIBRARY */
   exit(status);
+#endif /* not TRILIBRARY */
 }
 
 #ifdef ANSI_DECLARATORS
@@ -1441,7 +1743,7 @@ int size;
   memptr = (VOID *) malloc((unsigned int) size);
   if (memptr == (VOID *) NULL) {
     printf("Error:  Out of memory.\n");
-    triexit(1);
+    triexit(TRI_ERROR_MEMORY);
   }
   return(memptr);
 }
@@ -1457,6 +1759,83 @@ VOID *memptr;
   free(memptr);
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  memalloc()   Allocate memory for a mesh, from its allocator if it has    */
+/*               one, and count it.  `memory' may be NULL, for malloc().     */
+/*                                                                           */
+/*  memfree()   Give memory back the same way.                               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+VOID *memalloc(struct trimemory *memory, int size)
+#else /* not ANSI_DECLARATORS */
+VOID *memalloc(memory, size)
+struct trimemory *memory;
+int size;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID *memptr;
+
+  if ((memory == (struct trimemory *) NULL) ||
+      (memory->allocator.allocate == NULL)) {
+    memptr = (VOID *) malloc((unsigned int) size);
+  } else {
+    memptr = memory->allocator.allocate(memory->allocator.data, size);
+  }
+  if (memptr == (VOID *) NULL) {
+    printf("Error:  Out of memory.\n");
+    triexit(TRI_ERROR_MEMORY);
+  }
+  if (memory != (struct trimemory *) NULL) {
+    memory->allocations++;
+    memory->allocatedbytes += (unsigned long) size;
+  }
+  return(memptr);
+}
+
+#ifdef ANSI_DECLARATORS
+void memfree(struct trimemory *memory, VOID *memptr)
+#else /* not ANSI_DECLARATORS */
+void memfree(memory, memptr)
+struct trimemory *memory;
+VOID *memptr;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if ((memory == (struct trimemory *) NULL) ||
+      (memory->allocator.allocate == NULL)) {
+    free(memptr);
+  } else if (memory->allocator.release != NULL) {
+    memory->allocator.release(memory->allocator.data, memptr);
+  }
+  if (memory != (struct trimemory *) NULL) {
+    memory->releases++;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triclock()   Read a monotonic clock, in nanoseconds.                     */
+/*                                                                           */
+/*  Unlike the gettimeofday() timing (see NO_TIMER), this works everywhere   */
+/*  Triangle is compiled as C++.  It times the phases of a call for the      */
+/*  workspace statistics, and keeps track of a call's time budget.           */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef TRILIBRARY
+
+long long triclock()
+{
+  return (long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif /* TRILIBRARY */
+
 /**                                                                         **/
 /**                                                                         **/
 /********* Memory allocation and program exit wrappers end here      *********/
@@ -1477,15 +1856,16 @@ void syntax()
 {
 #ifdef CDT_ONLY
 #ifdef REDUCED
-  printf("triangle [-pAcjevngBPNEIOXzo_lQVh] input_file\n");
+  printf("triangle [-pAcjevngBPNEIOXzo_lt_QVh] input_file\n");
 #else /* not REDUCED */
-  printf("triangle [-pAcjevngBPNEIOXzo_iFlCQVh] input_file\n");
+  printf("triangle [-pAcjevngBPNEIOXzo_ibFlt_CQVh] input_file\n");
 #endif /* not REDUCED */
 #else /* not CDT_ONLY */
 #ifdef REDUCED
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__lQVh] input_file\n");
+  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__lt_QVh] input_file\n");
 #else /* not REDUCED */
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlsCQVh] input_file\n");
+  printf(
+      "triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__ibFlt_sCQVh] input_file\n");
 #endif /* not REDUCED */
 #endif /* not CDT_ONLY */
 
@@ -1527,9 +1907,11 @@ void syntax()
 #endif /* not CDT_ONLY */
 #ifndef REDUCED
   printf("    -i  Uses incremental method, rather than divide-and-conquer.\n");
+  printf("    -b  Uses incremental method, in a randomized Hilbert order.\n");
   printf("    -F  Uses Fortune's sweepline algorithm, rather than d-and-c.\n");
 #endif /* not REDUCED */
   printf("    -l  Uses vertical cuts only, rather than alternating cuts.\n");
+  printf("    -t  Uses several threads for divide-and-conquer.\n");
 #ifndef REDUCED
 #ifndef CDT_ONLY
   printf(
@@ -1588,7 +1970,8 @@ void info()
   printf(
 "Delaunay triangulation is returned in .node and .ele output files.  The\n");
   printf("command syntax is:\n\n");
-  printf("triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__iFlsCQVh] input_file\n\n");
+  printf(
+"triangle [-prq__a__uAcDjevngBPNEIOXzo_YS__ibFlt_sCQVh] input_file\n\n");
   printf(
 "Underscores indicate that numbers may optionally follow certain switches.\n");
   printf(
@@ -1909,6 +2292,14 @@ void info()
 "        construct a Delaunay triangulation.  Try it if the divide-and-\n");
   printf("        conquer algorithm fails.\n");
   printf(
+"    -b  Uses the incremental algorithm, but inserts the vertices in a\n");
+  printf(
+"        biased randomized order, in rounds sorted along a Hilbert curve, so\n"
+);
+  printf(
+"        that each vertex is found by a short walk from the one before.\n");
+  printf("        Much faster than -i for big inputs.\n");
+  printf(
 "    -F  Uses Steven Fortune's sweepline algorithm to construct a Delaunay\n");
   printf(
 "        triangulation.  Warning:  does not use exact arithmetic for all\n");
@@ -1924,6 +2315,17 @@ void info()
 "        small or short and wide.  This switch is primarily of theoretical\n");
   printf("        interest.\n");
   printf(
+"    -t  Runs the divide-and-conquer algorithm on several threads.  Follow\n");
+  printf(
+"        the -t with the number of threads, or leave it out to use one per\n");
+  printf(
+"        core.  Halves of the vertex set are triangulated at the same time,\n"
+);
+  printf(
+"        down to a few thousand vertices, and the result is the same as\n");
+  printf(
+"        with one thread.  No effect with -i, -b, or -F.\n");
+  printf(
 "    -s  Specifies that segments should be forced into the triangulation by\n"
 );
   printf(
@@ -3279,46 +3681,36 @@ void internalerror()
   printf("  Please report this bug to jrs@cs.berkeley.edu\n");
   printf("  Include the message above, your input data set, and the exact\n");
   printf("    command line you used to run Triangle.\n");
-  triexit(1);
+  triexit(TRI_ERROR_INTERNAL);
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  parsecommandline()   Read the command line, identify switches, and set   */
-/*                       up options and file names.                          */
+/*  behaviordefaults()   Set up the options as they are with no switches.    */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void parsecommandline(int argc, char **argv, struct behavior *b)
+void behaviordefaults(struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void parsecommandline(argc, argv, b)
-int argc;
-char **argv;
+void behaviordefaults(b)
 struct behavior *b;
 #endif /* not ANSI_DECLARATORS */
 
 {
-#ifdef TRILIBRARY
-#define STARTINDEX 0
-#else /* not TRILIBRARY */
-#define STARTINDEX 1
-  int increment;
-  int meshnumber;
-#endif /* not TRILIBRARY */
-  int i, j, k;
-  char workstring[FILENAMESIZE];
-
   b->poly = b->refine = b->quality = 0;
   b->vararea = b->fixedarea = b->usertest = 0;
+  b->unsuitable = NULL;
+  b->unsuitabledata = (VOID *) NULL;
   b->regionattrib = b->convex = b->weighted = b->jettison = 0;
   b->firstnumber = 1;
   b->edgesout = b->voronoi = b->neighbors = b->geomview = 0;
   b->nobound = b->nopolywritten = b->nonodewritten = b->noelewritten = 0;
   b->noiterationnum = 0;
   b->noholes = b->noexact = 0;
-  b->incremental = b->sweepline = 0;
+  b->incremental = b->sweepline = b->brio = 0;
   b->dwyer = 1;
+  b->threads = 1;
   b->splitseg = 0;
   b->docheck = 0;
   b->nobisect = 0;
@@ -3328,82 +3720,183 @@ struct behavior *b;
   b->minangle = 0.0;
   b->maxarea = -1.0;
   b->quiet = b->verbose = 0;
-#ifndef TRILIBRARY
-  b->innodefilename[0] = '\0';
-#endif /* not TRILIBRARY */
+}
 
-  for (i = STARTINDEX; i < argc; i++) {
-#ifndef TRILIBRARY
-    if (argv[i][0] == '-') {
-#endif /* not TRILIBRARY */
-      for (j = STARTINDEX; argv[i][j] != '\0'; j++) {
-        if (argv[i][j] == 'p') {
-          b->poly = 1;
-	}
-#ifndef CDT_ONLY
-        if (argv[i][j] == 'r') {
-          b->refine = 1;
-	}
-        if (argv[i][j] == 'q') {
-          b->quality = 1;
-          if (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
-              (argv[i][j + 1] == '.')) {
-            k = 0;
-            while (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
-                   (argv[i][j + 1] == '.')) {
-              j++;
-              workstring[k] = argv[i][j];
-              k++;
-            }
-            workstring[k] = '\0';
-            b->minangle = (REAL) strtod(workstring, (char **) NULL);
-	  } else {
-            b->minangle = 20.0;
-	  }
-	}
-        if (argv[i][j] == 'a') {
-          b->quality = 1;
-          if (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
-              (argv[i][j + 1] == '.')) {
-            b->fixedarea = 1;
-            k = 0;
-            while (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
-                   (argv[i][j + 1] == '.')) {
-              j++;
-              workstring[k] = argv[i][j];
-              k++;
-            }
-            workstring[k] = '\0';
-            b->maxarea = (REAL) strtod(workstring, (char **) NULL);
-            if (b->maxarea <= 0.0) {
-              printf("Error:  Maximum area must be greater than zero.\n");
-              triexit(1);
-	    }
-	  } else {
-            b->vararea = 1;
-	  }
-	}
-        if (argv[i][j] == 'u') {
-          b->quality = 1;
-          b->usertest = 1;
-        }
-#endif /* not CDT_ONLY */
-        if (argv[i][j] == 'A') {
-          b->regionattrib = 1;
-        }
-        if (argv[i][j] == 'c') {
-          b->convex = 1;
-        }
-        if (argv[i][j] == 'w') {
-          b->weighted = 1;
-        }
-        if (argv[i][j] == 'W') {
-          b->weighted = 2;
-        }
-        if (argv[i][j] == 'j') {
-          b->jettison = 1;
-        }
-        if (argv[i][j] == 'z') {
+/*****************************************************************************/
+/*                                                                           */
+/*  behaviorfinish()   Work out the options that follow from the switches,   */
+/*                     and resolve the ones that don't go together.          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void behaviorfinish(struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void behaviorfinish(b)
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  b->usesegments = b->poly || b->refine || b->quality || b->convex;
+  b->goodangle = cos(b->minangle * PI / 180.0);
+  if (b->goodangle == 1.0) {
+    b->offconstant = 0.0;
+  } else {
+    b->offconstant = 0.475 * sqrt((1.0 + b->goodangle) / (1.0 - b->goodangle));
+  }
+  b->goodangle *= b->goodangle;
+#ifdef NO_THREADS
+  b->threads = 1;
+#else /* not NO_THREADS */
+  if (b->threads == 0) {
+    b->threads = (int) std::thread::hardware_concurrency();
+  }
+#endif /* not NO_THREADS */
+  if (b->threads < 1) {
+    b->threads = 1;
+  }
+  if (b->refine && b->noiterationnum) {
+    printf(
+      "Error:  You cannot use the -I switch when refining a triangulation.\n");
+    triexit(1);
+  }
+  /* Be careful not to allocate space for element area constraints that */
+  /*   will never be assigned any value (other than the default -1.0).  */
+  if (!b->refine && !b->poly) {
+    b->vararea = 0;
+  }
+  /* Be careful not to add an extra attribute to each element unless the */
+  /*   input supports it (PSLG in, but not refining a preexisting mesh). */
+  if (b->refine || !b->poly) {
+    b->regionattrib = 0;
+  }
+  /* Regular/weighted triangulations are incompatible with PSLGs */
+  /*   and meshing.                                              */
+  if (b->weighted && (b->poly || b->quality)) {
+    b->weighted = 0;
+    if (!b->quiet) {
+      printf("Warning:  weighted triangulations (-w, -W) are incompatible\n");
+      printf("  with PSLGs (-p) and meshing (-q, -a, -u).  Weights ignored.\n"
+             );
+    }
+  }
+  if (b->jettison && b->nonodewritten && !b->quiet) {
+    printf("Warning:  -j and -N switches are somewhat incompatible.\n");
+    printf("  If any vertices are jettisoned, you will need the output\n");
+    printf("  .node file to reconstruct the new node indices.");
+  }
+  /* Choose the quality test now, rather than for every triangle. */
+  if (!b->vararea && !b->usertest) {
+    b->qualitytest = b->fixedarea ? QUALITYAREA : QUALITYANGLE;
+  } else {
+    b->qualitytest = QUALITYANY;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  parsecommandline()   Read the command line, identify switches, and set   */
+/*                       up options and file names.                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void parsecommandline(int argc, char **argv, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void parsecommandline(argc, argv, b)
+int argc;
+char **argv;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+#ifdef TRILIBRARY
+#define STARTINDEX 0
+#else /* not TRILIBRARY */
+#define STARTINDEX 1
+  int increment;
+  int meshnumber;
+#endif /* not TRILIBRARY */
+  int i, j, k;
+  char workstring[FILENAMESIZE];
+
+  behaviordefaults(b);
+#ifndef TRILIBRARY
+  b->innodefilename[0] = '\0';
+#endif /* not TRILIBRARY */
+
+  for (i = STARTINDEX; i < argc; i++) {
+#ifndef TRILIBRARY
+    if (argv[i][0] == '-') {
+#endif /* not TRILIBRARY */
+      for (j = STARTINDEX; argv[i][j] != '\0'; j++) {
+        if (argv[i][j] == 'p') {
+          b->poly = 1;
+	}
+#ifndef CDT_ONLY
+        if (argv[i][j] == 'r') {
+          b->refine = 1;
+	}
+        if (argv[i][j] == 'q') {
+          b->quality = 1;
+          if (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
+              (argv[i][j + 1] == '.')) {
+            k = 0;
+            while (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
+                   (argv[i][j + 1] == '.')) {
+              j++;
+              workstring[k] = argv[i][j];
+              k++;
+            }
+            workstring[k] = '\0';
+            b->minangle = (REAL) strtod(workstring, (char **) NULL);
+	  } else {
+            b->minangle = 20.0;
+	  }
+	}
+        if (argv[i][j] == 'a') {
+          b->quality = 1;
+          if (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
+              (argv[i][j + 1] == '.')) {
+            b->fixedarea = 1;
+            k = 0;
+            while (((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) ||
+                   (argv[i][j + 1] == '.')) {
+              j++;
+              workstring[k] = argv[i][j];
+              k++;
+            }
+            workstring[k] = '\0';
+            b->maxarea = (REAL) strtod(workstring, (char **) NULL);
+            if (b->maxarea <= 0.0) {
+              printf("Error:  Maximum area must be greater than zero.\n");
+              triexit(1);
+	    }
+	  } else {
+            b->vararea = 1;
+	  }
+	}
+        if (argv[i][j] == 'u') {
+          b->quality = 1;
+          b->usertest = 1;
+        }
+#endif /* not CDT_ONLY */
+        if (argv[i][j] == 'A') {
+          b->regionattrib = 1;
+        }
+        if (argv[i][j] == 'c') {
+          b->convex = 1;
+        }
+        if (argv[i][j] == 'w') {
+          b->weighted = 1;
+        }
+        if (argv[i][j] == 'W') {
+          b->weighted = 2;
+        }
+        if (argv[i][j] == 'j') {
+          b->jettison = 1;
+        }
+        if (argv[i][j] == 'z') {
           b->firstnumber = 0;
         }
         if (argv[i][j] == 'e') {
@@ -3466,10 +3959,21 @@ struct behavior *b;
         if (argv[i][j] == 'F') {
           b->sweepline = 1;
         }
+        if (argv[i][j] == 'b') {
+          b->incremental = 1;
+          b->brio = 1;
+        }
 #endif /* not REDUCED */
         if (argv[i][j] == 'l') {
           b->dwyer = 0;
         }
+        if (argv[i][j] == 't') {
+          b->threads = 0;
+          while ((argv[i][j + 1] >= '0') && (argv[i][j + 1] <= '9')) {
+            j++;
+            b->threads = b->threads * 10 + (int) (argv[i][j] - '0');
+          }
+        }
 #ifndef REDUCED
 #ifndef CDT_ONLY
         if (argv[i][j] == 's') {
@@ -3528,44 +4032,7 @@ struct behavior *b;
   }
 #endif /* not CDT_ONLY */
 #endif /* not TRILIBRARY */
-  b->usesegments = b->poly || b->refine || b->quality || b->convex;
-  b->goodangle = cos(b->minangle * PI / 180.0);
-  if (b->goodangle == 1.0) {
-    b->offconstant = 0.0;
-  } else {
-    b->offconstant = 0.475 * sqrt((1.0 + b->goodangle) / (1.0 - b->goodangle));
-  }
-  b->goodangle *= b->goodangle;
-  if (b->refine && b->noiterationnum) {
-    printf(
-      "Error:  You cannot use the -I switch when refining a triangulation.\n");
-    triexit(1);
-  }
-  /* Be careful not to allocate space for element area constraints that */
-  /*   will never be assigned any value (other than the default -1.0).  */
-  if (!b->refine && !b->poly) {
-    b->vararea = 0;
-  }
-  /* Be careful not to add an extra attribute to each element unless the */
-  /*   input supports it (PSLG in, but not refining a preexisting mesh). */
-  if (b->refine || !b->poly) {
-    b->regionattrib = 0;
-  }
-  /* Regular/weighted triangulations are incompatible with PSLGs */
-  /*   and meshing.                                              */
-  if (b->weighted && (b->poly || b->quality)) {
-    b->weighted = 0;
-    if (!b->quiet) {
-      printf("Warning:  weighted triangulations (-w, -W) are incompatible\n");
-      printf("  with PSLGs (-p) and meshing (-q, -a, -u).  Weights ignored.\n"
-             );
-    }
-  }
-  if (b->jettison && b->nonodewritten && !b->quiet) {
-    printf("Warning:  -j and -N switches are somewhat incompatible.\n");
-    printf("  If any vertices are jettisoned, you will need the output\n");
-    printf("  .node file to reconstruct the new node indices.");
-  }
+  behaviorfinish(b);
 
 #ifndef TRILIBRARY
   strcpy(b->inpolyfilename, b->innodefilename);
@@ -3652,6 +4119,74 @@ struct behavior *b;
 #endif /* not TRILIBRARY */
 }
 
+#ifdef TRILIBRARY
+
+/*****************************************************************************/
+/*                                                                           */
+/*  paramsbehavior()   Set up the options from a `triangulateparams', as     */
+/*                     parsecommandline() does from the switches it stands   */
+/*                     for.                                                  */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void paramsbehavior(struct triangulateparams *params, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void paramsbehavior(params, b)
+struct triangulateparams *params;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  behaviordefaults(b);
+  b->firstnumber = 0;
+  b->quiet = 1;
+  b->poly = params->poly != 0;
+  b->nopolywritten = params->nopolywritten != 0;
+  b->neighbors = params->neighbors != 0;
+  if ((params->nobisect < 0) || (params->nobisect > 2)) {
+    printf("Error:  `nobisect' must be 0, 1, or 2.\n");
+    triexit(1);
+  }
+  b->nobisect = params->nobisect;
+#ifndef CDT_ONLY
+  if (params->minangle > 0.0) {
+    b->quality = 1;
+    b->minangle = params->minangle;
+  }
+  if (params->maxarea > 0.0) {
+    b->quality = 1;
+    b->fixedarea = 1;
+    b->maxarea = params->maxarea;
+  }
+  if (params->unsuitable != NULL) {
+    b->quality = 1;
+    b->usertest = 1;
+    b->unsuitable = params->unsuitable;
+    b->unsuitabledata = params->unsuitabledata;
+  }
+  b->steiner = params->steiner;
+#endif /* not CDT_ONLY */
+  if ((params->algorithm < TRI_DIVCONQ) ||
+      (params->algorithm > TRI_SWEEPLINE)) {
+    printf("Error:  Unknown algorithm %d.\n", params->algorithm);
+    triexit(1);
+  }
+#ifndef REDUCED
+  if (params->algorithm == TRI_INCREMENTAL) {
+    b->incremental = 1;
+    b->brio = params->brio != 0;
+  }
+  if (params->algorithm == TRI_SWEEPLINE) {
+    b->sweepline = 1;
+  }
+#endif /* not REDUCED */
+  b->threads = params->threads;
+  behaviorfinish(b);
+}
+
+#endif /* TRILIBRARY */
+
 /**                                                                         **/
 /**                                                                         **/
 /********* User interaction routines begin here                      *********/
@@ -3881,6 +4416,7 @@ struct memorypool *pool;
   pool->maxitems = 0;
   pool->unallocateditems = 0;
   pool->pathitemsleft = 0;
+  pool->memory = (struct trimemory *) NULL;
 }
 
 /*****************************************************************************/
@@ -3974,8 +4510,8 @@ int alignment;
   /*   pointer (to point to the next block) are allocated, as well as space */
   /*   to ensure alignment of the items.                                    */
   pool->firstblock = (VOID **)
-    trimalloc(pool->itemsfirstblock * pool->itembytes + (int) sizeof(VOID *) +
-              pool->alignbytes);
+    memalloc(pool->memory, pool->itemsfirstblock * pool->itembytes +
+             (int) sizeof(VOID *) + pool->alignbytes);
   /* Set the next block pointer to NULL. */
   *(pool->firstblock) = (VOID *) NULL;
   poolrestart(pool);
@@ -3997,43 +4533,112 @@ struct memorypool *pool;
 {
   while (pool->firstblock != (VOID **) NULL) {
     pool->nowblock = (VOID **) *(pool->firstblock);
-    trifree((VOID *) pool->firstblock);
+    memfree(pool->memory, (VOID *) pool->firstblock);
     pool->firstblock = pool->nowblock;
   }
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  poolalloc()   Allocate space for an item.                                */
+/*  poolprepare()   Get a pool ready for a new triangulation.                */
+/*                                                                           */
+/*  Same arguments as poolinit().  If the mesh keeps its pools and this one  */
+/*  already holds memory for items of the same size, its blocks are simply   */
+/*  restarted, so no memory is freed or allocated.  Otherwise any old memory */
+/*  is freed and the pool is initialized from scratch.                       */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-VOID *poolalloc(struct memorypool *pool)
+void poolprepare(struct mesh *m, struct memorypool *pool, int bytecount,
+                 int itemcount, int firstitemcount, int alignment)
 #else /* not ANSI_DECLARATORS */
-VOID *poolalloc(pool)
+void poolprepare(m, pool, bytecount, itemcount, firstitemcount, alignment)
+struct mesh *m;
 struct memorypool *pool;
+int bytecount;
+int itemcount;
+int firstitemcount;
+int alignment;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  VOID *newitem;
-  VOID **newblock;
-  unsigned long alignptr;
+  int alignbytes;
 
-  /* First check the linked list of dead items.  If the list is not   */
-  /*   empty, allocate an item from the list rather than a fresh one. */
-  if (pool->deaditemstack != (VOID *) NULL) {
-    newitem = pool->deaditemstack;               /* Take first item in list. */
-    pool->deaditemstack = * (VOID **) pool->deaditemstack;
+  if (pool->firstblock != (VOID **) NULL) {
+    /* Same arithmetic as poolinit(). */
+    alignbytes = (alignment > sizeof(VOID *)) ? alignment : sizeof(VOID *);
+    if (m->keeppools && (pool->alignbytes == alignbytes) &&
+        (pool->itembytes == ((bytecount - 1) / alignbytes + 1) * alignbytes) &&
+        (pool->itemsperblock == itemcount)) {
+      poolrestart(pool);
+      return;
+    }
+    pooldeinit(pool);
+  }
+  if ((pool == &m->triangles) || (pool == &m->subsegs) ||
+      (pool == &m->vertices)) {
+    pool->memory = recordmemory(m);
+  } else {
+    pool->memory = &m->memory;
+  }
+  poolinit(pool, bytecount, itemcount, firstitemcount, alignment);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolrelease()   Free a pool's memory at the end of a stage, unless the   */
+/*                  mesh keeps its pools for the next triangulation.         */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void poolrelease(struct mesh *m, struct memorypool *pool)
+#else /* not ANSI_DECLARATORS */
+void poolrelease(m, pool)
+struct mesh *m;
+struct memorypool *pool;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (!m->keeppools) {
+    pooldeinit(pool);
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolalloc()   Allocate space for an item.                                */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+VOID *poolalloc(struct memorypool *pool)
+#else /* not ANSI_DECLARATORS */
+VOID *poolalloc(pool)
+struct memorypool *pool;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID *newitem;
+  VOID **newblock;
+  unsigned long alignptr;
+
+  /* First check the linked list of dead items.  If the list is not   */
+  /*   empty, allocate an item from the list rather than a fresh one. */
+  if (pool->deaditemstack != (VOID *) NULL) {
+    newitem = pool->deaditemstack;               /* Take first item in list. */
+    pool->deaditemstack = * (VOID **) pool->deaditemstack;
   } else {
     /* Check if there are any free items left in the current block. */
     if (pool->unallocateditems == 0) {
       /* Check if another block must be allocated. */
       if (*(pool->nowblock) == (VOID *) NULL) {
         /* Allocate a new block of items, pointed to by the previous block. */
-        newblock = (VOID **) trimalloc(pool->itemsperblock * pool->itembytes +
-                                       (int) sizeof(VOID *) +
-                                       pool->alignbytes);
+        newblock = (VOID **) memalloc(pool->memory,
+                                      pool->itemsperblock * pool->itembytes +
+                                      (int) sizeof(VOID *) +
+                                      pool->alignbytes);
         *(pool->nowblock) = (VOID *) newblock;
         /* The next block pointer is NULL. */
         *newblock = (VOID *) NULL;
@@ -4086,6 +4691,285 @@ VOID *dyingitem;
   pool->items--;
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  poolextend()   Allocate enough blocks that `count' more fresh items can  */
+/*                 be allocated without allocating another block.            */
+/*                                                                           */
+/*  The items themselves are not allocated.  This lets several threads       */
+/*  allocate from copies of the pool (see poolskip()) at the same time,      */
+/*  because none of them calls memalloc().                                   */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void poolextend(struct memorypool *pool, long count)
+#else /* not ANSI_DECLARATORS */
+void poolextend(pool, count)
+struct memorypool *pool;
+long count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID **block;
+  VOID **newblock;
+
+  block = pool->nowblock;
+  count -= pool->unallocateditems;
+  while (count > 0) {
+    if (*block == (VOID *) NULL) {
+      /* Allocate a new block of items, as poolalloc() would. */
+      newblock = (VOID **) memalloc(pool->memory,
+                                    pool->itemsperblock * pool->itembytes +
+                                    (int) sizeof(VOID *) +
+                                    pool->alignbytes);
+      *block = (VOID *) newblock;
+      *newblock = (VOID *) NULL;
+    }
+    block = (VOID **) *block;
+    count -= pool->itemsperblock;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  poolskip()   Allocate `count' fresh items without looking at them.       */
+/*                                                                           */
+/*  Afterward, the pool is in the same state as if poolalloc() had been      */
+/*  called `count' times, except that the stack of dead items is ignored.    */
+/*  The blocks must already be there; see poolextend().                      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void poolskip(struct memorypool *pool, long count)
+#else /* not ANSI_DECLARATORS */
+void poolskip(pool, count)
+struct memorypool *pool;
+long count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  unsigned long alignptr;
+
+  pool->items += count;
+  pool->maxitems += count;
+  while (count > (long) pool->unallocateditems) {
+    count -= pool->unallocateditems;
+    /* Move to the next block, and find its first item. */
+    pool->nowblock = (VOID **) *(pool->nowblock);
+    alignptr = (unsigned long) (pool->nowblock + 1);
+    pool->nextitem = (VOID *)
+      (alignptr + (unsigned long) pool->alignbytes -
+       (alignptr % (unsigned long) pool->alignbytes));
+    pool->unallocateditems = pool->itemsperblock;
+  }
+  pool->nextitem = (VOID *) ((char *) pool->nextitem +
+                             count * pool->itembytes);
+  pool->unallocateditems -= (int) count;
+}
+
+#ifdef INDEX32
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Index space                                                              */
+/*                                                                           */
+/*  With INDEX32, a mesh reserves a range of addresses the first time it     */
+/*  needs memory for triangles, subsegments, or vertices, and hands it out   */
+/*  from the front to the back.  Only the addresses are reserved; memory is  */
+/*  made usable behind them as the front moves on.  Nothing is given back    */
+/*  by itself.  indexrestart() starts over at the front for each             */
+/*  triangulation, keeping the memory, and indexfree() gives back the range. */
+/*                                                                           */
+/*****************************************************************************/
+
+/* Where the front starts.  No record starts below it, so offset zero can    */
+/*   stand for NULL.                                                         */
+
+#define INDEXFIRST 16
+
+/*****************************************************************************/
+/*                                                                           */
+/*  indexreserve()   Reserve a range of addresses for the index space.       */
+/*                                                                           */
+/*  Returns 0 if the system won't even give out INDEXCOMMIT bytes of them.   */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int indexreserve(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+int indexreserve(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  unsigned long bytes;
+  char *base;
+
+  /* Settle for fewer addresses, if need be. */
+  for (bytes = INDEXSPACE; bytes >= INDEXCOMMIT; bytes >>= 1) {
+#ifdef _WIN32
+    base = (char *) VirtualAlloc(NULL, (SIZE_T) bytes, MEM_RESERVE,
+                                 PAGE_NOACCESS);
+    if (base != (char *) NULL) {
+#else /* not _WIN32 */
+    base = (char *) mmap(NULL, (size_t) bytes, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base != (char *) MAP_FAILED) {
+#endif /* not _WIN32 */
+      m->indexbase = base;
+      m->indexreserved = bytes;
+      m->indexcommitted = 0;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  indexcommit()   Make at least the first `bytes' bytes of the index space */
+/*                  usable.                                                  */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int indexcommit(struct mesh *m, unsigned long bytes)
+#else /* not ANSI_DECLARATORS */
+int indexcommit(m, bytes)
+struct mesh *m;
+unsigned long bytes;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  unsigned long committed;
+
+  /* Grow by half again at least, so this isn't called often. */
+  committed = m->indexcommitted + m->indexcommitted / 2;
+  if (committed < bytes) {
+    committed = bytes;
+  }
+  committed = (committed + INDEXCOMMIT - 1) / INDEXCOMMIT * INDEXCOMMIT;
+  if (committed > m->indexreserved) {
+    committed = m->indexreserved;
+  }
+#ifdef _WIN32
+  if (VirtualAlloc(m->indexbase + m->indexcommitted,
+                   (SIZE_T) (committed - m->indexcommitted), MEM_COMMIT,
+                   PAGE_READWRITE) == NULL) {
+    return 0;
+  }
+#else /* not _WIN32 */
+  if (mprotect(m->indexbase + m->indexcommitted,
+               (size_t) (committed - m->indexcommitted),
+               PROT_READ | PROT_WRITE) != 0) {
+    return 0;
+  }
+#endif /* not _WIN32 */
+  m->indexcommitted = committed;
+  return 1;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  indexallocate()   Hand out `bytes' bytes of a mesh's index space.  The   */
+/*                    allocate() of `indexmemory'; it has no release().      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+VOID *indexallocate(VOID *data, int bytes)
+#else /* not ANSI_DECLARATORS */
+VOID *indexallocate(data, bytes)
+VOID *data;
+int bytes;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  unsigned long start, end;
+
+  m = (struct mesh *) data;
+  if ((m->indexbase == (char *) NULL) && !indexreserve(m)) {
+    return (VOID *) NULL;
+  }
+  /* Every block starts on a sixteen-byte boundary, as with malloc(). */
+  start = m->indexused;
+  end = start + ((unsigned long) bytes + 15ul) / 16ul * 16ul;
+  if (end > m->indexreserved) {
+    return (VOID *) NULL;
+  }
+  if ((end > m->indexcommitted) && !indexcommit(m, end)) {
+    return (VOID *) NULL;
+  }
+  m->indexused = end;
+  return (VOID *) (m->indexbase + start);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  indexrestart()   Forget everything in a mesh's index space, to hand it   */
+/*                   out again from the front.                               */
+/*                                                                           */
+/*  The pools of triangles, subsegments, and vertices, and `dummytri' and    */
+/*  `dummysub', are emptied.  They are prepared afresh by the triangulation  */
+/*  that follows, which costs next to nothing, as the memory is kept.        */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void indexrestart(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+void indexrestart(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  poolzero(&m->triangles);
+  poolzero(&m->subsegs);
+  poolzero(&m->vertices);
+  m->dummytribase = (triangle *) NULL;
+  m->dummysubbase = (subseg *) NULL;
+  m->dummytribytes = m->dummysubbytes = 0;
+  m->indexused = INDEXFIRST;
+  memset(&m->indexmemory, 0, sizeof(struct trimemory));
+  m->indexmemory.allocator.allocate = indexallocate;
+  m->indexmemory.allocator.data = (VOID *) m;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  indexfree()   Give a mesh's index space back to the operating system.    */
+/*                                                                           */
+/*  Whatever was in it must be forgotten (see indexrestart()) before the     */
+/*  mesh is used again.                                                      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void indexfree(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+void indexfree(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (m->indexbase != (char *) NULL) {
+#ifdef _WIN32
+    VirtualFree(m->indexbase, 0, MEM_RELEASE);
+#else /* not _WIN32 */
+    munmap(m->indexbase, (size_t) m->indexreserved);
+#endif /* not _WIN32 */
+  }
+  m->indexbase = (char *) NULL;
+  m->indexused = INDEXFIRST;
+  m->indexcommitted = m->indexreserved = 0;
+}
+
+#endif /* INDEX32 */
+
 /*****************************************************************************/
 /*                                                                           */
 /*  traversalinit()   Prepare to traverse the entire list of items.          */
@@ -4209,9 +5093,18 @@ int subsegbytes;
 {
   unsigned long alignptr;
 
-  /* Set up `dummytri', the `triangle' that occupies "outer space." */
-  m->dummytribase = (triangle *) trimalloc(trianglebytes +
-                                           m->triangles.alignbytes);
+  /* Set up `dummytri', the `triangle' that occupies "outer space."  A */
+  /*   workspace mesh keeps the old one if it is big enough.            */
+  if ((m->dummytribase == (triangle *) NULL) ||
+      (m->dummytribytes < trianglebytes + m->triangles.alignbytes)) {
+    if (m->dummytribase != (triangle *) NULL) {
+      memfree(recordmemory(m), (VOID *) m->dummytribase);
+      m->dummytribase = (triangle *) NULL;
+    }
+    m->dummytribytes = trianglebytes + m->triangles.alignbytes;
+    m->dummytribase = (triangle *) memalloc(recordmemory(m),
+                                            m->dummytribytes);
+  }
   /* Align `dummytri' on a `triangles.alignbytes'-byte boundary. */
   alignptr = (unsigned long) m->dummytribase;
   m->dummytri = (triangle *)
@@ -4221,9 +5114,9 @@ int subsegbytes;
   /*   will eventually be changed by various bonding operations, but their */
   /*   values don't really matter, as long as they can legally be          */
   /*   dereferenced.                                                       */
-  m->dummytri[0] = (triangle) m->dummytri;
-  m->dummytri[1] = (triangle) m->dummytri;
-  m->dummytri[2] = (triangle) m->dummytri;
+  m->dummytri[0] = encodetri(m->dummytri);
+  m->dummytri[1] = encodetri(m->dummytri);
+  m->dummytri[2] = encodetri(m->dummytri);
   /* Three NULL vertices. */
   m->dummytri[3] = (triangle) NULL;
   m->dummytri[4] = (triangle) NULL;
@@ -4233,8 +5126,16 @@ int subsegbytes;
     /* Set up `dummysub', the omnipresent subsegment pointed to by any */
     /*   triangle side or subsegment end that isn't attached to a real */
     /*   subsegment.                                                   */
-    m->dummysubbase = (subseg *) trimalloc(subsegbytes +
-                                           m->subsegs.alignbytes);
+    if ((m->dummysubbase == (subseg *) NULL) ||
+        (m->dummysubbytes < subsegbytes + m->subsegs.alignbytes)) {
+      if (m->dummysubbase != (subseg *) NULL) {
+        memfree(recordmemory(m), (VOID *) m->dummysubbase);
+        m->dummysubbase = (subseg *) NULL;
+      }
+      m->dummysubbytes = subsegbytes + m->subsegs.alignbytes;
+      m->dummysubbase = (subseg *) memalloc(recordmemory(m),
+                                            m->dummysubbytes);
+    }
     /* Align `dummysub' on a `subsegs.alignbytes'-byte boundary. */
     alignptr = (unsigned long) m->dummysubbase;
     m->dummysub = (subseg *)
@@ -4244,24 +5145,24 @@ int subsegbytes;
     /*   subsegment.  These will eventually be changed by various bonding  */
     /*   operations, but their values don't really matter, as long as they */
     /*   can legally be dereferenced.                                      */
-    m->dummysub[0] = (subseg) m->dummysub;
-    m->dummysub[1] = (subseg) m->dummysub;
+    m->dummysub[0] = encodesub(m->dummysub);
+    m->dummysub[1] = encodesub(m->dummysub);
     /* Four NULL vertices. */
     m->dummysub[2] = (subseg) NULL;
     m->dummysub[3] = (subseg) NULL;
     m->dummysub[4] = (subseg) NULL;
     m->dummysub[5] = (subseg) NULL;
     /* Initialize the two adjoining triangles to be "outer space." */
-    m->dummysub[6] = (subseg) m->dummytri;
-    m->dummysub[7] = (subseg) m->dummytri;
+    m->dummysub[6] = (subseg) encodetri(m->dummytri);
+    m->dummysub[7] = (subseg) encodetri(m->dummytri);
     /* Set the boundary marker to zero. */
     * (int *) (m->dummysub + 8) = 0;
 
     /* Initialize the three adjoining subsegments of `dummytri' to be */
     /*   the omnipresent subsegment.                                  */
-    m->dummytri[6] = (triangle) m->dummysub;
-    m->dummytri[7] = (triangle) m->dummysub;
-    m->dummytri[8] = (triangle) m->dummysub;
+    m->dummytri[6] = (triangle) encodesub(m->dummysub);
+    m->dummytri[7] = (triangle) encodesub(m->dummysub);
+    m->dummytri[8] = (triangle) encodesub(m->dummysub);
   }
 }
 
@@ -4302,9 +5203,9 @@ struct behavior *b;
   }
 
   /* Initialize the pool of vertices. */
-  poolinit(&m->vertices, vertexsize, VERTEXPERBLOCK,
-           m->invertices > VERTEXPERBLOCK ? m->invertices : VERTEXPERBLOCK,
-           sizeof(REAL));
+  poolprepare(m, &m->vertices, vertexsize, VERTEXPERBLOCK,
+              m->invertices > VERTEXPERBLOCK ? m->invertices : VERTEXPERBLOCK,
+              sizeof(REAL));
 }
 
 /*****************************************************************************/
@@ -4361,15 +5262,15 @@ struct behavior *b;
   }
 
   /* Having determined the memory size of a triangle, initialize the pool. */
-  poolinit(&m->triangles, trisize, TRIPERBLOCK,
-           (2 * m->invertices - 2) > TRIPERBLOCK ? (2 * m->invertices - 2) :
-           TRIPERBLOCK, 4);
+  poolprepare(m, &m->triangles, trisize, TRIPERBLOCK,
+              (2 * m->invertices - 2) > TRIPERBLOCK ? (2 * m->invertices - 2) :
+              TRIPERBLOCK, 4);
 
   if (b->usesegments) {
     /* Initialize the pool of subsegments.  Take into account all eight */
     /*   pointers and one boundary marker.                              */
-    poolinit(&m->subsegs, 8 * sizeof(triangle) + sizeof(int),
-             SUBSEGPERBLOCK, SUBSEGPERBLOCK, 4);
+    poolprepare(m, &m->subsegs, 8 * sizeof(triangle) + sizeof(int),
+                SUBSEGPERBLOCK, SUBSEGPERBLOCK, 4);
 
     /* Initialize the "outer space" triangle and omnipresent subsegment. */
     dummyinit(m, b, m->triangles.itembytes, m->subsegs.itembytes);
@@ -4635,12 +5536,15 @@ struct behavior *b;
 
 {
   pooldeinit(&m->triangles);
-  trifree((VOID *) m->dummytribase);
+  memfree(recordmemory(m), (VOID *) m->dummytribase);
   if (b->usesegments) {
     pooldeinit(&m->subsegs);
-    trifree((VOID *) m->dummysubbase);
+    memfree(recordmemory(m), (VOID *) m->dummysubbase);
   }
   pooldeinit(&m->vertices);
+#ifdef INDEX32
+  indexfree(m);
+#endif /* INDEX32 */
 #ifndef CDT_ONLY
   if (b->quality) {
     pooldeinit(&m->badsubsegs);
@@ -4652,6 +5556,57 @@ struct behavior *b;
 #endif /* not CDT_ONLY */
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  meshfree()   Free all memory a mesh holds, whatever stage it got to.     */
+/*                                                                           */
+/*  Unlike triangledeinit(), this doesn't depend on the switches, so it can  */
+/*  clean up a workspace's mesh, or a mesh whose triangulation was cut short */
+/*  by an error.  Pools and arrays that were never allocated (or were freed  */
+/*  already) are NULL, and are skipped.                                      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void meshfree(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+void meshfree(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  pooldeinit(&m->triangles);
+  pooldeinit(&m->subsegs);
+  pooldeinit(&m->vertices);
+  pooldeinit(&m->viri);
+  pooldeinit(&m->badsubsegs);
+  pooldeinit(&m->badtriangles);
+  pooldeinit(&m->flipstackers);
+  pooldeinit(&m->splaynodes);
+  if (m->dummytribase != (triangle *) NULL) {
+    memfree(recordmemory(m), (VOID *) m->dummytribase);
+    m->dummytribase = (triangle *) NULL;
+  }
+  if (m->dummysubbase != (subseg *) NULL) {
+    memfree(recordmemory(m), (VOID *) m->dummysubbase);
+    m->dummysubbase = (subseg *) NULL;
+  }
+#ifdef INDEX32
+  indexfree(m);
+#endif /* INDEX32 */
+  if (m->sortarray != (vertex *) NULL) {
+    memfree(&m->memory, (VOID *) m->sortarray);
+    m->sortarray = (vertex *) NULL;
+  }
+  if (m->sortkeys != (struct sortvertex *) NULL) {
+    memfree(&m->memory, (VOID *) m->sortkeys);
+    m->sortkeys = (struct sortvertex *) NULL;
+  }
+  m->dummytribytes = m->dummysubbytes = 0;
+  m->sortarraysize = 0;
+  m->sortkeyssize = 0;
+}
+
 /**                                                                         **/
 /**                                                                         **/
 /********* Memory management routines end here                       *********/
@@ -4680,9 +5635,9 @@ struct otri *newotri;
 
   newotri->tri = (triangle *) poolalloc(&m->triangles);
   /* Initialize the three adjoining triangles to be "outer space". */
-  newotri->tri[0] = (triangle) m->dummytri;
-  newotri->tri[1] = (triangle) m->dummytri;
-  newotri->tri[2] = (triangle) m->dummytri;
+  newotri->tri[0] = encodetri(m->dummytri);
+  newotri->tri[1] = encodetri(m->dummytri);
+  newotri->tri[2] = encodetri(m->dummytri);
   /* Three NULL vertices. */
   newotri->tri[3] = (triangle) NULL;
   newotri->tri[4] = (triangle) NULL;
@@ -4690,9 +5645,9 @@ struct otri *newotri;
   if (b->usesegments) {
     /* Initialize the three adjoining subsegments to be the omnipresent */
     /*   subsegment.                                                    */
-    newotri->tri[6] = (triangle) m->dummysub;
-    newotri->tri[7] = (triangle) m->dummysub;
-    newotri->tri[8] = (triangle) m->dummysub;
+    newotri->tri[6] = (triangle) encodesub(m->dummysub);
+    newotri->tri[7] = (triangle) encodesub(m->dummysub);
+    newotri->tri[8] = (triangle) encodesub(m->dummysub);
   }
   for (i = 0; i < m->eextras; i++) {
     setelemattribute(*newotri, i, 0.0);
@@ -4722,16 +5677,16 @@ struct osub *newsubseg;
   newsubseg->ss = (subseg *) poolalloc(&m->subsegs);
   /* Initialize the two adjoining subsegments to be the omnipresent */
   /*   subsegment.                                                  */
-  newsubseg->ss[0] = (subseg) m->dummysub;
-  newsubseg->ss[1] = (subseg) m->dummysub;
+  newsubseg->ss[0] = encodesub(m->dummysub);
+  newsubseg->ss[1] = encodesub(m->dummysub);
   /* Four NULL vertices. */
   newsubseg->ss[2] = (subseg) NULL;
   newsubseg->ss[3] = (subseg) NULL;
   newsubseg->ss[4] = (subseg) NULL;
   newsubseg->ss[5] = (subseg) NULL;
   /* Initialize the two adjoining triangles to be "outer space." */
-  newsubseg->ss[6] = (subseg) m->dummytri;
-  newsubseg->ss[7] = (subseg) m->dummytri;
+  newsubseg->ss[6] = (subseg) encodetri(m->dummytri);
+  newsubseg->ss[7] = (subseg) encodetri(m->dummytri);
   /* Set the boundary marker to zero. */
   setmark(*newsubseg, 0);
 
@@ -4762,6 +5717,23 @@ struct osub *newsubseg;
 #define Absolute(a)  ((a) >= 0.0 ? (a) : -(a))
 /* #define Absolute(a)  fabs(a) */
 
+/* counterclockwise() and incircle() are called from dozens of places, many  */
+/*   millions of times per mesh, and almost always the floating-point filter */
+/*   settles the sign.  So the filters are forced inline into their callers, */
+/*   and the exact fallbacks (counterclockwiseadapt(), incircleadapt()) are  */
+/*   kept out of line, where they don't bloat the callers' fast paths.       */
+
+#if defined(__GNUC__)
+#define PREDICATEINLINE inline __attribute__((always_inline))
+#define PREDICATENOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define PREDICATEINLINE __forceinline
+#define PREDICATENOINLINE __declspec(noinline)
+#else /* not __GNUC__ and not _MSC_VER */
+#define PREDICATEINLINE inline
+#define PREDICATENOINLINE
+#endif /* not __GNUC__ and not _MSC_VER */
+
 /* Many of the operations are broken up into two pieces, a main part that    */
 /*   performs an approximate operation, and a "tail" that computes the       */
 /*   roundoff error of that operation.                                       */
@@ -4876,28 +5848,15 @@ struct osub *newsubseg;
 
 /*****************************************************************************/
 /*                                                                           */
-/*  exactinit()   Initialize the variables used for exact arithmetic.        */
-/*                                                                           */
-/*  `epsilon' is the largest power of two such that 1.0 + epsilon = 1.0 in   */
-/*  floating-point arithmetic.  `epsilon' bounds the relative roundoff       */
-/*  error.  It is used for floating-point error analysis.                    */
-/*                                                                           */
-/*  `splitter' is used to split floating-point numbers into two half-        */
-/*  length significands for exact multiplication.                            */
-/*                                                                           */
-/*  I imagine that a highly optimizing compiler might be too smart for its   */
-/*  own good, and somehow cause this routine to fail, if it pretends that    */
-/*  floating-point arithmetic is too much like real arithmetic.              */
+/*  fpuinit()   Set the floating-point unit to the precision of REAL.        */
 /*                                                                           */
-/*  Don't change this routine unless you fully understand it.                */
+/*  The control word belongs to the thread that sets it, so this is done at  */
+/*  the start of every triangulation, not just once.                         */
 /*                                                                           */
 /*****************************************************************************/
 
-void exactinit()
+void fpuinit()
 {
-  REAL half;
-  REAL check, lastcheck;
-  int every_other;
 #ifdef LINUX
   int cword;
 #endif /* LINUX */
@@ -4919,6 +5878,34 @@ void exactinit()
 #endif /* not SINGLE */
   _FPU_SETCW(cword);
 #endif /* LINUX */
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  exactinit()   Initialize the variables used for exact arithmetic.        */
+/*                                                                           */
+/*  `epsilon' is the largest power of two such that 1.0 + epsilon = 1.0 in   */
+/*  floating-point arithmetic.  `epsilon' bounds the relative roundoff       */
+/*  error.  It is used for floating-point error analysis.                    */
+/*                                                                           */
+/*  `splitter' is used to split floating-point numbers into two half-        */
+/*  length significands for exact multiplication.                            */
+/*                                                                           */
+/*  I imagine that a highly optimizing compiler might be too smart for its   */
+/*  own good, and somehow cause this routine to fail, if it pretends that    */
+/*  floating-point arithmetic is too much like real arithmetic.              */
+/*                                                                           */
+/*  Don't change this routine unless you fully understand it.                */
+/*                                                                           */
+/*****************************************************************************/
+
+void exactinit()
+{
+  REAL half;
+  REAL check, lastcheck;
+  int every_other;
+
+  fpuinit();
 
   every_other = 1;
   half = 0.5;
@@ -4952,6 +5939,24 @@ void exactinit()
   o3derrboundC = (26.0 + 288.0 * epsilon) * epsilon * epsilon;
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  exactinitonce()   Make sure exactinit() has run, exactly once.           */
+/*                                                                           */
+/*  Triangle is compiled as C++, where the initialization of a local static  */
+/*  happens once even if several threads get here at the same time.  The     */
+/*  FPU control word is per thread, so it is set again every time.           */
+/*                                                                           */
+/*****************************************************************************/
+
+void exactinitonce()
+{
+  static int initialized = (exactinit(), 1);
+
+  (void) initialized;
+  fpuinit();
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  fast_expansion_sum_zeroelim()   Sum two expansions, eliminating zero     */
@@ -5156,8 +6161,10 @@ REAL *e;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
+PREDICATENOINLINE
 REAL counterclockwiseadapt(vertex pa, vertex pb, vertex pc, REAL detsum)
 #else /* not ANSI_DECLARATORS */
+PREDICATENOINLINE
 REAL counterclockwiseadapt(pa, pb, pc, detsum)
 vertex pa;
 vertex pb;
@@ -5244,56 +6251,67 @@ REAL detsum;
   return(D[Dlength - 1]);
 }
 
-#ifdef ANSI_DECLARATORS
-REAL counterclockwise(struct mesh *m, struct behavior *b,
-                      vertex pa, vertex pb, vertex pc)
-#else /* not ANSI_DECLARATORS */
-REAL counterclockwise(m, b, pa, pb, pc)
-struct mesh *m;
-struct behavior *b;
+/*****************************************************************************/
+/*                                                                           */
+/*  orientfilter()   counterclockwise() without the mesh:  the filter, then  */
+/*                   the exact fallback unless `noexact' is set.             */
+/*                                                                           */
+/*  The filter is Shewchuk's, without its branches.  If detleft and          */
+/*  detright have different signs (or one is zero), the determinant is at    */
+/*  least their summed magnitudes, so it always passes the bound; if they    */
+/*  have the same sign, the bound is the one he uses.  So the same value is  */
+/*  returned in every case, and the exact code runs in the same cases.       */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+PREDICATEINLINE
+REAL orientfilter(vertex pa, vertex pb, vertex pc, int noexact)
+#else /* not ANSI_DECLARATORS */
+PREDICATEINLINE
+REAL orientfilter(pa, pb, pc, noexact)
 vertex pa;
 vertex pb;
 vertex pc;
+int noexact;
 #endif /* not ANSI_DECLARATORS */
 
 {
   REAL detleft, detright, det;
   REAL detsum, errbound;
 
-  m->counterclockcount++;
-
   detleft = (pa[0] - pc[0]) * (pb[1] - pc[1]);
   detright = (pa[1] - pc[1]) * (pb[0] - pc[0]);
   det = detleft - detright;
 
-  if (b->noexact) {
-    return det;
-  }
-
-  if (detleft > 0.0) {
-    if (detright <= 0.0) {
-      return det;
-    } else {
-      detsum = detleft + detright;
-    }
-  } else if (detleft < 0.0) {
-    if (detright >= 0.0) {
-      return det;
-    } else {
-      detsum = -detleft - detright;
-    }
-  } else {
-    return det;
-  }
-
+  detsum = Absolute(detleft) + Absolute(detright);
   errbound = ccwerrboundA * detsum;
-  if ((det >= errbound) || (-det >= errbound)) {
+  if (noexact || (det >= errbound) || (-det >= errbound)) {
     return det;
   }
 
   return counterclockwiseadapt(pa, pb, pc, detsum);
 }
 
+#ifdef ANSI_DECLARATORS
+PREDICATEINLINE
+REAL counterclockwise(struct mesh *m, struct behavior *b,
+                      vertex pa, vertex pb, vertex pc)
+#else /* not ANSI_DECLARATORS */
+PREDICATEINLINE
+REAL counterclockwise(m, b, pa, pb, pc)
+struct mesh *m;
+struct behavior *b;
+vertex pa;
+vertex pb;
+vertex pc;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  m->counterclockcount++;
+  return orientfilter(pa, pb, pc, b->noexact);
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  incircle()   Return a positive value if the point pd lies inside the     */
@@ -5314,8 +6332,10 @@ vertex pc;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
+PREDICATENOINLINE
 REAL incircleadapt(vertex pa, vertex pb, vertex pc, vertex pd, REAL permanent)
 #else /* not ANSI_DECLARATORS */
+PREDICATENOINLINE
 REAL incircleadapt(pa, pb, pc, pd, permanent)
 vertex pa;
 vertex pb;
@@ -5892,17 +6912,24 @@ REAL permanent;
   return finnow[finlength - 1];
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  incirclefilter()   incircle() without the mesh:  the filter, then the    */
+/*                     exact fallback unless `noexact' is set.               */
+/*                                                                           */
+/*****************************************************************************/
+
 #ifdef ANSI_DECLARATORS
-REAL incircle(struct mesh *m, struct behavior *b,
-              vertex pa, vertex pb, vertex pc, vertex pd)
+PREDICATEINLINE
+REAL incirclefilter(vertex pa, vertex pb, vertex pc, vertex pd, int noexact)
 #else /* not ANSI_DECLARATORS */
-REAL incircle(m, b, pa, pb, pc, pd)
-struct mesh *m;
-struct behavior *b;
+PREDICATEINLINE
+REAL incirclefilter(pa, pb, pc, pd, noexact)
 vertex pa;
 vertex pb;
 vertex pc;
 vertex pd;
+int noexact;
 #endif /* not ANSI_DECLARATORS */
 
 {
@@ -5912,8 +6939,6 @@ vertex pd;
   REAL det;
   REAL permanent, errbound;
 
-  m->incirclecount++;
-
   adx = pa[0] - pd[0];
   bdx = pb[0] - pd[0];
   cdx = pc[0] - pd[0];
@@ -5937,7 +6962,7 @@ vertex pd;
       + blift * (cdxady - adxcdy)
       + clift * (adxbdy - bdxady);
 
-  if (b->noexact) {
+  if (noexact) {
     return det;
   }
 
@@ -5952,6 +6977,26 @@ vertex pd;
   return incircleadapt(pa, pb, pc, pd, permanent);
 }
 
+#ifdef ANSI_DECLARATORS
+PREDICATEINLINE
+REAL incircle(struct mesh *m, struct behavior *b,
+              vertex pa, vertex pb, vertex pc, vertex pd)
+#else /* not ANSI_DECLARATORS */
+PREDICATEINLINE
+REAL incircle(m, b, pa, pb, pc, pd)
+struct mesh *m;
+struct behavior *b;
+vertex pa;
+vertex pb;
+vertex pc;
+vertex pd;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  m->incirclecount++;
+  return incirclefilter(pa, pb, pc, pd, b->noexact);
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  orient3d()   Return a positive value if the point pd lies below the      */
@@ -6631,10 +7676,52 @@ int offcenter;
 /**                                                                         **/
 /********* Geometric primitives end here                             *********/
 
+/*****************************************************************************/
+/*                                                                           */
+/*  meshrestart()   Reset the variables that describe one triangulation,     */
+/*                  leaving the memory pools alone.                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void meshrestart(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+void meshrestart(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  m->recenttri.tri = (triangle *) NULL; /* No triangle has been visited yet. */
+  m->undeads = 0;                       /* No eliminated input vertices yet. */
+  m->samples = 1;         /* Point location should take at least one sample. */
+  m->walklocate = 0;                  /* Sample, unless -b says otherwise. */
+  m->checksegments = 0;   /* There are no segments in the triangulation yet. */
+  m->checkquality = 0;     /* The quality triangulation stage has not begun. */
+  m->incirclecount = m->counterclockcount = m->orient3dcount = 0;
+  m->hyperbolacount = m->circletopcount = m->circumcentercount = 0;
+  /* Pools kept from an earlier triangulation must not count toward this */
+  /*   one's statistics, even if they go unused this time.               */
+  m->vertices.maxitems = m->triangles.maxitems = m->subsegs.maxitems = 0;
+  m->viri.maxitems = m->badsubsegs.maxitems = m->badtriangles.maxitems = 0;
+  m->flipstackers.maxitems = m->splaynodes.maxitems = 0;
+  m->randomseed = 1;
+  m->maxtriangles = 0;                                 /* No budget so far. */
+  m->maxvertices = 0;
+  m->deadline = 0;
+  m->clockcountdown = 0;
+  m->outofbudget = 0;
+  m->steinerkept = 0;
+
+  exactinitonce();        /* Make sure exact arithmetic is ready to be used. */
+}
+
 /*****************************************************************************/
 /*                                                                           */
 /*  triangleinit()   Initialize some variables.                              */
 /*                                                                           */
+/*  The memory pools are emptied without freeing anything, so this must only */
+/*  be used on a fresh `struct mesh'.                                        */
+/*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
@@ -6654,16 +7741,23 @@ struct mesh *m;
   poolzero(&m->flipstackers);
   poolzero(&m->splaynodes);
 
-  m->recenttri.tri = (triangle *) NULL; /* No triangle has been visited yet. */
-  m->undeads = 0;                       /* No eliminated input vertices yet. */
-  m->samples = 1;         /* Point location should take at least one sample. */
-  m->checksegments = 0;   /* There are no segments in the triangulation yet. */
-  m->checkquality = 0;     /* The quality triangulation stage has not begun. */
-  m->incirclecount = m->counterclockcount = m->orient3dcount = 0;
-  m->hyperbolacount = m->circletopcount = m->circumcentercount = 0;
-  randomseed = 1;
-
-  exactinit();                     /* Initialize exact arithmetic constants. */
+  m->keeppools = 0;
+  m->dummytribase = (triangle *) NULL;
+  m->dummysubbase = (subseg *) NULL;
+  m->dummytribytes = m->dummysubbytes = 0;
+  m->sortarray = (vertex *) NULL;
+  m->sortarraysize = 0;
+  m->sortkeys = (struct sortvertex *) NULL;
+  m->sortkeyssize = 0;
+  memset(&m->memory, 0, sizeof(struct trimemory));
+#ifdef INDEX32
+  m->indexbase = (char *) NULL;
+  m->indexused = INDEXFIRST;
+  m->indexcommitted = m->indexreserved = 0;
+  memset(&m->indexmemory, 0, sizeof(struct trimemory));
+#endif /* INDEX32 */
+
+  meshrestart(m);
 }
 
 /*****************************************************************************/
@@ -6677,15 +7771,16 @@ struct mesh *m;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-unsigned long randomnation(unsigned int choices)
+unsigned long randomnation(struct mesh *m, unsigned int choices)
 #else /* not ANSI_DECLARATORS */
-unsigned long randomnation(choices)
+unsigned long randomnation(m, choices)
+struct mesh *m;
 unsigned int choices;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  randomseed = (randomseed * 1366l + 150889l) % 714025l;
-  return randomseed / (714025l / choices + 1);
+  m->randomseed = (m->randomseed * 1366l + 150889l) % 714025l;
+  return m->randomseed / (714025l / choices + 1);
 }
 
 /********* Mesh quality testing routines begin here                  *********/
@@ -7208,25 +8303,22 @@ struct osub *testsubseg;
 
 /*****************************************************************************/
 /*                                                                           */
-/*  testtriangle()   Test a triangle for quality and size.                   */
+/*  testtrianglekind()   Test a triangle for quality and size.               */
 /*                                                                           */
 /*  Tests a triangle to see if it satisfies the minimum angle condition and  */
 /*  the maximum area condition.  Triangles that aren't up to spec are added  */
 /*  to the bad triangle queue.                                               */
 /*                                                                           */
+/*  There is one of these for each of QUALITYANGLE, QUALITYAREA, and         */
+/*  QUALITYANY (the template parameter `test').  The first two leave out the */
+/*  tests of the switches they exclude; the compiler folds them away.        */
+/*                                                                           */
 /*****************************************************************************/
 
 #ifndef CDT_ONLY
 
-#ifdef ANSI_DECLARATORS
-void testtriangle(struct mesh *m, struct behavior *b, struct otri *testtri)
-#else /* not ANSI_DECLARATORS */
-void testtriangle(m, b, testtri)
-struct mesh *m;
-struct behavior *b;
-struct otri *testtri;
-#endif /* not ANSI_DECLARATORS */
-
+template <int test>
+void testtrianglekind(struct mesh *m, struct behavior *b, struct otri *testtri)
 {
   struct otri tri1, tri2;
   struct osub testsub;
@@ -7240,9 +8332,15 @@ struct otri *testtri;
   REAL angle;
   REAL area;
   REAL dist1, dist2;
+  int vararea, fixedarea, usertest;
   subseg sptr;                      /* Temporary variable used by tspivot(). */
   triangle ptr;           /* Temporary variable used by oprev() and dnext(). */
 
+  /* Constants, except for QUALITYANY. */
+  vararea = (test == QUALITYANY) && b->vararea;
+  fixedarea = (test == QUALITYAREA) || ((test == QUALITYANY) && b->fixedarea);
+  usertest = (test == QUALITYANY) && b->usertest;
+
   org(*testtri, torg);
   dest(*testtri, tdest);
   apex(*testtri, tapex);
@@ -7292,26 +8390,28 @@ struct otri *testtri;
     lprev(*testtri, tri1);
   }
 
-  if (b->vararea || b->fixedarea || b->usertest) {
+  if (vararea || fixedarea || usertest) {
     /* Check whether the area is larger than permitted. */
     area = 0.5 * (dxod * dyda - dyod * dxda);
-    if (b->fixedarea && (area > b->maxarea)) {
+    if (fixedarea && (area > b->maxarea)) {
       /* Add this triangle to the list of bad triangles. */
       enqueuebadtri(m, b, testtri, minedge, tapex, torg, tdest);
       return;
     }
 
     /* Nonpositive area constraints are treated as unconstrained. */
-    if ((b->vararea) && (area > areabound(*testtri)) &&
+    if (vararea && (area > areabound(*testtri)) &&
         (areabound(*testtri) > 0.0)) {
       /* Add this triangle to the list of bad triangles. */
       enqueuebadtri(m, b, testtri, minedge, tapex, torg, tdest);
       return;
     }
 
-    if (b->usertest) {
+    if (usertest) {
       /* Check whether the user thinks this triangle is too large. */
-      if (triunsuitable(torg, tdest, tapex, area)) {
+      if ((b->unsuitable != NULL) ?
+          b->unsuitable(torg, tdest, tapex, area, b->unsuitabledata) :
+          triunsuitable(torg, tdest, tapex, area)) {
         enqueuebadtri(m, b, testtri, minedge, tapex, torg, tdest);
         return;
       }
@@ -7380,6 +8480,32 @@ struct otri *testtri;
   }
 }
 
+/*****************************************************************************/
+/*                                                                           */
+/*  testtriangle()   Test a triangle for quality and size, with the          */
+/*                   testtrianglekind() the switches call for.               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void testtriangle(struct mesh *m, struct behavior *b, struct otri *testtri)
+#else /* not ANSI_DECLARATORS */
+void testtriangle(m, b, testtri)
+struct mesh *m;
+struct behavior *b;
+struct otri *testtri;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (b->qualitytest == QUALITYANGLE) {
+    testtrianglekind<QUALITYANGLE>(m, b, testtri);
+  } else if (b->qualitytest == QUALITYAREA) {
+    testtrianglekind<QUALITYAREA>(m, b, testtri);
+  } else {
+    testtrianglekind<QUALITYANY>(m, b, testtri);
+  }
+}
+
 #endif /* not CDT_ONLY */
 
 /**                                                                         **/
@@ -7402,6 +8528,10 @@ struct otri *testtri;
 /*  of several triangles, but in the end every vertex will point to some     */
 /*  triangle that contains it.                                               */
 /*                                                                           */
+/*  Duplicate vertices are in no triangle.  Their pointers are cleared       */
+/*  first, so that insertsegment() finds a segment that ends at one by point */
+/*  location, instead of following whatever its memory held before.         */
+/*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
@@ -7415,10 +8545,17 @@ struct behavior *b;
 {
   struct otri triangleloop;
   vertex triorg;
+  vertex vertexloop;
 
   if (b->verbose) {
     printf("    Constructing mapping from vertices to triangles.\n");
   }
+  traversalinit(&m->vertices);
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    setvertex2tri(vertexloop, (triangle) NULL);
+    vertexloop = vertextraverse(m);
+  }
   traversalinit(&m->triangles);
   triangleloop.tri = triangletraverse(m);
   while (triangleloop.tri != (triangle *) NULL) {
@@ -7721,6 +8858,10 @@ struct otri *searchtri;
   samplesleft = (m->samples * m->triangles.itemsfirstblock - 1) /
                 m->triangles.maxitems + 1;
   totalsamplesleft = m->samples;
+  if (m->walklocate) {
+    /* `recenttri' is close enough; don't sample at all. */
+    totalsamplesleft = 0;
+  }
   population = m->triangles.itemsfirstblock;
   totalpopulation = m->triangles.maxitems;
   sampleblock = m->triangles.firstblock;
@@ -7739,9 +8880,9 @@ struct otri *searchtri;
 
     /* Choose `samplesleft' randomly sampled triangles in this block. */
     do {
-      sampletri.tri = (triangle *) (firsttri +
-                                    (randomnation((unsigned int) population) *
-                                     m->triangles.itembytes));
+      sampletri.tri = (triangle *)
+                      (firsttri + (randomnation(m, (unsigned int) population) *
+                                   m->triangles.itembytes));
       if (!deadtri(sampletri.tri)) {
         org(sampletri, torg);
         dist = (searchpoint[0] - torg[0]) * (searchpoint[0] - torg[0]) +
@@ -9209,9 +10350,10 @@ struct behavior *b;
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void vertexsort(vertex *sortarray, int arraysize)
+void vertexsort(struct mesh *m, vertex *sortarray, int arraysize)
 #else /* not ANSI_DECLARATORS */
-void vertexsort(sortarray, arraysize)
+void vertexsort(m, sortarray, arraysize)
+struct mesh *m;
 vertex *sortarray;
 int arraysize;
 #endif /* not ANSI_DECLARATORS */
@@ -9234,7 +10376,7 @@ int arraysize;
     return;
   }
   /* Choose a random pivot to split the array. */
-  pivot = (int) randomnation((unsigned int) arraysize);
+  pivot = (int) randomnation(m, (unsigned int) arraysize);
   pivotx = sortarray[pivot][0];
   pivoty = sortarray[pivot][1];
   /* Split the array. */
@@ -9262,5413 +10404,8245 @@ int arraysize;
   }
   if (left > 1) {
     /* Recursively sort the left subset. */
-    vertexsort(sortarray, left);
+    vertexsort(m, sortarray, left);
   }
   if (right < arraysize - 2) {
     /* Recursively sort the right subset. */
-    vertexsort(&sortarray[right + 1], arraysize - right - 1);
+    vertexsort(m, &sortarray[right + 1], arraysize - right - 1);
   }
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  vertexmedian()   An order statistic algorithm, almost.  Shuffles an      */
-/*                   array of vertices so that the first `median' vertices   */
-/*                   occur lexicographically before the remaining vertices.  */
+/*  radixkey()   Map a coordinate to an unsigned integer that sorts the same */
+/*               way.                                                        */
 /*                                                                           */
-/*  Uses the x-coordinate as the primary key if axis == 0; the y-coordinate  */
-/*  if axis == 1.  Very similar to the vertexsort() procedure, but runs in   */
-/*  randomized linear time.                                                  */
+/*  A positive number gets its sign bit set, and a negative one gets all of  */
+/*  its bits flipped.  The two zeros, which compare equal, get the same key. */
 /*                                                                           */
 /*****************************************************************************/
 
+struct sortvertex {
+  unsigned long long key[2];      /* Keys of the x and y coordinates. */
+  vertex v;
+};
+
 #ifdef ANSI_DECLARATORS
-void vertexmedian(vertex *sortarray, int arraysize, int median, int axis)
+unsigned long long radixkey(REAL coord)
 #else /* not ANSI_DECLARATORS */
-void vertexmedian(sortarray, arraysize, median, axis)
-vertex *sortarray;
-int arraysize;
-int median;
-int axis;
+unsigned long long radixkey(coord)
+REAL coord;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  int left, right;
-  int pivot;
-  REAL pivot1, pivot2;
-  vertex temp;
+  unsigned long long key, sign;
+#ifdef SINGLE
+  unsigned int bits;
+#endif /* SINGLE */
 
-  if (arraysize == 2) {
-    /* Recursive base case. */
-    if ((sortarray[0][axis] > sortarray[1][axis]) ||
-        ((sortarray[0][axis] == sortarray[1][axis]) &&
-         (sortarray[0][1 - axis] > sortarray[1][1 - axis]))) {
-      temp = sortarray[1];
-      sortarray[1] = sortarray[0];
-      sortarray[0] = temp;
-    }
-    return;
+  if (coord == 0.0) {
+    /* No -0.0. */
+    coord = 0.0;
   }
-  /* Choose a random pivot to split the array. */
-  pivot = (int) randomnation((unsigned int) arraysize);
-  pivot1 = sortarray[pivot][axis];
-  pivot2 = sortarray[pivot][1 - axis];
-  /* Split the array. */
-  left = -1;
-  right = arraysize;
-  while (left < right) {
-    /* Search for a vertex whose x-coordinate is too large for the left. */
-    do {
-      left++;
-    } while ((left <= right) && ((sortarray[left][axis] < pivot1) ||
-                                 ((sortarray[left][axis] == pivot1) &&
-                                  (sortarray[left][1 - axis] < pivot2))));
-    /* Search for a vertex whose x-coordinate is too small for the right. */
-    do {
-      right--;
-    } while ((left <= right) && ((sortarray[right][axis] > pivot1) ||
-                                 ((sortarray[right][axis] == pivot1) &&
-                                  (sortarray[right][1 - axis] > pivot2))));
-    if (left < right) {
-      /* Swap the left and right vertices. */
-      temp = sortarray[left];
-      sortarray[left] = sortarray[right];
-      sortarray[right] = temp;
-    }
+#ifdef SINGLE
+  memcpy(&bits, &coord, sizeof(REAL));
+  key = (unsigned long long) bits;
+#else /* not SINGLE */
+  memcpy(&key, &coord, sizeof(REAL));
+#endif /* not SINGLE */
+  sign = 1ull << (8 * sizeof(REAL) - 1);
+  if (key & sign) {
+    return ~key & (sign | (sign - 1));
+  } else {
+    return key | sign;
   }
-  /* Unlike in vertexsort(), at most one of the following */
-  /*   conditionals is true.                             */
-  if (left > median) {
-    /* Recursively shuffle the left subset. */
-    vertexmedian(sortarray, left, median, axis);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  radixsort()   Sort an array of keyed vertices by x-coordinate, using the */
+/*                y-coordinate as a secondary key.                           */
+/*                                                                           */
+/*  A least significant digit first radix sort, RADIXBITS bits at a time:    */
+/*  first the digits of the y key, then those of x.  Every pass is stable,   */
+/*  so vertices with equal keys stay in the order they came in.  Counting    */
+/*  the digits does not depend on the order, so it is done for all passes at */
+/*  once, and passes where all the vertices have the same digit are skipped. */
+/*  `scratch' must have room for `count' vertices.                           */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void radixsort(struct sortvertex *keys, struct sortvertex *scratch, int count)
+#else /* not ANSI_DECLARATORS */
+void radixsort(keys, scratch, count)
+struct sortvertex *keys;
+struct sortvertex *scratch;
+int count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int counts[2][(8 * sizeof(REAL) + RADIXBITS - 1) / RADIXBITS]
+            [1 << RADIXBITS];
+  struct sortvertex *from, *to, *swap;
+  int *bucket;
+  int digits, axis, digit, shift;
+  int total, size;
+  int i;
+
+  digits = (8 * (int) sizeof(REAL) + RADIXBITS - 1) / RADIXBITS;
+  memset(counts, 0, sizeof(counts));
+  for (i = 0; i < count; i++) {
+    for (digit = 0; digit < digits; digit++) {
+      shift = digit * RADIXBITS;
+      counts[0][digit][(keys[i].key[0] >> shift) & ((1 << RADIXBITS) - 1)]++;
+      counts[1][digit][(keys[i].key[1] >> shift) & ((1 << RADIXBITS) - 1)]++;
+    }
+  }
+
+  from = keys;
+  to = scratch;
+  for (axis = 1; axis >= 0; axis--) {
+    for (digit = 0; digit < digits; digit++) {
+      shift = digit * RADIXBITS;
+      bucket = counts[axis][digit];
+      if (bucket[(from[0].key[axis] >> shift) & ((1 << RADIXBITS) - 1)] ==
+          count) {
+        /* Every vertex has the same digit here. */
+        continue;
+      }
+      /* Turn the counts into the first position of each digit. */
+      total = 0;
+      for (i = 0; i < 1 << RADIXBITS; i++) {
+        size = bucket[i];
+        bucket[i] = total;
+        total += size;
+      }
+      for (i = 0; i < count; i++) {
+        to[bucket[(from[i].key[axis] >> shift) & ((1 << RADIXBITS) - 1)]++] =
+          from[i];
+      }
+      swap = from;
+      from = to;
+      to = swap;
+    }
   }
-  if (right < median - 1) {
-    /* Recursively shuffle the right subset. */
-    vertexmedian(&sortarray[right + 1], arraysize - right - 1,
-                 median - right - 1, axis);
+  if (from != keys) {
+    memcpy(keys, from, count * sizeof(struct sortvertex));
   }
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  alternateaxes()   Sorts the vertices as appropriate for the divide-and-  */
-/*                    conquer algorithm with alternating cuts.               */
+/*  radixsortthreads()   Sort an array of keyed vertices like radixsort(),   */
+/*                       on up to `threads' threads.                         */
 /*                                                                           */
-/*  Partitions by x-coordinate if axis == 0; by y-coordinate if axis == 1.   */
-/*  For the base case, subsets containing only two or three vertices are     */
-/*  always sorted by x-coordinate.                                           */
+/*  Sorts the two halves at the same time, the left one on a new thread,     */
+/*  then merges them.  A vertex of the left half goes first when the keys    */
+/*  are equal, so the result is the same as radixsort()'s.                   */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void alternateaxes(vertex *sortarray, int arraysize, int axis)
+void radixsortthreads(struct sortvertex *keys, struct sortvertex *scratch,
+                      int count, int threads)
 #else /* not ANSI_DECLARATORS */
-void alternateaxes(sortarray, arraysize, axis)
-vertex *sortarray;
-int arraysize;
-int axis;
+void radixsortthreads(keys, scratch, count, threads)
+struct sortvertex *keys;
+struct sortvertex *scratch;
+int count;
+int threads;
 #endif /* not ANSI_DECLARATORS */
 
 {
+#ifndef NO_THREADS
+  struct sortvertex *left, *right, *leftend, *rightend;
+  std::thread lefthalf;
   int divider;
+  int i;
 
-  divider = arraysize >> 1;
-  if (arraysize <= 3) {
-    /* Recursive base case:  subsets of two or three vertices will be    */
-    /*   handled specially, and should always be sorted by x-coordinate. */
-    axis = 0;
-  }
-  /* Partition with a horizontal or vertical cut. */
-  vertexmedian(sortarray, arraysize, divider, axis);
-  /* Recursively partition the subsets with a cross cut. */
-  if (arraysize - divider >= 2) {
-    if (divider >= 2) {
-      alternateaxes(sortarray, divider, 1 - axis);
+  if ((threads > 1) && (count >= 2 * THREADGRAIN)) {
+    divider = count >> 1;
+    try {
+      lefthalf = std::thread(radixsortthreads, keys, scratch, divider,
+                             threads >> 1);
+    } catch (std::system_error &) {
+      /* No thread to be had. */
+    }
+    if (lefthalf.joinable()) {
+      radixsortthreads(&keys[divider], &scratch[divider], count - divider,
+                       threads - (threads >> 1));
+      lefthalf.join();
+    } else {
+      radixsort(keys, scratch, divider);
+      radixsort(&keys[divider], &scratch[divider], count - divider);
+    }
+    /* Merge the halves into `scratch', and copy them back. */
+    left = keys;
+    leftend = &keys[divider];
+    right = leftend;
+    rightend = &keys[count];
+    i = 0;
+    while ((left < leftend) && (right < rightend)) {
+      if ((right->key[0] < left->key[0]) ||
+          ((right->key[0] == left->key[0]) &&
+           (right->key[1] < left->key[1]))) {
+        scratch[i++] = *right++;
+      } else {
+        scratch[i++] = *left++;
+      }
+    }
+    while (left < leftend) {
+      scratch[i++] = *left++;
     }
-    alternateaxes(&sortarray[divider], arraysize - divider, 1 - axis);
+    while (right < rightend) {
+      scratch[i++] = *right++;
+    }
+    memcpy(keys, scratch, count * sizeof(struct sortvertex));
+    return;
   }
+#endif /* not NO_THREADS */
+  radixsort(keys, scratch, count);
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  mergehulls()   Merge two adjacent Delaunay triangulations into a         */
-/*                 single Delaunay triangulation.                            */
+/*  sortkeysalloc()   Get an array of `count' keyed vertices, and as many    */
+/*                    again for scratch space.                               */
+/*  sortkeysfree()    Give it back.                                          */
 /*                                                                           */
-/*  This is similar to the algorithm given by Guibas and Stolfi, but uses    */
-/*  a triangle-based, rather than edge-based, data structure.                */
+/*  A workspace mesh keeps the array from one triangulation to the next.     */
 /*                                                                           */
-/*  The algorithm walks up the gap between the two triangulations, knitting  */
-/*  them together.  As they are merged, some of their bounding triangles     */
-/*  are converted into real triangles of the triangulation.  The procedure   */
-/*  pulls each hull's bounding triangles apart, then knits them together     */
-/*  like the teeth of two gears.  The Delaunay property determines, at each  */
-/*  step, whether the next "tooth" is a bounding triangle of the left hull   */
-/*  or the right.  When a bounding triangle becomes real, its apex is        */
-/*  changed from NULL to a real vertex.                                      */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+struct sortvertex *sortkeysalloc(struct mesh *m, int count)
+#else /* not ANSI_DECLARATORS */
+struct sortvertex *sortkeysalloc(m, count)
+struct mesh *m;
+int count;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (!m->keeppools) {
+    return (struct sortvertex *)
+      memalloc(&m->memory, 2 * count * (int) sizeof(struct sortvertex));
+  }
+  if (m->sortkeyssize < count) {
+    if (m->sortkeys != (struct sortvertex *) NULL) {
+      memfree(&m->memory, (VOID *) m->sortkeys);
+      m->sortkeys = (struct sortvertex *) NULL;
+      m->sortkeyssize = 0;
+    }
+    m->sortkeys = (struct sortvertex *)
+      memalloc(&m->memory, 2 * count * (int) sizeof(struct sortvertex));
+    m->sortkeyssize = count;
+  }
+  return m->sortkeys;
+}
+
+#ifdef ANSI_DECLARATORS
+void sortkeysfree(struct mesh *m, struct sortvertex *keys)
+#else /* not ANSI_DECLARATORS */
+void sortkeysfree(m, keys)
+struct mesh *m;
+struct sortvertex *keys;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (!m->keeppools) {
+    memfree(&m->memory, (VOID *) keys);
+  }
+}
+
+/*****************************************************************************/
 /*                                                                           */
-/*  Only two new triangles need to be allocated.  These become new bounding  */
-/*  triangles at the top and bottom of the seam.  They are used to connect   */
-/*  the remaining bounding triangles (those that have not been converted     */
-/*  into real triangles) into a single fan.                                  */
+/*  vertexradixsort()   Sort an array of vertices by x-coordinate, using the */
+/*                      y-coordinate as a secondary key.                     */
 /*                                                                           */
-/*  On entry, `farleft' and `innerleft' are bounding triangles of the left   */
-/*  triangulation.  The origin of `farleft' is the leftmost vertex, and      */
-/*  the destination of `innerleft' is the rightmost vertex of the            */
-/*  triangulation.  Similarly, `innerright' and `farright' are bounding      */
-/*  triangles of the right triangulation.  The origin of `innerright' and    */
-/*  destination of `farright' are the leftmost and rightmost vertices.       */
+/*  Gives the same order as vertexsort().  Each vertex is sorted together    */
+/*  with its keys, so the sort reads memory front to back, instead of        */
+/*  following a pointer to the coordinates at every comparison.              */
 /*                                                                           */
-/*  On completion, the origin of `farleft' is the leftmost vertex of the     */
-/*  merged triangulation, and the destination of `farright' is the rightmost */
-/*  vertex.                                                                  */
+/*  Which of two vertices at the same place comes first decides which one    */
+/*  survives as the other is discarded, and vertexsort() leaves that to its  */
+/*  random pivots.  So if the sorted keys have any duplicates, the array is  */
+/*  handed to vertexsort() instead, still in the order it came in.           */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void mergehulls(struct mesh *m, struct behavior *b, struct otri *farleft,
-                struct otri *innerleft, struct otri *innerright,
-                struct otri *farright, int axis)
+void vertexradixsort(struct mesh *m, struct behavior *b, vertex *sortarray,
+                     int arraysize)
 #else /* not ANSI_DECLARATORS */
-void mergehulls(m, b, farleft, innerleft, innerright, farright, axis)
+void vertexradixsort(m, b, sortarray, arraysize)
 struct mesh *m;
 struct behavior *b;
-struct otri *farleft;
-struct otri *innerleft;
-struct otri *innerright;
-struct otri *farright;
-int axis;
+vertex *sortarray;
+int arraysize;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri leftcand, rightcand;
-  struct otri baseedge;
-  struct otri nextedge;
-  struct otri sidecasing, topcasing, outercasing;
-  struct otri checkedge;
-  vertex innerleftdest;
-  vertex innerrightorg;
-  vertex innerleftapex, innerrightapex;
-  vertex farleftpt, farrightpt;
-  vertex farleftapex, farrightapex;
-  vertex lowerleft, lowerright;
-  vertex upperleft, upperright;
-  vertex nextapex;
-  vertex checkvertex;
-  int changemade;
-  int badedge;
-  int leftfinished, rightfinished;
-  triangle ptr;                         /* Temporary variable used by sym(). */
+  struct sortvertex *keys;
+  int i;
 
-  dest(*innerleft, innerleftdest);
-  apex(*innerleft, innerleftapex);
-  org(*innerright, innerrightorg);
-  apex(*innerright, innerrightapex);
-  /* Special treatment for horizontal cuts. */
-  if (b->dwyer && (axis == 1)) {
-    org(*farleft, farleftpt);
-    apex(*farleft, farleftapex);
-    dest(*farright, farrightpt);
-    apex(*farright, farrightapex);
-    /* The pointers to the extremal vertices are shifted to point to the */
-    /*   topmost and bottommost vertex of each hull, rather than the     */
-    /*   leftmost and rightmost vertices.                                */
-    while (farleftapex[1] < farleftpt[1]) {
-      lnextself(*farleft);
-      symself(*farleft);
-      farleftpt = farleftapex;
-      apex(*farleft, farleftapex);
-    }
-    sym(*innerleft, checkedge);
-    apex(checkedge, checkvertex);
-    while (checkvertex[1] > innerleftdest[1]) {
-      lnext(checkedge, *innerleft);
-      innerleftapex = innerleftdest;
-      innerleftdest = checkvertex;
-      sym(*innerleft, checkedge);
-      apex(checkedge, checkvertex);
-    }
-    while (innerrightapex[1] < innerrightorg[1]) {
-      lnextself(*innerright);
-      symself(*innerright);
-      innerrightorg = innerrightapex;
-      apex(*innerright, innerrightapex);
-    }
-    sym(*farright, checkedge);
-    apex(checkedge, checkvertex);
-    while (checkvertex[1] > farrightpt[1]) {
-      lnext(checkedge, *farright);
-      farrightapex = farrightpt;
-      farrightpt = checkvertex;
-      sym(*farright, checkedge);
-      apex(checkedge, checkvertex);
+  keys = sortkeysalloc(m, arraysize);
+  for (i = 0; i < arraysize; i++) {
+    keys[i].key[0] = radixkey(sortarray[i][0]);
+    keys[i].key[1] = radixkey(sortarray[i][1]);
+    keys[i].v = sortarray[i];
+  }
+  radixsortthreads(keys, &keys[arraysize], arraysize, b->threads);
+  for (i = 1; i < arraysize; i++) {
+    if ((keys[i].key[0] == keys[i - 1].key[0]) &&
+        (keys[i].key[1] == keys[i - 1].key[1])) {
+      sortkeysfree(m, keys);
+      vertexsort(m, sortarray, arraysize);
+      return;
     }
   }
-  /* Find a line tangent to and below both hulls. */
-  do {
-    changemade = 0;
-    /* Make innerleftdest the "bottommost" vertex of the left hull. */
-    if (counterclockwise(m, b, innerleftdest, innerleftapex, innerrightorg) >
-        0.0) {
-      lprevself(*innerleft);
-      symself(*innerleft);
-      innerleftdest = innerleftapex;
-      apex(*innerleft, innerleftapex);
-      changemade = 1;
+  for (i = 0; i < arraysize; i++) {
+    sortarray[i] = keys[i].v;
+  }
+  sortkeysfree(m, keys);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  vertexmedian()   An order statistic algorithm, almost.  Shuffles an      */
+/*                   array of vertices so that the first `median' vertices   */
+/*                   occur lexicographically before the remaining vertices.  */
+/*                                                                           */
+/*  Uses the x-coordinate as the primary key if axis == 0; the y-coordinate  */
+/*  if axis == 1.  Very similar to the vertexsort() procedure, but runs in   */
+/*  randomized linear time.                                                  */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void vertexmedian(struct mesh *m, vertex *sortarray, int arraysize, int median,
+                  int axis)
+#else /* not ANSI_DECLARATORS */
+void vertexmedian(m, sortarray, arraysize, median, axis)
+struct mesh *m;
+vertex *sortarray;
+int arraysize;
+int median;
+int axis;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int left, right;
+  int pivot;
+  REAL pivot1, pivot2;
+  vertex temp;
+
+  if (arraysize == 2) {
+    /* Recursive base case. */
+    if ((sortarray[0][axis] > sortarray[1][axis]) ||
+        ((sortarray[0][axis] == sortarray[1][axis]) &&
+         (sortarray[0][1 - axis] > sortarray[1][1 - axis]))) {
+      temp = sortarray[1];
+      sortarray[1] = sortarray[0];
+      sortarray[0] = temp;
     }
-    /* Make innerrightorg the "bottommost" vertex of the right hull. */
-    if (counterclockwise(m, b, innerrightapex, innerrightorg, innerleftdest) >
-        0.0) {
-      lnextself(*innerright);
-      symself(*innerright);
-      innerrightorg = innerrightapex;
-      apex(*innerright, innerrightapex);
-      changemade = 1;
+    return;
+  }
+  /* Choose a random pivot to split the array. */
+  pivot = (int) randomnation(m, (unsigned int) arraysize);
+  pivot1 = sortarray[pivot][axis];
+  pivot2 = sortarray[pivot][1 - axis];
+  /* Split the array. */
+  left = -1;
+  right = arraysize;
+  while (left < right) {
+    /* Search for a vertex whose x-coordinate is too large for the left. */
+    do {
+      left++;
+    } while ((left <= right) && ((sortarray[left][axis] < pivot1) ||
+                                 ((sortarray[left][axis] == pivot1) &&
+                                  (sortarray[left][1 - axis] < pivot2))));
+    /* Search for a vertex whose x-coordinate is too small for the right. */
+    do {
+      right--;
+    } while ((left <= right) && ((sortarray[right][axis] > pivot1) ||
+                                 ((sortarray[right][axis] == pivot1) &&
+                                  (sortarray[right][1 - axis] > pivot2))));
+    if (left < right) {
+      /* Swap the left and right vertices. */
+      temp = sortarray[left];
+      sortarray[left] = sortarray[right];
+      sortarray[right] = temp;
     }
-  } while (changemade);
-  /* Find the two candidates to be the next "gear tooth." */
-  sym(*innerleft, leftcand);
-  sym(*innerright, rightcand);
-  /* Create the bottom new bounding triangle. */
-  maketriangle(m, b, &baseedge);
-  /* Connect it to the bounding boxes of the left and right triangulations. */
-  bond(baseedge, *innerleft);
-  lnextself(baseedge);
-  bond(baseedge, *innerright);
-  lnextself(baseedge);
-  setorg(baseedge, innerrightorg);
-  setdest(baseedge, innerleftdest);
-  /* Apex is intentionally left NULL. */
-  if (b->verbose > 2) {
-    printf("  Creating base bounding ");
-    printtriangle(m, b, &baseedge);
   }
-  /* Fix the extreme triangles if necessary. */
-  org(*farleft, farleftpt);
-  if (innerleftdest == farleftpt) {
-    lnext(baseedge, *farleft);
+  /* Unlike in vertexsort(), at most one of the following */
+  /*   conditionals is true.                             */
+  if (left > median) {
+    /* Recursively shuffle the left subset. */
+    vertexmedian(m, sortarray, left, median, axis);
   }
-  dest(*farright, farrightpt);
-  if (innerrightorg == farrightpt) {
-    lprev(baseedge, *farright);
+  if (right < median - 1) {
+    /* Recursively shuffle the right subset. */
+    vertexmedian(m, &sortarray[right + 1], arraysize - right - 1,
+                    median - right - 1, axis);
   }
-  /* The vertices of the current knitting edge. */
-  lowerleft = innerleftdest;
-  lowerright = innerrightorg;
-  /* The candidate vertices for knitting. */
-  apex(leftcand, upperleft);
-  apex(rightcand, upperright);
-  /* Walk up the gap between the two triangulations, knitting them together. */
-  while (1) {
-    /* Have we reached the top?  (This isn't quite the right question,       */
-    /*   because even though the left triangulation might seem finished now, */
-    /*   moving up on the right triangulation might reveal a new vertex of   */
-    /*   the left triangulation.  And vice-versa.)                           */
-    leftfinished = counterclockwise(m, b, upperleft, lowerleft, lowerright) <=
-                   0.0;
-    rightfinished = counterclockwise(m, b, upperright, lowerleft, lowerright)
-                 <= 0.0;
-    if (leftfinished && rightfinished) {
-      /* Create the top new bounding triangle. */
-      maketriangle(m, b, &nextedge);
-      setorg(nextedge, lowerleft);
-      setdest(nextedge, lowerright);
-      /* Apex is intentionally left NULL. */
-      /* Connect it to the bounding boxes of the two triangulations. */
-      bond(nextedge, baseedge);
-      lnextself(nextedge);
-      bond(nextedge, rightcand);
-      lnextself(nextedge);
-      bond(nextedge, leftcand);
-      if (b->verbose > 2) {
-        printf("  Creating top bounding ");
-        printtriangle(m, b, &nextedge);
-      }
-      /* Special treatment for horizontal cuts. */
-      if (b->dwyer && (axis == 1)) {
-        org(*farleft, farleftpt);
-        apex(*farleft, farleftapex);
-        dest(*farright, farrightpt);
-        apex(*farright, farrightapex);
-        sym(*farleft, checkedge);
-        apex(checkedge, checkvertex);
-        /* The pointers to the extremal vertices are restored to the  */
-        /*   leftmost and rightmost vertices (rather than topmost and */
-        /*   bottommost).                                             */
-        while (checkvertex[0] < farleftpt[0]) {
-          lprev(checkedge, *farleft);
-          farleftapex = farleftpt;
-          farleftpt = checkvertex;
-          sym(*farleft, checkedge);
-          apex(checkedge, checkvertex);
-        }
-        while (farrightapex[0] > farrightpt[0]) {
-          lprevself(*farright);
-          symself(*farright);
-          farrightpt = farrightapex;
-          apex(*farright, farrightapex);
-        }
-      }
-      return;
-    }
-    /* Consider eliminating edges from the left triangulation. */
-    if (!leftfinished) {
-      /* What vertex would be exposed if an edge were deleted? */
-      lprev(leftcand, nextedge);
-      symself(nextedge);
-      apex(nextedge, nextapex);
-      /* If nextapex is NULL, then no vertex would be exposed; the */
-      /*   triangulation would have been eaten right through.      */
-      if (nextapex != (vertex) NULL) {
-        /* Check whether the edge is Delaunay. */
-        badedge = incircle(m, b, lowerleft, lowerright, upperleft, nextapex) >
-                  0.0;
-        while (badedge) {
-          /* Eliminate the edge with an edge flip.  As a result, the    */
-          /*   left triangulation will have one more boundary triangle. */
-          lnextself(nextedge);
-          sym(nextedge, topcasing);
-          lnextself(nextedge);
-          sym(nextedge, sidecasing);
-          bond(nextedge, topcasing);
-          bond(leftcand, sidecasing);
-          lnextself(leftcand);
-          sym(leftcand, outercasing);
-          lprevself(nextedge);
-          bond(nextedge, outercasing);
-          /* Correct the vertices to reflect the edge flip. */
-          setorg(leftcand, lowerleft);
-          setdest(leftcand, NULL);
-          setapex(leftcand, nextapex);
-          setorg(nextedge, NULL);
-          setdest(nextedge, upperleft);
-          setapex(nextedge, nextapex);
-          /* Consider the newly exposed vertex. */
-          upperleft = nextapex;
-          /* What vertex would be exposed if another edge were deleted? */
-          otricopy(sidecasing, nextedge);
-          apex(nextedge, nextapex);
-          if (nextapex != (vertex) NULL) {
-            /* Check whether the edge is Delaunay. */
-            badedge = incircle(m, b, lowerleft, lowerright, upperleft,
-                               nextapex) > 0.0;
-          } else {
-            /* Avoid eating right through the triangulation. */
-            badedge = 0;
-          }
-        }
-      }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  alternateaxes()   Sorts the vertices as appropriate for the divide-and-  */
+/*                    conquer algorithm with alternating cuts.               */
+/*                                                                           */
+/*  Partitions by x-coordinate if axis == 0; by y-coordinate if axis == 1.   */
+/*  For the base case, subsets containing only two or three vertices are     */
+/*  always sorted by x-coordinate.                                           */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void alternateaxes(struct mesh *m, vertex *sortarray, int arraysize, int axis)
+#else /* not ANSI_DECLARATORS */
+void alternateaxes(m, sortarray, arraysize, axis)
+struct mesh *m;
+vertex *sortarray;
+int arraysize;
+int axis;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int divider;
+
+  divider = arraysize >> 1;
+  if (arraysize <= 3) {
+    /* Recursive base case:  subsets of two or three vertices will be    */
+    /*   handled specially, and should always be sorted by x-coordinate. */
+    axis = 0;
+  }
+  /* Partition with a horizontal or vertical cut. */
+  vertexmedian(m, sortarray, arraysize, divider, axis);
+  /* Recursively partition the subsets with a cross cut. */
+  if (arraysize - divider >= 2) {
+    if (divider >= 2) {
+      alternateaxes(m, sortarray, divider, 1 - axis);
     }
-    /* Consider eliminating edges from the right triangulation. */
-    if (!rightfinished) {
-      /* What vertex would be exposed if an edge were deleted? */
-      lnext(rightcand, nextedge);
-      symself(nextedge);
-      apex(nextedge, nextapex);
-      /* If nextapex is NULL, then no vertex would be exposed; the */
-      /*   triangulation would have been eaten right through.      */
-      if (nextapex != (vertex) NULL) {
-        /* Check whether the edge is Delaunay. */
-        badedge = incircle(m, b, lowerleft, lowerright, upperright, nextapex) >
-                  0.0;
-        while (badedge) {
-          /* Eliminate the edge with an edge flip.  As a result, the     */
-          /*   right triangulation will have one more boundary triangle. */
-          lprevself(nextedge);
-          sym(nextedge, topcasing);
-          lprevself(nextedge);
-          sym(nextedge, sidecasing);
-          bond(nextedge, topcasing);
-          bond(rightcand, sidecasing);
-          lprevself(rightcand);
-          sym(rightcand, outercasing);
-          lnextself(nextedge);
-          bond(nextedge, outercasing);
-          /* Correct the vertices to reflect the edge flip. */
-          setorg(rightcand, NULL);
-          setdest(rightcand, lowerright);
-          setapex(rightcand, nextapex);
-          setorg(nextedge, upperright);
-          setdest(nextedge, NULL);
-          setapex(nextedge, nextapex);
-          /* Consider the newly exposed vertex. */
-          upperright = nextapex;
-          /* What vertex would be exposed if another edge were deleted? */
-          otricopy(sidecasing, nextedge);
-          apex(nextedge, nextapex);
-          if (nextapex != (vertex) NULL) {
-            /* Check whether the edge is Delaunay. */
-            badedge = incircle(m, b, lowerleft, lowerright, upperright,
-                               nextapex) > 0.0;
-          } else {
-            /* Avoid eating right through the triangulation. */
-            badedge = 0;
-          }
-        }
+    alternateaxes(m, &sortarray[divider], arraysize - divider, 1 - axis);
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  keyedmedian()   Shuffle an array of keyed vertices so that the first     */
+/*                  `median' vertices occur lexicographically before the     */
+/*                  remaining vertices.                                      */
+/*                                                                           */
+/*  Does what vertexmedian() does, but on the keys of radixkey(), which sit  */
+/*  next to each other in memory.  The pivots come from a random number      */
+/*  generator of its own, so several threads can do this at the same time.   */
+/*  Which vertices end up in each part does not depend on the pivots.        */
+/*                                                                           */
+/*****************************************************************************/
+
+#define keyfirst(sv, axis) (sv).key[axis]
+#define keysecond(sv, axis) (sv).key[1 - (axis)]
+
+#ifdef ANSI_DECLARATORS
+void keyedmedian(struct sortvertex *keys, int arraysize, int median, int axis)
+#else /* not ANSI_DECLARATORS */
+void keyedmedian(keys, arraysize, median, axis)
+struct sortvertex *keys;
+int arraysize;
+int median;
+int axis;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct sortvertex temp;
+  unsigned long long pivot1, pivot2;
+  unsigned long long seed;
+  int left, right;
+
+  seed = (unsigned long long) arraysize;
+  while (arraysize > 2) {
+    /* Choose a random pivot to split the array. */
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    left = (int) ((seed >> 33) % (unsigned long long) arraysize);
+    pivot1 = keyfirst(keys[left], axis);
+    pivot2 = keysecond(keys[left], axis);
+    /* Split the array. */
+    left = -1;
+    right = arraysize;
+    while (left < right) {
+      do {
+        left++;
+      } while ((left <= right) && ((keyfirst(keys[left], axis) < pivot1) ||
+                                   ((keyfirst(keys[left], axis) == pivot1) &&
+                                    (keysecond(keys[left], axis) < pivot2))));
+      do {
+        right--;
+      } while ((left <= right) &&
+               ((keyfirst(keys[right], axis) > pivot1) ||
+                ((keyfirst(keys[right], axis) == pivot1) &&
+                 (keysecond(keys[right], axis) > pivot2))));
+      if (left < right) {
+        temp = keys[left];
+        keys[left] = keys[right];
+        keys[right] = temp;
       }
     }
-    if (leftfinished || (!rightfinished &&
-           (incircle(m, b, upperleft, lowerleft, lowerright, upperright) >
-            0.0))) {
-      /* Knit the triangulations, adding an edge from `lowerleft' */
-      /*   to `upperright'.                                       */
-      bond(baseedge, rightcand);
-      lprev(rightcand, baseedge);
-      setdest(baseedge, lowerleft);
-      lowerright = upperright;
-      sym(baseedge, rightcand);
-      apex(rightcand, upperright);
+    /* Carry on in the subset that holds the median, if either does. */
+    if (left > median) {
+      arraysize = left;
+    } else if (right < median - 1) {
+      keys = &keys[right + 1];
+      arraysize -= right + 1;
+      median -= right + 1;
     } else {
-      /* Knit the triangulations, adding an edge from `upperleft' */
-      /*   to `lowerright'.                                       */
-      bond(baseedge, leftcand);
-      lnext(leftcand, baseedge);
-      setorg(baseedge, lowerright);
-      lowerleft = upperleft;
-      sym(baseedge, leftcand);
-      apex(leftcand, upperleft);
-    }
-    if (b->verbose > 2) {
-      printf("  Connecting ");
-      printtriangle(m, b, &baseedge);
+      return;
     }
   }
+  if ((arraysize == 2) &&
+      ((keyfirst(keys[0], axis) > keyfirst(keys[1], axis)) ||
+       ((keyfirst(keys[0], axis) == keyfirst(keys[1], axis)) &&
+        (keysecond(keys[0], axis) > keysecond(keys[1], axis))))) {
+    temp = keys[1];
+    keys[1] = keys[0];
+    keys[0] = temp;
+  }
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  divconqrecurse()   Recursively form a Delaunay triangulation by the      */
-/*                     divide-and-conquer method.                            */
-/*                                                                           */
-/*  Recursively breaks down the problem into smaller pieces, which are       */
-/*  knitted together by mergehulls().  The base cases (problems of two or    */
-/*  three vertices) are handled specially here.                              */
+/*  keyedalternateaxes()   Sorts an array of keyed vertices as appropriate   */
+/*                         for the divide-and-conquer algorithm with         */
+/*                         alternating cuts, on up to `threads' threads.     */
+/*  keyedcrosscuts()       The same for the two halves of an array that is   */
+/*                         already cut at `divider'.                         */
 /*                                                                           */
-/*  On completion, `farleft' and `farright' are bounding triangles such that */
-/*  the origin of `farleft' is the leftmost vertex (breaking ties by         */
-/*  choosing the highest leftmost vertex), and the destination of            */
-/*  `farright' is the rightmost vertex (breaking ties by choosing the        */
-/*  lowest rightmost vertex).                                                */
+/*  Does what alternateaxes() does, but with keyedmedian().  Halves big      */
+/*  enough (see THREADGRAIN) are cut at the same time, the left one on a new */
+/*  thread.  The result is the same as alternateaxes()'s:  all the cuts      */
+/*  depend only on which vertices are on each side, and subsets of two or    */
+/*  three vertices end up sorted.                                            */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void divconqrecurse(struct mesh *m, struct behavior *b, vertex *sortarray,
-                    int vertices, int axis,
-                    struct otri *farleft, struct otri *farright)
+void keyedcrosscuts(struct sortvertex *keys, int arraysize, int divider,
+                    int axis, int threads);
 #else /* not ANSI_DECLARATORS */
-void divconqrecurse(m, b, sortarray, vertices, axis, farleft, farright)
-struct mesh *m;
-struct behavior *b;
-vertex *sortarray;
-int vertices;
+void keyedcrosscuts();
+#endif /* not ANSI_DECLARATORS */
+
+#ifdef ANSI_DECLARATORS
+void keyedalternateaxes(struct sortvertex *keys, int arraysize, int axis,
+                        int threads)
+#else /* not ANSI_DECLARATORS */
+void keyedalternateaxes(keys, arraysize, axis, threads)
+struct sortvertex *keys;
+int arraysize;
 int axis;
-struct otri *farleft;
-struct otri *farright;
+int threads;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri midtri, tri1, tri2, tri3;
-  struct otri innerleft, innerright;
-  REAL area;
   int divider;
 
-  if (b->verbose > 2) {
-    printf("  Triangulating %d vertices.\n", vertices);
-  }
-  if (vertices == 2) {
-    /* The triangulation of two vertices is an edge.  An edge is */
-    /*   represented by two bounding triangles.                  */
-    maketriangle(m, b, farleft);
-    setorg(*farleft, sortarray[0]);
-    setdest(*farleft, sortarray[1]);
-    /* The apex is intentionally left NULL. */
-    maketriangle(m, b, farright);
-    setorg(*farright, sortarray[1]);
-    setdest(*farright, sortarray[0]);
-    /* The apex is intentionally left NULL. */
-    bond(*farleft, *farright);
-    lprevself(*farleft);
-    lnextself(*farright);
-    bond(*farleft, *farright);
-    lprevself(*farleft);
-    lnextself(*farright);
-    bond(*farleft, *farright);
-    if (b->verbose > 2) {
-      printf("  Creating ");
-      printtriangle(m, b, farleft);
-      printf("  Creating ");
-      printtriangle(m, b, farright);
-    }
-    /* Ensure that the origin of `farleft' is sortarray[0]. */
-    lprev(*farright, *farleft);
-    return;
-  } else if (vertices == 3) {
-    /* The triangulation of three vertices is either a triangle (with */
-    /*   three bounding triangles) or two edges (with four bounding   */
-    /*   triangles).  In either case, four triangles are created.     */
-    maketriangle(m, b, &midtri);
-    maketriangle(m, b, &tri1);
-    maketriangle(m, b, &tri2);
-    maketriangle(m, b, &tri3);
-    area = counterclockwise(m, b, sortarray[0], sortarray[1], sortarray[2]);
-    if (area == 0.0) {
-      /* Three collinear vertices; the triangulation is two edges. */
-      setorg(midtri, sortarray[0]);
-      setdest(midtri, sortarray[1]);
-      setorg(tri1, sortarray[1]);
-      setdest(tri1, sortarray[0]);
-      setorg(tri2, sortarray[2]);
-      setdest(tri2, sortarray[1]);
-      setorg(tri3, sortarray[1]);
-      setdest(tri3, sortarray[2]);
-      /* All apices are intentionally left NULL. */
-      bond(midtri, tri1);
-      bond(tri2, tri3);
-      lnextself(midtri);
-      lprevself(tri1);
-      lnextself(tri2);
-      lprevself(tri3);
-      bond(midtri, tri3);
-      bond(tri1, tri2);
-      lnextself(midtri);
-      lprevself(tri1);
-      lnextself(tri2);
-      lprevself(tri3);
-      bond(midtri, tri1);
-      bond(tri2, tri3);
-      /* Ensure that the origin of `farleft' is sortarray[0]. */
-      otricopy(tri1, *farleft);
-      /* Ensure that the destination of `farright' is sortarray[2]. */
-      otricopy(tri2, *farright);
-    } else {
-      /* The three vertices are not collinear; the triangulation is one */
-      /*   triangle, namely `midtri'.                                   */
-      setorg(midtri, sortarray[0]);
-      setdest(tri1, sortarray[0]);
-      setorg(tri3, sortarray[0]);
-      /* Apices of tri1, tri2, and tri3 are left NULL. */
-      if (area > 0.0) {
-        /* The vertices are in counterclockwise order. */
-        setdest(midtri, sortarray[1]);
-        setorg(tri1, sortarray[1]);
-        setdest(tri2, sortarray[1]);
-        setapex(midtri, sortarray[2]);
-        setorg(tri2, sortarray[2]);
-        setdest(tri3, sortarray[2]);
-      } else {
-        /* The vertices are in clockwise order. */
-        setdest(midtri, sortarray[2]);
-        setorg(tri1, sortarray[2]);
-        setdest(tri2, sortarray[2]);
-        setapex(midtri, sortarray[1]);
-        setorg(tri2, sortarray[1]);
-        setdest(tri3, sortarray[1]);
-      }
-      /* The topology does not depend on how the vertices are ordered. */
-      bond(midtri, tri1);
-      lnextself(midtri);
-      bond(midtri, tri2);
-      lnextself(midtri);
-      bond(midtri, tri3);
-      lprevself(tri1);
-      lnextself(tri2);
-      bond(tri1, tri2);
-      lprevself(tri1);
-      lprevself(tri3);
-      bond(tri1, tri3);
-      lnextself(tri2);
-      lprevself(tri3);
-      bond(tri2, tri3);
-      /* Ensure that the origin of `farleft' is sortarray[0]. */
-      otricopy(tri1, *farleft);
-      /* Ensure that the destination of `farright' is sortarray[2]. */
-      if (area > 0.0) {
-        otricopy(tri2, *farright);
-      } else {
-        lnext(*farleft, *farright);
-      }
-    }
-    if (b->verbose > 2) {
-      printf("  Creating ");
-      printtriangle(m, b, &midtri);
-      printf("  Creating ");
-      printtriangle(m, b, &tri1);
-      printf("  Creating ");
-      printtriangle(m, b, &tri2);
-      printf("  Creating ");
-      printtriangle(m, b, &tri3);
-    }
-    return;
-  } else {
-    /* Split the vertices in half. */
-    divider = vertices >> 1;
-    /* Recursively triangulate each half. */
-    divconqrecurse(m, b, sortarray, divider, 1 - axis, farleft, &innerleft);
-    divconqrecurse(m, b, &sortarray[divider], vertices - divider, 1 - axis,
-                   &innerright, farright);
-    if (b->verbose > 1) {
-      printf("  Joining triangulations with %d and %d vertices.\n", divider,
-             vertices - divider);
-    }
-    /* Merge the two triangulations into one. */
-    mergehulls(m, b, farleft, &innerleft, &innerright, farright, axis);
+  divider = arraysize >> 1;
+  if (arraysize <= 3) {
+    /* Recursive base case:  subsets of two or three vertices will be    */
+    /*   handled specially, and should always be sorted by x-coordinate. */
+    axis = 0;
   }
+  /* Partition with a horizontal or vertical cut. */
+  keyedmedian(keys, arraysize, divider, axis);
+  /* Recursively partition the subsets with a cross cut. */
+  keyedcrosscuts(keys, arraysize, divider, 1 - axis, threads);
 }
 
 #ifdef ANSI_DECLARATORS
-long removeghosts(struct mesh *m, struct behavior *b, struct otri *startghost)
+void keyedcrosscuts(struct sortvertex *keys, int arraysize, int divider,
+                    int axis, int threads)
 #else /* not ANSI_DECLARATORS */
-long removeghosts(m, b, startghost)
-struct mesh *m;
-struct behavior *b;
-struct otri *startghost;
+void keyedcrosscuts(keys, arraysize, divider, axis, threads)
+struct sortvertex *keys;
+int arraysize;
+int divider;
+int axis;
+int threads;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri searchedge;
-  struct otri dissolveedge;
-  struct otri deadtriangle;
-  vertex markorg;
-  long hullsize;
-  triangle ptr;                         /* Temporary variable used by sym(). */
+#ifndef NO_THREADS
+  std::thread left;
+#endif /* not NO_THREADS */
 
-  if (b->verbose) {
-    printf("  Removing ghost triangles.\n");
+  if (arraysize - divider < 2) {
+    return;
   }
-  /* Find an edge on the convex hull to start point location from. */
-  lprev(*startghost, searchedge);
-  symself(searchedge);
-  m->dummytri[0] = encode(searchedge);
-  /* Remove the bounding box and count the convex hull edges. */
-  otricopy(*startghost, dissolveedge);
-  hullsize = 0;
-  do {
-    hullsize++;
-    lnext(dissolveedge, deadtriangle);
-    lprevself(dissolveedge);
-    symself(dissolveedge);
-    /* If no PSLG is involved, set the boundary markers of all the vertices */
-    /*   on the convex hull.  If a PSLG is used, this step is done later.   */
-    if (!b->poly) {
-      /* Watch out for the case where all the input vertices are collinear. */
-      if (dissolveedge.tri != m->dummytri) {
-        org(dissolveedge, markorg);
-        if (vertexmark(markorg) == 0) {
-          setvertexmark(markorg, 1);
-        }
-      }
+#ifndef NO_THREADS
+  if ((threads > 1) && (divider >= THREADGRAIN)) {
+    try {
+      left = std::thread(keyedalternateaxes, keys, divider, axis,
+                         threads >> 1);
+    } catch (std::system_error &) {
+      /* No thread to be had; do both halves on this one. */
+      threads = 1;
+    }
+    if (left.joinable()) {
+      keyedalternateaxes(&keys[divider], arraysize - divider, axis,
+                         threads - (threads >> 1));
+      left.join();
+      return;
     }
-    /* Remove a bounding triangle from a convex hull triangle. */
-    dissolve(dissolveedge);
-    /* Find the next bounding triangle. */
-    sym(deadtriangle, dissolveedge);
-    /* Delete the bounding triangle. */
-    triangledealloc(m, deadtriangle.tri);
-  } while (!otriequal(dissolveedge, *startghost));
-  return hullsize;
+  }
+#endif /* not NO_THREADS */
+  if (divider >= 2) {
+    keyedalternateaxes(keys, divider, axis, threads);
+  }
+  keyedalternateaxes(&keys[divider], arraysize - divider, axis, threads);
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  divconqdelaunay()   Form a Delaunay triangulation by the divide-and-     */
-/*                      conquer method.                                      */
+/*  vertexcuts()   Re-sort an array of vertices, already sorted by           */
+/*                 x-coordinate, to accommodate alternating cuts.            */
 /*                                                                           */
-/*  Sorts the vertices, calls a recursive procedure to triangulate them, and */
-/*  removes the bounding box, setting boundary markers as appropriate.       */
+/*  The same as calling alternateaxes() on both halves, but on keyed         */
+/*  vertices (see keyedalternateaxes()).                                     */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-long divconqdelaunay(struct mesh *m, struct behavior *b)
+void vertexcuts(struct mesh *m, struct behavior *b, vertex *sortarray,
+                int arraysize)
 #else /* not ANSI_DECLARATORS */
-long divconqdelaunay(m, b)
+void vertexcuts(m, b, sortarray, arraysize)
 struct mesh *m;
 struct behavior *b;
+vertex *sortarray;
+int arraysize;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  vertex *sortarray;
-  struct otri hullleft, hullright;
-  int divider;
-  int i, j;
-
-  if (b->verbose) {
-    printf("  Sorting vertices.\n");
-  }
+  struct sortvertex *keys;
+  int i;
 
-  /* Allocate an array of pointers to vertices for sorting. */
-  sortarray = (vertex *) trimalloc(m->invertices * (int) sizeof(vertex));
-  traversalinit(&m->vertices);
-  for (i = 0; i < m->invertices; i++) {
-    sortarray[i] = vertextraverse(m);
-  }
-  /* Sort the vertices. */
-  vertexsort(sortarray, m->invertices);
-  /* Discard duplicate vertices, which can really mess up the algorithm. */
-  i = 0;
-  for (j = 1; j < m->invertices; j++) {
-    if ((sortarray[i][0] == sortarray[j][0])
-        && (sortarray[i][1] == sortarray[j][1])) {
-      if (!b->quiet) {
-        printf(
-"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
-               sortarray[j][0], sortarray[j][1]);
-      }
-      setvertextype(sortarray[j], UNDEADVERTEX);
-      m->undeads++;
-    } else {
-      i++;
-      sortarray[i] = sortarray[j];
-    }
-  }
-  i++;
-  if (b->dwyer) {
-    /* Re-sort the array of vertices to accommodate alternating cuts. */
-    divider = i >> 1;
-    if (i - divider >= 2) {
-      if (divider >= 2) {
-        alternateaxes(sortarray, divider, 1);
-      }
-      alternateaxes(&sortarray[divider], i - divider, 1);
-    }
+  keys = sortkeysalloc(m, arraysize);
+  for (i = 0; i < arraysize; i++) {
+    keys[i].key[0] = radixkey(sortarray[i][0]);
+    keys[i].key[1] = radixkey(sortarray[i][1]);
+    keys[i].v = sortarray[i];
   }
-
-  if (b->verbose) {
-    printf("  Forming triangulation.\n");
+  keyedcrosscuts(keys, arraysize, arraysize >> 1, 1, b->threads);
+  for (i = 0; i < arraysize; i++) {
+    sortarray[i] = keys[i].v;
   }
-
-  /* Form the Delaunay triangulation. */
-  divconqrecurse(m, b, sortarray, i, 0, &hullleft, &hullright);
-  trifree((VOID *) sortarray);
-
-  return removeghosts(m, b, &hullleft);
+  sortkeysfree(m, keys);
 }
 
-/**                                                                         **/
-/**                                                                         **/
-/********* Divide-and-conquer Delaunay triangulation ends here       *********/
-
-/********* Incremental Delaunay triangulation begins here            *********/
-/**                                                                         **/
-/**                                                                         **/
-
 /*****************************************************************************/
 /*                                                                           */
-/*  boundingbox()   Form an "infinite" bounding triangle to insert vertices  */
-/*                  into.                                                    */
+/*  mergehulls()   Merge two adjacent Delaunay triangulations into a         */
+/*                 single Delaunay triangulation.                            */
 /*                                                                           */
-/*  The vertices at "infinity" are assigned finite coordinates, which are    */
-/*  used by the point location routines, but (mostly) ignored by the         */
-/*  Delaunay edge flip routines.                                             */
+/*  This is similar to the algorithm given by Guibas and Stolfi, but uses    */
+/*  a triangle-based, rather than edge-based, data structure.                */
 /*                                                                           */
-/*****************************************************************************/
-
-#ifndef REDUCED
-
-#ifdef ANSI_DECLARATORS
-void boundingbox(struct mesh *m, struct behavior *b)
-#else /* not ANSI_DECLARATORS */
-void boundingbox(m, b)
-struct mesh *m;
-struct behavior *b;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  struct otri inftri;          /* Handle for the triangular bounding box. */
-  REAL width;
-
-  if (b->verbose) {
-    printf("  Creating triangular bounding box.\n");
-  }
-  /* Find the width (or height, whichever is larger) of the triangulation. */
-  width = m->xmax - m->xmin;
-  if (m->ymax - m->ymin > width) {
-    width = m->ymax - m->ymin;
-  }
-  if (width == 0.0) {
-    width = 1.0;
-  }
-  /* Create the vertices of the bounding box. */
-  m->infvertex1 = (vertex) trimalloc(m->vertices.itembytes);
-  m->infvertex2 = (vertex) trimalloc(m->vertices.itembytes);
-  m->infvertex3 = (vertex) trimalloc(m->vertices.itembytes);
-  m->infvertex1[0] = m->xmin - 50.0 * width;
-  m->infvertex1[1] = m->ymin - 40.0 * width;
-  m->infvertex2[0] = m->xmax + 50.0 * width;
-  m->infvertex2[1] = m->ymin - 40.0 * width;
-  m->infvertex3[0] = 0.5 * (m->xmin + m->xmax);
-  m->infvertex3[1] = m->ymax + 60.0 * width;
-
-  /* Create the bounding box. */
-  maketriangle(m, b, &inftri);
-  setorg(inftri, m->infvertex1);
-  setdest(inftri, m->infvertex2);
-  setapex(inftri, m->infvertex3);
-  /* Link dummytri to the bounding box so we can always find an */
-  /*   edge to begin searching (point location) from.           */
-  m->dummytri[0] = (triangle) inftri.tri;
-  if (b->verbose > 2) {
-    printf("  Creating ");
-    printtriangle(m, b, &inftri);
-  }
-}
-
-#endif /* not REDUCED */
-
-/*****************************************************************************/
+/*  The algorithm walks up the gap between the two triangulations, knitting  */
+/*  them together.  As they are merged, some of their bounding triangles     */
+/*  are converted into real triangles of the triangulation.  The procedure   */
+/*  pulls each hull's bounding triangles apart, then knits them together     */
+/*  like the teeth of two gears.  The Delaunay property determines, at each  */
+/*  step, whether the next "tooth" is a bounding triangle of the left hull   */
+/*  or the right.  When a bounding triangle becomes real, its apex is        */
+/*  changed from NULL to a real vertex.                                      */
 /*                                                                           */
-/*  removebox()   Remove the "infinite" bounding triangle, setting boundary  */
-/*                markers as appropriate.                                    */
+/*  Only two new triangles need to be allocated.  These become new bounding  */
+/*  triangles at the top and bottom of the seam.  They are used to connect   */
+/*  the remaining bounding triangles (those that have not been converted     */
+/*  into real triangles) into a single fan.                                  */
 /*                                                                           */
-/*  The triangular bounding box has three boundary triangles (one for each   */
-/*  side of the bounding box), and a bunch of triangles fanning out from     */
-/*  the three bounding box vertices (one triangle for each edge of the       */
-/*  convex hull of the inner mesh).  This routine removes these triangles.   */
+/*  On entry, `farleft' and `innerleft' are bounding triangles of the left   */
+/*  triangulation.  The origin of `farleft' is the leftmost vertex, and      */
+/*  the destination of `innerleft' is the rightmost vertex of the            */
+/*  triangulation.  Similarly, `innerright' and `farright' are bounding      */
+/*  triangles of the right triangulation.  The origin of `innerright' and    */
+/*  destination of `farright' are the leftmost and rightmost vertices.       */
 /*                                                                           */
-/*  Returns the number of edges on the convex hull of the triangulation.     */
+/*  On completion, the origin of `farleft' is the leftmost vertex of the     */
+/*  merged triangulation, and the destination of `farright' is the rightmost */
+/*  vertex.                                                                  */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef REDUCED
-
 #ifdef ANSI_DECLARATORS
-long removebox(struct mesh *m, struct behavior *b)
+void mergehulls(struct mesh *m, struct behavior *b, struct otri *farleft,
+                struct otri *innerleft, struct otri *innerright,
+                struct otri *farright, int axis)
 #else /* not ANSI_DECLARATORS */
-long removebox(m, b)
+void mergehulls(m, b, farleft, innerleft, innerright, farright, axis)
 struct mesh *m;
 struct behavior *b;
+struct otri *farleft;
+struct otri *innerleft;
+struct otri *innerright;
+struct otri *farright;
+int axis;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri deadtriangle;
-  struct otri searchedge;
+  struct otri leftcand, rightcand;
+  struct otri baseedge;
+  struct otri nextedge;
+  struct otri sidecasing, topcasing, outercasing;
   struct otri checkedge;
-  struct otri nextedge, finaledge, dissolveedge;
-  vertex markorg;
-  long hullsize;
+  vertex innerleftdest;
+  vertex innerrightorg;
+  vertex innerleftapex, innerrightapex;
+  vertex farleftpt, farrightpt;
+  vertex farleftapex, farrightapex;
+  vertex lowerleft, lowerright;
+  vertex upperleft, upperright;
+  vertex nextapex;
+  vertex checkvertex;
+  int changemade;
+  int badedge;
+  int leftfinished, rightfinished;
   triangle ptr;                         /* Temporary variable used by sym(). */
 
-  if (b->verbose) {
-    printf("  Removing triangular bounding box.\n");
-  }
-  /* Find a boundary triangle. */
-  nextedge.tri = m->dummytri;
-  nextedge.orient = 0;
-  symself(nextedge);
-  /* Mark a place to stop. */
-  lprev(nextedge, finaledge);
-  lnextself(nextedge);
-  symself(nextedge);
-  /* Find a triangle (on the boundary of the vertex set) that isn't */
-  /*   a bounding box triangle.                                     */
-  lprev(nextedge, searchedge);
-  symself(searchedge);
-  /* Check whether nextedge is another boundary triangle */
-  /*   adjacent to the first one.                        */
-  lnext(nextedge, checkedge);
-  symself(checkedge);
-  if (checkedge.tri == m->dummytri) {
-    /* Go on to the next triangle.  There are only three boundary   */
-    /*   triangles, and this next triangle cannot be the third one, */
-    /*   so it's safe to stop here.                                 */
-    lprevself(searchedge);
-    symself(searchedge);
-  }
-  /* Find a new boundary edge to search from, as the current search */
-  /*   edge lies on a bounding box triangle and will be deleted.    */
-  m->dummytri[0] = encode(searchedge);
-  hullsize = -2l;
-  while (!otriequal(nextedge, finaledge)) {
-    hullsize++;
-    lprev(nextedge, dissolveedge);
-    symself(dissolveedge);
-    /* If not using a PSLG, the vertices should be marked now. */
-    /*   (If using a PSLG, markhull() will do the job.)        */
-    if (!b->poly) {
-      /* Be careful!  One must check for the case where all the input     */
-      /*   vertices are collinear, and thus all the triangles are part of */
-      /*   the bounding box.  Otherwise, the setvertexmark() call below   */
-      /*   will cause a bad pointer reference.                            */
-      if (dissolveedge.tri != m->dummytri) {
-        org(dissolveedge, markorg);
-        if (vertexmark(markorg) == 0) {
-          setvertexmark(markorg, 1);
-        }
-      }
+  dest(*innerleft, innerleftdest);
+  apex(*innerleft, innerleftapex);
+  org(*innerright, innerrightorg);
+  apex(*innerright, innerrightapex);
+  /* Special treatment for horizontal cuts. */
+  if (b->dwyer && (axis == 1)) {
+    org(*farleft, farleftpt);
+    apex(*farleft, farleftapex);
+    dest(*farright, farrightpt);
+    apex(*farright, farrightapex);
+    /* The pointers to the extremal vertices are shifted to point to the */
+    /*   topmost and bottommost vertex of each hull, rather than the     */
+    /*   leftmost and rightmost vertices.                                */
+    while (farleftapex[1] < farleftpt[1]) {
+      lnextself(*farleft);
+      symself(*farleft);
+      farleftpt = farleftapex;
+      apex(*farleft, farleftapex);
     }
-    /* Disconnect the bounding box triangle from the mesh triangle. */
-    dissolve(dissolveedge);
-    lnext(nextedge, deadtriangle);
-    sym(deadtriangle, nextedge);
-    /* Get rid of the bounding box triangle. */
-    triangledealloc(m, deadtriangle.tri);
-    /* Do we need to turn the corner? */
-    if (nextedge.tri == m->dummytri) {
-      /* Turn the corner. */
-      otricopy(dissolveedge, nextedge);
+    sym(*innerleft, checkedge);
+    apex(checkedge, checkvertex);
+    while (checkvertex[1] > innerleftdest[1]) {
+      lnext(checkedge, *innerleft);
+      innerleftapex = innerleftdest;
+      innerleftdest = checkvertex;
+      sym(*innerleft, checkedge);
+      apex(checkedge, checkvertex);
     }
-  }
-  triangledealloc(m, finaledge.tri);
-
-  trifree((VOID *) m->infvertex1);  /* Deallocate the bounding box vertices. */
-  trifree((VOID *) m->infvertex2);
-  trifree((VOID *) m->infvertex3);
-
-  return hullsize;
-}
-
-#endif /* not REDUCED */
-
-/*****************************************************************************/
-/*                                                                           */
-/*  incrementaldelaunay()   Form a Delaunay triangulation by incrementally   */
-/*                          inserting vertices.                              */
-/*                                                                           */
-/*  Returns the number of edges on the convex hull of the triangulation.     */
-/*                                                                           */
-/*****************************************************************************/
-
-#ifndef REDUCED
-
-#ifdef ANSI_DECLARATORS
-long incrementaldelaunay(struct mesh *m, struct behavior *b)
-#else /* not ANSI_DECLARATORS */
-long incrementaldelaunay(m, b)
-struct mesh *m;
-struct behavior *b;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  struct otri starttri;
-  vertex vertexloop;
-
-  /* Create a triangular bounding box. */
-  boundingbox(m, b);
-  if (b->verbose) {
-    printf("  Incrementally inserting vertices.\n");
-  }
-  traversalinit(&m->vertices);
-  vertexloop = vertextraverse(m);
-  while (vertexloop != (vertex) NULL) {
-    starttri.tri = m->dummytri;
-    if (insertvertex(m, b, vertexloop, &starttri, (struct osub *) NULL, 0, 0)
-        == DUPLICATEVERTEX) {
-      if (!b->quiet) {
-        printf(
-"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
-               vertexloop[0], vertexloop[1]);
-      }
-      setvertextype(vertexloop, UNDEADVERTEX);
-      m->undeads++;
+    while (innerrightapex[1] < innerrightorg[1]) {
+      lnextself(*innerright);
+      symself(*innerright);
+      innerrightorg = innerrightapex;
+      apex(*innerright, innerrightapex);
+    }
+    sym(*farright, checkedge);
+    apex(checkedge, checkvertex);
+    while (checkvertex[1] > farrightpt[1]) {
+      lnext(checkedge, *farright);
+      farrightapex = farrightpt;
+      farrightpt = checkvertex;
+      sym(*farright, checkedge);
+      apex(checkedge, checkvertex);
     }
-    vertexloop = vertextraverse(m);
   }
-  /* Remove the bounding box. */
-  return removebox(m, b);
-}
-
-#endif /* not REDUCED */
-
-/**                                                                         **/
-/**                                                                         **/
-/********* Incremental Delaunay triangulation ends here              *********/
-
-/********* Sweepline Delaunay triangulation begins here              *********/
-/**                                                                         **/
+  /* Find a line tangent to and below both hulls. */
+  do {
+    changemade = 0;
+    /* Make innerleftdest the "bottommost" vertex of the left hull. */
+    if (counterclockwise(m, b, innerleftdest, innerleftapex, innerrightorg) >
+        0.0) {
+      lprevself(*innerleft);
+      symself(*innerleft);
+      innerleftdest = innerleftapex;
+      apex(*innerleft, innerleftapex);
+      changemade = 1;
+    }
+    /* Make innerrightorg the "bottommost" vertex of the right hull. */
+    if (counterclockwise(m, b, innerrightapex, innerrightorg, innerleftdest) >
+        0.0) {
+      lnextself(*innerright);
+      symself(*innerright);
+      innerrightorg = innerrightapex;
+      apex(*innerright, innerrightapex);
+      changemade = 1;
+    }
+  } while (changemade);
+  /* Find the two candidates to be the next "gear tooth." */
+  sym(*innerleft, leftcand);
+  sym(*innerright, rightcand);
+  /* Create the bottom new bounding triangle. */
+  maketriangle(m, b, &baseedge);
+  /* Connect it to the bounding boxes of the left and right triangulations. */
+  bond(baseedge, *innerleft);
+  lnextself(baseedge);
+  bond(baseedge, *innerright);
+  lnextself(baseedge);
+  setorg(baseedge, innerrightorg);
+  setdest(baseedge, innerleftdest);
+  /* Apex is intentionally left NULL. */
+  if (b->verbose > 2) {
+    printf("  Creating base bounding ");
+    printtriangle(m, b, &baseedge);
+  }
+  /* Fix the extreme triangles if necessary. */
+  org(*farleft, farleftpt);
+  if (innerleftdest == farleftpt) {
+    lnext(baseedge, *farleft);
+  }
+  dest(*farright, farrightpt);
+  if (innerrightorg == farrightpt) {
+    lprev(baseedge, *farright);
+  }
+  /* The vertices of the current knitting edge. */
+  lowerleft = innerleftdest;
+  lowerright = innerrightorg;
+  /* The candidate vertices for knitting. */
+  apex(leftcand, upperleft);
+  apex(rightcand, upperright);
+  /* Walk up the gap between the two triangulations, knitting them together. */
+  while (1) {
+    /* Have we reached the top?  (This isn't quite the right question,       */
+    /*   because even though the left triangulation might seem finished now, */
+    /*   moving up on the right triangulation might reveal a new vertex of   */
+    /*   the left triangulation.  And vice-versa.)                           */
+    leftfinished = counterclockwise(m, b, upperleft, lowerleft, lowerright) <=
+                   0.0;
+    rightfinished = counterclockwise(m, b, upperright, lowerleft, lowerright)
+                 <= 0.0;
+    if (leftfinished && rightfinished) {
+      /* Create the top new bounding triangle. */
+      maketriangle(m, b, &nextedge);
+      setorg(nextedge, lowerleft);
+      setdest(nextedge, lowerright);
+      /* Apex is intentionally left NULL. */
+      /* Connect it to the bounding boxes of the two triangulations. */
+      bond(nextedge, baseedge);
+      lnextself(nextedge);
+      bond(nextedge, rightcand);
+      lnextself(nextedge);
+      bond(nextedge, leftcand);
+      if (b->verbose > 2) {
+        printf("  Creating top bounding ");
+        printtriangle(m, b, &nextedge);
+      }
+      /* Special treatment for horizontal cuts. */
+      if (b->dwyer && (axis == 1)) {
+        org(*farleft, farleftpt);
+        apex(*farleft, farleftapex);
+        dest(*farright, farrightpt);
+        apex(*farright, farrightapex);
+        sym(*farleft, checkedge);
+        apex(checkedge, checkvertex);
+        /* The pointers to the extremal vertices are restored to the  */
+        /*   leftmost and rightmost vertices (rather than topmost and */
+        /*   bottommost).                                             */
+        while (checkvertex[0] < farleftpt[0]) {
+          lprev(checkedge, *farleft);
+          farleftapex = farleftpt;
+          farleftpt = checkvertex;
+          sym(*farleft, checkedge);
+          apex(checkedge, checkvertex);
+        }
+        while (farrightapex[0] > farrightpt[0]) {
+          lprevself(*farright);
+          symself(*farright);
+          farrightpt = farrightapex;
+          apex(*farright, farrightapex);
+        }
+      }
+      return;
+    }
+    /* Consider eliminating edges from the left triangulation. */
+    if (!leftfinished) {
+      /* What vertex would be exposed if an edge were deleted? */
+      lprev(leftcand, nextedge);
+      symself(nextedge);
+      apex(nextedge, nextapex);
+      /* If nextapex is NULL, then no vertex would be exposed; the */
+      /*   triangulation would have been eaten right through.      */
+      if (nextapex != (vertex) NULL) {
+        /* Check whether the edge is Delaunay. */
+        badedge = incircle(m, b, lowerleft, lowerright, upperleft, nextapex) >
+                  0.0;
+        while (badedge) {
+          /* Eliminate the edge with an edge flip.  As a result, the    */
+          /*   left triangulation will have one more boundary triangle. */
+          lnextself(nextedge);
+          sym(nextedge, topcasing);
+          lnextself(nextedge);
+          sym(nextedge, sidecasing);
+          bond(nextedge, topcasing);
+          bond(leftcand, sidecasing);
+          lnextself(leftcand);
+          sym(leftcand, outercasing);
+          lprevself(nextedge);
+          bond(nextedge, outercasing);
+          /* Correct the vertices to reflect the edge flip. */
+          setorg(leftcand, lowerleft);
+          setdest(leftcand, NULL);
+          setapex(leftcand, nextapex);
+          setorg(nextedge, NULL);
+          setdest(nextedge, upperleft);
+          setapex(nextedge, nextapex);
+          /* Consider the newly exposed vertex. */
+          upperleft = nextapex;
+          /* What vertex would be exposed if another edge were deleted? */
+          otricopy(sidecasing, nextedge);
+          apex(nextedge, nextapex);
+          if (nextapex != (vertex) NULL) {
+            /* Check whether the edge is Delaunay. */
+            badedge = incircle(m, b, lowerleft, lowerright, upperleft,
+                               nextapex) > 0.0;
+          } else {
+            /* Avoid eating right through the triangulation. */
+            badedge = 0;
+          }
+        }
+      }
+    }
+    /* Consider eliminating edges from the right triangulation. */
+    if (!rightfinished) {
+      /* What vertex would be exposed if an edge were deleted? */
+      lnext(rightcand, nextedge);
+      symself(nextedge);
+      apex(nextedge, nextapex);
+      /* If nextapex is NULL, then no vertex would be exposed; the */
+      /*   triangulation would have been eaten right through.      */
+      if (nextapex != (vertex) NULL) {
+        /* Check whether the edge is Delaunay. */
+        badedge = incircle(m, b, lowerleft, lowerright, upperright, nextapex) >
+                  0.0;
+        while (badedge) {
+          /* Eliminate the edge with an edge flip.  As a result, the     */
+          /*   right triangulation will have one more boundary triangle. */
+          lprevself(nextedge);
+          sym(nextedge, topcasing);
+          lprevself(nextedge);
+          sym(nextedge, sidecasing);
+          bond(nextedge, topcasing);
+          bond(rightcand, sidecasing);
+          lprevself(rightcand);
+          sym(rightcand, outercasing);
+          lnextself(nextedge);
+          bond(nextedge, outercasing);
+          /* Correct the vertices to reflect the edge flip. */
+          setorg(rightcand, NULL);
+          setdest(rightcand, lowerright);
+          setapex(rightcand, nextapex);
+          setorg(nextedge, upperright);
+          setdest(nextedge, NULL);
+          setapex(nextedge, nextapex);
+          /* Consider the newly exposed vertex. */
+          upperright = nextapex;
+          /* What vertex would be exposed if another edge were deleted? */
+          otricopy(sidecasing, nextedge);
+          apex(nextedge, nextapex);
+          if (nextapex != (vertex) NULL) {
+            /* Check whether the edge is Delaunay. */
+            badedge = incircle(m, b, lowerleft, lowerright, upperright,
+                               nextapex) > 0.0;
+          } else {
+            /* Avoid eating right through the triangulation. */
+            badedge = 0;
+          }
+        }
+      }
+    }
+    if (leftfinished || (!rightfinished &&
+           (incircle(m, b, upperleft, lowerleft, lowerright, upperright) >
+            0.0))) {
+      /* Knit the triangulations, adding an edge from `lowerleft' */
+      /*   to `upperright'.                                       */
+      bond(baseedge, rightcand);
+      lprev(rightcand, baseedge);
+      setdest(baseedge, lowerleft);
+      lowerright = upperright;
+      sym(baseedge, rightcand);
+      apex(rightcand, upperright);
+    } else {
+      /* Knit the triangulations, adding an edge from `upperleft' */
+      /*   to `lowerright'.                                       */
+      bond(baseedge, leftcand);
+      lnext(leftcand, baseedge);
+      setorg(baseedge, lowerright);
+      lowerleft = upperleft;
+      sym(baseedge, leftcand);
+      apex(leftcand, upperleft);
+    }
+    if (b->verbose > 2) {
+      printf("  Connecting ");
+      printtriangle(m, b, &baseedge);
+    }
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  divconqrecurse()   Recursively form a Delaunay triangulation by the      */
+/*                     divide-and-conquer method.                            */
+/*                                                                           */
+/*  Recursively breaks down the problem into smaller pieces, which are       */
+/*  knitted together by mergehulls().  The base cases (problems of two or    */
+/*  three vertices) are handled specially here.                              */
+/*                                                                           */
+/*  On completion, `farleft' and `farright' are bounding triangles such that */
+/*  the origin of `farleft' is the leftmost vertex (breaking ties by         */
+/*  choosing the highest leftmost vertex), and the destination of            */
+/*  `farright' is the rightmost vertex (breaking ties by choosing the        */
+/*  lowest rightmost vertex).                                                */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void divconqrecurse(struct mesh *m, struct behavior *b, vertex *sortarray,
+                    int vertices, int axis,
+                    struct otri *farleft, struct otri *farright)
+#else /* not ANSI_DECLARATORS */
+void divconqrecurse(m, b, sortarray, vertices, axis, farleft, farright)
+struct mesh *m;
+struct behavior *b;
+vertex *sortarray;
+int vertices;
+int axis;
+struct otri *farleft;
+struct otri *farright;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri midtri, tri1, tri2, tri3;
+  struct otri innerleft, innerright;
+  REAL area;
+  int divider;
+
+  if (b->verbose > 2) {
+    printf("  Triangulating %d vertices.\n", vertices);
+  }
+  if (vertices == 2) {
+    /* The triangulation of two vertices is an edge.  An edge is */
+    /*   represented by two bounding triangles.                  */
+    maketriangle(m, b, farleft);
+    setorg(*farleft, sortarray[0]);
+    setdest(*farleft, sortarray[1]);
+    /* The apex is intentionally left NULL. */
+    maketriangle(m, b, farright);
+    setorg(*farright, sortarray[1]);
+    setdest(*farright, sortarray[0]);
+    /* The apex is intentionally left NULL. */
+    bond(*farleft, *farright);
+    lprevself(*farleft);
+    lnextself(*farright);
+    bond(*farleft, *farright);
+    lprevself(*farleft);
+    lnextself(*farright);
+    bond(*farleft, *farright);
+    if (b->verbose > 2) {
+      printf("  Creating ");
+      printtriangle(m, b, farleft);
+      printf("  Creating ");
+      printtriangle(m, b, farright);
+    }
+    /* Ensure that the origin of `farleft' is sortarray[0]. */
+    lprev(*farright, *farleft);
+    return;
+  } else if (vertices == 3) {
+    /* The triangulation of three vertices is either a triangle (with */
+    /*   three bounding triangles) or two edges (with four bounding   */
+    /*   triangles).  In either case, four triangles are created.     */
+    maketriangle(m, b, &midtri);
+    maketriangle(m, b, &tri1);
+    maketriangle(m, b, &tri2);
+    maketriangle(m, b, &tri3);
+    area = counterclockwise(m, b, sortarray[0], sortarray[1], sortarray[2]);
+    if (area == 0.0) {
+      /* Three collinear vertices; the triangulation is two edges. */
+      setorg(midtri, sortarray[0]);
+      setdest(midtri, sortarray[1]);
+      setorg(tri1, sortarray[1]);
+      setdest(tri1, sortarray[0]);
+      setorg(tri2, sortarray[2]);
+      setdest(tri2, sortarray[1]);
+      setorg(tri3, sortarray[1]);
+      setdest(tri3, sortarray[2]);
+      /* All apices are intentionally left NULL. */
+      bond(midtri, tri1);
+      bond(tri2, tri3);
+      lnextself(midtri);
+      lprevself(tri1);
+      lnextself(tri2);
+      lprevself(tri3);
+      bond(midtri, tri3);
+      bond(tri1, tri2);
+      lnextself(midtri);
+      lprevself(tri1);
+      lnextself(tri2);
+      lprevself(tri3);
+      bond(midtri, tri1);
+      bond(tri2, tri3);
+      /* Ensure that the origin of `farleft' is sortarray[0]. */
+      otricopy(tri1, *farleft);
+      /* Ensure that the destination of `farright' is sortarray[2]. */
+      otricopy(tri2, *farright);
+    } else {
+      /* The three vertices are not collinear; the triangulation is one */
+      /*   triangle, namely `midtri'.                                   */
+      setorg(midtri, sortarray[0]);
+      setdest(tri1, sortarray[0]);
+      setorg(tri3, sortarray[0]);
+      /* Apices of tri1, tri2, and tri3 are left NULL. */
+      if (area > 0.0) {
+        /* The vertices are in counterclockwise order. */
+        setdest(midtri, sortarray[1]);
+        setorg(tri1, sortarray[1]);
+        setdest(tri2, sortarray[1]);
+        setapex(midtri, sortarray[2]);
+        setorg(tri2, sortarray[2]);
+        setdest(tri3, sortarray[2]);
+      } else {
+        /* The vertices are in clockwise order. */
+        setdest(midtri, sortarray[2]);
+        setorg(tri1, sortarray[2]);
+        setdest(tri2, sortarray[2]);
+        setapex(midtri, sortarray[1]);
+        setorg(tri2, sortarray[1]);
+        setdest(tri3, sortarray[1]);
+      }
+      /* The topology does not depend on how the vertices are ordered. */
+      bond(midtri, tri1);
+      lnextself(midtri);
+      bond(midtri, tri2);
+      lnextself(midtri);
+      bond(midtri, tri3);
+      lprevself(tri1);
+      lnextself(tri2);
+      bond(tri1, tri2);
+      lprevself(tri1);
+      lprevself(tri3);
+      bond(tri1, tri3);
+      lnextself(tri2);
+      lprevself(tri3);
+      bond(tri2, tri3);
+      /* Ensure that the origin of `farleft' is sortarray[0]. */
+      otricopy(tri1, *farleft);
+      /* Ensure that the destination of `farright' is sortarray[2]. */
+      if (area > 0.0) {
+        otricopy(tri2, *farright);
+      } else {
+        lnext(*farleft, *farright);
+      }
+    }
+    if (b->verbose > 2) {
+      printf("  Creating ");
+      printtriangle(m, b, &midtri);
+      printf("  Creating ");
+      printtriangle(m, b, &tri1);
+      printf("  Creating ");
+      printtriangle(m, b, &tri2);
+      printf("  Creating ");
+      printtriangle(m, b, &tri3);
+    }
+    return;
+  } else {
+    /* Split the vertices in half. */
+    divider = vertices >> 1;
+    /* Recursively triangulate each half. */
+    divconqrecurse(m, b, sortarray, divider, 1 - axis, farleft, &innerleft);
+    divconqrecurse(m, b, &sortarray[divider], vertices - divider, 1 - axis,
+                   &innerright, farright);
+    if (b->verbose > 1) {
+      printf("  Joining triangulations with %d and %d vertices.\n", divider,
+             vertices - divider);
+    }
+    /* Merge the two triangulations into one. */
+    mergehulls(m, b, farleft, &innerleft, &innerright, farright, axis);
+  }
+}
+
+#ifdef ANSI_DECLARATORS
+long removeghosts(struct mesh *m, struct behavior *b, struct otri *startghost)
+#else /* not ANSI_DECLARATORS */
+long removeghosts(m, b, startghost)
+struct mesh *m;
+struct behavior *b;
+struct otri *startghost;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri searchedge;
+  struct otri dissolveedge;
+  struct otri deadtriangle;
+  vertex markorg;
+  long hullsize;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+
+  if (b->verbose) {
+    printf("  Removing ghost triangles.\n");
+  }
+  /* Find an edge on the convex hull to start point location from. */
+  lprev(*startghost, searchedge);
+  symself(searchedge);
+  m->dummytri[0] = encode(searchedge);
+  /* Remove the bounding box and count the convex hull edges. */
+  otricopy(*startghost, dissolveedge);
+  hullsize = 0;
+  do {
+    hullsize++;
+    lnext(dissolveedge, deadtriangle);
+    lprevself(dissolveedge);
+    symself(dissolveedge);
+    /* If no PSLG is involved, set the boundary markers of all the vertices */
+    /*   on the convex hull.  If a PSLG is used, this step is done later.   */
+    if (!b->poly) {
+      /* Watch out for the case where all the input vertices are collinear. */
+      if (dissolveedge.tri != m->dummytri) {
+        org(dissolveedge, markorg);
+        if (vertexmark(markorg) == 0) {
+          setvertexmark(markorg, 1);
+        }
+      }
+    }
+    /* Remove a bounding triangle from a convex hull triangle. */
+    dissolve(dissolveedge);
+    /* Find the next bounding triangle. */
+    sym(deadtriangle, dissolveedge);
+    /* Delete the bounding triangle. */
+    triangledealloc(m, deadtriangle.tri);
+  } while (!otriequal(dissolveedge, *startghost));
+  return hullsize;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  divconqthreads()   Form a Delaunay triangulation by the divide-and-      */
+/*                     conquer method, on up to `threads' threads.           */
+/*                                                                           */
+/*  Triangulates the two halves of the vertices at the same time, the left   */
+/*  one on a new thread, then knits them together on this one.  Problems     */
+/*  too small to split (see THREADGRAIN) go to divconqrecurse().             */
+/*                                                                           */
+/*  divconqrecurse() never frees a triangle, and makes exactly 2n - 2 of     */
+/*  them (counting the bounding triangles) for n vertices.  So it is known   */
+/*  in advance which items of the triangle pool a single thread would give   */
+/*  each subproblem:  the left half (of k vertices) gets the first 2k - 2,   */
+/*  the right half the ones after those, and mergehulls() the last two.      */
+/*  Each thread allocates from its own copy of the mesh, whose triangle      */
+/*  pool starts at the first item of its subproblem.  The triangles end up   */
+/*  exactly where a single thread would put them, so the result (down to     */
+/*  the numbering of the output) does not depend on the number of threads.   */
+/*  The blocks of the pool must be allocated beforehand (see poolextend()),  */
+/*  and its stack of dead items must be empty.                               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef NO_THREADS
+#ifdef ANSI_DECLARATORS
+void divconqthread(struct mesh *m, struct behavior *b, vertex *sortarray,
+                   int vertices, int axis, int threads,
+                   struct otri *farleft, struct otri *farright,
+                   std::exception_ptr *error);
+#else /* not ANSI_DECLARATORS */
+void divconqthread();
+#endif /* not ANSI_DECLARATORS */
+#endif /* not NO_THREADS */
+
+#ifdef ANSI_DECLARATORS
+void divconqthreads(struct mesh *m, struct behavior *b, vertex *sortarray,
+                    int vertices, int axis, int threads,
+                    struct otri *farleft, struct otri *farright)
+#else /* not ANSI_DECLARATORS */
+void divconqthreads(m, b, sortarray, vertices, axis, threads, farleft,
+                    farright)
+struct mesh *m;
+struct behavior *b;
+vertex *sortarray;
+int vertices;
+int axis;
+int threads;
+struct otri *farleft;
+struct otri *farright;
+#endif /* not ANSI_DECLARATORS */
+
+{
+#ifndef NO_THREADS
+  struct mesh leftmesh;
+  struct otri innerleft, innerright;
+  std::thread left;
+  std::exception_ptr lefterror;
+  int divider;
+
+  if ((threads > 1) && (vertices >= 2 * THREADGRAIN) &&
+      (m->triangles.deaditemstack == (VOID *) NULL)) {
+    divider = vertices >> 1;
+    /* The left half starts where this problem starts, and counts its own */
+    /*   geometric tests.                                                   */
+    leftmesh = *m;
+    leftmesh.incirclecount = 0;
+    leftmesh.counterclockcount = 0;
+    try {
+      left = std::thread(divconqthread, &leftmesh, b, sortarray, divider,
+                         1 - axis, threads >> 1, farleft, &innerleft,
+                         &lefterror);
+    } catch (std::system_error &) {
+      /* No thread to be had. */
+    }
+    if (left.joinable()) {
+      /* The right half starts after the left half's triangles.  If it    */
+      /*   runs out of memory, the left half must finish before the error */
+      /*   goes on up.                                                    */
+      try {
+        poolskip(&m->triangles, 2 * (long) divider - 2);
+        divconqthreads(m, b, &sortarray[divider], vertices - divider,
+                       1 - axis, threads - (threads >> 1), &innerright,
+                       farright);
+      } catch (...) {
+        left.join();
+        throw;
+      }
+      left.join();
+      if (lefterror) {
+        std::rethrow_exception(lefterror);
+      }
+    } else {
+      /* Do the left half on this one, first. */
+      divconqrecurse(&leftmesh, b, sortarray, divider, 1 - axis, farleft,
+                     &innerleft);
+      poolskip(&m->triangles, 2 * (long) divider - 2);
+      divconqrecurse(m, b, &sortarray[divider], vertices - divider,
+                     1 - axis, &innerright, farright);
+    }
+    m->incirclecount += leftmesh.incirclecount;
+    m->counterclockcount += leftmesh.counterclockcount;
+    if (b->verbose > 1) {
+      printf("  Joining triangulations with %d and %d vertices.\n", divider,
+             vertices - divider);
+    }
+    mergehulls(m, b, farleft, &innerleft, &innerright, farright, axis);
+    return;
+  }
+#endif /* not NO_THREADS */
+  divconqrecurse(m, b, sortarray, vertices, axis, farleft, farright);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  divconqthread()   The body of the thread divconqthreads() starts for     */
+/*                    the left half.                                         */
+/*                                                                           */
+/*  An exception may not leave a thread, so whatever the left half throws    */
+/*  (a trierror when memory runs out) is kept in `error', and thrown again   */
+/*  by divconqthreads() once it has joined this thread.                      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef NO_THREADS
+
+#ifdef ANSI_DECLARATORS
+void divconqthread(struct mesh *m, struct behavior *b, vertex *sortarray,
+                   int vertices, int axis, int threads,
+                   struct otri *farleft, struct otri *farright,
+                   std::exception_ptr *error)
+#else /* not ANSI_DECLARATORS */
+void divconqthread(m, b, sortarray, vertices, axis, threads, farleft,
+                   farright, error)
+struct mesh *m;
+struct behavior *b;
+vertex *sortarray;
+int vertices;
+int axis;
+int threads;
+struct otri *farleft;
+struct otri *farright;
+std::exception_ptr *error;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  try {
+    divconqthreads(m, b, sortarray, vertices, axis, threads, farleft,
+                   farright);
+  } catch (...) {
+    *error = std::current_exception();
+  }
+}
+
+#endif /* not NO_THREADS */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  divconqdelaunay()   Form a Delaunay triangulation by the divide-and-     */
+/*                      conquer method.                                      */
+/*                                                                           */
+/*  Sorts the vertices, calls a recursive procedure to triangulate them, and */
+/*  removes the bounding box, setting boundary markers as appropriate.       */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+long divconqdelaunay(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+long divconqdelaunay(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex *sortarray;
+  struct otri hullleft, hullright;
+  int divider;
+  int i, j;
+
+  if (b->verbose) {
+    printf("  Sorting vertices.\n");
+  }
+
+  /* Allocate an array of pointers to vertices for sorting.  A workspace */
+  /*   mesh keeps the array from one triangulation to the next.          */
+  if (m->keeppools) {
+    if (m->sortarraysize < m->invertices) {
+      if (m->sortarray != (vertex *) NULL) {
+        memfree(&m->memory, (VOID *) m->sortarray);
+        m->sortarray = (vertex *) NULL;
+        m->sortarraysize = 0;
+      }
+      m->sortarray = (vertex *) memalloc(&m->memory, m->invertices *
+                                         (int) sizeof(vertex));
+      m->sortarraysize = m->invertices;
+    }
+    sortarray = m->sortarray;
+  } else {
+    sortarray = (vertex *) memalloc(&m->memory,
+                                    m->invertices * (int) sizeof(vertex));
+  }
+  traversalinit(&m->vertices);
+  for (i = 0; i < m->invertices; i++) {
+    sortarray[i] = vertextraverse(m);
+  }
+  /* Sort the vertices.  Huge arrays are quicksorted too, as their radix */
+  /*   sort keys would not fit in memalloc()'s byte count.                */
+  if ((m->invertices >= RADIXMIN) &&
+      (m->invertices <= 0x7fffffff / (2 * (int) sizeof(struct sortvertex)))) {
+    vertexradixsort(m, b, sortarray, m->invertices);
+  } else {
+    vertexsort(m, sortarray, m->invertices);
+  }
+  /* Discard duplicate vertices, which can really mess up the algorithm. */
+  i = 0;
+  for (j = 1; j < m->invertices; j++) {
+    if ((sortarray[i][0] == sortarray[j][0])
+        && (sortarray[i][1] == sortarray[j][1])) {
+      if (!b->quiet) {
+        printf(
+"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
+               sortarray[j][0], sortarray[j][1]);
+      }
+      setvertextype(sortarray[j], UNDEADVERTEX);
+      m->undeads++;
+    } else {
+      i++;
+      sortarray[i] = sortarray[j];
+    }
+  }
+  i++;
+  if (i < 2) {
+    /* divconqrecurse() would never stop splitting a single vertex. */
+    if (!m->keeppools) {
+      memfree(&m->memory, (VOID *) sortarray);
+    }
+    printf("Error:  Input vertices are all identical.\n");
+    triexit(1);
+  }
+  if (b->dwyer && (i >= RADIXMIN) &&
+      (i <= 0x7fffffff / (2 * (int) sizeof(struct sortvertex)))) {
+    /* The same, faster for big arrays. */
+    vertexcuts(m, b, sortarray, i);
+  } else if (b->dwyer) {
+    /* Re-sort the array of vertices to accommodate alternating cuts. */
+    divider = i >> 1;
+    if (i - divider >= 2) {
+      if (divider >= 2) {
+        alternateaxes(m, sortarray, divider, 1);
+      }
+      alternateaxes(m, &sortarray[divider], i - divider, 1);
+    }
+  }
+
+  if (b->verbose) {
+    printf("  Forming triangulation.\n");
+  }
+
+  /* Form the Delaunay triangulation. */
+  if (b->threads > 1) {
+    /* Make room for all of its triangles before any thread starts. */
+    poolextend(&m->triangles, 2 * (long) i - 2);
+  }
+  divconqthreads(m, b, sortarray, i, 0, b->threads, &hullleft, &hullright);
+  if (!m->keeppools) {
+    memfree(&m->memory, (VOID *) sortarray);
+  }
+
+  return removeghosts(m, b, &hullleft);
+}
+
+/**                                                                         **/
+/**                                                                         **/
+/********* Divide-and-conquer Delaunay triangulation ends here       *********/
+
+/********* Incremental Delaunay triangulation begins here            *********/
+/**                                                                         **/
+/**                                                                         **/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  boundingbox()   Form an "infinite" bounding triangle to insert vertices  */
+/*                  into.                                                    */
+/*                                                                           */
+/*  The vertices at "infinity" are assigned finite coordinates, which are    */
+/*  used by the point location routines, but (mostly) ignored by the         */
+/*  Delaunay edge flip routines.                                             */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void boundingbox(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void boundingbox(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri inftri;          /* Handle for the triangular bounding box. */
+  REAL width;
+
+  if (b->verbose) {
+    printf("  Creating triangular bounding box.\n");
+  }
+  /* Find the width (or height, whichever is larger) of the triangulation. */
+  width = m->xmax - m->xmin;
+  if (m->ymax - m->ymin > width) {
+    width = m->ymax - m->ymin;
+  }
+  if (width == 0.0) {
+    width = 1.0;
+  }
+  /* Create the vertices of the bounding box. */
+  m->infvertex1 = (vertex) memalloc(recordmemory(m), m->vertices.itembytes);
+  m->infvertex2 = (vertex) memalloc(recordmemory(m), m->vertices.itembytes);
+  m->infvertex3 = (vertex) memalloc(recordmemory(m), m->vertices.itembytes);
+  m->infvertex1[0] = m->xmin - 50.0 * width;
+  m->infvertex1[1] = m->ymin - 40.0 * width;
+  m->infvertex2[0] = m->xmax + 50.0 * width;
+  m->infvertex2[1] = m->ymin - 40.0 * width;
+  m->infvertex3[0] = 0.5 * (m->xmin + m->xmax);
+  m->infvertex3[1] = m->ymax + 60.0 * width;
+
+  /* Create the bounding box. */
+  maketriangle(m, b, &inftri);
+  setorg(inftri, m->infvertex1);
+  setdest(inftri, m->infvertex2);
+  setapex(inftri, m->infvertex3);
+  /* Link dummytri to the bounding box so we can always find an */
+  /*   edge to begin searching (point location) from.           */
+  m->dummytri[0] = encodetri(inftri.tri);
+  if (b->verbose > 2) {
+    printf("  Creating ");
+    printtriangle(m, b, &inftri);
+  }
+}
+
+#endif /* not REDUCED */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  removebox()   Remove the "infinite" bounding triangle, setting boundary  */
+/*                markers as appropriate.                                    */
+/*                                                                           */
+/*  The triangular bounding box has three boundary triangles (one for each   */
+/*  side of the bounding box), and a bunch of triangles fanning out from     */
+/*  the three bounding box vertices (one triangle for each edge of the       */
+/*  convex hull of the inner mesh).  This routine removes these triangles.   */
+/*                                                                           */
+/*  Returns the number of edges on the convex hull of the triangulation.     */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+long removebox(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+long removebox(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri deadtriangle;
+  struct otri searchedge;
+  struct otri checkedge;
+  struct otri nextedge, finaledge, dissolveedge;
+  vertex markorg;
+  long hullsize;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+
+  if (b->verbose) {
+    printf("  Removing triangular bounding box.\n");
+  }
+  /* Find a boundary triangle. */
+  nextedge.tri = m->dummytri;
+  nextedge.orient = 0;
+  symself(nextedge);
+  /* Mark a place to stop. */
+  lprev(nextedge, finaledge);
+  lnextself(nextedge);
+  symself(nextedge);
+  /* Find a triangle (on the boundary of the vertex set) that isn't */
+  /*   a bounding box triangle.                                     */
+  lprev(nextedge, searchedge);
+  symself(searchedge);
+  /* Check whether nextedge is another boundary triangle */
+  /*   adjacent to the first one.                        */
+  lnext(nextedge, checkedge);
+  symself(checkedge);
+  if (checkedge.tri == m->dummytri) {
+    /* Go on to the next triangle.  There are only three boundary   */
+    /*   triangles, and this next triangle cannot be the third one, */
+    /*   so it's safe to stop here.                                 */
+    lprevself(searchedge);
+    symself(searchedge);
+  }
+  /* Find a new boundary edge to search from, as the current search */
+  /*   edge lies on a bounding box triangle and will be deleted.    */
+  m->dummytri[0] = encode(searchedge);
+  hullsize = -2l;
+  while (!otriequal(nextedge, finaledge)) {
+    hullsize++;
+    lprev(nextedge, dissolveedge);
+    symself(dissolveedge);
+    /* If not using a PSLG, the vertices should be marked now. */
+    /*   (If using a PSLG, markhull() will do the job.)        */
+    if (!b->poly) {
+      /* Be careful!  One must check for the case where all the input     */
+      /*   vertices are collinear, and thus all the triangles are part of */
+      /*   the bounding box.  Otherwise, the setvertexmark() call below   */
+      /*   will cause a bad pointer reference.                            */
+      if (dissolveedge.tri != m->dummytri) {
+        org(dissolveedge, markorg);
+        if (vertexmark(markorg) == 0) {
+          setvertexmark(markorg, 1);
+        }
+      }
+    }
+    /* Disconnect the bounding box triangle from the mesh triangle. */
+    dissolve(dissolveedge);
+    lnext(nextedge, deadtriangle);
+    sym(deadtriangle, nextedge);
+    /* Get rid of the bounding box triangle. */
+    triangledealloc(m, deadtriangle.tri);
+    /* Do we need to turn the corner? */
+    if (nextedge.tri == m->dummytri) {
+      /* Turn the corner. */
+      otricopy(dissolveedge, nextedge);
+    }
+  }
+  triangledealloc(m, finaledge.tri);
+
+  /* Free the bounding box. */
+  memfree(recordmemory(m), (VOID *) m->infvertex1);
+  memfree(recordmemory(m), (VOID *) m->infvertex2);
+  memfree(recordmemory(m), (VOID *) m->infvertex3);
+
+  return hullsize;
+}
+
+#endif /* not REDUCED */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  hilbertkey()   Find how far along a Hilbert curve a cell of the grid is. */
+/*                                                                           */
+/*  `x' and `y' are the cell's coordinates, from 0 to 2^HILBERTBITS - 1.     */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+unsigned long hilbertkey(unsigned long x, unsigned long y)
+#else /* not ANSI_DECLARATORS */
+unsigned long hilbertkey(x, y)
+unsigned long x;
+unsigned long y;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  unsigned long key;
+  unsigned long half;
+  unsigned long last;
+  unsigned long swap;
+  int xbit, ybit;
+
+  key = 0;
+  last = (1ul << HILBERTBITS) - 1;
+  for (half = 1ul << (HILBERTBITS - 1); half > 0; half >>= 1) {
+    xbit = (x & half) != 0;
+    ybit = (y & half) != 0;
+    key += half * half * (unsigned long) ((3 * xbit) ^ ybit);
+    /* Turn the quadrant so that its curve starts and ends where the */
+    /*   curve of the whole grid does.                               */
+    if (!ybit) {
+      if (xbit) {
+        x = last - x;
+        y = last - y;
+      }
+      swap = x;
+      x = y;
+      y = swap;
+    }
+  }
+  return key;
+}
+
+#endif /* not REDUCED */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  brioorder()   Put the vertices in a biased randomized insertion order.   */
+/*                                                                           */
+/*  Each vertex goes into the last round with probability 1/2, else into the */
+/*  one before with probability 1/2, and so on; the first round takes what   */
+/*  is left, and holds about BRIOMINROUND vertices.  Within each round, the  */
+/*  vertices are sorted along a Hilbert curve.  Both go into one sort key.   */
+/*                                                                           */
+/*  Returns the number of vertices in `order'.                               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef REDUCED
+
+struct briovertex {
+  int round;
+  unsigned long key;                       /* Position on the Hilbert curve. */
+  vertex v;
+};
+
+#ifdef ANSI_DECLARATORS
+int briocompare(const VOID *a, const VOID *b)
+#else /* not ANSI_DECLARATORS */
+int briocompare(a, b)
+VOID *a;
+VOID *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  const struct briovertex *va, *vb;
+
+  va = (const struct briovertex *) a;
+  vb = (const struct briovertex *) b;
+  if (va->round != vb->round) {
+    return (va->round < vb->round) ? -1 : 1;
+  }
+  if (va->key != vb->key) {
+    return (va->key < vb->key) ? -1 : 1;
+  }
+  return 0;
+}
+
+#ifdef ANSI_DECLARATORS
+int brioorder(struct mesh *m, struct behavior *b, struct briovertex *order)
+#else /* not ANSI_DECLARATORS */
+int brioorder(m, b, order)
+struct mesh *m;
+struct behavior *b;
+struct briovertex *order;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex vertexloop;
+  REAL scale;
+  int rounds, round;
+  int count;
+
+  /* The grid is square, so that the curve is as close in x as in y. */
+  scale = m->xmax - m->xmin;
+  if (m->ymax - m->ymin > scale) {
+    scale = m->ymax - m->ymin;
+  }
+  scale = (scale > 0.0) ? ((REAL) ((1ul << HILBERTBITS) - 1)) / scale : 0.0;
+
+  rounds = 1;
+  for (count = m->invertices; count > BRIOMINROUND; count /= 2) {
+    rounds++;
+  }
+
+  count = 0;
+  traversalinit(&m->vertices);
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    round = rounds - 1;
+    while ((round > 0) && (randomnation(m, 2) == 0)) {
+      round--;
+    }
+    order[count].round = round;
+    order[count].key =
+      hilbertkey((unsigned long) ((vertexloop[0] - m->xmin) * scale),
+                 (unsigned long) ((vertexloop[1] - m->ymin) * scale));
+    order[count].v = vertexloop;
+    count++;
+    vertexloop = vertextraverse(m);
+  }
+  qsort((VOID *) order, (size_t) count, sizeof(struct briovertex),
+        briocompare);
+  if (b->verbose) {
+    printf("  Ordering %d vertices in %d rounds.\n", count, rounds);
+  }
+  return count;
+}
+
+#endif /* not REDUCED */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  incrementaldelaunay()   Form a Delaunay triangulation by incrementally   */
+/*                          inserting vertices.                              */
+/*                                                                           */
+/*  With the -b switch, vertices are inserted in brioorder(), and locate()   */
+/*  walks to each one from the triangle of the one before it.                */
+/*                                                                           */
+/*  Returns the number of edges on the convex hull of the triangulation.     */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+long incrementaldelaunay(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+long incrementaldelaunay(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri starttri;
+  struct briovertex *order;
+  vertex vertexloop;
+  int count;
+  int i;
+
+  order = (struct briovertex *) NULL;
+  count = 0;
+  if (b->brio) {
+    order = (struct briovertex *)
+            memalloc(&m->memory, m->invertices *
+                                 (int) sizeof(struct briovertex));
+    count = brioorder(m, b, order);
+    /* Each vertex is near the one before, so locate() can walk from it. */
+    m->walklocate = 1;
+  }
+  /* Create a triangular bounding box. */
+  boundingbox(m, b);
+  if (b->verbose) {
+    printf("  Incrementally inserting vertices.\n");
+  }
+  traversalinit(&m->vertices);
+  i = 0;
+  vertexloop = b->brio ? ((count > 0) ? order[0].v : (vertex) NULL) :
+               vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    starttri.tri = m->dummytri;
+    if (insertvertex(m, b, vertexloop, &starttri, (struct osub *) NULL, 0, 0)
+        == DUPLICATEVERTEX) {
+      if (!b->quiet) {
+        printf(
+"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
+               vertexloop[0], vertexloop[1]);
+      }
+      setvertextype(vertexloop, UNDEADVERTEX);
+      m->undeads++;
+    }
+    if (b->brio) {
+      i++;
+      vertexloop = (i < count) ? order[i].v : (vertex) NULL;
+    } else {
+      vertexloop = vertextraverse(m);
+    }
+  }
+  if (b->brio) {
+    memfree(&m->memory, (VOID *) order);
+    m->walklocate = 0;
+  }
+  /* Remove the bounding box. */
+  return removebox(m, b);
+}
+
+#endif /* not REDUCED */
+
+/**                                                                         **/
+/**                                                                         **/
+/********* Incremental Delaunay triangulation ends here              *********/
+
+/********* Sweepline Delaunay triangulation begins here              *********/
+/**                                                                         **/
+/**                                                                         **/
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void eventheapinsert(struct event **heap, int heapsize, struct event *newevent)
+#else /* not ANSI_DECLARATORS */
+void eventheapinsert(heap, heapsize, newevent)
+struct event **heap;
+int heapsize;
+struct event *newevent;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  REAL eventx, eventy;
+  int eventnum;
+  int parent;
+  int notdone;
+
+  eventx = newevent->xkey;
+  eventy = newevent->ykey;
+  eventnum = heapsize;
+  notdone = eventnum > 0;
+  while (notdone) {
+    parent = (eventnum - 1) >> 1;
+    if ((heap[parent]->ykey < eventy) ||
+        ((heap[parent]->ykey == eventy)
+         && (heap[parent]->xkey <= eventx))) {
+      notdone = 0;
+    } else {
+      heap[eventnum] = heap[parent];
+      heap[eventnum]->heapposition = eventnum;
+
+      eventnum = parent;
+      notdone = eventnum > 0;
+    }
+  }
+  heap[eventnum] = newevent;
+  newevent->heapposition = eventnum;
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void eventheapify(struct event **heap, int heapsize, int eventnum)
+#else /* not ANSI_DECLARATORS */
+void eventheapify(heap, heapsize, eventnum)
+struct event **heap;
+int heapsize;
+int eventnum;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct event *thisevent;
+  REAL eventx, eventy;
+  int leftchild, rightchild;
+  int smallest;
+  int notdone;
+
+  thisevent = heap[eventnum];
+  eventx = thisevent->xkey;
+  eventy = thisevent->ykey;
+  leftchild = 2 * eventnum + 1;
+  notdone = leftchild < heapsize;
+  while (notdone) {
+    if ((heap[leftchild]->ykey < eventy) ||
+        ((heap[leftchild]->ykey == eventy)
+         && (heap[leftchild]->xkey < eventx))) {
+      smallest = leftchild;
+    } else {
+      smallest = eventnum;
+    }
+    rightchild = leftchild + 1;
+    if (rightchild < heapsize) {
+      if ((heap[rightchild]->ykey < heap[smallest]->ykey) ||
+          ((heap[rightchild]->ykey == heap[smallest]->ykey)
+           && (heap[rightchild]->xkey < heap[smallest]->xkey))) {
+        smallest = rightchild;
+      }
+    }
+    if (smallest == eventnum) {
+      notdone = 0;
+    } else {
+      heap[eventnum] = heap[smallest];
+      heap[eventnum]->heapposition = eventnum;
+      heap[smallest] = thisevent;
+      thisevent->heapposition = smallest;
+
+      eventnum = smallest;
+      leftchild = 2 * eventnum + 1;
+      notdone = leftchild < heapsize;
+    }
+  }
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void eventheapdelete(struct event **heap, int heapsize, int eventnum)
+#else /* not ANSI_DECLARATORS */
+void eventheapdelete(heap, heapsize, eventnum)
+struct event **heap;
+int heapsize;
+int eventnum;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct event *moveevent;
+  REAL eventx, eventy;
+  int parent;
+  int notdone;
+
+  moveevent = heap[heapsize - 1];
+  if (eventnum > 0) {
+    eventx = moveevent->xkey;
+    eventy = moveevent->ykey;
+    do {
+      parent = (eventnum - 1) >> 1;
+      if ((heap[parent]->ykey < eventy) ||
+          ((heap[parent]->ykey == eventy)
+           && (heap[parent]->xkey <= eventx))) {
+        notdone = 0;
+      } else {
+        heap[eventnum] = heap[parent];
+        heap[eventnum]->heapposition = eventnum;
+
+        eventnum = parent;
+        notdone = eventnum > 0;
+      }
+    } while (notdone);
+  }
+  heap[eventnum] = moveevent;
+  moveevent->heapposition = eventnum;
+  eventheapify(heap, heapsize - 1, eventnum);
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void createeventheap(struct mesh *m, struct event ***eventheap,
+                     struct event **events, struct event **freeevents)
+#else /* not ANSI_DECLARATORS */
+void createeventheap(m, eventheap, events, freeevents)
+struct mesh *m;
+struct event ***eventheap;
+struct event **events;
+struct event **freeevents;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex thisvertex;
+  int maxevents;
+  int i;
+
+  maxevents = (3 * m->invertices) / 2;
+  *eventheap = (struct event **) memalloc(&m->memory, maxevents *
+                                          (int) sizeof(struct event *));
+  /* Triangles point to circle events, so they must be where triangles */
+  /*   can point.                                                     */
+  *events = (struct event *) memalloc(recordmemory(m),
+                                      maxevents * (int) sizeof(struct event));
+  traversalinit(&m->vertices);
+  for (i = 0; i < m->invertices; i++) {
+    thisvertex = vertextraverse(m);
+    (*events)[i].eventptr = (VOID *) thisvertex;
+    (*events)[i].xkey = thisvertex[0];
+    (*events)[i].ykey = thisvertex[1];
+    eventheapinsert(*eventheap, i, *events + i);
+  }
+  *freeevents = (struct event *) NULL;
+  for (i = maxevents - 1; i >= m->invertices; i--) {
+    (*events)[i].eventptr = (VOID *) *freeevents;
+    *freeevents = *events + i;
+  }
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+int rightofhyperbola(struct mesh *m, struct otri *fronttri, vertex newsite)
+#else /* not ANSI_DECLARATORS */
+int rightofhyperbola(m, fronttri, newsite)
+struct mesh *m;
+struct otri *fronttri;
+vertex newsite;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex leftvertex, rightvertex;
+  REAL dxa, dya, dxb, dyb;
+
+  m->hyperbolacount++;
+
+  dest(*fronttri, leftvertex);
+  apex(*fronttri, rightvertex);
+  if ((leftvertex[1] < rightvertex[1]) ||
+      ((leftvertex[1] == rightvertex[1]) &&
+       (leftvertex[0] < rightvertex[0]))) {
+    if (newsite[0] >= rightvertex[0]) {
+      return 1;
+    }
+  } else {
+    if (newsite[0] <= leftvertex[0]) {
+      return 0;
+    }
+  }
+  dxa = leftvertex[0] - newsite[0];
+  dya = leftvertex[1] - newsite[1];
+  dxb = rightvertex[0] - newsite[0];
+  dyb = rightvertex[1] - newsite[1];
+  return dya * (dxb * dxb + dyb * dyb) > dyb * (dxa * dxa + dya * dya);
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+REAL circletop(struct mesh *m, vertex pa, vertex pb, vertex pc, REAL ccwabc)
+#else /* not ANSI_DECLARATORS */
+REAL circletop(m, pa, pb, pc, ccwabc)
+struct mesh *m;
+vertex pa;
+vertex pb;
+vertex pc;
+REAL ccwabc;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  REAL xac, yac, xbc, ybc, xab, yab;
+  REAL aclen2, bclen2, ablen2;
+
+  m->circletopcount++;
+
+  xac = pa[0] - pc[0];
+  yac = pa[1] - pc[1];
+  xbc = pb[0] - pc[0];
+  ybc = pb[1] - pc[1];
+  xab = pa[0] - pb[0];
+  yab = pa[1] - pb[1];
+  aclen2 = xac * xac + yac * yac;
+  bclen2 = xbc * xbc + ybc * ybc;
+  ablen2 = xab * xab + yab * yab;
+  return pc[1] + (xac * bclen2 - xbc * aclen2 + sqrt(aclen2 * bclen2 * ablen2))
+               / (2.0 * ccwabc);
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+void check4deadevent(struct mesh *m, struct otri *checktri,
+                     struct event **freeevents, struct event **eventheap,
+                     int *heapsize)
+#else /* not ANSI_DECLARATORS */
+void check4deadevent(m, checktri, freeevents, eventheap, heapsize)
+struct mesh *m;
+struct otri *checktri;
+struct event **freeevents;
+struct event **eventheap;
+int *heapsize;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct event *deadevent;
+  vertex eventvertex;
+  int eventnum;
+
+  org(*checktri, eventvertex);
+  if (eventvertex != (vertex) NULL) {
+    deadevent = (struct event *) eventvertex;
+    eventnum = deadevent->heapposition;
+    deadevent->eventptr = (VOID *) *freeevents;
+    *freeevents = deadevent;
+    eventheapdelete(eventheap, *heapsize, eventnum);
+    (*heapsize)--;
+    setorg(*checktri, NULL);
+  }
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+struct splaynode *splay(struct mesh *m, struct splaynode *splaytree,
+                        vertex searchpoint, struct otri *searchtri)
+#else /* not ANSI_DECLARATORS */
+struct splaynode *splay(m, splaytree, searchpoint, searchtri)
+struct mesh *m;
+struct splaynode *splaytree;
+vertex searchpoint;
+struct otri *searchtri;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct splaynode *child, *grandchild;
+  struct splaynode *lefttree, *righttree;
+  struct splaynode *leftright;
+  vertex checkvertex;
+  int rightofroot, rightofchild;
+
+  if (splaytree == (struct splaynode *) NULL) {
+    return (struct splaynode *) NULL;
+  }
+  dest(splaytree->keyedge, checkvertex);
+  if (checkvertex == splaytree->keydest) {
+    rightofroot = rightofhyperbola(m, &splaytree->keyedge, searchpoint);
+    if (rightofroot) {
+      otricopy(splaytree->keyedge, *searchtri);
+      child = splaytree->rchild;
+    } else {
+      child = splaytree->lchild;
+    }
+    if (child == (struct splaynode *) NULL) {
+      return splaytree;
+    }
+    dest(child->keyedge, checkvertex);
+    if (checkvertex != child->keydest) {
+      child = splay(m, child, searchpoint, searchtri);
+      if (child == (struct splaynode *) NULL) {
+        if (rightofroot) {
+          splaytree->rchild = (struct splaynode *) NULL;
+        } else {
+          splaytree->lchild = (struct splaynode *) NULL;
+        }
+        return splaytree;
+      }
+    }
+    rightofchild = rightofhyperbola(m, &child->keyedge, searchpoint);
+    if (rightofchild) {
+      otricopy(child->keyedge, *searchtri);
+      grandchild = splay(m, child->rchild, searchpoint, searchtri);
+      child->rchild = grandchild;
+    } else {
+      grandchild = splay(m, child->lchild, searchpoint, searchtri);
+      child->lchild = grandchild;
+    }
+    if (grandchild == (struct splaynode *) NULL) {
+      if (rightofroot) {
+        splaytree->rchild = child->lchild;
+        child->lchild = splaytree;
+      } else {
+        splaytree->lchild = child->rchild;
+        child->rchild = splaytree;
+      }
+      return child;
+    }
+    if (rightofchild) {
+      if (rightofroot) {
+        splaytree->rchild = child->lchild;
+        child->lchild = splaytree;
+      } else {
+        splaytree->lchild = grandchild->rchild;
+        grandchild->rchild = splaytree;
+      }
+      child->rchild = grandchild->lchild;
+      grandchild->lchild = child;
+    } else {
+      if (rightofroot) {
+        splaytree->rchild = grandchild->lchild;
+        grandchild->lchild = splaytree;
+      } else {
+        splaytree->lchild = child->rchild;
+        child->rchild = splaytree;
+      }
+      child->lchild = grandchild->rchild;
+      grandchild->rchild = child;
+    }
+    return grandchild;
+  } else {
+    lefttree = splay(m, splaytree->lchild, searchpoint, searchtri);
+    righttree = splay(m, splaytree->rchild, searchpoint, searchtri);
+
+    pooldealloc(&m->splaynodes, (VOID *) splaytree);
+    if (lefttree == (struct splaynode *) NULL) {
+      return righttree;
+    } else if (righttree == (struct splaynode *) NULL) {
+      return lefttree;
+    } else if (lefttree->rchild == (struct splaynode *) NULL) {
+      lefttree->rchild = righttree->lchild;
+      righttree->lchild = lefttree;
+      return righttree;
+    } else if (righttree->lchild == (struct splaynode *) NULL) {
+      righttree->lchild = lefttree->rchild;
+      lefttree->rchild = righttree;
+      return lefttree;
+    } else {
+/*      printf("Holy Toledo!!!\n"); */
+      leftright = lefttree->rchild;
+      while (leftright->rchild != (struct splaynode *) NULL) {
+        leftright = leftright->rchild;
+      }
+      leftright->rchild = righttree;
+      return lefttree;
+    }
+  }
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+struct splaynode *splayinsert(struct mesh *m, struct splaynode *splayroot,
+                              struct otri *newkey, vertex searchpoint)
+#else /* not ANSI_DECLARATORS */
+struct splaynode *splayinsert(m, splayroot, newkey, searchpoint)
+struct mesh *m;
+struct splaynode *splayroot;
+struct otri *newkey;
+vertex searchpoint;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct splaynode *newsplaynode;
+
+  newsplaynode = (struct splaynode *) poolalloc(&m->splaynodes);
+  otricopy(*newkey, newsplaynode->keyedge);
+  dest(*newkey, newsplaynode->keydest);
+  if (splayroot == (struct splaynode *) NULL) {
+    newsplaynode->lchild = (struct splaynode *) NULL;
+    newsplaynode->rchild = (struct splaynode *) NULL;
+  } else if (rightofhyperbola(m, &splayroot->keyedge, searchpoint)) {
+    newsplaynode->lchild = splayroot;
+    newsplaynode->rchild = splayroot->rchild;
+    splayroot->rchild = (struct splaynode *) NULL;
+  } else {
+    newsplaynode->lchild = splayroot->lchild;
+    newsplaynode->rchild = splayroot;
+    splayroot->lchild = (struct splaynode *) NULL;
+  }
+  return newsplaynode;
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+struct splaynode *circletopinsert(struct mesh *m, struct behavior *b,
+                                  struct splaynode *splayroot,
+                                  struct otri *newkey,
+                                  vertex pa, vertex pb, vertex pc, REAL topy)
+#else /* not ANSI_DECLARATORS */
+struct splaynode *circletopinsert(m, b, splayroot, newkey, pa, pb, pc, topy)
+struct mesh *m;
+struct behavior *b;
+struct splaynode *splayroot;
+struct otri *newkey;
+vertex pa;
+vertex pb;
+vertex pc;
+REAL topy;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  REAL ccwabc;
+  REAL xac, yac, xbc, ybc;
+  REAL aclen2, bclen2;
+  REAL searchpoint[2];
+  struct otri dummytri;
+
+  ccwabc = counterclockwise(m, b, pa, pb, pc);
+  xac = pa[0] - pc[0];
+  yac = pa[1] - pc[1];
+  xbc = pb[0] - pc[0];
+  ybc = pb[1] - pc[1];
+  aclen2 = xac * xac + yac * yac;
+  bclen2 = xbc * xbc + ybc * ybc;
+  searchpoint[0] = pc[0] - (yac * bclen2 - ybc * aclen2) / (2.0 * ccwabc);
+  searchpoint[1] = topy;
+  return splayinsert(m, splay(m, splayroot, (vertex) searchpoint, &dummytri),
+                     newkey, (vertex) searchpoint);
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+struct splaynode *frontlocate(struct mesh *m, struct splaynode *splayroot,
+                              struct otri *bottommost, vertex searchvertex,
+                              struct otri *searchtri, int *farright)
+#else /* not ANSI_DECLARATORS */
+struct splaynode *frontlocate(m, splayroot, bottommost, searchvertex,
+                              searchtri, farright)
+struct mesh *m;
+struct splaynode *splayroot;
+struct otri *bottommost;
+vertex searchvertex;
+struct otri *searchtri;
+int *farright;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int farrightflag;
+  triangle ptr;                       /* Temporary variable used by onext(). */
+
+  otricopy(*bottommost, *searchtri);
+  splayroot = splay(m, splayroot, searchvertex, searchtri);
+
+  farrightflag = 0;
+  while (!farrightflag && rightofhyperbola(m, searchtri, searchvertex)) {
+    onextself(*searchtri);
+    farrightflag = otriequal(*searchtri, *bottommost);
+  }
+  *farright = farrightflag;
+  return splayroot;
+}
+
+#endif /* not REDUCED */
+
+#ifndef REDUCED
+
+#ifdef ANSI_DECLARATORS
+long sweeplinedelaunay(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+long sweeplinedelaunay(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct event **eventheap;
+  struct event *events;
+  struct event *freeevents;
+  struct event *nextevent;
+  struct event *newevent;
+  struct splaynode *splayroot;
+  struct otri bottommost;
+  struct otri searchtri;
+  struct otri fliptri;
+  struct otri lefttri, righttri, farlefttri, farrighttri;
+  struct otri inserttri;
+  vertex firstvertex, secondvertex;
+  vertex nextvertex, lastvertex;
+  vertex connectvertex;
+  vertex leftvertex, midvertex, rightvertex;
+  REAL lefttest, righttest;
+  int heapsize;
+  int check4events, farrightflag;
+  triangle ptr;   /* Temporary variable used by sym(), onext(), and oprev(). */
+
+  poolprepare(m, &m->splaynodes, sizeof(struct splaynode), SPLAYNODEPERBLOCK,
+              SPLAYNODEPERBLOCK, 0);
+  splayroot = (struct splaynode *) NULL;
+
+  if (b->verbose) {
+    printf("  Placing vertices in event heap.\n");
+  }
+  createeventheap(m, &eventheap, &events, &freeevents);
+  heapsize = m->invertices;
+
+  if (b->verbose) {
+    printf("  Forming triangulation.\n");
+  }
+  maketriangle(m, b, &lefttri);
+  maketriangle(m, b, &righttri);
+  bond(lefttri, righttri);
+  lnextself(lefttri);
+  lprevself(righttri);
+  bond(lefttri, righttri);
+  lnextself(lefttri);
+  lprevself(righttri);
+  bond(lefttri, righttri);
+  firstvertex = (vertex) eventheap[0]->eventptr;
+  eventheap[0]->eventptr = (VOID *) freeevents;
+  freeevents = eventheap[0];
+  eventheapdelete(eventheap, heapsize, 0);
+  heapsize--;
+  do {
+    if (heapsize == 0) {
+      printf("Error:  Input vertices are all identical.\n");
+      triexit(1);
+    }
+    secondvertex = (vertex) eventheap[0]->eventptr;
+    eventheap[0]->eventptr = (VOID *) freeevents;
+    freeevents = eventheap[0];
+    eventheapdelete(eventheap, heapsize, 0);
+    heapsize--;
+    if ((firstvertex[0] == secondvertex[0]) &&
+        (firstvertex[1] == secondvertex[1])) {
+      if (!b->quiet) {
+        printf(
+"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
+               secondvertex[0], secondvertex[1]);
+      }
+      setvertextype(secondvertex, UNDEADVERTEX);
+      m->undeads++;
+    }
+  } while ((firstvertex[0] == secondvertex[0]) &&
+           (firstvertex[1] == secondvertex[1]));
+  setorg(lefttri, firstvertex);
+  setdest(lefttri, secondvertex);
+  setorg(righttri, secondvertex);
+  setdest(righttri, firstvertex);
+  lprev(lefttri, bottommost);
+  lastvertex = secondvertex;
+  while (heapsize > 0) {
+    nextevent = eventheap[0];
+    eventheapdelete(eventheap, heapsize, 0);
+    heapsize--;
+    check4events = 1;
+    if (nextevent->xkey < m->xmin) {
+      ptr = (triangle) (unsigned long) nextevent->eventptr;
+      decode(ptr, fliptri);
+      oprev(fliptri, farlefttri);
+      check4deadevent(m, &farlefttri, &freeevents, eventheap, &heapsize);
+      onext(fliptri, farrighttri);
+      check4deadevent(m, &farrighttri, &freeevents, eventheap, &heapsize);
+
+      if (otriequal(farlefttri, bottommost)) {
+        lprev(fliptri, bottommost);
+      }
+      flip(m, b, &fliptri);
+      setapex(fliptri, NULL);
+      lprev(fliptri, lefttri);
+      lnext(fliptri, righttri);
+      sym(lefttri, farlefttri);
+
+      if (randomnation(m, SAMPLERATE) == 0) {
+        symself(fliptri);
+        dest(fliptri, leftvertex);
+        apex(fliptri, midvertex);
+        org(fliptri, rightvertex);
+        splayroot = circletopinsert(m, b, splayroot, &lefttri, leftvertex,
+                                    midvertex, rightvertex, nextevent->ykey);
+      }
+    } else {
+      nextvertex = (vertex) nextevent->eventptr;
+      if ((nextvertex[0] == lastvertex[0]) &&
+          (nextvertex[1] == lastvertex[1])) {
+        if (!b->quiet) {
+          printf(
+"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
+                 nextvertex[0], nextvertex[1]);
+        }
+        setvertextype(nextvertex, UNDEADVERTEX);
+        m->undeads++;
+        check4events = 0;
+      } else {
+        lastvertex = nextvertex;
+
+        splayroot = frontlocate(m, splayroot, &bottommost, nextvertex,
+                                &searchtri, &farrightflag);
+/*
+        otricopy(bottommost, searchtri);
+        farrightflag = 0;
+        while (!farrightflag && rightofhyperbola(m, &searchtri, nextvertex)) {
+          onextself(searchtri);
+          farrightflag = otriequal(searchtri, bottommost);
+        }
+*/
+
+        check4deadevent(m, &searchtri, &freeevents, eventheap, &heapsize);
+
+        otricopy(searchtri, farrighttri);
+        sym(searchtri, farlefttri);
+        maketriangle(m, b, &lefttri);
+        maketriangle(m, b, &righttri);
+        dest(farrighttri, connectvertex);
+        setorg(lefttri, connectvertex);
+        setdest(lefttri, nextvertex);
+        setorg(righttri, nextvertex);
+        setdest(righttri, connectvertex);
+        bond(lefttri, righttri);
+        lnextself(lefttri);
+        lprevself(righttri);
+        bond(lefttri, righttri);
+        lnextself(lefttri);
+        lprevself(righttri);
+        bond(lefttri, farlefttri);
+        bond(righttri, farrighttri);
+        if (!farrightflag && otriequal(farrighttri, bottommost)) {
+          otricopy(lefttri, bottommost);
+        }
+
+        if (randomnation(m, SAMPLERATE) == 0) {
+          splayroot = splayinsert(m, splayroot, &lefttri, nextvertex);
+        } else if (randomnation(m, SAMPLERATE) == 0) {
+          lnext(righttri, inserttri);
+          splayroot = splayinsert(m, splayroot, &inserttri, nextvertex);
+        }
+      }
+    }
+    nextevent->eventptr = (VOID *) freeevents;
+    freeevents = nextevent;
+
+    if (check4events) {
+      apex(farlefttri, leftvertex);
+      dest(lefttri, midvertex);
+      apex(lefttri, rightvertex);
+      lefttest = counterclockwise(m, b, leftvertex, midvertex, rightvertex);
+      if (lefttest > 0.0) {
+        newevent = freeevents;
+        freeevents = (struct event *) freeevents->eventptr;
+        newevent->xkey = m->xminextreme;
+        newevent->ykey = circletop(m, leftvertex, midvertex, rightvertex,
+                                   lefttest);
+        newevent->eventptr = (VOID *) (unsigned long) encode(lefttri);
+        eventheapinsert(eventheap, heapsize, newevent);
+        heapsize++;
+        setorg(lefttri, newevent);
+      }
+      apex(righttri, leftvertex);
+      org(righttri, midvertex);
+      apex(farrighttri, rightvertex);
+      righttest = counterclockwise(m, b, leftvertex, midvertex, rightvertex);
+      if (righttest > 0.0) {
+        newevent = freeevents;
+        freeevents = (struct event *) freeevents->eventptr;
+        newevent->xkey = m->xminextreme;
+        newevent->ykey = circletop(m, leftvertex, midvertex, rightvertex,
+                                   righttest);
+        newevent->eventptr = (VOID *) (unsigned long) encode(farrighttri);
+        eventheapinsert(eventheap, heapsize, newevent);
+        heapsize++;
+        setorg(farrighttri, newevent);
+      }
+    }
+  }
+
+  memfree(recordmemory(m), (VOID *) events);
+  memfree(&m->memory, (VOID *) eventheap);
+  poolrelease(m, &m->splaynodes);
+  lprevself(bottommost);
+  return removeghosts(m, b, &bottommost);
+}
+
+#endif /* not REDUCED */
+
+/**                                                                         **/
+/**                                                                         **/
+/********* Sweepline Delaunay triangulation ends here                *********/
+
+/********* General mesh construction routines begin here             *********/
+/**                                                                         **/
+/**                                                                         **/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  delaunay()   Form a Delaunay triangulation.                              */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+long delaunay(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+long delaunay(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  long hulledges;
+
+  m->eextras = 0;
+  initializetrisubpools(m, b);
+
+#ifdef REDUCED
+  if (!b->quiet) {
+    printf(
+      "Constructing Delaunay triangulation by divide-and-conquer method.\n");
+  }
+  hulledges = divconqdelaunay(m, b);
+#else /* not REDUCED */
+  if (!b->quiet) {
+    printf("Constructing Delaunay triangulation ");
+    if (b->brio) {
+      printf("by incremental method, in BRIO order.\n");
+    } else if (b->incremental) {
+      printf("by incremental method.\n");
+    } else if (b->sweepline) {
+      printf("by sweepline method.\n");
+    } else {
+      printf("by divide-and-conquer method.\n");
+    }
+  }
+  if (b->incremental) {
+    hulledges = incrementaldelaunay(m, b);
+  } else if (b->sweepline) {
+    hulledges = sweeplinedelaunay(m, b);
+  } else {
+    hulledges = divconqdelaunay(m, b);
+  }
+#endif /* not REDUCED */
+
+  if (m->triangles.items == 0) {
+    /* The input vertices were all collinear, so there are no triangles. */
+    return 0l;
+  } else {
+    return hulledges;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  reconstruct()   Reconstruct a triangulation from its .ele (and possibly  */
+/*                  .poly) file.  Used when the -r switch is used.           */
+/*                                                                           */
+/*  Reads an .ele file and reconstructs the original mesh.  If the -p switch */
+/*  is used, this procedure will also read a .poly file and reconstruct the  */
+/*  subsegments of the original mesh.  If the -a switch is used, this        */
+/*  procedure will also read an .area file and set a maximum area constraint */
+/*  on each triangle.                                                        */
+/*                                                                           */
+/*  Vertices that are not corners of triangles, such as nodes on edges of    */
+/*  subparametric elements, are discarded.                                   */
+/*                                                                           */
+/*  This routine finds the adjacencies between triangles (and subsegments)   */
+/*  by forming one stack of triangles for each vertex.  Each triangle is on  */
+/*  three different stacks simultaneously.  Each triangle's subsegment       */
+/*  pointers are used to link the items in each stack.  This memory-saving   */
+/*  feature makes the code harder to read.  The most important thing to keep */
+/*  in mind is that each triangle is removed from a stack precisely when     */
+/*  the corresponding pointer is adjusted to refer to a subsegment rather    */
+/*  than the next triangle of the stack.                                     */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef CDT_ONLY
+
+#ifdef TRILIBRARY
+
+#ifdef ANSI_DECLARATORS
+int reconstruct(struct mesh *m, struct behavior *b, int *trianglelist,
+                REAL *triangleattriblist, REAL *trianglearealist,
+                int elements, int corners, int attribs,
+                int *segmentlist,int *segmentmarkerlist, int numberofsegments)
+#else /* not ANSI_DECLARATORS */
+int reconstruct(m, b, trianglelist, triangleattriblist, trianglearealist,
+                elements, corners, attribs, segmentlist, segmentmarkerlist,
+                numberofsegments)
+struct mesh *m;
+struct behavior *b;
+int *trianglelist;
+REAL *triangleattriblist;
+REAL *trianglearealist;
+int elements;
+int corners;
+int attribs;
+int *segmentlist;
+int *segmentmarkerlist;
+int numberofsegments;
+#endif /* not ANSI_DECLARATORS */
+
+#else /* not TRILIBRARY */
+
+#ifdef ANSI_DECLARATORS
+long reconstruct(struct mesh *m, struct behavior *b, char *elefilename,
+                 char *areafilename, char *polyfilename, FILE *polyfile)
+#else /* not ANSI_DECLARATORS */
+long reconstruct(m, b, elefilename, areafilename, polyfilename, polyfile)
+struct mesh *m;
+struct behavior *b;
+char *elefilename;
+char *areafilename;
+char *polyfilename;
+FILE *polyfile;
+#endif /* not ANSI_DECLARATORS */
+
+#endif /* not TRILIBRARY */
+
+{
+#ifdef TRILIBRARY
+  int vertexindex;
+  int attribindex;
+#else /* not TRILIBRARY */
+  FILE *elefile;
+  FILE *areafile;
+  char inputline[INPUTLINESIZE];
+  char *stringptr;
+  int areaelements;
+#endif /* not TRILIBRARY */
+  struct otri triangleloop;
+  struct otri triangleleft;
+  struct otri checktri;
+  struct otri checkleft;
+  struct otri checkneighbor;
+  struct osub subsegloop;
+  triangle *vertexarray;
+  triangle *prevlink;
+  triangle nexttri;
+  vertex tdest, tapex;
+  vertex checkdest, checkapex;
+  vertex shorg;
+  vertex killvertex;
+  vertex segmentorg, segmentdest;
+  REAL area;
+  int corner[3];
+  int end[2];
+  int killvertexindex;
+  int incorners;
+  int segmentmarkers;
+  int boundmarker;
+  int aroundvertex;
+  long hullsize;
+  int notfound;
+  long elementnumber, segmentnumber;
+  int i, j;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+
+#ifdef TRILIBRARY
+  m->inelements = elements;
+  incorners = corners;
+  if (incorners < 3) {
+    printf("Error:  Triangles must have at least 3 vertices.\n");
+    triexit(1);
+  }
+  m->eextras = attribs;
+#else /* not TRILIBRARY */
+  /* Read the triangles from an .ele file. */
+  if (!b->quiet) {
+    printf("Opening %s.\n", elefilename);
+  }
+  elefile = fopen(elefilename, "r");
+  if (elefile == (FILE *) NULL) {
+    printf("  Error:  Cannot access file %s.\n", elefilename);
+    triexit(1);
+  }
+  /* Read number of triangles, number of vertices per triangle, and */
+  /*   number of triangle attributes from .ele file.                */
+  stringptr = readline(inputline, elefile, elefilename);
+  m->inelements = (int) strtol(stringptr, &stringptr, 0);
+  stringptr = findfield(stringptr);
+  if (*stringptr == '\0') {
+    incorners = 3;
+  } else {
+    incorners = (int) strtol(stringptr, &stringptr, 0);
+    if (incorners < 3) {
+      printf("Error:  Triangles in %s must have at least 3 vertices.\n",
+             elefilename);
+      triexit(1);
+    }
+  }
+  stringptr = findfield(stringptr);
+  if (*stringptr == '\0') {
+    m->eextras = 0;
+  } else {
+    m->eextras = (int) strtol(stringptr, &stringptr, 0);
+  }
+#endif /* not TRILIBRARY */
+
+  initializetrisubpools(m, b);
+
+  /* Create the triangles. */
+  for (elementnumber = 1; elementnumber <= m->inelements; elementnumber++) {
+    maketriangle(m, b, &triangleloop);
+    /* Mark the triangle as living. */
+    triangleloop.tri[3] = encodetri(triangleloop.tri);
+  }
+
+  segmentmarkers = 0;
+  if (b->poly) {
+#ifdef TRILIBRARY
+    m->insegments = numberofsegments;
+    segmentmarkers = segmentmarkerlist != (int *) NULL;
+#else /* not TRILIBRARY */
+    /* Read number of segments and number of segment */
+    /*   boundary markers from .poly file.           */
+    stringptr = readline(inputline, polyfile, b->inpolyfilename);
+    m->insegments = (int) strtol(stringptr, &stringptr, 0);
+    stringptr = findfield(stringptr);
+    if (*stringptr != '\0') {
+      segmentmarkers = (int) strtol(stringptr, &stringptr, 0);
+    }
+#endif /* not TRILIBRARY */
+
+    /* Create the subsegments. */
+    for (segmentnumber = 1; segmentnumber <= m->insegments; segmentnumber++) {
+      makesubseg(m, &subsegloop);
+      /* Mark the subsegment as living. */
+      subsegloop.ss[2] = encodesub(subsegloop.ss);
+    }
+  }
+
+#ifdef TRILIBRARY
+  vertexindex = 0;
+  attribindex = 0;
+#else /* not TRILIBRARY */
+  if (b->vararea) {
+    /* Open an .area file, check for consistency with the .ele file. */
+    if (!b->quiet) {
+      printf("Opening %s.\n", areafilename);
+    }
+    areafile = fopen(areafilename, "r");
+    if (areafile == (FILE *) NULL) {
+      printf("  Error:  Cannot access file %s.\n", areafilename);
+      triexit(1);
+    }
+    stringptr = readline(inputline, areafile, areafilename);
+    areaelements = (int) strtol(stringptr, &stringptr, 0);
+    if (areaelements != m->inelements) {
+      printf("Error:  %s and %s disagree on number of triangles.\n",
+             elefilename, areafilename);
+      triexit(1);
+    }
+  }
+#endif /* not TRILIBRARY */
+
+  if (!b->quiet) {
+    printf("Reconstructing mesh.\n");
+  }
+  /* Allocate a temporary array that maps each vertex to some adjacent */
+  /*   triangle.  I took care to allocate all the permanent memory for */
+  /*   triangles and subsegments first.                                */
+  vertexarray = (triangle *) memalloc(&m->memory, m->vertices.items *
+                                      (int) sizeof(triangle));
+  /* Each vertex is initially unrepresented. */
+  for (i = 0; i < m->vertices.items; i++) {
+    vertexarray[i] = encodetri(m->dummytri);
+  }
+
+  if (b->verbose) {
+    printf("  Assembling triangles.\n");
+  }
+  /* Read the triangles from the .ele file, and link */
+  /*   together those that share an edge.            */
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  elementnumber = b->firstnumber;
+  while (triangleloop.tri != (triangle *) NULL) {
+#ifdef TRILIBRARY
+    /* Copy the triangle's three corners. */
+    for (j = 0; j < 3; j++) {
+      corner[j] = trianglelist[vertexindex++];
+      if ((corner[j] < b->firstnumber) ||
+          (corner[j] >= b->firstnumber + m->invertices)) {
+        printf("Error:  Triangle %ld has an invalid vertex index.\n",
+               elementnumber);
+        triexit(1);
+      }
+    }
+#else /* not TRILIBRARY */
+    /* Read triangle number and the triangle's three corners. */
+    stringptr = readline(inputline, elefile, elefilename);
+    for (j = 0; j < 3; j++) {
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        printf("Error:  Triangle %ld is missing vertex %d in %s.\n",
+               elementnumber, j + 1, elefilename);
+        triexit(1);
+      } else {
+        corner[j] = (int) strtol(stringptr, &stringptr, 0);
+        if ((corner[j] < b->firstnumber) ||
+            (corner[j] >= b->firstnumber + m->invertices)) {
+          printf("Error:  Triangle %ld has an invalid vertex index.\n",
+                 elementnumber);
+          triexit(1);
+        }
+      }
+    }
+#endif /* not TRILIBRARY */
+
+    /* Find out about (and throw away) extra nodes. */
+    for (j = 3; j < incorners; j++) {
+#ifdef TRILIBRARY
+      killvertexindex = trianglelist[vertexindex++];
+#else /* not TRILIBRARY */
+      stringptr = findfield(stringptr);
+      if (*stringptr != '\0') {
+        killvertexindex = (int) strtol(stringptr, &stringptr, 0);
+#endif /* not TRILIBRARY */
+        if ((killvertexindex >= b->firstnumber) &&
+            (killvertexindex < b->firstnumber + m->invertices)) {
+          /* Delete the non-corner vertex if it's not already deleted. */
+          killvertex = getvertex(m, b, killvertexindex);
+          if (vertextype(killvertex) != DEADVERTEX) {
+            vertexdealloc(m, killvertex);
+          }
+        }
+#ifndef TRILIBRARY
+      }
+#endif /* not TRILIBRARY */
+    }
+
+    /* Read the triangle's attributes. */
+    for (j = 0; j < m->eextras; j++) {
+#ifdef TRILIBRARY
+      setelemattribute(triangleloop, j, triangleattriblist[attribindex++]);
+#else /* not TRILIBRARY */
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        setelemattribute(triangleloop, j, 0);
+      } else {
+        setelemattribute(triangleloop, j,
+                         (REAL) strtod(stringptr, &stringptr));
+      }
+#endif /* not TRILIBRARY */
+    }
+
+    if (b->vararea) {
+#ifdef TRILIBRARY
+      area = trianglearealist[elementnumber - b->firstnumber];
+#else /* not TRILIBRARY */
+      /* Read an area constraint from the .area file. */
+      stringptr = readline(inputline, areafile, areafilename);
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        area = -1.0;                      /* No constraint on this triangle. */
+      } else {
+        area = (REAL) strtod(stringptr, &stringptr);
+      }
+#endif /* not TRILIBRARY */
+      setareabound(triangleloop, area);
+    }
+
+    /* Set the triangle's vertices. */
+    triangleloop.orient = 0;
+    setorg(triangleloop, getvertex(m, b, corner[0]));
+    setdest(triangleloop, getvertex(m, b, corner[1]));
+    setapex(triangleloop, getvertex(m, b, corner[2]));
+    /* Try linking the triangle to others that share these vertices. */
+    for (triangleloop.orient = 0; triangleloop.orient < 3;
+         triangleloop.orient++) {
+      /* Take the number for the origin of triangleloop. */
+      aroundvertex = corner[triangleloop.orient];
+      /* Look for other triangles having this vertex. */
+      nexttri = vertexarray[aroundvertex - b->firstnumber];
+      /* Link the current triangle to the next one in the stack. */
+      triangleloop.tri[6 + triangleloop.orient] = nexttri;
+      /* Push the current triangle onto the stack. */
+      vertexarray[aroundvertex - b->firstnumber] = encode(triangleloop);
+      decode(nexttri, checktri);
+      if (checktri.tri != m->dummytri) {
+        dest(triangleloop, tdest);
+        apex(triangleloop, tapex);
+        /* Look for other triangles that share an edge. */
+        do {
+          dest(checktri, checkdest);
+          apex(checktri, checkapex);
+          if (tapex == checkdest) {
+            /* The two triangles share an edge; bond them together. */
+            lprev(triangleloop, triangleleft);
+            bond(triangleleft, checktri);
+          }
+          if (tdest == checkapex) {
+            /* The two triangles share an edge; bond them together. */
+            lprev(checktri, checkleft);
+            bond(triangleloop, checkleft);
+          }
+          /* Find the next triangle in the stack. */
+          nexttri = checktri.tri[6 + checktri.orient];
+          decode(nexttri, checktri);
+        } while (checktri.tri != m->dummytri);
+      }
+    }
+    triangleloop.tri = triangletraverse(m);
+    elementnumber++;
+  }
+
+#ifdef TRILIBRARY
+  vertexindex = 0;
+#else /* not TRILIBRARY */
+  fclose(elefile);
+  if (b->vararea) {
+    fclose(areafile);
+  }
+#endif /* not TRILIBRARY */
+
+  hullsize = 0;                      /* Prepare to count the boundary edges. */
+  if (b->poly) {
+    if (b->verbose) {
+      printf("  Marking segments in triangulation.\n");
+    }
+    /* Read the segments from the .poly file, and link them */
+    /*   to their neighboring triangles.                    */
+    boundmarker = 0;
+    traversalinit(&m->subsegs);
+    subsegloop.ss = subsegtraverse(m);
+    segmentnumber = b->firstnumber;
+    while (subsegloop.ss != (subseg *) NULL) {
+#ifdef TRILIBRARY
+      end[0] = segmentlist[vertexindex++];
+      end[1] = segmentlist[vertexindex++];
+      if (segmentmarkers) {
+        boundmarker = segmentmarkerlist[segmentnumber - b->firstnumber];
+      }
+#else /* not TRILIBRARY */
+      /* Read the endpoints of each segment, and possibly a boundary marker. */
+      stringptr = readline(inputline, polyfile, b->inpolyfilename);
+      /* Skip the first (segment number) field. */
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        printf("Error:  Segment %ld has no endpoints in %s.\n", segmentnumber,
+               polyfilename);
+        triexit(1);
+      } else {
+        end[0] = (int) strtol(stringptr, &stringptr, 0);
+      }
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        printf("Error:  Segment %ld is missing its second endpoint in %s.\n",
+               segmentnumber, polyfilename);
+        triexit(1);
+      } else {
+        end[1] = (int) strtol(stringptr, &stringptr, 0);
+      }
+      if (segmentmarkers) {
+        stringptr = findfield(stringptr);
+        if (*stringptr == '\0') {
+          boundmarker = 0;
+        } else {
+          boundmarker = (int) strtol(stringptr, &stringptr, 0);
+        }
+      }
+#endif /* not TRILIBRARY */
+      for (j = 0; j < 2; j++) {
+        if ((end[j] < b->firstnumber) ||
+            (end[j] >= b->firstnumber + m->invertices)) {
+          printf("Error:  Segment %ld has an invalid vertex index.\n", 
+                 segmentnumber);
+          triexit(1);
+        }
+      }
+
+      /* set the subsegment's vertices. */
+      subsegloop.ssorient = 0;
+      segmentorg = getvertex(m, b, end[0]);
+      segmentdest = getvertex(m, b, end[1]);
+      setsorg(subsegloop, segmentorg);
+      setsdest(subsegloop, segmentdest);
+      setsegorg(subsegloop, segmentorg);
+      setsegdest(subsegloop, segmentdest);
+      setmark(subsegloop, boundmarker);
+      /* Try linking the subsegment to triangles that share these vertices. */
+      for (subsegloop.ssorient = 0; subsegloop.ssorient < 2;
+           subsegloop.ssorient++) {
+        /* Take the number for the destination of subsegloop. */
+        aroundvertex = end[1 - subsegloop.ssorient];
+        /* Look for triangles having this vertex. */
+        prevlink = &vertexarray[aroundvertex - b->firstnumber];
+        nexttri = vertexarray[aroundvertex - b->firstnumber];
+        decode(nexttri, checktri);
+        sorg(subsegloop, shorg);
+        notfound = 1;
+        /* Look for triangles having this edge.  Note that I'm only       */
+        /*   comparing each triangle's destination with the subsegment;   */
+        /*   each triangle's apex is handled through a different vertex.  */
+        /*   Because each triangle appears on three vertices' lists, each */
+        /*   occurrence of a triangle on a list can (and does) represent  */
+        /*   an edge.  In this way, most edges are represented twice, and */
+        /*   every triangle-subsegment bond is represented once.          */
+        while (notfound && (checktri.tri != m->dummytri)) {
+          dest(checktri, checkdest);
+          if (shorg == checkdest) {
+            /* We have a match.  Remove this triangle from the list. */
+            *prevlink = checktri.tri[6 + checktri.orient];
+            /* Bond the subsegment to the triangle. */
+            tsbond(checktri, subsegloop);
+            /* Check if this is a boundary edge. */
+            sym(checktri, checkneighbor);
+            if (checkneighbor.tri == m->dummytri) {
+              /* The next line doesn't insert a subsegment (because there's */
+              /*   already one there), but it sets the boundary markers of  */
+              /*   the existing subsegment and its vertices.                */
+              insertsubseg(m, b, &checktri, 1);
+              hullsize++;
+            }
+            notfound = 0;
+          }
+          /* Find the next triangle in the stack. */
+          prevlink = &checktri.tri[6 + checktri.orient];
+          nexttri = checktri.tri[6 + checktri.orient];
+          decode(nexttri, checktri);
+        }
+      }
+      subsegloop.ss = subsegtraverse(m);
+      segmentnumber++;
+    }
+  }
+
+  /* Mark the remaining edges as not being attached to any subsegment. */
+  /* Also, count the (yet uncounted) boundary edges.                   */
+  for (i = 0; i < m->vertices.items; i++) {
+    /* Search the stack of triangles adjacent to a vertex. */
+    nexttri = vertexarray[i];
+    decode(nexttri, checktri);
+    while (checktri.tri != m->dummytri) {
+      /* Find the next triangle in the stack before this */
+      /*   information gets overwritten.                 */
+      nexttri = checktri.tri[6 + checktri.orient];
+      /* No adjacent subsegment.  (This overwrites the stack info.) */
+      tsdissolve(checktri);
+      sym(checktri, checkneighbor);
+      if (checkneighbor.tri == m->dummytri) {
+        insertsubseg(m, b, &checktri, 1);
+        hullsize++;
+      }
+      decode(nexttri, checktri);
+    }
+  }
+
+  memfree(&m->memory, (VOID *) vertexarray);
+  return hullsize;
+}
+
+#endif /* not CDT_ONLY */
+
 /**                                                                         **/
+/**                                                                         **/
+/********* General mesh construction routines end here               *********/
 
-#ifndef REDUCED
+/********* Segment insertion begins here                             *********/
+/**                                                                         **/
+/**                                                                         **/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  finddirection()   Find the first triangle on the path from one point     */
+/*                    to another.                                            */
+/*                                                                           */
+/*  Finds the triangle that intersects a line segment drawn from the         */
+/*  origin of `searchtri' to the point `searchpoint', and returns the result */
+/*  in `searchtri'.  The origin of `searchtri' does not change, even though  */
+/*  the triangle returned may differ from the one passed in.  This routine   */
+/*  is used to find the direction to move in to get from one point to        */
+/*  another.                                                                 */
+/*                                                                           */
+/*  The return value notes whether the destination or apex of the found      */
+/*  triangle is collinear with the two points in question.                   */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void eventheapinsert(struct event **heap, int heapsize, struct event *newevent)
+enum finddirectionresult finddirection(struct mesh *m, struct behavior *b,
+                                       struct otri *searchtri,
+                                       vertex searchpoint)
 #else /* not ANSI_DECLARATORS */
-void eventheapinsert(heap, heapsize, newevent)
-struct event **heap;
-int heapsize;
-struct event *newevent;
+enum finddirectionresult finddirection(m, b, searchtri, searchpoint)
+struct mesh *m;
+struct behavior *b;
+struct otri *searchtri;
+vertex searchpoint;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  REAL eventx, eventy;
-  int eventnum;
-  int parent;
-  int notdone;
+  struct otri checktri;
+  vertex startvertex;
+  vertex leftvertex, rightvertex;
+  REAL leftccw, rightccw;
+  int leftflag, rightflag;
+  triangle ptr;           /* Temporary variable used by onext() and oprev(). */
 
-  eventx = newevent->xkey;
-  eventy = newevent->ykey;
-  eventnum = heapsize;
-  notdone = eventnum > 0;
-  while (notdone) {
-    parent = (eventnum - 1) >> 1;
-    if ((heap[parent]->ykey < eventy) ||
-        ((heap[parent]->ykey == eventy)
-         && (heap[parent]->xkey <= eventx))) {
-      notdone = 0;
+  org(*searchtri, startvertex);
+  dest(*searchtri, rightvertex);
+  apex(*searchtri, leftvertex);
+  /* Is `searchpoint' to the left? */
+  leftccw = counterclockwise(m, b, searchpoint, startvertex, leftvertex);
+  leftflag = leftccw > 0.0;
+  /* Is `searchpoint' to the right? */
+  rightccw = counterclockwise(m, b, startvertex, searchpoint, rightvertex);
+  rightflag = rightccw > 0.0;
+  if (leftflag && rightflag) {
+    /* `searchtri' faces directly away from `searchpoint'.  We could go left */
+    /*   or right.  Ask whether it's a triangle or a boundary on the left.   */
+    onext(*searchtri, checktri);
+    if (checktri.tri == m->dummytri) {
+      leftflag = 0;
     } else {
-      heap[eventnum] = heap[parent];
-      heap[eventnum]->heapposition = eventnum;
-
-      eventnum = parent;
-      notdone = eventnum > 0;
+      rightflag = 0;
+    }
+  }
+  while (leftflag) {
+    /* Turn left until satisfied. */
+    onextself(*searchtri);
+    if (searchtri->tri == m->dummytri) {
+      printf("Internal error in finddirection():  Unable to find a\n");
+      printf("  triangle leading from (%.12g, %.12g) to", startvertex[0],
+             startvertex[1]);
+      printf("  (%.12g, %.12g).\n", searchpoint[0], searchpoint[1]);
+      internalerror();
+    }
+    apex(*searchtri, leftvertex);
+    rightccw = leftccw;
+    leftccw = counterclockwise(m, b, searchpoint, startvertex, leftvertex);
+    leftflag = leftccw > 0.0;
+  }
+  while (rightflag) {
+    /* Turn right until satisfied. */
+    oprevself(*searchtri);
+    if (searchtri->tri == m->dummytri) {
+      printf("Internal error in finddirection():  Unable to find a\n");
+      printf("  triangle leading from (%.12g, %.12g) to", startvertex[0],
+             startvertex[1]);
+      printf("  (%.12g, %.12g).\n", searchpoint[0], searchpoint[1]);
+      internalerror();
     }
+    dest(*searchtri, rightvertex);
+    leftccw = rightccw;
+    rightccw = counterclockwise(m, b, startvertex, searchpoint, rightvertex);
+    rightflag = rightccw > 0.0;
+  }
+  if (leftccw == 0.0) {
+    return LEFTCOLLINEAR;
+  } else if (rightccw == 0.0) {
+    return RIGHTCOLLINEAR;
+  } else {
+    return WITHIN;
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  segmentintersection()   Find the intersection of an existing segment     */
+/*                          and a segment that is being inserted.  Insert    */
+/*                          a vertex at the intersection, splitting an       */
+/*                          existing subsegment.                             */
+/*                                                                           */
+/*  The segment being inserted connects the apex of splittri to endpoint2.   */
+/*  splitsubseg is the subsegment being split, and MUST adjoin splittri.     */
+/*  Hence, endpoints of the subsegment being split are the origin and        */
+/*  destination of splittri.                                                 */
+/*                                                                           */
+/*  On completion, splittri is a handle having the newly inserted            */
+/*  intersection point as its origin, and endpoint1 as its destination.      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void segmentintersection(struct mesh *m, struct behavior *b,
+                         struct otri *splittri, struct osub *splitsubseg,
+                         vertex endpoint2)
+#else /* not ANSI_DECLARATORS */
+void segmentintersection(m, b, splittri, splitsubseg, endpoint2)
+struct mesh *m;
+struct behavior *b;
+struct otri *splittri;
+struct osub *splitsubseg;
+vertex endpoint2;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct osub opposubseg;
+  vertex endpoint1;
+  vertex torg, tdest;
+  vertex leftvertex, rightvertex;
+  vertex newvertex;
+  enum insertvertexresult success;
+  enum finddirectionresult collinear;
+  REAL ex, ey;
+  REAL tx, ty;
+  REAL etx, ety;
+  REAL split, denom;
+  int i;
+  triangle ptr;                       /* Temporary variable used by onext(). */
+  subseg sptr;                        /* Temporary variable used by snext(). */
+
+  /* Find the other three segment endpoints. */
+  apex(*splittri, endpoint1);
+  org(*splittri, torg);
+  dest(*splittri, tdest);
+  /* Segment intersection formulae; see the Antonio reference. */
+  tx = tdest[0] - torg[0];
+  ty = tdest[1] - torg[1];
+  ex = endpoint2[0] - endpoint1[0];
+  ey = endpoint2[1] - endpoint1[1];
+  etx = torg[0] - endpoint2[0];
+  ety = torg[1] - endpoint2[1];
+  denom = ty * ex - tx * ey;
+  if (denom == 0.0) {
+    printf("Internal error in segmentintersection():");
+    printf("  Attempt to find intersection of parallel segments.\n");
+    internalerror();
+  }
+  split = (ey * etx - ex * ety) / denom;
+  /* Create the new vertex. */
+  newvertex = (vertex) poolalloc(&m->vertices);
+  /* Interpolate its coordinate and attributes. */
+  for (i = 0; i < 2 + m->nextras; i++) {
+    newvertex[i] = torg[i] + split * (tdest[i] - torg[i]);
+  }
+  setvertexmark(newvertex, mark(*splitsubseg));
+  setvertextype(newvertex, INPUTVERTEX);
+  if (b->verbose > 1) {
+    printf(
+  "  Splitting subsegment (%.12g, %.12g) (%.12g, %.12g) at (%.12g, %.12g).\n",
+           torg[0], torg[1], tdest[0], tdest[1], newvertex[0], newvertex[1]);
+  }
+  /* Insert the intersection vertex.  This should always succeed. */
+  success = insertvertex(m, b, newvertex, splittri, splitsubseg, 0, 0);
+  if (success != SUCCESSFULVERTEX) {
+    printf("Internal error in segmentintersection():\n");
+    printf("  Failure to split a segment.\n");
+    internalerror();
+  }
+  /* Record a triangle whose origin is the new vertex. */
+  setvertex2tri(newvertex, encode(*splittri));
+  if (m->steinerleft > 0) {
+    m->steinerleft--;
+  }
+
+  /* Divide the segment into two, and correct the segment endpoints. */
+  ssymself(*splitsubseg);
+  spivot(*splitsubseg, opposubseg);
+  sdissolve(*splitsubseg);
+  sdissolve(opposubseg);
+  do {
+    setsegorg(*splitsubseg, newvertex);
+    snextself(*splitsubseg);
+  } while (splitsubseg->ss != m->dummysub);
+  do {
+    setsegorg(opposubseg, newvertex);
+    snextself(opposubseg);
+  } while (opposubseg.ss != m->dummysub);
+
+  /* Inserting the vertex may have caused edge flips.  We wish to rediscover */
+  /*   the edge connecting endpoint1 to the new intersection vertex.         */
+  collinear = finddirection(m, b, splittri, endpoint1);
+  dest(*splittri, rightvertex);
+  apex(*splittri, leftvertex);
+  if ((leftvertex[0] == endpoint1[0]) && (leftvertex[1] == endpoint1[1])) {
+    onextself(*splittri);
+  } else if ((rightvertex[0] != endpoint1[0]) ||
+             (rightvertex[1] != endpoint1[1])) {
+    printf("Internal error in segmentintersection():\n");
+    printf("  Topological inconsistency after splitting a segment.\n");
+    internalerror();
   }
-  heap[eventnum] = newevent;
-  newevent->heapposition = eventnum;
+  /* `splittri' should have destination endpoint1. */
 }
 
-#endif /* not REDUCED */
-
-#ifndef REDUCED
+/*****************************************************************************/
+/*                                                                           */
+/*  scoutsegment()   Scout the first triangle on the path from one endpoint  */
+/*                   to another, and check for completion (reaching the      */
+/*                   second endpoint), a collinear vertex, or the            */
+/*                   intersection of two segments.                           */
+/*                                                                           */
+/*  Returns one if the entire segment is successfully inserted, and zero if  */
+/*  the job must be finished by conformingedge() or constrainededge().       */
+/*                                                                           */
+/*  If the first triangle on the path has the second endpoint as its         */
+/*  destination or apex, a subsegment is inserted and the job is done.       */
+/*                                                                           */
+/*  If the first triangle on the path has a destination or apex that lies on */
+/*  the segment, a subsegment is inserted connecting the first endpoint to   */
+/*  the collinear vertex, and the search is continued from the collinear     */
+/*  vertex.                                                                  */
+/*                                                                           */
+/*  If the first triangle on the path has a subsegment opposite its origin,  */
+/*  then there is a segment that intersects the segment being inserted.      */
+/*  Their intersection vertex is inserted, splitting the subsegment.         */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void eventheapify(struct event **heap, int heapsize, int eventnum)
+int scoutsegment(struct mesh *m, struct behavior *b, struct otri *searchtri,
+                 vertex endpoint2, int newmark)
 #else /* not ANSI_DECLARATORS */
-void eventheapify(heap, heapsize, eventnum)
-struct event **heap;
-int heapsize;
-int eventnum;
+int scoutsegment(m, b, searchtri, endpoint2, newmark)
+struct mesh *m;
+struct behavior *b;
+struct otri *searchtri;
+vertex endpoint2;
+int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct event *thisevent;
-  REAL eventx, eventy;
-  int leftchild, rightchild;
-  int smallest;
-  int notdone;
+  struct otri crosstri;
+  struct osub crosssubseg;
+  vertex leftvertex, rightvertex;
+  enum finddirectionresult collinear;
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  thisevent = heap[eventnum];
-  eventx = thisevent->xkey;
-  eventy = thisevent->ykey;
-  leftchild = 2 * eventnum + 1;
-  notdone = leftchild < heapsize;
-  while (notdone) {
-    if ((heap[leftchild]->ykey < eventy) ||
-        ((heap[leftchild]->ykey == eventy)
-         && (heap[leftchild]->xkey < eventx))) {
-      smallest = leftchild;
-    } else {
-      smallest = eventnum;
-    }
-    rightchild = leftchild + 1;
-    if (rightchild < heapsize) {
-      if ((heap[rightchild]->ykey < heap[smallest]->ykey) ||
-          ((heap[rightchild]->ykey == heap[smallest]->ykey)
-           && (heap[rightchild]->xkey < heap[smallest]->xkey))) {
-        smallest = rightchild;
-      }
+  collinear = finddirection(m, b, searchtri, endpoint2);
+  dest(*searchtri, rightvertex);
+  apex(*searchtri, leftvertex);
+  if (((leftvertex[0] == endpoint2[0]) && (leftvertex[1] == endpoint2[1])) ||
+      ((rightvertex[0] == endpoint2[0]) && (rightvertex[1] == endpoint2[1]))) {
+    /* The segment is already an edge in the mesh. */
+    if ((leftvertex[0] == endpoint2[0]) && (leftvertex[1] == endpoint2[1])) {
+      lprevself(*searchtri);
     }
-    if (smallest == eventnum) {
-      notdone = 0;
+    /* Insert a subsegment, if there isn't already one there. */
+    insertsubseg(m, b, searchtri, newmark);
+    return 1;
+  } else if (collinear == LEFTCOLLINEAR) {
+    /* We've collided with a vertex between the segment's endpoints. */
+    /* Make the collinear vertex be the triangle's origin. */
+    lprevself(*searchtri);
+    insertsubseg(m, b, searchtri, newmark);
+    /* Insert the remainder of the segment. */
+    return scoutsegment(m, b, searchtri, endpoint2, newmark);
+  } else if (collinear == RIGHTCOLLINEAR) {
+    /* We've collided with a vertex between the segment's endpoints. */
+    insertsubseg(m, b, searchtri, newmark);
+    /* Make the collinear vertex be the triangle's origin. */
+    lnextself(*searchtri);
+    /* Insert the remainder of the segment. */
+    return scoutsegment(m, b, searchtri, endpoint2, newmark);
+  } else {
+    lnext(*searchtri, crosstri);
+    tspivot(crosstri, crosssubseg);
+    /* Check for a crossing segment. */
+    if (crosssubseg.ss == m->dummysub) {
+      return 0;
     } else {
-      heap[eventnum] = heap[smallest];
-      heap[eventnum]->heapposition = eventnum;
-      heap[smallest] = thisevent;
-      thisevent->heapposition = smallest;
-
-      eventnum = smallest;
-      leftchild = 2 * eventnum + 1;
-      notdone = leftchild < heapsize;
+      /* Insert a vertex at the intersection. */
+      segmentintersection(m, b, &crosstri, &crosssubseg, endpoint2);
+      otricopy(crosstri, *searchtri);
+      insertsubseg(m, b, searchtri, newmark);
+      /* Insert the remainder of the segment. */
+      return scoutsegment(m, b, searchtri, endpoint2, newmark);
     }
   }
 }
 
-#endif /* not REDUCED */
+/*****************************************************************************/
+/*                                                                           */
+/*  conformingedge()   Force a segment into a conforming Delaunay            */
+/*                     triangulation by inserting a vertex at its midpoint,  */
+/*                     and recursively forcing in the two half-segments if   */
+/*                     necessary.                                            */
+/*                                                                           */
+/*  Generates a sequence of subsegments connecting `endpoint1' to            */
+/*  `endpoint2'.  `newmark' is the boundary marker of the segment, assigned  */
+/*  to each new splitting vertex and subsegment.                             */
+/*                                                                           */
+/*  Note that conformingedge() does not always maintain the conforming       */
+/*  Delaunay property.  Once inserted, segments are locked into place;       */
+/*  vertices inserted later (to force other segments in) may render these    */
+/*  fixed segments non-Delaunay.  The conforming Delaunay property will be   */
+/*  restored by enforcequality() by splitting encroached subsegments.        */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifndef REDUCED
+#ifndef CDT_ONLY
 
 #ifdef ANSI_DECLARATORS
-void eventheapdelete(struct event **heap, int heapsize, int eventnum)
+void conformingedge(struct mesh *m, struct behavior *b,
+                    vertex endpoint1, vertex endpoint2, int newmark)
 #else /* not ANSI_DECLARATORS */
-void eventheapdelete(heap, heapsize, eventnum)
-struct event **heap;
-int heapsize;
-int eventnum;
+void conformingedge(m, b, endpoint1, endpoint2, newmark)
+struct mesh *m;
+struct behavior *b;
+vertex endpoint1;
+vertex endpoint2;
+int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct event *moveevent;
-  REAL eventx, eventy;
-  int parent;
-  int notdone;
-
-  moveevent = heap[heapsize - 1];
-  if (eventnum > 0) {
-    eventx = moveevent->xkey;
-    eventy = moveevent->ykey;
-    do {
-      parent = (eventnum - 1) >> 1;
-      if ((heap[parent]->ykey < eventy) ||
-          ((heap[parent]->ykey == eventy)
-           && (heap[parent]->xkey <= eventx))) {
-        notdone = 0;
-      } else {
-        heap[eventnum] = heap[parent];
-        heap[eventnum]->heapposition = eventnum;
+  struct otri searchtri1, searchtri2;
+  struct osub brokensubseg;
+  vertex newvertex;
+  vertex midvertex1, midvertex2;
+  enum insertvertexresult success;
+  int i;
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-        eventnum = parent;
-        notdone = eventnum > 0;
+  if (b->verbose > 2) {
+    printf("Forcing segment into triangulation by recursive splitting:\n");
+    printf("  (%.12g, %.12g) (%.12g, %.12g)\n", endpoint1[0], endpoint1[1],
+           endpoint2[0], endpoint2[1]);
+  }
+  /* Create a new vertex to insert in the middle of the segment. */
+  newvertex = (vertex) poolalloc(&m->vertices);
+  /* Interpolate coordinates and attributes. */
+  for (i = 0; i < 2 + m->nextras; i++) {
+    newvertex[i] = 0.5 * (endpoint1[i] + endpoint2[i]);
+  }
+  setvertexmark(newvertex, newmark);
+  setvertextype(newvertex, SEGMENTVERTEX);
+  /* No known triangle to search from. */
+  searchtri1.tri = m->dummytri;
+  /* Attempt to insert the new vertex. */
+  success = insertvertex(m, b, newvertex, &searchtri1, (struct osub *) NULL,
+                         0, 0);
+  if (success == DUPLICATEVERTEX) {
+    if (b->verbose > 2) {
+      printf("  Segment intersects existing vertex (%.12g, %.12g).\n",
+             newvertex[0], newvertex[1]);
+    }
+    /* Use the vertex that's already there. */
+    vertexdealloc(m, newvertex);
+    org(searchtri1, newvertex);
+  } else {
+    if (success == VIOLATINGVERTEX) {
+      if (b->verbose > 2) {
+        printf("  Two segments intersect at (%.12g, %.12g).\n",
+               newvertex[0], newvertex[1]);
       }
-    } while (notdone);
+      /* By fluke, we've landed right on another segment.  Split it. */
+      tspivot(searchtri1, brokensubseg);
+      success = insertvertex(m, b, newvertex, &searchtri1, &brokensubseg,
+                             0, 0);
+      if (success != SUCCESSFULVERTEX) {
+        printf("Internal error in conformingedge():\n");
+        printf("  Failure to split a segment.\n");
+        internalerror();
+      }
+    }
+    /* The vertex has been inserted successfully. */
+    if (m->steinerleft > 0) {
+      m->steinerleft--;
+    }
+  }
+  otricopy(searchtri1, searchtri2);
+  /* `searchtri1' and `searchtri2' are fastened at their origins to         */
+  /*   `newvertex', and will be directed toward `endpoint1' and `endpoint2' */
+  /*   respectively.  First, we must get `searchtri2' out of the way so it  */
+  /*   won't be invalidated during the insertion of the first half of the   */
+  /*   segment.                                                             */
+  finddirection(m, b, &searchtri2, endpoint2);
+  if (!scoutsegment(m, b, &searchtri1, endpoint1, newmark)) {
+    /* The origin of searchtri1 may have changed if a collision with an */
+    /*   intervening vertex on the segment occurred.                    */
+    org(searchtri1, midvertex1);
+    conformingedge(m, b, midvertex1, endpoint1, newmark);
+  }
+  if (!scoutsegment(m, b, &searchtri2, endpoint2, newmark)) {
+    /* The origin of searchtri2 may have changed if a collision with an */
+    /*   intervening vertex on the segment occurred.                    */
+    org(searchtri2, midvertex2);
+    conformingedge(m, b, midvertex2, endpoint2, newmark);
   }
-  heap[eventnum] = moveevent;
-  moveevent->heapposition = eventnum;
-  eventheapify(heap, heapsize - 1, eventnum);
 }
 
+#endif /* not CDT_ONLY */
 #endif /* not REDUCED */
 
-#ifndef REDUCED
+/*****************************************************************************/
+/*                                                                           */
+/*  delaunayfixup()   Enforce the Delaunay condition at an edge, fanning out */
+/*                    recursively from an existing vertex.  Pay special      */
+/*                    attention to stacking inverted triangles.              */
+/*                                                                           */
+/*  This is a support routine for inserting segments into a constrained      */
+/*  Delaunay triangulation.                                                  */
+/*                                                                           */
+/*  The origin of fixuptri is treated as if it has just been inserted, and   */
+/*  the local Delaunay condition needs to be enforced.  It is only enforced  */
+/*  in one sector, however, that being the angular range defined by          */
+/*  fixuptri.                                                                */
+/*                                                                           */
+/*  This routine also needs to make decisions regarding the "stacking" of    */
+/*  triangles.  (Read the description of constrainededge() below before      */
+/*  reading on here, so you understand the algorithm.)  If the position of   */
+/*  the new vertex (the origin of fixuptri) indicates that the vertex before */
+/*  it on the polygon is a reflex vertex, then "stack" the triangle by       */
+/*  doing nothing.  (fixuptri is an inverted triangle, which is how stacked  */
+/*  triangles are identified.)                                               */
+/*                                                                           */
+/*  Otherwise, check whether the vertex before that was a reflex vertex.     */
+/*  If so, perform an edge flip, thereby eliminating an inverted triangle    */
+/*  (popping it off the stack).  The edge flip may result in the creation    */
+/*  of a new inverted triangle, depending on whether or not the new vertex   */
+/*  is visible to the vertex three edges behind on the polygon.              */
+/*                                                                           */
+/*  If neither of the two vertices behind the new vertex are reflex          */
+/*  vertices, fixuptri and fartri, the triangle opposite it, are not         */
+/*  inverted; hence, ensure that the edge between them is locally Delaunay.  */
+/*                                                                           */
+/*  `leftside' indicates whether or not fixuptri is to the left of the       */
+/*  segment being inserted.  (Imagine that the segment is pointing up from   */
+/*  endpoint1 to endpoint2.)                                                 */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void createeventheap(struct mesh *m, struct event ***eventheap,
-                     struct event **events, struct event **freeevents)
+void delaunayfixup(struct mesh *m, struct behavior *b,
+                   struct otri *fixuptri, int leftside)
 #else /* not ANSI_DECLARATORS */
-void createeventheap(m, eventheap, events, freeevents)
+void delaunayfixup(m, b, fixuptri, leftside)
 struct mesh *m;
-struct event ***eventheap;
-struct event **events;
-struct event **freeevents;
+struct behavior *b;
+struct otri *fixuptri;
+int leftside;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  vertex thisvertex;
-  int maxevents;
-  int i;
+  struct otri neartri;
+  struct otri fartri;
+  struct osub faredge;
+  vertex nearvertex, leftvertex, rightvertex, farvertex;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  maxevents = (3 * m->invertices) / 2;
-  *eventheap = (struct event **) trimalloc(maxevents *
-                                           (int) sizeof(struct event *));
-  *events = (struct event *) trimalloc(maxevents * (int) sizeof(struct event));
-  traversalinit(&m->vertices);
-  for (i = 0; i < m->invertices; i++) {
-    thisvertex = vertextraverse(m);
-    (*events)[i].eventptr = (VOID *) thisvertex;
-    (*events)[i].xkey = thisvertex[0];
-    (*events)[i].ykey = thisvertex[1];
-    eventheapinsert(*eventheap, i, *events + i);
+  lnext(*fixuptri, neartri);
+  sym(neartri, fartri);
+  /* Check if the edge opposite the origin of fixuptri can be flipped. */
+  if (fartri.tri == m->dummytri) {
+    return;
   }
-  *freeevents = (struct event *) NULL;
-  for (i = maxevents - 1; i >= m->invertices; i--) {
-    (*events)[i].eventptr = (VOID *) *freeevents;
-    *freeevents = *events + i;
+  tspivot(neartri, faredge);
+  if (faredge.ss != m->dummysub) {
+    return;
+  }
+  /* Find all the relevant vertices. */
+  apex(neartri, nearvertex);
+  org(neartri, leftvertex);
+  dest(neartri, rightvertex);
+  apex(fartri, farvertex);
+  /* Check whether the previous polygon vertex is a reflex vertex. */
+  if (leftside) {
+    if (counterclockwise(m, b, nearvertex, leftvertex, farvertex) <= 0.0) {
+      /* leftvertex is a reflex vertex too.  Nothing can */
+      /*   be done until a convex section is found.      */
+      return;
+    }
+  } else {
+    if (counterclockwise(m, b, farvertex, rightvertex, nearvertex) <= 0.0) {
+      /* rightvertex is a reflex vertex too.  Nothing can */
+      /*   be done until a convex section is found.       */
+      return;
+    }
   }
+  if (counterclockwise(m, b, rightvertex, leftvertex, farvertex) > 0.0) {
+    /* fartri is not an inverted triangle, and farvertex is not a reflex */
+    /*   vertex.  As there are no reflex vertices, fixuptri isn't an     */
+    /*   inverted triangle, either.  Hence, test the edge between the    */
+    /*   triangles to ensure it is locally Delaunay.                     */
+    if (incircle(m, b, leftvertex, farvertex, rightvertex, nearvertex) <=
+        0.0) {
+      return;
+    }
+    /* Not locally Delaunay; go on to an edge flip. */
+  }        /* else fartri is inverted; remove it from the stack by flipping. */
+  flip(m, b, &neartri);
+  lprevself(*fixuptri);    /* Restore the origin of fixuptri after the flip. */
+  /* Recursively process the two triangles that result from the flip. */
+  delaunayfixup(m, b, fixuptri, leftside);
+  delaunayfixup(m, b, &fartri, leftside);
 }
 
-#endif /* not REDUCED */
-
-#ifndef REDUCED
+/*****************************************************************************/
+/*                                                                           */
+/*  constrainededge()   Force a segment into a constrained Delaunay          */
+/*                      triangulation by deleting the triangles it           */
+/*                      intersects, and triangulating the polygons that      */
+/*                      form on each side of it.                             */
+/*                                                                           */
+/*  Generates a single subsegment connecting `endpoint1' to `endpoint2'.     */
+/*  The triangle `starttri' has `endpoint1' as its origin.  `newmark' is the */
+/*  boundary marker of the segment.                                          */
+/*                                                                           */
+/*  To insert a segment, every triangle whose interior intersects the        */
+/*  segment is deleted.  The union of these deleted triangles is a polygon   */
+/*  (which is not necessarily monotone, but is close enough), which is       */
+/*  divided into two polygons by the new segment.  This routine's task is    */
+/*  to generate the Delaunay triangulation of these two polygons.            */
+/*                                                                           */
+/*  You might think of this routine's behavior as a two-step process.  The   */
+/*  first step is to walk from endpoint1 to endpoint2, flipping each edge    */
+/*  encountered.  This step creates a fan of edges connected to endpoint1,   */
+/*  including the desired edge to endpoint2.  The second step enforces the   */
+/*  Delaunay condition on each side of the segment in an incremental manner: */
+/*  proceeding along the polygon from endpoint1 to endpoint2 (this is done   */
+/*  independently on each side of the segment), each vertex is "enforced"    */
+/*  as if it had just been inserted, but affecting only the previous         */
+/*  vertices.  The result is the same as if the vertices had been inserted   */
+/*  in the order they appear on the polygon, so the result is Delaunay.      */
+/*                                                                           */
+/*  In truth, constrainededge() interleaves these two steps.  The procedure  */
+/*  walks from endpoint1 to endpoint2, and each time an edge is encountered  */
+/*  and flipped, the newly exposed vertex (at the far end of the flipped     */
+/*  edge) is "enforced" upon the previously flipped edges, usually affecting */
+/*  only one side of the polygon (depending upon which side of the segment   */
+/*  the vertex falls on).                                                    */
+/*                                                                           */
+/*  The algorithm is complicated by the need to handle polygons that are not */
+/*  convex.  Although the polygon is not necessarily monotone, it can be     */
+/*  triangulated in a manner similar to the stack-based algorithms for       */
+/*  monotone polygons.  For each reflex vertex (local concavity) of the      */
+/*  polygon, there will be an inverted triangle formed by one of the edge    */
+/*  flips.  (An inverted triangle is one with negative area - that is, its   */
+/*  vertices are arranged in clockwise order - and is best thought of as a   */
+/*  wrinkle in the fabric of the mesh.)  Each inverted triangle can be       */
+/*  thought of as a reflex vertex pushed on the stack, waiting to be fixed   */
+/*  later.                                                                   */
+/*                                                                           */
+/*  A reflex vertex is popped from the stack when a vertex is inserted that  */
+/*  is visible to the reflex vertex.  (However, if the vertex behind the     */
+/*  reflex vertex is not visible to the reflex vertex, a new inverted        */
+/*  triangle will take its place on the stack.)  These details are handled   */
+/*  by the delaunayfixup() routine above.                                    */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-int rightofhyperbola(struct mesh *m, struct otri *fronttri, vertex newsite)
+void constrainededge(struct mesh *m, struct behavior *b,
+                     struct otri *starttri, vertex endpoint2, int newmark)
 #else /* not ANSI_DECLARATORS */
-int rightofhyperbola(m, fronttri, newsite)
+void constrainededge(m, b, starttri, endpoint2, newmark)
 struct mesh *m;
-struct otri *fronttri;
-vertex newsite;
+struct behavior *b;
+struct otri *starttri;
+vertex endpoint2;
+int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  vertex leftvertex, rightvertex;
-  REAL dxa, dya, dxb, dyb;
-
-  m->hyperbolacount++;
+  struct otri fixuptri, fixuptri2;
+  struct osub crosssubseg;
+  vertex endpoint1;
+  vertex farvertex;
+  REAL area;
+  int collision;
+  int done;
+  triangle ptr;             /* Temporary variable used by sym() and oprev(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  dest(*fronttri, leftvertex);
-  apex(*fronttri, rightvertex);
-  if ((leftvertex[1] < rightvertex[1]) ||
-      ((leftvertex[1] == rightvertex[1]) &&
-       (leftvertex[0] < rightvertex[0]))) {
-    if (newsite[0] >= rightvertex[0]) {
-      return 1;
+  org(*starttri, endpoint1);
+  lnext(*starttri, fixuptri);
+  flip(m, b, &fixuptri);
+  /* `collision' indicates whether we have found a vertex directly */
+  /*   between endpoint1 and endpoint2.                            */
+  collision = 0;
+  done = 0;
+  do {
+    org(fixuptri, farvertex);
+    /* `farvertex' is the extreme point of the polygon we are "digging" */
+    /*   to get from endpoint1 to endpoint2.                           */
+    if ((farvertex[0] == endpoint2[0]) && (farvertex[1] == endpoint2[1])) {
+      oprev(fixuptri, fixuptri2);
+      /* Enforce the Delaunay condition around endpoint2. */
+      delaunayfixup(m, b, &fixuptri, 0);
+      delaunayfixup(m, b, &fixuptri2, 1);
+      done = 1;
+    } else {
+      /* Check whether farvertex is to the left or right of the segment */
+      /*   being inserted, to decide which edge of fixuptri to dig      */
+      /*   through next.                                                */
+      area = counterclockwise(m, b, endpoint1, endpoint2, farvertex);
+      if (area == 0.0) {
+        /* We've collided with a vertex between endpoint1 and endpoint2. */
+        collision = 1;
+        oprev(fixuptri, fixuptri2);
+        /* Enforce the Delaunay condition around farvertex. */
+        delaunayfixup(m, b, &fixuptri, 0);
+        delaunayfixup(m, b, &fixuptri2, 1);
+        done = 1;
+      } else {
+        if (area > 0.0) {        /* farvertex is to the left of the segment. */
+          oprev(fixuptri, fixuptri2);
+          /* Enforce the Delaunay condition around farvertex, on the */
+          /*   left side of the segment only.                        */
+          delaunayfixup(m, b, &fixuptri2, 1);
+          /* Flip the edge that crosses the segment.  After the edge is */
+          /*   flipped, one of its endpoints is the fan vertex, and the */
+          /*   destination of fixuptri is the fan vertex.               */
+          lprevself(fixuptri);
+        } else {                /* farvertex is to the right of the segment. */
+          delaunayfixup(m, b, &fixuptri, 0);
+          /* Flip the edge that crosses the segment.  After the edge is */
+          /*   flipped, one of its endpoints is the fan vertex, and the */
+          /*   destination of fixuptri is the fan vertex.               */
+          oprevself(fixuptri);
+        }
+        /* Check for two intersecting segments. */
+        tspivot(fixuptri, crosssubseg);
+        if (crosssubseg.ss == m->dummysub) {
+          flip(m, b, &fixuptri);    /* May create inverted triangle at left. */
+        } else {
+          /* We've collided with a segment between endpoint1 and endpoint2. */
+          collision = 1;
+          /* Insert a vertex at the intersection. */
+          segmentintersection(m, b, &fixuptri, &crosssubseg, endpoint2);
+          done = 1;
+        }
+      }
     }
-  } else {
-    if (newsite[0] <= leftvertex[0]) {
-      return 0;
+  } while (!done);
+  /* Insert a subsegment to make the segment permanent. */
+  insertsubseg(m, b, &fixuptri, newmark);
+  /* If there was a collision with an interceding vertex, install another */
+  /*   segment connecting that vertex with endpoint2.                     */
+  if (collision) {
+    /* Insert the remainder of the segment. */
+    if (!scoutsegment(m, b, &fixuptri, endpoint2, newmark)) {
+      constrainededge(m, b, &fixuptri, endpoint2, newmark);
     }
   }
-  dxa = leftvertex[0] - newsite[0];
-  dya = leftvertex[1] - newsite[1];
-  dxb = rightvertex[0] - newsite[0];
-  dyb = rightvertex[1] - newsite[1];
-  return dya * (dxb * dxb + dyb * dyb) > dyb * (dxa * dxa + dya * dya);
 }
 
-#endif /* not REDUCED */
-
-#ifndef REDUCED
+/*****************************************************************************/
+/*                                                                           */
+/*  insertsegment()   Insert a PSLG segment into a triangulation.            */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-REAL circletop(struct mesh *m, vertex pa, vertex pb, vertex pc, REAL ccwabc)
+void insertsegment(struct mesh *m, struct behavior *b,
+                   vertex endpoint1, vertex endpoint2, int newmark)
 #else /* not ANSI_DECLARATORS */
-REAL circletop(m, pa, pb, pc, ccwabc)
+void insertsegment(m, b, endpoint1, endpoint2, newmark)
 struct mesh *m;
-vertex pa;
-vertex pb;
-vertex pc;
-REAL ccwabc;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  REAL xac, yac, xbc, ybc, xab, yab;
-  REAL aclen2, bclen2, ablen2;
-
-  m->circletopcount++;
-
-  xac = pa[0] - pc[0];
-  yac = pa[1] - pc[1];
-  xbc = pb[0] - pc[0];
-  ybc = pb[1] - pc[1];
-  xab = pa[0] - pb[0];
-  yab = pa[1] - pb[1];
-  aclen2 = xac * xac + yac * yac;
-  bclen2 = xbc * xbc + ybc * ybc;
-  ablen2 = xab * xab + yab * yab;
-  return pc[1] + (xac * bclen2 - xbc * aclen2 + sqrt(aclen2 * bclen2 * ablen2))
-               / (2.0 * ccwabc);
-}
-
-#endif /* not REDUCED */
-
-#ifndef REDUCED
-
-#ifdef ANSI_DECLARATORS
-void check4deadevent(struct otri *checktri, struct event **freeevents,
-                     struct event **eventheap, int *heapsize)
-#else /* not ANSI_DECLARATORS */
-void check4deadevent(checktri, freeevents, eventheap, heapsize)
-struct otri *checktri;
-struct event **freeevents;
-struct event **eventheap;
-int *heapsize;
+struct behavior *b;
+vertex endpoint1;
+vertex endpoint2;
+int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct event *deadevent;
-  vertex eventvertex;
-  int eventnum;
+  struct otri searchtri1, searchtri2;
+  triangle encodedtri;
+  vertex checkvertex;
+  triangle ptr;                         /* Temporary variable used by sym(). */
 
-  org(*checktri, eventvertex);
-  if (eventvertex != (vertex) NULL) {
-    deadevent = (struct event *) eventvertex;
-    eventnum = deadevent->heapposition;
-    deadevent->eventptr = (VOID *) *freeevents;
-    *freeevents = deadevent;
-    eventheapdelete(eventheap, *heapsize, eventnum);
-    (*heapsize)--;
-    setorg(*checktri, NULL);
+  if (b->verbose > 1) {
+    printf("  Connecting (%.12g, %.12g) to (%.12g, %.12g).\n",
+           endpoint1[0], endpoint1[1], endpoint2[0], endpoint2[1]);
   }
-}
-
-#endif /* not REDUCED */
-
-#ifndef REDUCED
-
-#ifdef ANSI_DECLARATORS
-struct splaynode *splay(struct mesh *m, struct splaynode *splaytree,
-                        vertex searchpoint, struct otri *searchtri)
-#else /* not ANSI_DECLARATORS */
-struct splaynode *splay(m, splaytree, searchpoint, searchtri)
-struct mesh *m;
-struct splaynode *splaytree;
-vertex searchpoint;
-struct otri *searchtri;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  struct splaynode *child, *grandchild;
-  struct splaynode *lefttree, *righttree;
-  struct splaynode *leftright;
-  vertex checkvertex;
-  int rightofroot, rightofchild;
 
-  if (splaytree == (struct splaynode *) NULL) {
-    return (struct splaynode *) NULL;
+  /* Find a triangle whose origin is the segment's first endpoint. */
+  checkvertex = (vertex) NULL;
+  encodedtri = vertex2tri(endpoint1);
+  if (encodedtri != (triangle) NULL) {
+    decode(encodedtri, searchtri1);
+    org(searchtri1, checkvertex);
   }
-  dest(splaytree->keyedge, checkvertex);
-  if (checkvertex == splaytree->keydest) {
-    rightofroot = rightofhyperbola(m, &splaytree->keyedge, searchpoint);
-    if (rightofroot) {
-      otricopy(splaytree->keyedge, *searchtri);
-      child = splaytree->rchild;
-    } else {
-      child = splaytree->lchild;
-    }
-    if (child == (struct splaynode *) NULL) {
-      return splaytree;
-    }
-    dest(child->keyedge, checkvertex);
-    if (checkvertex != child->keydest) {
-      child = splay(m, child, searchpoint, searchtri);
-      if (child == (struct splaynode *) NULL) {
-        if (rightofroot) {
-          splaytree->rchild = (struct splaynode *) NULL;
-        } else {
-          splaytree->lchild = (struct splaynode *) NULL;
-        }
-        return splaytree;
-      }
-    }
-    rightofchild = rightofhyperbola(m, &child->keyedge, searchpoint);
-    if (rightofchild) {
-      otricopy(child->keyedge, *searchtri);
-      grandchild = splay(m, child->rchild, searchpoint, searchtri);
-      child->rchild = grandchild;
-    } else {
-      grandchild = splay(m, child->lchild, searchpoint, searchtri);
-      child->lchild = grandchild;
-    }
-    if (grandchild == (struct splaynode *) NULL) {
-      if (rightofroot) {
-        splaytree->rchild = child->lchild;
-        child->lchild = splaytree;
-      } else {
-        splaytree->lchild = child->rchild;
-        child->rchild = splaytree;
-      }
-      return child;
-    }
-    if (rightofchild) {
-      if (rightofroot) {
-        splaytree->rchild = child->lchild;
-        child->lchild = splaytree;
-      } else {
-        splaytree->lchild = grandchild->rchild;
-        grandchild->rchild = splaytree;
-      }
-      child->rchild = grandchild->lchild;
-      grandchild->lchild = child;
-    } else {
-      if (rightofroot) {
-        splaytree->rchild = grandchild->lchild;
-        grandchild->lchild = splaytree;
-      } else {
-        splaytree->lchild = child->rchild;
-        child->rchild = splaytree;
-      }
-      child->lchild = grandchild->rchild;
-      grandchild->rchild = child;
+  if (checkvertex != endpoint1) {
+    /* Find a boundary triangle to search from. */
+    searchtri1.tri = m->dummytri;
+    searchtri1.orient = 0;
+    symself(searchtri1);
+    /* Search for the segment's first endpoint by point location. */
+    if (locate(m, b, endpoint1, &searchtri1) != ONVERTEX) {
+      printf(
+        "Internal error in insertsegment():  Unable to locate PSLG vertex\n");
+      printf("  (%.12g, %.12g) in triangulation.\n",
+             endpoint1[0], endpoint1[1]);
+      internalerror();
     }
-    return grandchild;
-  } else {
-    lefttree = splay(m, splaytree->lchild, searchpoint, searchtri);
-    righttree = splay(m, splaytree->rchild, searchpoint, searchtri);
+  }
+  /* Remember this triangle to improve subsequent point location. */
+  otricopy(searchtri1, m->recenttri);
+  /* Scout the beginnings of a path from the first endpoint */
+  /*   toward the second.                                   */
+  if (scoutsegment(m, b, &searchtri1, endpoint2, newmark)) {
+    /* The segment was easily inserted. */
+    return;
+  }
+  /* The first endpoint may have changed if a collision with an intervening */
+  /*   vertex on the segment occurred.                                      */
+  org(searchtri1, endpoint1);
 
-    pooldealloc(&m->splaynodes, (VOID *) splaytree);
-    if (lefttree == (struct splaynode *) NULL) {
-      return righttree;
-    } else if (righttree == (struct splaynode *) NULL) {
-      return lefttree;
-    } else if (lefttree->rchild == (struct splaynode *) NULL) {
-      lefttree->rchild = righttree->lchild;
-      righttree->lchild = lefttree;
-      return righttree;
-    } else if (righttree->lchild == (struct splaynode *) NULL) {
-      righttree->lchild = lefttree->rchild;
-      lefttree->rchild = righttree;
-      return lefttree;
-    } else {
-/*      printf("Holy Toledo!!!\n"); */
-      leftright = lefttree->rchild;
-      while (leftright->rchild != (struct splaynode *) NULL) {
-        leftright = leftright->rchild;
-      }
-      leftright->rchild = righttree;
-      return lefttree;
+  /* Find a triangle whose origin is the segment's second endpoint. */
+  checkvertex = (vertex) NULL;
+  encodedtri = vertex2tri(endpoint2);
+  if (encodedtri != (triangle) NULL) {
+    decode(encodedtri, searchtri2);
+    org(searchtri2, checkvertex);
+  }
+  if (checkvertex != endpoint2) {
+    /* Find a boundary triangle to search from. */
+    searchtri2.tri = m->dummytri;
+    searchtri2.orient = 0;
+    symself(searchtri2);
+    /* Search for the segment's second endpoint by point location. */
+    if (locate(m, b, endpoint2, &searchtri2) != ONVERTEX) {
+      printf(
+        "Internal error in insertsegment():  Unable to locate PSLG vertex\n");
+      printf("  (%.12g, %.12g) in triangulation.\n",
+             endpoint2[0], endpoint2[1]);
+      internalerror();
     }
   }
-}
+  /* Remember this triangle to improve subsequent point location. */
+  otricopy(searchtri2, m->recenttri);
+  /* Scout the beginnings of a path from the second endpoint */
+  /*   toward the first.                                     */
+  if (scoutsegment(m, b, &searchtri2, endpoint1, newmark)) {
+    /* The segment was easily inserted. */
+    return;
+  }
+  /* The second endpoint may have changed if a collision with an intervening */
+  /*   vertex on the segment occurred.                                       */
+  org(searchtri2, endpoint2);
 
+#ifndef REDUCED
+#ifndef CDT_ONLY
+  if (b->splitseg) {
+    /* Insert vertices to force the segment into the triangulation. */
+    conformingedge(m, b, endpoint1, endpoint2, newmark);
+  } else {
+#endif /* not CDT_ONLY */
 #endif /* not REDUCED */
-
+    /* Insert the segment directly into the triangulation. */
+    constrainededge(m, b, &searchtri1, endpoint2, newmark);
 #ifndef REDUCED
+#ifndef CDT_ONLY
+  }
+#endif /* not CDT_ONLY */
+#endif /* not REDUCED */
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  markhull()   Cover the convex hull of a triangulation with subsegments.  */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-struct splaynode *splayinsert(struct mesh *m, struct splaynode *splayroot,
-                              struct otri *newkey, vertex searchpoint)
+void markhull(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-struct splaynode *splayinsert(m, splayroot, newkey, searchpoint)
+void markhull(m, b)
 struct mesh *m;
-struct splaynode *splayroot;
-struct otri *newkey;
-vertex searchpoint;
+struct behavior *b;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct splaynode *newsplaynode;
+  struct otri hulltri;
+  struct otri nexttri;
+  struct otri starttri;
+  triangle ptr;             /* Temporary variable used by sym() and oprev(). */
 
-  newsplaynode = (struct splaynode *) poolalloc(&m->splaynodes);
-  otricopy(*newkey, newsplaynode->keyedge);
-  dest(*newkey, newsplaynode->keydest);
-  if (splayroot == (struct splaynode *) NULL) {
-    newsplaynode->lchild = (struct splaynode *) NULL;
-    newsplaynode->rchild = (struct splaynode *) NULL;
-  } else if (rightofhyperbola(m, &splayroot->keyedge, searchpoint)) {
-    newsplaynode->lchild = splayroot;
-    newsplaynode->rchild = splayroot->rchild;
-    splayroot->rchild = (struct splaynode *) NULL;
-  } else {
-    newsplaynode->lchild = splayroot->lchild;
-    newsplaynode->rchild = splayroot;
-    splayroot->lchild = (struct splaynode *) NULL;
-  }
-  return newsplaynode;
+  /* Find a triangle handle on the hull. */
+  hulltri.tri = m->dummytri;
+  hulltri.orient = 0;
+  symself(hulltri);
+  /* Remember where we started so we know when to stop. */
+  otricopy(hulltri, starttri);
+  /* Go once counterclockwise around the convex hull. */
+  do {
+    /* Create a subsegment if there isn't already one here. */
+    insertsubseg(m, b, &hulltri, 1);
+    /* To find the next hull edge, go clockwise around the next vertex. */
+    lnextself(hulltri);
+    oprev(hulltri, nexttri);
+    while (nexttri.tri != m->dummytri) {
+      otricopy(nexttri, hulltri);
+      oprev(hulltri, nexttri);
+    }
+  } while (!otriequal(hulltri, starttri));
 }
 
-#endif /* not REDUCED */
+/*****************************************************************************/
+/*                                                                           */
+/*  formskeleton()   Create the segments of a triangulation, including PSLG  */
+/*                   segments and edges on the convex hull.                  */
+/*                                                                           */
+/*  The PSLG segments are read from a .poly file.  The return value is the   */
+/*  number of segments in the file.                                          */
+/*                                                                           */
+/*****************************************************************************/
 
-#ifndef REDUCED
+#ifdef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-struct splaynode *circletopinsert(struct mesh *m, struct behavior *b,
-                                  struct splaynode *splayroot,
-                                  struct otri *newkey,
-                                  vertex pa, vertex pb, vertex pc, REAL topy)
+void formskeleton(struct mesh *m, struct behavior *b, int *segmentlist,
+                  int *segmentmarkerlist, int numberofsegments)
 #else /* not ANSI_DECLARATORS */
-struct splaynode *circletopinsert(m, b, splayroot, newkey, pa, pb, pc, topy)
+void formskeleton(m, b, segmentlist, segmentmarkerlist, numberofsegments)
 struct mesh *m;
 struct behavior *b;
-struct splaynode *splayroot;
-struct otri *newkey;
-vertex pa;
-vertex pb;
-vertex pc;
-REAL topy;
+int *segmentlist;
+int *segmentmarkerlist;
+int numberofsegments;
 #endif /* not ANSI_DECLARATORS */
 
-{
-  REAL ccwabc;
-  REAL xac, yac, xbc, ybc;
-  REAL aclen2, bclen2;
-  REAL searchpoint[2];
-  struct otri dummytri;
-
-  ccwabc = counterclockwise(m, b, pa, pb, pc);
-  xac = pa[0] - pc[0];
-  yac = pa[1] - pc[1];
-  xbc = pb[0] - pc[0];
-  ybc = pb[1] - pc[1];
-  aclen2 = xac * xac + yac * yac;
-  bclen2 = xbc * xbc + ybc * ybc;
-  searchpoint[0] = pc[0] - (yac * bclen2 - ybc * aclen2) / (2.0 * ccwabc);
-  searchpoint[1] = topy;
-  return splayinsert(m, splay(m, splayroot, (vertex) searchpoint, &dummytri),
-                     newkey, (vertex) searchpoint);
-}
-
-#endif /* not REDUCED */
-
-#ifndef REDUCED
+#else /* not TRILIBRARY */
 
 #ifdef ANSI_DECLARATORS
-struct splaynode *frontlocate(struct mesh *m, struct splaynode *splayroot,
-                              struct otri *bottommost, vertex searchvertex,
-                              struct otri *searchtri, int *farright)
+void formskeleton(struct mesh *m, struct behavior *b,
+                  FILE *polyfile, char *polyfilename)
 #else /* not ANSI_DECLARATORS */
-struct splaynode *frontlocate(m, splayroot, bottommost, searchvertex,
-                              searchtri, farright)
+void formskeleton(m, b, polyfile, polyfilename)
 struct mesh *m;
-struct splaynode *splayroot;
-struct otri *bottommost;
-vertex searchvertex;
-struct otri *searchtri;
-int *farright;
+struct behavior *b;
+FILE *polyfile;
+char *polyfilename;
 #endif /* not ANSI_DECLARATORS */
 
+#endif /* not TRILIBRARY */
+
 {
-  int farrightflag;
-  triangle ptr;                       /* Temporary variable used by onext(). */
+#ifdef TRILIBRARY
+  char polyfilename[6];
+  int index;
+#else /* not TRILIBRARY */
+  char inputline[INPUTLINESIZE];
+  char *stringptr;
+#endif /* not TRILIBRARY */
+  vertex endpoint1, endpoint2;
+  int segmentmarkers;
+  int end1, end2;
+  int boundmarker;
+  int i;
 
-  otricopy(*bottommost, *searchtri);
-  splayroot = splay(m, splayroot, searchvertex, searchtri);
+  if (b->poly) {
+    if (!b->quiet) {
+      printf("Recovering segments in Delaunay triangulation.\n");
+    }
+#ifdef TRILIBRARY
+    strcpy(polyfilename, "input");
+    m->insegments = numberofsegments;
+    segmentmarkers = segmentmarkerlist != (int *) NULL;
+    index = 0;
+#else /* not TRILIBRARY */
+    /* Read the segments from a .poly file. */
+    /* Read number of segments and number of boundary markers. */
+    stringptr = readline(inputline, polyfile, polyfilename);
+    m->insegments = (int) strtol(stringptr, &stringptr, 0);
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      segmentmarkers = 0;
+    } else {
+      segmentmarkers = (int) strtol(stringptr, &stringptr, 0);
+    }
+#endif /* not TRILIBRARY */
+    /* If the input vertices are collinear, there is no triangulation, */
+    /*   so don't try to insert segments.                              */
+    if (m->triangles.items == 0) {
+      return;
+    }
 
-  farrightflag = 0;
-  while (!farrightflag && rightofhyperbola(m, searchtri, searchvertex)) {
-    onextself(*searchtri);
-    farrightflag = otriequal(*searchtri, *bottommost);
+    /* If segments are to be inserted, compute a mapping */
+    /*   from vertices to triangles.                     */
+    if (m->insegments > 0) {
+      makevertexmap(m, b);
+      if (b->verbose) {
+        printf("  Recovering PSLG segments.\n");
+      }
+    }
+
+    boundmarker = 0;
+    /* Read and insert the segments. */
+    for (i = 0; i < m->insegments; i++) {
+#ifdef TRILIBRARY
+      end1 = segmentlist[index++];
+      end2 = segmentlist[index++];
+      if (segmentmarkers) {
+        boundmarker = segmentmarkerlist[i];
+      }
+#else /* not TRILIBRARY */
+      stringptr = readline(inputline, polyfile, b->inpolyfilename);
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        printf("Error:  Segment %d has no endpoints in %s.\n",
+               b->firstnumber + i, polyfilename);
+        triexit(1);
+      } else {
+        end1 = (int) strtol(stringptr, &stringptr, 0);
+      }
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        printf("Error:  Segment %d is missing its second endpoint in %s.\n",
+               b->firstnumber + i, polyfilename);
+        triexit(1);
+      } else {
+        end2 = (int) strtol(stringptr, &stringptr, 0);
+      }
+      if (segmentmarkers) {
+        stringptr = findfield(stringptr);
+        if (*stringptr == '\0') {
+          boundmarker = 0;
+        } else {
+          boundmarker = (int) strtol(stringptr, &stringptr, 0);
+        }
+      }
+#endif /* not TRILIBRARY */
+      if ((end1 < b->firstnumber) ||
+          (end1 >= b->firstnumber + m->invertices)) {
+        if (!b->quiet) {
+          printf("Warning:  Invalid first endpoint of segment %d in %s.\n",
+                 b->firstnumber + i, polyfilename);
+        }
+      } else if ((end2 < b->firstnumber) ||
+                 (end2 >= b->firstnumber + m->invertices)) {
+        if (!b->quiet) {
+          printf("Warning:  Invalid second endpoint of segment %d in %s.\n",
+                 b->firstnumber + i, polyfilename);
+        }
+      } else {
+        /* Find the vertices numbered `end1' and `end2'. */
+        endpoint1 = getvertex(m, b, end1);
+        endpoint2 = getvertex(m, b, end2);
+        if ((endpoint1[0] == endpoint2[0]) && (endpoint1[1] == endpoint2[1])) {
+          if (!b->quiet) {
+            printf("Warning:  Endpoints of segment %d are coincident in %s.\n",
+                   b->firstnumber + i, polyfilename);
+          }
+        } else {
+          insertsegment(m, b, endpoint1, endpoint2, boundmarker);
+        }
+      }
+    }
+  } else {
+    m->insegments = 0;
+  }
+  if (b->convex || !b->poly) {
+    /* Enclose the convex hull with subsegments. */
+    if (b->verbose) {
+      printf("  Enclosing convex hull with segments.\n");
+    }
+    markhull(m, b);
   }
-  *farright = farrightflag;
-  return splayroot;
 }
 
-#endif /* not REDUCED */
+/**                                                                         **/
+/**                                                                         **/
+/********* Segment insertion ends here                               *********/
 
-#ifndef REDUCED
+/********* Carving out holes and concavities begins here             *********/
+/**                                                                         **/
+/**                                                                         **/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  infecthull()   Virally infect all of the triangles of the convex hull    */
+/*                 that are not protected by subsegments.  Where there are   */
+/*                 subsegments, set boundary markers as appropriate.         */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-long sweeplinedelaunay(struct mesh *m, struct behavior *b)
+void infecthull(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-long sweeplinedelaunay(m, b)
+void infecthull(m, b)
 struct mesh *m;
 struct behavior *b;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct event **eventheap;
-  struct event *events;
-  struct event *freeevents;
-  struct event *nextevent;
-  struct event *newevent;
-  struct splaynode *splayroot;
-  struct otri bottommost;
-  struct otri searchtri;
-  struct otri fliptri;
-  struct otri lefttri, righttri, farlefttri, farrighttri;
-  struct otri inserttri;
-  vertex firstvertex, secondvertex;
-  vertex nextvertex, lastvertex;
-  vertex connectvertex;
-  vertex leftvertex, midvertex, rightvertex;
-  REAL lefttest, righttest;
-  int heapsize;
-  int check4events, farrightflag;
-  triangle ptr;   /* Temporary variable used by sym(), onext(), and oprev(). */
-
-  poolinit(&m->splaynodes, sizeof(struct splaynode), SPLAYNODEPERBLOCK,
-           SPLAYNODEPERBLOCK, 0);
-  splayroot = (struct splaynode *) NULL;
-
-  if (b->verbose) {
-    printf("  Placing vertices in event heap.\n");
-  }
-  createeventheap(m, &eventheap, &events, &freeevents);
-  heapsize = m->invertices;
+  struct otri hulltri;
+  struct otri nexttri;
+  struct otri starttri;
+  struct osub hullsubseg;
+  triangle **deadtriangle;
+  vertex horg, hdest;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
   if (b->verbose) {
-    printf("  Forming triangulation.\n");
+    printf("  Marking concavities (external triangles) for elimination.\n");
   }
-  maketriangle(m, b, &lefttri);
-  maketriangle(m, b, &righttri);
-  bond(lefttri, righttri);
-  lnextself(lefttri);
-  lprevself(righttri);
-  bond(lefttri, righttri);
-  lnextself(lefttri);
-  lprevself(righttri);
-  bond(lefttri, righttri);
-  firstvertex = (vertex) eventheap[0]->eventptr;
-  eventheap[0]->eventptr = (VOID *) freeevents;
-  freeevents = eventheap[0];
-  eventheapdelete(eventheap, heapsize, 0);
-  heapsize--;
+  /* Find a triangle handle on the hull. */
+  hulltri.tri = m->dummytri;
+  hulltri.orient = 0;
+  symself(hulltri);
+  /* Remember where we started so we know when to stop. */
+  otricopy(hulltri, starttri);
+  /* Go once counterclockwise around the convex hull. */
   do {
-    if (heapsize == 0) {
-      printf("Error:  Input vertices are all identical.\n");
-      triexit(1);
-    }
-    secondvertex = (vertex) eventheap[0]->eventptr;
-    eventheap[0]->eventptr = (VOID *) freeevents;
-    freeevents = eventheap[0];
-    eventheapdelete(eventheap, heapsize, 0);
-    heapsize--;
-    if ((firstvertex[0] == secondvertex[0]) &&
-        (firstvertex[1] == secondvertex[1])) {
-      if (!b->quiet) {
-        printf(
-"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
-               secondvertex[0], secondvertex[1]);
-      }
-      setvertextype(secondvertex, UNDEADVERTEX);
-      m->undeads++;
-    }
-  } while ((firstvertex[0] == secondvertex[0]) &&
-           (firstvertex[1] == secondvertex[1]));
-  setorg(lefttri, firstvertex);
-  setdest(lefttri, secondvertex);
-  setorg(righttri, secondvertex);
-  setdest(righttri, firstvertex);
-  lprev(lefttri, bottommost);
-  lastvertex = secondvertex;
-  while (heapsize > 0) {
-    nextevent = eventheap[0];
-    eventheapdelete(eventheap, heapsize, 0);
-    heapsize--;
-    check4events = 1;
-    if (nextevent->xkey < m->xmin) {
-      decode(nextevent->eventptr, fliptri);
-      oprev(fliptri, farlefttri);
-      check4deadevent(&farlefttri, &freeevents, eventheap, &heapsize);
-      onext(fliptri, farrighttri);
-      check4deadevent(&farrighttri, &freeevents, eventheap, &heapsize);
-
-      if (otriequal(farlefttri, bottommost)) {
-        lprev(fliptri, bottommost);
-      }
-      flip(m, b, &fliptri);
-      setapex(fliptri, NULL);
-      lprev(fliptri, lefttri);
-      lnext(fliptri, righttri);
-      sym(lefttri, farlefttri);
-
-      if (randomnation(SAMPLERATE) == 0) {
-        symself(fliptri);
-        dest(fliptri, leftvertex);
-        apex(fliptri, midvertex);
-        org(fliptri, rightvertex);
-        splayroot = circletopinsert(m, b, splayroot, &lefttri, leftvertex,
-                                    midvertex, rightvertex, nextevent->ykey);
-      }
-    } else {
-      nextvertex = (vertex) nextevent->eventptr;
-      if ((nextvertex[0] == lastvertex[0]) &&
-          (nextvertex[1] == lastvertex[1])) {
-        if (!b->quiet) {
-          printf(
-"Warning:  A duplicate vertex at (%.12g, %.12g) appeared and was ignored.\n",
-                 nextvertex[0], nextvertex[1]);
+    /* Ignore triangles that are already infected. */
+    if (!infected(hulltri)) {
+      /* Is the triangle protected by a subsegment? */
+      tspivot(hulltri, hullsubseg);
+      if (hullsubseg.ss == m->dummysub) {
+        /* The triangle is not protected; infect it. */
+        if (!infected(hulltri)) {
+          infect(hulltri);
+          deadtriangle = (triangle **) poolalloc(&m->viri);
+          *deadtriangle = hulltri.tri;
         }
-        setvertextype(nextvertex, UNDEADVERTEX);
-        m->undeads++;
-        check4events = 0;
       } else {
-        lastvertex = nextvertex;
-
-        splayroot = frontlocate(m, splayroot, &bottommost, nextvertex,
-                                &searchtri, &farrightflag);
-/*
-        otricopy(bottommost, searchtri);
-        farrightflag = 0;
-        while (!farrightflag && rightofhyperbola(m, &searchtri, nextvertex)) {
-          onextself(searchtri);
-          farrightflag = otriequal(searchtri, bottommost);
-        }
-*/
-
-        check4deadevent(&searchtri, &freeevents, eventheap, &heapsize);
-
-        otricopy(searchtri, farrighttri);
-        sym(searchtri, farlefttri);
-        maketriangle(m, b, &lefttri);
-        maketriangle(m, b, &righttri);
-        dest(farrighttri, connectvertex);
-        setorg(lefttri, connectvertex);
-        setdest(lefttri, nextvertex);
-        setorg(righttri, nextvertex);
-        setdest(righttri, connectvertex);
-        bond(lefttri, righttri);
-        lnextself(lefttri);
-        lprevself(righttri);
-        bond(lefttri, righttri);
-        lnextself(lefttri);
-        lprevself(righttri);
-        bond(lefttri, farlefttri);
-        bond(righttri, farrighttri);
-        if (!farrightflag && otriequal(farrighttri, bottommost)) {
-          otricopy(lefttri, bottommost);
-        }
-
-        if (randomnation(SAMPLERATE) == 0) {
-          splayroot = splayinsert(m, splayroot, &lefttri, nextvertex);
-        } else if (randomnation(SAMPLERATE) == 0) {
-          lnext(righttri, inserttri);
-          splayroot = splayinsert(m, splayroot, &inserttri, nextvertex);
-        }
-      }
-    }
-    nextevent->eventptr = (VOID *) freeevents;
-    freeevents = nextevent;
-
-    if (check4events) {
-      apex(farlefttri, leftvertex);
-      dest(lefttri, midvertex);
-      apex(lefttri, rightvertex);
-      lefttest = counterclockwise(m, b, leftvertex, midvertex, rightvertex);
-      if (lefttest > 0.0) {
-        newevent = freeevents;
-        freeevents = (struct event *) freeevents->eventptr;
-        newevent->xkey = m->xminextreme;
-        newevent->ykey = circletop(m, leftvertex, midvertex, rightvertex,
-                                   lefttest);
-        newevent->eventptr = (VOID *) encode(lefttri);
-        eventheapinsert(eventheap, heapsize, newevent);
-        heapsize++;
-        setorg(lefttri, newevent);
-      }
-      apex(righttri, leftvertex);
-      org(righttri, midvertex);
-      apex(farrighttri, rightvertex);
-      righttest = counterclockwise(m, b, leftvertex, midvertex, rightvertex);
-      if (righttest > 0.0) {
-        newevent = freeevents;
-        freeevents = (struct event *) freeevents->eventptr;
-        newevent->xkey = m->xminextreme;
-        newevent->ykey = circletop(m, leftvertex, midvertex, rightvertex,
-                                   righttest);
-        newevent->eventptr = (VOID *) encode(farrighttri);
-        eventheapinsert(eventheap, heapsize, newevent);
-        heapsize++;
-        setorg(farrighttri, newevent);
+        /* The triangle is protected; set boundary markers if appropriate. */
+        if (mark(hullsubseg) == 0) {
+          setmark(hullsubseg, 1);
+          org(hulltri, horg);
+          dest(hulltri, hdest);
+          if (vertexmark(horg) == 0) {
+            setvertexmark(horg, 1);
+          }
+          if (vertexmark(hdest) == 0) {
+            setvertexmark(hdest, 1);
+          }
+        }
       }
     }
-  }
-
-  pooldeinit(&m->splaynodes);
-  lprevself(bottommost);
-  return removeghosts(m, b, &bottommost);
+    /* To find the next hull edge, go clockwise around the next vertex. */
+    lnextself(hulltri);
+    oprev(hulltri, nexttri);
+    while (nexttri.tri != m->dummytri) {
+      otricopy(nexttri, hulltri);
+      oprev(hulltri, nexttri);
+    }
+  } while (!otriequal(hulltri, starttri));
 }
 
-#endif /* not REDUCED */
-
-/**                                                                         **/
-/**                                                                         **/
-/********* Sweepline Delaunay triangulation ends here                *********/
-
-/********* General mesh construction routines begin here             *********/
-/**                                                                         **/
-/**                                                                         **/
-
 /*****************************************************************************/
 /*                                                                           */
-/*  delaunay()   Form a Delaunay triangulation.                              */
+/*  plague()   Spread the virus from all infected triangles to any neighbors */
+/*             not protected by subsegments.  Delete all infected triangles. */
+/*                                                                           */
+/*  This is the procedure that actually creates holes and concavities.       */
+/*                                                                           */
+/*  This procedure operates in two phases.  The first phase identifies all   */
+/*  the triangles that will die, and marks them as infected.  They are       */
+/*  marked to ensure that each triangle is added to the virus pool only      */
+/*  once, so the procedure will terminate.                                   */
+/*                                                                           */
+/*  The second phase actually eliminates the infected triangles.  It also    */
+/*  eliminates orphaned vertices.                                            */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-long delaunay(struct mesh *m, struct behavior *b)
+void plague(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-long delaunay(m, b)
+void plague(m, b)
 struct mesh *m;
 struct behavior *b;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  long hulledges;
-
-  m->eextras = 0;
-  initializetrisubpools(m, b);
+  struct otri testtri;
+  struct otri neighbor;
+  triangle **virusloop;
+  triangle **deadtriangle;
+  struct osub neighborsubseg;
+  vertex testvertex;
+  vertex norg, ndest;
+  vertex deadorg, deaddest, deadapex;
+  int killorg;
+  triangle ptr;             /* Temporary variable used by sym() and onext(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-#ifdef REDUCED
-  if (!b->quiet) {
-    printf(
-      "Constructing Delaunay triangulation by divide-and-conquer method.\n");
+  if (b->verbose) {
+    printf("  Marking neighbors of marked triangles.\n");
   }
-  hulledges = divconqdelaunay(m, b);
-#else /* not REDUCED */
-  if (!b->quiet) {
-    printf("Constructing Delaunay triangulation ");
-    if (b->incremental) {
-      printf("by incremental method.\n");
-    } else if (b->sweepline) {
-      printf("by sweepline method.\n");
-    } else {
-      printf("by divide-and-conquer method.\n");
+  /* Loop through all the infected triangles, spreading the virus to */
+  /*   their neighbors, then to their neighbors' neighbors.          */
+  traversalinit(&m->viri);
+  virusloop = (triangle **) traverse(&m->viri);
+  while (virusloop != (triangle **) NULL) {
+    testtri.tri = *virusloop;
+    /* A triangle is marked as infected by messing with one of its pointers */
+    /*   to subsegments, setting it to an illegal value.  Hence, we have to */
+    /*   temporarily uninfect this triangle so that we can examine its      */
+    /*   adjacent subsegments.                                              */
+    uninfect(testtri);
+    if (b->verbose > 2) {
+      /* Assign the triangle an orientation for convenience in */
+      /*   checking its vertices.                              */
+      testtri.orient = 0;
+      org(testtri, deadorg);
+      dest(testtri, deaddest);
+      apex(testtri, deadapex);
+      printf("    Checking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
+             deadorg[0], deadorg[1], deaddest[0], deaddest[1],
+             deadapex[0], deadapex[1]);
+    }
+    /* Check each of the triangle's three neighbors. */
+    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
+      /* Find the neighbor. */
+      sym(testtri, neighbor);
+      /* Check for a subsegment between the triangle and its neighbor. */
+      tspivot(testtri, neighborsubseg);
+      /* Check if the neighbor is nonexistent or already infected. */
+      if ((neighbor.tri == m->dummytri) || infected(neighbor)) {
+        if (neighborsubseg.ss != m->dummysub) {
+          /* There is a subsegment separating the triangle from its      */
+          /*   neighbor, but both triangles are dying, so the subsegment */
+          /*   dies too.                                                 */
+          subsegdealloc(m, neighborsubseg.ss);
+          if (neighbor.tri != m->dummytri) {
+            /* Make sure the subsegment doesn't get deallocated again */
+            /*   later when the infected neighbor is visited.         */
+            uninfect(neighbor);
+            tsdissolve(neighbor);
+            infect(neighbor);
+          }
+        }
+      } else {                   /* The neighbor exists and is not infected. */
+        if (neighborsubseg.ss == m->dummysub) {
+          /* There is no subsegment protecting the neighbor, so */
+          /*   the neighbor becomes infected.                   */
+          if (b->verbose > 2) {
+            org(neighbor, deadorg);
+            dest(neighbor, deaddest);
+            apex(neighbor, deadapex);
+            printf(
+              "    Marking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
+                   deadorg[0], deadorg[1], deaddest[0], deaddest[1],
+                   deadapex[0], deadapex[1]);
+          }
+          infect(neighbor);
+          /* Ensure that the neighbor's neighbors will be infected. */
+          deadtriangle = (triangle **) poolalloc(&m->viri);
+          *deadtriangle = neighbor.tri;
+        } else {               /* The neighbor is protected by a subsegment. */
+          /* Remove this triangle from the subsegment. */
+          stdissolve(neighborsubseg);
+          /* The subsegment becomes a boundary.  Set markers accordingly. */
+          if (mark(neighborsubseg) == 0) {
+            setmark(neighborsubseg, 1);
+          }
+          org(neighbor, norg);
+          dest(neighbor, ndest);
+          if (vertexmark(norg) == 0) {
+            setvertexmark(norg, 1);
+          }
+          if (vertexmark(ndest) == 0) {
+            setvertexmark(ndest, 1);
+          }
+        }
+      }
     }
+    /* Remark the triangle as infected, so it doesn't get added to the */
+    /*   virus pool again.                                             */
+    infect(testtri);
+    virusloop = (triangle **) traverse(&m->viri);
   }
-  if (b->incremental) {
-    hulledges = incrementaldelaunay(m, b);
-  } else if (b->sweepline) {
-    hulledges = sweeplinedelaunay(m, b);
-  } else {
-    hulledges = divconqdelaunay(m, b);
+
+  if (b->verbose) {
+    printf("  Deleting marked triangles.\n");
   }
-#endif /* not REDUCED */
 
-  if (m->triangles.items == 0) {
-    /* The input vertices were all collinear, so there are no triangles. */
-    return 0l;
-  } else {
-    return hulledges;
+  traversalinit(&m->viri);
+  virusloop = (triangle **) traverse(&m->viri);
+  while (virusloop != (triangle **) NULL) {
+    testtri.tri = *virusloop;
+
+    /* Check each of the three corners of the triangle for elimination. */
+    /*   This is done by walking around each vertex, checking if it is  */
+    /*   still connected to at least one live triangle.                 */
+    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
+      org(testtri, testvertex);
+      /* Check if the vertex has already been tested. */
+      if (testvertex != (vertex) NULL) {
+        killorg = 1;
+        /* Mark the corner of the triangle as having been tested. */
+        setorg(testtri, NULL);
+        /* Walk counterclockwise about the vertex. */
+        onext(testtri, neighbor);
+        /* Stop upon reaching a boundary or the starting triangle. */
+        while ((neighbor.tri != m->dummytri) &&
+               (!otriequal(neighbor, testtri))) {
+          if (infected(neighbor)) {
+            /* Mark the corner of this triangle as having been tested. */
+            setorg(neighbor, NULL);
+          } else {
+            /* A live triangle.  The vertex survives. */
+            killorg = 0;
+          }
+          /* Walk counterclockwise about the vertex. */
+          onextself(neighbor);
+        }
+        /* If we reached a boundary, we must walk clockwise as well. */
+        if (neighbor.tri == m->dummytri) {
+          /* Walk clockwise about the vertex. */
+          oprev(testtri, neighbor);
+          /* Stop upon reaching a boundary. */
+          while (neighbor.tri != m->dummytri) {
+            if (infected(neighbor)) {
+            /* Mark the corner of this triangle as having been tested. */
+              setorg(neighbor, NULL);
+            } else {
+              /* A live triangle.  The vertex survives. */
+              killorg = 0;
+            }
+            /* Walk clockwise about the vertex. */
+            oprevself(neighbor);
+          }
+        }
+        if (killorg) {
+          if (b->verbose > 1) {
+            printf("    Deleting vertex (%.12g, %.12g)\n",
+                   testvertex[0], testvertex[1]);
+          }
+          setvertextype(testvertex, UNDEADVERTEX);
+          m->undeads++;
+        }
+      }
+    }
+
+    /* Record changes in the number of boundary edges, and disconnect */
+    /*   dead triangles from their neighbors.                         */
+    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
+      sym(testtri, neighbor);
+      if (neighbor.tri == m->dummytri) {
+        /* There is no neighboring triangle on this edge, so this edge    */
+        /*   is a boundary edge.  This triangle is being deleted, so this */
+        /*   boundary edge is deleted.                                    */
+        m->hullsize--;
+      } else {
+        /* Disconnect the triangle from its neighbor. */
+        dissolve(neighbor);
+        /* There is a neighboring triangle on this edge, so this edge */
+        /*   becomes a boundary edge when this triangle is deleted.   */
+        m->hullsize++;
+      }
+    }
+    /* Return the dead triangle to the pool of triangles. */
+    triangledealloc(m, testtri.tri);
+    virusloop = (triangle **) traverse(&m->viri);
   }
+  /* Empty the virus pool. */
+  poolrestart(&m->viri);
 }
 
-/*****************************************************************************/
-/*                                                                           */
-/*  reconstruct()   Reconstruct a triangulation from its .ele (and possibly  */
-/*                  .poly) file.  Used when the -r switch is used.           */
+/*****************************************************************************/
 /*                                                                           */
-/*  Reads an .ele file and reconstructs the original mesh.  If the -p switch */
-/*  is used, this procedure will also read a .poly file and reconstruct the  */
-/*  subsegments of the original mesh.  If the -a switch is used, this        */
-/*  procedure will also read an .area file and set a maximum area constraint */
-/*  on each triangle.                                                        */
+/*  regionplague()   Spread regional attributes and/or area constraints      */
+/*                   (from a .poly file) throughout the mesh.                */
 /*                                                                           */
-/*  Vertices that are not corners of triangles, such as nodes on edges of    */
-/*  subparametric elements, are discarded.                                   */
+/*  This procedure operates in two phases.  The first phase spreads an       */
+/*  attribute and/or an area constraint through a (segment-bounded) region.  */
+/*  The triangles are marked to ensure that each triangle is added to the    */
+/*  virus pool only once, so the procedure will terminate.                   */
 /*                                                                           */
-/*  This routine finds the adjacencies between triangles (and subsegments)   */
-/*  by forming one stack of triangles for each vertex.  Each triangle is on  */
-/*  three different stacks simultaneously.  Each triangle's subsegment       */
-/*  pointers are used to link the items in each stack.  This memory-saving   */
-/*  feature makes the code harder to read.  The most important thing to keep */
-/*  in mind is that each triangle is removed from a stack precisely when     */
-/*  the corresponding pointer is adjusted to refer to a subsegment rather    */
-/*  than the next triangle of the stack.                                     */
+/*  The second phase uninfects all infected triangles, returning them to     */
+/*  normal.                                                                  */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef CDT_ONLY
-
-#ifdef TRILIBRARY
-
-#ifdef ANSI_DECLARATORS
-int reconstruct(struct mesh *m, struct behavior *b, int *trianglelist,
-                REAL *triangleattriblist, REAL *trianglearealist,
-                int elements, int corners, int attribs,
-                int *segmentlist,int *segmentmarkerlist, int numberofsegments)
-#else /* not ANSI_DECLARATORS */
-int reconstruct(m, b, trianglelist, triangleattriblist, trianglearealist,
-                elements, corners, attribs, segmentlist, segmentmarkerlist,
-                numberofsegments)
-struct mesh *m;
-struct behavior *b;
-int *trianglelist;
-REAL *triangleattriblist;
-REAL *trianglearealist;
-int elements;
-int corners;
-int attribs;
-int *segmentlist;
-int *segmentmarkerlist;
-int numberofsegments;
-#endif /* not ANSI_DECLARATORS */
-
-#else /* not TRILIBRARY */
-
 #ifdef ANSI_DECLARATORS
-long reconstruct(struct mesh *m, struct behavior *b, char *elefilename,
-                 char *areafilename, char *polyfilename, FILE *polyfile)
+void regionplague(struct mesh *m, struct behavior *b,
+                  REAL attribute, REAL area)
 #else /* not ANSI_DECLARATORS */
-long reconstruct(m, b, elefilename, areafilename, polyfilename, polyfile)
+void regionplague(m, b, attribute, area)
 struct mesh *m;
 struct behavior *b;
-char *elefilename;
-char *areafilename;
-char *polyfilename;
-FILE *polyfile;
+REAL attribute;
+REAL area;
 #endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
-
 {
-#ifdef TRILIBRARY
-  int vertexindex;
-  int attribindex;
-#else /* not TRILIBRARY */
-  FILE *elefile;
-  FILE *areafile;
-  char inputline[INPUTLINESIZE];
-  char *stringptr;
-  int areaelements;
-#endif /* not TRILIBRARY */
-  struct otri triangleloop;
-  struct otri triangleleft;
-  struct otri checktri;
-  struct otri checkleft;
-  struct otri checkneighbor;
-  struct osub subsegloop;
-  triangle *vertexarray;
-  triangle *prevlink;
-  triangle nexttri;
-  vertex tdest, tapex;
-  vertex checkdest, checkapex;
-  vertex shorg;
-  vertex killvertex;
-  vertex segmentorg, segmentdest;
-  REAL area;
-  int corner[3];
-  int end[2];
-  int killvertexindex;
-  int incorners;
-  int segmentmarkers;
-  int boundmarker;
-  int aroundvertex;
-  long hullsize;
-  int notfound;
-  long elementnumber, segmentnumber;
-  int i, j;
-  triangle ptr;                         /* Temporary variable used by sym(). */
+  struct otri testtri;
+  struct otri neighbor;
+  triangle **virusloop;
+  triangle **regiontri;
+  struct osub neighborsubseg;
+  vertex regionorg, regiondest, regionapex;
+  triangle ptr;             /* Temporary variable used by sym() and onext(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-#ifdef TRILIBRARY
-  m->inelements = elements;
-  incorners = corners;
-  if (incorners < 3) {
-    printf("Error:  Triangles must have at least 3 vertices.\n");
-    triexit(1);
-  }
-  m->eextras = attribs;
-#else /* not TRILIBRARY */
-  /* Read the triangles from an .ele file. */
-  if (!b->quiet) {
-    printf("Opening %s.\n", elefilename);
-  }
-  elefile = fopen(elefilename, "r");
-  if (elefile == (FILE *) NULL) {
-    printf("  Error:  Cannot access file %s.\n", elefilename);
-    triexit(1);
+  if (b->verbose > 1) {
+    printf("  Marking neighbors of marked triangles.\n");
   }
-  /* Read number of triangles, number of vertices per triangle, and */
-  /*   number of triangle attributes from .ele file.                */
-  stringptr = readline(inputline, elefile, elefilename);
-  m->inelements = (int) strtol(stringptr, &stringptr, 0);
-  stringptr = findfield(stringptr);
-  if (*stringptr == '\0') {
-    incorners = 3;
-  } else {
-    incorners = (int) strtol(stringptr, &stringptr, 0);
-    if (incorners < 3) {
-      printf("Error:  Triangles in %s must have at least 3 vertices.\n",
-             elefilename);
-      triexit(1);
+  /* Loop through all the infected triangles, spreading the attribute      */
+  /*   and/or area constraint to their neighbors, then to their neighbors' */
+  /*   neighbors.                                                          */
+  traversalinit(&m->viri);
+  virusloop = (triangle **) traverse(&m->viri);
+  while (virusloop != (triangle **) NULL) {
+    testtri.tri = *virusloop;
+    /* A triangle is marked as infected by messing with one of its pointers */
+    /*   to subsegments, setting it to an illegal value.  Hence, we have to */
+    /*   temporarily uninfect this triangle so that we can examine its      */
+    /*   adjacent subsegments.                                              */
+    uninfect(testtri);
+    if (b->regionattrib) {
+      /* Set an attribute. */
+      setelemattribute(testtri, m->eextras, attribute);
     }
+    if (b->vararea) {
+      /* Set an area constraint. */
+      setareabound(testtri, area);
+    }
+    if (b->verbose > 2) {
+      /* Assign the triangle an orientation for convenience in */
+      /*   checking its vertices.                              */
+      testtri.orient = 0;
+      org(testtri, regionorg);
+      dest(testtri, regiondest);
+      apex(testtri, regionapex);
+      printf("    Checking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
+             regionorg[0], regionorg[1], regiondest[0], regiondest[1],
+             regionapex[0], regionapex[1]);
+    }
+    /* Check each of the triangle's three neighbors. */
+    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
+      /* Find the neighbor. */
+      sym(testtri, neighbor);
+      /* Check for a subsegment between the triangle and its neighbor. */
+      tspivot(testtri, neighborsubseg);
+      /* Make sure the neighbor exists, is not already infected, and */
+      /*   isn't protected by a subsegment.                          */
+      if ((neighbor.tri != m->dummytri) && !infected(neighbor)
+          && (neighborsubseg.ss == m->dummysub)) {
+        if (b->verbose > 2) {
+          org(neighbor, regionorg);
+          dest(neighbor, regiondest);
+          apex(neighbor, regionapex);
+          printf("    Marking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
+                 regionorg[0], regionorg[1], regiondest[0], regiondest[1],
+                 regionapex[0], regionapex[1]);
+        }
+        /* Infect the neighbor. */
+        infect(neighbor);
+        /* Ensure that the neighbor's neighbors will be infected. */
+        regiontri = (triangle **) poolalloc(&m->viri);
+        *regiontri = neighbor.tri;
+      }
+    }
+    /* Remark the triangle as infected, so it doesn't get added to the */
+    /*   virus pool again.                                             */
+    infect(testtri);
+    virusloop = (triangle **) traverse(&m->viri);
   }
-  stringptr = findfield(stringptr);
-  if (*stringptr == '\0') {
-    m->eextras = 0;
-  } else {
-    m->eextras = (int) strtol(stringptr, &stringptr, 0);
-  }
-#endif /* not TRILIBRARY */
-
-  initializetrisubpools(m, b);
 
-  /* Create the triangles. */
-  for (elementnumber = 1; elementnumber <= m->inelements; elementnumber++) {
-    maketriangle(m, b, &triangleloop);
-    /* Mark the triangle as living. */
-    triangleloop.tri[3] = (triangle) triangleloop.tri;
+  /* Uninfect all triangles. */
+  if (b->verbose > 1) {
+    printf("  Unmarking marked triangles.\n");
+  }
+  traversalinit(&m->viri);
+  virusloop = (triangle **) traverse(&m->viri);
+  while (virusloop != (triangle **) NULL) {
+    testtri.tri = *virusloop;
+    uninfect(testtri);
+    virusloop = (triangle **) traverse(&m->viri);
   }
+  /* Empty the virus pool. */
+  poolrestart(&m->viri);
+}
 
-  segmentmarkers = 0;
-  if (b->poly) {
-#ifdef TRILIBRARY
-    m->insegments = numberofsegments;
-    segmentmarkers = segmentmarkerlist != (int *) NULL;
-#else /* not TRILIBRARY */
-    /* Read number of segments and number of segment */
-    /*   boundary markers from .poly file.           */
-    stringptr = readline(inputline, polyfile, b->inpolyfilename);
-    m->insegments = (int) strtol(stringptr, &stringptr, 0);
-    stringptr = findfield(stringptr);
-    if (*stringptr != '\0') {
-      segmentmarkers = (int) strtol(stringptr, &stringptr, 0);
-    }
-#endif /* not TRILIBRARY */
+/*****************************************************************************/
+/*                                                                           */
+/*  carveholes()   Find the holes and infect them.  Find the area            */
+/*                 constraints and infect them.  Infect the convex hull.     */
+/*                 Spread the infection and kill triangles.  Spread the      */
+/*                 area constraints.                                         */
+/*                                                                           */
+/*  This routine mainly calls other routines to carry out all these          */
+/*  functions.                                                               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void carveholes(struct mesh *m, struct behavior *b, REAL *holelist, int holes,
+                REAL *regionlist, int regions)
+#else /* not ANSI_DECLARATORS */
+void carveholes(m, b, holelist, holes, regionlist, regions)
+struct mesh *m;
+struct behavior *b;
+REAL *holelist;
+int holes;
+REAL *regionlist;
+int regions;
+#endif /* not ANSI_DECLARATORS */
 
-    /* Create the subsegments. */
-    for (segmentnumber = 1; segmentnumber <= m->insegments; segmentnumber++) {
-      makesubseg(m, &subsegloop);
-      /* Mark the subsegment as living. */
-      subsegloop.ss[2] = (subseg) subsegloop.ss;
-    }
-  }
+{
+  struct otri searchtri;
+  struct otri triangleloop;
+  struct otri *regiontris;
+  triangle **holetri;
+  triangle **regiontri;
+  vertex searchorg, searchdest;
+  enum locateresult intersect;
+  int i;
+  triangle ptr;                         /* Temporary variable used by sym(). */
 
-#ifdef TRILIBRARY
-  vertexindex = 0;
-  attribindex = 0;
-#else /* not TRILIBRARY */
-  if (b->vararea) {
-    /* Open an .area file, check for consistency with the .ele file. */
-    if (!b->quiet) {
-      printf("Opening %s.\n", areafilename);
-    }
-    areafile = fopen(areafilename, "r");
-    if (areafile == (FILE *) NULL) {
-      printf("  Error:  Cannot access file %s.\n", areafilename);
-      triexit(1);
-    }
-    stringptr = readline(inputline, areafile, areafilename);
-    areaelements = (int) strtol(stringptr, &stringptr, 0);
-    if (areaelements != m->inelements) {
-      printf("Error:  %s and %s disagree on number of triangles.\n",
-             elefilename, areafilename);
-      triexit(1);
+  if (!(b->quiet || (b->noholes && b->convex))) {
+    printf("Removing unwanted triangles.\n");
+    if (b->verbose && (holes > 0)) {
+      printf("  Marking holes for elimination.\n");
     }
   }
-#endif /* not TRILIBRARY */
 
-  if (!b->quiet) {
-    printf("Reconstructing mesh.\n");
+  if (regions > 0) {
+    /* Allocate storage for the triangles in which region points fall. */
+    regiontris = (struct otri *) memalloc(&m->memory, regions *
+                                          (int) sizeof(struct otri));
+  } else {
+    regiontris = (struct otri *) NULL;
   }
-  /* Allocate a temporary array that maps each vertex to some adjacent */
-  /*   triangle.  I took care to allocate all the permanent memory for */
-  /*   triangles and subsegments first.                                */
-  vertexarray = (triangle *) trimalloc(m->vertices.items *
-                                       (int) sizeof(triangle));
-  /* Each vertex is initially unrepresented. */
-  for (i = 0; i < m->vertices.items; i++) {
-    vertexarray[i] = (triangle) m->dummytri;
+
+  if (((holes > 0) && !b->noholes) || !b->convex || (regions > 0)) {
+    /* Initialize a pool of viri to be used for holes, concavities, */
+    /*   regional attributes, and/or regional area constraints.     */
+    poolprepare(m, &m->viri, sizeof(triangle *), VIRUSPERBLOCK, VIRUSPERBLOCK,
+                0);
   }
 
-  if (b->verbose) {
-    printf("  Assembling triangles.\n");
+  if (!b->convex) {
+    /* Mark as infected any unprotected triangles on the boundary. */
+    /*   This is one way by which concavities are created.         */
+    infecthull(m, b);
   }
-  /* Read the triangles from the .ele file, and link */
-  /*   together those that share an edge.            */
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  elementnumber = b->firstnumber;
-  while (triangleloop.tri != (triangle *) NULL) {
-#ifdef TRILIBRARY
-    /* Copy the triangle's three corners. */
-    for (j = 0; j < 3; j++) {
-      corner[j] = trianglelist[vertexindex++];
-      if ((corner[j] < b->firstnumber) ||
-          (corner[j] >= b->firstnumber + m->invertices)) {
-        printf("Error:  Triangle %ld has an invalid vertex index.\n",
-               elementnumber);
-        triexit(1);
-      }
-    }
-#else /* not TRILIBRARY */
-    /* Read triangle number and the triangle's three corners. */
-    stringptr = readline(inputline, elefile, elefilename);
-    for (j = 0; j < 3; j++) {
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        printf("Error:  Triangle %ld is missing vertex %d in %s.\n",
-               elementnumber, j + 1, elefilename);
-        triexit(1);
-      } else {
-        corner[j] = (int) strtol(stringptr, &stringptr, 0);
-        if ((corner[j] < b->firstnumber) ||
-            (corner[j] >= b->firstnumber + m->invertices)) {
-          printf("Error:  Triangle %ld has an invalid vertex index.\n",
-                 elementnumber);
-          triexit(1);
-        }
-      }
-    }
-#endif /* not TRILIBRARY */
 
-    /* Find out about (and throw away) extra nodes. */
-    for (j = 3; j < incorners; j++) {
-#ifdef TRILIBRARY
-      killvertexindex = trianglelist[vertexindex++];
-#else /* not TRILIBRARY */
-      stringptr = findfield(stringptr);
-      if (*stringptr != '\0') {
-        killvertexindex = (int) strtol(stringptr, &stringptr, 0);
-#endif /* not TRILIBRARY */
-        if ((killvertexindex >= b->firstnumber) &&
-            (killvertexindex < b->firstnumber + m->invertices)) {
-          /* Delete the non-corner vertex if it's not already deleted. */
-          killvertex = getvertex(m, b, killvertexindex);
-          if (vertextype(killvertex) != DEADVERTEX) {
-            vertexdealloc(m, killvertex);
+  if ((holes > 0) && !b->noholes) {
+    /* Infect each triangle in which a hole lies. */
+    for (i = 0; i < 2 * holes; i += 2) {
+      /* Ignore holes that aren't within the bounds of the mesh. */
+      if ((holelist[i] >= m->xmin) && (holelist[i] <= m->xmax)
+          && (holelist[i + 1] >= m->ymin) && (holelist[i + 1] <= m->ymax)) {
+        /* Start searching from some triangle on the outer boundary. */
+        searchtri.tri = m->dummytri;
+        searchtri.orient = 0;
+        symself(searchtri);
+        /* Ensure that the hole is to the left of this boundary edge; */
+        /*   otherwise, locate() will falsely report that the hole    */
+        /*   falls within the starting triangle.                      */
+        org(searchtri, searchorg);
+        dest(searchtri, searchdest);
+        if (counterclockwise(m, b, searchorg, searchdest, &holelist[i]) >
+            0.0) {
+          /* Find a triangle that contains the hole. */
+          intersect = locate(m, b, &holelist[i], &searchtri);
+          if ((intersect != OUTSIDE) && (!infected(searchtri))) {
+            /* Infect the triangle.  This is done by marking the triangle  */
+            /*   as infected and including the triangle in the virus pool. */
+            infect(searchtri);
+            holetri = (triangle **) poolalloc(&m->viri);
+            *holetri = searchtri.tri;
           }
         }
-#ifndef TRILIBRARY
-      }
-#endif /* not TRILIBRARY */
-    }
-
-    /* Read the triangle's attributes. */
-    for (j = 0; j < m->eextras; j++) {
-#ifdef TRILIBRARY
-      setelemattribute(triangleloop, j, triangleattriblist[attribindex++]);
-#else /* not TRILIBRARY */
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        setelemattribute(triangleloop, j, 0);
-      } else {
-        setelemattribute(triangleloop, j,
-                         (REAL) strtod(stringptr, &stringptr));
-      }
-#endif /* not TRILIBRARY */
-    }
-
-    if (b->vararea) {
-#ifdef TRILIBRARY
-      area = trianglearealist[elementnumber - b->firstnumber];
-#else /* not TRILIBRARY */
-      /* Read an area constraint from the .area file. */
-      stringptr = readline(inputline, areafile, areafilename);
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        area = -1.0;                      /* No constraint on this triangle. */
-      } else {
-        area = (REAL) strtod(stringptr, &stringptr);
       }
-#endif /* not TRILIBRARY */
-      setareabound(triangleloop, area);
     }
+  }
 
-    /* Set the triangle's vertices. */
-    triangleloop.orient = 0;
-    setorg(triangleloop, getvertex(m, b, corner[0]));
-    setdest(triangleloop, getvertex(m, b, corner[1]));
-    setapex(triangleloop, getvertex(m, b, corner[2]));
-    /* Try linking the triangle to others that share these vertices. */
-    for (triangleloop.orient = 0; triangleloop.orient < 3;
-         triangleloop.orient++) {
-      /* Take the number for the origin of triangleloop. */
-      aroundvertex = corner[triangleloop.orient];
-      /* Look for other triangles having this vertex. */
-      nexttri = vertexarray[aroundvertex - b->firstnumber];
-      /* Link the current triangle to the next one in the stack. */
-      triangleloop.tri[6 + triangleloop.orient] = nexttri;
-      /* Push the current triangle onto the stack. */
-      vertexarray[aroundvertex - b->firstnumber] = encode(triangleloop);
-      decode(nexttri, checktri);
-      if (checktri.tri != m->dummytri) {
-        dest(triangleloop, tdest);
-        apex(triangleloop, tapex);
-        /* Look for other triangles that share an edge. */
-        do {
-          dest(checktri, checkdest);
-          apex(checktri, checkapex);
-          if (tapex == checkdest) {
-            /* The two triangles share an edge; bond them together. */
-            lprev(triangleloop, triangleleft);
-            bond(triangleleft, checktri);
-          }
-          if (tdest == checkapex) {
-            /* The two triangles share an edge; bond them together. */
-            lprev(checktri, checkleft);
-            bond(triangleloop, checkleft);
+  /* Now, we have to find all the regions BEFORE we carve the holes, because */
+  /*   locate() won't work when the triangulation is no longer convex.       */
+  /*   (Incidentally, this is the reason why regional attributes and area    */
+  /*   constraints can't be used when refining a preexisting mesh, which     */
+  /*   might not be convex; they can only be used with a freshly             */
+  /*   triangulated PSLG.)                                                   */
+  if (regions > 0) {
+    /* Find the starting triangle for each region. */
+    for (i = 0; i < regions; i++) {
+      regiontris[i].tri = m->dummytri;
+      /* Ignore region points that aren't within the bounds of the mesh. */
+      if ((regionlist[4 * i] >= m->xmin) && (regionlist[4 * i] <= m->xmax) &&
+          (regionlist[4 * i + 1] >= m->ymin) &&
+          (regionlist[4 * i + 1] <= m->ymax)) {
+        /* Start searching from some triangle on the outer boundary. */
+        searchtri.tri = m->dummytri;
+        searchtri.orient = 0;
+        symself(searchtri);
+        /* Ensure that the region point is to the left of this boundary */
+        /*   edge; otherwise, locate() will falsely report that the     */
+        /*   region point falls within the starting triangle.           */
+        org(searchtri, searchorg);
+        dest(searchtri, searchdest);
+        if (counterclockwise(m, b, searchorg, searchdest, &regionlist[4 * i]) >
+            0.0) {
+          /* Find a triangle that contains the region point. */
+          intersect = locate(m, b, &regionlist[4 * i], &searchtri);
+          if ((intersect != OUTSIDE) && (!infected(searchtri))) {
+            /* Record the triangle for processing after the */
+            /*   holes have been carved.                    */
+            otricopy(searchtri, regiontris[i]);
           }
-          /* Find the next triangle in the stack. */
-          nexttri = checktri.tri[6 + checktri.orient];
-          decode(nexttri, checktri);
-        } while (checktri.tri != m->dummytri);
+        }
       }
-    }
-    triangleloop.tri = triangletraverse(m);
-    elementnumber++;
+    }
   }
 
-#ifdef TRILIBRARY
-  vertexindex = 0;
-#else /* not TRILIBRARY */
-  fclose(elefile);
-  if (b->vararea) {
-    fclose(areafile);
+  if (m->viri.items > 0) {
+    /* Carve the holes and concavities. */
+    plague(m, b);
   }
-#endif /* not TRILIBRARY */
+  /* The virus pool should be empty now. */
 
-  hullsize = 0;                      /* Prepare to count the boundary edges. */
-  if (b->poly) {
-    if (b->verbose) {
-      printf("  Marking segments in triangulation.\n");
-    }
-    /* Read the segments from the .poly file, and link them */
-    /*   to their neighboring triangles.                    */
-    boundmarker = 0;
-    traversalinit(&m->subsegs);
-    subsegloop.ss = subsegtraverse(m);
-    segmentnumber = b->firstnumber;
-    while (subsegloop.ss != (subseg *) NULL) {
-#ifdef TRILIBRARY
-      end[0] = segmentlist[vertexindex++];
-      end[1] = segmentlist[vertexindex++];
-      if (segmentmarkers) {
-        boundmarker = segmentmarkerlist[segmentnumber - b->firstnumber];
-      }
-#else /* not TRILIBRARY */
-      /* Read the endpoints of each segment, and possibly a boundary marker. */
-      stringptr = readline(inputline, polyfile, b->inpolyfilename);
-      /* Skip the first (segment number) field. */
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        printf("Error:  Segment %ld has no endpoints in %s.\n", segmentnumber,
-               polyfilename);
-        triexit(1);
-      } else {
-        end[0] = (int) strtol(stringptr, &stringptr, 0);
-      }
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        printf("Error:  Segment %ld is missing its second endpoint in %s.\n",
-               segmentnumber, polyfilename);
-        triexit(1);
-      } else {
-        end[1] = (int) strtol(stringptr, &stringptr, 0);
-      }
-      if (segmentmarkers) {
-        stringptr = findfield(stringptr);
-        if (*stringptr == '\0') {
-          boundmarker = 0;
+  if (regions > 0) {
+    if (!b->quiet) {
+      if (b->regionattrib) {
+        if (b->vararea) {
+          printf("Spreading regional attributes and area constraints.\n");
         } else {
-          boundmarker = (int) strtol(stringptr, &stringptr, 0);
+          printf("Spreading regional attributes.\n");
         }
+      } else { 
+        printf("Spreading regional area constraints.\n");
       }
-#endif /* not TRILIBRARY */
-      for (j = 0; j < 2; j++) {
-        if ((end[j] < b->firstnumber) ||
-            (end[j] >= b->firstnumber + m->invertices)) {
-          printf("Error:  Segment %ld has an invalid vertex index.\n", 
-                 segmentnumber);
-          triexit(1);
-        }
+    }
+    if (b->regionattrib && !b->refine) {
+      /* Assign every triangle a regional attribute of zero. */
+      traversalinit(&m->triangles);
+      triangleloop.orient = 0;
+      triangleloop.tri = triangletraverse(m);
+      while (triangleloop.tri != (triangle *) NULL) {
+        setelemattribute(triangleloop, m->eextras, 0.0);
+        triangleloop.tri = triangletraverse(m);
       }
-
-      /* set the subsegment's vertices. */
-      subsegloop.ssorient = 0;
-      segmentorg = getvertex(m, b, end[0]);
-      segmentdest = getvertex(m, b, end[1]);
-      setsorg(subsegloop, segmentorg);
-      setsdest(subsegloop, segmentdest);
-      setsegorg(subsegloop, segmentorg);
-      setsegdest(subsegloop, segmentdest);
-      setmark(subsegloop, boundmarker);
-      /* Try linking the subsegment to triangles that share these vertices. */
-      for (subsegloop.ssorient = 0; subsegloop.ssorient < 2;
-           subsegloop.ssorient++) {
-        /* Take the number for the destination of subsegloop. */
-        aroundvertex = end[1 - subsegloop.ssorient];
-        /* Look for triangles having this vertex. */
-        prevlink = &vertexarray[aroundvertex - b->firstnumber];
-        nexttri = vertexarray[aroundvertex - b->firstnumber];
-        decode(nexttri, checktri);
-        sorg(subsegloop, shorg);
-        notfound = 1;
-        /* Look for triangles having this edge.  Note that I'm only       */
-        /*   comparing each triangle's destination with the subsegment;   */
-        /*   each triangle's apex is handled through a different vertex.  */
-        /*   Because each triangle appears on three vertices' lists, each */
-        /*   occurrence of a triangle on a list can (and does) represent  */
-        /*   an edge.  In this way, most edges are represented twice, and */
-        /*   every triangle-subsegment bond is represented once.          */
-        while (notfound && (checktri.tri != m->dummytri)) {
-          dest(checktri, checkdest);
-          if (shorg == checkdest) {
-            /* We have a match.  Remove this triangle from the list. */
-            *prevlink = checktri.tri[6 + checktri.orient];
-            /* Bond the subsegment to the triangle. */
-            tsbond(checktri, subsegloop);
-            /* Check if this is a boundary edge. */
-            sym(checktri, checkneighbor);
-            if (checkneighbor.tri == m->dummytri) {
-              /* The next line doesn't insert a subsegment (because there's */
-              /*   already one there), but it sets the boundary markers of  */
-              /*   the existing subsegment and its vertices.                */
-              insertsubseg(m, b, &checktri, 1);
-              hullsize++;
-            }
-            notfound = 0;
-          }
-          /* Find the next triangle in the stack. */
-          prevlink = &checktri.tri[6 + checktri.orient];
-          nexttri = checktri.tri[6 + checktri.orient];
-          decode(nexttri, checktri);
+    }
+    for (i = 0; i < regions; i++) {
+      if (regiontris[i].tri != m->dummytri) {
+        /* Make sure the triangle under consideration still exists. */
+        /*   It may have been eaten by the virus.                   */
+        if (!deadtri(regiontris[i].tri)) {
+          /* Put one triangle in the virus pool. */
+          infect(regiontris[i]);
+          regiontri = (triangle **) poolalloc(&m->viri);
+          *regiontri = regiontris[i].tri;
+          /* Apply one region's attribute and/or area constraint. */
+          regionplague(m, b, regionlist[4 * i + 2], regionlist[4 * i + 3]);
+          /* The virus pool should be empty now. */
         }
       }
-      subsegloop.ss = subsegtraverse(m);
-      segmentnumber++;
     }
-  }
-
-  /* Mark the remaining edges as not being attached to any subsegment. */
-  /* Also, count the (yet uncounted) boundary edges.                   */
-  for (i = 0; i < m->vertices.items; i++) {
-    /* Search the stack of triangles adjacent to a vertex. */
-    nexttri = vertexarray[i];
-    decode(nexttri, checktri);
-    while (checktri.tri != m->dummytri) {
-      /* Find the next triangle in the stack before this */
-      /*   information gets overwritten.                 */
-      nexttri = checktri.tri[6 + checktri.orient];
-      /* No adjacent subsegment.  (This overwrites the stack info.) */
-      tsdissolve(checktri);
-      sym(checktri, checkneighbor);
-      if (checkneighbor.tri == m->dummytri) {
-        insertsubseg(m, b, &checktri, 1);
-        hullsize++;
-      }
-      decode(nexttri, checktri);
+    if (b->regionattrib && !b->refine) {
+      /* Note the fact that each triangle has an additional attribute. */
+      m->eextras++;
     }
   }
 
-  trifree((VOID *) vertexarray);
-  return hullsize;
+  /* Free up memory. */
+  if (((holes > 0) && !b->noholes) || !b->convex || (regions > 0)) {
+    poolrelease(m, &m->viri);
+  }
+  if (regions > 0) {
+    memfree(&m->memory, (VOID *) regiontris);
+  }
 }
 
-#endif /* not CDT_ONLY */
-
 /**                                                                         **/
 /**                                                                         **/
-/********* General mesh construction routines end here               *********/
+/********* Carving out holes and concavities ends here               *********/
 
-/********* Segment insertion begins here                             *********/
+/********* Mesh quality maintenance begins here                      *********/
 /**                                                                         **/
 /**                                                                         **/
 
 /*****************************************************************************/
 /*                                                                           */
-/*  finddirection()   Find the first triangle on the path from one point     */
-/*                    to another.                                            */
+/*  tallyencs()   Traverse the entire list of subsegments, and check each    */
+/*                to see if it is encroached.  If so, add it to the list.    */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef CDT_ONLY
+
+#ifdef ANSI_DECLARATORS
+void tallyencs(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void tallyencs(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct osub subsegloop;
+  int dummy;
+
+  traversalinit(&m->subsegs);
+  subsegloop.ssorient = 0;
+  subsegloop.ss = subsegtraverse(m);
+  while (subsegloop.ss != (subseg *) NULL) {
+    /* If the segment is encroached, add it to the list. */
+    dummy = checkseg4encroach(m, b, &subsegloop);
+    subsegloop.ss = subsegtraverse(m);
+  }
+}
+
+#endif /* not CDT_ONLY */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  precisionerror()  Print an error message for precision problems.         */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef CDT_ONLY
+
+void precisionerror()
+{
+  printf("Try increasing the area criterion and/or reducing the minimum\n");
+  printf("  allowable angle so that tiny triangles are not created.\n");
+#ifdef SINGLE
+  printf("Alternatively, try recompiling me with double precision\n");
+  printf("  arithmetic (by removing \"#define SINGLE\" from the\n");
+  printf("  source file or \"-DSINGLE\" from the makefile).\n");
+#endif /* SINGLE */
+}
+
+#endif /* not CDT_ONLY */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  budgetleft()   Check whether refinement may insert another Steiner       */
+/*                 point.                                                    */
+/*                                                                           */
+/*  Besides the `S' switch's limit on Steiner points, a workspace can give a */
+/*  call a budget of triangles and of time (see triworkspacebudget()), and   */
+/*  trirefine() a budget of vertices (a workspace call's `S' limit becomes   */
+/*  one too, see triangulatemesh()).  Once it runs out, `steinerleft' is     */
+/*  set to zero, which makes the refinement loops stop just as if the        */
+/*  Steiner points had run out; what it was is kept in `steinerkept', for    */
+/*  trirefine() to go on with.  Only called when there is refining left to   */
+/*  do, so a zero return means the mesh is not finished.  The clock is only  */
+/*  read every 64 Steiner points.                                            */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int budgetleft(struct mesh *m)
+#else /* not ANSI_DECLARATORS */
+int budgetleft(m)
+struct mesh *m;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int spent;
+
+  spent = 0;
+  if ((m->maxtriangles > 0) && (m->triangles.items >= m->maxtriangles)) {
+    spent = 1;
+  }
+  if ((m->maxvertices > 0) && (m->vertices.items >= m->maxvertices)) {
+    spent = 1;
+  }
+#ifdef TRILIBRARY
+  if ((m->deadline > 0) && (m->steinerleft != 0) && !spent) {
+    if (--m->clockcountdown <= 0) {
+      m->clockcountdown = 64;
+      if (triclock() >= m->deadline) {
+        spent = 1;
+      }
+    }
+  }
+#endif /* TRILIBRARY */
+  if (spent && (m->steinerleft != 0)) {
+    m->steinerkept = m->steinerleft;
+    m->steinerleft = 0;
+  }
+  if (m->steinerleft == 0) {
+    m->outofbudget = 1;
+    return 0;
+  }
+  return 1;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  splitencsegs()   Split all the encroached subsegments.                   */
 /*                                                                           */
-/*  Finds the triangle that intersects a line segment drawn from the         */
-/*  origin of `searchtri' to the point `searchpoint', and returns the result */
-/*  in `searchtri'.  The origin of `searchtri' does not change, even though  */
-/*  the triangle returned may differ from the one passed in.  This routine   */
-/*  is used to find the direction to move in to get from one point to        */
-/*  another.                                                                 */
+/*  Each encroached subsegment is repaired by splitting it - inserting a     */
+/*  vertex at or near its midpoint.  Newly inserted vertices may encroach    */
+/*  upon other subsegments; these are also repaired.                         */
 /*                                                                           */
-/*  The return value notes whether the destination or apex of the found      */
-/*  triangle is collinear with the two points in question.                   */
+/*  `triflaws' is a flag that specifies whether one should take note of new  */
+/*  bad triangles that result from inserting vertices to repair encroached   */
+/*  subsegments.                                                             */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef CDT_ONLY
+
 #ifdef ANSI_DECLARATORS
-enum finddirectionresult finddirection(struct mesh *m, struct behavior *b,
-                                       struct otri *searchtri,
-                                       vertex searchpoint)
+void splitencsegs(struct mesh *m, struct behavior *b, int triflaws)
 #else /* not ANSI_DECLARATORS */
-enum finddirectionresult finddirection(m, b, searchtri, searchpoint)
+void splitencsegs(m, b, triflaws)
 struct mesh *m;
 struct behavior *b;
-struct otri *searchtri;
-vertex searchpoint;
+int triflaws;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri checktri;
-  vertex startvertex;
-  vertex leftvertex, rightvertex;
-  REAL leftccw, rightccw;
-  int leftflag, rightflag;
-  triangle ptr;           /* Temporary variable used by onext() and oprev(). */
+  struct otri enctri;
+  struct otri testtri;
+  struct osub testsh;
+  struct osub currentenc;
+  struct badsubseg *encloop;
+  vertex eorg, edest, eapex;
+  vertex newvertex;
+  enum insertvertexresult success;
+  REAL segmentlength, nearestpoweroftwo;
+  REAL split;
+  REAL multiplier, divisor;
+  int acuteorg, acuteorg2, acutedest, acutedest2;
+  int dummy;
+  int i;
+  triangle ptr;                     /* Temporary variable used by stpivot(). */
+  subseg sptr;                        /* Temporary variable used by snext(). */
 
-  org(*searchtri, startvertex);
-  dest(*searchtri, rightvertex);
-  apex(*searchtri, leftvertex);
-  /* Is `searchpoint' to the left? */
-  leftccw = counterclockwise(m, b, searchpoint, startvertex, leftvertex);
-  leftflag = leftccw > 0.0;
-  /* Is `searchpoint' to the right? */
-  rightccw = counterclockwise(m, b, startvertex, searchpoint, rightvertex);
-  rightflag = rightccw > 0.0;
-  if (leftflag && rightflag) {
-    /* `searchtri' faces directly away from `searchpoint'.  We could go left */
-    /*   or right.  Ask whether it's a triangle or a boundary on the left.   */
-    onext(*searchtri, checktri);
-    if (checktri.tri == m->dummytri) {
-      leftflag = 0;
-    } else {
-      rightflag = 0;
-    }
-  }
-  while (leftflag) {
-    /* Turn left until satisfied. */
-    onextself(*searchtri);
-    if (searchtri->tri == m->dummytri) {
-      printf("Internal error in finddirection():  Unable to find a\n");
-      printf("  triangle leading from (%.12g, %.12g) to", startvertex[0],
-             startvertex[1]);
-      printf("  (%.12g, %.12g).\n", searchpoint[0], searchpoint[1]);
-      internalerror();
-    }
-    apex(*searchtri, leftvertex);
-    rightccw = leftccw;
-    leftccw = counterclockwise(m, b, searchpoint, startvertex, leftvertex);
-    leftflag = leftccw > 0.0;
-  }
-  while (rightflag) {
-    /* Turn right until satisfied. */
-    oprevself(*searchtri);
-    if (searchtri->tri == m->dummytri) {
-      printf("Internal error in finddirection():  Unable to find a\n");
-      printf("  triangle leading from (%.12g, %.12g) to", startvertex[0],
-             startvertex[1]);
-      printf("  (%.12g, %.12g).\n", searchpoint[0], searchpoint[1]);
-      internalerror();
+  /* Note that steinerleft == -1 if an unlimited number of Steiner */
+  /*   points is allowed, and that budgetleft() may cut it to zero. */
+  while ((m->badsubsegs.items > 0) && budgetleft(m)) {
+    traversalinit(&m->badsubsegs);
+    encloop = badsubsegtraverse(m);
+    while ((encloop != (struct badsubseg *) NULL) && budgetleft(m)) {
+      sdecode(encloop->encsubseg, currentenc);
+      sorg(currentenc, eorg);
+      sdest(currentenc, edest);
+      /* Make sure that this segment is still the same segment it was   */
+      /*   when it was determined to be encroached.  If the segment was */
+      /*   enqueued multiple times (because several newly inserted      */
+      /*   vertices encroached it), it may have already been split.     */
+      if (!deadsubseg(currentenc.ss) &&
+          (eorg == encloop->subsegorg) && (edest == encloop->subsegdest)) {
+        /* To decide where to split a segment, we need to know if the   */
+        /*   segment shares an endpoint with an adjacent segment.       */
+        /*   The concern is that, if we simply split every encroached   */
+        /*   segment in its center, two adjacent segments with a small  */
+        /*   angle between them might lead to an infinite loop; each    */
+        /*   vertex added to split one segment will encroach upon the   */
+        /*   other segment, which must then be split with a vertex that */
+        /*   will encroach upon the first segment, and so on forever.   */
+        /* To avoid this, imagine a set of concentric circles, whose    */
+        /*   radii are powers of two, about each segment endpoint.      */
+        /*   These concentric circles determine where the segment is    */
+        /*   split.  (If both endpoints are shared with adjacent        */
+        /*   segments, split the segment in the middle, and apply the   */
+        /*   concentric circles for later splittings.)                  */
+
+        /* Is the origin shared with another segment? */
+        stpivot(currentenc, enctri);
+        lnext(enctri, testtri);
+        tspivot(testtri, testsh);
+        acuteorg = testsh.ss != m->dummysub;
+        /* Is the destination shared with another segment? */
+        lnextself(testtri);
+        tspivot(testtri, testsh);
+        acutedest = testsh.ss != m->dummysub;
+
+        /* If we're using Chew's algorithm (rather than Ruppert's) */
+        /*   to define encroachment, delete free vertices from the */
+        /*   subsegment's diametral circle.                        */
+        if (!b->conformdel && !acuteorg && !acutedest) {
+          apex(enctri, eapex);
+          while ((vertextype(eapex) == FREEVERTEX) &&
+                 ((eorg[0] - eapex[0]) * (edest[0] - eapex[0]) +
+                  (eorg[1] - eapex[1]) * (edest[1] - eapex[1]) < 0.0)) {
+            deletevertex(m, b, &testtri);
+            stpivot(currentenc, enctri);
+            apex(enctri, eapex);
+            lprev(enctri, testtri);
+          }
+        }
+
+        /* Now, check the other side of the segment, if there's a triangle */
+        /*   there.                                                        */
+        sym(enctri, testtri);
+        if (testtri.tri != m->dummytri) {
+          /* Is the destination shared with another segment? */
+          lnextself(testtri);
+          tspivot(testtri, testsh);
+          acutedest2 = testsh.ss != m->dummysub;
+          acutedest = acutedest || acutedest2;
+          /* Is the origin shared with another segment? */
+          lnextself(testtri);
+          tspivot(testtri, testsh);
+          acuteorg2 = testsh.ss != m->dummysub;
+          acuteorg = acuteorg || acuteorg2;
+
+          /* Delete free vertices from the subsegment's diametral circle. */
+          if (!b->conformdel && !acuteorg2 && !acutedest2) {
+            org(testtri, eapex);
+            while ((vertextype(eapex) == FREEVERTEX) &&
+                   ((eorg[0] - eapex[0]) * (edest[0] - eapex[0]) +
+                    (eorg[1] - eapex[1]) * (edest[1] - eapex[1]) < 0.0)) {
+              deletevertex(m, b, &testtri);
+              sym(enctri, testtri);
+              apex(testtri, eapex);
+              lprevself(testtri);
+            }
+          }
+        }
+
+        /* Use the concentric circles if exactly one endpoint is shared */
+        /*   with another adjacent segment.                             */
+        if (acuteorg || acutedest) {
+          segmentlength = sqrt((edest[0] - eorg[0]) * (edest[0] - eorg[0]) +
+                               (edest[1] - eorg[1]) * (edest[1] - eorg[1]));
+          /* Find the power of two that most evenly splits the segment.  */
+          /*   The worst case is a 2:1 ratio between subsegment lengths. */
+          nearestpoweroftwo = 1.0;
+          while (segmentlength > 3.0 * nearestpoweroftwo) {
+            nearestpoweroftwo *= 2.0;
+          }
+          while (segmentlength < 1.5 * nearestpoweroftwo) {
+            nearestpoweroftwo *= 0.5;
+          }
+          /* Where do we split the segment? */
+          split = nearestpoweroftwo / segmentlength;
+          if (acutedest) {
+            split = 1.0 - split;
+          }
+        } else {
+          /* If we're not worried about adjacent segments, split */
+          /*   this segment in the middle.                       */
+          split = 0.5;
+        }
+
+        /* Create the new vertex. */
+        newvertex = (vertex) poolalloc(&m->vertices);
+        /* Interpolate its coordinate and attributes. */
+        for (i = 0; i < 2 + m->nextras; i++) {
+          newvertex[i] = eorg[i] + split * (edest[i] - eorg[i]);
+        }
+
+        if (!b->noexact) {
+          /* Roundoff in the above calculation may yield a `newvertex'   */
+          /*   that is not precisely collinear with `eorg' and `edest'.  */
+          /*   Improve collinearity by one step of iterative refinement. */
+          multiplier = counterclockwise(m, b, eorg, edest, newvertex);
+          divisor = ((eorg[0] - edest[0]) * (eorg[0] - edest[0]) +
+                     (eorg[1] - edest[1]) * (eorg[1] - edest[1]));
+          if ((multiplier != 0.0) && (divisor != 0.0)) {
+            multiplier = multiplier / divisor;
+            /* Watch out for NANs. */
+            if (multiplier == multiplier) {
+              newvertex[0] += multiplier * (edest[1] - eorg[1]);
+              newvertex[1] += multiplier * (eorg[0] - edest[0]);
+            }
+          }
+        }
+
+        setvertexmark(newvertex, mark(currentenc));
+        setvertextype(newvertex, SEGMENTVERTEX);
+        if (b->verbose > 1) {
+          printf(
+  "  Splitting subsegment (%.12g, %.12g) (%.12g, %.12g) at (%.12g, %.12g).\n",
+                 eorg[0], eorg[1], edest[0], edest[1],
+                 newvertex[0], newvertex[1]);
+        }
+        /* Check whether the new vertex lies on an endpoint. */
+        if (((newvertex[0] == eorg[0]) && (newvertex[1] == eorg[1])) ||
+            ((newvertex[0] == edest[0]) && (newvertex[1] == edest[1]))) {
+          printf("Error:  Ran out of precision at (%.12g, %.12g).\n",
+                 newvertex[0], newvertex[1]);
+          printf("I attempted to split a segment to a smaller size than\n");
+          printf("  can be accommodated by the finite precision of\n");
+          printf("  floating point arithmetic.\n");
+          precisionerror();
+          triexit(1);
+        }
+        /* Insert the splitting vertex.  This should always succeed. */
+        success = insertvertex(m, b, newvertex, &enctri, &currentenc,
+                               1, triflaws);
+        if ((success != SUCCESSFULVERTEX) && (success != ENCROACHINGVERTEX)) {
+          printf("Internal error in splitencsegs():\n");
+          printf("  Failure to split a segment.\n");
+          internalerror();
+        }
+        if (m->steinerleft > 0) {
+          m->steinerleft--;
+        }
+        /* Check the two new subsegments to see if they're encroached. */
+        dummy = checkseg4encroach(m, b, &currentenc);
+        snextself(currentenc);
+        dummy = checkseg4encroach(m, b, &currentenc);
+      }
+
+      badsubsegdealloc(m, encloop);
+      encloop = badsubsegtraverse(m);
     }
-    dest(*searchtri, rightvertex);
-    leftccw = rightccw;
-    rightccw = counterclockwise(m, b, startvertex, searchpoint, rightvertex);
-    rightflag = rightccw > 0.0;
-  }
-  if (leftccw == 0.0) {
-    return LEFTCOLLINEAR;
-  } else if (rightccw == 0.0) {
-    return RIGHTCOLLINEAR;
-  } else {
-    return WITHIN;
   }
 }
 
+#endif /* not CDT_ONLY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  segmentintersection()   Find the intersection of an existing segment     */
-/*                          and a segment that is being inserted.  Insert    */
-/*                          a vertex at the intersection, splitting an       */
-/*                          existing subsegment.                             */
+/*  tallyfaces()   Test every triangle in the mesh for quality measures.     */
 /*                                                                           */
-/*  The segment being inserted connects the apex of splittri to endpoint2.   */
-/*  splitsubseg is the subsegment being split, and MUST adjoin splittri.     */
-/*  Hence, endpoints of the subsegment being split are the origin and        */
-/*  destination of splittri.                                                 */
+/*****************************************************************************/
+
+#ifndef CDT_ONLY
+
+#ifdef ANSI_DECLARATORS
+void tallyfaces(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void tallyfaces(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct otri triangleloop;
+
+  if (b->verbose) {
+    printf("  Making a list of bad triangles.\n");
+  }
+  traversalinit(&m->triangles);
+  triangleloop.orient = 0;
+  triangleloop.tri = triangletraverse(m);
+  while (triangleloop.tri != (triangle *) NULL) {
+    /* If the triangle is bad, enqueue it. */
+    testtriangle(m, b, &triangleloop);
+    triangleloop.tri = triangletraverse(m);
+  }
+}
+
+#endif /* not CDT_ONLY */
+
+/*****************************************************************************/
 /*                                                                           */
-/*  On completion, splittri is a handle having the newly inserted            */
-/*  intersection point as its origin, and endpoint1 as its destination.      */
+/*  splittriangle()   Inserts a vertex at the circumcenter of a triangle.    */
+/*                    Deletes the newly inserted vertex if it encroaches     */
+/*                    upon a segment.                                        */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef CDT_ONLY
+
 #ifdef ANSI_DECLARATORS
-void segmentintersection(struct mesh *m, struct behavior *b,
-                         struct otri *splittri, struct osub *splitsubseg,
-                         vertex endpoint2)
+void splittriangle(struct mesh *m, struct behavior *b,
+                   struct badtriang *badtri)
 #else /* not ANSI_DECLARATORS */
-void segmentintersection(m, b, splittri, splitsubseg, endpoint2)
+void splittriangle(m, b, badtri)
 struct mesh *m;
 struct behavior *b;
-struct otri *splittri;
-struct osub *splitsubseg;
-vertex endpoint2;
+struct badtriang *badtri;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct osub opposubseg;
-  vertex endpoint1;
-  vertex torg, tdest;
-  vertex leftvertex, rightvertex;
+  struct otri badotri;
+  vertex borg, bdest, bapex;
   vertex newvertex;
+  REAL xi, eta;
   enum insertvertexresult success;
-  enum finddirectionresult collinear;
-  REAL ex, ey;
-  REAL tx, ty;
-  REAL etx, ety;
-  REAL split, denom;
+  int errorflag;
   int i;
-  triangle ptr;                       /* Temporary variable used by onext(). */
-  subseg sptr;                        /* Temporary variable used by snext(). */
 
-  /* Find the other three segment endpoints. */
-  apex(*splittri, endpoint1);
-  org(*splittri, torg);
-  dest(*splittri, tdest);
-  /* Segment intersection formulae; see the Antonio reference. */
-  tx = tdest[0] - torg[0];
-  ty = tdest[1] - torg[1];
-  ex = endpoint2[0] - endpoint1[0];
-  ey = endpoint2[1] - endpoint1[1];
-  etx = torg[0] - endpoint2[0];
-  ety = torg[1] - endpoint2[1];
-  denom = ty * ex - tx * ey;
-  if (denom == 0.0) {
-    printf("Internal error in segmentintersection():");
-    printf("  Attempt to find intersection of parallel segments.\n");
-    internalerror();
-  }
-  split = (ey * etx - ex * ety) / denom;
-  /* Create the new vertex. */
-  newvertex = (vertex) poolalloc(&m->vertices);
-  /* Interpolate its coordinate and attributes. */
-  for (i = 0; i < 2 + m->nextras; i++) {
-    newvertex[i] = torg[i] + split * (tdest[i] - torg[i]);
-  }
-  setvertexmark(newvertex, mark(*splitsubseg));
-  setvertextype(newvertex, INPUTVERTEX);
-  if (b->verbose > 1) {
-    printf(
-  "  Splitting subsegment (%.12g, %.12g) (%.12g, %.12g) at (%.12g, %.12g).\n",
-           torg[0], torg[1], tdest[0], tdest[1], newvertex[0], newvertex[1]);
-  }
-  /* Insert the intersection vertex.  This should always succeed. */
-  success = insertvertex(m, b, newvertex, splittri, splitsubseg, 0, 0);
-  if (success != SUCCESSFULVERTEX) {
-    printf("Internal error in segmentintersection():\n");
-    printf("  Failure to split a segment.\n");
-    internalerror();
-  }
-  /* Record a triangle whose origin is the new vertex. */
-  setvertex2tri(newvertex, encode(*splittri));
-  if (m->steinerleft > 0) {
-    m->steinerleft--;
-  }
+  decode(badtri->poortri, badotri);
+  org(badotri, borg);
+  dest(badotri, bdest);
+  apex(badotri, bapex);
+  /* Make sure that this triangle is still the same triangle it was      */
+  /*   when it was tested and determined to be of bad quality.           */
+  /*   Subsequent transformations may have made it a different triangle. */
+  if (!deadtri(badotri.tri) && (borg == badtri->triangorg) &&
+      (bdest == badtri->triangdest) && (bapex == badtri->triangapex)) {
+    if (b->verbose > 1) {
+      printf("  Splitting this triangle at its circumcenter:\n");
+      printf("    (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n", borg[0],
+             borg[1], bdest[0], bdest[1], bapex[0], bapex[1]);
+    }
 
-  /* Divide the segment into two, and correct the segment endpoints. */
-  ssymself(*splitsubseg);
-  spivot(*splitsubseg, opposubseg);
-  sdissolve(*splitsubseg);
-  sdissolve(opposubseg);
-  do {
-    setsegorg(*splitsubseg, newvertex);
-    snextself(*splitsubseg);
-  } while (splitsubseg->ss != m->dummysub);
-  do {
-    setsegorg(opposubseg, newvertex);
-    snextself(opposubseg);
-  } while (opposubseg.ss != m->dummysub);
+    errorflag = 0;
+    /* Create a new vertex at the triangle's circumcenter. */
+    newvertex = (vertex) poolalloc(&m->vertices);
+    findcircumcenter(m, b, borg, bdest, bapex, newvertex, &xi, &eta, 1);
 
-  /* Inserting the vertex may have caused edge flips.  We wish to rediscover */
-  /*   the edge connecting endpoint1 to the new intersection vertex.         */
-  collinear = finddirection(m, b, splittri, endpoint1);
-  dest(*splittri, rightvertex);
-  apex(*splittri, leftvertex);
-  if ((leftvertex[0] == endpoint1[0]) && (leftvertex[1] == endpoint1[1])) {
-    onextself(*splittri);
-  } else if ((rightvertex[0] != endpoint1[0]) ||
-             (rightvertex[1] != endpoint1[1])) {
-    printf("Internal error in segmentintersection():\n");
-    printf("  Topological inconsistency after splitting a segment.\n");
-    internalerror();
+    /* Check whether the new vertex lies on a triangle vertex. */
+    if (((newvertex[0] == borg[0]) && (newvertex[1] == borg[1])) ||
+        ((newvertex[0] == bdest[0]) && (newvertex[1] == bdest[1])) ||
+        ((newvertex[0] == bapex[0]) && (newvertex[1] == bapex[1]))) {
+      if (!b->quiet) {
+        printf(
+             "Warning:  New vertex (%.12g, %.12g) falls on existing vertex.\n",
+               newvertex[0], newvertex[1]);
+        errorflag = 1;
+      }
+      vertexdealloc(m, newvertex);
+    } else {
+      for (i = 2; i < 2 + m->nextras; i++) {
+        /* Interpolate the vertex attributes at the circumcenter. */
+        newvertex[i] = borg[i] + xi * (bdest[i] - borg[i])
+                              + eta * (bapex[i] - borg[i]);
+      }
+      /* The new vertex must be in the interior, and therefore is a */
+      /*   free vertex with a marker of zero.                       */
+      setvertexmark(newvertex, 0);
+      setvertextype(newvertex, FREEVERTEX);
+
+      /* Ensure that the handle `badotri' does not represent the longest  */
+      /*   edge of the triangle.  This ensures that the circumcenter must */
+      /*   fall to the left of this edge, so point location will work.    */
+      /*   (If the angle org-apex-dest exceeds 90 degrees, then the       */
+      /*   circumcenter lies outside the org-dest edge, and eta is        */
+      /*   negative.  Roundoff error might prevent eta from being         */
+      /*   negative when it should be, so I test eta against xi.)         */
+      if (eta < xi) {
+        lprevself(badotri);
+      }
+
+      /* Insert the circumcenter, searching from the edge of the triangle, */
+      /*   and maintain the Delaunay property of the triangulation.        */
+      success = insertvertex(m, b, newvertex, &badotri, (struct osub *) NULL,
+                             1, 1);
+      if (success == SUCCESSFULVERTEX) {
+        if (m->steinerleft > 0) {
+          m->steinerleft--;
+        }
+      } else if (success == ENCROACHINGVERTEX) {
+        /* If the newly inserted vertex encroaches upon a subsegment, */
+        /*   delete the new vertex.                                   */
+        undovertex(m, b);
+        if (b->verbose > 1) {
+          printf("  Rejecting (%.12g, %.12g).\n", newvertex[0], newvertex[1]);
+        }
+        vertexdealloc(m, newvertex);
+      } else if (success == VIOLATINGVERTEX) {
+        /* Failed to insert the new vertex, but some subsegment was */
+        /*   marked as being encroached.                            */
+        vertexdealloc(m, newvertex);
+      } else {                                 /* success == DUPLICATEVERTEX */
+        /* Couldn't insert the new vertex because a vertex is already there. */
+        if (!b->quiet) {
+          printf(
+            "Warning:  New vertex (%.12g, %.12g) falls on existing vertex.\n",
+                 newvertex[0], newvertex[1]);
+          errorflag = 1;
+        }
+        vertexdealloc(m, newvertex);
+      }
+    }
+    if (errorflag) {
+      if (b->verbose) {
+        printf("  The new vertex is at the circumcenter of triangle\n");
+        printf("    (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
+               borg[0], borg[1], bdest[0], bdest[1], bapex[0], bapex[1]);
+      }
+      printf("This probably means that I am trying to refine triangles\n");
+      printf("  to a smaller size than can be accommodated by the finite\n");
+      printf("  precision of floating point arithmetic.  (You can be\n");
+      printf("  sure of this if I fail to terminate.)\n");
+      precisionerror();
+    }
   }
-  /* `splittri' should have destination endpoint1. */
 }
 
+#endif /* not CDT_ONLY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  scoutsegment()   Scout the first triangle on the path from one endpoint  */
-/*                   to another, and check for completion (reaching the      */
-/*                   second endpoint), a collinear vertex, or the            */
-/*                   intersection of two segments.                           */
-/*                                                                           */
-/*  Returns one if the entire segment is successfully inserted, and zero if  */
-/*  the job must be finished by conformingedge() or constrainededge().       */
-/*                                                                           */
-/*  If the first triangle on the path has the second endpoint as its         */
-/*  destination or apex, a subsegment is inserted and the job is done.       */
-/*                                                                           */
-/*  If the first triangle on the path has a destination or apex that lies on */
-/*  the segment, a subsegment is inserted connecting the first endpoint to   */
-/*  the collinear vertex, and the search is continued from the collinear     */
-/*  vertex.                                                                  */
-/*                                                                           */
-/*  If the first triangle on the path has a subsegment opposite its origin,  */
-/*  then there is a segment that intersects the segment being inserted.      */
-/*  Their intersection vertex is inserted, splitting the subsegment.         */
+/*  splitbadtriangles()   Split the queued bad triangles, and whatever       */
+/*                        subsegments that encroaches upon, until none are   */
+/*                        left or the budget runs out.                       */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef CDT_ONLY
+
 #ifdef ANSI_DECLARATORS
-int scoutsegment(struct mesh *m, struct behavior *b, struct otri *searchtri,
-                 vertex endpoint2, int newmark)
+void splitbadtriangles(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-int scoutsegment(m, b, searchtri, endpoint2, newmark)
+void splitbadtriangles(m, b)
 struct mesh *m;
 struct behavior *b;
-struct otri *searchtri;
-vertex endpoint2;
-int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri crosstri;
-  struct osub crosssubseg;
-  vertex leftvertex, rightvertex;
-  enum finddirectionresult collinear;
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+  struct badtriang *badtri;
 
-  collinear = finddirection(m, b, searchtri, endpoint2);
-  dest(*searchtri, rightvertex);
-  apex(*searchtri, leftvertex);
-  if (((leftvertex[0] == endpoint2[0]) && (leftvertex[1] == endpoint2[1])) ||
-      ((rightvertex[0] == endpoint2[0]) && (rightvertex[1] == endpoint2[1]))) {
-    /* The segment is already an edge in the mesh. */
-    if ((leftvertex[0] == endpoint2[0]) && (leftvertex[1] == endpoint2[1])) {
-      lprevself(*searchtri);
-    }
-    /* Insert a subsegment, if there isn't already one there. */
-    insertsubseg(m, b, searchtri, newmark);
-    return 1;
-  } else if (collinear == LEFTCOLLINEAR) {
-    /* We've collided with a vertex between the segment's endpoints. */
-    /* Make the collinear vertex be the triangle's origin. */
-    lprevself(*searchtri);
-    insertsubseg(m, b, searchtri, newmark);
-    /* Insert the remainder of the segment. */
-    return scoutsegment(m, b, searchtri, endpoint2, newmark);
-  } else if (collinear == RIGHTCOLLINEAR) {
-    /* We've collided with a vertex between the segment's endpoints. */
-    insertsubseg(m, b, searchtri, newmark);
-    /* Make the collinear vertex be the triangle's origin. */
-    lnextself(*searchtri);
-    /* Insert the remainder of the segment. */
-    return scoutsegment(m, b, searchtri, endpoint2, newmark);
-  } else {
-    lnext(*searchtri, crosstri);
-    tspivot(crosstri, crosssubseg);
-    /* Check for a crossing segment. */
-    if (crosssubseg.ss == m->dummysub) {
-      return 0;
+  while ((m->badtriangles.items > 0) && budgetleft(m)) {
+    /* Fix one bad triangle by inserting a vertex at its circumcenter. */
+    badtri = dequeuebadtriang(m);
+    splittriangle(m, b, badtri);
+    if (m->badsubsegs.items > 0) {
+      /* Put bad triangle back in queue for another try later. */
+      enqueuebadtriang(m, b, badtri);
+      /* Fix any encroached subsegments that resulted. */
+      /*   Record any new bad triangles that result.   */
+      splitencsegs(m, b, 1);
     } else {
-      /* Insert a vertex at the intersection. */
-      segmentintersection(m, b, &crosstri, &crosssubseg, endpoint2);
-      otricopy(crosstri, *searchtri);
-      insertsubseg(m, b, searchtri, newmark);
-      /* Insert the remainder of the segment. */
-      return scoutsegment(m, b, searchtri, endpoint2, newmark);
+      /* Return the bad triangle to the pool. */
+      pooldealloc(&m->badtriangles, (VOID *) badtri);
     }
   }
 }
 
+#endif /* not CDT_ONLY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  conformingedge()   Force a segment into a conforming Delaunay            */
-/*                     triangulation by inserting a vertex at its midpoint,  */
-/*                     and recursively forcing in the two half-segments if   */
-/*                     necessary.                                            */
-/*                                                                           */
-/*  Generates a sequence of subsegments connecting `endpoint1' to            */
-/*  `endpoint2'.  `newmark' is the boundary marker of the segment, assigned  */
-/*  to each new splitting vertex and subsegment.                             */
-/*                                                                           */
-/*  Note that conformingedge() does not always maintain the conforming       */
-/*  Delaunay property.  Once inserted, segments are locked into place;       */
-/*  vertices inserted later (to force other segments in) may render these    */
-/*  fixed segments non-Delaunay.  The conforming Delaunay property will be   */
-/*  restored by enforcequality() by splitting encroached subsegments.        */
+/*  enforcequality()   Remove all the encroached subsegments and bad         */
+/*                     triangles from the triangulation.                     */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef REDUCED
 #ifndef CDT_ONLY
 
 #ifdef ANSI_DECLARATORS
-void conformingedge(struct mesh *m, struct behavior *b,
-                    vertex endpoint1, vertex endpoint2, int newmark)
+void enforcequality(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void conformingedge(m, b, endpoint1, endpoint2, newmark)
+void enforcequality(m, b)
 struct mesh *m;
 struct behavior *b;
-vertex endpoint1;
-vertex endpoint2;
-int newmark;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri searchtri1, searchtri2;
-  struct osub brokensubseg;
-  vertex newvertex;
-  vertex midvertex1, midvertex2;
-  enum insertvertexresult success;
   int i;
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  if (b->verbose > 2) {
-    printf("Forcing segment into triangulation by recursive splitting:\n");
-    printf("  (%.12g, %.12g) (%.12g, %.12g)\n", endpoint1[0], endpoint1[1],
-           endpoint2[0], endpoint2[1]);
+  if (!b->quiet) {
+    printf("Adding Steiner points to enforce quality.\n");
   }
-  /* Create a new vertex to insert in the middle of the segment. */
-  newvertex = (vertex) poolalloc(&m->vertices);
-  /* Interpolate coordinates and attributes. */
-  for (i = 0; i < 2 + m->nextras; i++) {
-    newvertex[i] = 0.5 * (endpoint1[i] + endpoint2[i]);
+  /* Initialize the pool of encroached subsegments. */
+  poolprepare(m, &m->badsubsegs, sizeof(struct badsubseg), BADSUBSEGPERBLOCK,
+              BADSUBSEGPERBLOCK, 0);
+  if (b->verbose) {
+    printf("  Looking for encroached subsegments.\n");
   }
-  setvertexmark(newvertex, newmark);
-  setvertextype(newvertex, SEGMENTVERTEX);
-  /* No known triangle to search from. */
-  searchtri1.tri = m->dummytri;
-  /* Attempt to insert the new vertex. */
-  success = insertvertex(m, b, newvertex, &searchtri1, (struct osub *) NULL,
-                         0, 0);
-  if (success == DUPLICATEVERTEX) {
-    if (b->verbose > 2) {
-      printf("  Segment intersects existing vertex (%.12g, %.12g).\n",
-             newvertex[0], newvertex[1]);
-    }
-    /* Use the vertex that's already there. */
-    vertexdealloc(m, newvertex);
-    org(searchtri1, newvertex);
-  } else {
-    if (success == VIOLATINGVERTEX) {
-      if (b->verbose > 2) {
-        printf("  Two segments intersect at (%.12g, %.12g).\n",
-               newvertex[0], newvertex[1]);
-      }
-      /* By fluke, we've landed right on another segment.  Split it. */
-      tspivot(searchtri1, brokensubseg);
-      success = insertvertex(m, b, newvertex, &searchtri1, &brokensubseg,
-                             0, 0);
-      if (success != SUCCESSFULVERTEX) {
-        printf("Internal error in conformingedge():\n");
-        printf("  Failure to split a segment.\n");
-        internalerror();
-      }
+  /* Test all segments to see if they're encroached. */
+  tallyencs(m, b);
+  if (b->verbose && (m->badsubsegs.items > 0)) {
+    printf("  Splitting encroached subsegments.\n");
+  }
+  /* Fix encroached subsegments without noting bad triangles. */
+  splitencsegs(m, b, 0);
+  /* At this point, if we haven't run out of Steiner points, the */
+  /*   triangulation should be (conforming) Delaunay.            */
+
+  /* Next, we worry about enforcing triangle quality. */
+  if ((b->minangle > 0.0) || b->vararea || b->fixedarea || b->usertest) {
+    /* Initialize the pool of bad triangles. */
+    poolprepare(m, &m->badtriangles, sizeof(struct badtriang), BADTRIPERBLOCK,
+                BADTRIPERBLOCK, 0);
+    /* Initialize the queues of bad triangles. */
+    for (i = 0; i < 4096; i++) {
+      m->queuefront[i] = (struct badtriang *) NULL;
     }
-    /* The vertex has been inserted successfully. */
-    if (m->steinerleft > 0) {
-      m->steinerleft--;
+    m->firstnonemptyq = -1;
+    /* Test all triangles to see if they're bad. */
+    tallyfaces(m, b);
+    /* Initialize the pool of recently flipped triangles. */
+    poolprepare(m, &m->flipstackers, sizeof(struct flipstacker),
+                FLIPSTACKERPERBLOCK, FLIPSTACKERPERBLOCK, 0);
+    m->checkquality = 1;
+    if (b->verbose) {
+      printf("  Splitting bad triangles.\n");
     }
+    splitbadtriangles(m, b);
   }
-  otricopy(searchtri1, searchtri2);
-  /* `searchtri1' and `searchtri2' are fastened at their origins to         */
-  /*   `newvertex', and will be directed toward `endpoint1' and `endpoint2' */
-  /*   respectively.  First, we must get `searchtri2' out of the way so it  */
-  /*   won't be invalidated during the insertion of the first half of the   */
-  /*   segment.                                                             */
-  finddirection(m, b, &searchtri2, endpoint2);
-  if (!scoutsegment(m, b, &searchtri1, endpoint1, newmark)) {
-    /* The origin of searchtri1 may have changed if a collision with an */
-    /*   intervening vertex on the segment occurred.                    */
-    org(searchtri1, midvertex1);
-    conformingedge(m, b, midvertex1, endpoint1, newmark);
-  }
-  if (!scoutsegment(m, b, &searchtri2, endpoint2, newmark)) {
-    /* The origin of searchtri2 may have changed if a collision with an */
-    /*   intervening vertex on the segment occurred.                    */
-    org(searchtri2, midvertex2);
-    conformingedge(m, b, midvertex2, endpoint2, newmark);
+  /* At this point, if the "-D" switch was selected and we haven't run out  */
+  /*   of Steiner points, the triangulation should be (conforming) Delaunay */
+  /*   and have no low-quality triangles.                                   */
+
+  /* Might we have run out of Steiner points too soon? */
+  if (!b->quiet && b->conformdel && (m->badsubsegs.items > 0) &&
+      (m->steinerleft == 0)) {
+    printf("\nWarning:  I ran out of Steiner points, but the mesh has\n");
+    if (m->badsubsegs.items == 1) {
+      printf("  one encroached subsegment, and therefore might not be truly\n"
+             );
+    } else {
+      printf("  %ld encroached subsegments, and therefore might not be truly\n"
+             , m->badsubsegs.items);
+    }
+    printf("  Delaunay.  If the Delaunay property is important to you,\n");
+    printf("  try increasing the number of Steiner points (controlled by\n");
+    printf("  the -S switch) slightly and try again.\n\n");
   }
 }
 
 #endif /* not CDT_ONLY */
-#endif /* not REDUCED */
 
 /*****************************************************************************/
 /*                                                                           */
-/*  delaunayfixup()   Enforce the Delaunay condition at an edge, fanning out */
-/*                    recursively from an existing vertex.  Pay special      */
-/*                    attention to stacking inverted triangles.              */
-/*                                                                           */
-/*  This is a support routine for inserting segments into a constrained      */
-/*  Delaunay triangulation.                                                  */
-/*                                                                           */
-/*  The origin of fixuptri is treated as if it has just been inserted, and   */
-/*  the local Delaunay condition needs to be enforced.  It is only enforced  */
-/*  in one sector, however, that being the angular range defined by          */
-/*  fixuptri.                                                                */
-/*                                                                           */
-/*  This routine also needs to make decisions regarding the "stacking" of    */
-/*  triangles.  (Read the description of constrainededge() below before      */
-/*  reading on here, so you understand the algorithm.)  If the position of   */
-/*  the new vertex (the origin of fixuptri) indicates that the vertex before */
-/*  it on the polygon is a reflex vertex, then "stack" the triangle by       */
-/*  doing nothing.  (fixuptri is an inverted triangle, which is how stacked  */
-/*  triangles are identified.)                                               */
+/*  resumequality()   Go on with enforcequality() after the budget stopped   */
+/*                    it.                                                    */
 /*                                                                           */
-/*  Otherwise, check whether the vertex before that was a reflex vertex.     */
-/*  If so, perform an edge flip, thereby eliminating an inverted triangle    */
-/*  (popping it off the stack).  The edge flip may result in the creation    */
-/*  of a new inverted triangle, depending on whether or not the new vertex   */
-/*  is visible to the vertex three edges behind on the polygon.              */
+/*  The mesh, the encroached subsegments and the queues of bad triangles     */
+/*  must be just as enforcequality() left them.  If it had got as far as     */
+/*  testing the triangles, splitting a subsegment now may make new bad       */
+/*  triangles, and they are queued too.                                      */
 /*                                                                           */
-/*  If neither of the two vertices behind the new vertex are reflex          */
-/*  vertices, fixuptri and fartri, the triangle opposite it, are not         */
-/*  inverted; hence, ensure that the edge between them is locally Delaunay.  */
+/*****************************************************************************/
+
+#ifndef CDT_ONLY
+
+#ifdef ANSI_DECLARATORS
+void resumequality(struct mesh *m, struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void resumequality(m, b)
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  splitencsegs(m, b, m->checkquality);
+  if (m->checkquality) {
+    splitbadtriangles(m, b);
+  }
+}
+
+#endif /* not CDT_ONLY */
+
+/**                                                                         **/
+/**                                                                         **/
+/********* Mesh quality maintenance ends here                        *********/
+
+/*****************************************************************************/
 /*                                                                           */
-/*  `leftside' indicates whether or not fixuptri is to the left of the       */
-/*  segment being inserted.  (Imagine that the segment is pointing up from   */
-/*  endpoint1 to endpoint2.)                                                 */
+/*  highorder()   Create extra nodes for quadratic subparametric elements.   */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void delaunayfixup(struct mesh *m, struct behavior *b,
-                   struct otri *fixuptri, int leftside)
+void highorder(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void delaunayfixup(m, b, fixuptri, leftside)
+void highorder(m, b)
 struct mesh *m;
 struct behavior *b;
-struct otri *fixuptri;
-int leftside;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri neartri;
-  struct otri fartri;
-  struct osub faredge;
-  vertex nearvertex, leftvertex, rightvertex, farvertex;
+  struct otri triangleloop, trisym;
+  struct osub checkmark;
+  vertex newvertex;
+  vertex torg, tdest;
+  int i;
   triangle ptr;                         /* Temporary variable used by sym(). */
   subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  lnext(*fixuptri, neartri);
-  sym(neartri, fartri);
-  /* Check if the edge opposite the origin of fixuptri can be flipped. */
-  if (fartri.tri == m->dummytri) {
-    return;
-  }
-  tspivot(neartri, faredge);
-  if (faredge.ss != m->dummysub) {
-    return;
+  if (!b->quiet) {
+    printf("Adding vertices for second-order triangles.\n");
   }
-  /* Find all the relevant vertices. */
-  apex(neartri, nearvertex);
-  org(neartri, leftvertex);
-  dest(neartri, rightvertex);
-  apex(fartri, farvertex);
-  /* Check whether the previous polygon vertex is a reflex vertex. */
-  if (leftside) {
-    if (counterclockwise(m, b, nearvertex, leftvertex, farvertex) <= 0.0) {
-      /* leftvertex is a reflex vertex too.  Nothing can */
-      /*   be done until a convex section is found.      */
-      return;
-    }
-  } else {
-    if (counterclockwise(m, b, farvertex, rightvertex, nearvertex) <= 0.0) {
-      /* rightvertex is a reflex vertex too.  Nothing can */
-      /*   be done until a convex section is found.       */
-      return;
+  /* The following line ensures that dead items in the pool of nodes    */
+  /*   cannot be allocated for the extra nodes associated with high     */
+  /*   order elements.  This ensures that the primary nodes (at the     */
+  /*   corners of elements) will occur earlier in the output files, and */
+  /*   have lower indices, than the extra nodes.                        */
+  m->vertices.deaditemstack = (VOID *) NULL;
+
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  /* To loop over the set of edges, loop over all triangles, and look at   */
+  /*   the three edges of each triangle.  If there isn't another triangle  */
+  /*   adjacent to the edge, operate on the edge.  If there is another     */
+  /*   adjacent triangle, operate on the edge only if the current triangle */
+  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
+  /*   considered only once.                                               */
+  while (triangleloop.tri != (triangle *) NULL) {
+    for (triangleloop.orient = 0; triangleloop.orient < 3;
+         triangleloop.orient++) {
+      sym(triangleloop, trisym);
+      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+        org(triangleloop, torg);
+        dest(triangleloop, tdest);
+        /* Create a new node in the middle of the edge.  Interpolate */
+        /*   its attributes.                                         */
+        newvertex = (vertex) poolalloc(&m->vertices);
+        for (i = 0; i < 2 + m->nextras; i++) {
+          newvertex[i] = 0.5 * (torg[i] + tdest[i]);
+        }
+        /* Set the new node's marker to zero or one, depending on */
+        /*   whether it lies on a boundary.                       */
+        setvertexmark(newvertex, trisym.tri == m->dummytri);
+        setvertextype(newvertex,
+                      trisym.tri == m->dummytri ? FREEVERTEX : SEGMENTVERTEX);
+        if (b->usesegments) {
+          tspivot(triangleloop, checkmark);
+          /* If this edge is a segment, transfer the marker to the new node. */
+          if (checkmark.ss != m->dummysub) {
+            setvertexmark(newvertex, mark(checkmark));
+            setvertextype(newvertex, SEGMENTVERTEX);
+          }
+        }
+        if (b->verbose > 1) {
+          printf("  Creating (%.12g, %.12g).\n", newvertex[0], newvertex[1]);
+        }
+        /* Record the new node in the (one or two) adjacent elements. */
+        triangleloop.tri[m->highorderindex + triangleloop.orient] =
+                encodevertex(newvertex);
+        if (trisym.tri != m->dummytri) {
+          trisym.tri[m->highorderindex + trisym.orient] =
+                  encodevertex(newvertex);
+        }
+      }
     }
+    triangleloop.tri = triangletraverse(m);
   }
-  if (counterclockwise(m, b, rightvertex, leftvertex, farvertex) > 0.0) {
-    /* fartri is not an inverted triangle, and farvertex is not a reflex */
-    /*   vertex.  As there are no reflex vertices, fixuptri isn't an     */
-    /*   inverted triangle, either.  Hence, test the edge between the    */
-    /*   triangles to ensure it is locally Delaunay.                     */
-    if (incircle(m, b, leftvertex, farvertex, rightvertex, nearvertex) <=
-        0.0) {
-      return;
-    }
-    /* Not locally Delaunay; go on to an edge flip. */
-  }        /* else fartri is inverted; remove it from the stack by flipping. */
-  flip(m, b, &neartri);
-  lprevself(*fixuptri);    /* Restore the origin of fixuptri after the flip. */
-  /* Recursively process the two triangles that result from the flip. */
-  delaunayfixup(m, b, fixuptri, leftside);
-  delaunayfixup(m, b, &fartri, leftside);
 }
 
+/********* File I/O routines begin here                              *********/
+/**                                                                         **/
+/**                                                                         **/
+
 /*****************************************************************************/
 /*                                                                           */
-/*  constrainededge()   Force a segment into a constrained Delaunay          */
-/*                      triangulation by deleting the triangles it           */
-/*                      intersects, and triangulating the polygons that      */
-/*                      form on each side of it.                             */
-/*                                                                           */
-/*  Generates a single subsegment connecting `endpoint1' to `endpoint2'.     */
-/*  The triangle `starttri' has `endpoint1' as its origin.  `newmark' is the */
-/*  boundary marker of the segment.                                          */
-/*                                                                           */
-/*  To insert a segment, every triangle whose interior intersects the        */
-/*  segment is deleted.  The union of these deleted triangles is a polygon   */
-/*  (which is not necessarily monotone, but is close enough), which is       */
-/*  divided into two polygons by the new segment.  This routine's task is    */
-/*  to generate the Delaunay triangulation of these two polygons.            */
-/*                                                                           */
-/*  You might think of this routine's behavior as a two-step process.  The   */
-/*  first step is to walk from endpoint1 to endpoint2, flipping each edge    */
-/*  encountered.  This step creates a fan of edges connected to endpoint1,   */
-/*  including the desired edge to endpoint2.  The second step enforces the   */
-/*  Delaunay condition on each side of the segment in an incremental manner: */
-/*  proceeding along the polygon from endpoint1 to endpoint2 (this is done   */
-/*  independently on each side of the segment), each vertex is "enforced"    */
-/*  as if it had just been inserted, but affecting only the previous         */
-/*  vertices.  The result is the same as if the vertices had been inserted   */
-/*  in the order they appear on the polygon, so the result is Delaunay.      */
-/*                                                                           */
-/*  In truth, constrainededge() interleaves these two steps.  The procedure  */
-/*  walks from endpoint1 to endpoint2, and each time an edge is encountered  */
-/*  and flipped, the newly exposed vertex (at the far end of the flipped     */
-/*  edge) is "enforced" upon the previously flipped edges, usually affecting */
-/*  only one side of the polygon (depending upon which side of the segment   */
-/*  the vertex falls on).                                                    */
-/*                                                                           */
-/*  The algorithm is complicated by the need to handle polygons that are not */
-/*  convex.  Although the polygon is not necessarily monotone, it can be     */
-/*  triangulated in a manner similar to the stack-based algorithms for       */
-/*  monotone polygons.  For each reflex vertex (local concavity) of the      */
-/*  polygon, there will be an inverted triangle formed by one of the edge    */
-/*  flips.  (An inverted triangle is one with negative area - that is, its   */
-/*  vertices are arranged in clockwise order - and is best thought of as a   */
-/*  wrinkle in the fabric of the mesh.)  Each inverted triangle can be       */
-/*  thought of as a reflex vertex pushed on the stack, waiting to be fixed   */
-/*  later.                                                                   */
+/*  readline()   Read a nonempty line from a file.                           */
 /*                                                                           */
-/*  A reflex vertex is popped from the stack when a vertex is inserted that  */
-/*  is visible to the reflex vertex.  (However, if the vertex behind the     */
-/*  reflex vertex is not visible to the reflex vertex, a new inverted        */
-/*  triangle will take its place on the stack.)  These details are handled   */
-/*  by the delaunayfixup() routine above.                                    */
+/*  A line is considered "nonempty" if it contains something that looks like */
+/*  a number.  Comments (prefaced by `#') are ignored.                       */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifdef ANSI_DECLARATORS
-void constrainededge(struct mesh *m, struct behavior *b,
-                     struct otri *starttri, vertex endpoint2, int newmark)
-#else /* not ANSI_DECLARATORS */
-void constrainededge(m, b, starttri, endpoint2, newmark)
-struct mesh *m;
-struct behavior *b;
-struct otri *starttri;
-vertex endpoint2;
-int newmark;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  struct otri fixuptri, fixuptri2;
-  struct osub crosssubseg;
-  vertex endpoint1;
-  vertex farvertex;
-  REAL area;
-  int collision;
-  int done;
-  triangle ptr;             /* Temporary variable used by sym() and oprev(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+#ifndef TRILIBRARY
 
-  org(*starttri, endpoint1);
-  lnext(*starttri, fixuptri);
-  flip(m, b, &fixuptri);
-  /* `collision' indicates whether we have found a vertex directly */
-  /*   between endpoint1 and endpoint2.                            */
-  collision = 0;
-  done = 0;
-  do {
-    org(fixuptri, farvertex);
-    /* `farvertex' is the extreme point of the polygon we are "digging" */
-    /*   to get from endpoint1 to endpoint2.                           */
-    if ((farvertex[0] == endpoint2[0]) && (farvertex[1] == endpoint2[1])) {
-      oprev(fixuptri, fixuptri2);
-      /* Enforce the Delaunay condition around endpoint2. */
-      delaunayfixup(m, b, &fixuptri, 0);
-      delaunayfixup(m, b, &fixuptri2, 1);
-      done = 1;
-    } else {
-      /* Check whether farvertex is to the left or right of the segment */
-      /*   being inserted, to decide which edge of fixuptri to dig      */
-      /*   through next.                                                */
-      area = counterclockwise(m, b, endpoint1, endpoint2, farvertex);
-      if (area == 0.0) {
-        /* We've collided with a vertex between endpoint1 and endpoint2. */
-        collision = 1;
-        oprev(fixuptri, fixuptri2);
-        /* Enforce the Delaunay condition around farvertex. */
-        delaunayfixup(m, b, &fixuptri, 0);
-        delaunayfixup(m, b, &fixuptri2, 1);
-        done = 1;
-      } else {
-        if (area > 0.0) {        /* farvertex is to the left of the segment. */
-          oprev(fixuptri, fixuptri2);
-          /* Enforce the Delaunay condition around farvertex, on the */
-          /*   left side of the segment only.                        */
-          delaunayfixup(m, b, &fixuptri2, 1);
-          /* Flip the edge that crosses the segment.  After the edge is */
-          /*   flipped, one of its endpoints is the fan vertex, and the */
-          /*   destination of fixuptri is the fan vertex.               */
-          lprevself(fixuptri);
-        } else {                /* farvertex is to the right of the segment. */
-          delaunayfixup(m, b, &fixuptri, 0);
-          /* Flip the edge that crosses the segment.  After the edge is */
-          /*   flipped, one of its endpoints is the fan vertex, and the */
-          /*   destination of fixuptri is the fan vertex.               */
-          oprevself(fixuptri);
-        }
-        /* Check for two intersecting segments. */
-        tspivot(fixuptri, crosssubseg);
-        if (crosssubseg.ss == m->dummysub) {
-          flip(m, b, &fixuptri);    /* May create inverted triangle at left. */
-        } else {
-          /* We've collided with a segment between endpoint1 and endpoint2. */
-          collision = 1;
-          /* Insert a vertex at the intersection. */
-          segmentintersection(m, b, &fixuptri, &crosssubseg, endpoint2);
-          done = 1;
-        }
-      }
+#ifdef ANSI_DECLARATORS
+char *readline(char *string, FILE *infile, char *infilename)
+#else /* not ANSI_DECLARATORS */
+char *readline(string, infile, infilename)
+char *string;
+FILE *infile;
+char *infilename;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  char *result;
+
+  /* Search for something that looks like a number. */
+  do {
+    result = fgets(string, INPUTLINESIZE, infile);
+    if (result == (char *) NULL) {
+      printf("  Error:  Unexpected end of file in %s.\n", infilename);
+      triexit(1);
     }
-  } while (!done);
-  /* Insert a subsegment to make the segment permanent. */
-  insertsubseg(m, b, &fixuptri, newmark);
-  /* If there was a collision with an interceding vertex, install another */
-  /*   segment connecting that vertex with endpoint2.                     */
-  if (collision) {
-    /* Insert the remainder of the segment. */
-    if (!scoutsegment(m, b, &fixuptri, endpoint2, newmark)) {
-      constrainededge(m, b, &fixuptri, endpoint2, newmark);
+    /* Skip anything that doesn't look like a number, a comment, */
+    /*   or the end of a line.                                   */
+    while ((*result != '\0') && (*result != '#')
+           && (*result != '.') && (*result != '+') && (*result != '-')
+           && ((*result < '0') || (*result > '9'))) {
+      result++;
     }
+  /* If it's a comment or end of line, read another line and try again. */
+  } while ((*result == '#') || (*result == '\0'));
+  return result;
+}
+
+#endif /* not TRILIBRARY */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  findfield()   Find the next field of a string.                           */
+/*                                                                           */
+/*  Jumps past the current field by searching for whitespace, then jumps     */
+/*  past the whitespace to find the next field.                              */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifndef TRILIBRARY
+
+#ifdef ANSI_DECLARATORS
+char *findfield(char *string)
+#else /* not ANSI_DECLARATORS */
+char *findfield(string)
+char *string;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  char *result;
+
+  result = string;
+  /* Skip the current field.  Stop upon reaching whitespace. */
+  while ((*result != '\0') && (*result != '#')
+         && (*result != ' ') && (*result != '\t')) {
+    result++;
+  }
+  /* Now skip the whitespace and anything else that doesn't look like a */
+  /*   number, a comment, or the end of a line.                         */
+  while ((*result != '\0') && (*result != '#')
+         && (*result != '.') && (*result != '+') && (*result != '-')
+         && ((*result < '0') || (*result > '9'))) {
+    result++;
+  }
+  /* Check for a comment (prefixed with `#'). */
+  if (*result == '#') {
+    *result = '\0';
   }
+  return result;
 }
 
+#endif /* not TRILIBRARY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  insertsegment()   Insert a PSLG segment into a triangulation.            */
+/*  readnodes()   Read the vertices from a file, which may be a .node or     */
+/*                .poly file.                                                */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef TRILIBRARY
+
 #ifdef ANSI_DECLARATORS
-void insertsegment(struct mesh *m, struct behavior *b,
-                   vertex endpoint1, vertex endpoint2, int newmark)
+void readnodes(struct mesh *m, struct behavior *b, char *nodefilename,
+               char *polyfilename, FILE **polyfile)
 #else /* not ANSI_DECLARATORS */
-void insertsegment(m, b, endpoint1, endpoint2, newmark)
+void readnodes(m, b, nodefilename, polyfilename, polyfile)
 struct mesh *m;
 struct behavior *b;
-vertex endpoint1;
-vertex endpoint2;
-int newmark;
+char *nodefilename;
+char *polyfilename;
+FILE **polyfile;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri searchtri1, searchtri2;
-  triangle encodedtri;
-  vertex checkvertex;
-  triangle ptr;                         /* Temporary variable used by sym(). */
+  FILE *infile;
+  vertex vertexloop;
+  char inputline[INPUTLINESIZE];
+  char *stringptr;
+  char *infilename;
+  REAL x, y;
+  int firstnode;
+  int nodemarkers;
+  int currentmarker;
+  int i, j;
 
-  if (b->verbose > 1) {
-    printf("  Connecting (%.12g, %.12g) to (%.12g, %.12g).\n",
-           endpoint1[0], endpoint1[1], endpoint2[0], endpoint2[1]);
+  if (b->poly) {
+    /* Read the vertices from a .poly file. */
+    if (!b->quiet) {
+      printf("Opening %s.\n", polyfilename);
+    }
+    *polyfile = fopen(polyfilename, "r");
+    if (*polyfile == (FILE *) NULL) {
+      printf("  Error:  Cannot access file %s.\n", polyfilename);
+      triexit(1);
+    }
+    /* Read number of vertices, number of dimensions, number of vertex */
+    /*   attributes, and number of boundary markers.                   */
+    stringptr = readline(inputline, *polyfile, polyfilename);
+    m->invertices = (int) strtol(stringptr, &stringptr, 0);
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      m->mesh_dim = 2;
+    } else {
+      m->mesh_dim = (int) strtol(stringptr, &stringptr, 0);
+    }
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      m->nextras = 0;
+    } else {
+      m->nextras = (int) strtol(stringptr, &stringptr, 0);
+    }
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      nodemarkers = 0;
+    } else {
+      nodemarkers = (int) strtol(stringptr, &stringptr, 0);
+    }
+    if (m->invertices > 0) {
+      infile = *polyfile;
+      infilename = polyfilename;
+      m->readnodefile = 0;
+    } else {
+      /* If the .poly file claims there are zero vertices, that means that */
+      /*   the vertices should be read from a separate .node file.         */
+      m->readnodefile = 1;
+      infilename = nodefilename;
+    }
+  } else {
+    m->readnodefile = 1;
+    infilename = nodefilename;
+    *polyfile = (FILE *) NULL;
   }
 
-  /* Find a triangle whose origin is the segment's first endpoint. */
-  checkvertex = (vertex) NULL;
-  encodedtri = vertex2tri(endpoint1);
-  if (encodedtri != (triangle) NULL) {
-    decode(encodedtri, searchtri1);
-    org(searchtri1, checkvertex);
+  if (m->readnodefile) {
+    /* Read the vertices from a .node file. */
+    if (!b->quiet) {
+      printf("Opening %s.\n", nodefilename);
+    }
+    infile = fopen(nodefilename, "r");
+    if (infile == (FILE *) NULL) {
+      printf("  Error:  Cannot access file %s.\n", nodefilename);
+      triexit(1);
+    }
+    /* Read number of vertices, number of dimensions, number of vertex */
+    /*   attributes, and number of boundary markers.                   */
+    stringptr = readline(inputline, infile, nodefilename);
+    m->invertices = (int) strtol(stringptr, &stringptr, 0);
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      m->mesh_dim = 2;
+    } else {
+      m->mesh_dim = (int) strtol(stringptr, &stringptr, 0);
+    }
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      m->nextras = 0;
+    } else {
+      m->nextras = (int) strtol(stringptr, &stringptr, 0);
+    }
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      nodemarkers = 0;
+    } else {
+      nodemarkers = (int) strtol(stringptr, &stringptr, 0);
+    }
   }
-  if (checkvertex != endpoint1) {
-    /* Find a boundary triangle to search from. */
-    searchtri1.tri = m->dummytri;
-    searchtri1.orient = 0;
-    symself(searchtri1);
-    /* Search for the segment's first endpoint by point location. */
-    if (locate(m, b, endpoint1, &searchtri1) != ONVERTEX) {
-      printf(
-        "Internal error in insertsegment():  Unable to locate PSLG vertex\n");
-      printf("  (%.12g, %.12g) in triangulation.\n",
-             endpoint1[0], endpoint1[1]);
-      internalerror();
+
+  if (m->invertices < 3) {
+    printf("Error:  Input must have at least three input vertices.\n");
+    triexit(1);
+  }
+  if (m->mesh_dim != 2) {
+    printf("Error:  Triangle only works with two-dimensional meshes.\n");
+    triexit(1);
+  }
+  if (m->nextras == 0) {
+    b->weighted = 0;
+  }
+
+  initializevertexpool(m, b);
+
+  /* Read the vertices. */
+  for (i = 0; i < m->invertices; i++) {
+    vertexloop = (vertex) poolalloc(&m->vertices);
+    stringptr = readline(inputline, infile, infilename);
+    if (i == 0) {
+      firstnode = (int) strtol(stringptr, &stringptr, 0);
+      if ((firstnode == 0) || (firstnode == 1)) {
+        b->firstnumber = firstnode;
+      }
+    }
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      printf("Error:  Vertex %d has no x coordinate.\n", b->firstnumber + i);
+      triexit(1);
+    }
+    x = (REAL) strtod(stringptr, &stringptr);
+    stringptr = findfield(stringptr);
+    if (*stringptr == '\0') {
+      printf("Error:  Vertex %d has no y coordinate.\n", b->firstnumber + i);
+      triexit(1);
+    }
+    y = (REAL) strtod(stringptr, &stringptr);
+    vertexloop[0] = x;
+    vertexloop[1] = y;
+    /* Read the vertex attributes. */
+    for (j = 2; j < 2 + m->nextras; j++) {
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        vertexloop[j] = 0.0;
+      } else {
+        vertexloop[j] = (REAL) strtod(stringptr, &stringptr);
+      }
     }
-  }
-  /* Remember this triangle to improve subsequent point location. */
-  otricopy(searchtri1, m->recenttri);
-  /* Scout the beginnings of a path from the first endpoint */
-  /*   toward the second.                                   */
-  if (scoutsegment(m, b, &searchtri1, endpoint2, newmark)) {
-    /* The segment was easily inserted. */
-    return;
-  }
-  /* The first endpoint may have changed if a collision with an intervening */
-  /*   vertex on the segment occurred.                                      */
-  org(searchtri1, endpoint1);
-
-  /* Find a triangle whose origin is the segment's second endpoint. */
-  checkvertex = (vertex) NULL;
-  encodedtri = vertex2tri(endpoint2);
-  if (encodedtri != (triangle) NULL) {
-    decode(encodedtri, searchtri2);
-    org(searchtri2, checkvertex);
-  }
-  if (checkvertex != endpoint2) {
-    /* Find a boundary triangle to search from. */
-    searchtri2.tri = m->dummytri;
-    searchtri2.orient = 0;
-    symself(searchtri2);
-    /* Search for the segment's second endpoint by point location. */
-    if (locate(m, b, endpoint2, &searchtri2) != ONVERTEX) {
-      printf(
-        "Internal error in insertsegment():  Unable to locate PSLG vertex\n");
-      printf("  (%.12g, %.12g) in triangulation.\n",
-             endpoint2[0], endpoint2[1]);
-      internalerror();
+    if (nodemarkers) {
+      /* Read a vertex marker. */
+      stringptr = findfield(stringptr);
+      if (*stringptr == '\0') {
+        setvertexmark(vertexloop, 0);
+      } else {
+        currentmarker = (int) strtol(stringptr, &stringptr, 0);
+        setvertexmark(vertexloop, currentmarker);
+      }
+    } else {
+      /* If no markers are specified in the file, they default to zero. */
+      setvertexmark(vertexloop, 0);
+    }
+    setvertextype(vertexloop, INPUTVERTEX);
+    /* Determine the smallest and largest x and y coordinates. */
+    if (i == 0) {
+      m->xmin = m->xmax = x;
+      m->ymin = m->ymax = y;
+    } else {
+      m->xmin = (x < m->xmin) ? x : m->xmin;
+      m->xmax = (x > m->xmax) ? x : m->xmax;
+      m->ymin = (y < m->ymin) ? y : m->ymin;
+      m->ymax = (y > m->ymax) ? y : m->ymax;
     }
   }
-  /* Remember this triangle to improve subsequent point location. */
-  otricopy(searchtri2, m->recenttri);
-  /* Scout the beginnings of a path from the second endpoint */
-  /*   toward the first.                                     */
-  if (scoutsegment(m, b, &searchtri2, endpoint1, newmark)) {
-    /* The segment was easily inserted. */
-    return;
+  if (m->readnodefile) {
+    fclose(infile);
   }
-  /* The second endpoint may have changed if a collision with an intervening */
-  /*   vertex on the segment occurred.                                       */
-  org(searchtri2, endpoint2);
 
-#ifndef REDUCED
-#ifndef CDT_ONLY
-  if (b->splitseg) {
-    /* Insert vertices to force the segment into the triangulation. */
-    conformingedge(m, b, endpoint1, endpoint2, newmark);
-  } else {
-#endif /* not CDT_ONLY */
-#endif /* not REDUCED */
-    /* Insert the segment directly into the triangulation. */
-    constrainededge(m, b, &searchtri1, endpoint2, newmark);
-#ifndef REDUCED
-#ifndef CDT_ONLY
-  }
-#endif /* not CDT_ONLY */
-#endif /* not REDUCED */
+  /* Nonexistent x value used as a flag to mark circle events in sweepline */
+  /*   Delaunay algorithm.                                                 */
+  m->xminextreme = 10 * m->xmin - 9 * m->xmax;
 }
 
+#endif /* not TRILIBRARY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  markhull()   Cover the convex hull of a triangulation with subsegments.  */
+/*  transfernodes()   Read the vertices from memory.                         */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifdef TRILIBRARY
+
 #ifdef ANSI_DECLARATORS
-void markhull(struct mesh *m, struct behavior *b)
+void transfernodes(struct mesh *m, struct behavior *b, REAL *pointlist,
+                   REAL *pointattriblist, int *pointmarkerlist,
+                   int numberofpoints, int numberofpointattribs)
 #else /* not ANSI_DECLARATORS */
-void markhull(m, b)
+void transfernodes(m, b, pointlist, pointattriblist, pointmarkerlist,
+                   numberofpoints, numberofpointattribs)
 struct mesh *m;
 struct behavior *b;
+REAL *pointlist;
+REAL *pointattriblist;
+int *pointmarkerlist;
+int numberofpoints;
+int numberofpointattribs;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri hulltri;
-  struct otri nexttri;
-  struct otri starttri;
-  triangle ptr;             /* Temporary variable used by sym() and oprev(). */
+  vertex vertexloop;
+  REAL x, y;
+  int i, j;
+  int coordindex;
+  int attribindex;
 
-  /* Find a triangle handle on the hull. */
-  hulltri.tri = m->dummytri;
-  hulltri.orient = 0;
-  symself(hulltri);
-  /* Remember where we started so we know when to stop. */
-  otricopy(hulltri, starttri);
-  /* Go once counterclockwise around the convex hull. */
-  do {
-    /* Create a subsegment if there isn't already one here. */
-    insertsubseg(m, b, &hulltri, 1);
-    /* To find the next hull edge, go clockwise around the next vertex. */
-    lnextself(hulltri);
-    oprev(hulltri, nexttri);
-    while (nexttri.tri != m->dummytri) {
-      otricopy(nexttri, hulltri);
-      oprev(hulltri, nexttri);
+  m->invertices = numberofpoints;
+  m->mesh_dim = 2;
+  m->nextras = numberofpointattribs;
+  m->readnodefile = 0;
+  if (m->invertices < 3) {
+    printf("Error:  Input must have at least three input vertices.\n");
+    triexit(1);
+  }
+  if (m->nextras == 0) {
+    b->weighted = 0;
+  }
+
+  initializevertexpool(m, b);
+
+  /* Read the vertices. */
+  coordindex = 0;
+  attribindex = 0;
+  for (i = 0; i < m->invertices; i++) {
+    vertexloop = (vertex) poolalloc(&m->vertices);
+    /* Read the vertex coordinates. */
+    x = vertexloop[0] = pointlist[coordindex++];
+    y = vertexloop[1] = pointlist[coordindex++];
+    /* Read the vertex attributes. */
+    for (j = 0; j < numberofpointattribs; j++) {
+      vertexloop[2 + j] = pointattriblist[attribindex++];
     }
-  } while (!otriequal(hulltri, starttri));
+    if (pointmarkerlist != (int *) NULL) {
+      /* Read a vertex marker. */
+      setvertexmark(vertexloop, pointmarkerlist[i]);
+    } else {
+      /* If no markers are specified, they default to zero. */
+      setvertexmark(vertexloop, 0);
+    }
+    setvertextype(vertexloop, INPUTVERTEX);
+    /* Determine the smallest and largest x and y coordinates. */
+    if (i == 0) {
+      m->xmin = m->xmax = x;
+      m->ymin = m->ymax = y;
+    } else {
+      m->xmin = (x < m->xmin) ? x : m->xmin;
+      m->xmax = (x > m->xmax) ? x : m->xmax;
+      m->ymin = (y < m->ymin) ? y : m->ymin;
+      m->ymax = (y > m->ymax) ? y : m->ymax;
+    }
+  }
+
+  /* Nonexistent x value used as a flag to mark circle events in sweepline */
+  /*   Delaunay algorithm.                                                 */
+  m->xminextreme = 10 * m->xmin - 9 * m->xmax;
 }
 
+#endif /* TRILIBRARY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  formskeleton()   Create the segments of a triangulation, including PSLG  */
-/*                   segments and edges on the convex hull.                  */
-/*                                                                           */
-/*  The PSLG segments are read from a .poly file.  The return value is the   */
-/*  number of segments in the file.                                          */
+/*  readholes()   Read the holes, and possibly regional attributes and area  */
+/*                constraints, from a .poly file.                            */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifdef TRILIBRARY
-
-#ifdef ANSI_DECLARATORS
-void formskeleton(struct mesh *m, struct behavior *b, int *segmentlist,
-                  int *segmentmarkerlist, int numberofsegments)
-#else /* not ANSI_DECLARATORS */
-void formskeleton(m, b, segmentlist, segmentmarkerlist, numberofsegments)
-struct mesh *m;
-struct behavior *b;
-int *segmentlist;
-int *segmentmarkerlist;
-int numberofsegments;
-#endif /* not ANSI_DECLARATORS */
-
-#else /* not TRILIBRARY */
-
-#ifdef ANSI_DECLARATORS
-void formskeleton(struct mesh *m, struct behavior *b,
-                  FILE *polyfile, char *polyfilename)
-#else /* not ANSI_DECLARATORS */
-void formskeleton(m, b, polyfile, polyfilename)
-struct mesh *m;
-struct behavior *b;
-FILE *polyfile;
-char *polyfilename;
-#endif /* not ANSI_DECLARATORS */
-
-#endif /* not TRILIBRARY */
-
-{
-#ifdef TRILIBRARY
-  char polyfilename[6];
-  int index;
-#else /* not TRILIBRARY */
-  char inputline[INPUTLINESIZE];
-  char *stringptr;
-#endif /* not TRILIBRARY */
-  vertex endpoint1, endpoint2;
-  int segmentmarkers;
-  int end1, end2;
-  int boundmarker;
-  int i;
+#ifndef TRILIBRARY
 
-  if (b->poly) {
-    if (!b->quiet) {
-      printf("Recovering segments in Delaunay triangulation.\n");
-    }
-#ifdef TRILIBRARY
-    strcpy(polyfilename, "input");
-    m->insegments = numberofsegments;
-    segmentmarkers = segmentmarkerlist != (int *) NULL;
-    index = 0;
-#else /* not TRILIBRARY */
-    /* Read the segments from a .poly file. */
-    /* Read number of segments and number of boundary markers. */
-    stringptr = readline(inputline, polyfile, polyfilename);
-    m->insegments = (int) strtol(stringptr, &stringptr, 0);
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      segmentmarkers = 0;
-    } else {
-      segmentmarkers = (int) strtol(stringptr, &stringptr, 0);
-    }
-#endif /* not TRILIBRARY */
-    /* If the input vertices are collinear, there is no triangulation, */
-    /*   so don't try to insert segments.                              */
-    if (m->triangles.items == 0) {
-      return;
-    }
+#ifdef ANSI_DECLARATORS
+void readholes(struct mesh *m, struct behavior *b,
+               FILE *polyfile, char *polyfilename, REAL **hlist, int *holes,
+               REAL **rlist, int *regions)
+#else /* not ANSI_DECLARATORS */
+void readholes(m, b, polyfile, polyfilename, hlist, holes, rlist, regions)
+struct mesh *m;
+struct behavior *b;
+FILE *polyfile;
+char *polyfilename;
+REAL **hlist;
+int *holes;
+REAL **rlist;
+int *regions;
+#endif /* not ANSI_DECLARATORS */
 
-    /* If segments are to be inserted, compute a mapping */
-    /*   from vertices to triangles.                     */
-    if (m->insegments > 0) {
-      makevertexmap(m, b);
-      if (b->verbose) {
-        printf("  Recovering PSLG segments.\n");
-      }
-    }
+{
+  REAL *holelist;
+  REAL *regionlist;
+  char inputline[INPUTLINESIZE];
+  char *stringptr;
+  int index;
+  int i;
 
-    boundmarker = 0;
-    /* Read and insert the segments. */
-    for (i = 0; i < m->insegments; i++) {
-#ifdef TRILIBRARY
-      end1 = segmentlist[index++];
-      end2 = segmentlist[index++];
-      if (segmentmarkers) {
-        boundmarker = segmentmarkerlist[i];
-      }
-#else /* not TRILIBRARY */
-      stringptr = readline(inputline, polyfile, b->inpolyfilename);
+  /* Read the holes. */
+  stringptr = readline(inputline, polyfile, polyfilename);
+  *holes = (int) strtol(stringptr, &stringptr, 0);
+  if (*holes > 0) {
+    holelist = (REAL *) trimalloc(2 * *holes * (int) sizeof(REAL));
+    *hlist = holelist;
+    for (i = 0; i < 2 * *holes; i += 2) {
+      stringptr = readline(inputline, polyfile, polyfilename);
       stringptr = findfield(stringptr);
       if (*stringptr == '\0') {
-        printf("Error:  Segment %d has no endpoints in %s.\n",
-               b->firstnumber + i, polyfilename);
+        printf("Error:  Hole %d has no x coordinate.\n",
+               b->firstnumber + (i >> 1));
         triexit(1);
       } else {
-        end1 = (int) strtol(stringptr, &stringptr, 0);
+        holelist[i] = (REAL) strtod(stringptr, &stringptr);
       }
       stringptr = findfield(stringptr);
       if (*stringptr == '\0') {
-        printf("Error:  Segment %d is missing its second endpoint in %s.\n",
-               b->firstnumber + i, polyfilename);
+        printf("Error:  Hole %d has no y coordinate.\n",
+               b->firstnumber + (i >> 1));
         triexit(1);
       } else {
-        end2 = (int) strtol(stringptr, &stringptr, 0);
+        holelist[i + 1] = (REAL) strtod(stringptr, &stringptr);
       }
-      if (segmentmarkers) {
+    }
+  } else {
+    *hlist = (REAL *) NULL;
+  }
+
+#ifndef CDT_ONLY
+  if ((b->regionattrib || b->vararea) && !b->refine) {
+    /* Read the area constraints. */
+    stringptr = readline(inputline, polyfile, polyfilename);
+    *regions = (int) strtol(stringptr, &stringptr, 0);
+    if (*regions > 0) {
+      regionlist = (REAL *) trimalloc(4 * *regions * (int) sizeof(REAL));
+      *rlist = regionlist;
+      index = 0;
+      for (i = 0; i < *regions; i++) {
+        stringptr = readline(inputline, polyfile, polyfilename);
         stringptr = findfield(stringptr);
         if (*stringptr == '\0') {
-          boundmarker = 0;
+          printf("Error:  Region %d has no x coordinate.\n",
+                 b->firstnumber + i);
+          triexit(1);
         } else {
-          boundmarker = (int) strtol(stringptr, &stringptr, 0);
+          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
         }
-      }
-#endif /* not TRILIBRARY */
-      if ((end1 < b->firstnumber) ||
-          (end1 >= b->firstnumber + m->invertices)) {
-        if (!b->quiet) {
-          printf("Warning:  Invalid first endpoint of segment %d in %s.\n",
-                 b->firstnumber + i, polyfilename);
+        stringptr = findfield(stringptr);
+        if (*stringptr == '\0') {
+          printf("Error:  Region %d has no y coordinate.\n",
+                 b->firstnumber + i);
+          triexit(1);
+        } else {
+          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
         }
-      } else if ((end2 < b->firstnumber) ||
-                 (end2 >= b->firstnumber + m->invertices)) {
-        if (!b->quiet) {
-          printf("Warning:  Invalid second endpoint of segment %d in %s.\n",
-                 b->firstnumber + i, polyfilename);
+        stringptr = findfield(stringptr);
+        if (*stringptr == '\0') {
+          printf(
+            "Error:  Region %d has no region attribute or area constraint.\n",
+                 b->firstnumber + i);
+          triexit(1);
+        } else {
+          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
         }
-      } else {
-        /* Find the vertices numbered `end1' and `end2'. */
-        endpoint1 = getvertex(m, b, end1);
-        endpoint2 = getvertex(m, b, end2);
-        if ((endpoint1[0] == endpoint2[0]) && (endpoint1[1] == endpoint2[1])) {
-          if (!b->quiet) {
-            printf("Warning:  Endpoints of segment %d are coincident in %s.\n",
-                   b->firstnumber + i, polyfilename);
-          }
+        stringptr = findfield(stringptr);
+        if (*stringptr == '\0') {
+          regionlist[index] = regionlist[index - 1];
         } else {
-          insertsegment(m, b, endpoint1, endpoint2, boundmarker);
+          regionlist[index] = (REAL) strtod(stringptr, &stringptr);
         }
+        index++;
       }
     }
   } else {
-    m->insegments = 0;
-  }
-  if (b->convex || !b->poly) {
-    /* Enclose the convex hull with subsegments. */
-    if (b->verbose) {
-      printf("  Enclosing convex hull with segments.\n");
-    }
-    markhull(m, b);
+    /* Set `*regions' to zero to avoid an accidental free() later. */
+    *regions = 0;
+    *rlist = (REAL *) NULL;
   }
-}
+#endif /* not CDT_ONLY */
 
-/**                                                                         **/
-/**                                                                         **/
-/********* Segment insertion ends here                               *********/
+  fclose(polyfile);
+}
 
-/********* Carving out holes and concavities begins here             *********/
-/**                                                                         **/
-/**                                                                         **/
+#endif /* not TRILIBRARY */
 
 /*****************************************************************************/
 /*                                                                           */
-/*  infecthull()   Virally infect all of the triangles of the convex hull    */
-/*                 that are not protected by subsegments.  Where there are   */
-/*                 subsegments, set boundary markers as appropriate.         */
+/*  finishfile()   Write the command line to the output file so the user     */
+/*                 can remember how the file was generated.  Close the file. */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifndef TRILIBRARY
+
 #ifdef ANSI_DECLARATORS
-void infecthull(struct mesh *m, struct behavior *b)
+void finishfile(FILE *outfile, int argc, char **argv)
 #else /* not ANSI_DECLARATORS */
-void infecthull(m, b)
-struct mesh *m;
-struct behavior *b;
+void finishfile(outfile, argc, argv)
+FILE *outfile;
+int argc;
+char **argv;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri hulltri;
-  struct otri nexttri;
-  struct otri starttri;
-  struct osub hullsubseg;
-  triangle **deadtriangle;
-  vertex horg, hdest;
-  triangle ptr;                         /* Temporary variable used by sym(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+  int i;
 
-  if (b->verbose) {
-    printf("  Marking concavities (external triangles) for elimination.\n");
+  fprintf(outfile, "# Generated by");
+  for (i = 0; i < argc; i++) {
+    fprintf(outfile, " ");
+    fputs(argv[i], outfile);
   }
-  /* Find a triangle handle on the hull. */
-  hulltri.tri = m->dummytri;
-  hulltri.orient = 0;
-  symself(hulltri);
-  /* Remember where we started so we know when to stop. */
-  otricopy(hulltri, starttri);
-  /* Go once counterclockwise around the convex hull. */
-  do {
-    /* Ignore triangles that are already infected. */
-    if (!infected(hulltri)) {
-      /* Is the triangle protected by a subsegment? */
-      tspivot(hulltri, hullsubseg);
-      if (hullsubseg.ss == m->dummysub) {
-        /* The triangle is not protected; infect it. */
-        if (!infected(hulltri)) {
-          infect(hulltri);
-          deadtriangle = (triangle **) poolalloc(&m->viri);
-          *deadtriangle = hulltri.tri;
-        }
-      } else {
-        /* The triangle is protected; set boundary markers if appropriate. */
-        if (mark(hullsubseg) == 0) {
-          setmark(hullsubseg, 1);
-          org(hulltri, horg);
-          dest(hulltri, hdest);
-          if (vertexmark(horg) == 0) {
-            setvertexmark(horg, 1);
-          }
-          if (vertexmark(hdest) == 0) {
-            setvertexmark(hdest, 1);
-          }
-        }
-      }
-    }
-    /* To find the next hull edge, go clockwise around the next vertex. */
-    lnextself(hulltri);
-    oprev(hulltri, nexttri);
-    while (nexttri.tri != m->dummytri) {
-      otricopy(nexttri, hulltri);
-      oprev(hulltri, nexttri);
-    }
-  } while (!otriequal(hulltri, starttri));
+  fprintf(outfile, "\n");
+  fclose(outfile);
 }
 
+#endif /* not TRILIBRARY */
+
 /*****************************************************************************/
 /*                                                                           */
-/*  plague()   Spread the virus from all infected triangles to any neighbors */
-/*             not protected by subsegments.  Delete all infected triangles. */
-/*                                                                           */
-/*  This is the procedure that actually creates holes and concavities.       */
-/*                                                                           */
-/*  This procedure operates in two phases.  The first phase identifies all   */
-/*  the triangles that will die, and marks them as infected.  They are       */
-/*  marked to ensure that each triangle is added to the virus pool only      */
-/*  once, so the procedure will terminate.                                   */
+/*  writenodes()   Number the vertices and write them to a .node file.       */
 /*                                                                           */
-/*  The second phase actually eliminates the infected triangles.  It also    */
-/*  eliminates orphaned vertices.                                            */
+/*  To save memory, the vertex numbers are written over the boundary markers */
+/*  after the vertices are written to a file.                                */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifdef TRILIBRARY
+
 #ifdef ANSI_DECLARATORS
-void plague(struct mesh *m, struct behavior *b)
+void writenodes(struct mesh *m, struct behavior *b, REAL **pointlist,
+                REAL **pointattriblist, int **pointmarkerlist)
+#else /* not ANSI_DECLARATORS */
+void writenodes(m, b, pointlist, pointattriblist, pointmarkerlist)
+struct mesh *m;
+struct behavior *b;
+REAL **pointlist;
+REAL **pointattriblist;
+int **pointmarkerlist;
+#endif /* not ANSI_DECLARATORS */
+
+#else /* not TRILIBRARY */
+
+#ifdef ANSI_DECLARATORS
+void writenodes(struct mesh *m, struct behavior *b, char *nodefilename,
+                int argc, char **argv)
 #else /* not ANSI_DECLARATORS */
-void plague(m, b)
+void writenodes(m, b, nodefilename, argc, argv)
 struct mesh *m;
 struct behavior *b;
+char *nodefilename;
+int argc;
+char **argv;
 #endif /* not ANSI_DECLARATORS */
 
+#endif /* not TRILIBRARY */
+
 {
-  struct otri testtri;
-  struct otri neighbor;
-  triangle **virusloop;
-  triangle **deadtriangle;
-  struct osub neighborsubseg;
-  vertex testvertex;
-  vertex norg, ndest;
-  vertex deadorg, deaddest, deadapex;
-  int killorg;
-  triangle ptr;             /* Temporary variable used by sym() and onext(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+#ifdef TRILIBRARY
+  REAL *plist;
+  REAL *palist;
+  int *pmlist;
+  int coordindex;
+  int attribindex;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+#endif /* not TRILIBRARY */
+  vertex vertexloop;
+  long outvertices;
+  int vertexnumber;
+  int i;
 
-  if (b->verbose) {
-    printf("  Marking neighbors of marked triangles.\n");
-  }
-  /* Loop through all the infected triangles, spreading the virus to */
-  /*   their neighbors, then to their neighbors' neighbors.          */
-  traversalinit(&m->viri);
-  virusloop = (triangle **) traverse(&m->viri);
-  while (virusloop != (triangle **) NULL) {
-    testtri.tri = *virusloop;
-    /* A triangle is marked as infected by messing with one of its pointers */
-    /*   to subsegments, setting it to an illegal value.  Hence, we have to */
-    /*   temporarily uninfect this triangle so that we can examine its      */
-    /*   adjacent subsegments.                                              */
-    uninfect(testtri);
-    if (b->verbose > 2) {
-      /* Assign the triangle an orientation for convenience in */
-      /*   checking its vertices.                              */
-      testtri.orient = 0;
-      org(testtri, deadorg);
-      dest(testtri, deaddest);
-      apex(testtri, deadapex);
-      printf("    Checking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
-             deadorg[0], deadorg[1], deaddest[0], deaddest[1],
-             deadapex[0], deadapex[1]);
-    }
-    /* Check each of the triangle's three neighbors. */
-    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
-      /* Find the neighbor. */
-      sym(testtri, neighbor);
-      /* Check for a subsegment between the triangle and its neighbor. */
-      tspivot(testtri, neighborsubseg);
-      /* Check if the neighbor is nonexistent or already infected. */
-      if ((neighbor.tri == m->dummytri) || infected(neighbor)) {
-        if (neighborsubseg.ss != m->dummysub) {
-          /* There is a subsegment separating the triangle from its      */
-          /*   neighbor, but both triangles are dying, so the subsegment */
-          /*   dies too.                                                 */
-          subsegdealloc(m, neighborsubseg.ss);
-          if (neighbor.tri != m->dummytri) {
-            /* Make sure the subsegment doesn't get deallocated again */
-            /*   later when the infected neighbor is visited.         */
-            uninfect(neighbor);
-            tsdissolve(neighbor);
-            infect(neighbor);
-          }
-        }
-      } else {                   /* The neighbor exists and is not infected. */
-        if (neighborsubseg.ss == m->dummysub) {
-          /* There is no subsegment protecting the neighbor, so */
-          /*   the neighbor becomes infected.                   */
-          if (b->verbose > 2) {
-            org(neighbor, deadorg);
-            dest(neighbor, deaddest);
-            apex(neighbor, deadapex);
-            printf(
-              "    Marking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
-                   deadorg[0], deadorg[1], deaddest[0], deaddest[1],
-                   deadapex[0], deadapex[1]);
-          }
-          infect(neighbor);
-          /* Ensure that the neighbor's neighbors will be infected. */
-          deadtriangle = (triangle **) poolalloc(&m->viri);
-          *deadtriangle = neighbor.tri;
-        } else {               /* The neighbor is protected by a subsegment. */
-          /* Remove this triangle from the subsegment. */
-          stdissolve(neighborsubseg);
-          /* The subsegment becomes a boundary.  Set markers accordingly. */
-          if (mark(neighborsubseg) == 0) {
-            setmark(neighborsubseg, 1);
-          }
-          org(neighbor, norg);
-          dest(neighbor, ndest);
-          if (vertexmark(norg) == 0) {
-            setvertexmark(norg, 1);
-          }
-          if (vertexmark(ndest) == 0) {
-            setvertexmark(ndest, 1);
-          }
-        }
-      }
-    }
-    /* Remark the triangle as infected, so it doesn't get added to the */
-    /*   virus pool again.                                             */
-    infect(testtri);
-    virusloop = (triangle **) traverse(&m->viri);
+  if (b->jettison) {
+    outvertices = m->vertices.items - m->undeads;
+  } else {
+    outvertices = m->vertices.items;
   }
 
-  if (b->verbose) {
-    printf("  Deleting marked triangles.\n");
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing vertices.\n");
   }
+  /* Allocate memory for output vertices if necessary. */
+  if (*pointlist == (REAL *) NULL) {
+    *pointlist = (REAL *) trimalloc((int) (outvertices * 2 * sizeof(REAL)));
+  }
+  /* Allocate memory for output vertex attributes if necessary. */
+  if ((m->nextras > 0) && (*pointattriblist == (REAL *) NULL)) {
+    *pointattriblist = (REAL *) trimalloc((int) (outvertices * m->nextras *
+                                                 sizeof(REAL)));
+  }
+  /* Allocate memory for output vertex markers if necessary. */
+  if (!b->nobound && (*pointmarkerlist == (int *) NULL)) {
+    *pointmarkerlist = (int *) trimalloc((int) (outvertices * sizeof(int)));
+  }
+  plist = *pointlist;
+  palist = *pointattriblist;
+  pmlist = *pointmarkerlist;
+  coordindex = 0;
+  attribindex = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", nodefilename);
+  }
+  outfile = fopen(nodefilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", nodefilename);
+    triexit(1);
+  }
+  /* Number of vertices, number of dimensions, number of vertex attributes, */
+  /*   and number of boundary markers (zero or one).                        */
+  fprintf(outfile, "%ld  %d  %d  %d\n", outvertices, m->mesh_dim,
+          m->nextras, 1 - b->nobound);
+#endif /* not TRILIBRARY */
 
-  traversalinit(&m->viri);
-  virusloop = (triangle **) traverse(&m->viri);
-  while (virusloop != (triangle **) NULL) {
-    testtri.tri = *virusloop;
-
-    /* Check each of the three corners of the triangle for elimination. */
-    /*   This is done by walking around each vertex, checking if it is  */
-    /*   still connected to at least one live triangle.                 */
-    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
-      org(testtri, testvertex);
-      /* Check if the vertex has already been tested. */
-      if (testvertex != (vertex) NULL) {
-        killorg = 1;
-        /* Mark the corner of the triangle as having been tested. */
-        setorg(testtri, NULL);
-        /* Walk counterclockwise about the vertex. */
-        onext(testtri, neighbor);
-        /* Stop upon reaching a boundary or the starting triangle. */
-        while ((neighbor.tri != m->dummytri) &&
-               (!otriequal(neighbor, testtri))) {
-          if (infected(neighbor)) {
-            /* Mark the corner of this triangle as having been tested. */
-            setorg(neighbor, NULL);
-          } else {
-            /* A live triangle.  The vertex survives. */
-            killorg = 0;
-          }
-          /* Walk counterclockwise about the vertex. */
-          onextself(neighbor);
-        }
-        /* If we reached a boundary, we must walk clockwise as well. */
-        if (neighbor.tri == m->dummytri) {
-          /* Walk clockwise about the vertex. */
-          oprev(testtri, neighbor);
-          /* Stop upon reaching a boundary. */
-          while (neighbor.tri != m->dummytri) {
-            if (infected(neighbor)) {
-            /* Mark the corner of this triangle as having been tested. */
-              setorg(neighbor, NULL);
-            } else {
-              /* A live triangle.  The vertex survives. */
-              killorg = 0;
-            }
-            /* Walk clockwise about the vertex. */
-            oprevself(neighbor);
-          }
-        }
-        if (killorg) {
-          if (b->verbose > 1) {
-            printf("    Deleting vertex (%.12g, %.12g)\n",
-                   testvertex[0], testvertex[1]);
-          }
-          setvertextype(testvertex, UNDEADVERTEX);
-          m->undeads++;
-        }
+  traversalinit(&m->vertices);
+  vertexnumber = b->firstnumber;
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
+#ifdef TRILIBRARY
+      /* X and y coordinates. */
+      plist[coordindex++] = vertexloop[0];
+      plist[coordindex++] = vertexloop[1];
+      /* Vertex attributes. */
+      for (i = 0; i < m->nextras; i++) {
+        palist[attribindex++] = vertexloop[2 + i];
       }
-    }
-
-    /* Record changes in the number of boundary edges, and disconnect */
-    /*   dead triangles from their neighbors.                         */
-    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
-      sym(testtri, neighbor);
-      if (neighbor.tri == m->dummytri) {
-        /* There is no neighboring triangle on this edge, so this edge    */
-        /*   is a boundary edge.  This triangle is being deleted, so this */
-        /*   boundary edge is deleted.                                    */
-        m->hullsize--;
-      } else {
-        /* Disconnect the triangle from its neighbor. */
-        dissolve(neighbor);
-        /* There is a neighboring triangle on this edge, so this edge */
-        /*   becomes a boundary edge when this triangle is deleted.   */
-        m->hullsize++;
+      if (!b->nobound) {
+        /* Copy the boundary marker. */
+        pmlist[vertexnumber - b->firstnumber] = vertexmark(vertexloop);
+      }
+#else /* not TRILIBRARY */
+      /* Vertex number, x and y coordinates. */
+      fprintf(outfile, "%4d    %.17g  %.17g", vertexnumber, vertexloop[0],
+              vertexloop[1]);
+      for (i = 0; i < m->nextras; i++) {
+        /* Write an attribute. */
+        fprintf(outfile, "  %.17g", vertexloop[i + 2]);
+      }
+      if (b->nobound) {
+        fprintf(outfile, "\n");
+      } else {
+        /* Write the boundary marker. */
+        fprintf(outfile, "    %d\n", vertexmark(vertexloop));
       }
+#endif /* not TRILIBRARY */
+
+      setvertexmark(vertexloop, vertexnumber);
+      vertexnumber++;
     }
-    /* Return the dead triangle to the pool of triangles. */
-    triangledealloc(m, testtri.tri);
-    virusloop = (triangle **) traverse(&m->viri);
+    vertexloop = vertextraverse(m);
   }
-  /* Empty the virus pool. */
-  poolrestart(&m->viri);
+
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  regionplague()   Spread regional attributes and/or area constraints      */
-/*                   (from a .poly file) throughout the mesh.                */
+/*  numbernodes()   Number the vertices.                                     */
 /*                                                                           */
-/*  This procedure operates in two phases.  The first phase spreads an       */
-/*  attribute and/or an area constraint through a (segment-bounded) region.  */
-/*  The triangles are marked to ensure that each triangle is added to the    */
-/*  virus pool only once, so the procedure will terminate.                   */
+/*  Each vertex is assigned a marker equal to its number.                    */
 /*                                                                           */
-/*  The second phase uninfects all infected triangles, returning them to     */
-/*  normal.                                                                  */
+/*  Used when writenodes() is not called because no .node file is written.   */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void regionplague(struct mesh *m, struct behavior *b,
-                  REAL attribute, REAL area)
+void numbernodes(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void regionplague(m, b, attribute, area)
+void numbernodes(m, b)
 struct mesh *m;
 struct behavior *b;
-REAL attribute;
-REAL area;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri testtri;
-  struct otri neighbor;
-  triangle **virusloop;
-  triangle **regiontri;
-  struct osub neighborsubseg;
-  vertex regionorg, regiondest, regionapex;
-  triangle ptr;             /* Temporary variable used by sym() and onext(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+  vertex vertexloop;
+  int vertexnumber;
 
-  if (b->verbose > 1) {
-    printf("  Marking neighbors of marked triangles.\n");
-  }
-  /* Loop through all the infected triangles, spreading the attribute      */
-  /*   and/or area constraint to their neighbors, then to their neighbors' */
-  /*   neighbors.                                                          */
-  traversalinit(&m->viri);
-  virusloop = (triangle **) traverse(&m->viri);
-  while (virusloop != (triangle **) NULL) {
-    testtri.tri = *virusloop;
-    /* A triangle is marked as infected by messing with one of its pointers */
-    /*   to subsegments, setting it to an illegal value.  Hence, we have to */
-    /*   temporarily uninfect this triangle so that we can examine its      */
-    /*   adjacent subsegments.                                              */
-    uninfect(testtri);
-    if (b->regionattrib) {
-      /* Set an attribute. */
-      setelemattribute(testtri, m->eextras, attribute);
+  traversalinit(&m->vertices);
+  vertexnumber = b->firstnumber;
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    setvertexmark(vertexloop, vertexnumber);
+    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
+      vertexnumber++;
     }
-    if (b->vararea) {
-      /* Set an area constraint. */
-      setareabound(testtri, area);
+    vertexloop = vertextraverse(m);
+  }
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  writeelements()   Write the triangles to an .ele file.                   */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef TRILIBRARY
+
+#ifdef ANSI_DECLARATORS
+void writeelements(struct mesh *m, struct behavior *b,
+                   int **trianglelist, REAL **triangleattriblist)
+#else /* not ANSI_DECLARATORS */
+void writeelements(m, b, trianglelist, triangleattriblist)
+struct mesh *m;
+struct behavior *b;
+int **trianglelist;
+REAL **triangleattriblist;
+#endif /* not ANSI_DECLARATORS */
+
+#else /* not TRILIBRARY */
+
+#ifdef ANSI_DECLARATORS
+void writeelements(struct mesh *m, struct behavior *b, char *elefilename,
+                   int argc, char **argv)
+#else /* not ANSI_DECLARATORS */
+void writeelements(m, b, elefilename, argc, argv)
+struct mesh *m;
+struct behavior *b;
+char *elefilename;
+int argc;
+char **argv;
+#endif /* not ANSI_DECLARATORS */
+
+#endif /* not TRILIBRARY */
+
+{
+#ifdef TRILIBRARY
+  int *tlist;
+  REAL *talist;
+  int vertexindex;
+  int attribindex;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+#endif /* not TRILIBRARY */
+  struct otri triangleloop;
+  vertex p1, p2, p3;
+  vertex mid1, mid2, mid3;
+  long elementnumber;
+  int i;
+
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing triangles.\n");
+  }
+  /* Allocate memory for output triangles if necessary. */
+  if (*trianglelist == (int *) NULL) {
+    *trianglelist = (int *) trimalloc((int) (m->triangles.items *
+                                             ((b->order + 1) * (b->order + 2) /
+                                              2) * sizeof(int)));
+  }
+  /* Allocate memory for output triangle attributes if necessary. */
+  if ((m->eextras > 0) && (*triangleattriblist == (REAL *) NULL)) {
+    *triangleattriblist = (REAL *) trimalloc((int) (m->triangles.items *
+                                                    m->eextras *
+                                                    sizeof(REAL)));
+  }
+  tlist = *trianglelist;
+  talist = *triangleattriblist;
+  vertexindex = 0;
+  attribindex = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", elefilename);
+  }
+  outfile = fopen(elefilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", elefilename);
+    triexit(1);
+  }
+  /* Number of triangles, vertices per triangle, attributes per triangle. */
+  fprintf(outfile, "%ld  %d  %d\n", m->triangles.items,
+          (b->order + 1) * (b->order + 2) / 2, m->eextras);
+#endif /* not TRILIBRARY */
+
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  triangleloop.orient = 0;
+  elementnumber = b->firstnumber;
+  while (triangleloop.tri != (triangle *) NULL) {
+    org(triangleloop, p1);
+    dest(triangleloop, p2);
+    apex(triangleloop, p3);
+    if (b->order == 1) {
+#ifdef TRILIBRARY
+      tlist[vertexindex++] = vertexmark(p1);
+      tlist[vertexindex++] = vertexmark(p2);
+      tlist[vertexindex++] = vertexmark(p3);
+#else /* not TRILIBRARY */
+      /* Triangle number, indices for three vertices. */
+      fprintf(outfile, "%4ld    %4d  %4d  %4d", elementnumber,
+              vertexmark(p1), vertexmark(p2), vertexmark(p3));
+#endif /* not TRILIBRARY */
+    } else {
+      mid1 = decodevertex(triangleloop.tri[m->highorderindex + 1]);
+      mid2 = decodevertex(triangleloop.tri[m->highorderindex + 2]);
+      mid3 = decodevertex(triangleloop.tri[m->highorderindex]);
+#ifdef TRILIBRARY
+      tlist[vertexindex++] = vertexmark(p1);
+      tlist[vertexindex++] = vertexmark(p2);
+      tlist[vertexindex++] = vertexmark(p3);
+      tlist[vertexindex++] = vertexmark(mid1);
+      tlist[vertexindex++] = vertexmark(mid2);
+      tlist[vertexindex++] = vertexmark(mid3);
+#else /* not TRILIBRARY */
+      /* Triangle number, indices for six vertices. */
+      fprintf(outfile, "%4ld    %4d  %4d  %4d  %4d  %4d  %4d", elementnumber,
+              vertexmark(p1), vertexmark(p2), vertexmark(p3), vertexmark(mid1),
+              vertexmark(mid2), vertexmark(mid3));
+#endif /* not TRILIBRARY */
     }
-    if (b->verbose > 2) {
-      /* Assign the triangle an orientation for convenience in */
-      /*   checking its vertices.                              */
-      testtri.orient = 0;
-      org(testtri, regionorg);
-      dest(testtri, regiondest);
-      apex(testtri, regionapex);
-      printf("    Checking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
-             regionorg[0], regionorg[1], regiondest[0], regiondest[1],
-             regionapex[0], regionapex[1]);
+
+#ifdef TRILIBRARY
+    for (i = 0; i < m->eextras; i++) {
+      talist[attribindex++] = elemattribute(triangleloop, i);
     }
-    /* Check each of the triangle's three neighbors. */
-    for (testtri.orient = 0; testtri.orient < 3; testtri.orient++) {
-      /* Find the neighbor. */
-      sym(testtri, neighbor);
-      /* Check for a subsegment between the triangle and its neighbor. */
-      tspivot(testtri, neighborsubseg);
-      /* Make sure the neighbor exists, is not already infected, and */
-      /*   isn't protected by a subsegment.                          */
-      if ((neighbor.tri != m->dummytri) && !infected(neighbor)
-          && (neighborsubseg.ss == m->dummysub)) {
-        if (b->verbose > 2) {
-          org(neighbor, regionorg);
-          dest(neighbor, regiondest);
-          apex(neighbor, regionapex);
-          printf("    Marking (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
-                 regionorg[0], regionorg[1], regiondest[0], regiondest[1],
-                 regionapex[0], regionapex[1]);
-        }
-        /* Infect the neighbor. */
-        infect(neighbor);
-        /* Ensure that the neighbor's neighbors will be infected. */
-        regiontri = (triangle **) poolalloc(&m->viri);
-        *regiontri = neighbor.tri;
-      }
+#else /* not TRILIBRARY */
+    for (i = 0; i < m->eextras; i++) {
+      fprintf(outfile, "  %.17g", elemattribute(triangleloop, i));
     }
-    /* Remark the triangle as infected, so it doesn't get added to the */
-    /*   virus pool again.                                             */
-    infect(testtri);
-    virusloop = (triangle **) traverse(&m->viri);
-  }
+    fprintf(outfile, "\n");
+#endif /* not TRILIBRARY */
 
-  /* Uninfect all triangles. */
-  if (b->verbose > 1) {
-    printf("  Unmarking marked triangles.\n");
-  }
-  traversalinit(&m->viri);
-  virusloop = (triangle **) traverse(&m->viri);
-  while (virusloop != (triangle **) NULL) {
-    testtri.tri = *virusloop;
-    uninfect(testtri);
-    virusloop = (triangle **) traverse(&m->viri);
+    triangleloop.tri = triangletraverse(m);
+    elementnumber++;
   }
-  /* Empty the virus pool. */
-  poolrestart(&m->viri);
+
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  carveholes()   Find the holes and infect them.  Find the area            */
-/*                 constraints and infect them.  Infect the convex hull.     */
-/*                 Spread the infection and kill triangles.  Spread the      */
-/*                 area constraints.                                         */
-/*                                                                           */
-/*  This routine mainly calls other routines to carry out all these          */
-/*  functions.                                                               */
+/*  writepoly()   Write the segments and holes to a .poly file.              */
 /*                                                                           */
 /*****************************************************************************/
 
+#ifdef TRILIBRARY
+
 #ifdef ANSI_DECLARATORS
-void carveholes(struct mesh *m, struct behavior *b, REAL *holelist, int holes,
-                REAL *regionlist, int regions)
+void writepoly(struct mesh *m, struct behavior *b,
+               int **segmentlist, int **segmentmarkerlist)
 #else /* not ANSI_DECLARATORS */
-void carveholes(m, b, holelist, holes, regionlist, regions)
+void writepoly(m, b, segmentlist, segmentmarkerlist)
+struct mesh *m;
+struct behavior *b;
+int **segmentlist;
+int **segmentmarkerlist;
+#endif /* not ANSI_DECLARATORS */
+
+#else /* not TRILIBRARY */
+
+#ifdef ANSI_DECLARATORS
+void writepoly(struct mesh *m, struct behavior *b, char *polyfilename,
+               REAL *holelist, int holes, REAL *regionlist, int regions,
+               int argc, char **argv)
+#else /* not ANSI_DECLARATORS */
+void writepoly(m, b, polyfilename, holelist, holes, regionlist, regions,
+               argc, argv)
 struct mesh *m;
 struct behavior *b;
+char *polyfilename;
 REAL *holelist;
 int holes;
 REAL *regionlist;
 int regions;
+int argc;
+char **argv;
 #endif /* not ANSI_DECLARATORS */
 
-{
-  struct otri searchtri;
-  struct otri triangleloop;
-  struct otri *regiontris;
-  triangle **holetri;
-  triangle **regiontri;
-  vertex searchorg, searchdest;
-  enum locateresult intersect;
-  int i;
-  triangle ptr;                         /* Temporary variable used by sym(). */
-
-  if (!(b->quiet || (b->noholes && b->convex))) {
-    printf("Removing unwanted triangles.\n");
-    if (b->verbose && (holes > 0)) {
-      printf("  Marking holes for elimination.\n");
-    }
-  }
+#endif /* not TRILIBRARY */
 
-  if (regions > 0) {
-    /* Allocate storage for the triangles in which region points fall. */
-    regiontris = (struct otri *) trimalloc(regions *
-                                           (int) sizeof(struct otri));
-  } else {
-    regiontris = (struct otri *) NULL;
-  }
+{
+#ifdef TRILIBRARY
+  int *slist;
+  int *smlist;
+  int index;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+  long holenumber, regionnumber;
+#endif /* not TRILIBRARY */
+  struct osub subsegloop;
+  vertex endpoint1, endpoint2;
+  long subsegnumber;
 
-  if (((holes > 0) && !b->noholes) || !b->convex || (regions > 0)) {
-    /* Initialize a pool of viri to be used for holes, concavities, */
-    /*   regional attributes, and/or regional area constraints.     */
-    poolinit(&m->viri, sizeof(triangle *), VIRUSPERBLOCK, VIRUSPERBLOCK, 0);
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing segments.\n");
   }
-
-  if (!b->convex) {
-    /* Mark as infected any unprotected triangles on the boundary. */
-    /*   This is one way by which concavities are created.         */
-    infecthull(m, b);
+  /* Allocate memory for output segments if necessary. */
+  if (*segmentlist == (int *) NULL) {
+    *segmentlist = (int *) trimalloc((int) (m->subsegs.items * 2 *
+                                            sizeof(int)));
   }
-
-  if ((holes > 0) && !b->noholes) {
-    /* Infect each triangle in which a hole lies. */
-    for (i = 0; i < 2 * holes; i += 2) {
-      /* Ignore holes that aren't within the bounds of the mesh. */
-      if ((holelist[i] >= m->xmin) && (holelist[i] <= m->xmax)
-          && (holelist[i + 1] >= m->ymin) && (holelist[i + 1] <= m->ymax)) {
-        /* Start searching from some triangle on the outer boundary. */
-        searchtri.tri = m->dummytri;
-        searchtri.orient = 0;
-        symself(searchtri);
-        /* Ensure that the hole is to the left of this boundary edge; */
-        /*   otherwise, locate() will falsely report that the hole    */
-        /*   falls within the starting triangle.                      */
-        org(searchtri, searchorg);
-        dest(searchtri, searchdest);
-        if (counterclockwise(m, b, searchorg, searchdest, &holelist[i]) >
-            0.0) {
-          /* Find a triangle that contains the hole. */
-          intersect = locate(m, b, &holelist[i], &searchtri);
-          if ((intersect != OUTSIDE) && (!infected(searchtri))) {
-            /* Infect the triangle.  This is done by marking the triangle  */
-            /*   as infected and including the triangle in the virus pool. */
-            infect(searchtri);
-            holetri = (triangle **) poolalloc(&m->viri);
-            *holetri = searchtri.tri;
-          }
-        }
-      }
-    }
+  /* Allocate memory for output segment markers if necessary. */
+  if (!b->nobound && (*segmentmarkerlist == (int *) NULL)) {
+    *segmentmarkerlist = (int *) trimalloc((int) (m->subsegs.items *
+                                                  sizeof(int)));
   }
-
-  /* Now, we have to find all the regions BEFORE we carve the holes, because */
-  /*   locate() won't work when the triangulation is no longer convex.       */
-  /*   (Incidentally, this is the reason why regional attributes and area    */
-  /*   constraints can't be used when refining a preexisting mesh, which     */
-  /*   might not be convex; they can only be used with a freshly             */
-  /*   triangulated PSLG.)                                                   */
-  if (regions > 0) {
-    /* Find the starting triangle for each region. */
-    for (i = 0; i < regions; i++) {
-      regiontris[i].tri = m->dummytri;
-      /* Ignore region points that aren't within the bounds of the mesh. */
-      if ((regionlist[4 * i] >= m->xmin) && (regionlist[4 * i] <= m->xmax) &&
-          (regionlist[4 * i + 1] >= m->ymin) &&
-          (regionlist[4 * i + 1] <= m->ymax)) {
-        /* Start searching from some triangle on the outer boundary. */
-        searchtri.tri = m->dummytri;
-        searchtri.orient = 0;
-        symself(searchtri);
-        /* Ensure that the region point is to the left of this boundary */
-        /*   edge; otherwise, locate() will falsely report that the     */
-        /*   region point falls within the starting triangle.           */
-        org(searchtri, searchorg);
-        dest(searchtri, searchdest);
-        if (counterclockwise(m, b, searchorg, searchdest, &regionlist[4 * i]) >
-            0.0) {
-          /* Find a triangle that contains the region point. */
-          intersect = locate(m, b, &regionlist[4 * i], &searchtri);
-          if ((intersect != OUTSIDE) && (!infected(searchtri))) {
-            /* Record the triangle for processing after the */
-            /*   holes have been carved.                    */
-            otricopy(searchtri, regiontris[i]);
-          }
-        }
-      }
-    }
+  slist = *segmentlist;
+  smlist = *segmentmarkerlist;
+  index = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", polyfilename);
   }
-
-  if (m->viri.items > 0) {
-    /* Carve the holes and concavities. */
-    plague(m, b);
+  outfile = fopen(polyfilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", polyfilename);
+    triexit(1);
   }
-  /* The virus pool should be empty now. */
+  /* The zero indicates that the vertices are in a separate .node file. */
+  /*   Followed by number of dimensions, number of vertex attributes,   */
+  /*   and number of boundary markers (zero or one).                    */
+  fprintf(outfile, "%d  %d  %d  %d\n", 0, m->mesh_dim, m->nextras,
+          1 - b->nobound);
+  /* Number of segments, number of boundary markers (zero or one). */
+  fprintf(outfile, "%ld  %d\n", m->subsegs.items, 1 - b->nobound);
+#endif /* not TRILIBRARY */
 
-  if (regions > 0) {
-    if (!b->quiet) {
-      if (b->regionattrib) {
-        if (b->vararea) {
-          printf("Spreading regional attributes and area constraints.\n");
-        } else {
-          printf("Spreading regional attributes.\n");
-        }
-      } else { 
-        printf("Spreading regional area constraints.\n");
-      }
-    }
-    if (b->regionattrib && !b->refine) {
-      /* Assign every triangle a regional attribute of zero. */
-      traversalinit(&m->triangles);
-      triangleloop.orient = 0;
-      triangleloop.tri = triangletraverse(m);
-      while (triangleloop.tri != (triangle *) NULL) {
-        setelemattribute(triangleloop, m->eextras, 0.0);
-        triangleloop.tri = triangletraverse(m);
-      }
-    }
-    for (i = 0; i < regions; i++) {
-      if (regiontris[i].tri != m->dummytri) {
-        /* Make sure the triangle under consideration still exists. */
-        /*   It may have been eaten by the virus.                   */
-        if (!deadtri(regiontris[i].tri)) {
-          /* Put one triangle in the virus pool. */
-          infect(regiontris[i]);
-          regiontri = (triangle **) poolalloc(&m->viri);
-          *regiontri = regiontris[i].tri;
-          /* Apply one region's attribute and/or area constraint. */
-          regionplague(m, b, regionlist[4 * i + 2], regionlist[4 * i + 3]);
-          /* The virus pool should be empty now. */
-        }
-      }
+  traversalinit(&m->subsegs);
+  subsegloop.ss = subsegtraverse(m);
+  subsegloop.ssorient = 0;
+  subsegnumber = b->firstnumber;
+  while (subsegloop.ss != (subseg *) NULL) {
+    sorg(subsegloop, endpoint1);
+    sdest(subsegloop, endpoint2);
+#ifdef TRILIBRARY
+    /* Copy indices of the segment's two endpoints. */
+    slist[index++] = vertexmark(endpoint1);
+    slist[index++] = vertexmark(endpoint2);
+    if (!b->nobound) {
+      /* Copy the boundary marker. */
+      smlist[subsegnumber - b->firstnumber] = mark(subsegloop);
     }
-    if (b->regionattrib && !b->refine) {
-      /* Note the fact that each triangle has an additional attribute. */
-      m->eextras++;
+#else /* not TRILIBRARY */
+    /* Segment number, indices of its two endpoints, and possibly a marker. */
+    if (b->nobound) {
+      fprintf(outfile, "%4ld    %4d  %4d\n", subsegnumber,
+              vertexmark(endpoint1), vertexmark(endpoint2));
+    } else {
+      fprintf(outfile, "%4ld    %4d  %4d    %4d\n", subsegnumber,
+              vertexmark(endpoint1), vertexmark(endpoint2), mark(subsegloop));
     }
+#endif /* not TRILIBRARY */
+
+    subsegloop.ss = subsegtraverse(m);
+    subsegnumber++;
   }
 
-  /* Free up memory. */
-  if (((holes > 0) && !b->noholes) || !b->convex || (regions > 0)) {
-    pooldeinit(&m->viri);
+#ifndef TRILIBRARY
+#ifndef CDT_ONLY
+  fprintf(outfile, "%d\n", holes);
+  if (holes > 0) {
+    for (holenumber = 0; holenumber < holes; holenumber++) {
+      /* Hole number, x and y coordinates. */
+      fprintf(outfile, "%4ld   %.17g  %.17g\n", b->firstnumber + holenumber,
+              holelist[2 * holenumber], holelist[2 * holenumber + 1]);
+    }
   }
   if (regions > 0) {
-    trifree((VOID *) regiontris);
+    fprintf(outfile, "%d\n", regions);
+    for (regionnumber = 0; regionnumber < regions; regionnumber++) {
+      /* Region number, x and y coordinates, attribute, maximum area. */
+      fprintf(outfile, "%4ld   %.17g  %.17g  %.17g  %.17g\n",
+              b->firstnumber + regionnumber,
+              regionlist[4 * regionnumber], regionlist[4 * regionnumber + 1],
+              regionlist[4 * regionnumber + 2],
+              regionlist[4 * regionnumber + 3]);
+    }
   }
-}
-
-/**                                                                         **/
-/**                                                                         **/
-/********* Carving out holes and concavities ends here               *********/
+#endif /* not CDT_ONLY */
 
-/********* Mesh quality maintenance begins here                      *********/
-/**                                                                         **/
-/**                                                                         **/
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  tallyencs()   Traverse the entire list of subsegments, and check each    */
-/*                to see if it is encroached.  If so, add it to the list.    */
+/*  writeedges()   Write the edges to an .edge file.                         */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef CDT_ONLY
+#ifdef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-void tallyencs(struct mesh *m, struct behavior *b)
+void writeedges(struct mesh *m, struct behavior *b,
+                int **edgelist, int **edgemarkerlist)
 #else /* not ANSI_DECLARATORS */
-void tallyencs(m, b)
+void writeedges(m, b, edgelist, edgemarkerlist)
 struct mesh *m;
 struct behavior *b;
+int **edgelist;
+int **edgemarkerlist;
 #endif /* not ANSI_DECLARATORS */
 
-{
-  struct osub subsegloop;
-  int dummy;
+#else /* not TRILIBRARY */
 
-  traversalinit(&m->subsegs);
-  subsegloop.ssorient = 0;
-  subsegloop.ss = subsegtraverse(m);
-  while (subsegloop.ss != (subseg *) NULL) {
-    /* If the segment is encroached, add it to the list. */
-    dummy = checkseg4encroach(m, b, &subsegloop);
-    subsegloop.ss = subsegtraverse(m);
-  }
-}
+#ifdef ANSI_DECLARATORS
+void writeedges(struct mesh *m, struct behavior *b, char *edgefilename,
+                int argc, char **argv)
+#else /* not ANSI_DECLARATORS */
+void writeedges(m, b, edgefilename, argc, argv)
+struct mesh *m;
+struct behavior *b;
+char *edgefilename;
+int argc;
+char **argv;
+#endif /* not ANSI_DECLARATORS */
 
-#endif /* not CDT_ONLY */
+#endif /* not TRILIBRARY */
 
-/*****************************************************************************/
-/*                                                                           */
-/*  precisionerror()  Print an error message for precision problems.         */
-/*                                                                           */
-/*****************************************************************************/
+{
+#ifdef TRILIBRARY
+  int *elist;
+  int *emlist;
+  int index;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+#endif /* not TRILIBRARY */
+  struct otri triangleloop, trisym;
+  struct osub checkmark;
+  vertex p1, p2;
+  long edgenumber;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-#ifndef CDT_ONLY
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing edges.\n");
+  }
+  /* Allocate memory for edges if necessary. */
+  if (*edgelist == (int *) NULL) {
+    *edgelist = (int *) trimalloc((int) (m->edges * 2 * sizeof(int)));
+  }
+  /* Allocate memory for edge markers if necessary. */
+  if (!b->nobound && (*edgemarkerlist == (int *) NULL)) {
+    *edgemarkerlist = (int *) trimalloc((int) (m->edges * sizeof(int)));
+  }
+  elist = *edgelist;
+  emlist = *edgemarkerlist;
+  index = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", edgefilename);
+  }
+  outfile = fopen(edgefilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", edgefilename);
+    triexit(1);
+  }
+  /* Number of edges, number of boundary markers (zero or one). */
+  fprintf(outfile, "%ld  %d\n", m->edges, 1 - b->nobound);
+#endif /* not TRILIBRARY */
 
-void precisionerror()
-{
-  printf("Try increasing the area criterion and/or reducing the minimum\n");
-  printf("  allowable angle so that tiny triangles are not created.\n");
-#ifdef SINGLE
-  printf("Alternatively, try recompiling me with double precision\n");
-  printf("  arithmetic (by removing \"#define SINGLE\" from the\n");
-  printf("  source file or \"-DSINGLE\" from the makefile).\n");
-#endif /* SINGLE */
-}
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  edgenumber = b->firstnumber;
+  /* To loop over the set of edges, loop over all triangles, and look at   */
+  /*   the three edges of each triangle.  If there isn't another triangle  */
+  /*   adjacent to the edge, operate on the edge.  If there is another     */
+  /*   adjacent triangle, operate on the edge only if the current triangle */
+  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
+  /*   considered only once.                                               */
+  while (triangleloop.tri != (triangle *) NULL) {
+    for (triangleloop.orient = 0; triangleloop.orient < 3;
+         triangleloop.orient++) {
+      sym(triangleloop, trisym);
+      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+        org(triangleloop, p1);
+        dest(triangleloop, p2);
+#ifdef TRILIBRARY
+        elist[index++] = vertexmark(p1);
+        elist[index++] = vertexmark(p2);
+#endif /* TRILIBRARY */
+        if (b->nobound) {
+#ifndef TRILIBRARY
+          /* Edge number, indices of two endpoints. */
+          fprintf(outfile, "%4ld   %d  %d\n", edgenumber,
+                  vertexmark(p1), vertexmark(p2));
+#endif /* not TRILIBRARY */
+        } else {
+          /* Edge number, indices of two endpoints, and a boundary marker. */
+          /*   If there's no subsegment, the boundary marker is zero.      */
+          if (b->usesegments) {
+            tspivot(triangleloop, checkmark);
+            if (checkmark.ss == m->dummysub) {
+#ifdef TRILIBRARY
+              emlist[edgenumber - b->firstnumber] = 0;
+#else /* not TRILIBRARY */
+              fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
+                      vertexmark(p1), vertexmark(p2), 0);
+#endif /* not TRILIBRARY */
+            } else {
+#ifdef TRILIBRARY
+              emlist[edgenumber - b->firstnumber] = mark(checkmark);
+#else /* not TRILIBRARY */
+              fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
+                      vertexmark(p1), vertexmark(p2), mark(checkmark));
+#endif /* not TRILIBRARY */
+            }
+          } else {
+#ifdef TRILIBRARY
+            emlist[edgenumber - b->firstnumber] = trisym.tri == m->dummytri;
+#else /* not TRILIBRARY */
+            fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
+                    vertexmark(p1), vertexmark(p2), trisym.tri == m->dummytri);
+#endif /* not TRILIBRARY */
+          }
+        }
+        edgenumber++;
+      }
+    }
+    triangleloop.tri = triangletraverse(m);
+  }
 
-#endif /* not CDT_ONLY */
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  splitencsegs()   Split all the encroached subsegments.                   */
+/*  writevoronoi()   Write the Voronoi diagram to a .v.node and .v.edge      */
+/*                   file.                                                   */
 /*                                                                           */
-/*  Each encroached subsegment is repaired by splitting it - inserting a     */
-/*  vertex at or near its midpoint.  Newly inserted vertices may encroach    */
-/*  upon other subsegments; these are also repaired.                         */
+/*  The Voronoi diagram is the geometric dual of the Delaunay triangulation. */
+/*  Hence, the Voronoi vertices are listed by traversing the Delaunay        */
+/*  triangles, and the Voronoi edges are listed by traversing the Delaunay   */
+/*  edges.                                                                   */
 /*                                                                           */
-/*  `triflaws' is a flag that specifies whether one should take note of new  */
-/*  bad triangles that result from inserting vertices to repair encroached   */
-/*  subsegments.                                                             */
+/*  WARNING:  In order to assign numbers to the Voronoi vertices, this       */
+/*  procedure messes up the subsegments or the extra nodes of every          */
+/*  element.  Hence, you should call this procedure last.                    */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef CDT_ONLY
+#ifdef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-void splitencsegs(struct mesh *m, struct behavior *b, int triflaws)
+void writevoronoi(struct mesh *m, struct behavior *b, REAL **vpointlist,
+                  REAL **vpointattriblist, int **vpointmarkerlist,
+                  int **vedgelist, int **vedgemarkerlist, REAL **vnormlist)
 #else /* not ANSI_DECLARATORS */
-void splitencsegs(m, b, triflaws)
+void writevoronoi(m, b, vpointlist, vpointattriblist, vpointmarkerlist,
+                  vedgelist, vedgemarkerlist, vnormlist)
 struct mesh *m;
 struct behavior *b;
-int triflaws;
-#endif /* not ANSI_DECLARATORS */
-
-{
-  struct otri enctri;
-  struct otri testtri;
-  struct osub testsh;
-  struct osub currentenc;
-  struct badsubseg *encloop;
-  vertex eorg, edest, eapex;
-  vertex newvertex;
-  enum insertvertexresult success;
-  REAL segmentlength, nearestpoweroftwo;
-  REAL split;
-  REAL multiplier, divisor;
-  int acuteorg, acuteorg2, acutedest, acutedest2;
-  int dummy;
-  int i;
-  triangle ptr;                     /* Temporary variable used by stpivot(). */
-  subseg sptr;                        /* Temporary variable used by snext(). */
-
-  /* Note that steinerleft == -1 if an unlimited number */
-  /*   of Steiner points is allowed.                    */
-  while ((m->badsubsegs.items > 0) && (m->steinerleft != 0)) {
-    traversalinit(&m->badsubsegs);
-    encloop = badsubsegtraverse(m);
-    while ((encloop != (struct badsubseg *) NULL) && (m->steinerleft != 0)) {
-      sdecode(encloop->encsubseg, currentenc);
-      sorg(currentenc, eorg);
-      sdest(currentenc, edest);
-      /* Make sure that this segment is still the same segment it was   */
-      /*   when it was determined to be encroached.  If the segment was */
-      /*   enqueued multiple times (because several newly inserted      */
-      /*   vertices encroached it), it may have already been split.     */
-      if (!deadsubseg(currentenc.ss) &&
-          (eorg == encloop->subsegorg) && (edest == encloop->subsegdest)) {
-        /* To decide where to split a segment, we need to know if the   */
-        /*   segment shares an endpoint with an adjacent segment.       */
-        /*   The concern is that, if we simply split every encroached   */
-        /*   segment in its center, two adjacent segments with a small  */
-        /*   angle between them might lead to an infinite loop; each    */
-        /*   vertex added to split one segment will encroach upon the   */
-        /*   other segment, which must then be split with a vertex that */
-        /*   will encroach upon the first segment, and so on forever.   */
-        /* To avoid this, imagine a set of concentric circles, whose    */
-        /*   radii are powers of two, about each segment endpoint.      */
-        /*   These concentric circles determine where the segment is    */
-        /*   split.  (If both endpoints are shared with adjacent        */
-        /*   segments, split the segment in the middle, and apply the   */
-        /*   concentric circles for later splittings.)                  */
+REAL **vpointlist;
+REAL **vpointattriblist;
+int **vpointmarkerlist;
+int **vedgelist;
+int **vedgemarkerlist;
+REAL **vnormlist;
+#endif /* not ANSI_DECLARATORS */
 
-        /* Is the origin shared with another segment? */
-        stpivot(currentenc, enctri);
-        lnext(enctri, testtri);
-        tspivot(testtri, testsh);
-        acuteorg = testsh.ss != m->dummysub;
-        /* Is the destination shared with another segment? */
-        lnextself(testtri);
-        tspivot(testtri, testsh);
-        acutedest = testsh.ss != m->dummysub;
+#else /* not TRILIBRARY */
 
-        /* If we're using Chew's algorithm (rather than Ruppert's) */
-        /*   to define encroachment, delete free vertices from the */
-        /*   subsegment's diametral circle.                        */
-        if (!b->conformdel && !acuteorg && !acutedest) {
-          apex(enctri, eapex);
-          while ((vertextype(eapex) == FREEVERTEX) &&
-                 ((eorg[0] - eapex[0]) * (edest[0] - eapex[0]) +
-                  (eorg[1] - eapex[1]) * (edest[1] - eapex[1]) < 0.0)) {
-            deletevertex(m, b, &testtri);
-            stpivot(currentenc, enctri);
-            apex(enctri, eapex);
-            lprev(enctri, testtri);
-          }
-        }
+#ifdef ANSI_DECLARATORS
+void writevoronoi(struct mesh *m, struct behavior *b, char *vnodefilename,
+                  char *vedgefilename, int argc, char **argv)
+#else /* not ANSI_DECLARATORS */
+void writevoronoi(m, b, vnodefilename, vedgefilename, argc, argv)
+struct mesh *m;
+struct behavior *b;
+char *vnodefilename;
+char *vedgefilename;
+int argc;
+char **argv;
+#endif /* not ANSI_DECLARATORS */
 
-        /* Now, check the other side of the segment, if there's a triangle */
-        /*   there.                                                        */
-        sym(enctri, testtri);
-        if (testtri.tri != m->dummytri) {
-          /* Is the destination shared with another segment? */
-          lnextself(testtri);
-          tspivot(testtri, testsh);
-          acutedest2 = testsh.ss != m->dummysub;
-          acutedest = acutedest || acutedest2;
-          /* Is the origin shared with another segment? */
-          lnextself(testtri);
-          tspivot(testtri, testsh);
-          acuteorg2 = testsh.ss != m->dummysub;
-          acuteorg = acuteorg || acuteorg2;
+#endif /* not TRILIBRARY */
 
-          /* Delete free vertices from the subsegment's diametral circle. */
-          if (!b->conformdel && !acuteorg2 && !acutedest2) {
-            org(testtri, eapex);
-            while ((vertextype(eapex) == FREEVERTEX) &&
-                   ((eorg[0] - eapex[0]) * (edest[0] - eapex[0]) +
-                    (eorg[1] - eapex[1]) * (edest[1] - eapex[1]) < 0.0)) {
-              deletevertex(m, b, &testtri);
-              sym(enctri, testtri);
-              apex(testtri, eapex);
-              lprevself(testtri);
-            }
-          }
-        }
+{
+#ifdef TRILIBRARY
+  REAL *plist;
+  REAL *palist;
+  int *elist;
+  REAL *normlist;
+  int coordindex;
+  int attribindex;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+#endif /* not TRILIBRARY */
+  struct otri triangleloop, trisym;
+  vertex torg, tdest, tapex;
+  REAL circumcenter[2];
+  REAL xi, eta;
+  long vnodenumber, vedgenumber;
+  int p1, p2;
+  int i;
+  triangle ptr;                         /* Temporary variable used by sym(). */
 
-        /* Use the concentric circles if exactly one endpoint is shared */
-        /*   with another adjacent segment.                             */
-        if (acuteorg || acutedest) {
-          segmentlength = sqrt((edest[0] - eorg[0]) * (edest[0] - eorg[0]) +
-                               (edest[1] - eorg[1]) * (edest[1] - eorg[1]));
-          /* Find the power of two that most evenly splits the segment.  */
-          /*   The worst case is a 2:1 ratio between subsegment lengths. */
-          nearestpoweroftwo = 1.0;
-          while (segmentlength > 3.0 * nearestpoweroftwo) {
-            nearestpoweroftwo *= 2.0;
-          }
-          while (segmentlength < 1.5 * nearestpoweroftwo) {
-            nearestpoweroftwo *= 0.5;
-          }
-          /* Where do we split the segment? */
-          split = nearestpoweroftwo / segmentlength;
-          if (acutedest) {
-            split = 1.0 - split;
-          }
-        } else {
-          /* If we're not worried about adjacent segments, split */
-          /*   this segment in the middle.                       */
-          split = 0.5;
-        }
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing Voronoi vertices.\n");
+  }
+  /* Allocate memory for Voronoi vertices if necessary. */
+  if (*vpointlist == (REAL *) NULL) {
+    *vpointlist = (REAL *) trimalloc((int) (m->triangles.items * 2 *
+                                            sizeof(REAL)));
+  }
+  /* Allocate memory for Voronoi vertex attributes if necessary. */
+  if (*vpointattriblist == (REAL *) NULL) {
+    *vpointattriblist = (REAL *) trimalloc((int) (m->triangles.items *
+                                                  m->nextras * sizeof(REAL)));
+  }
+  *vpointmarkerlist = (int *) NULL;
+  plist = *vpointlist;
+  palist = *vpointattriblist;
+  coordindex = 0;
+  attribindex = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", vnodefilename);
+  }
+  outfile = fopen(vnodefilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", vnodefilename);
+    triexit(1);
+  }
+  /* Number of triangles, two dimensions, number of vertex attributes, */
+  /*   no markers.                                                     */
+  fprintf(outfile, "%ld  %d  %d  %d\n", m->triangles.items, 2, m->nextras, 0);
+#endif /* not TRILIBRARY */
 
-        /* Create the new vertex. */
-        newvertex = (vertex) poolalloc(&m->vertices);
-        /* Interpolate its coordinate and attributes. */
-        for (i = 0; i < 2 + m->nextras; i++) {
-          newvertex[i] = eorg[i] + split * (edest[i] - eorg[i]);
-        }
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  triangleloop.orient = 0;
+  vnodenumber = b->firstnumber;
+  while (triangleloop.tri != (triangle *) NULL) {
+    org(triangleloop, torg);
+    dest(triangleloop, tdest);
+    apex(triangleloop, tapex);
+    findcircumcenter(m, b, torg, tdest, tapex, circumcenter, &xi, &eta, 0);
+#ifdef TRILIBRARY
+    /* X and y coordinates. */
+    plist[coordindex++] = circumcenter[0];
+    plist[coordindex++] = circumcenter[1];
+    for (i = 2; i < 2 + m->nextras; i++) {
+      /* Interpolate the vertex attributes at the circumcenter. */
+      palist[attribindex++] = torg[i] + xi * (tdest[i] - torg[i])
+                                     + eta * (tapex[i] - torg[i]);
+    }
+#else /* not TRILIBRARY */
+    /* Voronoi vertex number, x and y coordinates. */
+    fprintf(outfile, "%4ld    %.17g  %.17g", vnodenumber, circumcenter[0],
+            circumcenter[1]);
+    for (i = 2; i < 2 + m->nextras; i++) {
+      /* Interpolate the vertex attributes at the circumcenter. */
+      fprintf(outfile, "  %.17g", torg[i] + xi * (tdest[i] - torg[i])
+                                         + eta * (tapex[i] - torg[i]));
+    }
+    fprintf(outfile, "\n");
+#endif /* not TRILIBRARY */
 
-        if (!b->noexact) {
-          /* Roundoff in the above calculation may yield a `newvertex'   */
-          /*   that is not precisely collinear with `eorg' and `edest'.  */
-          /*   Improve collinearity by one step of iterative refinement. */
-          multiplier = counterclockwise(m, b, eorg, edest, newvertex);
-          divisor = ((eorg[0] - edest[0]) * (eorg[0] - edest[0]) +
-                     (eorg[1] - edest[1]) * (eorg[1] - edest[1]));
-          if ((multiplier != 0.0) && (divisor != 0.0)) {
-            multiplier = multiplier / divisor;
-            /* Watch out for NANs. */
-            if (multiplier == multiplier) {
-              newvertex[0] += multiplier * (edest[1] - eorg[1]);
-              newvertex[1] += multiplier * (eorg[0] - edest[0]);
-            }
-          }
-        }
+    * (int *) (triangleloop.tri + 6) = (int) vnodenumber;
+    triangleloop.tri = triangletraverse(m);
+    vnodenumber++;
+  }
 
-        setvertexmark(newvertex, mark(currentenc));
-        setvertextype(newvertex, SEGMENTVERTEX);
-        if (b->verbose > 1) {
-          printf(
-  "  Splitting subsegment (%.12g, %.12g) (%.12g, %.12g) at (%.12g, %.12g).\n",
-                 eorg[0], eorg[1], edest[0], edest[1],
-                 newvertex[0], newvertex[1]);
-        }
-        /* Check whether the new vertex lies on an endpoint. */
-        if (((newvertex[0] == eorg[0]) && (newvertex[1] == eorg[1])) ||
-            ((newvertex[0] == edest[0]) && (newvertex[1] == edest[1]))) {
-          printf("Error:  Ran out of precision at (%.12g, %.12g).\n",
-                 newvertex[0], newvertex[1]);
-          printf("I attempted to split a segment to a smaller size than\n");
-          printf("  can be accommodated by the finite precision of\n");
-          printf("  floating point arithmetic.\n");
-          precisionerror();
-          triexit(1);
-        }
-        /* Insert the splitting vertex.  This should always succeed. */
-        success = insertvertex(m, b, newvertex, &enctri, &currentenc,
-                               1, triflaws);
-        if ((success != SUCCESSFULVERTEX) && (success != ENCROACHINGVERTEX)) {
-          printf("Internal error in splitencsegs():\n");
-          printf("  Failure to split a segment.\n");
-          internalerror();
-        }
-        if (m->steinerleft > 0) {
-          m->steinerleft--;
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
+
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing Voronoi edges.\n");
+  }
+  /* Allocate memory for output Voronoi edges if necessary. */
+  if (*vedgelist == (int *) NULL) {
+    *vedgelist = (int *) trimalloc((int) (m->edges * 2 * sizeof(int)));
+  }
+  *vedgemarkerlist = (int *) NULL;
+  /* Allocate memory for output Voronoi norms if necessary. */
+  if (*vnormlist == (REAL *) NULL) {
+    *vnormlist = (REAL *) trimalloc((int) (m->edges * 2 * sizeof(REAL)));
+  }
+  elist = *vedgelist;
+  normlist = *vnormlist;
+  coordindex = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", vedgefilename);
+  }
+  outfile = fopen(vedgefilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", vedgefilename);
+    triexit(1);
+  }
+  /* Number of edges, zero boundary markers. */
+  fprintf(outfile, "%ld  %d\n", m->edges, 0);
+#endif /* not TRILIBRARY */
+
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  vedgenumber = b->firstnumber;
+  /* To loop over the set of edges, loop over all triangles, and look at   */
+  /*   the three edges of each triangle.  If there isn't another triangle  */
+  /*   adjacent to the edge, operate on the edge.  If there is another     */
+  /*   adjacent triangle, operate on the edge only if the current triangle */
+  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
+  /*   considered only once.                                               */
+  while (triangleloop.tri != (triangle *) NULL) {
+    for (triangleloop.orient = 0; triangleloop.orient < 3;
+         triangleloop.orient++) {
+      sym(triangleloop, trisym);
+      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
+        /* Find the number of this triangle (and Voronoi vertex). */
+        p1 = * (int *) (triangleloop.tri + 6);
+        if (trisym.tri == m->dummytri) {
+          org(triangleloop, torg);
+          dest(triangleloop, tdest);
+#ifdef TRILIBRARY
+          /* Copy an infinite ray.  Index of one endpoint, and -1. */
+          elist[coordindex] = p1;
+          normlist[coordindex++] = tdest[1] - torg[1];
+          elist[coordindex] = -1;
+          normlist[coordindex++] = torg[0] - tdest[0];
+#else /* not TRILIBRARY */
+          /* Write an infinite ray.  Edge number, index of one endpoint, -1, */
+          /*   and x and y coordinates of a vector representing the          */
+          /*   direction of the ray.                                         */
+          fprintf(outfile, "%4ld   %d  %d   %.17g  %.17g\n", vedgenumber,
+                  p1, -1, tdest[1] - torg[1], torg[0] - tdest[0]);
+#endif /* not TRILIBRARY */
+        } else {
+          /* Find the number of the adjacent triangle (and Voronoi vertex). */
+          p2 = * (int *) (trisym.tri + 6);
+          /* Finite edge.  Write indices of two endpoints. */
+#ifdef TRILIBRARY
+          elist[coordindex] = p1;
+          normlist[coordindex++] = 0.0;
+          elist[coordindex] = p2;
+          normlist[coordindex++] = 0.0;
+#else /* not TRILIBRARY */
+          fprintf(outfile, "%4ld   %d  %d\n", vedgenumber, p1, p2);
+#endif /* not TRILIBRARY */
         }
-        /* Check the two new subsegments to see if they're encroached. */
-        dummy = checkseg4encroach(m, b, &currentenc);
-        snextself(currentenc);
-        dummy = checkseg4encroach(m, b, &currentenc);
+        vedgenumber++;
       }
-
-      badsubsegdealloc(m, encloop);
-      encloop = badsubsegtraverse(m);
     }
+    triangleloop.tri = triangletraverse(m);
   }
-}
-
-#endif /* not CDT_ONLY */
 
-/*****************************************************************************/
-/*                                                                           */
-/*  tallyfaces()   Test every triangle in the mesh for quality measures.     */
-/*                                                                           */
-/*****************************************************************************/
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
+}
 
-#ifndef CDT_ONLY
+#ifdef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-void tallyfaces(struct mesh *m, struct behavior *b)
+void writeneighbors(struct mesh *m, struct behavior *b, int **neighborlist)
 #else /* not ANSI_DECLARATORS */
-void tallyfaces(m, b)
+void writeneighbors(m, b, neighborlist)
 struct mesh *m;
 struct behavior *b;
+int **neighborlist;
 #endif /* not ANSI_DECLARATORS */
 
-{
-  struct otri triangleloop;
-
-  if (b->verbose) {
-    printf("  Making a list of bad triangles.\n");
-  }
-  traversalinit(&m->triangles);
-  triangleloop.orient = 0;
-  triangleloop.tri = triangletraverse(m);
-  while (triangleloop.tri != (triangle *) NULL) {
-    /* If the triangle is bad, enqueue it. */
-    testtriangle(m, b, &triangleloop);
-    triangleloop.tri = triangletraverse(m);
-  }
-}
-
-#endif /* not CDT_ONLY */
-
-/*****************************************************************************/
-/*                                                                           */
-/*  splittriangle()   Inserts a vertex at the circumcenter of a triangle.    */
-/*                    Deletes the newly inserted vertex if it encroaches     */
-/*                    upon a segment.                                        */
-/*                                                                           */
-/*****************************************************************************/
-
-#ifndef CDT_ONLY
+#else /* not TRILIBRARY */
 
 #ifdef ANSI_DECLARATORS
-void splittriangle(struct mesh *m, struct behavior *b,
-                   struct badtriang *badtri)
+void writeneighbors(struct mesh *m, struct behavior *b, char *neighborfilename,
+                    int argc, char **argv)
 #else /* not ANSI_DECLARATORS */
-void splittriangle(m, b, badtri)
+void writeneighbors(m, b, neighborfilename, argc, argv)
 struct mesh *m;
 struct behavior *b;
-struct badtriang *badtri;
+char *neighborfilename;
+int argc;
+char **argv;
 #endif /* not ANSI_DECLARATORS */
 
-{
-  struct otri badotri;
-  vertex borg, bdest, bapex;
-  vertex newvertex;
-  REAL xi, eta;
-  enum insertvertexresult success;
-  int errorflag;
-  int i;
-
-  decode(badtri->poortri, badotri);
-  org(badotri, borg);
-  dest(badotri, bdest);
-  apex(badotri, bapex);
-  /* Make sure that this triangle is still the same triangle it was      */
-  /*   when it was tested and determined to be of bad quality.           */
-  /*   Subsequent transformations may have made it a different triangle. */
-  if (!deadtri(badotri.tri) && (borg == badtri->triangorg) &&
-      (bdest == badtri->triangdest) && (bapex == badtri->triangapex)) {
-    if (b->verbose > 1) {
-      printf("  Splitting this triangle at its circumcenter:\n");
-      printf("    (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n", borg[0],
-             borg[1], bdest[0], bdest[1], bapex[0], bapex[1]);
-    }
-
-    errorflag = 0;
-    /* Create a new vertex at the triangle's circumcenter. */
-    newvertex = (vertex) poolalloc(&m->vertices);
-    findcircumcenter(m, b, borg, bdest, bapex, newvertex, &xi, &eta, 1);
+#endif /* not TRILIBRARY */
 
-    /* Check whether the new vertex lies on a triangle vertex. */
-    if (((newvertex[0] == borg[0]) && (newvertex[1] == borg[1])) ||
-        ((newvertex[0] == bdest[0]) && (newvertex[1] == bdest[1])) ||
-        ((newvertex[0] == bapex[0]) && (newvertex[1] == bapex[1]))) {
-      if (!b->quiet) {
-        printf(
-             "Warning:  New vertex (%.12g, %.12g) falls on existing vertex.\n",
-               newvertex[0], newvertex[1]);
-        errorflag = 1;
-      }
-      vertexdealloc(m, newvertex);
-    } else {
-      for (i = 2; i < 2 + m->nextras; i++) {
-        /* Interpolate the vertex attributes at the circumcenter. */
-        newvertex[i] = borg[i] + xi * (bdest[i] - borg[i])
-                              + eta * (bapex[i] - borg[i]);
-      }
-      /* The new vertex must be in the interior, and therefore is a */
-      /*   free vertex with a marker of zero.                       */
-      setvertexmark(newvertex, 0);
-      setvertextype(newvertex, FREEVERTEX);
+{
+#ifdef TRILIBRARY
+  int *nlist;
+  int index;
+#else /* not TRILIBRARY */
+  FILE *outfile;
+#endif /* not TRILIBRARY */
+  struct otri triangleloop, trisym;
+  long elementnumber;
+  int neighbor1, neighbor2, neighbor3;
+  triangle ptr;                         /* Temporary variable used by sym(). */
 
-      /* Ensure that the handle `badotri' does not represent the longest  */
-      /*   edge of the triangle.  This ensures that the circumcenter must */
-      /*   fall to the left of this edge, so point location will work.    */
-      /*   (If the angle org-apex-dest exceeds 90 degrees, then the       */
-      /*   circumcenter lies outside the org-dest edge, and eta is        */
-      /*   negative.  Roundoff error might prevent eta from being         */
-      /*   negative when it should be, so I test eta against xi.)         */
-      if (eta < xi) {
-        lprevself(badotri);
-      }
+#ifdef TRILIBRARY
+  if (!b->quiet) {
+    printf("Writing neighbors.\n");
+  }
+  /* Allocate memory for neighbors if necessary. */
+  if (*neighborlist == (int *) NULL) {
+    *neighborlist = (int *) trimalloc((int) (m->triangles.items * 3 *
+                                             sizeof(int)));
+  }
+  nlist = *neighborlist;
+  index = 0;
+#else /* not TRILIBRARY */
+  if (!b->quiet) {
+    printf("Writing %s.\n", neighborfilename);
+  }
+  outfile = fopen(neighborfilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", neighborfilename);
+    triexit(1);
+  }
+  /* Number of triangles, three neighbors per triangle. */
+  fprintf(outfile, "%ld  %d\n", m->triangles.items, 3);
+#endif /* not TRILIBRARY */
 
-      /* Insert the circumcenter, searching from the edge of the triangle, */
-      /*   and maintain the Delaunay property of the triangulation.        */
-      success = insertvertex(m, b, newvertex, &badotri, (struct osub *) NULL,
-                             1, 1);
-      if (success == SUCCESSFULVERTEX) {
-        if (m->steinerleft > 0) {
-          m->steinerleft--;
-        }
-      } else if (success == ENCROACHINGVERTEX) {
-        /* If the newly inserted vertex encroaches upon a subsegment, */
-        /*   delete the new vertex.                                   */
-        undovertex(m, b);
-        if (b->verbose > 1) {
-          printf("  Rejecting (%.12g, %.12g).\n", newvertex[0], newvertex[1]);
-        }
-        vertexdealloc(m, newvertex);
-      } else if (success == VIOLATINGVERTEX) {
-        /* Failed to insert the new vertex, but some subsegment was */
-        /*   marked as being encroached.                            */
-        vertexdealloc(m, newvertex);
-      } else {                                 /* success == DUPLICATEVERTEX */
-        /* Couldn't insert the new vertex because a vertex is already there. */
-        if (!b->quiet) {
-          printf(
-            "Warning:  New vertex (%.12g, %.12g) falls on existing vertex.\n",
-                 newvertex[0], newvertex[1]);
-          errorflag = 1;
-        }
-        vertexdealloc(m, newvertex);
-      }
-    }
-    if (errorflag) {
-      if (b->verbose) {
-        printf("  The new vertex is at the circumcenter of triangle\n");
-        printf("    (%.12g, %.12g) (%.12g, %.12g) (%.12g, %.12g)\n",
-               borg[0], borg[1], bdest[0], bdest[1], bapex[0], bapex[1]);
-      }
-      printf("This probably means that I am trying to refine triangles\n");
-      printf("  to a smaller size than can be accommodated by the finite\n");
-      printf("  precision of floating point arithmetic.  (You can be\n");
-      printf("  sure of this if I fail to terminate.)\n");
-      precisionerror();
-    }
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  triangleloop.orient = 0;
+  elementnumber = b->firstnumber;
+  while (triangleloop.tri != (triangle *) NULL) {
+    * (int *) (triangleloop.tri + 6) = (int) elementnumber;
+    triangleloop.tri = triangletraverse(m);
+    elementnumber++;
   }
-}
+  * (int *) (m->dummytri + 6) = -1;
 
-#endif /* not CDT_ONLY */
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  elementnumber = b->firstnumber;
+  while (triangleloop.tri != (triangle *) NULL) {
+    triangleloop.orient = 1;
+    sym(triangleloop, trisym);
+    neighbor1 = * (int *) (trisym.tri + 6);
+    triangleloop.orient = 2;
+    sym(triangleloop, trisym);
+    neighbor2 = * (int *) (trisym.tri + 6);
+    triangleloop.orient = 0;
+    sym(triangleloop, trisym);
+    neighbor3 = * (int *) (trisym.tri + 6);
+#ifdef TRILIBRARY
+    nlist[index++] = neighbor1;
+    nlist[index++] = neighbor2;
+    nlist[index++] = neighbor3;
+#else /* not TRILIBRARY */
+    /* Triangle number, neighboring triangle numbers. */
+    fprintf(outfile, "%4ld    %d  %d  %d\n", elementnumber,
+            neighbor1, neighbor2, neighbor3);
+#endif /* not TRILIBRARY */
+
+    triangleloop.tri = triangletraverse(m);
+    elementnumber++;
+  }
+
+#ifndef TRILIBRARY
+  finishfile(outfile, argc, argv);
+#endif /* not TRILIBRARY */
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  enforcequality()   Remove all the encroached subsegments and bad         */
-/*                     triangles from the triangulation.                     */
+/*  writeoff()   Write the triangulation to an .off file.                    */
+/*                                                                           */
+/*  OFF stands for the Object File Format, a format used by the Geometry     */
+/*  Center's Geomview package.                                               */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef CDT_ONLY
+#ifndef TRILIBRARY
 
 #ifdef ANSI_DECLARATORS
-void enforcequality(struct mesh *m, struct behavior *b)
+void writeoff(struct mesh *m, struct behavior *b, char *offfilename,
+              int argc, char **argv)
 #else /* not ANSI_DECLARATORS */
-void enforcequality(m, b)
+void writeoff(m, b, offfilename, argc, argv)
 struct mesh *m;
 struct behavior *b;
+char *offfilename;
+int argc;
+char **argv;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct badtriang *badtri;
-  int i;
+  FILE *outfile;
+  struct otri triangleloop;
+  vertex vertexloop;
+  vertex p1, p2, p3;
+  long outvertices;
 
   if (!b->quiet) {
-    printf("Adding Steiner points to enforce quality.\n");
+    printf("Writing %s.\n", offfilename);
   }
-  /* Initialize the pool of encroached subsegments. */
-  poolinit(&m->badsubsegs, sizeof(struct badsubseg), BADSUBSEGPERBLOCK,
-           BADSUBSEGPERBLOCK, 0);
-  if (b->verbose) {
-    printf("  Looking for encroached subsegments.\n");
+
+  if (b->jettison) {
+    outvertices = m->vertices.items - m->undeads;
+  } else {
+    outvertices = m->vertices.items;
   }
-  /* Test all segments to see if they're encroached. */
-  tallyencs(m, b);
-  if (b->verbose && (m->badsubsegs.items > 0)) {
-    printf("  Splitting encroached subsegments.\n");
+
+  outfile = fopen(offfilename, "w");
+  if (outfile == (FILE *) NULL) {
+    printf("  Error:  Cannot create file %s.\n", offfilename);
+    triexit(1);
   }
-  /* Fix encroached subsegments without noting bad triangles. */
-  splitencsegs(m, b, 0);
-  /* At this point, if we haven't run out of Steiner points, the */
-  /*   triangulation should be (conforming) Delaunay.            */
+  /* Number of vertices, triangles, and edges. */
+  fprintf(outfile, "OFF\n%ld  %ld  %ld\n", outvertices, m->triangles.items,
+          m->edges);
 
-  /* Next, we worry about enforcing triangle quality. */
-  if ((b->minangle > 0.0) || b->vararea || b->fixedarea || b->usertest) {
-    /* Initialize the pool of bad triangles. */
-    poolinit(&m->badtriangles, sizeof(struct badtriang), BADTRIPERBLOCK,
-             BADTRIPERBLOCK, 0);
-    /* Initialize the queues of bad triangles. */
-    for (i = 0; i < 4096; i++) {
-      m->queuefront[i] = (struct badtriang *) NULL;
-    }
-    m->firstnonemptyq = -1;
-    /* Test all triangles to see if they're bad. */
-    tallyfaces(m, b);
-    /* Initialize the pool of recently flipped triangles. */
-    poolinit(&m->flipstackers, sizeof(struct flipstacker), FLIPSTACKERPERBLOCK,
-             FLIPSTACKERPERBLOCK, 0);
-    m->checkquality = 1;
-    if (b->verbose) {
-      printf("  Splitting bad triangles.\n");
-    }
-    while ((m->badtriangles.items > 0) && (m->steinerleft != 0)) {
-      /* Fix one bad triangle by inserting a vertex at its circumcenter. */
-      badtri = dequeuebadtriang(m);
-      splittriangle(m, b, badtri);
-      if (m->badsubsegs.items > 0) {
-        /* Put bad triangle back in queue for another try later. */
-        enqueuebadtriang(m, b, badtri);
-        /* Fix any encroached subsegments that resulted. */
-        /*   Record any new bad triangles that result.   */
-        splitencsegs(m, b, 1);
-      } else {
-        /* Return the bad triangle to the pool. */
-        pooldealloc(&m->badtriangles, (VOID *) badtri);
-      }
+  /* Write the vertices. */
+  traversalinit(&m->vertices);
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
+      /* The "0.0" is here because the OFF format uses 3D coordinates. */
+      fprintf(outfile, " %.17g  %.17g  %.17g\n", vertexloop[0], vertexloop[1],
+              0.0);
     }
+    vertexloop = vertextraverse(m);
   }
-  /* At this point, if the "-D" switch was selected and we haven't run out  */
-  /*   of Steiner points, the triangulation should be (conforming) Delaunay */
-  /*   and have no low-quality triangles.                                   */
 
-  /* Might we have run out of Steiner points too soon? */
-  if (!b->quiet && b->conformdel && (m->badsubsegs.items > 0) &&
-      (m->steinerleft == 0)) {
-    printf("\nWarning:  I ran out of Steiner points, but the mesh has\n");
-    if (m->badsubsegs.items == 1) {
-      printf("  one encroached subsegment, and therefore might not be truly\n"
-             );
-    } else {
-      printf("  %ld encroached subsegments, and therefore might not be truly\n"
-             , m->badsubsegs.items);
-    }
-    printf("  Delaunay.  If the Delaunay property is important to you,\n");
-    printf("  try increasing the number of Steiner points (controlled by\n");
-    printf("  the -S switch) slightly and try again.\n\n");
+  /* Write the triangles. */
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  triangleloop.orient = 0;
+  while (triangleloop.tri != (triangle *) NULL) {
+    org(triangleloop, p1);
+    dest(triangleloop, p2);
+    apex(triangleloop, p3);
+    /* The "3" means a three-vertex polygon. */
+    fprintf(outfile, " 3   %4d  %4d  %4d\n", vertexmark(p1) - b->firstnumber,
+            vertexmark(p2) - b->firstnumber, vertexmark(p3) - b->firstnumber);
+    triangleloop.tri = triangletraverse(m);
   }
+  finishfile(outfile, argc, argv);
 }
 
-#endif /* not CDT_ONLY */
+#endif /* not TRILIBRARY */
 
 /**                                                                         **/
 /**                                                                         **/
-/********* Mesh quality maintenance ends here                        *********/
+/********* File I/O routines end here                                *********/
+
+#ifdef TRILIBRARY
+
+/********* Workspace routines begin here                            *********/
+/**                                                                         **/
+/**                                                                         **/
 
 /*****************************************************************************/
 /*                                                                           */
-/*  highorder()   Create extra nodes for quadratic subparametric elements.   */
+/*  A workspace is a mesh whose memory is kept from one call of              */
+/*  triangulatews() to the next.  Its pools are restarted (poolrestart())    */
+/*  rather than freed, and the output arrays handed back in `out' are owned  */
+/*  by the workspace and grown only when a bigger mesh comes along.  Once a  */
+/*  workspace has seen the biggest mesh it is going to see, triangulating    */
+/*  does no memory allocation at all.                                        */
+/*                                                                           */
+/*****************************************************************************/
+
+struct trispace {
+  VOID *memory;
+  int bytes;
+};
+
+struct triangulateworkspace {
+  struct mesh m;
+  struct trispace pointlist, pointattributelist, pointmarkerlist;
+  struct trispace trianglelist, triangleattributelist, neighborlist;
+  struct trispace segmentlist, segmentmarkerlist;
+  struct trispace edgelist, edgemarkerlist;
+  struct triangulatestats stats;
+  long maxtriangles;                        /* Budget of every call, if any. */
+  long long maxnanoseconds;
+
+  /* A live mesh; see trilivebegin(). */
+  int live;                               /* Nonzero while it may be edited. */
+  struct behavior liveb;                   /* The switches it was made with. */
+  REAL livexmin, liveymin, livexmax, liveymax;                 /* The frame. */
+  vertex liveframe;                              /* One corner of the frame. */
+  int liveids;                                  /* Number of ids handed out. */
+  int livefreeids;                    /* Number of ids waiting to be reused. */
+  struct trispace livevertices;                        /* Vertex of each id. */
+  struct trispace livefree;                     /* Ids waiting to be reused. */
+  struct trispace liveindex;                    /* Output number of each id. */
+  struct trispace livestack, livecross, liveends;          /* Scratch space. */
+  struct trispace livelink, livehole;      /* Scratch space of liveremove(). */
+  int livestacksize;                                /* Edges on `livestack'. */
+  struct trispace livepointlist, livemarkerlist;                 /* Input of */
+  struct trispace livesegmentlist;                        /* trilivebegin(). */
+
+  /* Refinement the budget stopped; see trirefine(). */
+  int refining;                               /* Nonzero while it may go on. */
+  struct behavior refineb;              /* The switches it was started with. */
+};
+
+/*****************************************************************************/
+/*                                                                           */
+/*  spacereserve()   Make sure a workspace array has room for `bytes' bytes. */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void highorder(struct mesh *m, struct behavior *b)
+VOID *spacereserve(struct triangulateworkspace *ws, struct trispace *space,
+                   int bytes)
 #else /* not ANSI_DECLARATORS */
-void highorder(m, b)
-struct mesh *m;
-struct behavior *b;
+VOID *spacereserve(ws, space, bytes)
+struct triangulateworkspace *ws;
+struct trispace *space;
+int bytes;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri triangleloop, trisym;
-  struct osub checkmark;
-  vertex newvertex;
-  vertex torg, tdest;
-  int i;
-  triangle ptr;                         /* Temporary variable used by sym(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
-
-  if (!b->quiet) {
-    printf("Adding vertices for second-order triangles.\n");
-  }
-  /* The following line ensures that dead items in the pool of nodes    */
-  /*   cannot be allocated for the extra nodes associated with high     */
-  /*   order elements.  This ensures that the primary nodes (at the     */
-  /*   corners of elements) will occur earlier in the output files, and */
-  /*   have lower indices, than the extra nodes.                        */
-  m->vertices.deaditemstack = (VOID *) NULL;
-
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  /* To loop over the set of edges, loop over all triangles, and look at   */
-  /*   the three edges of each triangle.  If there isn't another triangle  */
-  /*   adjacent to the edge, operate on the edge.  If there is another     */
-  /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
-  while (triangleloop.tri != (triangle *) NULL) {
-    for (triangleloop.orient = 0; triangleloop.orient < 3;
-         triangleloop.orient++) {
-      sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
-        org(triangleloop, torg);
-        dest(triangleloop, tdest);
-        /* Create a new node in the middle of the edge.  Interpolate */
-        /*   its attributes.                                         */
-        newvertex = (vertex) poolalloc(&m->vertices);
-        for (i = 0; i < 2 + m->nextras; i++) {
-          newvertex[i] = 0.5 * (torg[i] + tdest[i]);
-        }
-        /* Set the new node's marker to zero or one, depending on */
-        /*   whether it lies on a boundary.                       */
-        setvertexmark(newvertex, trisym.tri == m->dummytri);
-        setvertextype(newvertex,
-                      trisym.tri == m->dummytri ? FREEVERTEX : SEGMENTVERTEX);
-        if (b->usesegments) {
-          tspivot(triangleloop, checkmark);
-          /* If this edge is a segment, transfer the marker to the new node. */
-          if (checkmark.ss != m->dummysub) {
-            setvertexmark(newvertex, mark(checkmark));
-            setvertextype(newvertex, SEGMENTVERTEX);
-          }
-        }
-        if (b->verbose > 1) {
-          printf("  Creating (%.12g, %.12g).\n", newvertex[0], newvertex[1]);
-        }
-        /* Record the new node in the (one or two) adjacent elements. */
-        triangleloop.tri[m->highorderindex + triangleloop.orient] =
-                (triangle) newvertex;
-        if (trisym.tri != m->dummytri) {
-          trisym.tri[m->highorderindex + trisym.orient] = (triangle) newvertex;
-        }
-      }
+  if ((space->memory == (VOID *) NULL) || (space->bytes < bytes)) {
+    if (space->memory != (VOID *) NULL) {
+      memfree(&ws->m.memory, space->memory);
+      space->memory = (VOID *) NULL;
     }
-    triangleloop.tri = triangletraverse(m);
+    /* Never ask for zero bytes; some malloc()s return NULL for that. */
+    space->bytes = (bytes > 0) ? bytes : (int) sizeof(REAL);
+    space->memory = memalloc(&ws->m.memory, space->bytes);
   }
+  return space->memory;
 }
 
-/********* File I/O routines begin here                              *********/
-/**                                                                         **/
-/**                                                                         **/
-
 /*****************************************************************************/
 /*                                                                           */
-/*  readline()   Read a nonempty line from a file.                           */
-/*                                                                           */
-/*  A line is considered "nonempty" if it contains something that looks like */
-/*  a number.  Comments (prefaced by `#') are ignored.                       */
+/*  spacegrow()   Make sure a workspace array has room for `bytes' bytes,    */
+/*                keeping the first `used' bytes of what it holds.           */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
-
 #ifdef ANSI_DECLARATORS
-char *readline(char *string, FILE *infile, char *infilename)
+VOID *spacegrow(struct triangulateworkspace *ws, struct trispace *space,
+                int used, int bytes)
 #else /* not ANSI_DECLARATORS */
-char *readline(string, infile, infilename)
-char *string;
-FILE *infile;
-char *infilename;
+VOID *spacegrow(ws, space, used, bytes)
+struct triangulateworkspace *ws;
+struct trispace *space;
+int used;
+int bytes;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  char *result;
+  VOID *newmemory;
 
-  /* Search for something that looks like a number. */
-  do {
-    result = fgets(string, INPUTLINESIZE, infile);
-    if (result == (char *) NULL) {
-      printf("  Error:  Unexpected end of file in %s.\n", infilename);
-      triexit(1);
-    }
-    /* Skip anything that doesn't look like a number, a comment, */
-    /*   or the end of a line.                                   */
-    while ((*result != '\0') && (*result != '#')
-           && (*result != '.') && (*result != '+') && (*result != '-')
-           && ((*result < '0') || (*result > '9'))) {
-      result++;
+  if ((space->memory == (VOID *) NULL) || (space->bytes < bytes)) {
+    /* Grow by half again at least, so that growing one item at a time */
+    /*   copies each item only a few times.                            */
+    if (bytes < space->bytes + space->bytes / 2) {
+      bytes = space->bytes + space->bytes / 2;
     }
-  /* If it's a comment or end of line, read another line and try again. */
-  } while ((*result == '#') || (*result == '\0'));
-  return result;
+    newmemory = memalloc(&ws->m.memory,
+                         (bytes > 0) ? bytes : (int) sizeof(REAL));
+    if (space->memory != (VOID *) NULL) {
+      memcpy(newmemory, space->memory, (size_t) used);
+      memfree(&ws->m.memory, space->memory);
+    }
+    space->memory = newmemory;
+    space->bytes = (bytes > 0) ? bytes : (int) sizeof(REAL);
+  }
+  return space->memory;
 }
 
-#endif /* not TRILIBRARY */
-
 /*****************************************************************************/
 /*                                                                           */
-/*  findfield()   Find the next field of a string.                           */
-/*                                                                           */
-/*  Jumps past the current field by searching for whitespace, then jumps     */
-/*  past the whitespace to find the next field.                              */
+/*  spacefree()   Free a workspace array.                                    */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
-
 #ifdef ANSI_DECLARATORS
-char *findfield(char *string)
+void spacefree(struct triangulateworkspace *ws, struct trispace *space)
 #else /* not ANSI_DECLARATORS */
-char *findfield(string)
-char *string;
+void spacefree(ws, space)
+struct triangulateworkspace *ws;
+struct trispace *space;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  char *result;
-
-  result = string;
-  /* Skip the current field.  Stop upon reaching whitespace. */
-  while ((*result != '\0') && (*result != '#')
-         && (*result != ' ') && (*result != '\t')) {
-    result++;
-  }
-  /* Now skip the whitespace and anything else that doesn't look like a */
-  /*   number, a comment, or the end of a line.                         */
-  while ((*result != '\0') && (*result != '#')
-         && (*result != '.') && (*result != '+') && (*result != '-')
-         && ((*result < '0') || (*result > '9'))) {
-    result++;
-  }
-  /* Check for a comment (prefixed with `#'). */
-  if (*result == '#') {
-    *result = '\0';
+  if (space->memory != (VOID *) NULL) {
+    memfree(&ws->m.memory, space->memory);
   }
-  return result;
+  space->memory = (VOID *) NULL;
+  space->bytes = 0;
 }
 
-#endif /* not TRILIBRARY */
-
 /*****************************************************************************/
 /*                                                                           */
-/*  readnodes()   Read the vertices from a file, which may be a .node or     */
-/*                .poly file.                                                */
+/*  poolbytes()   Count the bytes held by a pool's blocks.                   */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
+#ifdef ANSI_DECLARATORS
+unsigned long poolbytes(struct memorypool *pool)
+#else /* not ANSI_DECLARATORS */
+unsigned long poolbytes(pool)
+struct memorypool *pool;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  VOID **block;
+  unsigned long bytes;
+
+  bytes = 0;
+  block = pool->firstblock;
+  while (block != (VOID **) NULL) {
+    bytes += (unsigned long) ((block == pool->firstblock ?
+                               pool->itemsfirstblock : pool->itemsperblock) *
+                              pool->itembytes + (int) sizeof(VOID *) +
+                              pool->alignbytes);
+    block = (VOID **) *block;
+  }
+  return bytes;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  reserveoutput()   Point the output arrays that are about to be written   */
+/*                    at the workspace's own arrays.                         */
+/*                                                                           */
+/*  Follows the same rules as the writing code in triangulate(), so that     */
+/*  only arrays that will actually be filled are set.  The Voronoi output    */
+/*  is not covered; writevoronoi() allocates it as usual.                    */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void readnodes(struct mesh *m, struct behavior *b, char *nodefilename,
-               char *polyfilename, FILE **polyfile)
+void reserveoutput(struct triangulateworkspace *ws, struct behavior *b,
+                   struct triangulateio *out)
 #else /* not ANSI_DECLARATORS */
-void readnodes(m, b, nodefilename, polyfilename, polyfile)
-struct mesh *m;
+void reserveoutput(ws, b, out)
+struct triangulateworkspace *ws;
 struct behavior *b;
-char *nodefilename;
-char *polyfilename;
-FILE **polyfile;
+struct triangulateio *out;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  FILE *infile;
-  vertex vertexloop;
-  char inputline[INPUTLINESIZE];
-  char *stringptr;
-  char *infilename;
-  REAL x, y;
-  int firstnode;
-  int nodemarkers;
-  int currentmarker;
-  int i, j;
+  struct mesh *m;
+  long outvertices;
 
-  if (b->poly) {
-    /* Read the vertices from a .poly file. */
-    if (!b->quiet) {
-      printf("Opening %s.\n", polyfilename);
-    }
-    *polyfile = fopen(polyfilename, "r");
-    if (*polyfile == (FILE *) NULL) {
-      printf("  Error:  Cannot access file %s.\n", polyfilename);
-      triexit(1);
-    }
-    /* Read number of vertices, number of dimensions, number of vertex */
-    /*   attributes, and number of boundary markers.                   */
-    stringptr = readline(inputline, *polyfile, polyfilename);
-    m->invertices = (int) strtol(stringptr, &stringptr, 0);
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      m->mesh_dim = 2;
-    } else {
-      m->mesh_dim = (int) strtol(stringptr, &stringptr, 0);
-    }
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      m->nextras = 0;
-    } else {
-      m->nextras = (int) strtol(stringptr, &stringptr, 0);
-    }
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      nodemarkers = 0;
-    } else {
-      nodemarkers = (int) strtol(stringptr, &stringptr, 0);
-    }
-    if (m->invertices > 0) {
-      infile = *polyfile;
-      infilename = polyfilename;
-      m->readnodefile = 0;
-    } else {
-      /* If the .poly file claims there are zero vertices, that means that */
-      /*   the vertices should be read from a separate .node file.         */
-      m->readnodefile = 1;
-      infilename = nodefilename;
-    }
+  m = &ws->m;
+  if (b->jettison) {
+    outvertices = m->vertices.items - m->undeads;
   } else {
-    m->readnodefile = 1;
-    infilename = nodefilename;
-    *polyfile = (FILE *) NULL;
+    outvertices = m->vertices.items;
   }
 
-  if (m->readnodefile) {
-    /* Read the vertices from a .node file. */
-    if (!b->quiet) {
-      printf("Opening %s.\n", nodefilename);
-    }
-    infile = fopen(nodefilename, "r");
-    if (infile == (FILE *) NULL) {
-      printf("  Error:  Cannot access file %s.\n", nodefilename);
-      triexit(1);
-    }
-    /* Read number of vertices, number of dimensions, number of vertex */
-    /*   attributes, and number of boundary markers.                   */
-    stringptr = readline(inputline, infile, nodefilename);
-    m->invertices = (int) strtol(stringptr, &stringptr, 0);
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      m->mesh_dim = 2;
-    } else {
-      m->mesh_dim = (int) strtol(stringptr, &stringptr, 0);
-    }
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      m->nextras = 0;
-    } else {
-      m->nextras = (int) strtol(stringptr, &stringptr, 0);
+  if (!(b->nonodewritten || (b->noiterationnum && m->readnodefile))) {
+    out->pointlist = (REAL *)
+      spacereserve(ws, &ws->pointlist,
+                   (int) (outvertices * 2 * sizeof(REAL)));
+    if (m->nextras > 0) {
+      out->pointattributelist = (REAL *)
+        spacereserve(ws, &ws->pointattributelist,
+                     (int) (outvertices * m->nextras * sizeof(REAL)));
     }
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      nodemarkers = 0;
-    } else {
-      nodemarkers = (int) strtol(stringptr, &stringptr, 0);
+    if (!b->nobound) {
+      out->pointmarkerlist = (int *)
+        spacereserve(ws, &ws->pointmarkerlist,
+                     (int) (outvertices * sizeof(int)));
+    }
+  }
+  if (!b->noelewritten) {
+    out->trianglelist = (int *)
+      spacereserve(ws, &ws->trianglelist,
+                   (int) (m->triangles.items *
+                          ((b->order + 1) * (b->order + 2) / 2) *
+                          sizeof(int)));
+    if (m->eextras > 0) {
+      out->triangleattributelist = (REAL *)
+        spacereserve(ws, &ws->triangleattributelist,
+                     (int) (m->triangles.items * m->eextras * sizeof(REAL)));
+    }
+  }
+  if ((b->poly || b->convex) && !(b->nopolywritten || b->noiterationnum)) {
+    out->segmentlist = (int *)
+      spacereserve(ws, &ws->segmentlist,
+                   (int) (m->subsegs.items * 2 * sizeof(int)));
+    if (!b->nobound) {
+      out->segmentmarkerlist = (int *)
+        spacereserve(ws, &ws->segmentmarkerlist,
+                     (int) (m->subsegs.items * sizeof(int)));
     }
   }
-
-  if (m->invertices < 3) {
-    printf("Error:  Input must have at least three input vertices.\n");
-    triexit(1);
-  }
-  if (m->mesh_dim != 2) {
-    printf("Error:  Triangle only works with two-dimensional meshes.\n");
-    triexit(1);
+  if (b->edgesout) {
+    out->edgelist = (int *)
+      spacereserve(ws, &ws->edgelist, (int) (m->edges * 2 * sizeof(int)));
+    if (!b->nobound) {
+      out->edgemarkerlist = (int *)
+        spacereserve(ws, &ws->edgemarkerlist, (int) (m->edges * sizeof(int)));
+    }
   }
-  if (m->nextras == 0) {
-    b->weighted = 0;
+  if (b->neighbors) {
+    out->neighborlist = (int *)
+      spacereserve(ws, &ws->neighborlist,
+                   (int) (m->triangles.items * 3 * sizeof(int)));
   }
+}
 
-  initializevertexpool(m, b);
+/*****************************************************************************/
+/*                                                                           */
+/*  gatherstats()   Fill in a workspace's statistics at the end of a call.   */
+/*                                                                           */
+/*  `stamps' holds the clock at the start of the call and at the end of each */
+/*  of its six phases.                                                       */
+/*                                                                           */
+/*****************************************************************************/
 
-  /* Read the vertices. */
-  for (i = 0; i < m->invertices; i++) {
-    vertexloop = (vertex) poolalloc(&m->vertices);
-    stringptr = readline(inputline, infile, infilename);
-    if (i == 0) {
-      firstnode = (int) strtol(stringptr, &stringptr, 0);
-      if ((firstnode == 0) || (firstnode == 1)) {
-        b->firstnumber = firstnode;
-      }
-    }
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      printf("Error:  Vertex %d has no x coordinate.\n", b->firstnumber + i);
-      triexit(1);
-    }
-    x = (REAL) strtod(stringptr, &stringptr);
-    stringptr = findfield(stringptr);
-    if (*stringptr == '\0') {
-      printf("Error:  Vertex %d has no y coordinate.\n", b->firstnumber + i);
-      triexit(1);
-    }
-    y = (REAL) strtod(stringptr, &stringptr);
-    vertexloop[0] = x;
-    vertexloop[1] = y;
-    /* Read the vertex attributes. */
-    for (j = 2; j < 2 + m->nextras; j++) {
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        vertexloop[j] = 0.0;
-      } else {
-        vertexloop[j] = (REAL) strtod(stringptr, &stringptr);
-      }
-    }
-    if (nodemarkers) {
-      /* Read a vertex marker. */
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        setvertexmark(vertexloop, 0);
-      } else {
-        currentmarker = (int) strtol(stringptr, &stringptr, 0);
-        setvertexmark(vertexloop, currentmarker);
-      }
-    } else {
-      /* If no markers are specified in the file, they default to zero. */
-      setvertexmark(vertexloop, 0);
-    }
-    setvertextype(vertexloop, INPUTVERTEX);
-    /* Determine the smallest and largest x and y coordinates. */
-    if (i == 0) {
-      m->xmin = m->xmax = x;
-      m->ymin = m->ymax = y;
-    } else {
-      m->xmin = (x < m->xmin) ? x : m->xmin;
-      m->xmax = (x > m->xmax) ? x : m->xmax;
-      m->ymin = (y < m->ymin) ? y : m->ymin;
-      m->ymax = (y > m->ymax) ? y : m->ymax;
-    }
-  }
-  if (m->readnodefile) {
-    fclose(infile);
-  }
+#ifdef ANSI_DECLARATORS
+void gatherstats(struct triangulateworkspace *ws, long long *stamps)
+#else /* not ANSI_DECLARATORS */
+void gatherstats(ws, stamps)
+struct triangulateworkspace *ws;
+long long *stamps;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  struct triangulatestats *stats;
+
+  m = &ws->m;
+  stats = &ws->stats;
+
+  stats->inputnanoseconds = stamps[1] - stamps[0];
+  stats->delaunaynanoseconds = stamps[2] - stamps[1];
+  stats->segmentnanoseconds = stamps[3] - stamps[2];
+  stats->holenanoseconds = stamps[4] - stamps[3];
+  stats->qualitynanoseconds = stamps[5] - stamps[4];
+  stats->outputnanoseconds = stamps[6] - stamps[5];
+  stats->totalnanoseconds = stamps[6] - stamps[0];
+
+  stats->incirclecount = m->incirclecount;
+  stats->counterclockcount = m->counterclockcount;
+  stats->orient3dcount = m->orient3dcount;
+  stats->hyperbolacount = m->hyperbolacount;
+  stats->circumcentercount = m->circumcentercount;
+  stats->circletopcount = m->circletopcount;
+
+  stats->inputvertices = m->invertices;
+  stats->steinerpoints = m->vertices.items - m->invertices;
+  stats->triangles = m->triangles.items;
+  stats->subsegs = m->subsegs.items;
+
+  stats->vertexpoolbytes = (unsigned long) m->vertices.maxitems *
+                           m->vertices.itembytes;
+  stats->trianglepoolbytes = (unsigned long) m->triangles.maxitems *
+                             m->triangles.itembytes;
+  stats->subsegpoolbytes = (unsigned long) m->subsegs.maxitems *
+                           m->subsegs.itembytes;
+  stats->viripoolbytes = (unsigned long) m->viri.maxitems *
+                         m->viri.itembytes;
+  stats->badsubsegpoolbytes = (unsigned long) m->badsubsegs.maxitems *
+                              m->badsubsegs.itembytes;
+  stats->badtrianglepoolbytes = (unsigned long) m->badtriangles.maxitems *
+                                m->badtriangles.itembytes;
+  stats->flipstackerpoolbytes = (unsigned long) m->flipstackers.maxitems *
+                                m->flipstackers.itembytes;
+  stats->splaynodepoolbytes = (unsigned long) m->splaynodes.maxitems *
+                              m->splaynodes.itembytes;
+
+  stats->allocations = m->memory.allocations;
+  stats->releases = m->memory.releases;
+  stats->allocatedbytes = m->memory.allocatedbytes;
+
+  stats->outofbudget = m->outofbudget;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  workspacedeinit()   Free everything a workspace holds, leaving it empty  */
+/*                      and ready to be used again.                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void workspacedeinit(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+void workspacedeinit(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  meshfree(&ws->m);
+  ws->live = 0;
+  ws->refining = 0;
+  spacefree(ws, &ws->pointlist);
+  spacefree(ws, &ws->pointattributelist);
+  spacefree(ws, &ws->pointmarkerlist);
+  spacefree(ws, &ws->trianglelist);
+  spacefree(ws, &ws->triangleattributelist);
+  spacefree(ws, &ws->neighborlist);
+  spacefree(ws, &ws->segmentlist);
+  spacefree(ws, &ws->segmentmarkerlist);
+  spacefree(ws, &ws->edgelist);
+  spacefree(ws, &ws->edgemarkerlist);
+  spacefree(ws, &ws->livevertices);
+  spacefree(ws, &ws->livefree);
+  spacefree(ws, &ws->liveindex);
+  spacefree(ws, &ws->livestack);
+  spacefree(ws, &ws->livecross);
+  spacefree(ws, &ws->liveends);
+  spacefree(ws, &ws->livelink);
+  spacefree(ws, &ws->livehole);
+  spacefree(ws, &ws->livepointlist);
+  spacefree(ws, &ws->livemarkerlist);
+  spacefree(ws, &ws->livesegmentlist);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspacenew()   Create an empty workspace.                           */
+/*                                                                           */
+/*****************************************************************************/
+
+struct triangulateworkspace *triworkspacenew()
+{
+  struct triangulateworkspace *ws;
+
+  ws = (struct triangulateworkspace *)
+       trimalloc((int) sizeof(struct triangulateworkspace));
+  memset(ws, 0, sizeof(struct triangulateworkspace));
+  triangleinit(&ws->m);
+  ws->m.keeppools = 1;
+  return ws;
+}
 
-  /* Nonexistent x value used as a flag to mark circle events in sweepline */
-  /*   Delaunay algorithm.                                                 */
-  m->xminextreme = 10 * m->xmin - 9 * m->xmax;
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspacefree()   Free a workspace and everything it holds, including */
+/*                       the arrays last handed back by triangulatews().     */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void triworkspacefree(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+void triworkspacefree(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (ws == (struct triangulateworkspace *) NULL) {
+    return;
+  }
+  workspacedeinit(ws);
+  trifree((VOID *) ws);
 }
 
-#endif /* not TRILIBRARY */
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspacebytes()   Report the memory held by a workspace.             */
+/*                                                                           */
+/*  Nothing is given back until the workspace is freed, so this is also the  */
+/*  high-water mark of all the triangulations done with it.                  */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+unsigned long triworkspacebytes(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+unsigned long triworkspacebytes(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  unsigned long bytes;
+
+  m = &ws->m;
+  bytes = (unsigned long) sizeof(struct triangulateworkspace);
+  bytes += poolbytes(&m->triangles) + poolbytes(&m->subsegs) +
+           poolbytes(&m->vertices) + poolbytes(&m->viri) +
+           poolbytes(&m->badsubsegs) + poolbytes(&m->badtriangles) +
+           poolbytes(&m->flipstackers) + poolbytes(&m->splaynodes);
+  bytes += (unsigned long) (m->dummytribytes + m->dummysubbytes);
+  bytes += (unsigned long) m->sortarraysize * sizeof(vertex);
+  bytes += (unsigned long) (ws->pointlist.bytes +
+                            ws->pointattributelist.bytes +
+                            ws->pointmarkerlist.bytes +
+                            ws->trianglelist.bytes +
+                            ws->triangleattributelist.bytes +
+                            ws->neighborlist.bytes + ws->segmentlist.bytes +
+                            ws->segmentmarkerlist.bytes + ws->edgelist.bytes +
+                            ws->edgemarkerlist.bytes);
+  bytes += (unsigned long) (ws->livevertices.bytes + ws->livefree.bytes +
+                            ws->liveindex.bytes + ws->livestack.bytes +
+                            ws->livecross.bytes + ws->liveends.bytes +
+                            ws->livelink.bytes + ws->livehole.bytes +
+                            ws->livepointlist.bytes +
+                            ws->livemarkerlist.bytes +
+                            ws->livesegmentlist.bytes);
+  return bytes;
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  transfernodes()   Read the vertices from memory.                         */
+/*  triworkspacestats()   Copy out the statistics of the last call to        */
+/*                        triangulatews() that used this workspace.          */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifdef TRILIBRARY
+#ifdef ANSI_DECLARATORS
+void triworkspacestats(struct triangulateworkspace *ws,
+                       struct triangulatestats *stats)
+#else /* not ANSI_DECLARATORS */
+void triworkspacestats(ws, stats)
+struct triangulateworkspace *ws;
+struct triangulatestats *stats;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  *stats = ws->stats;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspacebudget()   Set the budget of every call made with a          */
+/*                         workspace (see "Budget of a call" in triangle.h). */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void transfernodes(struct mesh *m, struct behavior *b, REAL *pointlist,
-                   REAL *pointattriblist, int *pointmarkerlist,
-                   int numberofpoints, int numberofpointattribs)
+void triworkspacebudget(struct triangulateworkspace *ws, long maxtriangles,
+                        long long maxnanoseconds)
 #else /* not ANSI_DECLARATORS */
-void transfernodes(m, b, pointlist, pointattriblist, pointmarkerlist,
-                   numberofpoints, numberofpointattribs)
-struct mesh *m;
-struct behavior *b;
-REAL *pointlist;
-REAL *pointattriblist;
-int *pointmarkerlist;
-int numberofpoints;
-int numberofpointattribs;
+void triworkspacebudget(ws, maxtriangles, maxnanoseconds)
+struct triangulateworkspace *ws;
+long maxtriangles;
+long long maxnanoseconds;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  vertex vertexloop;
-  REAL x, y;
-  int i, j;
-  int coordindex;
-  int attribindex;
+  ws->maxtriangles = (maxtriangles > 0) ? maxtriangles : 0;
+  ws->maxnanoseconds = (maxnanoseconds > 0) ? maxnanoseconds : 0;
+}
 
-  m->invertices = numberofpoints;
-  m->mesh_dim = 2;
-  m->nextras = numberofpointattribs;
-  m->readnodefile = 0;
-  if (m->invertices < 3) {
-    printf("Error:  Input must have at least three input vertices.\n");
-    triexit(1);
-  }
-  if (m->nextras == 0) {
-    b->weighted = 0;
-  }
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspaceallocator()   Free what a workspace holds, and take all of   */
+/*                            its memory from `allocator' from now on.       */
+/*                                                                           */
+/*****************************************************************************/
 
-  initializevertexpool(m, b);
+#ifdef ANSI_DECLARATORS
+void triworkspaceallocator(struct triangulateworkspace *ws,
+                           struct triallocator *allocator)
+#else /* not ANSI_DECLARATORS */
+void triworkspaceallocator(ws, allocator)
+struct triangulateworkspace *ws;
+struct triallocator *allocator;
+#endif /* not ANSI_DECLARATORS */
 
-  /* Read the vertices. */
-  coordindex = 0;
-  attribindex = 0;
-  for (i = 0; i < m->invertices; i++) {
-    vertexloop = (vertex) poolalloc(&m->vertices);
-    /* Read the vertex coordinates. */
-    x = vertexloop[0] = pointlist[coordindex++];
-    y = vertexloop[1] = pointlist[coordindex++];
-    /* Read the vertex attributes. */
-    for (j = 0; j < numberofpointattribs; j++) {
-      vertexloop[2 + j] = pointattriblist[attribindex++];
-    }
-    if (pointmarkerlist != (int *) NULL) {
-      /* Read a vertex marker. */
-      setvertexmark(vertexloop, pointmarkerlist[i]);
-    } else {
-      /* If no markers are specified, they default to zero. */
-      setvertexmark(vertexloop, 0);
-    }
-    setvertextype(vertexloop, INPUTVERTEX);
-    /* Determine the smallest and largest x and y coordinates. */
-    if (i == 0) {
-      m->xmin = m->xmax = x;
-      m->ymin = m->ymax = y;
-    } else {
-      m->xmin = (x < m->xmin) ? x : m->xmin;
-      m->xmax = (x > m->xmax) ? x : m->xmax;
-      m->ymin = (y < m->ymin) ? y : m->ymin;
-      m->ymax = (y > m->ymax) ? y : m->ymax;
-    }
+{
+  workspacedeinit(ws);
+  if (allocator == (struct triallocator *) NULL) {
+    memset(&ws->m.memory.allocator, 0, sizeof(struct triallocator));
+  } else {
+    ws->m.memory.allocator = *allocator;
   }
-
-  /* Nonexistent x value used as a flag to mark circle events in sweepline */
-  /*   Delaunay algorithm.                                                 */
-  m->xminextreme = 10 * m->xmin - 9 * m->xmax;
 }
 
-#endif /* TRILIBRARY */
+/*****************************************************************************/
+/*                                                                           */
+/*  triworkspaceforget()   Let go of everything a workspace holds, without   */
+/*                         freeing any of it.                                */
+/*                                                                           */
+/*  For an allocator that takes its memory back all at once, like an arena   */
+/*  when it is reset.  The workspace is left empty, with its allocator.      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void triworkspaceforget(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+void triworkspaceforget(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct trimemory memory;
+#ifdef INDEX32
+  char *indexbase;
+  unsigned long indexcommitted, indexreserved;
+#endif /* INDEX32 */
+
+  memory = ws->m.memory;
+#ifdef INDEX32
+  /* The index space isn't the allocator's; keep it. */
+  indexbase = ws->m.indexbase;
+  indexcommitted = ws->m.indexcommitted;
+  indexreserved = ws->m.indexreserved;
+#endif /* INDEX32 */
+  triangleinit(&ws->m);
+  ws->m.keeppools = 1;
+  ws->m.memory = memory;
+#ifdef INDEX32
+  ws->m.indexbase = indexbase;
+  ws->m.indexcommitted = indexcommitted;
+  ws->m.indexreserved = indexreserved;
+#endif /* INDEX32 */
+  ws->live = 0;
+  ws->refining = 0;
+  memset(&ws->pointlist, 0, sizeof(struct trispace));
+  memset(&ws->pointattributelist, 0, sizeof(struct trispace));
+  memset(&ws->pointmarkerlist, 0, sizeof(struct trispace));
+  memset(&ws->trianglelist, 0, sizeof(struct trispace));
+  memset(&ws->triangleattributelist, 0, sizeof(struct trispace));
+  memset(&ws->neighborlist, 0, sizeof(struct trispace));
+  memset(&ws->segmentlist, 0, sizeof(struct trispace));
+  memset(&ws->segmentmarkerlist, 0, sizeof(struct trispace));
+  memset(&ws->edgelist, 0, sizeof(struct trispace));
+  memset(&ws->edgemarkerlist, 0, sizeof(struct trispace));
+  memset(&ws->livevertices, 0, sizeof(struct trispace));
+  memset(&ws->livefree, 0, sizeof(struct trispace));
+  memset(&ws->liveindex, 0, sizeof(struct trispace));
+  memset(&ws->livestack, 0, sizeof(struct trispace));
+  memset(&ws->livecross, 0, sizeof(struct trispace));
+  memset(&ws->liveends, 0, sizeof(struct trispace));
+  memset(&ws->livelink, 0, sizeof(struct trispace));
+  memset(&ws->livehole, 0, sizeof(struct trispace));
+  memset(&ws->livepointlist, 0, sizeof(struct trispace));
+  memset(&ws->livemarkerlist, 0, sizeof(struct trispace));
+  memset(&ws->livesegmentlist, 0, sizeof(struct trispace));
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  readholes()   Read the holes, and possibly regional attributes and area  */
-/*                constraints, from a .poly file.                            */
+/*  Arenas                                                                   */
+/*                                                                           */
+/*  An arena is a list of chunks, each starting with a `struct arenachunk'.  */
+/*  Memory is handed out from the front of the current chunk to the back.    */
+/*  When it doesn't fit, the first of the following chunks that is big       */
+/*  enough is used; if there is none, a new chunk is made and put after the  */
+/*  current one.  New chunks are at least as big as all the others together, */
+/*  so there are few of them.  Resetting goes back to the front of the first */
+/*  chunk.                                                                   */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
+/* Chunks, and what is handed out of them, are aligned to this many bytes.   */
+
+#define ARENAALIGN 16
+
+struct arenachunk {
+  struct arenachunk *next;
+  unsigned long bytes;                    /* Usable bytes, after the header. */
+};
+
+struct triarena {
+  struct arenachunk *firstchunk, *nowchunk;
+  unsigned long used;                           /* Bytes used in `nowchunk'. */
+  unsigned long chunkbytes;                  /* Usable bytes of a new chunk. */
+  unsigned long totalbytes;                      /* Bytes of all the chunks. */
+};
+
+/* The header of a chunk, rounded up so its memory stays aligned.            */
+
+#define ARENAHEADER (((sizeof(struct arenachunk) - 1) / ARENAALIGN + 1) * \
+                     ARENAALIGN)
+
+/*****************************************************************************/
+/*                                                                           */
+/*  arenaallocate()   Hand out `bytes' bytes of an arena.  The allocate()    */
+/*                    of the arena's allocator.                              */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void readholes(struct mesh *m, struct behavior *b,
-               FILE *polyfile, char *polyfilename, REAL **hlist, int *holes,
-               REAL **rlist, int *regions)
+VOID *arenaallocate(VOID *data, int bytes)
 #else /* not ANSI_DECLARATORS */
-void readholes(m, b, polyfile, polyfilename, hlist, holes, rlist, regions)
-struct mesh *m;
-struct behavior *b;
-FILE *polyfile;
-char *polyfilename;
-REAL **hlist;
-int *holes;
-REAL **rlist;
-int *regions;
+VOID *arenaallocate(data, bytes)
+VOID *data;
+int bytes;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  REAL *holelist;
-  REAL *regionlist;
-  char inputline[INPUTLINESIZE];
-  char *stringptr;
-  int index;
-  int i;
+  struct triarena *arena;
+  struct arenachunk *chunk;
+  unsigned long size;
+  unsigned long chunksize;
+  VOID *memptr;
 
-  /* Read the holes. */
-  stringptr = readline(inputline, polyfile, polyfilename);
-  *holes = (int) strtol(stringptr, &stringptr, 0);
-  if (*holes > 0) {
-    holelist = (REAL *) trimalloc(2 * *holes * (int) sizeof(REAL));
-    *hlist = holelist;
-    for (i = 0; i < 2 * *holes; i += 2) {
-      stringptr = readline(inputline, polyfile, polyfilename);
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        printf("Error:  Hole %d has no x coordinate.\n",
-               b->firstnumber + (i >> 1));
-        triexit(1);
-      } else {
-        holelist[i] = (REAL) strtod(stringptr, &stringptr);
+  arena = (struct triarena *) data;
+  size = ((unsigned long) ((bytes > 0) ? bytes : 1) - 1) / ARENAALIGN + 1;
+  size *= ARENAALIGN;
+  chunk = arena->nowchunk;
+  if ((chunk == (struct arenachunk *) NULL) ||
+      (arena->used + size > chunk->bytes)) {
+    /* Move on to a later chunk, or make one. */
+    chunk = (chunk == (struct arenachunk *) NULL) ? arena->firstchunk :
+            chunk->next;
+    while ((chunk != (struct arenachunk *) NULL) && (chunk->bytes < size)) {
+      chunk = chunk->next;
+    }
+    if (chunk == (struct arenachunk *) NULL) {
+      chunksize = (size > arena->chunkbytes) ? size : arena->chunkbytes;
+      if (chunksize < arena->totalbytes) {
+        chunksize = arena->totalbytes;
       }
-      stringptr = findfield(stringptr);
-      if (*stringptr == '\0') {
-        printf("Error:  Hole %d has no y coordinate.\n",
-               b->firstnumber + (i >> 1));
-        triexit(1);
+      chunk = (struct arenachunk *) malloc((size_t) (ARENAHEADER + chunksize));
+      if (chunk == (struct arenachunk *) NULL) {
+        return (VOID *) NULL;
+      }
+      chunk->bytes = chunksize;
+      arena->totalbytes += ARENAHEADER + chunksize;
+      if (arena->nowchunk == (struct arenachunk *) NULL) {
+        chunk->next = arena->firstchunk;
+        arena->firstchunk = chunk;
       } else {
-        holelist[i + 1] = (REAL) strtod(stringptr, &stringptr);
+        chunk->next = arena->nowchunk->next;
+        arena->nowchunk->next = chunk;
       }
     }
-  } else {
-    *hlist = (REAL *) NULL;
+    arena->nowchunk = chunk;
+    arena->used = 0;
   }
+  memptr = (VOID *) ((char *) chunk + ARENAHEADER + arena->used);
+  arena->used += size;
+  return memptr;
+}
 
-#ifndef CDT_ONLY
-  if ((b->regionattrib || b->vararea) && !b->refine) {
-    /* Read the area constraints. */
-    stringptr = readline(inputline, polyfile, polyfilename);
-    *regions = (int) strtol(stringptr, &stringptr, 0);
-    if (*regions > 0) {
-      regionlist = (REAL *) trimalloc(4 * *regions * (int) sizeof(REAL));
-      *rlist = regionlist;
-      index = 0;
-      for (i = 0; i < *regions; i++) {
-        stringptr = readline(inputline, polyfile, polyfilename);
-        stringptr = findfield(stringptr);
-        if (*stringptr == '\0') {
-          printf("Error:  Region %d has no x coordinate.\n",
-                 b->firstnumber + i);
-          triexit(1);
-        } else {
-          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
-        }
-        stringptr = findfield(stringptr);
-        if (*stringptr == '\0') {
-          printf("Error:  Region %d has no y coordinate.\n",
-                 b->firstnumber + i);
-          triexit(1);
-        } else {
-          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
-        }
-        stringptr = findfield(stringptr);
-        if (*stringptr == '\0') {
-          printf(
-            "Error:  Region %d has no region attribute or area constraint.\n",
-                 b->firstnumber + i);
-          triexit(1);
-        } else {
-          regionlist[index++] = (REAL) strtod(stringptr, &stringptr);
-        }
-        stringptr = findfield(stringptr);
-        if (*stringptr == '\0') {
-          regionlist[index] = regionlist[index - 1];
-        } else {
-          regionlist[index] = (REAL) strtod(stringptr, &stringptr);
-        }
-        index++;
-      }
-    }
-  } else {
-    /* Set `*regions' to zero to avoid an accidental free() later. */
-    *regions = 0;
-    *rlist = (REAL *) NULL;
-  }
-#endif /* not CDT_ONLY */
+/*****************************************************************************/
+/*                                                                           */
+/*  triarenanew()   Make an empty arena, with chunks of `chunkbytes' bytes.  */
+/*                  Returns NULL if there is no memory for it.               */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+struct triarena *triarenanew(int chunkbytes)
+#else /* not ANSI_DECLARATORS */
+struct triarena *triarenanew(chunkbytes)
+int chunkbytes;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct triarena *arena;
+
+  arena = (struct triarena *) malloc(sizeof(struct triarena));
+  if (arena == (struct triarena *) NULL) {
+    return arena;
+  }
+  arena->firstchunk = arena->nowchunk = (struct arenachunk *) NULL;
+  arena->used = 0;
+  arena->chunkbytes = (chunkbytes > ARENAALIGN) ?
+                      (unsigned long) chunkbytes : ARENAALIGN;
+  arena->totalbytes = 0;
+  return arena;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triarenaallocator()   Fill in an allocator that uses an arena.           */
+/*                                                                           */
+/*****************************************************************************/
 
-  fclose(polyfile);
-}
+#ifdef ANSI_DECLARATORS
+void triarenaallocator(struct triarena *arena, struct triallocator *allocator)
+#else /* not ANSI_DECLARATORS */
+void triarenaallocator(arena, allocator)
+struct triarena *arena;
+struct triallocator *allocator;
+#endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
+{
+  allocator->allocate = arenaallocate;
+  allocator->release = (void (*)(VOID *, VOID *)) NULL;
+  allocator->data = (VOID *) arena;
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  finishfile()   Write the command line to the output file so the user     */
-/*                 can remember how the file was generated.  Close the file. */
+/*  triarenareset()   Take back everything an arena handed out.              */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
-
 #ifdef ANSI_DECLARATORS
-void finishfile(FILE *outfile, int argc, char **argv)
+void triarenareset(struct triarena *arena)
 #else /* not ANSI_DECLARATORS */
-void finishfile(outfile, argc, argv)
-FILE *outfile;
-int argc;
-char **argv;
+void triarenareset(arena)
+struct triarena *arena;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  int i;
-
-  fprintf(outfile, "# Generated by");
-  for (i = 0; i < argc; i++) {
-    fprintf(outfile, " ");
-    fputs(argv[i], outfile);
-  }
-  fprintf(outfile, "\n");
-  fclose(outfile);
+  arena->nowchunk = (struct arenachunk *) NULL;
+  arena->used = 0;
 }
 
-#endif /* not TRILIBRARY */
-
 /*****************************************************************************/
 /*                                                                           */
-/*  writenodes()   Number the vertices and write them to a .node file.       */
-/*                                                                           */
-/*  To save memory, the vertex numbers are written over the boundary markers */
-/*  after the vertices are written to a file.                                */
+/*  triarenabytes()   Report the memory held by an arena.                    */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifdef TRILIBRARY
+#ifdef ANSI_DECLARATORS
+unsigned long triarenabytes(struct triarena *arena)
+#else /* not ANSI_DECLARATORS */
+unsigned long triarenabytes(arena)
+struct triarena *arena;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  return (unsigned long) sizeof(struct triarena) + arena->totalbytes;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triarenafree()   Free an arena and all of its chunks.                    */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void writenodes(struct mesh *m, struct behavior *b, REAL **pointlist,
-                REAL **pointattriblist, int **pointmarkerlist)
+void triarenafree(struct triarena *arena)
 #else /* not ANSI_DECLARATORS */
-void writenodes(m, b, pointlist, pointattriblist, pointmarkerlist)
-struct mesh *m;
-struct behavior *b;
-REAL **pointlist;
-REAL **pointattriblist;
-int **pointmarkerlist;
+void triarenafree(arena)
+struct triarena *arena;
 #endif /* not ANSI_DECLARATORS */
 
-#else /* not TRILIBRARY */
+{
+  struct arenachunk *chunk;
+
+  if (arena == (struct triarena *) NULL) {
+    return;
+  }
+  while (arena->firstchunk != (struct arenachunk *) NULL) {
+    chunk = arena->firstchunk;
+    arena->firstchunk = chunk->next;
+    free(chunk);
+  }
+  free(arena);
+}
+
+/**                                                                         **/
+/**                                                                         **/
+/********* Workspace routines end here                               *********/
+
+#endif /* TRILIBRARY */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  quality_statistics()   Print statistics about the quality of the mesh.   */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void writenodes(struct mesh *m, struct behavior *b, char *nodefilename,
-                int argc, char **argv)
+void quality_statistics(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void writenodes(m, b, nodefilename, argc, argv)
+void quality_statistics(m, b)
 struct mesh *m;
 struct behavior *b;
-char *nodefilename;
-int argc;
-char **argv;
 #endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
-
 {
-#ifdef TRILIBRARY
-  REAL *plist;
-  REAL *palist;
-  int *pmlist;
-  int coordindex;
-  int attribindex;
-#else /* not TRILIBRARY */
-  FILE *outfile;
-#endif /* not TRILIBRARY */
-  vertex vertexloop;
-  long outvertices;
-  int vertexnumber;
-  int i;
-
-  if (b->jettison) {
-    outvertices = m->vertices.items - m->undeads;
-  } else {
-    outvertices = m->vertices.items;
-  }
+  struct otri triangleloop;
+  vertex p[3];
+  REAL cossquaretable[8];
+  REAL ratiotable[16];
+  REAL dx[3], dy[3];
+  REAL edgelength[3];
+  REAL dotproduct;
+  REAL cossquare;
+  REAL triarea;
+  REAL shortest, longest;
+  REAL trilongest2;
+  REAL smallestarea, biggestarea;
+  REAL triminaltitude2;
+  REAL minaltitude;
+  REAL triaspect2;
+  REAL worstaspect;
+  REAL smallestangle, biggestangle;
+  REAL radconst, degconst;
+  int angletable[18];
+  int aspecttable[16];
+  int aspectindex;
+  int tendegree;
+  int acutebiggest;
+  int i, ii, j, k;
 
-#ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing vertices.\n");
-  }
-  /* Allocate memory for output vertices if necessary. */
-  if (*pointlist == (REAL *) NULL) {
-    *pointlist = (REAL *) trimalloc((int) (outvertices * 2 * sizeof(REAL)));
-  }
-  /* Allocate memory for output vertex attributes if necessary. */
-  if ((m->nextras > 0) && (*pointattriblist == (REAL *) NULL)) {
-    *pointattriblist = (REAL *) trimalloc((int) (outvertices * m->nextras *
-                                                 sizeof(REAL)));
-  }
-  /* Allocate memory for output vertex markers if necessary. */
-  if (!b->nobound && (*pointmarkerlist == (int *) NULL)) {
-    *pointmarkerlist = (int *) trimalloc((int) (outvertices * sizeof(int)));
+  printf("Mesh quality statistics:\n\n");
+  radconst = PI / 18.0;
+  degconst = 180.0 / PI;
+  for (i = 0; i < 8; i++) {
+    cossquaretable[i] = cos(radconst * (REAL) (i + 1));
+    cossquaretable[i] = cossquaretable[i] * cossquaretable[i];
   }
-  plist = *pointlist;
-  palist = *pointattriblist;
-  pmlist = *pointmarkerlist;
-  coordindex = 0;
-  attribindex = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", nodefilename);
+  for (i = 0; i < 18; i++) {
+    angletable[i] = 0;
   }
-  outfile = fopen(nodefilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", nodefilename);
-    triexit(1);
+
+  ratiotable[0]  =      1.5;      ratiotable[1]  =     2.0;
+  ratiotable[2]  =      2.5;      ratiotable[3]  =     3.0;
+  ratiotable[4]  =      4.0;      ratiotable[5]  =     6.0;
+  ratiotable[6]  =     10.0;      ratiotable[7]  =    15.0;
+  ratiotable[8]  =     25.0;      ratiotable[9]  =    50.0;
+  ratiotable[10] =    100.0;      ratiotable[11] =   300.0;
+  ratiotable[12] =   1000.0;      ratiotable[13] = 10000.0;
+  ratiotable[14] = 100000.0;      ratiotable[15] =     0.0;
+  for (i = 0; i < 16; i++) {
+    aspecttable[i] = 0;
   }
-  /* Number of vertices, number of dimensions, number of vertex attributes, */
-  /*   and number of boundary markers (zero or one).                        */
-  fprintf(outfile, "%ld  %d  %d  %d\n", outvertices, m->mesh_dim,
-          m->nextras, 1 - b->nobound);
-#endif /* not TRILIBRARY */
 
-  traversalinit(&m->vertices);
-  vertexnumber = b->firstnumber;
-  vertexloop = vertextraverse(m);
-  while (vertexloop != (vertex) NULL) {
-    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
-#ifdef TRILIBRARY
-      /* X and y coordinates. */
-      plist[coordindex++] = vertexloop[0];
-      plist[coordindex++] = vertexloop[1];
-      /* Vertex attributes. */
-      for (i = 0; i < m->nextras; i++) {
-        palist[attribindex++] = vertexloop[2 + i];
+  worstaspect = 0.0;
+  minaltitude = m->xmax - m->xmin + m->ymax - m->ymin;
+  minaltitude = minaltitude * minaltitude;
+  shortest = minaltitude;
+  longest = 0.0;
+  smallestarea = minaltitude;
+  biggestarea = 0.0;
+  worstaspect = 0.0;
+  smallestangle = 0.0;
+  biggestangle = 2.0;
+  acutebiggest = 1;
+
+  traversalinit(&m->triangles);
+  triangleloop.tri = triangletraverse(m);
+  triangleloop.orient = 0;
+  while (triangleloop.tri != (triangle *) NULL) {
+    org(triangleloop, p[0]);
+    dest(triangleloop, p[1]);
+    apex(triangleloop, p[2]);
+    trilongest2 = 0.0;
+
+    for (i = 0; i < 3; i++) {
+      j = plus1mod3[i];
+      k = minus1mod3[i];
+      dx[i] = p[j][0] - p[k][0];
+      dy[i] = p[j][1] - p[k][1];
+      edgelength[i] = dx[i] * dx[i] + dy[i] * dy[i];
+      if (edgelength[i] > trilongest2) {
+        trilongest2 = edgelength[i];
       }
-      if (!b->nobound) {
-        /* Copy the boundary marker. */
-        pmlist[vertexnumber - b->firstnumber] = vertexmark(vertexloop);
+      if (edgelength[i] > longest) {
+        longest = edgelength[i];
       }
-#else /* not TRILIBRARY */
-      /* Vertex number, x and y coordinates. */
-      fprintf(outfile, "%4d    %.17g  %.17g", vertexnumber, vertexloop[0],
-              vertexloop[1]);
-      for (i = 0; i < m->nextras; i++) {
-        /* Write an attribute. */
-        fprintf(outfile, "  %.17g", vertexloop[i + 2]);
+      if (edgelength[i] < shortest) {
+        shortest = edgelength[i];
+      }
+    }
+
+    triarea = counterclockwise(m, b, p[0], p[1], p[2]);
+    if (triarea < smallestarea) {
+      smallestarea = triarea;
+    }
+    if (triarea > biggestarea) {
+      biggestarea = triarea;
+    }
+    triminaltitude2 = triarea * triarea / trilongest2;
+    if (triminaltitude2 < minaltitude) {
+      minaltitude = triminaltitude2;
+    }
+    triaspect2 = trilongest2 / triminaltitude2;
+    if (triaspect2 > worstaspect) {
+      worstaspect = triaspect2;
+    }
+    aspectindex = 0;
+    while ((triaspect2 > ratiotable[aspectindex] * ratiotable[aspectindex])
+           && (aspectindex < 15)) {
+      aspectindex++;
+    }
+    aspecttable[aspectindex]++;
+
+    for (i = 0; i < 3; i++) {
+      j = plus1mod3[i];
+      k = minus1mod3[i];
+      dotproduct = dx[j] * dx[k] + dy[j] * dy[k];
+      cossquare = dotproduct * dotproduct / (edgelength[j] * edgelength[k]);
+      tendegree = 8;
+      for (ii = 7; ii >= 0; ii--) {
+        if (cossquare > cossquaretable[ii]) {
+          tendegree = ii;
+        }
       }
-      if (b->nobound) {
-        fprintf(outfile, "\n");
+      if (dotproduct <= 0.0) {
+        angletable[tendegree]++;
+        if (cossquare > smallestangle) {
+          smallestangle = cossquare;
+        }
+        if (acutebiggest && (cossquare < biggestangle)) {
+          biggestangle = cossquare;
+        }
       } else {
-        /* Write the boundary marker. */
-        fprintf(outfile, "    %d\n", vertexmark(vertexloop));
+        angletable[17 - tendegree]++;
+        if (acutebiggest || (cossquare > biggestangle)) {
+          biggestangle = cossquare;
+          acutebiggest = 0;
+        }
       }
-#endif /* not TRILIBRARY */
-
-      setvertexmark(vertexloop, vertexnumber);
-      vertexnumber++;
     }
-    vertexloop = vertextraverse(m);
+    triangleloop.tri = triangletraverse(m);
   }
 
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
-}
+  shortest = sqrt(shortest);
+  longest = sqrt(longest);
+  minaltitude = sqrt(minaltitude);
+  worstaspect = sqrt(worstaspect);
+  smallestarea *= 0.5;
+  biggestarea *= 0.5;
+  if (smallestangle >= 1.0) {
+    smallestangle = 0.0;
+  } else {
+    smallestangle = degconst * acos(sqrt(smallestangle));
+  }
+  if (biggestangle >= 1.0) {
+    biggestangle = 180.0;
+  } else {
+    if (acutebiggest) {
+      biggestangle = degconst * acos(sqrt(biggestangle));
+    } else {
+      biggestangle = 180.0 - degconst * acos(sqrt(biggestangle));
+    }
+  }
 
-/*****************************************************************************/
-/*                                                                           */
-/*  numbernodes()   Number the vertices.                                     */
-/*                                                                           */
-/*  Each vertex is assigned a marker equal to its number.                    */
-/*                                                                           */
-/*  Used when writenodes() is not called because no .node file is written.   */
-/*                                                                           */
-/*****************************************************************************/
+  printf("  Smallest area: %16.5g   |  Largest area: %16.5g\n",
+         smallestarea, biggestarea);
+  printf("  Shortest edge: %16.5g   |  Longest edge: %16.5g\n",
+         shortest, longest);
+  printf("  Shortest altitude: %12.5g   |  Largest aspect ratio: %8.5g\n\n",
+         minaltitude, worstaspect);
 
-#ifdef ANSI_DECLARATORS
-void numbernodes(struct mesh *m, struct behavior *b)
-#else /* not ANSI_DECLARATORS */
-void numbernodes(m, b)
-struct mesh *m;
-struct behavior *b;
-#endif /* not ANSI_DECLARATORS */
+  printf("  Triangle aspect ratio histogram:\n");
+  printf("  1.1547 - %-6.6g    :  %8d    | %6.6g - %-6.6g     :  %8d\n",
+         ratiotable[0], aspecttable[0], ratiotable[7], ratiotable[8],
+         aspecttable[8]);
+  for (i = 1; i < 7; i++) {
+    printf("  %6.6g - %-6.6g    :  %8d    | %6.6g - %-6.6g     :  %8d\n",
+           ratiotable[i - 1], ratiotable[i], aspecttable[i],
+           ratiotable[i + 7], ratiotable[i + 8], aspecttable[i + 8]);
+  }
+  printf("  %6.6g - %-6.6g    :  %8d    | %6.6g -            :  %8d\n",
+         ratiotable[6], ratiotable[7], aspecttable[7], ratiotable[14],
+         aspecttable[15]);
+  printf("  (Aspect ratio is longest edge divided by shortest altitude)\n\n");
 
-{
-  vertex vertexloop;
-  int vertexnumber;
+  printf("  Smallest angle: %15.5g   |  Largest angle: %15.5g\n\n",
+         smallestangle, biggestangle);
 
-  traversalinit(&m->vertices);
-  vertexnumber = b->firstnumber;
-  vertexloop = vertextraverse(m);
-  while (vertexloop != (vertex) NULL) {
-    setvertexmark(vertexloop, vertexnumber);
-    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
-      vertexnumber++;
-    }
-    vertexloop = vertextraverse(m);
+  printf("  Angle histogram:\n");
+  for (i = 0; i < 9; i++) {
+    printf("    %3d - %3d degrees:  %8d    |    %3d - %3d degrees:  %8d\n",
+           i * 10, i * 10 + 10, angletable[i],
+           i * 10 + 90, i * 10 + 100, angletable[i + 9]);
   }
+  printf("\n");
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  writeelements()   Write the triangles to an .ele file.                   */
+/*  statistics()   Print all sorts of cool facts.                            */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifdef TRILIBRARY
-
-#ifdef ANSI_DECLARATORS
-void writeelements(struct mesh *m, struct behavior *b,
-                   int **trianglelist, REAL **triangleattriblist)
-#else /* not ANSI_DECLARATORS */
-void writeelements(m, b, trianglelist, triangleattriblist)
-struct mesh *m;
-struct behavior *b;
-int **trianglelist;
-REAL **triangleattriblist;
-#endif /* not ANSI_DECLARATORS */
-
-#else /* not TRILIBRARY */
-
 #ifdef ANSI_DECLARATORS
-void writeelements(struct mesh *m, struct behavior *b, char *elefilename,
-                   int argc, char **argv)
+void statistics(struct mesh *m, struct behavior *b)
 #else /* not ANSI_DECLARATORS */
-void writeelements(m, b, elefilename, argc, argv)
+void statistics(m, b)
 struct mesh *m;
 struct behavior *b;
-char *elefilename;
-int argc;
-char **argv;
 #endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
-
 {
-#ifdef TRILIBRARY
-  int *tlist;
-  REAL *talist;
-  int vertexindex;
-  int attribindex;
-#else /* not TRILIBRARY */
-  FILE *outfile;
-#endif /* not TRILIBRARY */
-  struct otri triangleloop;
-  vertex p1, p2, p3;
-  vertex mid1, mid2, mid3;
-  long elementnumber;
-  int i;
-
-#ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing triangles.\n");
-  }
-  /* Allocate memory for output triangles if necessary. */
-  if (*trianglelist == (int *) NULL) {
-    *trianglelist = (int *) trimalloc((int) (m->triangles.items *
-                                             ((b->order + 1) * (b->order + 2) /
-                                              2) * sizeof(int)));
-  }
-  /* Allocate memory for output triangle attributes if necessary. */
-  if ((m->eextras > 0) && (*triangleattriblist == (REAL *) NULL)) {
-    *triangleattriblist = (REAL *) trimalloc((int) (m->triangles.items *
-                                                    m->eextras *
-                                                    sizeof(REAL)));
+  printf("\nStatistics:\n\n");
+  printf("  Input vertices: %d\n", m->invertices);
+  if (b->refine) {
+    printf("  Input triangles: %d\n", m->inelements);
   }
-  tlist = *trianglelist;
-  talist = *triangleattriblist;
-  vertexindex = 0;
-  attribindex = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", elefilename);
+  if (b->poly) {
+    printf("  Input segments: %d\n", m->insegments);
+    if (!b->refine) {
+      printf("  Input holes: %d\n", m->holes);
+    }
   }
-  outfile = fopen(elefilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", elefilename);
-    triexit(1);
+
+  printf("\n  Mesh vertices: %ld\n", m->vertices.items - m->undeads);
+  printf("  Mesh triangles: %ld\n", m->triangles.items);
+  printf("  Mesh edges: %ld\n", m->edges);
+  printf("  Mesh exterior boundary edges: %ld\n", m->hullsize);
+  if (b->poly || b->refine) {
+    printf("  Mesh interior boundary edges: %ld\n",
+           m->subsegs.items - m->hullsize);
+    printf("  Mesh subsegments (constrained edges): %ld\n",
+           m->subsegs.items);
   }
-  /* Number of triangles, vertices per triangle, attributes per triangle. */
-  fprintf(outfile, "%ld  %d  %d\n", m->triangles.items,
-          (b->order + 1) * (b->order + 2) / 2, m->eextras);
-#endif /* not TRILIBRARY */
+  printf("\n");
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  triangleloop.orient = 0;
-  elementnumber = b->firstnumber;
-  while (triangleloop.tri != (triangle *) NULL) {
-    org(triangleloop, p1);
-    dest(triangleloop, p2);
-    apex(triangleloop, p3);
-    if (b->order == 1) {
-#ifdef TRILIBRARY
-      tlist[vertexindex++] = vertexmark(p1);
-      tlist[vertexindex++] = vertexmark(p2);
-      tlist[vertexindex++] = vertexmark(p3);
-#else /* not TRILIBRARY */
-      /* Triangle number, indices for three vertices. */
-      fprintf(outfile, "%4ld    %4d  %4d  %4d", elementnumber,
-              vertexmark(p1), vertexmark(p2), vertexmark(p3));
-#endif /* not TRILIBRARY */
-    } else {
-      mid1 = (vertex) triangleloop.tri[m->highorderindex + 1];
-      mid2 = (vertex) triangleloop.tri[m->highorderindex + 2];
-      mid3 = (vertex) triangleloop.tri[m->highorderindex];
-#ifdef TRILIBRARY
-      tlist[vertexindex++] = vertexmark(p1);
-      tlist[vertexindex++] = vertexmark(p2);
-      tlist[vertexindex++] = vertexmark(p3);
-      tlist[vertexindex++] = vertexmark(mid1);
-      tlist[vertexindex++] = vertexmark(mid2);
-      tlist[vertexindex++] = vertexmark(mid3);
-#else /* not TRILIBRARY */
-      /* Triangle number, indices for six vertices. */
-      fprintf(outfile, "%4ld    %4d  %4d  %4d  %4d  %4d  %4d", elementnumber,
-              vertexmark(p1), vertexmark(p2), vertexmark(p3), vertexmark(mid1),
-              vertexmark(mid2), vertexmark(mid3));
-#endif /* not TRILIBRARY */
+  if (b->verbose) {
+    quality_statistics(m, b);
+    printf("Memory allocation statistics:\n\n");
+    printf("  Maximum number of vertices: %ld\n", m->vertices.maxitems);
+    printf("  Maximum number of triangles: %ld\n", m->triangles.maxitems);
+    if (m->subsegs.maxitems > 0) {
+      printf("  Maximum number of subsegments: %ld\n", m->subsegs.maxitems);
+    }
+    if (m->viri.maxitems > 0) {
+      printf("  Maximum number of viri: %ld\n", m->viri.maxitems);
+    }
+    if (m->badsubsegs.maxitems > 0) {
+      printf("  Maximum number of encroached subsegments: %ld\n",
+             m->badsubsegs.maxitems);
+    }
+    if (m->badtriangles.maxitems > 0) {
+      printf("  Maximum number of bad triangles: %ld\n",
+             m->badtriangles.maxitems);
+    }
+    if (m->flipstackers.maxitems > 0) {
+      printf("  Maximum number of stacked triangle flips: %ld\n",
+             m->flipstackers.maxitems);
     }
+    if (m->splaynodes.maxitems > 0) {
+      printf("  Maximum number of splay tree nodes: %ld\n",
+             m->splaynodes.maxitems);
+    }
+    printf("  Approximate heap memory use (bytes): %ld\n\n",
+           m->vertices.maxitems * m->vertices.itembytes +
+           m->triangles.maxitems * m->triangles.itembytes +
+           m->subsegs.maxitems * m->subsegs.itembytes +
+           m->viri.maxitems * m->viri.itembytes +
+           m->badsubsegs.maxitems * m->badsubsegs.itembytes +
+           m->badtriangles.maxitems * m->badtriangles.itembytes +
+           m->flipstackers.maxitems * m->flipstackers.itembytes +
+           m->splaynodes.maxitems * m->splaynodes.itembytes);
 
-#ifdef TRILIBRARY
-    for (i = 0; i < m->eextras; i++) {
-      talist[attribindex++] = elemattribute(triangleloop, i);
+    printf("Algorithmic statistics:\n\n");
+    if (!b->weighted) {
+      printf("  Number of incircle tests: %ld\n", m->incirclecount);
+    } else {
+      printf("  Number of 3D orientation tests: %ld\n", m->orient3dcount);
     }
-#else /* not TRILIBRARY */
-    for (i = 0; i < m->eextras; i++) {
-      fprintf(outfile, "  %.17g", elemattribute(triangleloop, i));
+    printf("  Number of 2D orientation tests: %ld\n", m->counterclockcount);
+    if (m->hyperbolacount > 0) {
+      printf("  Number of right-of-hyperbola tests: %ld\n",
+             m->hyperbolacount);
     }
-    fprintf(outfile, "\n");
-#endif /* not TRILIBRARY */
-
-    triangleloop.tri = triangletraverse(m);
-    elementnumber++;
+    if (m->circletopcount > 0) {
+      printf("  Number of circle top computations: %ld\n",
+             m->circletopcount);
+    }
+    if (m->circumcentercount > 0) {
+      printf("  Number of triangle circumcenter computations: %ld\n",
+             m->circumcentercount);
+    }
+    printf("\n");
   }
-
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  writepoly()   Write the segments and holes to a .poly file.              */
+/*  main() or triangulate()   Gosh, do everything.                           */
+/*                                                                           */
+/*  The sequence is roughly as follows.  Many of these steps can be skipped, */
+/*  depending on the command line switches.                                  */
+/*                                                                           */
+/*  - Initialize constants and parse the command line.                       */
+/*  - Read the vertices from a file and either                               */
+/*    - triangulate them (no -r), or                                         */
+/*    - read an old mesh from files and reconstruct it (-r).                 */
+/*  - Insert the PSLG segments (-p), and possibly segments on the convex     */
+/*      hull (-c).                                                           */
+/*  - Read the holes (-p), regional attributes (-pA), and regional area      */
+/*      constraints (-pa).  Carve the holes and concavities, and spread the  */
+/*      regional attributes and area constraints.                            */
+/*  - Enforce the constraints on minimum angle (-q) and maximum area (-a).   */
+/*      Also enforce the conforming Delaunay property (-q and -a).           */
+/*  - Compute the number of edges in the resulting mesh.                     */
+/*  - Promote the mesh's linear triangles to higher order elements (-o).     */
+/*  - Write the output files and print the statistics.                       */
+/*  - Check the consistency and Delaunay property of the mesh (-C).          */
 /*                                                                           */
 /*****************************************************************************/
 
+//#define REDUCED
+#define ANSI_DECLARATORS
+#define TRILIBRARY
+//#define CDT_ONLY
+
 #ifdef TRILIBRARY
 
+/* As a library, this is triangulatemesh(), which works on a mesh that has   */
+/*   already been set up.  triangulatecall(), after it, sets up the mesh and */
+/*   turns errors into return values.  The options come from `params' if     */
+/*   it isn't NULL, and from the switches otherwise.                         */
+
 #ifdef ANSI_DECLARATORS
-void writepoly(struct mesh *m, struct behavior *b,
-               int **segmentlist, int **segmentmarkerlist)
+void triangulatemesh(char *triswitches, struct triangulateparams *params,
+                     struct triangulateio *in,
+                     struct triangulateio *out, struct triangulateio *vorout,
+                     struct triangulateworkspace *ws, struct mesh *m)
 #else /* not ANSI_DECLARATORS */
-void writepoly(m, b, segmentlist, segmentmarkerlist)
+void triangulatemesh(triswitches, params, in, out, vorout, ws, m)
+char *triswitches;
+struct triangulateparams *params;
+struct triangulateio *in;
+struct triangulateio *out;
+struct triangulateio *vorout;
+struct triangulateworkspace *ws;
 struct mesh *m;
-struct behavior *b;
-int **segmentlist;
-int **segmentmarkerlist;
 #endif /* not ANSI_DECLARATORS */
 
 #else /* not TRILIBRARY */
 
 #ifdef ANSI_DECLARATORS
-void writepoly(struct mesh *m, struct behavior *b, char *polyfilename,
-               REAL *holelist, int holes, REAL *regionlist, int regions,
-               int argc, char **argv)
+int main(int argc, char **argv)
 #else /* not ANSI_DECLARATORS */
-void writepoly(m, b, polyfilename, holelist, holes, regionlist, regions,
-               argc, argv)
-struct mesh *m;
-struct behavior *b;
-char *polyfilename;
-REAL *holelist;
-int holes;
-REAL *regionlist;
-int regions;
+int main(argc, argv)
 int argc;
 char **argv;
 #endif /* not ANSI_DECLARATORS */
@@ -14676,1347 +18650,1905 @@ char **argv;
 #endif /* not TRILIBRARY */
 
 {
-#ifdef TRILIBRARY
-  int *slist;
-  int *smlist;
-  int index;
-#else /* not TRILIBRARY */
-  FILE *outfile;
-  long holenumber, regionnumber;
+#ifndef TRILIBRARY
+  struct mesh meshonstack;
+  struct mesh *m;
 #endif /* not TRILIBRARY */
-  struct osub subsegloop;
-  vertex endpoint1, endpoint2;
-  long subsegnumber;
+  struct behavior b;
+  REAL *holearray;                                        /* Array of holes. */
+  REAL *regionarray;   /* Array of regional attributes and area constraints. */
+#ifndef TRILIBRARY
+  FILE *polyfile;
+#endif /* not TRILIBRARY */
+#ifndef NO_TIMER
+  /* Variables for timing the performance of Triangle.  The types are */
+  /*   defined in sys/time.h.                                         */
+  struct timeval tv0, tv1, tv2, tv3, tv4, tv5, tv6;
+  struct timezone tz;
+#endif /* not NO_TIMER */
+#ifdef TRILIBRARY
+  long long stamps[7];             /* Phase times for workspace statistics. */
+#endif /* TRILIBRARY */
 
+#ifndef NO_TIMER
+  gettimeofday(&tv0, &tz);
+#endif /* not NO_TIMER */
 #ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing segments.\n");
-  }
-  /* Allocate memory for output segments if necessary. */
-  if (*segmentlist == (int *) NULL) {
-    *segmentlist = (int *) trimalloc((int) (m->subsegs.items * 2 *
-                                            sizeof(int)));
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[0] = triclock();
+    /* The budget runs from the start of the call. */
+    m->maxtriangles = ws->maxtriangles;
+    if (ws->maxnanoseconds > 0) {
+      m->deadline = stamps[0] + ws->maxnanoseconds;
+    }
   }
-  /* Allocate memory for output segment markers if necessary. */
-  if (!b->nobound && (*segmentmarkerlist == (int *) NULL)) {
-    *segmentmarkerlist = (int *) trimalloc((int) (m->subsegs.items *
-                                                  sizeof(int)));
+#endif /* TRILIBRARY */
+
+#ifndef TRILIBRARY
+  m = &meshonstack;
+  triangleinit(m);
+#endif /* not TRILIBRARY */
+#ifdef TRILIBRARY
+  if (params != (struct triangulateparams *) NULL) {
+    paramsbehavior(params, &b);
+  } else {
+    parsecommandline(1, &triswitches, &b);
   }
-  slist = *segmentlist;
-  smlist = *segmentmarkerlist;
-  index = 0;
 #else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", polyfilename);
+  parsecommandline(argc, argv, &b);
+#endif /* not TRILIBRARY */
+  m->steinerleft = b.steiner;
+
+#ifdef TRILIBRARY
+  transfernodes(m, &b, in->pointlist, in->pointattributelist,
+                in->pointmarkerlist, in->numberofpoints,
+                in->numberofpointattributes);
+#else /* not TRILIBRARY */
+  readnodes(m, &b, b.innodefilename, b.inpolyfilename, &polyfile);
+#endif /* not TRILIBRARY */
+
+#ifdef TRILIBRARY
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[1] = triclock();
   }
-  outfile = fopen(polyfilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", polyfilename);
-    triexit(1);
+#endif /* TRILIBRARY */
+#ifndef NO_TIMER
+  if (!b.quiet) {
+    gettimeofday(&tv1, &tz);
   }
-  /* The zero indicates that the vertices are in a separate .node file. */
-  /*   Followed by number of dimensions, number of vertex attributes,   */
-  /*   and number of boundary markers (zero or one).                    */
-  fprintf(outfile, "%d  %d  %d  %d\n", 0, m->mesh_dim, m->nextras,
-          1 - b->nobound);
-  /* Number of segments, number of boundary markers (zero or one). */
-  fprintf(outfile, "%ld  %d\n", m->subsegs.items, 1 - b->nobound);
-#endif /* not TRILIBRARY */
+#endif /* not NO_TIMER */
 
-  traversalinit(&m->subsegs);
-  subsegloop.ss = subsegtraverse(m);
-  subsegloop.ssorient = 0;
-  subsegnumber = b->firstnumber;
-  while (subsegloop.ss != (subseg *) NULL) {
-    sorg(subsegloop, endpoint1);
-    sdest(subsegloop, endpoint2);
+#ifdef CDT_ONLY
+  m->hullsize = delaunay(m, &b);                /* Triangulate the vertices. */
+#else /* not CDT_ONLY */
+  if (b.refine) {
+    /* Read and reconstruct a mesh. */
 #ifdef TRILIBRARY
-    /* Copy indices of the segment's two endpoints. */
-    slist[index++] = vertexmark(endpoint1);
-    slist[index++] = vertexmark(endpoint2);
-    if (!b->nobound) {
-      /* Copy the boundary marker. */
-      smlist[subsegnumber - b->firstnumber] = mark(subsegloop);
-    }
+    m->hullsize = reconstruct(m, &b, in->trianglelist,
+                              in->triangleattributelist, in->trianglearealist,
+                              in->numberoftriangles, in->numberofcorners,
+                              in->numberoftriangleattributes,
+                              in->segmentlist, in->segmentmarkerlist,
+                              in->numberofsegments);
 #else /* not TRILIBRARY */
-    /* Segment number, indices of its two endpoints, and possibly a marker. */
-    if (b->nobound) {
-      fprintf(outfile, "%4ld    %4d  %4d\n", subsegnumber,
-              vertexmark(endpoint1), vertexmark(endpoint2));
-    } else {
-      fprintf(outfile, "%4ld    %4d  %4d    %4d\n", subsegnumber,
-              vertexmark(endpoint1), vertexmark(endpoint2), mark(subsegloop));
-    }
+    m->hullsize = reconstruct(m, &b, b.inelefilename, b.areafilename,
+                              b.inpolyfilename, polyfile);
 #endif /* not TRILIBRARY */
+  } else {
+    m->hullsize = delaunay(m, &b);              /* Triangulate the vertices. */
+  }
+#endif /* not CDT_ONLY */
 
-    subsegloop.ss = subsegtraverse(m);
-    subsegnumber++;
+#ifdef TRILIBRARY
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[2] = triclock();
+  }
+#endif /* TRILIBRARY */
+#ifndef NO_TIMER
+  if (!b.quiet) {
+    gettimeofday(&tv2, &tz);
+    if (b.refine) {
+      printf("Mesh reconstruction");
+    } else {
+      printf("Delaunay");
+    }
+    printf(" milliseconds:  %ld\n", 1000l * (tv2.tv_sec - tv1.tv_sec) +
+           (tv2.tv_usec - tv1.tv_usec) / 1000l);
   }
+#endif /* not NO_TIMER */
 
-#ifndef TRILIBRARY
-#ifndef CDT_ONLY
-  fprintf(outfile, "%d\n", holes);
-  if (holes > 0) {
-    for (holenumber = 0; holenumber < holes; holenumber++) {
-      /* Hole number, x and y coordinates. */
-      fprintf(outfile, "%4ld   %.17g  %.17g\n", b->firstnumber + holenumber,
-              holelist[2 * holenumber], holelist[2 * holenumber + 1]);
+  /* Ensure that no vertex can be mistaken for a triangular bounding */
+  /*   box vertex in insertvertex().                                 */
+  m->infvertex1 = (vertex) NULL;
+  m->infvertex2 = (vertex) NULL;
+  m->infvertex3 = (vertex) NULL;
+
+  if (b.usesegments) {
+    m->checksegments = 1;               /* Segments will be introduced next. */
+    if (!b.refine) {
+      /* Insert PSLG segments and/or convex hull segments. */
+#ifdef TRILIBRARY
+      formskeleton(m, &b, in->segmentlist,
+                   in->segmentmarkerlist, in->numberofsegments);
+#else /* not TRILIBRARY */
+      formskeleton(m, &b, polyfile, b.inpolyfilename);
+#endif /* not TRILIBRARY */
     }
   }
-  if (regions > 0) {
-    fprintf(outfile, "%d\n", regions);
-    for (regionnumber = 0; regionnumber < regions; regionnumber++) {
-      /* Region number, x and y coordinates, attribute, maximum area. */
-      fprintf(outfile, "%4ld   %.17g  %.17g  %.17g  %.17g\n",
-              b->firstnumber + regionnumber,
-              regionlist[4 * regionnumber], regionlist[4 * regionnumber + 1],
-              regionlist[4 * regionnumber + 2],
-              regionlist[4 * regionnumber + 3]);
+
+#ifdef TRILIBRARY
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[3] = triclock();
+  }
+#endif /* TRILIBRARY */
+#ifndef NO_TIMER
+  if (!b.quiet) {
+    gettimeofday(&tv3, &tz);
+    if (b.usesegments && !b.refine) {
+      printf("Segment milliseconds:  %ld\n",
+             1000l * (tv3.tv_sec - tv2.tv_sec) +
+             (tv3.tv_usec - tv2.tv_usec) / 1000l);
     }
   }
-#endif /* not CDT_ONLY */
-
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
-}
-
-/*****************************************************************************/
-/*                                                                           */
-/*  writeedges()   Write the edges to an .edge file.                         */
-/*                                                                           */
-/*****************************************************************************/
+#endif /* not NO_TIMER */
 
+  if (b.poly && (m->triangles.items > 0)) {
 #ifdef TRILIBRARY
-
-#ifdef ANSI_DECLARATORS
-void writeedges(struct mesh *m, struct behavior *b,
-                int **edgelist, int **edgemarkerlist)
-#else /* not ANSI_DECLARATORS */
-void writeedges(m, b, edgelist, edgemarkerlist)
-struct mesh *m;
-struct behavior *b;
-int **edgelist;
-int **edgemarkerlist;
-#endif /* not ANSI_DECLARATORS */
-
+    holearray = in->holelist;
+    m->holes = in->numberofholes;
+    regionarray = in->regionlist;
+    m->regions = in->numberofregions;
 #else /* not TRILIBRARY */
-
-#ifdef ANSI_DECLARATORS
-void writeedges(struct mesh *m, struct behavior *b, char *edgefilename,
-                int argc, char **argv)
-#else /* not ANSI_DECLARATORS */
-void writeedges(m, b, edgefilename, argc, argv)
-struct mesh *m;
-struct behavior *b;
-char *edgefilename;
-int argc;
-char **argv;
-#endif /* not ANSI_DECLARATORS */
-
+    readholes(m, &b, polyfile, b.inpolyfilename, &holearray, &m->holes,
+              &regionarray, &m->regions);
 #endif /* not TRILIBRARY */
+    if (!b.refine) {
+      /* Carve out holes and concavities. */
+      carveholes(m, &b, holearray, m->holes, regionarray, m->regions);
+    }
+  } else {
+    /* Without a PSLG, there can be no holes or regional attributes   */
+    /*   or area constraints.  The following are set to zero to avoid */
+    /*   an accidental free() later.                                  */
+    m->holes = 0;
+    m->regions = 0;
+  }
 
-{
 #ifdef TRILIBRARY
-  int *elist;
-  int *emlist;
-  int index;
-#else /* not TRILIBRARY */
-  FILE *outfile;
-#endif /* not TRILIBRARY */
-  struct otri triangleloop, trisym;
-  struct osub checkmark;
-  vertex p1, p2;
-  long edgenumber;
-  triangle ptr;                         /* Temporary variable used by sym(). */
-  subseg sptr;                      /* Temporary variable used by tspivot(). */
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[4] = triclock();
+  }
+#endif /* TRILIBRARY */
+#ifndef NO_TIMER
+  if (!b.quiet) {
+    gettimeofday(&tv4, &tz);
+    if (b.poly && !b.refine) {
+      printf("Hole milliseconds:  %ld\n", 1000l * (tv4.tv_sec - tv3.tv_sec) +
+             (tv4.tv_usec - tv3.tv_usec) / 1000l);
+    }
+  }
+#endif /* not NO_TIMER */
 
+#ifndef CDT_ONLY
+  if (b.quality && (m->triangles.items > 0)) {
 #ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing edges.\n");
+    /* In a workspace, what is left of the `S' switch's Steiner points    */
+    /*   becomes a budget of vertices, as trirefine() gives, so that      */
+    /*   running out of it stops refinement in a way trirefine() can take */
+    /*   up again.  The same points are inserted either way.              */
+    if ((ws != (struct triangulateworkspace *) NULL) &&
+        (m->steinerleft >= 0)) {
+      m->maxvertices = m->vertices.items + m->steinerleft;
+      m->steinerleft = -1;
+    }
+#endif /* TRILIBRARY */
+	//#error here
+    enforcequality(m, &b);           /* Enforce angle and area constraints. */
   }
-  /* Allocate memory for edges if necessary. */
-  if (*edgelist == (int *) NULL) {
-    *edgelist = (int *) trimalloc((int) (m->edges * 2 * sizeof(int)));
+#endif /* not CDT_ONLY */
+
+#ifdef TRILIBRARY
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[5] = triclock();
   }
-  /* Allocate memory for edge markers if necessary. */
-  if (!b->nobound && (*edgemarkerlist == (int *) NULL)) {
-    *edgemarkerlist = (int *) trimalloc((int) (m->edges * sizeof(int)));
+#endif /* TRILIBRARY */
+#ifndef NO_TIMER
+  if (!b.quiet) {
+    gettimeofday(&tv5, &tz);
+#ifndef CDT_ONLY
+    if (b.quality) {
+      printf("Quality milliseconds:  %ld\n",
+             1000l * (tv5.tv_sec - tv4.tv_sec) +
+             (tv5.tv_usec - tv4.tv_usec) / 1000l);
+    }
+#endif /* not CDT_ONLY */
   }
-  elist = *edgelist;
-  emlist = *edgemarkerlist;
-  index = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", edgefilename);
+#endif /* not NO_TIMER */
+
+  /* Calculate the number of edges. */
+  m->edges = (3l * m->triangles.items + m->hullsize) / 2l;
+
+  if (b.order > 1) {
+    highorder(m, &b);       /* Promote elements to higher polynomial order. */
   }
-  outfile = fopen(edgefilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", edgefilename);
-    triexit(1);
+  if (!b.quiet) {
+    printf("\n");
   }
-  /* Number of edges, number of boundary markers (zero or one). */
-  fprintf(outfile, "%ld  %d\n", m->edges, 1 - b->nobound);
-#endif /* not TRILIBRARY */
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  edgenumber = b->firstnumber;
-  /* To loop over the set of edges, loop over all triangles, and look at   */
-  /*   the three edges of each triangle.  If there isn't another triangle  */
-  /*   adjacent to the edge, operate on the edge.  If there is another     */
-  /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
-  while (triangleloop.tri != (triangle *) NULL) {
-    for (triangleloop.orient = 0; triangleloop.orient < 3;
-         triangleloop.orient++) {
-      sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
-        org(triangleloop, p1);
-        dest(triangleloop, p2);
 #ifdef TRILIBRARY
-        elist[index++] = vertexmark(p1);
-        elist[index++] = vertexmark(p2);
+  if (b.jettison) {
+    out->numberofpoints = m->vertices.items - m->undeads;
+  } else {
+    out->numberofpoints = m->vertices.items;
+  }
+  out->numberofpointattributes = m->nextras;
+  out->numberoftriangles = m->triangles.items;
+  out->numberofcorners = (b.order + 1) * (b.order + 2) / 2;
+  out->numberoftriangleattributes = m->eextras;
+  out->numberofedges = m->edges;
+  if (b.usesegments) {
+    out->numberofsegments = m->subsegs.items;
+  } else {
+    out->numberofsegments = m->hullsize;
+  }
+  if (vorout != (struct triangulateio *) NULL) {
+    vorout->numberofpoints = m->triangles.items;
+    vorout->numberofpointattributes = m->nextras;
+    vorout->numberofedges = m->edges;
+  }
+  if (ws != (struct triangulateworkspace *) NULL) {
+    /* The output goes into the workspace's arrays. */
+    reserveoutput(ws, &b, out);
+  }
 #endif /* TRILIBRARY */
-        if (b->nobound) {
-#ifndef TRILIBRARY
-          /* Edge number, indices of two endpoints. */
-          fprintf(outfile, "%4ld   %d  %d\n", edgenumber,
-                  vertexmark(p1), vertexmark(p2));
-#endif /* not TRILIBRARY */
-        } else {
-          /* Edge number, indices of two endpoints, and a boundary marker. */
-          /*   If there's no subsegment, the boundary marker is zero.      */
-          if (b->usesegments) {
-            tspivot(triangleloop, checkmark);
-            if (checkmark.ss == m->dummysub) {
+  /* If not using iteration numbers, don't write a .node file if one was */
+  /*   read, because the original one would be overwritten!              */
+  if (b.nonodewritten || (b.noiterationnum && m->readnodefile)) {
+    if (!b.quiet) {
 #ifdef TRILIBRARY
-              emlist[edgenumber - b->firstnumber] = 0;
+      printf("NOT writing vertices.\n");
 #else /* not TRILIBRARY */
-              fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
-                      vertexmark(p1), vertexmark(p2), 0);
+      printf("NOT writing a .node file.\n");
 #endif /* not TRILIBRARY */
-            } else {
+    }
+    numbernodes(m, &b);         /* We must remember to number the vertices. */
+  } else {
+    /* writenodes() numbers the vertices too. */
 #ifdef TRILIBRARY
-              emlist[edgenumber - b->firstnumber] = mark(checkmark);
+    writenodes(m, &b, &out->pointlist, &out->pointattributelist,
+               &out->pointmarkerlist);
 #else /* not TRILIBRARY */
-              fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
-                      vertexmark(p1), vertexmark(p2), mark(checkmark));
-#endif /* not TRILIBRARY */
-            }
-          } else {
+    writenodes(m, &b, b.outnodefilename, argc, argv);
+#endif /* TRILIBRARY */
+  }
+  if (b.noelewritten) {
+    if (!b.quiet) {
 #ifdef TRILIBRARY
-            emlist[edgenumber - b->firstnumber] = trisym.tri == m->dummytri;
+      printf("NOT writing triangles.\n");
 #else /* not TRILIBRARY */
-            fprintf(outfile, "%4ld   %d  %d  %d\n", edgenumber,
-                    vertexmark(p1), vertexmark(p2), trisym.tri == m->dummytri);
+      printf("NOT writing an .ele file.\n");
 #endif /* not TRILIBRARY */
-          }
-        }
-        edgenumber++;
-      }
     }
-    triangleloop.tri = triangletraverse(m);
-  }
-
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
-}
-
-/*****************************************************************************/
-/*                                                                           */
-/*  writevoronoi()   Write the Voronoi diagram to a .v.node and .v.edge      */
-/*                   file.                                                   */
-/*                                                                           */
-/*  The Voronoi diagram is the geometric dual of the Delaunay triangulation. */
-/*  Hence, the Voronoi vertices are listed by traversing the Delaunay        */
-/*  triangles, and the Voronoi edges are listed by traversing the Delaunay   */
-/*  edges.                                                                   */
-/*                                                                           */
-/*  WARNING:  In order to assign numbers to the Voronoi vertices, this       */
-/*  procedure messes up the subsegments or the extra nodes of every          */
-/*  element.  Hence, you should call this procedure last.                    */
-/*                                                                           */
-/*****************************************************************************/
-
+  } else {
 #ifdef TRILIBRARY
-
-#ifdef ANSI_DECLARATORS
-void writevoronoi(struct mesh *m, struct behavior *b, REAL **vpointlist,
-                  REAL **vpointattriblist, int **vpointmarkerlist,
-                  int **vedgelist, int **vedgemarkerlist, REAL **vnormlist)
-#else /* not ANSI_DECLARATORS */
-void writevoronoi(m, b, vpointlist, vpointattriblist, vpointmarkerlist,
-                  vedgelist, vedgemarkerlist, vnormlist)
-struct mesh *m;
-struct behavior *b;
-REAL **vpointlist;
-REAL **vpointattriblist;
-int **vpointmarkerlist;
-int **vedgelist;
-int **vedgemarkerlist;
-REAL **vnormlist;
-#endif /* not ANSI_DECLARATORS */
-
+    writeelements(m, &b, &out->trianglelist, &out->triangleattributelist);
 #else /* not TRILIBRARY */
-
-#ifdef ANSI_DECLARATORS
-void writevoronoi(struct mesh *m, struct behavior *b, char *vnodefilename,
-                  char *vedgefilename, int argc, char **argv)
-#else /* not ANSI_DECLARATORS */
-void writevoronoi(m, b, vnodefilename, vedgefilename, argc, argv)
-struct mesh *m;
-struct behavior *b;
-char *vnodefilename;
-char *vedgefilename;
-int argc;
-char **argv;
-#endif /* not ANSI_DECLARATORS */
-
+    writeelements(m, &b, b.outelefilename, argc, argv);
 #endif /* not TRILIBRARY */
-
-{
+  }
+  /* The -c switch (convex switch) causes a PSLG to be written */
+  /*   even if none was read.                                  */
+  if (b.poly || b.convex) {
+    /* If not using iteration numbers, don't overwrite the .poly file. */
+    if (b.nopolywritten || b.noiterationnum) {
+      if (!b.quiet) {
 #ifdef TRILIBRARY
-  REAL *plist;
-  REAL *palist;
-  int *elist;
-  REAL *normlist;
-  int coordindex;
-  int attribindex;
+        printf("NOT writing segments.\n");
 #else /* not TRILIBRARY */
-  FILE *outfile;
+        printf("NOT writing a .poly file.\n");
 #endif /* not TRILIBRARY */
-  struct otri triangleloop, trisym;
-  vertex torg, tdest, tapex;
-  REAL circumcenter[2];
-  REAL xi, eta;
-  long vnodenumber, vedgenumber;
-  int p1, p2;
-  int i;
-  triangle ptr;                         /* Temporary variable used by sym(). */
-
+      }
+    } else {
 #ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing Voronoi vertices.\n");
-  }
-  /* Allocate memory for Voronoi vertices if necessary. */
-  if (*vpointlist == (REAL *) NULL) {
-    *vpointlist = (REAL *) trimalloc((int) (m->triangles.items * 2 *
-                                            sizeof(REAL)));
+      writepoly(m, &b, &out->segmentlist, &out->segmentmarkerlist);
+      out->numberofholes = m->holes;
+      out->numberofregions = m->regions;
+      if (b.poly) {
+        out->holelist = in->holelist;
+        out->regionlist = in->regionlist;
+      } else {
+        out->holelist = (REAL *) NULL;
+        out->regionlist = (REAL *) NULL;
+      }
+#else /* not TRILIBRARY */
+      writepoly(m, &b, b.outpolyfilename, holearray, m->holes, regionarray,
+                m->regions, argc, argv);
+#endif /* not TRILIBRARY */
+    }
   }
-  /* Allocate memory for Voronoi vertex attributes if necessary. */
-  if (*vpointattriblist == (REAL *) NULL) {
-    *vpointattriblist = (REAL *) trimalloc((int) (m->triangles.items *
-                                                  m->nextras * sizeof(REAL)));
+#ifndef TRILIBRARY
+#ifndef CDT_ONLY
+  if (m->regions > 0) {
+    trifree((VOID *) regionarray);
   }
-  *vpointmarkerlist = (int *) NULL;
-  plist = *vpointlist;
-  palist = *vpointattriblist;
-  coordindex = 0;
-  attribindex = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", vnodefilename);
+#endif /* not CDT_ONLY */
+  if (m->holes > 0) {
+    trifree((VOID *) holearray);
   }
-  outfile = fopen(vnodefilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", vnodefilename);
-    triexit(1);
+  if (b.geomview) {
+    writeoff(m, &b, b.offfilename, argc, argv);
   }
-  /* Number of triangles, two dimensions, number of vertex attributes, */
-  /*   no markers.                                                     */
-  fprintf(outfile, "%ld  %d  %d  %d\n", m->triangles.items, 2, m->nextras, 0);
 #endif /* not TRILIBRARY */
-
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  triangleloop.orient = 0;
-  vnodenumber = b->firstnumber;
-  while (triangleloop.tri != (triangle *) NULL) {
-    org(triangleloop, torg);
-    dest(triangleloop, tdest);
-    apex(triangleloop, tapex);
-    findcircumcenter(m, b, torg, tdest, tapex, circumcenter, &xi, &eta, 0);
+  if (b.edgesout) {
 #ifdef TRILIBRARY
-    /* X and y coordinates. */
-    plist[coordindex++] = circumcenter[0];
-    plist[coordindex++] = circumcenter[1];
-    for (i = 2; i < 2 + m->nextras; i++) {
-      /* Interpolate the vertex attributes at the circumcenter. */
-      palist[attribindex++] = torg[i] + xi * (tdest[i] - torg[i])
-                                     + eta * (tapex[i] - torg[i]);
-    }
+    writeedges(m, &b, &out->edgelist, &out->edgemarkerlist);
 #else /* not TRILIBRARY */
-    /* Voronoi vertex number, x and y coordinates. */
-    fprintf(outfile, "%4ld    %.17g  %.17g", vnodenumber, circumcenter[0],
-            circumcenter[1]);
-    for (i = 2; i < 2 + m->nextras; i++) {
-      /* Interpolate the vertex attributes at the circumcenter. */
-      fprintf(outfile, "  %.17g", torg[i] + xi * (tdest[i] - torg[i])
-                                         + eta * (tapex[i] - torg[i]));
-    }
-    fprintf(outfile, "\n");
+    writeedges(m, &b, b.edgefilename, argc, argv);
 #endif /* not TRILIBRARY */
-
-    * (int *) (triangleloop.tri + 6) = (int) vnodenumber;
-    triangleloop.tri = triangletraverse(m);
-    vnodenumber++;
   }
-
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
-
+  if (b.voronoi) {
 #ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing Voronoi edges.\n");
+    writevoronoi(m, &b, &vorout->pointlist, &vorout->pointattributelist,
+                 &vorout->pointmarkerlist, &vorout->edgelist,
+                 &vorout->edgemarkerlist, &vorout->normlist);
+#else /* not TRILIBRARY */
+    writevoronoi(m, &b, b.vnodefilename, b.vedgefilename, argc, argv);
+#endif /* not TRILIBRARY */
   }
-  /* Allocate memory for output Voronoi edges if necessary. */
-  if (*vedgelist == (int *) NULL) {
-    *vedgelist = (int *) trimalloc((int) (m->edges * 2 * sizeof(int)));
+  if (b.neighbors) {
+#ifdef TRILIBRARY
+    writeneighbors(m, &b, &out->neighborlist);
+#else /* not TRILIBRARY */
+    writeneighbors(m, &b, b.neighborfilename, argc, argv);
+#endif /* not TRILIBRARY */
   }
-  *vedgemarkerlist = (int *) NULL;
-  /* Allocate memory for output Voronoi norms if necessary. */
-  if (*vnormlist == (REAL *) NULL) {
-    *vnormlist = (REAL *) trimalloc((int) (m->edges * 2 * sizeof(REAL)));
+
+#ifdef TRILIBRARY
+  if (ws != (struct triangulateworkspace *) NULL) {
+    stamps[6] = triclock();
+    gatherstats(ws, stamps);
+#ifndef CDT_ONLY
+    /* If the budget stopped refinement, trirefine() can go on with it, */
+    /*   unless the output has written over the mesh.                   */
+    if (m->outofbudget && (m->steinerkept != 0) && (b.order == 1) &&
+        !b.neighbors && !b.voronoi) {
+      ws->refining = 1;
+      ws->refineb = b;
+    }
+#endif /* not CDT_ONLY */
   }
-  elist = *vedgelist;
-  normlist = *vnormlist;
-  coordindex = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", vedgefilename);
+#endif /* TRILIBRARY */
+
+  if (!b.quiet) {
+#ifndef NO_TIMER
+    gettimeofday(&tv6, &tz);
+    printf("\nOutput milliseconds:  %ld\n",
+           1000l * (tv6.tv_sec - tv5.tv_sec) +
+           (tv6.tv_usec - tv5.tv_usec) / 1000l);
+    printf("Total running milliseconds:  %ld\n",
+           1000l * (tv6.tv_sec - tv0.tv_sec) +
+           (tv6.tv_usec - tv0.tv_usec) / 1000l);
+#endif /* not NO_TIMER */
+
+    statistics(m, &b);
   }
-  outfile = fopen(vedgefilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", vedgefilename);
-    triexit(1);
+
+#ifndef REDUCED
+  if (b.docheck) {
+    checkmesh(m, &b);
+    checkdelaunay(m, &b);
   }
-  /* Number of edges, zero boundary markers. */
-  fprintf(outfile, "%ld  %d\n", m->edges, 0);
-#endif /* not TRILIBRARY */
+#endif /* not REDUCED */
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  vedgenumber = b->firstnumber;
-  /* To loop over the set of edges, loop over all triangles, and look at   */
-  /*   the three edges of each triangle.  If there isn't another triangle  */
-  /*   adjacent to the edge, operate on the edge.  If there is another     */
-  /*   adjacent triangle, operate on the edge only if the current triangle */
-  /*   has a smaller pointer than its neighbor.  This way, each edge is    */
-  /*   considered only once.                                               */
-  while (triangleloop.tri != (triangle *) NULL) {
-    for (triangleloop.orient = 0; triangleloop.orient < 3;
-         triangleloop.orient++) {
-      sym(triangleloop, trisym);
-      if ((triangleloop.tri < trisym.tri) || (trisym.tri == m->dummytri)) {
-        /* Find the number of this triangle (and Voronoi vertex). */
-        p1 = * (int *) (triangleloop.tri + 6);
-        if (trisym.tri == m->dummytri) {
-          org(triangleloop, torg);
-          dest(triangleloop, tdest);
 #ifdef TRILIBRARY
-          /* Copy an infinite ray.  Index of one endpoint, and -1. */
-          elist[coordindex] = p1;
-          normlist[coordindex++] = tdest[1] - torg[1];
-          elist[coordindex] = -1;
-          normlist[coordindex++] = torg[0] - tdest[0];
+  if (ws == (struct triangulateworkspace *) NULL) {
+    triangledeinit(m, &b);
+  }
 #else /* not TRILIBRARY */
-          /* Write an infinite ray.  Edge number, index of one endpoint, -1, */
-          /*   and x and y coordinates of a vector representing the          */
-          /*   direction of the ray.                                         */
-          fprintf(outfile, "%4ld   %d  %d   %.17g  %.17g\n", vedgenumber,
-                  p1, -1, tdest[1] - torg[1], torg[0] - tdest[0]);
+  triangledeinit(m, &b);
 #endif /* not TRILIBRARY */
-        } else {
-          /* Find the number of the adjacent triangle (and Voronoi vertex). */
-          p2 = * (int *) (trisym.tri + 6);
-          /* Finite edge.  Write indices of two endpoints. */
-#ifdef TRILIBRARY
-          elist[coordindex] = p1;
-          normlist[coordindex++] = 0.0;
-          elist[coordindex] = p2;
-          normlist[coordindex++] = 0.0;
-#else /* not TRILIBRARY */
-          fprintf(outfile, "%4ld   %d  %d\n", vedgenumber, p1, p2);
+#ifndef TRILIBRARY
+  return 0;
 #endif /* not TRILIBRARY */
-        }
-        vedgenumber++;
-      }
+}
+
+#ifdef TRILIBRARY
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triangulatecall()   Set up the mesh (a workspace's, or one of its own),  */
+/*                      triangulate, and turn an error into its status.      */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int triangulatecall(char *triswitches, struct triangulateparams *params,
+                    struct triangulateio *in, struct triangulateio *out,
+                    struct triangulateio *vorout,
+                    struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+int triangulatecall(triswitches, params, in, out, vorout, ws)
+char *triswitches;
+struct triangulateparams *params;
+struct triangulateio *in;
+struct triangulateio *out;
+struct triangulateio *vorout;
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh meshonstack;
+  struct mesh *m;
+
+  if (ws != (struct triangulateworkspace *) NULL) {
+    /* Reuse the workspace's mesh and the memory it holds.  Any live */
+    /*   mesh or unfinished refinement it had is gone.               */
+    m = &ws->m;
+    meshrestart(m);
+    ws->live = 0;
+    ws->refining = 0;
+    m->memory.allocations = m->memory.releases = 0;
+    m->memory.allocatedbytes = 0;
+  } else {
+    m = &meshonstack;
+    triangleinit(m);
+  }
+#ifdef INDEX32
+  indexrestart(m);
+#endif /* INDEX32 */
+
+  try {
+    triangulatemesh(triswitches, params, in, out, vorout, ws, m);
+  } catch (struct trierror &error) {
+    /* triexit() was called.  A workspace keeps its memory for the next */
+    /*   call (every pool is prepared afresh then); otherwise, free it. */
+    if (ws != (struct triangulateworkspace *) NULL) {
+      memset(&ws->stats, 0, sizeof(struct triangulatestats));
+    } else {
+      meshfree(m);
     }
-    triangleloop.tri = triangletraverse(m);
+    return error.status;
   }
+  return TRI_OK;
+}
 
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
+#ifdef ANSI_DECLARATORS
+int triangulate(char *triswitches, struct triangulateio *in,
+                struct triangulateio *out, struct triangulateio *vorout)
+#else /* not ANSI_DECLARATORS */
+int triangulate(triswitches, in, out, vorout)
+char *triswitches;
+struct triangulateio *in;
+struct triangulateio *out;
+struct triangulateio *vorout;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  return triangulatecall(triswitches, (struct triangulateparams *) NULL,
+                         in, out, vorout,
+                         (struct triangulateworkspace *) NULL);
+}
+
+#ifdef ANSI_DECLARATORS
+int triangulatews(char *triswitches, struct triangulateio *in,
+                  struct triangulateio *out, struct triangulateio *vorout,
+                  struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+int triangulatews(triswitches, in, out, vorout, ws)
+char *triswitches;
+struct triangulateio *in;
+struct triangulateio *out;
+struct triangulateio *vorout;
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  return triangulatecall(triswitches, (struct triangulateparams *) NULL,
+                         in, out, vorout, ws);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triparamsinit()   Set a `triangulateparams' to the defaults:  Delaunay   */
+/*                    triangulation by divide-and-conquer, on one thread.    */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void triparamsinit(struct triangulateparams *params)
+#else /* not ANSI_DECLARATORS */
+void triparamsinit(params)
+struct triangulateparams *params;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  params->poly = params->nopolywritten = params->neighbors = 0;
+  params->nobisect = 0;
+  params->minangle = 0.0;
+  params->maxarea = 0.0;
+  params->steiner = -1;
+  params->algorithm = TRI_DIVCONQ;
+  params->brio = 0;
+  params->threads = 1;
+  params->unsuitable = NULL;
+  params->unsuitabledata = (VOID *) NULL;
 }
 
-#ifdef TRILIBRARY
+/*****************************************************************************/
+/*                                                                           */
+/*  triangulatewith()   Like triangulatews(), with the options in `params'   */
+/*                      instead of a switch string.                          */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void writeneighbors(struct mesh *m, struct behavior *b, int **neighborlist)
+int triangulatewith(struct triangulateparams *params,
+                    struct triangulateio *in, struct triangulateio *out,
+                    struct triangulateio *vorout,
+                    struct triangulateworkspace *ws)
 #else /* not ANSI_DECLARATORS */
-void writeneighbors(m, b, neighborlist)
-struct mesh *m;
-struct behavior *b;
-int **neighborlist;
+int triangulatewith(params, in, out, vorout, ws)
+struct triangulateparams *params;
+struct triangulateio *in;
+struct triangulateio *out;
+struct triangulateio *vorout;
+struct triangulateworkspace *ws;
 #endif /* not ANSI_DECLARATORS */
 
-#else /* not TRILIBRARY */
+{
+  return triangulatecall((char *) NULL, params, in, out, vorout, ws);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  trirefine()   Go on with the refinement of a workspace's mesh that the   */
+/*                budget stopped, and write the mesh out again.              */
+/*                                                                           */
+/*  At most `steinerpoints' Steiner points are added (zero or less means no  */
+/*  limit), within the budget set with triworkspacebudget(), which runs from */
+/*  the start of this call.  The output is written with the switches of the */
+/*  call that made the mesh.  The holes and regions of `out' are left alone. */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void writeneighbors(struct mesh *m, struct behavior *b, char *neighborfilename,
-                    int argc, char **argv)
+int trirefine(struct triangulateworkspace *ws, int steinerpoints,
+              struct triangulateio *out)
 #else /* not ANSI_DECLARATORS */
-void writeneighbors(m, b, neighborfilename, argc, argv)
-struct mesh *m;
-struct behavior *b;
-char *neighborfilename;
-int argc;
-char **argv;
+int trirefine(ws, steinerpoints, out)
+struct triangulateworkspace *ws;
+int steinerpoints;
+struct triangulateio *out;
 #endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
-
 {
-#ifdef TRILIBRARY
-  int *nlist;
-  int index;
-#else /* not TRILIBRARY */
-  FILE *outfile;
-#endif /* not TRILIBRARY */
-  struct otri triangleloop, trisym;
-  long elementnumber;
-  int neighbor1, neighbor2, neighbor3;
-  triangle ptr;                         /* Temporary variable used by sym(). */
+  struct mesh *m;
+  struct behavior *b;
+  vertex vertexloop;
+  int *markers;
+  long long stamps[7];
+  int i;
 
-#ifdef TRILIBRARY
-  if (!b->quiet) {
-    printf("Writing neighbors.\n");
-  }
-  /* Allocate memory for neighbors if necessary. */
-  if (*neighborlist == (int *) NULL) {
-    *neighborlist = (int *) trimalloc((int) (m->triangles.items * 3 *
-                                             sizeof(int)));
-  }
-  nlist = *neighborlist;
-  index = 0;
-#else /* not TRILIBRARY */
-  if (!b->quiet) {
-    printf("Writing %s.\n", neighborfilename);
-  }
-  outfile = fopen(neighborfilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", neighborfilename);
-    triexit(1);
+  if (!ws->refining) {
+    return TRI_ERROR_INPUT;
   }
-  /* Number of triangles, three neighbors per triangle. */
-  fprintf(outfile, "%ld  %d\n", m->triangles.items, 3);
-#endif /* not TRILIBRARY */
+  m = &ws->m;
+  b = &ws->refineb;
+  ws->refining = 0;
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  triangleloop.orient = 0;
-  elementnumber = b->firstnumber;
-  while (triangleloop.tri != (triangle *) NULL) {
-    * (int *) (triangleloop.tri + 6) = (int) elementnumber;
-    triangleloop.tri = triangletraverse(m);
-    elementnumber++;
+  stamps[0] = triclock();
+  /* The statistics are this call's, as with triangulatews(). */
+  m->incirclecount = m->counterclockcount = m->orient3dcount = 0;
+  m->hyperbolacount = m->circletopcount = m->circumcentercount = 0;
+  m->memory.allocations = m->memory.releases = 0;
+  m->memory.allocatedbytes = 0;
+  m->maxtriangles = ws->maxtriangles;
+  m->maxvertices = (steinerpoints > 0) ? m->vertices.items + steinerpoints
+                                       : 0;
+  m->deadline = (ws->maxnanoseconds > 0) ? stamps[0] + ws->maxnanoseconds
+                                         : 0;
+  m->clockcountdown = 0;
+  m->outofbudget = 0;
+  m->steinerleft = m->steinerkept;
+  m->steinerkept = 0;
+
+  /* writenodes() numbered the vertices over their markers.  Put the */
+  /*   markers back, from the output it wrote them to.              */
+  if (!b->nobound && !(b->nonodewritten ||
+                       (b->noiterationnum && m->readnodefile))) {
+    markers = (int *) ws->pointmarkerlist.memory;
+    traversalinit(&m->vertices);
+    vertexloop = vertextraverse(m);
+    while (vertexloop != (vertex) NULL) {
+      if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
+        setvertexmark(vertexloop,
+                      markers[vertexmark(vertexloop) - b->firstnumber]);
+      }
+      vertexloop = vertextraverse(m);
+    }
   }
-  * (int *) (m->dummytri + 6) = -1;
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  elementnumber = b->firstnumber;
-  while (triangleloop.tri != (triangle *) NULL) {
-    triangleloop.orient = 1;
-    sym(triangleloop, trisym);
-    neighbor1 = * (int *) (trisym.tri + 6);
-    triangleloop.orient = 2;
-    sym(triangleloop, trisym);
-    neighbor2 = * (int *) (trisym.tri + 6);
-    triangleloop.orient = 0;
-    sym(triangleloop, trisym);
-    neighbor3 = * (int *) (trisym.tri + 6);
-#ifdef TRILIBRARY
-    nlist[index++] = neighbor1;
-    nlist[index++] = neighbor2;
-    nlist[index++] = neighbor3;
-#else /* not TRILIBRARY */
-    /* Triangle number, neighboring triangle numbers. */
-    fprintf(outfile, "%4ld    %d  %d  %d\n", elementnumber,
-            neighbor1, neighbor2, neighbor3);
-#endif /* not TRILIBRARY */
+  try {
+    for (i = 1; i < 5; i++) {
+      stamps[i] = stamps[0];
+    }
+#ifndef CDT_ONLY
+    resumequality(m, b);
+#endif /* not CDT_ONLY */
+    stamps[5] = triclock();
 
-    triangleloop.tri = triangletraverse(m);
-    elementnumber++;
-  }
+    /* The output of triangulatemesh(), less the Voronoi diagram, the */
+    /*   neighbors and higher order elements, which never get here.   */
+    m->edges = (3l * m->triangles.items + m->hullsize) / 2l;
+    if (b->jettison) {
+      out->numberofpoints = m->vertices.items - m->undeads;
+    } else {
+      out->numberofpoints = m->vertices.items;
+    }
+    out->numberofpointattributes = m->nextras;
+    out->numberoftriangles = m->triangles.items;
+    out->numberofcorners = 3;
+    out->numberoftriangleattributes = m->eextras;
+    out->numberofedges = m->edges;
+    if (b->usesegments) {
+      out->numberofsegments = m->subsegs.items;
+    } else {
+      out->numberofsegments = m->hullsize;
+    }
+    reserveoutput(ws, b, out);
+    if (b->nonodewritten || (b->noiterationnum && m->readnodefile)) {
+      numbernodes(m, b);
+    } else {
+      writenodes(m, b, &out->pointlist, &out->pointattributelist,
+                 &out->pointmarkerlist);
+    }
+    if (!b->noelewritten) {
+      writeelements(m, b, &out->trianglelist, &out->triangleattributelist);
+    }
+    if ((b->poly || b->convex) && !(b->nopolywritten || b->noiterationnum)) {
+      writepoly(m, b, &out->segmentlist, &out->segmentmarkerlist);
+    }
+    if (b->edgesout) {
+      writeedges(m, b, &out->edgelist, &out->edgemarkerlist);
+    }
 
-#ifndef TRILIBRARY
-  finishfile(outfile, argc, argv);
-#endif /* not TRILIBRARY */
+    stamps[6] = triclock();
+    gatherstats(ws, stamps);
+  } catch (struct trierror &error) {
+    memset(&ws->stats, 0, sizeof(struct triangulatestats));
+    return error.status;
+  }
+  ws->refining = m->outofbudget && (m->steinerkept != 0);
+  return TRI_OK;
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  writeoff()   Write the triangulation to an .off file.                    */
+/*  trirefining()   Check whether a workspace has refinement left for       */
+/*                  trirefine() to do.                                       */
 /*                                                                           */
-/*  OFF stands for the Object File Format, a format used by the Geometry     */
-/*  Center's Geomview package.                                               */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int trirefining(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+int trirefining(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  return ws->refining;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triorient()   counterclockwise() for points that aren't in a mesh.       */
 /*                                                                           */
 /*****************************************************************************/
 
-#ifndef TRILIBRARY
+#ifdef ANSI_DECLARATORS
+REAL triorient(REAL *pa, REAL *pb, REAL *pc)
+#else /* not ANSI_DECLARATORS */
+REAL triorient(pa, pb, pc)
+REAL *pa;
+REAL *pb;
+REAL *pc;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  exactinitonce();
+  return orientfilter(pa, pb, pc, 0);
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triincircle()   incircle() for points that aren't in a mesh.             */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void writeoff(struct mesh *m, struct behavior *b, char *offfilename,
-              int argc, char **argv)
+REAL triincircle(REAL *pa, REAL *pb, REAL *pc, REAL *pd)
 #else /* not ANSI_DECLARATORS */
-void writeoff(m, b, offfilename, argc, argv)
-struct mesh *m;
-struct behavior *b;
-char *offfilename;
-int argc;
-char **argv;
+REAL triincircle(pa, pb, pc, pd)
+REAL *pa;
+REAL *pb;
+REAL *pc;
+REAL *pd;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  FILE *outfile;
-  struct otri triangleloop;
-  vertex vertexloop;
-  vertex p1, p2, p3;
-  long outvertices;
+  exactinitonce();
+  return incirclefilter(pa, pb, pc, pd, 0);
+}
 
-  if (!b->quiet) {
-    printf("Writing %s.\n", offfilename);
-  }
+/*****************************************************************************/
+/*                                                                           */
+/*  triincircles()   incircle() of `count' points (x, y pairs in             */
+/*                   `pointlist') against the circle through pa, pb, and pc, */
+/*                   one result per point.                                   */
+/*                                                                           */
+/*  The filter runs over a block of points first, in a loop without calls   */
+/*  or early returns, which the compiler can vectorize; the exact fallback   */
+/*  then runs for the few points the filter couldn't settle.  Each point is  */
+/*  computed exactly as incircle() does it, so every result is the same as   */
+/*  triincircle()'s.                                                         */
+/*                                                                           */
+/*****************************************************************************/
 
-  if (b->jettison) {
-    outvertices = m->vertices.items - m->undeads;
-  } else {
-    outvertices = m->vertices.items;
-  }
+#define INCIRCLEBLOCK 64                       /* Points filtered in one go. */
 
-  outfile = fopen(offfilename, "w");
-  if (outfile == (FILE *) NULL) {
-    printf("  Error:  Cannot create file %s.\n", offfilename);
-    triexit(1);
-  }
-  /* Number of vertices, triangles, and edges. */
-  fprintf(outfile, "OFF\n%ld  %ld  %ld\n", outvertices, m->triangles.items,
-          m->edges);
+#ifdef ANSI_DECLARATORS
+void triincircles(REAL *pa, REAL *pb, REAL *pc, REAL *pointlist, int count,
+                  REAL *results)
+#else /* not ANSI_DECLARATORS */
+void triincircles(pa, pb, pc, pointlist, count, results)
+REAL *pa;
+REAL *pb;
+REAL *pc;
+REAL *pointlist;
+int count;
+REAL *results;
+#endif /* not ANSI_DECLARATORS */
 
-  /* Write the vertices. */
-  traversalinit(&m->vertices);
-  vertexloop = vertextraverse(m);
-  while (vertexloop != (vertex) NULL) {
-    if (!b->jettison || (vertextype(vertexloop) != UNDEADVERTEX)) {
-      /* The "0.0" is here because the OFF format uses 3D coordinates. */
-      fprintf(outfile, " %.17g  %.17g  %.17g\n", vertexloop[0], vertexloop[1],
-              0.0);
+{
+  REAL permanents[INCIRCLEBLOCK];
+  REAL adx, bdx, cdx, ady, bdy, cdy;
+  REAL bdxcdy, cdxbdy, cdxady, adxcdy, adxbdy, bdxady;
+  REAL alift, blift, clift;
+  REAL det, errbound;
+  REAL *pd;
+  int first, blocksize;
+  int i;
+
+  exactinitonce();
+  for (first = 0; first < count; first += INCIRCLEBLOCK) {
+    blocksize = count - first;
+    if (blocksize > INCIRCLEBLOCK) {
+      blocksize = INCIRCLEBLOCK;
+    }
+    for (i = 0; i < blocksize; i++) {
+      pd = &pointlist[(first + i) * 2];
+      adx = pa[0] - pd[0];
+      bdx = pb[0] - pd[0];
+      cdx = pc[0] - pd[0];
+      ady = pa[1] - pd[1];
+      bdy = pb[1] - pd[1];
+      cdy = pc[1] - pd[1];
+
+      bdxcdy = bdx * cdy;
+      cdxbdy = cdx * bdy;
+      alift = adx * adx + ady * ady;
+
+      cdxady = cdx * ady;
+      adxcdy = adx * cdy;
+      blift = bdx * bdx + bdy * bdy;
+
+      adxbdy = adx * bdy;
+      bdxady = bdx * ady;
+      clift = cdx * cdx + cdy * cdy;
+
+      results[first + i] = alift * (bdxcdy - cdxbdy)
+                         + blift * (cdxady - adxcdy)
+                         + clift * (adxbdy - bdxady);
+      permanents[i] = (Absolute(bdxcdy) + Absolute(cdxbdy)) * alift
+                    + (Absolute(cdxady) + Absolute(adxcdy)) * blift
+                    + (Absolute(adxbdy) + Absolute(bdxady)) * clift;
+    }
+    for (i = 0; i < blocksize; i++) {
+      det = results[first + i];
+      errbound = iccerrboundA * permanents[i];
+      if (!((det > errbound) || (-det > errbound))) {
+        results[first + i] = incircleadapt(pa, pb, pc,
+                                           &pointlist[(first + i) * 2],
+                                           permanents[i]);
+      }
     }
-    vertexloop = vertextraverse(m);
   }
+}
 
-  /* Write the triangles. */
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  triangleloop.orient = 0;
-  while (triangleloop.tri != (triangle *) NULL) {
-    org(triangleloop, p1);
-    dest(triangleloop, p2);
-    apex(triangleloop, p3);
-    /* The "3" means a three-vertex polygon. */
-    fprintf(outfile, " 3   %4d  %4d  %4d\n", vertexmark(p1) - b->firstnumber,
-            vertexmark(p2) - b->firstnumber, vertexmark(p3) - b->firstnumber);
-    triangleloop.tri = triangletraverse(m);
+
+#ifndef CDT_ONLY
+
+/********* Live mesh routines begin here                            *********/
+/**                                                                         **/
+/**                                                                         **/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  A live mesh is a workspace's mesh kept after trilivebegin() and then     */
+/*  edited in place, one vertex or segment at a time.  Each edit changes     */
+/*  only the triangles around it, so a contour that moves a few vertices     */
+/*  from one frame to the next costs a few local edits, not a whole new      */
+/*  triangulation.                                                           */
+/*                                                                           */
+/*  The mesh is bounded by a frame:  a rectangle of four extra vertices,     */
+/*  joined by segments.  All other vertices lie strictly inside it, so no    */
+/*  edit ever touches the boundary of the triangulation, and deletevertex()  */
+/*  and insertvertex() can be used as they are.  Between edits the mesh is   */
+/*  always a constrained Delaunay triangulation.                             */
+/*                                                                           */
+/*  Vertices are known by small integer ids, which live in the vertices'     */
+/*  boundary markers (the frame's markers are -1).  The table              */
+/*  `livevertices' finds the vertex of an id.                                */
+/*                                                                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  livenewid()   Hand out an id, reusing one that was given back if there   */
+/*                is one.                                                    */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int livenewid(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+int livenewid(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (ws->livefreeids > 0) {
+    ws->livefreeids--;
+    return ((int *) ws->livefree.memory)[ws->livefreeids];
+  }
+  spacegrow(ws, &ws->livevertices, ws->liveids * (int) sizeof(vertex),
+            (ws->liveids + 1) * (int) sizeof(vertex));
+  ((vertex *) ws->livevertices.memory)[ws->liveids] = (vertex) NULL;
+  return ws->liveids++;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  livefreeid()   Give an id back.                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+void livefreeid(struct triangulateworkspace *ws, int id)
+#else /* not ANSI_DECLARATORS */
+void livefreeid(ws, id)
+struct triangulateworkspace *ws;
+int id;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  ((vertex *) ws->livevertices.memory)[id] = (vertex) NULL;
+  spacegrow(ws, &ws->livefree, ws->livefreeids * (int) sizeof(int),
+            (ws->livefreeids + 1) * (int) sizeof(int));
+  ((int *) ws->livefree.memory)[ws->livefreeids++] = id;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  livevertex()   Find the vertex of an id.  Returns NULL if there is no    */
+/*                 live mesh or no such vertex.                              */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+vertex livevertex(struct triangulateworkspace *ws, int id)
+#else /* not ANSI_DECLARATORS */
+vertex livevertex(ws, id)
+struct triangulateworkspace *ws;
+int id;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  if (!ws->live || (id < 0) || (id >= ws->liveids)) {
+    return (vertex) NULL;
   }
-  finishfile(outfile, argc, argv);
+  return ((vertex *) ws->livevertices.memory)[id];
 }
 
-#endif /* not TRILIBRARY */
+/*****************************************************************************/
+/*                                                                           */
+/*  liveinside()   Check that a point lies strictly inside the frame.        */
+/*                                                                           */
+/*****************************************************************************/
 
-/**                                                                         **/
-/**                                                                         **/
-/********* File I/O routines end here                                *********/
+#ifdef ANSI_DECLARATORS
+int liveinside(struct triangulateworkspace *ws, REAL x, REAL y)
+#else /* not ANSI_DECLARATORS */
+int liveinside(ws, x, y)
+struct triangulateworkspace *ws;
+REAL x;
+REAL y;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  return (x > ws->livexmin) && (x < ws->livexmax) &&
+         (y > ws->liveymin) && (y < ws->liveymax);
+}
 
 /*****************************************************************************/
 /*                                                                           */
-/*  quality_statistics()   Print statistics about the quality of the mesh.   */
+/*  livefind()   Find a triangle whose origin is a given vertex.             */
+/*                                                                           */
+/*  Each vertex remembers the last triangle found this way; if that one is   */
+/*  still alive and still has the vertex as its origin, no search is needed. */
+/*  Otherwise the vertex is found by point location.                         */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void quality_statistics(struct mesh *m, struct behavior *b)
+void livefind(struct mesh *m, struct behavior *b, vertex findvertex,
+              struct otri *searchtri)
 #else /* not ANSI_DECLARATORS */
-void quality_statistics(m, b)
+void livefind(m, b, findvertex, searchtri)
 struct mesh *m;
 struct behavior *b;
+vertex findvertex;
+struct otri *searchtri;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  struct otri triangleloop;
-  vertex p[3];
-  REAL cossquaretable[8];
-  REAL ratiotable[16];
-  REAL dx[3], dy[3];
-  REAL edgelength[3];
-  REAL dotproduct;
-  REAL cossquare;
-  REAL triarea;
-  REAL shortest, longest;
-  REAL trilongest2;
-  REAL smallestarea, biggestarea;
-  REAL triminaltitude2;
-  REAL minaltitude;
-  REAL triaspect2;
-  REAL worstaspect;
-  REAL smallestangle, biggestangle;
-  REAL radconst, degconst;
-  int angletable[18];
-  int aspecttable[16];
-  int aspectindex;
-  int tendegree;
-  int acutebiggest;
-  int i, ii, j, k;
+  triangle encodedtri;
+  vertex checkvertex;
+  triangle ptr;                         /* Temporary variable used by sym(). */
 
-  printf("Mesh quality statistics:\n\n");
-  radconst = PI / 18.0;
-  degconst = 180.0 / PI;
-  for (i = 0; i < 8; i++) {
-    cossquaretable[i] = cos(radconst * (REAL) (i + 1));
-    cossquaretable[i] = cossquaretable[i] * cossquaretable[i];
+  encodedtri = vertex2tri(findvertex);
+  if (encodedtri != (triangle) NULL) {
+    decode(encodedtri, *searchtri);
+    if (!deadtri(searchtri->tri)) {
+      org(*searchtri, checkvertex);
+      if (checkvertex == findvertex) {
+        return;
+      }
+    }
   }
-  for (i = 0; i < 18; i++) {
-    angletable[i] = 0;
+  searchtri->tri = m->dummytri;
+  searchtri->orient = 0;
+  symself(*searchtri);
+  if (locate(m, b, findvertex, searchtri) != ONVERTEX) {
+    printf("Internal error in livefind():  Unable to locate vertex\n");
+    printf("  (%.12g, %.12g) in triangulation.\n",
+           findvertex[0], findvertex[1]);
+    internalerror();
   }
+  setvertex2tri(findvertex, encode(*searchtri));
+}
 
-  ratiotable[0]  =      1.5;      ratiotable[1]  =     2.0;
-  ratiotable[2]  =      2.5;      ratiotable[3]  =     3.0;
-  ratiotable[4]  =      4.0;      ratiotable[5]  =     6.0;
-  ratiotable[6]  =     10.0;      ratiotable[7]  =    15.0;
-  ratiotable[8]  =     25.0;      ratiotable[9]  =    50.0;
-  ratiotable[10] =    100.0;      ratiotable[11] =   300.0;
-  ratiotable[12] =   1000.0;      ratiotable[13] = 10000.0;
-  ratiotable[14] = 100000.0;      ratiotable[15] =     0.0;
-  for (i = 0; i < 16; i++) {
-    aspecttable[i] = 0;
-  }
+/*****************************************************************************/
+/*                                                                           */
+/*  livepush()   Put an edge on the stack of edges livefixup() will check.   */
+/*                                                                           */
+/*****************************************************************************/
 
-  worstaspect = 0.0;
-  minaltitude = m->xmax - m->xmin + m->ymax - m->ymin;
-  minaltitude = minaltitude * minaltitude;
-  shortest = minaltitude;
-  longest = 0.0;
-  smallestarea = minaltitude;
-  biggestarea = 0.0;
-  worstaspect = 0.0;
-  smallestangle = 0.0;
-  biggestangle = 2.0;
-  acutebiggest = 1;
+#ifdef ANSI_DECLARATORS
+void livepush(struct triangulateworkspace *ws, struct otri *edge)
+#else /* not ANSI_DECLARATORS */
+void livepush(ws, edge)
+struct triangulateworkspace *ws;
+struct otri *edge;
+#endif /* not ANSI_DECLARATORS */
 
-  traversalinit(&m->triangles);
-  triangleloop.tri = triangletraverse(m);
-  triangleloop.orient = 0;
-  while (triangleloop.tri != (triangle *) NULL) {
-    org(triangleloop, p[0]);
-    dest(triangleloop, p[1]);
-    apex(triangleloop, p[2]);
-    trilongest2 = 0.0;
+{
+  spacegrow(ws, &ws->livestack, ws->livestacksize * (int) sizeof(struct otri),
+            (ws->livestacksize + 1) * (int) sizeof(struct otri));
+  ((struct otri *) ws->livestack.memory)[ws->livestacksize++] = *edge;
+}
 
-    for (i = 0; i < 3; i++) {
-      j = plus1mod3[i];
-      k = minus1mod3[i];
-      dx[i] = p[j][0] - p[k][0];
-      dy[i] = p[j][1] - p[k][1];
-      edgelength[i] = dx[i] * dx[i] + dy[i] * dy[i];
-      if (edgelength[i] > trilongest2) {
-        trilongest2 = edgelength[i];
-      }
-      if (edgelength[i] > longest) {
-        longest = edgelength[i];
-      }
-      if (edgelength[i] < shortest) {
-        shortest = edgelength[i];
-      }
-    }
+/*****************************************************************************/
+/*                                                                           */
+/*  livefixup()   Restore the constrained Delaunay property by flipping the  */
+/*                edges on the stack (and the edges they lead to) until      */
+/*                none is left that isn't locally Delaunay.                  */
+/*                                                                           */
+/*  This is Lawson's algorithm.  Only the edges that might have stopped      */
+/*  being locally Delaunay are on the stack, so the work is proportional to  */
+/*  the number of flips.                                                     */
+/*                                                                           */
+/*  A flip rewrites the two triangles on either side of the edge.  So the    */
+/*  four edges around the flipped one are stacked from the side of the       */
+/*  triangles outside, which the flip leaves alone.  If one of those is      */
+/*  flipped later, its edge is gone anyway and the edges around it are       */
+/*  stacked in turn, so no edge that needs checking is ever missed.          */
+/*                                                                           */
+/*****************************************************************************/
 
-    triarea = counterclockwise(m, b, p[0], p[1], p[2]);
-    if (triarea < smallestarea) {
-      smallestarea = triarea;
-    }
-    if (triarea > biggestarea) {
-      biggestarea = triarea;
-    }
-    triminaltitude2 = triarea * triarea / trilongest2;
-    if (triminaltitude2 < minaltitude) {
-      minaltitude = triminaltitude2;
-    }
-    triaspect2 = trilongest2 / triminaltitude2;
-    if (triaspect2 > worstaspect) {
-      worstaspect = triaspect2;
-    }
-    aspectindex = 0;
-    while ((triaspect2 > ratiotable[aspectindex] * ratiotable[aspectindex])
-           && (aspectindex < 15)) {
-      aspectindex++;
-    }
-    aspecttable[aspectindex]++;
+#ifdef ANSI_DECLARATORS
+void livefixup(struct triangulateworkspace *ws, struct mesh *m,
+               struct behavior *b)
+#else /* not ANSI_DECLARATORS */
+void livefixup(ws, m, b)
+struct triangulateworkspace *ws;
+struct mesh *m;
+struct behavior *b;
+#endif /* not ANSI_DECLARATORS */
 
-    for (i = 0; i < 3; i++) {
-      j = plus1mod3[i];
-      k = minus1mod3[i];
-      dotproduct = dx[j] * dx[k] + dy[j] * dy[k];
-      cossquare = dotproduct * dotproduct / (edgelength[j] * edgelength[k]);
-      tendegree = 8;
-      for (ii = 7; ii >= 0; ii--) {
-        if (cossquare > cossquaretable[ii]) {
-          tendegree = ii;
-        }
-      }
-      if (dotproduct <= 0.0) {
-        angletable[tendegree]++;
-        if (cossquare > smallestangle) {
-          smallestangle = cossquare;
-        }
-        if (acutebiggest && (cossquare < biggestangle)) {
-          biggestangle = cossquare;
+{
+  struct otri fixedge, top;
+  struct otri sideedge, outside;
+  struct osub checksubseg;
+  vertex leftvertex, rightvertex, botvertex, farvertex;
+  int i;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
+
+  while (ws->livestacksize > 0) {
+    ws->livestacksize--;
+    fixedge = ((struct otri *) ws->livestack.memory)[ws->livestacksize];
+    if (deadtri(fixedge.tri)) {
+      continue;
+    }
+    sym(fixedge, top);
+    if (top.tri == m->dummytri) {
+      continue;
+    }
+    tspivot(fixedge, checksubseg);
+    if (checksubseg.ss != m->dummysub) {
+      /* Segments are never flipped. */
+      continue;
+    }
+    org(fixedge, rightvertex);
+    dest(fixedge, leftvertex);
+    apex(fixedge, botvertex);
+    apex(top, farvertex);
+    if (incircle(m, b, rightvertex, leftvertex, botvertex, farvertex) > 0.0) {
+      for (i = 0; i < 4; i++) {
+        if (i == 0) {
+          lnext(fixedge, sideedge);
+        } else if (i == 1) {
+          lprev(fixedge, sideedge);
+        } else if (i == 2) {
+          lnext(top, sideedge);
+        } else {
+          lprev(top, sideedge);
         }
-      } else {
-        angletable[17 - tendegree]++;
-        if (acutebiggest || (cossquare > biggestangle)) {
-          biggestangle = cossquare;
-          acutebiggest = 0;
+        sym(sideedge, outside);
+        if (outside.tri != m->dummytri) {
+          livepush(ws, &outside);
         }
       }
+      flip(m, b, &fixedge);
     }
-    triangleloop.tri = triangletraverse(m);
   }
+}
 
-  shortest = sqrt(shortest);
-  longest = sqrt(longest);
-  minaltitude = sqrt(minaltitude);
-  worstaspect = sqrt(worstaspect);
-  smallestarea *= 0.5;
-  biggestarea *= 0.5;
-  if (smallestangle >= 1.0) {
-    smallestangle = 0.0;
-  } else {
-    smallestangle = degconst * acos(sqrt(smallestangle));
-  }
-  if (biggestangle >= 1.0) {
-    biggestangle = 180.0;
-  } else {
-    if (acutebiggest) {
-      biggestangle = degconst * acos(sqrt(biggestangle));
-    } else {
-      biggestangle = 180.0 - degconst * acos(sqrt(biggestangle));
-    }
-  }
+/*****************************************************************************/
+/*                                                                           */
+/*  livedissolve()   Remove every subsegment that ends at a vertex.          */
+/*                                                                           */
+/*  If `record' is set, the other ends of the subsegments are left in        */
+/*  `liveends'.  Returns how many subsegments there were.                    */
+/*                                                                           */
+/*****************************************************************************/
 
-  printf("  Smallest area: %16.5g   |  Largest area: %16.5g\n",
-         smallestarea, biggestarea);
-  printf("  Shortest edge: %16.5g   |  Longest edge: %16.5g\n",
-         shortest, longest);
-  printf("  Shortest altitude: %12.5g   |  Largest aspect ratio: %8.5g\n\n",
-         minaltitude, worstaspect);
+#ifdef ANSI_DECLARATORS
+int livedissolve(struct triangulateworkspace *ws, struct mesh *m,
+                 struct behavior *b, vertex dissolvevertex, int record)
+#else /* not ANSI_DECLARATORS */
+int livedissolve(ws, m, b, dissolvevertex, record)
+struct triangulateworkspace *ws;
+struct mesh *m;
+struct behavior *b;
+vertex dissolvevertex;
+int record;
+#endif /* not ANSI_DECLARATORS */
 
-  printf("  Triangle aspect ratio histogram:\n");
-  printf("  1.1547 - %-6.6g    :  %8d    | %6.6g - %-6.6g     :  %8d\n",
-         ratiotable[0], aspecttable[0], ratiotable[7], ratiotable[8],
-         aspecttable[8]);
-  for (i = 1; i < 7; i++) {
-    printf("  %6.6g - %-6.6g    :  %8d    | %6.6g - %-6.6g     :  %8d\n",
-           ratiotable[i - 1], ratiotable[i], aspecttable[i],
-           ratiotable[i + 7], ratiotable[i + 8], aspecttable[i + 8]);
-  }
-  printf("  %6.6g - %-6.6g    :  %8d    | %6.6g -            :  %8d\n",
-         ratiotable[6], ratiotable[7], aspecttable[7], ratiotable[14],
-         aspecttable[15]);
-  printf("  (Aspect ratio is longest edge divided by shortest altitude)\n\n");
+{
+  struct otri firsttri, spintri, opptri;
+  struct osub dissolvesubseg;
+  vertex farvertex;
+  int count;
+  triangle ptr;   /* Temporary variable used by sym(), onext(), and oprev(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
 
-  printf("  Smallest angle: %15.5g   |  Largest angle: %15.5g\n\n",
-         smallestangle, biggestangle);
+  count = 0;
+  livefind(m, b, dissolvevertex, &firsttri);
+  otricopy(firsttri, spintri);
+  do {
+    tspivot(spintri, dissolvesubseg);
+    if (dissolvesubseg.ss != m->dummysub) {
+      if (record) {
+        dest(spintri, farvertex);
+        spacegrow(ws, &ws->liveends, count * (int) sizeof(vertex),
+                  (count + 1) * (int) sizeof(vertex));
+        ((vertex *) ws->liveends.memory)[count] = farvertex;
+      }
+      count++;
+      tsdissolve(spintri);
+      sym(spintri, opptri);
+      tsdissolve(opptri);
+      subsegdealloc(m, dissolvesubseg.ss);
+    }
+    onextself(spintri);
+  } while (!otriequal(spintri, firsttri));
+  return count;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  livelinked()   Is the edge between two vertices a side of the polygon    */
+/*                 in `livelink'?                                            */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int livelinked(struct triangulateworkspace *ws, int links, vertex vertex1,
+               vertex vertex2)
+#else /* not ANSI_DECLARATORS */
+int livelinked(ws, links, vertex1, vertex2)
+struct triangulateworkspace *ws;
+int links;
+vertex vertex1;
+vertex vertex2;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex *link;
+  int i;
 
-  printf("  Angle histogram:\n");
-  for (i = 0; i < 9; i++) {
-    printf("    %3d - %3d degrees:  %8d    |    %3d - %3d degrees:  %8d\n",
-           i * 10, i * 10 + 10, angletable[i],
-           i * 10 + 90, i * 10 + 100, angletable[i + 9]);
+  link = (vertex *) ws->livelink.memory;
+  for (i = 0; i < links; i++) {
+    if (((link[i] == vertex1) && (link[(i + 1) % links] == vertex2)) ||
+        ((link[i] == vertex2) && (link[(i + 1) % links] == vertex1))) {
+      return 1;
+    }
   }
-  printf("\n");
+  return 0;
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  statistics()   Print all sorts of cool facts.                            */
+/*  liveremove()   Delete a vertex and the subsegments that end at it.       */
+/*                                                                           */
+/*  A duplicate vertex (one Triangle set aside because another vertex was    */
+/*  already at the same place) is not in the triangulation, so it is just    */
+/*  freed.  Returns the number of subsegments, as livedissolve() does.       */
+/*                                                                           */
+/*  deletevertex() alone won't do here.  triangulatepolygon() chooses the    */
+/*  new triangles by the incircle test, as if every vertex of the polygon    */
+/*  could see every other, and next to segments that isn't so; it can leave  */
+/*  inverted triangles behind.  So the edges at the vertex are flipped away  */
+/*  first, each only where its quadrilateral is convex, until three are      */
+/*  left and deletevertex() merely merges three triangles into one.  The     */
+/*  triangles that fill the hole are then made constrained Delaunay by       */
+/*  livefixup().                                                             */
 /*                                                                           */
 /*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-void statistics(struct mesh *m, struct behavior *b)
+int liveremove(struct triangulateworkspace *ws, struct mesh *m,
+               struct behavior *b, vertex deadvertex, int record)
 #else /* not ANSI_DECLARATORS */
-void statistics(m, b)
+int liveremove(ws, m, b, deadvertex, record)
+struct triangulateworkspace *ws;
 struct mesh *m;
 struct behavior *b;
+vertex deadvertex;
+int record;
 #endif /* not ANSI_DECLARATORS */
 
 {
-  printf("\nStatistics:\n\n");
-  printf("  Input vertices: %d\n", m->invertices);
-  if (b->refine) {
-    printf("  Input triangles: %d\n", m->inelements);
-  }
-  if (b->poly) {
-    printf("  Input segments: %d\n", m->insegments);
-    if (!b->refine) {
-      printf("  Input holes: %d\n", m->holes);
-    }
-  }
+  struct otri deltri, spintri, opptri, holetri;
+  vertex farvertex, leftvertex, rightvertex;
+  triangle **hole;
+  int count;
+  int links, degree, holes;
+  int unflippable;
+  int i, j;
+  triangle ptr;   /* Temporary variable used by sym(), onext(), and oprev(). */
 
-  printf("\n  Mesh vertices: %ld\n", m->vertices.items - m->undeads);
-  printf("  Mesh triangles: %ld\n", m->triangles.items);
-  printf("  Mesh edges: %ld\n", m->edges);
-  printf("  Mesh exterior boundary edges: %ld\n", m->hullsize);
-  if (b->poly || b->refine) {
-    printf("  Mesh interior boundary edges: %ld\n",
-           m->subsegs.items - m->hullsize);
-    printf("  Mesh subsegments (constrained edges): %ld\n",
-           m->subsegs.items);
+  if (vertextype(deadvertex) == UNDEADVERTEX) {
+    vertexdealloc(m, deadvertex);
+    return 0;
   }
-  printf("\n");
-
-  if (b->verbose) {
-    quality_statistics(m, b);
-    printf("Memory allocation statistics:\n\n");
-    printf("  Maximum number of vertices: %ld\n", m->vertices.maxitems);
-    printf("  Maximum number of triangles: %ld\n", m->triangles.maxitems);
-    if (m->subsegs.maxitems > 0) {
-      printf("  Maximum number of subsegments: %ld\n", m->subsegs.maxitems);
-    }
-    if (m->viri.maxitems > 0) {
-      printf("  Maximum number of viri: %ld\n", m->viri.maxitems);
-    }
-    if (m->badsubsegs.maxitems > 0) {
-      printf("  Maximum number of encroached subsegments: %ld\n",
-             m->badsubsegs.maxitems);
-    }
-    if (m->badtriangles.maxitems > 0) {
-      printf("  Maximum number of bad triangles: %ld\n",
-             m->badtriangles.maxitems);
-    }
-    if (m->flipstackers.maxitems > 0) {
-      printf("  Maximum number of stacked triangle flips: %ld\n",
-             m->flipstackers.maxitems);
-    }
-    if (m->splaynodes.maxitems > 0) {
-      printf("  Maximum number of splay tree nodes: %ld\n",
-             m->splaynodes.maxitems);
-    }
-    printf("  Approximate heap memory use (bytes): %ld\n\n",
-           m->vertices.maxitems * m->vertices.itembytes +
-           m->triangles.maxitems * m->triangles.itembytes +
-           m->subsegs.maxitems * m->subsegs.itembytes +
-           m->viri.maxitems * m->viri.itembytes +
-           m->badsubsegs.maxitems * m->badsubsegs.itembytes +
-           m->badtriangles.maxitems * m->badtriangles.itembytes +
-           m->flipstackers.maxitems * m->flipstackers.itembytes +
-           m->splaynodes.maxitems * m->splaynodes.itembytes);
+  count = livedissolve(ws, m, b, deadvertex, record);
+  livefind(m, b, deadvertex, &deltri);
 
-    printf("Algorithmic statistics:\n\n");
-    if (!b->weighted) {
-      printf("  Number of incircle tests: %ld\n", m->incirclecount);
+  /* Remember the polygon around the vertex; the hole will be this shape. */
+  links = 0;
+  otricopy(deltri, spintri);
+  do {
+    dest(spintri, farvertex);
+    spacegrow(ws, &ws->livelink, links * (int) sizeof(vertex),
+              (links + 1) * (int) sizeof(vertex));
+    ((vertex *) ws->livelink.memory)[links++] = farvertex;
+    onextself(spintri);
+  } while (!otriequal(spintri, deltri));
+
+  /* Flip edges away until the vertex has three left.  If none can be    */
+  /*   flipped before that, the vertex is where the diagonals of a convex */
+  /*   quadrilateral cross, which triangulatepolygon() gets right.        */
+  degree = links;
+  unflippable = 0;
+  while ((degree > 3) && (unflippable < degree)) {
+    sym(spintri, opptri);
+    dest(spintri, farvertex);
+    apex(spintri, leftvertex);
+    apex(opptri, rightvertex);
+    if ((counterclockwise(m, b, deadvertex, rightvertex, leftvertex) > 0.0) &&
+        (counterclockwise(m, b, farvertex, leftvertex, rightvertex) > 0.0)) {
+      flip(m, b, &spintri);
+      /* The flipped edge is directed away from the vertex's new neighbor; */
+      /*   the edge before it starts at the vertex again.                  */
+      lprevself(spintri);
+      degree--;
+      unflippable = 0;
     } else {
-      printf("  Number of 3D orientation tests: %ld\n", m->orient3dcount);
-    }
-    printf("  Number of 2D orientation tests: %ld\n", m->counterclockcount);
-    if (m->hyperbolacount > 0) {
-      printf("  Number of right-of-hyperbola tests: %ld\n",
-             m->hyperbolacount);
-    }
-    if (m->circletopcount > 0) {
-      printf("  Number of circle top computations: %ld\n",
-             m->circletopcount);
-    }
-    if (m->circumcentercount > 0) {
-      printf("  Number of triangle circumcenter computations: %ld\n",
-             m->circumcentercount);
+      onextself(spintri);
+      unflippable++;
+    }
+  }
+  deletevertex(m, b, &spintri);
+
+  /* Stack every edge of the triangles that fill the hole now.  They are */
+  /*   found by walking from the merged triangle across the edges that   */
+  /*   aren't sides of the polygon.                                      */
+  holes = 0;
+  spacegrow(ws, &ws->livehole, 0, (int) sizeof(triangle *));
+  ((triangle **) ws->livehole.memory)[holes++] = spintri.tri;
+  for (i = 0; i < holes; i++) {
+    holetri.tri = ((triangle **) ws->livehole.memory)[i];
+    for (holetri.orient = 0; holetri.orient < 3; holetri.orient++) {
+      livepush(ws, &holetri);
+      org(holetri, leftvertex);
+      dest(holetri, rightvertex);
+      if (!livelinked(ws, links, leftvertex, rightvertex)) {
+        sym(holetri, opptri);
+        hole = (triangle **) ws->livehole.memory;
+        for (j = 0; (j < holes) && (hole[j] != opptri.tri); j++);
+        if (j == holes) {
+          spacegrow(ws, &ws->livehole, holes * (int) sizeof(triangle *),
+                    (holes + 1) * (int) sizeof(triangle *));
+          ((triangle **) ws->livehole.memory)[holes++] = opptri.tri;
+        }
+      }
     }
-    printf("\n");
   }
+  livefixup(ws, m, b);
+  return count;
 }
 
 /*****************************************************************************/
 /*                                                                           */
-/*  main() or triangulate()   Gosh, do everything.                           */
-/*                                                                           */
-/*  The sequence is roughly as follows.  Many of these steps can be skipped, */
-/*  depending on the command line switches.                                  */
-/*                                                                           */
-/*  - Initialize constants and parse the command line.                       */
-/*  - Read the vertices from a file and either                               */
-/*    - triangulate them (no -r), or                                         */
-/*    - read an old mesh from files and reconstruct it (-r).                 */
-/*  - Insert the PSLG segments (-p), and possibly segments on the convex     */
-/*      hull (-c).                                                           */
-/*  - Read the holes (-p), regional attributes (-pA), and regional area      */
-/*      constraints (-pa).  Carve the holes and concavities, and spread the  */
-/*      regional attributes and area constraints.                            */
-/*  - Enforce the constraints on minimum angle (-q) and maximum area (-a).   */
-/*      Also enforce the conforming Delaunay property (-q and -a).           */
-/*  - Compute the number of edges in the resulting mesh.                     */
-/*  - Promote the mesh's linear triangles to higher order elements (-o).     */
-/*  - Write the output files and print the statistics.                       */
-/*  - Check the consistency and Delaunay property of the mesh (-C).          */
+/*  liveadd()   Insert a vertex with a given id.  Returns TRI_ERROR_INPUT    */
+/*              (and inserts nothing) if there is a vertex at that place     */
+/*              already, or the place is on a segment.                       */
 /*                                                                           */
 /*****************************************************************************/
 
-//#define REDUCED
-#define ANSI_DECLARATORS
-#define TRILIBRARY
-//#define CDT_ONLY
-
-#ifdef TRILIBRARY
-
 #ifdef ANSI_DECLARATORS
-void triangulate(char *triswitches, struct triangulateio *in,
-                 struct triangulateio *out, struct triangulateio *vorout)
+int liveadd(struct triangulateworkspace *ws, struct mesh *m,
+            struct behavior *b, REAL x, REAL y, int id)
 #else /* not ANSI_DECLARATORS */
-void triangulate(triswitches, in, out, vorout)
-char *triswitches;
-struct triangulateio *in;
-struct triangulateio *out;
-struct triangulateio *vorout;
+int liveadd(ws, m, b, x, y, id)
+struct triangulateworkspace *ws;
+struct mesh *m;
+struct behavior *b;
+REAL x;
+REAL y;
+int id;
 #endif /* not ANSI_DECLARATORS */
 
-#else /* not TRILIBRARY */
+{
+  struct otri searchtri;
+  vertex newvertex;
+
+  newvertex = (vertex) poolalloc(&m->vertices);
+  newvertex[0] = x;
+  newvertex[1] = y;
+  setvertexmark(newvertex, id);
+  setvertextype(newvertex, INPUTVERTEX);
+  setvertex2tri(newvertex, (triangle) NULL);
+  searchtri.tri = m->dummytri;
+  searchtri.orient = 0;
+  if (insertvertex(m, b, newvertex, &searchtri, (struct osub *) NULL, 0, 0)
+      != SUCCESSFULVERTEX) {
+    vertexdealloc(m, newvertex);
+    return TRI_ERROR_INPUT;
+  }
+  ((vertex *) ws->livevertices.memory)[id] = newvertex;
+  return TRI_OK;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  liveconnect()   Insert a segment between two vertices.                   */
+/*                                                                           */
+/*  A segment that runs through a vertex is split there, as usual.  A        */
+/*  segment that crosses another one would need a new vertex where they      */
+/*  cross, which has no id; that ends the live mesh, and TRI_ERROR_INPUT is  */
+/*  returned.                                                                */
+/*                                                                           */
+/*****************************************************************************/
 
 #ifdef ANSI_DECLARATORS
-int main(int argc, char **argv)
+int liveconnect(struct triangulateworkspace *ws, struct mesh *m,
+                struct behavior *b, vertex endpoint1, vertex endpoint2)
 #else /* not ANSI_DECLARATORS */
-int main(argc, argv)
-int argc;
-char **argv;
+int liveconnect(ws, m, b, endpoint1, endpoint2)
+struct triangulateworkspace *ws;
+struct mesh *m;
+struct behavior *b;
+vertex endpoint1;
+vertex endpoint2;
 #endif /* not ANSI_DECLARATORS */
 
-#endif /* not TRILIBRARY */
-
 {
-  struct mesh m;
-  struct behavior b;
-  REAL *holearray;                                        /* Array of holes. */
-  REAL *regionarray;   /* Array of regional attributes and area constraints. */
-#ifndef TRILIBRARY
-  FILE *polyfile;
-#endif /* not TRILIBRARY */
-#ifndef NO_TIMER
-  /* Variables for timing the performance of Triangle.  The types are */
-  /*   defined in sys/time.h.                                         */
-  struct timeval tv0, tv1, tv2, tv3, tv4, tv5, tv6;
-  struct timezone tz;
-#endif /* not NO_TIMER */
-
-#ifndef NO_TIMER
-  gettimeofday(&tv0, &tz);
-#endif /* not NO_TIMER */
+  struct otri searchtri;
+  long vertexcount;
+
+  if ((endpoint1 == endpoint2) ||
+      (vertextype(endpoint1) == UNDEADVERTEX) ||
+      (vertextype(endpoint2) == UNDEADVERTEX)) {
+    return TRI_ERROR_INPUT;
+  }
+  /* insertsegment() trusts vertex2tri(), so make sure it is up to date. */
+  livefind(m, b, endpoint1, &searchtri);
+  livefind(m, b, endpoint2, &searchtri);
+  vertexcount = m->vertices.items;
+  /* A marker of zero leaves the vertex markers (the ids) alone. */
+  insertsegment(m, b, endpoint1, endpoint2, 0);
+  if (m->vertices.items != vertexcount) {
+    ws->live = 0;
+    return TRI_ERROR_INPUT;
+  }
+  return TRI_OK;
+}
 
-  triangleinit(&m);
-#ifdef TRILIBRARY
-  parsecommandline(1, &triswitches, &b);
-#else /* not TRILIBRARY */
-  parsecommandline(argc, argv, &b);
-#endif /* not TRILIBRARY */
-  m.steinerleft = b.steiner;
+/*****************************************************************************/
+/*                                                                           */
+/*  trilivebegin()   Start a live mesh:  the constrained Delaunay            */
+/*                   triangulation of the points and segments of `in',       */
+/*                   inside the frame (xmin, ymin) - (xmax, ymax).           */
+/*                                                                           */
+/*****************************************************************************/
 
-#ifdef TRILIBRARY
-  transfernodes(&m, &b, in->pointlist, in->pointattributelist,
-                in->pointmarkerlist, in->numberofpoints,
-                in->numberofpointattributes);
-#else /* not TRILIBRARY */
-  readnodes(&m, &b, b.innodefilename, b.inpolyfilename, &polyfile);
-#endif /* not TRILIBRARY */
+#ifdef ANSI_DECLARATORS
+int trilivebegin(struct triangulateworkspace *ws, struct triangulateio *in,
+                 REAL xmin, REAL ymin, REAL xmax, REAL ymax)
+#else /* not ANSI_DECLARATORS */
+int trilivebegin(ws, in, xmin, ymin, xmax, ymax)
+struct triangulateworkspace *ws;
+struct triangulateio *in;
+REAL xmin;
+REAL ymin;
+REAL xmax;
+REAL ymax;
+#endif /* not ANSI_DECLARATORS */
 
-#ifndef NO_TIMER
-  if (!b.quiet) {
-    gettimeofday(&tv1, &tz);
+{
+  struct triangulateio framed, out;
+  struct mesh *m;
+  vertex vertexloop;
+  REAL *pointlist;
+  int *markerlist;
+  int *segmentlist;
+  int points, segments;
+  int status;
+  int i;
+  /* `p' for segments, `z' for numbering from zero, `Y' keeps deletevertex() */
+  /*   from checking triangle quality, and `N', `E' and `P' skip the output. */
+  char switches[] = "pzYQNEP";
+  char *argv0;
+
+  ws->live = 0;
+  points = in->numberofpoints;
+  segments = in->numberofsegments;
+  ws->livexmin = xmin;
+  ws->liveymin = ymin;
+  ws->livexmax = xmax;
+  ws->liveymax = ymax;
+  for (i = 0; i < points; i++) {
+    if (!liveinside(ws, in->pointlist[i * 2], in->pointlist[i * 2 + 1])) {
+      return TRI_ERROR_INPUT;
+    }
+  }
+  for (i = 0; i < segments * 2; i++) {
+    if ((in->segmentlist[i] < 0) || (in->segmentlist[i] >= points)) {
+      return TRI_ERROR_INPUT;
+    }
+  }
+
+  try {
+    /* The input, and the frame after it. */
+    pointlist = (REAL *) spacereserve(ws, &ws->livepointlist,
+                                      (points + 4) * 2 * (int) sizeof(REAL));
+    markerlist = (int *) spacereserve(ws, &ws->livemarkerlist,
+                                      (segments + 4) * (int) sizeof(int));
+    segmentlist = (int *) spacereserve(ws, &ws->livesegmentlist,
+                                       (segments + 4) * 2 * (int) sizeof(int));
+  } catch (struct trierror &error) {
+    return error.status;
+  }
+  for (i = 0; i < points * 2; i++) {
+    pointlist[i] = in->pointlist[i];
+  }
+  for (i = 0; i < segments * 2; i++) {
+    segmentlist[i] = in->segmentlist[i];
+  }
+  pointlist[points * 2] = xmin;
+  pointlist[points * 2 + 1] = ymin;
+  pointlist[points * 2 + 2] = xmax;
+  pointlist[points * 2 + 3] = ymin;
+  pointlist[points * 2 + 4] = xmax;
+  pointlist[points * 2 + 5] = ymax;
+  pointlist[points * 2 + 6] = xmin;
+  pointlist[points * 2 + 7] = ymax;
+  for (i = 0; i < 4; i++) {
+    segmentlist[(segments + i) * 2] = points + i;
+    segmentlist[(segments + i) * 2 + 1] = points + (i + 1) % 4;
+  }
+  /* Zero markers, so that inserting the segments leaves the vertex */
+  /*   markers alone.                                               */
+  for (i = 0; i < segments + 4; i++) {
+    markerlist[i] = 0;
+  }
+
+  memset(&framed, 0, sizeof(struct triangulateio));
+  memset(&out, 0, sizeof(struct triangulateio));
+  framed.pointlist = pointlist;
+  framed.numberofpoints = points + 4;
+  framed.segmentlist = segmentlist;
+  framed.segmentmarkerlist = markerlist;
+  framed.numberofsegments = segments + 4;
+  status = triangulatews(switches, &framed, &out,
+                         (struct triangulateio *) NULL, ws);
+  if (status != TRI_OK) {
+    return status;
+  }
+
+  m = &ws->m;
+  argv0 = switches;
+  parsecommandline(1, &argv0, &ws->liveb);
+  ws->liveids = 0;
+  ws->livefreeids = 0;
+  ws->livestacksize = 0;
+  try {
+    spacegrow(ws, &ws->livevertices, 0, points * (int) sizeof(vertex));
+  } catch (struct trierror &error) {
+    return error.status;
+  }
+  ws->liveids = points;
+  /* Writing the output numbered the vertices in order, in their markers, */
+  /*   so the id of each input vertex is its index.  The frame's are -1.  */
+  /*   Vertices added where input segments cross get the next ids.        */
+  try {
+    traversalinit(&m->vertices);
+    vertexloop = vertextraverse(m);
+    while (vertexloop != (vertex) NULL) {
+      i = vertexmark(vertexloop);
+      if (i < points) {
+        ((vertex *) ws->livevertices.memory)[i] = vertexloop;
+      } else if (i < points + 4) {
+        setvertexmark(vertexloop, -1);
+        ws->liveframe = vertexloop;
+      } else {
+        i = livenewid(ws);
+        setvertexmark(vertexloop, i);
+        ((vertex *) ws->livevertices.memory)[i] = vertexloop;
+      }
+      setvertex2tri(vertexloop, (triangle) NULL);
+      vertexloop = vertextraverse(m);
+    }
+  } catch (struct trierror &error) {
+    return error.status;
   }
-#endif /* not NO_TIMER */
+  ws->live = 1;
+  return TRI_OK;
+}
 
-#ifdef CDT_ONLY
-  m.hullsize = delaunay(&m, &b);                /* Triangulate the vertices. */
-#else /* not CDT_ONLY */
-  if (b.refine) {
-    /* Read and reconstruct a mesh. */
-#ifdef TRILIBRARY
-    m.hullsize = reconstruct(&m, &b, in->trianglelist,
-                             in->triangleattributelist, in->trianglearealist,
-                             in->numberoftriangles, in->numberofcorners,
-                             in->numberoftriangleattributes,
-                             in->segmentlist, in->segmentmarkerlist,
-                             in->numberofsegments);
-#else /* not TRILIBRARY */
-    m.hullsize = reconstruct(&m, &b, b.inelefilename, b.areafilename,
-                             b.inpolyfilename, polyfile);
-#endif /* not TRILIBRARY */
-  } else {
-    m.hullsize = delaunay(&m, &b);              /* Triangulate the vertices. */
-  }
-#endif /* not CDT_ONLY */
+/*****************************************************************************/
+/*                                                                           */
+/*  triliveactive()   Check whether a workspace holds a live mesh.           */
+/*                                                                           */
+/*****************************************************************************/
 
-#ifndef NO_TIMER
-  if (!b.quiet) {
-    gettimeofday(&tv2, &tz);
-    if (b.refine) {
-      printf("Mesh reconstruction");
-    } else {
-      printf("Delaunay");
-    }
-    printf(" milliseconds:  %ld\n", 1000l * (tv2.tv_sec - tv1.tv_sec) +
-           (tv2.tv_usec - tv1.tv_usec) / 1000l);
-  }
-#endif /* not NO_TIMER */
+#ifdef ANSI_DECLARATORS
+int triliveactive(struct triangulateworkspace *ws)
+#else /* not ANSI_DECLARATORS */
+int triliveactive(ws)
+struct triangulateworkspace *ws;
+#endif /* not ANSI_DECLARATORS */
 
-  /* Ensure that no vertex can be mistaken for a triangular bounding */
-  /*   box vertex in insertvertex().                                 */
-  m.infvertex1 = (vertex) NULL;
-  m.infvertex2 = (vertex) NULL;
-  m.infvertex3 = (vertex) NULL;
+{
+  return ws->live;
+}
 
-  if (b.usesegments) {
-    m.checksegments = 1;                /* Segments will be introduced next. */
-    if (!b.refine) {
-      /* Insert PSLG segments and/or convex hull segments. */
-#ifdef TRILIBRARY
-      formskeleton(&m, &b, in->segmentlist,
-                   in->segmentmarkerlist, in->numberofsegments);
-#else /* not TRILIBRARY */
-      formskeleton(&m, &b, polyfile, b.inpolyfilename);
-#endif /* not TRILIBRARY */
-    }
-  }
+/*****************************************************************************/
+/*                                                                           */
+/*  triliveinsert()   Insert a vertex; its id is returned in `id'.           */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int triliveinsert(struct triangulateworkspace *ws, REAL x, REAL y, int *id)
+#else /* not ANSI_DECLARATORS */
+int triliveinsert(ws, x, y, id)
+struct triangulateworkspace *ws;
+REAL x;
+REAL y;
+int *id;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  int newid;
+  int status;
 
-#ifndef NO_TIMER
-  if (!b.quiet) {
-    gettimeofday(&tv3, &tz);
-    if (b.usesegments && !b.refine) {
-      printf("Segment milliseconds:  %ld\n",
-             1000l * (tv3.tv_sec - tv2.tv_sec) +
-             (tv3.tv_usec - tv2.tv_usec) / 1000l);
-    }
+  if (!ws->live || !liveinside(ws, x, y)) {
+    return TRI_ERROR_INPUT;
   }
-#endif /* not NO_TIMER */
-
-  if (b.poly && (m.triangles.items > 0)) {
-#ifdef TRILIBRARY
-    holearray = in->holelist;
-    m.holes = in->numberofholes;
-    regionarray = in->regionlist;
-    m.regions = in->numberofregions;
-#else /* not TRILIBRARY */
-    readholes(&m, &b, polyfile, b.inpolyfilename, &holearray, &m.holes,
-              &regionarray, &m.regions);
-#endif /* not TRILIBRARY */
-    if (!b.refine) {
-      /* Carve out holes and concavities. */
-      carveholes(&m, &b, holearray, m.holes, regionarray, m.regions);
+  try {
+    newid = livenewid(ws);
+    status = liveadd(ws, &ws->m, &ws->liveb, x, y, newid);
+    if (status != TRI_OK) {
+      livefreeid(ws, newid);
+      return status;
     }
-  } else {
-    /* Without a PSLG, there can be no holes or regional attributes   */
-    /*   or area constraints.  The following are set to zero to avoid */
-    /*   an accidental free() later.                                  */
-    m.holes = 0;
-    m.regions = 0;
+  } catch (struct trierror &error) {
+    ws->live = 0;
+    return error.status;
   }
+  *id = newid;
+  return TRI_OK;
+}
 
-#ifndef NO_TIMER
-  if (!b.quiet) {
-    gettimeofday(&tv4, &tz);
-    if (b.poly && !b.refine) {
-      printf("Hole milliseconds:  %ld\n", 1000l * (tv4.tv_sec - tv3.tv_sec) +
-             (tv4.tv_usec - tv3.tv_usec) / 1000l);
-    }
-  }
-#endif /* not NO_TIMER */
+/*****************************************************************************/
+/*                                                                           */
+/*  trilivedelete()   Delete a vertex, and the segments that end at it.      */
+/*                                                                           */
+/*****************************************************************************/
 
-#ifndef CDT_ONLY
-  if (b.quality && (m.triangles.items > 0)) {
-	//#error here
-    enforcequality(&m, &b);           /* Enforce angle and area constraints. */
+#ifdef ANSI_DECLARATORS
+int trilivedelete(struct triangulateworkspace *ws, int id)
+#else /* not ANSI_DECLARATORS */
+int trilivedelete(ws, id)
+struct triangulateworkspace *ws;
+int id;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  vertex deadvertex;
+
+  deadvertex = livevertex(ws, id);
+  if (deadvertex == (vertex) NULL) {
+    return TRI_ERROR_INPUT;
   }
-#endif /* not CDT_ONLY */
+  try {
+    liveremove(ws, &ws->m, &ws->liveb, deadvertex, 0);
+    livefreeid(ws, id);
+  } catch (struct trierror &error) {
+    ws->live = 0;
+    return error.status;
+  }
+  return TRI_OK;
+}
 
-#ifndef NO_TIMER
-  if (!b.quiet) {
-    gettimeofday(&tv5, &tz);
-#ifndef CDT_ONLY
-    if (b.quality) {
-      printf("Quality milliseconds:  %ld\n",
-             1000l * (tv5.tv_sec - tv4.tv_sec) +
-             (tv5.tv_usec - tv4.tv_usec) / 1000l);
+/*****************************************************************************/
+/*                                                                           */
+/*  trilivemove()   Move a vertex, and the segments that end at it.          */
+/*                                                                           */
+/*  The vertex is deleted and inserted again.  If it can't be inserted at    */
+/*  the new place, it stays deleted (with its segments), and its id is free. */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int trilivemove(struct triangulateworkspace *ws, int id, REAL x, REAL y)
+#else /* not ANSI_DECLARATORS */
+int trilivemove(ws, id, x, y)
+struct triangulateworkspace *ws;
+int id;
+REAL x;
+REAL y;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  struct behavior *b;
+  vertex movevertex;
+  int ends;
+  int status;
+  int i;
+
+  movevertex = livevertex(ws, id);
+  if ((movevertex == (vertex) NULL) || !liveinside(ws, x, y)) {
+    return TRI_ERROR_INPUT;
+  }
+  if ((movevertex[0] == x) && (movevertex[1] == y)) {
+    return TRI_OK;
+  }
+  m = &ws->m;
+  b = &ws->liveb;
+  try {
+    ends = liveremove(ws, m, b, movevertex, 1);
+    status = liveadd(ws, m, b, x, y, id);
+    if (status != TRI_OK) {
+      livefreeid(ws, id);
+      return status;
+    }
+    movevertex = livevertex(ws, id);
+    for (i = 0; i < ends; i++) {
+      status = liveconnect(ws, m, b, movevertex,
+                           ((vertex *) ws->liveends.memory)[i]);
+      if (status != TRI_OK) {
+        return status;
+      }
     }
-#endif /* not CDT_ONLY */
+  } catch (struct trierror &error) {
+    ws->live = 0;
+    return error.status;
   }
-#endif /* not NO_TIMER */
+  return TRI_OK;
+}
 
-  /* Calculate the number of edges. */
-  m.edges = (3l * m.triangles.items + m.hullsize) / 2l;
+/*****************************************************************************/
+/*                                                                           */
+/*  trilivesegment()   Insert a segment between two vertices.                */
+/*                                                                           */
+/*****************************************************************************/
 
-  if (b.order > 1) {
-    highorder(&m, &b);       /* Promote elements to higher polynomial order. */
-  }
-  if (!b.quiet) {
-    printf("\n");
-  }
+#ifdef ANSI_DECLARATORS
+int trilivesegment(struct triangulateworkspace *ws, int id1, int id2)
+#else /* not ANSI_DECLARATORS */
+int trilivesegment(ws, id1, id2)
+struct triangulateworkspace *ws;
+int id1;
+int id2;
+#endif /* not ANSI_DECLARATORS */
 
-#ifdef TRILIBRARY
-  if (b.jettison) {
-    out->numberofpoints = m.vertices.items - m.undeads;
-  } else {
-    out->numberofpoints = m.vertices.items;
-  }
-  out->numberofpointattributes = m.nextras;
-  out->numberoftriangles = m.triangles.items;
-  out->numberofcorners = (b.order + 1) * (b.order + 2) / 2;
-  out->numberoftriangleattributes = m.eextras;
-  out->numberofedges = m.edges;
-  if (b.usesegments) {
-    out->numberofsegments = m.subsegs.items;
-  } else {
-    out->numberofsegments = m.hullsize;
-  }
-  if (vorout != (struct triangulateio *) NULL) {
-    vorout->numberofpoints = m.triangles.items;
-    vorout->numberofpointattributes = m.nextras;
-    vorout->numberofedges = m.edges;
+{
+  vertex endpoint1, endpoint2;
+
+  endpoint1 = livevertex(ws, id1);
+  endpoint2 = livevertex(ws, id2);
+  if ((endpoint1 == (vertex) NULL) || (endpoint2 == (vertex) NULL)) {
+    return TRI_ERROR_INPUT;
   }
-#endif /* TRILIBRARY */
-  /* If not using iteration numbers, don't write a .node file if one was */
-  /*   read, because the original one would be overwritten!              */
-  if (b.nonodewritten || (b.noiterationnum && m.readnodefile)) {
-    if (!b.quiet) {
-#ifdef TRILIBRARY
-      printf("NOT writing vertices.\n");
-#else /* not TRILIBRARY */
-      printf("NOT writing a .node file.\n");
-#endif /* not TRILIBRARY */
-    }
-    numbernodes(&m, &b);         /* We must remember to number the vertices. */
-  } else {
-    /* writenodes() numbers the vertices too. */
-#ifdef TRILIBRARY
-    writenodes(&m, &b, &out->pointlist, &out->pointattributelist,
-               &out->pointmarkerlist);
-#else /* not TRILIBRARY */
-    writenodes(&m, &b, b.outnodefilename, argc, argv);
-#endif /* TRILIBRARY */
+  try {
+    return liveconnect(ws, &ws->m, &ws->liveb, endpoint1, endpoint2);
+  } catch (struct trierror &error) {
+    ws->live = 0;
+    return error.status;
   }
-  if (b.noelewritten) {
-    if (!b.quiet) {
-#ifdef TRILIBRARY
-      printf("NOT writing triangles.\n");
-#else /* not TRILIBRARY */
-      printf("NOT writing an .ele file.\n");
-#endif /* not TRILIBRARY */
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  triliveunsegment()   Delete the segment between two vertices, which      */
+/*                       must be an edge of the mesh.                        */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int triliveunsegment(struct triangulateworkspace *ws, int id1, int id2)
+#else /* not ANSI_DECLARATORS */
+int triliveunsegment(ws, id1, id2)
+struct triangulateworkspace *ws;
+int id1;
+int id2;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  struct otri firsttri, spintri, opptri;
+  struct osub dissolvesubseg;
+  vertex endpoint1, endpoint2;
+  vertex farvertex;
+  triangle ptr;   /* Temporary variable used by sym(), onext(), and oprev(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
+
+  m = &ws->m;
+  endpoint1 = livevertex(ws, id1);
+  endpoint2 = livevertex(ws, id2);
+  if ((endpoint1 == (vertex) NULL) || (endpoint2 == (vertex) NULL) ||
+      (vertextype(endpoint1) == UNDEADVERTEX)) {
+    return TRI_ERROR_INPUT;
+  }
+  try {
+    /* Look for the edge among the edges around the first vertex. */
+    livefind(m, &ws->liveb, endpoint1, &firsttri);
+    otricopy(firsttri, spintri);
+    do {
+      dest(spintri, farvertex);
+      if (farvertex == endpoint2) {
+        break;
+      }
+      onextself(spintri);
+    } while (!otriequal(spintri, firsttri));
+    tspivot(spintri, dissolvesubseg);
+    if ((farvertex != endpoint2) || (dissolvesubseg.ss == m->dummysub)) {
+      return TRI_ERROR_INPUT;
+    }
+    tsdissolve(spintri);
+    sym(spintri, opptri);
+    tsdissolve(opptri);
+    subsegdealloc(m, dissolvesubseg.ss);
+    /* The edge may not be Delaunay now that it's free to flip. */
+    livepush(ws, &spintri);
+    livefixup(ws, m, &ws->liveb);
+  } catch (struct trierror &error) {
+    ws->live = 0;
+    return error.status;
+  }
+  return TRI_OK;
+}
+
+/*****************************************************************************/
+/*                                                                           */
+/*  trilivewrite()   Write out the triangles of a live mesh that are inside  */
+/*                   its segments.                                           */
+/*                                                                           */
+/*  Inside is decided by the even-odd rule:  starting from the frame, every  */
+/*  segment crossed flips between outside and inside.  The triangles are     */
+/*  visited breadth-first, one region (a set of triangles connected without  */
+/*  crossing a segment) at a time, so each region is entered by the fewest   */
+/*  crossings possible.  A triangle's `infected' flag marks it as visited.   */
+/*                                                                           */
+/*  `out->pointlist' gets every vertex (but not the frame), with its id in   */
+/*  `out->pointmarkerlist'; `out->trianglelist' indexes into these.  The     */
+/*  arrays belong to the workspace, as with triangulatews().                 */
+/*                                                                           */
+/*  Unlike the edits, this is linear in the size of the mesh, but it is      */
+/*  only a walk over the triangles.                                          */
+/*                                                                           */
+/*****************************************************************************/
+
+#ifdef ANSI_DECLARATORS
+int trilivewrite(struct triangulateworkspace *ws, struct triangulateio *out)
+#else /* not ANSI_DECLARATORS */
+int trilivewrite(ws, out)
+struct triangulateworkspace *ws;
+struct triangulateio *out;
+#endif /* not ANSI_DECLARATORS */
+
+{
+  struct mesh *m;
+  struct otri triangleloop, neighbor;
+  struct osub checksubseg;
+  struct otri *visit;
+  triangle **cross;
+  vertex vertexloop;
+  vertex p1, p2, p3;
+  REAL *plist;
+  int *pmlist;
+  int *tlist;
+  int *index;
+  long visited, head, crossed;
+  long i;
+  int points, triangles;
+  int inside;
+  triangle ptr;                         /* Temporary variable used by sym(). */
+  subseg sptr;                      /* Temporary variable used by tspivot(). */
+
+  if (!ws->live) {
+    return TRI_ERROR_INPUT;
+  }
+  m = &ws->m;
+  try {
+    plist = (REAL *) spacereserve(ws, &ws->pointlist,
+                                  (int) (m->vertices.items * 2 *
+                                         (long) sizeof(REAL)));
+    pmlist = (int *) spacereserve(ws, &ws->pointmarkerlist,
+                                  (int) (m->vertices.items *
+                                         (long) sizeof(int)));
+    index = (int *) spacereserve(ws, &ws->liveindex,
+                                 ws->liveids * (int) sizeof(int));
+    tlist = (int *) spacereserve(ws, &ws->trianglelist,
+                                 (int) (m->triangles.items * 3 *
+                                        (long) sizeof(int)));
+    visit = (struct otri *) spacereserve(ws, &ws->livestack,
+                                         (int) (m->triangles.items *
+                                                (long) sizeof(struct otri)));
+    cross = (triangle **) spacereserve(ws, &ws->livecross,
+                                       (int) (m->triangles.items * 3 *
+                                              (long) sizeof(triangle *)));
+  } catch (struct trierror &error) {
+    return error.status;
+  }
+  /* The stack just went to the visit list. */
+  ws->livestacksize = 0;
+
+  points = 0;
+  traversalinit(&m->vertices);
+  vertexloop = vertextraverse(m);
+  while (vertexloop != (vertex) NULL) {
+    if (vertexmark(vertexloop) >= 0) {
+      index[vertexmark(vertexloop)] = points;
+      plist[points * 2] = vertexloop[0];
+      plist[points * 2 + 1] = vertexloop[1];
+      pmlist[points] = vertexmark(vertexloop);
+      points++;
     }
-  } else {
-#ifdef TRILIBRARY
-    writeelements(&m, &b, &out->trianglelist, &out->triangleattributelist);
-#else /* not TRILIBRARY */
-    writeelements(&m, &b, b.outelefilename, argc, argv);
-#endif /* not TRILIBRARY */
+    vertexloop = vertextraverse(m);
   }
-  /* The -c switch (convex switch) causes a PSLG to be written */
-  /*   even if none was read.                                  */
-  if (b.poly || b.convex) {
-    /* If not using iteration numbers, don't overwrite the .poly file. */
-    if (b.nopolywritten || b.noiterationnum) {
-      if (!b.quiet) {
-#ifdef TRILIBRARY
-        printf("NOT writing segments.\n");
-#else /* not TRILIBRARY */
-        printf("NOT writing a .poly file.\n");
-#endif /* not TRILIBRARY */
+
+  triangles = 0;
+  inside = 0;
+  visited = head = crossed = 0;
+  livefind(m, &ws->liveb, ws->liveframe, &triangleloop);
+  triangleloop.orient = 0;
+  infect(triangleloop);
+  visit[visited++] = triangleloop;
+  while (1) {
+    while (head < visited) {
+      triangleloop = visit[head++];
+      if (inside) {
+        org(triangleloop, p1);
+        dest(triangleloop, p2);
+        apex(triangleloop, p3);
+        if ((vertexmark(p1) >= 0) && (vertexmark(p2) >= 0) &&
+            (vertexmark(p3) >= 0)) {
+          tlist[triangles * 3] = index[vertexmark(p1)];
+          tlist[triangles * 3 + 1] = index[vertexmark(p2)];
+          tlist[triangles * 3 + 2] = index[vertexmark(p3)];
+          triangles++;
+        }
       }
-    } else {
-#ifdef TRILIBRARY
-      writepoly(&m, &b, &out->segmentlist, &out->segmentmarkerlist);
-      out->numberofholes = m.holes;
-      out->numberofregions = m.regions;
-      if (b.poly) {
-        out->holelist = in->holelist;
-        out->regionlist = in->regionlist;
-      } else {
-        out->holelist = (REAL *) NULL;
-        out->regionlist = (REAL *) NULL;
+      for (triangleloop.orient = 0; triangleloop.orient < 3;
+           triangleloop.orient++) {
+        sym(triangleloop, neighbor);
+        if ((neighbor.tri == m->dummytri) || infected(neighbor)) {
+          continue;
+        }
+        tspivot(triangleloop, checksubseg);
+        if (checksubseg.ss != m->dummysub) {
+          /* The other side is the next region, if nothing gets there */
+          /*   first.                                                 */
+          cross[crossed++] = neighbor.tri;
+        } else {
+          neighbor.orient = 0;
+          infect(neighbor);
+          visit[visited++] = neighbor;
+        }
       }
-#else /* not TRILIBRARY */
-      writepoly(&m, &b, b.outpolyfilename, holearray, m.holes, regionarray,
-                m.regions, argc, argv);
-#endif /* not TRILIBRARY */
     }
+    if (crossed == 0) {
+      break;
+    }
+    inside = !inside;
+    for (i = 0; i < crossed; i++) {
+      neighbor.tri = cross[i];
+      neighbor.orient = 0;
+      if (!infected(neighbor)) {
+        infect(neighbor);
+        visit[visited++] = neighbor;
+      }
+    }
+    crossed = 0;
   }
-#ifndef TRILIBRARY
-#ifndef CDT_ONLY
-  if (m.regions > 0) {
-    trifree((VOID *) regionarray);
-  }
-#endif /* not CDT_ONLY */
-  if (m.holes > 0) {
-    trifree((VOID *) holearray);
-  }
-  if (b.geomview) {
-    writeoff(&m, &b, b.offfilename, argc, argv);
-  }
-#endif /* not TRILIBRARY */
-  if (b.edgesout) {
-#ifdef TRILIBRARY
-    writeedges(&m, &b, &out->edgelist, &out->edgemarkerlist);
-#else /* not TRILIBRARY */
-    writeedges(&m, &b, b.edgefilename, argc, argv);
-#endif /* not TRILIBRARY */
-  }
-  if (b.voronoi) {
-#ifdef TRILIBRARY
-    writevoronoi(&m, &b, &vorout->pointlist, &vorout->pointattributelist,
-                 &vorout->pointmarkerlist, &vorout->edgelist,
-                 &vorout->edgemarkerlist, &vorout->normlist);
-#else /* not TRILIBRARY */
-    writevoronoi(&m, &b, b.vnodefilename, b.vedgefilename, argc, argv);
-#endif /* not TRILIBRARY */
-  }
-  if (b.neighbors) {
-#ifdef TRILIBRARY
-    writeneighbors(&m, &b, &out->neighborlist);
-#else /* not TRILIBRARY */
-    writeneighbors(&m, &b, b.neighborfilename, argc, argv);
-#endif /* not TRILIBRARY */
+  for (i = 0; i < visited; i++) {
+    uninfect(visit[i]);
   }
 
-  if (!b.quiet) {
-#ifndef NO_TIMER
-    gettimeofday(&tv6, &tz);
-    printf("\nOutput milliseconds:  %ld\n",
-           1000l * (tv6.tv_sec - tv5.tv_sec) +
-           (tv6.tv_usec - tv5.tv_usec) / 1000l);
-    printf("Total running milliseconds:  %ld\n",
-           1000l * (tv6.tv_sec - tv0.tv_sec) +
-           (tv6.tv_usec - tv0.tv_usec) / 1000l);
-#endif /* not NO_TIMER */
+  out->pointlist = plist;
+  out->pointmarkerlist = pmlist;
+  out->numberofpoints = points;
+  out->numberofpointattributes = 0;
+  out->trianglelist = tlist;
+  out->numberoftriangles = triangles;
+  out->numberofcorners = 3;
+  out->numberoftriangleattributes = 0;
+  return TRI_OK;
+}
 
-    statistics(&m, &b);
-  }
+/**                                                                         **/
+/**                                                                         **/
+/********* Live mesh routines end here                               *********/
 
-#ifndef REDUCED
-  if (b.docheck) {
-    checkmesh(&m, &b);
-    checkdelaunay(&m, &b);
-  }
-#endif /* not REDUCED */
+#endif /* not CDT_ONLY */
 
-  triangledeinit(&m, &b);
-#ifndef TRILIBRARY
-  return 0;
-#endif /* not TRILIBRARY */
-}
+#endif /* TRILIBRARY */
@@ -288,11 +288,351 @@ struct triangulateio {
   int numberofedges;                                             /* Out only */
 };
 
+/*****************************************************************************/
+/*                                                                           */
+/*  Reusing memory across calls                                              */
+/*                                                                           */
+/*  A program that triangulates many small inputs can avoid most of the      */
+/*  malloc() and free() traffic of triangulate() by keeping a workspace.     */
+/*  Create one with triworkspacenew() and pass it to triangulatews(), which  */
+/*  behaves exactly like triangulate() except that Triangle's internal       */
+/*  memory pools survive the call and are recycled by the next one.          */
+/*                                                                           */
+/*  With a workspace, the output arrays Triangle would normally allocate     */
+/*  (points, attributes, markers, triangles, neighbors, segments, edges)     */
+/*  are carved out of buffers owned by the workspace.  Do not free() or      */
+/*  trifree() them; they stay valid until the next call to triangulatews()   */
+/*  with the same workspace, or until triworkspacefree().  Voronoi output    */
+/*  is still allocated the usual way.                                        */
+/*                                                                           */
+/*  triworkspacebytes() reports how much memory the workspace holds.  A      */
+/*  workspace must not be used by two threads at the same time, but          */
+/*  several threads can triangulate at once, each with its own workspace     */
+/*  (or with triangulate()); Triangle keeps no per-call state in globals.    */
+/*                                                                           */
+/*****************************************************************************/
+
+struct triangulateworkspace;
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Allocators                                                               */
+/*                                                                           */
+/*  A workspace gets its memory from malloc() unless it is given an          */
+/*  allocator with triworkspaceallocator().  That frees what the workspace   */
+/*  holds, and from then on every pool block and every array of the mesh     */
+/*  and of the workspace comes from `allocate' and goes back to `release'    */
+/*  (which may be NULL).  Both are passed `data'.  `allocate' returns NULL   */
+/*  when it is out of memory.  Memory must be aligned as malloc()'s is.      */
+/*  An allocator with a NULL `allocate' means malloc() again.  Arrays that   */
+/*  are handed to the caller to free (Voronoi output) still use malloc().    */
+/*  If triangle.c is compiled with INDEX32, triangles, subsegments, and      */
+/*  vertices come from a range of addresses each mesh reserves for itself    */
+/*  instead, and are neither counted nor given to the allocator.             */
+/*                                                                           */
+/*  Triangle comes with one allocator, an arena:  a few big chunks of memory */
+/*  that are handed out from front to back and never given back one by one.  */
+/*  triarenanew() makes one; chunks are `chunkbytes' long (or longer, for    */
+/*  bigger requests).  triarenaallocator() fills in an allocator that uses   */
+/*  it.  triarenareset() takes everything back at once, in O(1), keeping     */
+/*  the chunks for what comes next.  Before that, tell every workspace that  */
+/*  uses the arena to let go of its memory without freeing it, with          */
+/*  triworkspaceforget().  triarenabytes() is the size of all the chunks,    */
+/*  and triarenafree() frees them.  An arena must not be used by two         */
+/*  threads at the same time.                                                */
+/*                                                                           */
+/*  The statistics (see below) count the allocations of each call.           */
+/*                                                                           */
+/*****************************************************************************/
+
+struct triallocator {
+  VOID *(*allocate)(VOID *data, int bytes);
+  void (*release)(VOID *data, VOID *memory);
+  VOID *data;
+};
+
+struct triarena;
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Live meshes                                                              */
+/*                                                                           */
+/*  A workspace can also hold a live mesh:  a constrained Delaunay           */
+/*  triangulation that is kept after the call and edited in place, for input */
+/*  that changes a little at a time (a contour that moves a few vertices per */
+/*  frame).  Each edit changes only the triangles near it.                   */
+/*                                                                           */
+/*  trilivebegin() triangulates the points and segments of `in' (only those  */
+/*  fields are read) inside a frame, the rectangle (xmin, ymin) - (xmax,     */
+/*  ymax).  Every vertex must lie strictly inside the frame, now and later.  */
+/*  The input points get the ids 0, 1, 2, ..., and vertices added where      */
+/*  input segments cross get the ids after those.  triliveinsert() hands out */
+/*  new ids, reusing those of deleted vertices.  trilivedelete() and         */
+/*  trilivemove() take the segments that end at the vertex with it.          */
+/*  trilivesegment() and triliveunsegment() add and remove a segment.        */
+/*                                                                           */
+/*  trilivewrite() writes out the triangles inside the segments, by the      */
+/*  even-odd rule, with the points (not the frame) and their ids in          */
+/*  `pointmarkerlist'.  Like triangulatews() output, the arrays belong to    */
+/*  the workspace.  Only the edits are local; writing is a walk over the     */
+/*  whole mesh.                                                              */
+/*                                                                           */
+/*  Each returns TRI_OK or an error code.  An edit that can't be done (a     */
+/*  vertex on top of another or on a segment, a point outside the frame, an  */
+/*  unknown id) returns TRI_ERROR_INPUT and changes nothing, except that a   */
+/*  failed trilivemove() leaves the vertex deleted.  A segment that crosses  */
+/*  another one, or running out of memory, ends the live mesh:  every call   */
+/*  fails until the next trilivebegin().  So does triangulatews() with the   */
+/*  same workspace.  triliveactive() says whether a workspace holds a live   */
+/*  mesh.  There is no quality refinement in a live mesh.                    */
+/*                                                                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Exact predicates                                                         */
+/*                                                                           */
+/*  Triangle's robust orientation and incircle tests, for points that are    */
+/*  not in a mesh.  triorient() is positive if pa, pb, pc are in             */
+/*  counterclockwise order, negative if clockwise, zero if collinear.        */
+/*  triincircle() is positive if pd is inside the circle through pa, pb, pc  */
+/*  (in counterclockwise order), negative if outside, zero if on it.  Each   */
+/*  point is an x, y pair.  The signs are always exact.                      */
+/*                                                                           */
+/*  triincircles() tests `count' points from `pointlist' (x, y pairs)        */
+/*  against one circle and writes a result per point into `results', the    */
+/*  same as triincircle() would.  The floating-point filter runs over blocks */
+/*  of points at a time, so it is faster than a call per point.              */
+/*                                                                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Errors                                                                   */
+/*                                                                           */
+/*  Compiled as a library, Triangle never ends the program.  triangulate()   */
+/*  and triangulatews() return TRI_OK, or one of the codes below if the      */
+/*  switches or the input were bad, memory ran out, or Triangle found a bug  */
+/*  in itself.  (The message is still printed, as before.)  After an error   */
+/*  the output arrays must not be used.  triangulate() frees its memory      */
+/*  before returning; a workspace keeps its memory and is ready for the      */
+/*  next call.                                                               */
+/*                                                                           */
+/*  Errors travel back to the caller as a C++ exception thrown by triexit(), */
+/*  so this relies on Triangle being compiled as C++, as it is here.         */
+/*                                                                           */
+/*****************************************************************************/
+
+#define TRI_OK              0                                   /* No error. */
+#define TRI_ERROR_INPUT     1            /* Bad switches, or unusable input. */
+#define TRI_ERROR_MEMORY    2                              /* Out of memory. */
+#define TRI_ERROR_INTERNAL  3                    /* internalerror():  a bug. */
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Budget of a call                                                         */
+/*                                                                           */
+/*  Quality refinement (the `q', `a' and `u' switches) can take a long       */
+/*  time, and for minimum angles above about 34 degrees it may never end.    */
+/*  The `S' switch limits the number of Steiner points.  A workspace can     */
+/*  also limit the number of triangles and the time a call may take, with    */
+/*  triworkspacebudget(); zero or less means no limit.  The time is          */
+/*  measured from the start of the call, but only refinement is stopped.     */
+/*  With a workspace, `S' is the Steiner points of that call only.           */
+/*                                                                           */
+/*  When the budget runs out, refinement stops where it is and the mesh so   */
+/*  far is written out as usual.  It is a valid constrained triangulation,   */
+/*  but some triangles may not meet the quality constraints.                 */
+/*  `outofbudget' in the statistics says when that happened.                 */
+/*                                                                           */
+/*  The workspace keeps the mesh and the queue of bad triangles, and         */
+/*  trirefine() goes on from where refinement stopped, under a new budget:   */
+/*  the one of the workspace, from the start of that call, and at most       */
+/*  `steinerpoints' more Steiner points (zero or less means no limit).  It   */
+/*  writes the whole mesh out again, into the same arrays, so a program can  */
+/*  show a coarse mesh at once and a better one every frame.  Any of the     */
+/*  budgets, `S' included, can stop a call this way.  Once the mesh meets    */
+/*  the constraints, trirefining() returns zero, and so does it after any    */
+/*  other call with the workspace.  The mesh can't be refined further if     */
+/*  the `n' or `v' switch or higher order elements (`o2') were used, as      */
+/*  their output writes over it.  A refined mesh need not be the one a call  */
+/*  with no budget would have made, but it meets the same constraints.       */
+/*  Writing the mesh out comes after the budget, and takes time in           */
+/*  proportion to the whole mesh, so a call to trirefine() takes at least    */
+/*  that long, whatever its budget; give it less time to make up for it.     */
+/*                                                                           */
+/*****************************************************************************/
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Statistics of a call                                                     */
+/*                                                                           */
+/*  After each call to triangulatews(), triworkspacestats() copies out what  */
+/*  that call did, without anything being printed.  Times are nanoseconds    */
+/*  on a monotonic clock, split into the same phases the `V' switch reports: */
+/*  reading the input, Delaunay triangulation (or mesh reconstruction with   */
+/*  `r'), inserting segments, carving holes, quality refinement, and writing */
+/*  the output.  The predicate counts are those `V' prints.  Steiner points  */
+/*  are vertices that were not in the input.  Pool bytes are the most memory */
+/*  each of Triangle's memory pools had in use during the call.              */
+/*  `allocations', `releases' and `allocatedbytes' count the memory the      */
+/*  call took from malloc() or the workspace's allocator, and gave back.     */
+/*                                                                           */
+/*****************************************************************************/
+
+struct triangulatestats {
+  long long inputnanoseconds;
+  long long delaunaynanoseconds;
+  long long segmentnanoseconds;
+  long long holenanoseconds;
+  long long qualitynanoseconds;
+  long long outputnanoseconds;
+  long long totalnanoseconds;
+
+  long incirclecount;
+  long counterclockcount;
+  long orient3dcount;
+  long hyperbolacount;
+  long circumcentercount;
+  long circletopcount;
+
+  long inputvertices;
+  long steinerpoints;
+  long triangles;
+  long subsegs;
+
+  unsigned long vertexpoolbytes;
+  unsigned long trianglepoolbytes;
+  unsigned long subsegpoolbytes;
+  unsigned long viripoolbytes;
+  unsigned long badsubsegpoolbytes;
+  unsigned long badtrianglepoolbytes;
+  unsigned long flipstackerpoolbytes;
+  unsigned long splaynodepoolbytes;
+
+  long allocations;
+  long releases;
+  unsigned long allocatedbytes;
+
+  int outofbudget;                  /* Refinement was stopped by the budget. */
+};
+
+/*****************************************************************************/
+/*                                                                           */
+/*  Parameters instead of switches                                           */
+/*                                                                           */
+/*  For the usual library calls, triangulatewith() takes a filled in         */
+/*  `triangulateparams' instead of a switch string, so no string is built or */
+/*  parsed.  It behaves like triangulatews() with the switches `zQ' plus the */
+/*  ones the fields ask for.  `ws' may be NULL, as with triangulatews().     */
+/*  triparamsinit() sets every field to its default:  a Delaunay             */
+/*  triangulation of the points, by divide-and-conquer, on one thread.       */
+/*                                                                           */
+/*  A constrained triangulation with a minimum angle, or with a maximum      */
+/*  area (or both), is refined by code compiled for just that case, without  */
+/*  the tests for the switches it does not use.  triangulatews() gets the    */
+/*  same code when its switches make the same case.                          */
+/*                                                                           */
+/*  `unsuitable' is the `u' switch with a test of the caller's own, instead  */
+/*  of the triunsuitable() compiled into Triangle:  it is given the three    */
+/*  corners of a triangle, its area and `unsuitabledata', and returns        */
+/*  nonzero if the triangle must be split.  This is how an area limit can    */
+/*  vary over the mesh, say from a sizing field sampled on a grid.  It is    */
+/*  asked about every triangle refinement makes that the other area limits   */
+/*  let through, so it should be quick.                                      */
+/*                                                                           */
+/*****************************************************************************/
+
+#define TRI_DIVCONQ      0                  /* Divide-and-conquer (default). */
+#define TRI_INCREMENTAL  1                             /* Incremental (`i'). */
+#define TRI_SWEEPLINE    2                               /* Sweepline (`F'). */
+
+struct triangulateparams {
+  int poly;                       /* `p':  triangulate the segments of `in'. */
+  int nopolywritten;                      /* `P':  don't write the segments. */
+  int neighbors;                               /* `n':  write the neighbors. */
+  int nobisect;               /* `Y' (1) or `YY' (2):  don't split segments. */
+  REAL minangle;                /* `q':  minimum angle in degrees; 0 = none. */
+  REAL maxarea;                    /* `a':  maximum triangle area; 0 = none. */
+  int steiner;                  /* `S':  most Steiner points; -1 = no limit. */
+  int algorithm;             /* TRI_DIVCONQ, TRI_INCREMENTAL, TRI_SWEEPLINE. */
+  int brio;                       /* `b':  BRIO order, with TRI_INCREMENTAL. */
+  int threads;                           /* `t':  threads; 0 = one per core. */
+  int (*unsuitable)(REAL *triorg, REAL *tridest, REAL *triapex, REAL area,
+                    VOID *data);                       /* `u':  NULL = none. */
+  VOID *unsuitabledata;                           /* Passed to `unsuitable'. */
+};
+
 #ifdef ANSI_DECLARATORS
-void triangulate(char *, struct triangulateio *, struct triangulateio *,
-                 struct triangulateio *);
+int triangulate(char *, struct triangulateio *, struct triangulateio *,
+                struct triangulateio *);
 void trifree(VOID *memptr);
+int triangulatews(char *, struct triangulateio *, struct triangulateio *,
+                  struct triangulateio *, struct triangulateworkspace *);
+void triparamsinit(struct triangulateparams *params);
+int triangulatewith(struct triangulateparams *, struct triangulateio *,
+                    struct triangulateio *, struct triangulateio *,
+                    struct triangulateworkspace *);
+struct triangulateworkspace *triworkspacenew(void);
+void triworkspacefree(struct triangulateworkspace *ws);
+unsigned long triworkspacebytes(struct triangulateworkspace *ws);
+void triworkspacestats(struct triangulateworkspace *ws,
+                       struct triangulatestats *stats);
+void triworkspacebudget(struct triangulateworkspace *ws, long maxtriangles,
+                        long long maxnanoseconds);
+void triworkspaceallocator(struct triangulateworkspace *ws,
+                           struct triallocator *allocator);
+void triworkspaceforget(struct triangulateworkspace *ws);
+struct triarena *triarenanew(int chunkbytes);
+void triarenaallocator(struct triarena *arena, struct triallocator *allocator);
+void triarenareset(struct triarena *arena);
+unsigned long triarenabytes(struct triarena *arena);
+void triarenafree(struct triarena *arena);
+int trilivebegin(struct triangulateworkspace *ws, struct triangulateio *in,
+                 REAL xmin, REAL ymin, REAL xmax, REAL ymax);
+int triliveinsert(struct triangulateworkspace *ws, REAL x, REAL y, int *id);
+int trilivedelete(struct triangulateworkspace *ws, int id);
+int trilivemove(struct triangulateworkspace *ws, int id, REAL x, REAL y);
+int trilivesegment(struct triangulateworkspace *ws, int id1, int id2);
+int triliveunsegment(struct triangulateworkspace *ws, int id1, int id2);
+int trilivewrite(struct triangulateworkspace *ws, struct triangulateio *out);
+int triliveactive(struct triangulateworkspace *ws);
+int trirefine(struct triangulateworkspace *ws, int steinerpoints,
+              struct triangulateio *out);
+int trirefining(struct triangulateworkspace *ws);
+REAL triorient(REAL *pa, REAL *pb, REAL *pc);
+REAL triincircle(REAL *pa, REAL *pb, REAL *pc, REAL *pd);
+void triincircles(REAL *pa, REAL *pb, REAL *pc, REAL *pointlist, int count,
+                  REAL *results);
 #else /* not ANSI_DECLARATORS */
-void triangulate();
+int triangulate();
 void trifree();
+int triangulatews();
+void triparamsinit();
+int triangulatewith();
+struct triangulateworkspace *triworkspacenew();
+void triworkspacefree();
+unsigned long triworkspacebytes();
+void triworkspacestats();
+void triworkspacebudget();
+void triworkspaceallocator();
+void triworkspaceforget();
+struct triarena *triarenanew();
+void triarenaallocator();
+void triarenareset();
+unsigned long triarenabytes();
+void triarenafree();
+int trilivebegin();
+int triliveinsert();
+int trilivedelete();
+int trilivemove();
+int trilivesegment();
+int triliveunsegment();
+int trilivewrite();
+int triliveactive();
+int trirefine();
+int trirefining();
+REAL triorient();
+REAL triincircle();
+void triincircles();
 #endif /* not ANSI_DECLARATORS */
@@ -1,189 +1,369 @@
 #include "ofxTriangleMesh.h"
-#include "triangle.h"
 
 
 
 
 
+ofxTriangleMesh::ofxTriangleMesh(){
+    nTriangles = 0;
+    outputMode = OFX_TRIANGLE_MESH_OUTPUT_FULL;
+    bTrianglesReady = true;
+}
 
+ofxTriangleMesh::ofxTriangleMesh(const ofxTriangleMesh & other){
+    *this = other;
+}
 
-void triangulatePoints(char * flags, triangulateio * in, triangulateio * mid, 
-                       triangulateio * out){
+ofxTriangleMesh & ofxTriangleMesh::operator=(const ofxTriangleMesh & other){
+    nTriangles = other.nTriangles;
+    outputPts = other.outputPts;
+    triangles = other.triangles;
+    triangulatedMesh = other.triangulatedMesh;
+    outputMode = other.outputMode;
+    core = other.core;
+    batch = other.batch;
+    live = other.live;
+    cache = other.cache;
+    sizing = other.sizing;
+    rings = other.rings;
+    batchRanges = other.batchRanges;
+    bTrianglesReady = other.bTrianglesReady;
+    if (core.getSizing() == &other.sizing) setSizing(&sizing);
+    return *this;
+}
 
-    // this funciton, which calls triangulage is because we have a function called triangulate, so the compiler get's a bit confused.
-    triangulate(flags, in,  mid, out);
+void ofxTriangleMesh::setMode(ofxTriangleMeshMode newMode){
+    core.setMode(newMode);
 }
 
+ofxTriangleMeshMode ofxTriangleMesh::getMode(){
+    return core.getMode();
+}
 
-ofxTriangleMesh::ofxTriangleMesh(){
-    nTriangles = 0;
+void ofxTriangleMesh::setBudget(int maxSteinerPoints, int maxTriangles, float maxMilliseconds){
+    core.setBudget(maxSteinerPoints, maxTriangles, maxMilliseconds);
+    batch.setBudget(maxSteinerPoints, maxTriangles, maxMilliseconds);
 }
 
+const ofxTriangleMeshStats & ofxTriangleMesh::refine(int maxSteinerPoints, float maxMilliseconds){
+    if (!core.isRefining()) return core.getStats();
+    core.refine(maxSteinerPoints, maxMilliseconds);
+    return updateOutput();
+}
 
-// see note in the h file for how to use the parameters here....
-void ofxTriangleMesh::triangulate(ofPolyline contour, float angleConstraint, float sizeConstraint){
-
-    int bSize = contour.size();
-   
-    struct triangulateio in, out;
-    in.numberofpoints = bSize;
-    in.numberofpointattributes = 0;
-    in.pointmarkerlist = NULL;
-    in.pointlist = (REAL *) malloc(bSize * 2 * sizeof(REAL));
-    in.numberofregions = 0;
-    in.regionlist =  NULL;
-    
-    for(int i = 0; i < bSize; i++) {
-		in.pointlist[i*2+0] = contour[i].x;
-        in.pointlist[i*2+1] = contour[i].y;
+bool ofxTriangleMesh::isRefining(){
+    return core.isRefining();
+}
+
+void ofxTriangleMesh::setVertexCacheOrder(bool bOrder, int cacheSize){
+    core.setVertexCacheOrder(bOrder, cacheSize);
+    batch.setVertexCacheOrder(bOrder, cacheSize);
+}
+
+void ofxTriangleMesh::setSizing(const ofFloatPixels & density, const ofRectangle & bounds, float minArea, float maxArea){
+    sizing.setupFromDensity(density.getData(), density.getWidth(), density.getHeight(), density.getNumChannels(),
+                            bounds.x, bounds.y, bounds.width, bounds.height, minArea, maxArea);
+    setSizing(&sizing);
+}
+
+void ofxTriangleMesh::setSizing(const ofxTriangleMeshSizing * sizing){
+    core.setSizing(sizing);
+    batch.setSizing(sizing);
+}
+
+void ofxTriangleMesh::clearSizing(){
+    setSizing(NULL);
+}
+
+void ofxTriangleMesh::setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method, float maxEdgeLength){
+    core.setSimplify(tolerance, method, maxEdgeLength);
+    batch.setSimplify(tolerance, method, maxEdgeLength);
+}
+
+void ofxTriangleMesh::setCacheSize(size_t maxBytes){
+    cache.setMaxBytes(maxBytes);
+}
+
+void ofxTriangleMesh::setOutputMode(ofxTriangleMeshOutput newOutputMode){
+    outputMode = newOutputMode;
+}
+
+ofxTriangleMeshOutput ofxTriangleMesh::getOutputMode(){
+    return outputMode;
+}
+
+const vector <meshTriangle> & ofxTriangleMesh::getTriangles(){
+    
+    if (bTrianglesReady) return triangles;
+    
+    // compact mode: make the per triangle copies (and debug colors) from the mesh, now that they are wanted
+    
+    const vector < ofPoint > & vertices = triangulatedMesh.getVertices();
+    const vector < ofIndexType > & indices = triangulatedMesh.getIndices();
+    
+    triangles.resize(indices.size() / 3);
+    for (int i = 0; i < triangles.size(); i++){
+        for (int j = 0; j < 3; j++){
+            triangles[i].index[j] = indices[i * 3 + j];
+            triangles[i].pts[j] = vertices[indices[i * 3 + j]];
+        }
+        triangles[i].randomColor = ofColor(ofRandom(0,255), ofRandom(0,255), ofRandom(0,255));
     }
-	
-    out.pointlist = (REAL *) NULL;            
-    out.pointattributelist = (REAL *) NULL;
-    out.pointmarkerlist = (int *) NULL; 
-    out.trianglelist = (int *) NULL;  
-    out.triangleattributelist = (REAL *) NULL;
-    out.neighborlist = (int *) NULL; 
-    out.segmentlist = (int *) NULL;
-    out.segmentmarkerlist = (int *) NULL;
-    out.edgelist = (int *) NULL;
-    out.edgemarkerlist = (int *) NULL; 
- 
     
-    bool bConstrainAngle = false;
-    bool bConstrainSize = false;
+    bTrianglesReady = true;
+    return triangles;
+}
+
+
+// see note in the h file for how to use the parameters here....
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulate(const ofPolyline & contour, float angleConstraint, float sizeConstraint){
+    return triangulate(ofxTriangleMeshPoints(contour.getVertices()), angleConstraint, sizeConstraint);
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulate(const ofxTriangleMeshPoints & contour, float angleConstraint, float sizeConstraint){
     
-    if (angleConstraint > 0) bConstrainAngle = true;
-    if (sizeConstraint > 0) bConstrainSize = true;
+    rings.clear();
+    rings.push_back(contour);
     
+    if (!findCached(-1, angleConstraint, sizeConstraint)){
+        core.triangulate(contour, angleConstraint, sizeConstraint);
+        storeCached();
+    }
+    return updateOutput();
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulate(const vector <ofPolyline> & outlines, const vector <ofPolyline> & holes, float angleConstraint, float sizeConstraint){
     
+    rings.clear();
+    for (int i = 0; i < outlines.size(); i++) rings.push_back(outlines[i].getVertices());
+    for (int i = 0; i < holes.size(); i++) rings.push_back(holes[i].getVertices());
     
-    string triangulateParams;
+    if (!findCached(outlines.size(), angleConstraint, sizeConstraint)){
+        core.triangulateRings(rings, outlines.size(), angleConstraint, sizeConstraint);
+        storeCached();
+    }
+    return updateOutput();
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulate(const vector <ofxTriangleMeshPoints> & outlines, const vector <ofxTriangleMeshPoints> & holes, float angleConstraint, float sizeConstraint){
     
-    triangulateParams += "z";   // start from zero
-    triangulateParams += "Y";   // Prohibits the insertion of Steiner points (extra points) on the mesh boundary.
-    triangulateParams += "Q";   // quiet!   change to V is you want alot of info
+    rings.clear();
+    rings.insert(rings.end(), outlines.begin(), outlines.end());
+    rings.insert(rings.end(), holes.begin(), holes.end());
     
-    if (bConstrainAngle == true){
-        triangulateParams += "q" + ofToString( angleConstraint );
+    if (!findCached(outlines.size(), angleConstraint, sizeConstraint)){
+        core.triangulateRings(rings, outlines.size(), angleConstraint, sizeConstraint);
+        storeCached();
     }
+    return updateOutput();
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulate(ofPath & path, float angleConstraint, float sizeConstraint){
     
-    if (bConstrainSize == true){
-        triangulateParams += "a" + ofToString( (int)sizeConstraint );
+    // we don't know which of the outlines of a path are holes, so look for an empty
+    // (even-odd) area inside every one of them.
+    
+    const vector < ofPolyline > & outlines = path.getOutline();
+    
+    rings.clear();
+    for (int i = 0; i < outlines.size(); i++) rings.push_back(outlines[i].getVertices());
+    
+    if (!findCached(0, angleConstraint, sizeConstraint)){
+        core.triangulateRings(rings, 0, angleConstraint, sizeConstraint);
+        storeCached();
     }
+    return updateOutput();
+}
+
+
+// the cache's key is the rings plus everything that changes what triangle makes of them.
+// a single contour (firstHole -1) depends on the mode, rings are always constrained.
+// on a hit, core's buffers get the cached mesh and the stats say so, with the time the lookup took.
+
+bool ofxTriangleMesh::findCached(int firstHole, float angleConstraint, float sizeConstraint){
+    
+    if (!cache.isEnabled()) return false;
+    
+    unsigned long long startTime = ofGetElapsedTimeMicros();
+    
+    double settings[] = {
+        (double) firstHole, (double) (firstHole < 0 ? core.getMode() : OFX_TRIANGLE_MESH_CONSTRAINED),
+        angleConstraint, sizeConstraint,
+        (double) core.maxSteinerPoints, (double) core.maxTriangles, core.maxMilliseconds,
+        (double) core.getAlgorithm(), (double) (core.getVertexCacheOrder() ? core.vertexCacheSize : 0),
+        (double) (core.getSizing() != NULL ? core.getSizing()->getVersion() : 0),
+        core.simplify.getTolerance(), (double) core.simplify.getMethod(), core.simplify.getMaxEdgeLength()
+    };
+    cache.setKey(rings, settings, sizeof(settings) / sizeof(settings[0]));
+    
+    if (!cache.find(core.points, core.indices, core.stats)) return false;
+    
+    core.stopRefining();
+    const ofxTriangleMeshStats made = core.stats;
+    core.stats = ofxTriangleMeshStats();
+    core.stats.contourPoints = made.contourPoints;
+    core.stats.inputPoints = made.inputPoints;
+    core.stats.steinerPoints = made.steinerPoints;
+    core.stats.triangles = made.triangles;
+    core.stats.acmrBefore = made.acmrBefore;
+    core.stats.acmrAfter = made.acmrAfter;
+    core.stats.bCached = true;
+    core.stats.totalNanos = core.stats.wrapperNanos = (ofGetElapsedTimeMicros() - startTime) * 1000;
+    return true;
+}
+
+
+// failed meshes aren't kept, and neither are the ones a time budget cut short (next time might get further)
+
+void ofxTriangleMesh::storeCached(){
     
+    if (!cache.isEnabled() || core.stats.error != OFX_TRIANGLE_MESH_OK) return;
+    if (core.stats.bOutOfBudget && core.maxMilliseconds > 0) return;
     
-    triangulatePoints((char *) triangulateParams.c_str(), &in, &out, NULL);
+    cache.store(core.points, core.indices, core.stats);
+}
 
+
+// only what changed since the last call is remeshed, the rest of the mesh is kept in live.
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulateLive(const ofPolyline & contour){
     
-    /*
-    printf("Initial triangulation:\n\n");
-    //report(&mid, 1, 1, 1, 1, 1, 0);
-        for (int i = 0; i < out.numberofpoints; i++) {
-            printf("Point %4d:", i);
-            for (int j = 0; j < 2; j++) {
-                printf("  %.6g", out.pointlist[i * 2 + j]);
-            }
-            printf("\n");
+    core.stats = live.update(ofxTriangleMeshPoints(contour.getVertices()));
+    core.stopRefining();
+    
+    // swapped, not copied: live writes its whole output again next time anyway
+    core.points.swap(live.points);
+    core.indices.swap(live.indices);
+    return updateOutput();
+}
 
-        }
-    */
+
+// every contour on its own, on the batch's threads, with the same mode as a single triangulate().
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulateBatch(const vector <ofPolyline> & contours, float angleConstraint, float sizeConstraint){
     
+    rings.clear();
+    for (int i = 0; i < contours.size(); i++) rings.push_back(contours[i].getVertices());
     
-    nTriangles = 0;
-    triangles.clear();
+    batch.setMode(core.getMode());
+    core.stats = batch.triangulate(rings, angleConstraint, sizeConstraint);
+    core.stopRefining();
     
+    // all of them into core's buffers, then into the mesh like any other result
+    batch.pack(core.points, core.indices, batchRanges);
+    return updateOutput();
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::triangulateBatch(const vector <ofPolyline> & contours, vector <ofMesh> & meshes, float angleConstraint, float sizeConstraint){
+    
+    rings.clear();
+    for (int i = 0; i < contours.size(); i++) rings.push_back(contours[i].getVertices());
     
-    std::map < int , ofPoint  > goodPts;
+    batch.setMode(core.getMode());
+    core.stats = batch.triangulate(rings, angleConstraint, sizeConstraint);
+    core.stopRefining();
     
-    for (int i = 0; i < out.numberoftriangles; i++) {
-        meshTriangle triangle;
+    unsigned long long startTime = ofGetElapsedTimeMicros();
+    
+    meshes.resize(contours.size());
+    for (int i = 0; i < meshes.size(); i++){
         
-        int whichPt;
+        const vector < float > & points = batch.getPoints(i);
+        const vector < unsigned int > & indices = batch.getIndices(i);
         
-        for (int j = 0; j < 3; j++){
-            whichPt = out.trianglelist[i * 3 + j];
-            triangle.pts[j] = ofPoint(  out.pointlist[ whichPt * 2 + 0],  out.pointlist[ whichPt * 2 + 1]);
-            triangle.index[j] = whichPt;
-            
-            
-            
+        meshes[i].clear();
+        meshes[i].setMode(OF_PRIMITIVE_TRIANGLES);
+        for (int j = 0; j < points.size(); j += 2){
+            meshes[i].addVertex(ofPoint(points[j], points[j + 1]));
         }
-        
-        ofPoint tr[3];
-        tr[0] = triangle.pts[0];
-        tr[1] = triangle.pts[1];
-        tr[2] = triangle.pts[2];
-		
-        
-        // here we check if a triangle is "inside" a contour to drop non inner triangles
-        
-        if( isPointInsidePolygon(&contour[0], contour.size(), getTriangleCenter(tr) ) ) {
-            triangle.randomColor = ofColor(ofRandom(0,255), ofRandom(0,255), ofRandom(0,255));
-            triangles.push_back(triangle);
-            
-            // store the good points in a map
-            for (int j = 0; j < 3; j++){
-                goodPts[triangle.index[j]] = triangle.pts[j]; 
-            }
-            nTriangles++;
+        for (int j = 0; j < indices.size(); j++){
+            meshes[i].addIndex(indices[j]);
         }
     }
     
-    // put all good points in a vector and handle the remapping of indices.
-    // the indices stored above were for all points, but since we drop triangles, we 
-    // can drop non used points, and then remap all the indces. 
-    // that happens here: 
+    long long outputNanos = (ofGetElapsedTimeMicros() - startTime) * 1000;
+    core.stats.wrapperNanos += outputNanos;
+    core.stats.totalNanos += outputNanos;
+    return core.stats;
+}
+
+
+const vector <ofxTriangleMeshRange> & ofxTriangleMesh::getBatchRanges(){
+    return batchRanges;
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMesh::getStats(){
+    return core.getStats();
+}
+
+
+// turns core's flat buffers into triangulatedMesh, and in full output mode outputPts and triangles too.
+// (the time that takes is counted in the stats as wrapper time)
+
+const ofxTriangleMeshStats & ofxTriangleMesh::updateOutput(){
     
-    outputPts.clear();
-    std::map < int, int > indexChanges;
-    std::map< int , ofPoint >::iterator iter;
-    for (iter = goodPts.begin(); iter != goodPts.end(); ++iter) {
-        //cout << iter->first << " " << iter->second << endl;
-        indexChanges[iter->first] = outputPts.size();
-        outputPts.push_back(iter->second);
+    unsigned long long startTime = ofGetElapsedTimeMicros();
+    
+    if (core.stats.error != OFX_TRIANGLE_MESH_OK){
+        ofLogError("ofxTriangleMesh") << "triangle couldn't mesh the input (error " << core.stats.error << ")";
     }
     
-    // now, with the new, potentially smaller group of points, update all the indices of the triangles so their indices point right: 
+    triangles.clear();
+    outputPts.clear();
+    triangulatedMesh.clear();
+    
+    nTriangles = core.getNumTriangles();
     
-    for (int i = 0; i < triangles.size(); i++){
-        for (int j = 0; j < 3; j++){
-            triangles[i].index[j] = indexChanges[triangles[i].index[j]];
-        }
-    }
+    bool bFull = (outputMode == OFX_TRIANGLE_MESH_OUTPUT_FULL);
     
     // now make a mesh, using indices: 
     
-    triangulatedMesh.clear();
     triangulatedMesh.setMode(OF_PRIMITIVE_TRIANGLES);
-    for (int i = 0; i < outputPts.size(); i++){
-        triangulatedMesh.addVertex(outputPts[i]);
+    for (int i = 0; i < core.points.size(); i += 2){
+        triangulatedMesh.addVertex(ofPoint(core.points[i], core.points[i + 1]));
     }
     
-    for (int i = 0; i < triangles.size(); i++){
-        triangulatedMesh.addIndex(triangles[i].index[0]);;
-        triangulatedMesh.addIndex(triangles[i].index[1]);;
-        triangulatedMesh.addIndex(triangles[i].index[2]);;
+    for (int i = 0; i < core.indices.size(); i++){
+        triangulatedMesh.addIndex(core.indices[i]);
+    }
+    
+    if (bFull){
+        
+        const vector < ofPoint > & vertices = triangulatedMesh.getVertices();
+        outputPts.assign(vertices.begin(), vertices.end());
+        
+        for (int i = 0; i < nTriangles; i++){
+            meshTriangle triangle;
+            for (int j = 0; j < 3; j++){
+                triangle.index[j] = core.indices[i * 3 + j];
+                triangle.pts[j] = outputPts[triangle.index[j]];
+            }
+            triangle.randomColor = ofColor(ofRandom(0,255), ofRandom(0,255), ofRandom(0,255));
+            triangles.push_back(triangle);
+        }
     }
-
-    // depending on flags, we may need to adjust some of the memory clearing
-    // (see tricall.c for full listings)
-    // TODO: this should be agressively tested. 
     
-    free(in.pointlist);
-    free(out.pointlist);
-    if (out.pointattributelist != NULL) free(out.pointattributelist);
-    if (out.pointmarkerlist != NULL) free(out.pointmarkerlist);
-    free(out.trianglelist);
-    if (out.triangleattributelist != NULL) free(out.triangleattributelist);
+    // in compact mode triangles stays empty until someone asks for it, see getTriangles()
+    bTrianglesReady = bFull;
     
-    return;
-
+    long long outputNanos = (ofGetElapsedTimeMicros() - startTime) * 1000;
+    core.stats.wrapperNanos += outputNanos;
+    core.stats.totalNanos += outputNanos;
+    return core.stats;
 }
 
 void ofxTriangleMesh::clear(){
+    core.clear();
     triangles.clear();
+    batchRanges.clear();
     nTriangles = 0;
+    bTrianglesReady = true;
 }
 
 ofPoint ofxTriangleMesh::getTriangleCenter(ofPoint *tr){
@@ -194,45 +374,24 @@ ofPoint ofxTriangleMesh::getTriangleCenter(ofPoint *tr){
 
 bool ofxTriangleMesh::isPointInsidePolygon(ofPoint *polygon,int N, ofPoint p)
 {
-    int counter = 0;
-    int i;
-    double xinters;
-    ofPoint p1,p2;
-
-    p1 = polygon[0];
-
-    for (i=1;i<=N;i++)
-    {
-        p2 = polygon[i % N];
-        if (p.y > MIN(p1.y,p2.y)) {
-            if (p.y <= MAX(p1.y,p2.y)) {
-                if (p.x <= MAX(p1.x,p2.x)) {
-                    if (p1.y != p2.y) {
-                        xinters = (p.y-p1.y)*(p2.x-p1.x)/(p2.y-p1.y)+p1.x;
-                        if (p1.x == p2.x || p.x <= xinters){
-                            counter++;
-						}
-                    }
-                }
-            }
-        }
-        p1 = p2;
-    }
-	return counter % 2 != 0;
+    return ofxTriangleMeshCore::isPointInsidePolygon(ofxTriangleMeshPoints(&polygon[0].x, N, sizeof(ofPoint)), p.x, p.y);
 }
 
 
 void ofxTriangleMesh::draw() {
 
     // draw the triangles in their random colors: 
+    // (in compact mode, this is where the colors get made)
+    
+    const vector <meshTriangle> & triangles = getTriangles();
     
     for (int i=0; i<nTriangles; i++){
     
         ofFill();
         ofSetColor( triangles[i].randomColor);
-        ofTriangle( outputPts[triangles[i].index[0]], 
-        outputPts[triangles[i].index[1]],
-                   outputPts[triangles[i].index[2]]);
+        ofTriangle( triangles[i].pts[0], 
+        triangles[i].pts[1],
+                   triangles[i].pts[2]);
         
     }
     
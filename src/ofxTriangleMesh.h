@@ -24,8 +24,10 @@
 
 
 #include "ofMain.h"
-
-
+#include "ofxTriangleMeshCore.h"
+#include "ofxTriangleMeshBatch.h"
+#include "ofxTriangleMeshLive.h"
+#include "ofxTriangleMeshCache.h"
 
 
 typedef struct{
@@ -37,6 +39,21 @@ typedef struct{
 } meshTriangle;
 
 
+// what a triangulation fills in:
+//
+// OFX_TRIANGLE_MESH_OUTPUT_FULL    : triangulatedMesh, outputPts, and triangles (a copy of the three points of every
+//                                    triangle, plus a random color for drawing).  the original behavior.
+//
+// OFX_TRIANGLE_MESH_OUTPUT_COMPACT : only triangulatedMesh (vertices + indices), which is all the mesh really is.
+//                                    outputPts stays empty, and triangles is only made (colors and all) when
+//                                    getTriangles() or draw() is called.  less than half the memory, and no ofRandom.
+
+enum ofxTriangleMeshOutput {
+    OFX_TRIANGLE_MESH_OUTPUT_FULL,
+    OFX_TRIANGLE_MESH_OUTPUT_COMPACT
+};
+
+
 
 
 
@@ -48,6 +65,10 @@ class ofxTriangleMesh {
     
         ofxTriangleMesh();
         
+        // a copy that used the original's sizing (from setSizing() with a density map) uses its own copy of it
+        ofxTriangleMesh(const ofxTriangleMesh & other);
+        ofxTriangleMesh & operator=(const ofxTriangleMesh & other);
+        
     
         // usage notes: 
     
@@ -60,11 +81,87 @@ class ofxTriangleMesh {
         // for size, this depends on the size of your shape, 
         // 100 to 200 is a good first guess for screen resolution based points
     
-        void triangulate(ofPolyline contour, float angleConstraint = -1, float sizeConstraint = -1);
+        // every call hands back the timings / counters of that call, see ofxTriangleMeshStats in ofxTriangleMeshCore.h
+        // (getStats() has them too, until the next call)
+    
+        const ofxTriangleMeshStats & triangulate(const ofPolyline & contour, float angleConstraint = -1, float sizeConstraint = -1);
+    
+        // same thing, reading the points straight from your own memory (see ofxTriangleMeshPoints in ofxTriangleMeshCore.h)
+        const ofxTriangleMeshStats & triangulate(const ofxTriangleMeshPoints & contour, float angleConstraint = -1, float sizeConstraint = -1);
 
+        // several contours (and holes) in one go, always constrained, whatever the mode is.
+        // the outlines and the holes all become segments, and triangle carves the holes out.
+        // for a path, every outline is checked for an empty (even-odd) area, so holes are found automatically.
+    
+        const ofxTriangleMeshStats & triangulate(const vector <ofPolyline> & outlines, const vector <ofPolyline> & holes, float angleConstraint = -1, float sizeConstraint = -1);
+        const ofxTriangleMeshStats & triangulate(const vector <ofxTriangleMeshPoints> & outlines, const vector <ofxTriangleMeshPoints> & holes, float angleConstraint = -1, float sizeConstraint = -1);
+        const ofxTriangleMeshStats & triangulate(ofPath & path, float angleConstraint = -1, float sizeConstraint = -1);
+    
+        // lots of independent contours (every tracked blob, say), spread over all cores, see ofxTriangleMeshBatch.h.
+        // the first one packs all of them into this mesh (triangulatedMesh, triangles, ...), and getBatchRanges()
+        // says which vertices / indices belong to which contour.  the second one makes a mesh per contour.
+        // both keep the input order, and hand back the stats of the whole batch.
+    
+        const ofxTriangleMeshStats & triangulateBatch(const vector <ofPolyline> & contours, float angleConstraint = -1, float sizeConstraint = -1);
+        const ofxTriangleMeshStats & triangulateBatch(const vector <ofPolyline> & contours, vector <ofMesh> & meshes, float angleConstraint = -1, float sizeConstraint = -1);
+        const vector <ofxTriangleMeshRange> & getBatchRanges();
+    
+        // a contour that only changes a little from frame to frame (a tracked blob, a shape being drawn):
+        // the mesh is kept alive in live, and only the points that changed since the last call are remeshed.
+        // always constrained, without angle / size constraints, see ofxTriangleMeshLive.h.
+    
+        const ofxTriangleMeshStats & triangulateLive(const ofPolyline & contour);
+    
+        const ofxTriangleMeshStats & getStats();
+    
+        void setMode(ofxTriangleMeshMode mode);
+        ofxTriangleMeshMode getMode();
+    
+        // a hard limit on the work of the angle / size constraints, -1 = no limit.  see ofxTriangleMeshCore.h
+        // (if triangle can't mesh the input at all, the mesh is empty, stats.error says why, and it's logged)
+        void setBudget(int maxSteinerPoints, int maxTriangles = -1, float maxMilliseconds = -1);
+    
+        // a triangulate() the budget cut short can go on where it stopped, a bit more every call (say, every frame),
+        // with the mesh updated every time, until isRefining() is false.  see ofxTriangleMeshCore.h.
+        // cached, batch and live meshes can't, they don't keep triangle's mesh around.
+        const ofxTriangleMeshStats & refine(int maxSteinerPoints = -1, float maxMilliseconds = -1);
+        bool isRefining();
+    
+        // triangles in an order that's kind to the gpu's vertex cache, and the vertices in the order they're used.
+        // stats.acmrBefore / acmrAfter say how much it helped (vertices transformed per triangle).
+        // batches too, live meshes keep their own order.  see ofxTriangleMeshOrder.h
+        void setVertexCacheOrder(bool bOrder, int cacheSize = 32);
+    
+        // small triangles where density is high, big ones where it's low: a density map (say a grayscale image,
+        // 0..1, its first channel) stretched over bounds gives every spot a maximum area between minArea (at 1)
+        // and maxArea (at 0), as well as sizeConstraint.  kept in sizing, which you can also set up from a grid
+        // of areas yourself (then call setSizing(&sizing) again).  batches too, live meshes don't.  see ofxTriangleMeshSizing.h
+        void setSizing(const ofFloatPixels & density, const ofRectangle & bounds, float minArea, float maxArea);
+        void setSizing(const ofxTriangleMeshSizing * sizing);
+        void clearSizing();
+    
+        // fewer points on the contours before they're triangulated: douglas peucker or visvalingam, tolerance is
+        // how far the contour may move (0 = off).  maxEdgeLength splits long straight edges again, so the spacing
+        // follows the curvature.  stats.contourPoints / inputPoints say how many went in and how many are left.
+        // batches too, live meshes don't.  see ofxTriangleMeshSimplify.h
+        void setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER, float maxEdgeLength = -1);
+    
+        // keep the meshes of recent inputs, so a shape that comes back (a glyph, a mask) isn't triangulated again.
+        // maxBytes caps the memory, the least recently used meshes go first.  0 (the default) turns it off.
+        // hits, misses and evictions are counted in cache, see ofxTriangleMeshCache.h.  batches and live meshes skip it.
+        void setCacheSize(size_t maxBytes);
+    
+        void setOutputMode(ofxTriangleMeshOutput outputMode);
+        ofxTriangleMeshOutput getOutputMode();
+    
+        // the triangles with their points and colors, made on demand in compact mode
+        const vector <meshTriangle> & getTriangles();
     
         
         ofPoint getTriangleCenter(ofPoint *tr);
+    
+        // walks every edge of the polygon.  to test lots of points against the same polygon (particles against a blob),
+        // set up an ofxTriangleMeshPolygon once, see ofxTriangleMeshPolygon.h
         bool isPointInsidePolygon(ofPoint *polygon,int N, ofPoint p);
 
         void draw();
@@ -75,6 +172,35 @@ class ofxTriangleMesh {
         vector <meshTriangle> triangles;
         ofMesh triangulatedMesh;
     
+        ofxTriangleMeshOutput outputMode;
+    
+        // the openFrameworks-free part that does the actual work (mode, workspace, flat output buffers).
+        // core.workspace.getMemoryUsage() tells you how big triangle's memory got.
+        ofxTriangleMeshCore core;
+    
+        // the threads (and a core per thread) for triangulateBatch, started the first time it's used.
+        // batch.setNumThreads() picks how many.
+        ofxTriangleMeshBatch batch;
+    
+        // the mesh kept between triangulateLive() calls.  its points / indices are swapped into core's
+        // after every call, so read the result from here (or core), not from live.
+        ofxTriangleMeshLive live;
+    
+        ofxTriangleMeshCache cache;
+    
+        ofxTriangleMeshSizing sizing;
+    
+    protected:
+    
+        const ofxTriangleMeshStats & updateOutput();    // core's buffers -> triangulatedMesh (and outputPts / triangles)
+        bool findCached(int firstHole, float angleConstraint, float sizeConstraint);   // rings -> core's buffers, if cached
+        void storeCached();
+    
+        vector < ofxTriangleMeshPoints > rings;     // views of the polylines of the current call, kept so it isn't reallocated every time
+        vector < ofxTriangleMeshRange > batchRanges;    // where every contour of the last packed batch is
+        
+        bool bTrianglesReady;                       // false = compact output, triangles hasn't been made from the mesh yet
+
       
     
 
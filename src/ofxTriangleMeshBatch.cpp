@@ -0,0 +1,333 @@
+#include "ofxTriangleMeshBatch.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+
+
+static long long nanoTime(){
+    return chrono::duration_cast < chrono::nanoseconds > (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ofxTriangleMeshBatch::ofxTriangleMeshBatch(int numThreads){
+    mode = OFX_TRIANGLE_MESH_FILTER_CENTROIDS;
+    maxSteinerPoints = maxTriangles = -1;
+    maxMilliseconds = -1;
+    bVertexCacheOrder = false;
+    vertexCacheSize = 32;
+    sizing = NULL;
+    simplifyTolerance = 0;
+    simplifyMethod = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER;
+    simplifyMaxEdgeLength = -1;
+    this->numThreads = max(numThreads, 0);
+    generation = 0;
+    busy = 0;
+    bQuit = false;
+    contours = NULL;
+    angleConstraint = sizeConstraint = -1;
+    numShapes = 0;
+}
+
+ofxTriangleMeshBatch::~ofxTriangleMeshBatch(){
+    stop();
+}
+
+ofxTriangleMeshBatch::ofxTriangleMeshBatch(const ofxTriangleMeshBatch & other){
+    mode = other.mode;
+    maxSteinerPoints = other.maxSteinerPoints;
+    maxTriangles = other.maxTriangles;
+    maxMilliseconds = other.maxMilliseconds;
+    bVertexCacheOrder = other.bVertexCacheOrder;
+    vertexCacheSize = other.vertexCacheSize;
+    sizing = other.sizing;
+    simplifyTolerance = other.simplifyTolerance;
+    simplifyMethod = other.simplifyMethod;
+    simplifyMaxEdgeLength = other.simplifyMaxEdgeLength;
+    numThreads = other.numThreads;
+    generation = 0;
+    busy = 0;
+    bQuit = false;
+    contours = NULL;
+    angleConstraint = sizeConstraint = -1;
+    numShapes = 0;
+}
+
+ofxTriangleMeshBatch & ofxTriangleMeshBatch::operator=(const ofxTriangleMeshBatch & other){
+    // keep our own threads and memory, only the settings come over
+    mode = other.mode;
+    maxSteinerPoints = other.maxSteinerPoints;
+    maxTriangles = other.maxTriangles;
+    maxMilliseconds = other.maxMilliseconds;
+    bVertexCacheOrder = other.bVertexCacheOrder;
+    vertexCacheSize = other.vertexCacheSize;
+    sizing = other.sizing;
+    simplifyTolerance = other.simplifyTolerance;
+    simplifyMethod = other.simplifyMethod;
+    simplifyMaxEdgeLength = other.simplifyMaxEdgeLength;
+    if (other.numThreads != numThreads) setNumThreads(other.numThreads);
+    return *this;
+}
+
+void ofxTriangleMeshBatch::setMode(ofxTriangleMeshMode newMode){
+    mode = newMode;
+}
+
+ofxTriangleMeshMode ofxTriangleMeshBatch::getMode(){
+    return mode;
+}
+
+void ofxTriangleMeshBatch::setBudget(int maxSteinerPoints, int maxTriangles, float maxMilliseconds){
+    this->maxSteinerPoints = maxSteinerPoints;
+    this->maxTriangles = maxTriangles;
+    this->maxMilliseconds = maxMilliseconds;
+}
+
+void ofxTriangleMeshBatch::setVertexCacheOrder(bool bOrder, int cacheSize){
+    bVertexCacheOrder = bOrder;
+    vertexCacheSize = cacheSize;
+}
+
+void ofxTriangleMeshBatch::setSizing(const ofxTriangleMeshSizing * sizing){
+    this->sizing = sizing;
+}
+
+void ofxTriangleMeshBatch::setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method, float maxEdgeLength){
+    simplifyTolerance = tolerance;
+    simplifyMethod = method;
+    simplifyMaxEdgeLength = maxEdgeLength;
+}
+
+void ofxTriangleMeshBatch::setNumThreads(int newNumThreads){
+    stop();
+    numThreads = max(newNumThreads, 0);
+}
+
+int ofxTriangleMeshBatch::getNumThreads() const {
+    int n = numThreads;
+    if (n == 0) n = thread::hardware_concurrency();
+    return max(n, 1);
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMeshBatch::triangulate(const vector < ofxTriangleMeshPoints > & contours, float angleConstraint, float sizeConstraint){
+
+    long long startTime = nanoTime();
+
+    numShapes = contours.size();
+    if (results.size() < numShapes) results.resize(numShapes);
+
+    if (workers.empty()) start();
+
+    this->contours = &contours;
+    this->angleConstraint = angleConstraint;
+    this->sizeConstraint = sizeConstraint;
+
+    // even chunks, in order.  the threads are all waiting, so nobody looks at these while we set them up.
+    int nWorkers = workers.size();
+    for (int i = 0; i < nWorkers; i++){
+        workers[i]->core.setMode(mode);
+        workers[i]->core.setBudget(maxSteinerPoints, maxTriangles, maxMilliseconds);
+        workers[i]->core.setVertexCacheOrder(bVertexCacheOrder, vertexCacheSize);
+        workers[i]->core.setSizing(sizing);
+        workers[i]->core.setSimplify(simplifyTolerance, simplifyMethod, simplifyMaxEdgeLength);
+        workers[i]->begin = (int) ((long long) numShapes * i / nWorkers);
+        workers[i]->end = (int) ((long long) numShapes * (i + 1) / nWorkers);
+    }
+
+    // one shape (or one thread) isn't worth waking anybody up for
+    bool bWakeUp = (numShapes > 1 && !threads.empty());
+
+    if (bWakeUp){
+        {
+            lock_guard < mutex > guard(lock);
+            generation++;
+            busy = threads.size();
+        }
+        wakeUp.notify_all();
+    } else {
+        // everything is ours: work(0) steals from the others when its own range runs out, so theirs have to be empty
+        for (int i = 1; i < nWorkers; i++) workers[i]->begin = workers[i]->end = 0;
+        workers[0]->begin = 0;
+        workers[0]->end = numShapes;
+    }
+
+    work(0);
+
+    if (bWakeUp){
+        unique_lock < mutex > guard(lock);
+        allDone.wait(guard, [this]{ return busy == 0; });
+    }
+
+    this->contours = NULL;
+
+    // add the shapes up
+    stats = ofxTriangleMeshStats();
+    for (int i = 0; i < numShapes; i++){
+        const ofxTriangleMeshStats & st = results[i].stats;
+        stats.inputNanos += st.inputNanos;
+        stats.delaunayNanos += st.delaunayNanos;
+        stats.segmentNanos += st.segmentNanos;
+        stats.holeNanos += st.holeNanos;
+        stats.qualityNanos += st.qualityNanos;
+        stats.outputNanos += st.outputNanos;
+        stats.wrapperNanos += st.wrapperNanos;
+        stats.incircleTests += st.incircleTests;
+        stats.orientationTests += st.orientationTests;
+        stats.hyperbolaTests += st.hyperbolaTests;
+        stats.circumcenters += st.circumcenters;
+        stats.circleTops += st.circleTops;
+        stats.contourPoints += st.contourPoints;
+        stats.inputPoints += st.inputPoints;
+        stats.steinerPoints += st.steinerPoints;
+        stats.triangles += st.triangles;
+        stats.acmrBefore += st.acmrBefore * st.triangles;
+        stats.acmrAfter += st.acmrAfter * st.triangles;
+        stats.vertexPoolBytes = max(stats.vertexPoolBytes, st.vertexPoolBytes);
+        stats.trianglePoolBytes = max(stats.trianglePoolBytes, st.trianglePoolBytes);
+        stats.subsegPoolBytes = max(stats.subsegPoolBytes, st.subsegPoolBytes);
+        stats.viriPoolBytes = max(stats.viriPoolBytes, st.viriPoolBytes);
+        stats.badSubsegPoolBytes = max(stats.badSubsegPoolBytes, st.badSubsegPoolBytes);
+        stats.badTrianglePoolBytes = max(stats.badTrianglePoolBytes, st.badTrianglePoolBytes);
+        stats.flipStackerPoolBytes = max(stats.flipStackerPoolBytes, st.flipStackerPoolBytes);
+        stats.splayNodePoolBytes = max(stats.splayNodePoolBytes, st.splayNodePoolBytes);
+        stats.allocations += st.allocations;
+        stats.allocatedBytes += st.allocatedBytes;
+        if (stats.error == OFX_TRIANGLE_MESH_OK) stats.error = st.error;
+        stats.bOutOfBudget = stats.bOutOfBudget || st.bOutOfBudget;
+    }
+    if (stats.triangles > 0){
+        stats.acmrBefore /= stats.triangles;
+        stats.acmrAfter /= stats.triangles;
+    }
+    stats.totalNanos = nanoTime() - startTime;
+
+    return stats;
+}
+
+
+void ofxTriangleMeshBatch::pack(vector < float > & points, vector < unsigned int > & indices, vector < ofxTriangleMeshRange > & ranges) const {
+
+    points.clear();
+    indices.clear();
+    ranges.resize(numShapes);
+
+    for (int i = 0; i < numShapes; i++){
+
+        const result & r = results[i];
+        ofxTriangleMeshRange & range = ranges[i];
+
+        range.firstPoint = points.size() / 2;
+        range.numPoints = r.points.size() / 2;
+        range.firstIndex = indices.size();
+        range.numIndices = r.indices.size();
+
+        points.insert(points.end(), r.points.begin(), r.points.end());
+        for (int j = 0; j < r.indices.size(); j++){
+            indices.push_back(r.indices[j] + range.firstPoint);
+        }
+    }
+}
+
+
+void ofxTriangleMeshBatch::release(){
+    stop();
+    vector < result >().swap(results);
+    numShapes = 0;
+}
+
+
+void ofxTriangleMeshBatch::start(){
+
+    int n = getNumThreads();
+
+    for (int i = 0; i < n; i++){
+        workers.push_back(new worker());
+        workers.back()->begin = workers.back()->end = 0;
+    }
+
+    // the threads start out waiting for the batch after this one
+    for (int i = 1; i < n; i++){
+        threads.push_back(thread(&ofxTriangleMeshBatch::threadMain, this, i, generation));
+    }
+}
+
+void ofxTriangleMeshBatch::stop(){
+
+    {
+        lock_guard < mutex > guard(lock);
+        bQuit = true;
+    }
+    wakeUp.notify_all();
+
+    for (int i = 0; i < threads.size(); i++) threads[i].join();
+    threads.clear();
+
+    for (int i = 0; i < workers.size(); i++) delete workers[i];
+    workers.clear();
+
+    bQuit = false;
+}
+
+void ofxTriangleMeshBatch::threadMain(int which, unsigned int seen){
+
+    while (true){
+
+        {
+            unique_lock < mutex > guard(lock);
+            wakeUp.wait(guard, [&]{ return bQuit || generation != seen; });
+            if (bQuit) return;
+            seen = generation;
+        }
+
+        work(which);
+
+        {
+            lock_guard < mutex > guard(lock);
+            if (--busy == 0) allDone.notify_one();
+        }
+    }
+}
+
+void ofxTriangleMeshBatch::work(int which){
+    int task;
+    while (takeTask(which, task)) runTask(which, task);
+}
+
+
+// our own chunk first (from the end), then the front of everybody else's, starting with the next worker.
+
+bool ofxTriangleMeshBatch::takeTask(int which, int & task){
+
+    int nWorkers = workers.size();
+
+    for (int i = 0; i < nWorkers; i++){
+
+        worker & w = *workers[(which + i) % nWorkers];
+        lock_guard < mutex > guard(w.lock);
+
+        if (w.begin < w.end){
+            task = (i == 0) ? --w.end : w.begin++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// the result buffers are swapped with the core's, not copied: the core gets the (old) result's
+// memory to fill next time, so nothing is allocated once every slot has grown big enough.
+
+void ofxTriangleMeshBatch::runTask(int which, int task){
+
+    ofxTriangleMeshCore & core = workers[which]->core;
+    result & r = results[task];
+
+    core.triangulate((*contours)[task], angleConstraint, sizeConstraint);
+
+    r.points.swap(core.points);
+    r.indices.swap(core.indices);
+    r.stats = core.getStats();
+}
@@ -0,0 +1,143 @@
+/*!
+
+ ofxTriangleMeshBatch
+
+ triangulates a lot of independent contours at once (say, every tracked blob of a frame),
+ spread over a small pool of threads.  every worker has its own ofxTriangleMeshCore (so its own workspace),
+ and the threads stay alive between calls, so a batch every frame doesn't start threads or allocate once it's warm.
+
+ the contours are handed out in even chunks, one per worker.  a worker that runs out steals from
+ the front of someone else's chunk, so one big contour doesn't leave the other cores idle.
+
+ the results come back in input order, either one shape at a time (getPoints(i) / getIndices(i))
+ or packed into one vertex / index buffer with an offset per shape (pack()).
+
+ one batch is meant to be used from one thread at a time.
+
+*/
+
+#pragma once
+
+#include "ofxTriangleMeshCore.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// where one shape ended up in a packed buffer: its points are points[firstPoint * 2 ...],
+// its indices indices[firstIndex ...], already offset to index into the whole buffer.
+
+struct ofxTriangleMeshRange {
+    int firstPoint;
+    int numPoints;
+    int firstIndex;
+    int numIndices;
+};
+
+
+class ofxTriangleMeshBatch {
+
+    public :
+
+        // numThreads = 0 uses every core.  the calling thread is one of them, it works too.
+        ofxTriangleMeshBatch(int numThreads = 0);
+        ~ofxTriangleMeshBatch();
+
+        // copies don't share threads or memory, they start their own when first used
+        ofxTriangleMeshBatch(const ofxTriangleMeshBatch & other);
+        ofxTriangleMeshBatch & operator=(const ofxTriangleMeshBatch & other);
+
+        // every contour on its own, like ofxTriangleMeshCore::triangulate(contour, ...), with the batch's mode.
+        // hands back the stats of the whole batch: the counters and the per phase times are summed over the
+        // shapes (so that is cpu time), totalNanos is the wall clock time of the call,
+        // and the pool sizes are the biggest any one shape needed.  error is the first error of any shape
+        // (getStats(i) says which), bOutOfBudget is set if any shape ran out.
+        const ofxTriangleMeshStats & triangulate(const std::vector < ofxTriangleMeshPoints > & contours, float angleConstraint = -1, float sizeConstraint = -1);
+
+        const ofxTriangleMeshStats & getStats() const { return stats; }
+
+        void setMode(ofxTriangleMeshMode mode);
+        ofxTriangleMeshMode getMode();
+
+        // the budget of every shape, see ofxTriangleMeshCore::setBudget()
+        void setBudget(int maxSteinerPoints, int maxTriangles = -1, float maxMilliseconds = -1);
+
+        // every shape's mesh in vertex cache order, see ofxTriangleMeshCore::setVertexCacheOrder().
+        // the batch's acmrs are the shapes' averaged over their triangles.
+        void setVertexCacheOrder(bool bOrder, int cacheSize = 32);
+
+        // one sizing field for every shape, see ofxTriangleMeshCore::setSizing().  the threads only read it.
+        void setSizing(const ofxTriangleMeshSizing * sizing);
+
+        // every contour simplified first, see ofxTriangleMeshCore::setSimplify()
+        void setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER, float maxEdgeLength = -1);
+
+        // 0 = every core.  changing it stops the threads, they are started again on the next triangulate()
+        void setNumThreads(int numThreads);
+        int getNumThreads() const;
+
+        // the results of the last call, in the same order as the contours
+        int getNumShapes() const { return numShapes; }
+        const std::vector < float > & getPoints(int shape) const { return results[shape].points; }
+        const std::vector < unsigned int > & getIndices(int shape) const { return results[shape].indices; }
+        const ofxTriangleMeshStats & getStats(int shape) const { return results[shape].stats; }
+
+        // all shapes in one buffer, x0 y0 x1 y1 ... and 3 indices per triangle, plus where every shape is in it.
+        void pack(std::vector < float > & points, std::vector < unsigned int > & indices, std::vector < ofxTriangleMeshRange > & ranges) const;
+
+        // gives the threads and all of the memory back (they come back on the next triangulate())
+        void release();
+
+    protected:
+
+        struct result {
+            std::vector < float > points;
+            std::vector < unsigned int > indices;
+            ofxTriangleMeshStats stats;
+        };
+
+        // one per thread: its core, and the contours it still has to do ([begin, end) into the batch).
+        // the owner takes from the end, thieves from the begin.
+        struct worker {
+            ofxTriangleMeshCore core;
+            std::mutex lock;
+            int begin, end;
+        };
+
+        void start();
+        void stop();
+        void threadMain(int which, unsigned int seen);
+        void work(int which);
+        bool takeTask(int which, int & task);
+        void runTask(int which, int task);
+
+        ofxTriangleMeshMode mode;
+        int maxSteinerPoints, maxTriangles;
+        float maxMilliseconds;
+        bool bVertexCacheOrder;
+        int vertexCacheSize;
+        const ofxTriangleMeshSizing * sizing;
+        float simplifyTolerance;
+        ofxTriangleMeshSimplifyMethod simplifyMethod;
+        float simplifyMaxEdgeLength;
+        int numThreads;
+
+        std::vector < worker * > workers;           // workers[0] is the calling thread
+        std::vector < std::thread > threads;        // one less than workers
+
+        std::mutex lock;                            // guards generation, busy and bQuit
+        std::condition_variable wakeUp, allDone;
+        unsigned int generation;                    // goes up by one for every batch
+        int busy;                                   // threads that haven't finished the current batch
+        bool bQuit;
+
+        // the current call
+        const std::vector < ofxTriangleMeshPoints > * contours;
+        float angleConstraint, sizeConstraint;
+
+        std::vector < result > results;             // only grows, so the buffers are reused
+        int numShapes;
+        ofxTriangleMeshStats stats;
+
+};
@@ -0,0 +1,123 @@
+#include "ofxTriangleMeshCache.h"
+#include <cstring>
+
+using namespace std;
+
+
+
+// a few multiplies per point: a lot less than triangulating it
+static inline uint64_t hashWord(uint64_t h, uint64_t word){
+    h ^= word * 0x9E3779B97F4A7C15ULL;
+    h = (h << 31) | (h >> 33);
+    return h * 0xBF58476D1CE4E5B9ULL;
+}
+
+
+ofxTriangleMeshCache::ofxTriangleMeshCache(size_t maxBytes){
+    this->maxBytes = maxBytes;
+    bytes = 0;
+    hash = 0;
+    hits = misses = evictions = 0;
+}
+
+void ofxTriangleMeshCache::setMaxBytes(size_t newMaxBytes){
+    maxBytes = newMaxBytes;
+    evict(0);
+}
+
+void ofxTriangleMeshCache::resetCounters(){
+    hits = misses = evictions = 0;
+}
+
+void ofxTriangleMeshCache::clear(){
+    entries.clear();
+    lookup.clear();
+    bytes = 0;
+}
+
+
+void ofxTriangleMeshCache::setKey(const vector < ofxTriangleMeshPoints > & rings, const double * settings, int numSettings){
+
+    key.assign(settings, settings + numSettings);
+    for (int i = 0; i < rings.size(); i++){
+        const ofxTriangleMeshPoints & ring = rings[i];
+        key.push_back(ring.size());
+        for (int j = 0; j < ring.size(); j++){
+            key.push_back(ring.x(j));
+            key.push_back(ring.y(j));
+        }
+    }
+
+    hash = key.size();
+    for (int i = 0; i < key.size(); i++){
+        uint64_t word;
+        memcpy(&word, &key[i], sizeof(word));
+        hash = hashWord(hash, word);
+    }
+    hash ^= hash >> 29;
+}
+
+
+bool ofxTriangleMeshCache::find(vector < float > & points, vector < unsigned int > & indices, ofxTriangleMeshStats & stats){
+
+    unordered_map < uint64_t, entryIterator >::iterator found = lookup.find(hash);
+
+    if (found == lookup.end() || found->second->key != key){
+        misses++;
+        return false;
+    }
+
+    entryIterator it = found->second;
+    entries.splice(entries.begin(), entries, it);
+
+    points.assign(it->points.begin(), it->points.end());
+    indices.assign(it->indices.begin(), it->indices.end());
+    stats = it->stats;
+
+    hits++;
+    return true;
+}
+
+
+void ofxTriangleMeshCache::store(const vector < float > & points, const vector < unsigned int > & indices, const ofxTriangleMeshStats & stats){
+
+    // what the entry costs: its buffers, and roughly what the list and the map spend on it
+    size_t entryBytes = sizeof(entry) + 4 * sizeof(void *) + sizeof(pair < uint64_t, entryIterator >) +
+                        key.size() * sizeof(double) + points.size() * sizeof(float) + indices.size() * sizeof(unsigned int);
+
+    if (entryBytes > maxBytes) return;
+
+    // a different input with the same hash (or this one again) makes way
+    unordered_map < uint64_t, entryIterator >::iterator found = lookup.find(hash);
+    if (found != lookup.end()) erase(found->second);
+
+    evict(entryBytes);
+
+    entries.push_front(entry());
+    entry & e = entries.front();
+    e.hash = hash;
+    e.key = key;
+    e.points = points;
+    e.indices = indices;
+    e.stats = stats;
+    e.bytes = entryBytes;
+
+    lookup[hash] = entries.begin();
+    bytes += entryBytes;
+}
+
+
+// the least recently used entries go, until neededBytes more fit under the cap
+
+void ofxTriangleMeshCache::evict(size_t neededBytes){
+    while (!entries.empty() && bytes + neededBytes > maxBytes){
+        erase(--entries.end());
+        evictions++;
+    }
+}
+
+void ofxTriangleMeshCache::erase(entryIterator it){
+    bytes -= it->bytes;
+    lookup.erase(it->hash);
+    entries.erase(it);
+}
@@ -0,0 +1,88 @@
+/*!
+
+ ofxTriangleMeshCache
+
+ remembers the meshes of the last few inputs, for shapes that come back over and over
+ (glyphs, ui masks, the same blob templates), so they aren't triangulated again.
+
+ an input is known by its points and every setting that changes the result (mode, algorithm, angle
+ and size constraints, budget, which rings are holes).  a 64 bit hash of all that finds the entry, and the
+ input itself is kept with it and compared, so two inputs with the same hash never mix up.
+
+ the least recently used meshes go first once the cache holds more than its byte cap.
+ the cap is 0 by default, which turns it off: nothing is hashed or kept.
+
+ ofxTriangleMesh has one (see setCacheSize()), in front of its triangulate() calls.
+ without openFrameworks, call setKey() and find() before ofxTriangleMeshCore::triangulate(), and store() after a miss.
+
+*/
+
+#pragma once
+
+#include "ofxTriangleMeshCore.h"
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+
+class ofxTriangleMeshCache {
+
+    public :
+
+        ofxTriangleMeshCache(size_t maxBytes = 0);
+
+        // how much memory the meshes (and their inputs) may take, 0 = off.  making it smaller evicts right away.
+        void setMaxBytes(size_t maxBytes);
+        size_t getMaxBytes() const { return maxBytes; }
+        bool isEnabled() const { return maxBytes > 0; }
+
+        // the input of the next find() / store(): the rings, and the settings that change the result
+        void setKey(const std::vector < ofxTriangleMeshPoints > & rings, const double * settings, int numSettings);
+
+        // the mesh of the key, if there is one: copied into points / indices, and made the most recently used.
+        // stats are the ones of the call that made the mesh.
+        bool find(std::vector < float > & points, std::vector < unsigned int > & indices, ofxTriangleMeshStats & stats);
+
+        // keeps the mesh of the key (unless it alone is bigger than the cap), evicting old ones to make room
+        void store(const std::vector < float > & points, const std::vector < unsigned int > & indices, const ofxTriangleMeshStats & stats);
+
+        void clear();
+
+        int getNumEntries() const { return entries.size(); }
+        size_t getBytes() const { return bytes; }
+
+        long long getHits() const { return hits; }
+        long long getMisses() const { return misses; }
+        long long getEvictions() const { return evictions; }
+        void resetCounters();
+
+    protected:
+
+        struct entry {
+            uint64_t hash;
+            std::vector < double > key;             // the settings, and then every ring's size and points
+            std::vector < float > points;
+            std::vector < unsigned int > indices;
+            ofxTriangleMeshStats stats;
+            size_t bytes;
+        };
+
+        typedef std::list < entry >::iterator entryIterator;
+
+        void evict(size_t neededBytes);
+        void erase(entryIterator it);
+
+        std::list < entry > entries;                // most recently used first
+        std::unordered_map < uint64_t, entryIterator > lookup;
+
+        std::vector < double > key;                 // the current key, reused from call to call
+        uint64_t hash;
+
+        size_t maxBytes;
+        size_t bytes;
+
+        long long hits, misses, evictions;
+
+};
@@ -0,0 +1,618 @@
+#include "ofxTriangleMeshCore.h"
+#include "triangle.h"
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+
+
+
+
+
+
+int triangulatePoints(triangulateparams * params, triangulateio * in, triangulateio * mid,
+                      triangulateio * out, triangulateworkspace * ws){
+
+    // this funciton, which calls triangulage is because we have a function called triangulate, so the compiler get's a bit confused.
+    // (with a workspace, triangle keeps its memory around, and the output arrays belong to the workspace)
+    // (the settings go in as a struct, no switch string is built or parsed)
+    return triangulatewith(params, in,  mid, out, ws);
+}
+
+
+// triangle's user test ("u"), for every triangle refinement looks at
+static int isTooBigForSizing(REAL * triorg, REAL * tridest, REAL * triapex, REAL area, void * sizing){
+    return ((const ofxTriangleMeshSizing *) sizing)->isTooBig(triorg, tridest, triapex, area) ? 1 : 0;
+}
+
+
+ofxTriangleMeshPoints::ofxTriangleMeshPoints(){
+    data = NULL;
+    count = 0;
+    stride = 0;
+    yOffset = 0;
+    bDouble = false;
+}
+
+ofxTriangleMeshPoints::ofxTriangleMeshPoints(const float * xy, int count, int stride, int yOffset){
+    this->data = (const char *) xy;
+    this->count = count;
+    this->stride = stride;
+    this->yOffset = yOffset;
+    this->bDouble = false;
+}
+
+ofxTriangleMeshPoints::ofxTriangleMeshPoints(const double * xy, int count, int stride, int yOffset){
+    this->data = (const char *) xy;
+    this->count = count;
+    this->stride = stride;
+    this->yOffset = yOffset;
+    this->bDouble = true;
+}
+
+
+static long long nanoTime(){
+    return chrono::duration_cast < chrono::nanoseconds > (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ofxTriangleMeshStats::ofxTriangleMeshStats(){
+    memset(this, 0, sizeof(ofxTriangleMeshStats));
+}
+
+
+ofxTriangleMeshCore::ofxTriangleMeshCore(){
+    mode = OFX_TRIANGLE_MESH_FILTER_CENTROIDS;
+    algorithm = OFX_TRIANGLE_MESH_DIVIDE_AND_CONQUER;
+    numThreads = 1;
+    maxSteinerPoints = -1;
+    maxTriangles = -1;
+    maxMilliseconds = -1;
+    bVertexCacheOrder = false;
+    vertexCacheSize = 32;
+    sizing = NULL;
+    contourPoints = 0;
+    bFilter = false;
+    bRefining = false;
+    outputCostNanos = 0;
+}
+
+void ofxTriangleMeshCore::setMode(ofxTriangleMeshMode newMode){
+    mode = newMode;
+}
+
+ofxTriangleMeshMode ofxTriangleMeshCore::getMode(){
+    return mode;
+}
+
+void ofxTriangleMeshCore::setAlgorithm(ofxTriangleMeshAlgorithm newAlgorithm){
+    algorithm = newAlgorithm;
+}
+
+void ofxTriangleMeshCore::setThreads(int newNumThreads){
+    numThreads = max(newNumThreads, 0);
+}
+
+void ofxTriangleMeshCore::setBudget(int maxSteinerPoints, int maxTriangles, float maxMilliseconds){
+    this->maxSteinerPoints = maxSteinerPoints;
+    this->maxTriangles = maxTriangles;
+    this->maxMilliseconds = maxMilliseconds;
+}
+
+void ofxTriangleMeshCore::setVertexCacheOrder(bool bOrder, int cacheSize){
+    bVertexCacheOrder = bOrder;
+    vertexCacheSize = max(cacheSize, 4);
+}
+
+void ofxTriangleMeshCore::setSizing(const ofxTriangleMeshSizing * sizing){
+    this->sizing = sizing;
+}
+
+void ofxTriangleMeshCore::setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method, float maxEdgeLength){
+    simplify.setup(tolerance, method, maxEdgeLength);
+}
+
+void ofxTriangleMeshCore::stopRefining(){
+    bRefining = false;
+}
+
+void ofxTriangleMeshCore::clear(){
+    points.clear();
+    indices.clear();
+    stats = ofxTriangleMeshStats();
+    bRefining = false;
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMeshCore::triangulate(const ofxTriangleMeshPoints & contour, float angleConstraint, float sizeConstraint){
+
+    if (mode == OFX_TRIANGLE_MESH_CONSTRAINED){
+        rings.clear();
+        rings.push_back(contour);
+        return triangulateRings(rings, 1, angleConstraint, sizeConstraint);
+    }
+
+    long long startTime = nanoTime();
+
+    // simplified, the contour that's triangulated is also the one the triangles are filtered with
+    contourPoints = contour.size();
+    const ofxTriangleMeshPoints * input = &contour;
+    if (simplify.isEnabled()){
+        rings.clear();
+        rings.push_back(contour);
+        input = &simplifyRings(rings)[0];
+    }
+
+    int bSize = input->size();
+
+    // triangle reads whatever is in these, so start from all zeros / NULL
+    struct triangulateio in;
+    memset(&in, 0, sizeof(in));
+
+    // the workspace's vectors only grow, so after the first few calls this doesn't allocate
+    vector < REAL > & pointlist = workspace.pointlist;
+    pointlist.resize(max(bSize, 1) * 2);
+
+    in.numberofpoints = bSize;
+    in.pointlist = &pointlist[0];
+
+    for(int i = 0; i < bSize; i++) {
+		in.pointlist[i*2+0] = input->x(i);
+        in.pointlist[i*2+1] = input->y(i);
+    }
+
+    triangulateInput(in, angleConstraint, sizeConstraint, input);
+
+    return finishStats(startTime);
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMeshCore::triangulate(const vector < ofxTriangleMeshPoints > & outlines, const vector < ofxTriangleMeshPoints > & holes, float angleConstraint, float sizeConstraint){
+
+    rings.clear();
+    rings.insert(rings.end(), outlines.begin(), outlines.end());
+    rings.insert(rings.end(), holes.begin(), holes.end());
+
+    return triangulateRings(rings, outlines.size(), angleConstraint, sizeConstraint);
+}
+
+
+// every ring becomes a closed loop of segments.  rings from firstHole on are holes, and
+// we have to give triangle a point inside each of them so it knows where to start eating.
+
+const ofxTriangleMeshStats & ofxTriangleMeshCore::triangulateRings(const vector < ofxTriangleMeshPoints > & contours, int firstHole, float angleConstraint, float sizeConstraint){
+
+    long long startTime = nanoTime();
+
+    contourPoints = 0;
+    for (int i = 0; i < contours.size(); i++) contourPoints += contours[i].size();
+
+    const vector < ofxTriangleMeshPoints > & rings = simplify.isEnabled() ? simplifyRings(contours) : contours;
+
+    int nPts = 0;
+    for (int i = 0; i < rings.size(); i++){
+        if (rings[i].size() >= 3) nPts += rings[i].size();
+    }
+
+    struct triangulateio in;
+    memset(&in, 0, sizeof(in));
+
+    workspace.pointlist.resize((nPts + 1) * 2);
+    workspace.segmentlist.resize((nPts + 1) * 2);
+    workspace.holelist.resize((rings.size() - firstHole + 1) * 2);
+
+    in.pointlist = &workspace.pointlist[0];
+    in.segmentlist = &workspace.segmentlist[0];
+    in.holelist = &workspace.holelist[0];
+
+    for (int i = 0; i < rings.size(); i++){
+
+        const ofxTriangleMeshPoints & ring = rings[i];
+        int bSize = ring.size();
+        if (bSize < 3) continue;
+
+        int start = in.numberofpoints;
+        for (int j = 0; j < bSize; j++){
+            in.pointlist[in.numberofpoints*2+0] = ring.x(j);
+            in.pointlist[in.numberofpoints*2+1] = ring.y(j);
+            in.numberofpoints++;
+        }
+
+        // every edge of the (closed) ring becomes a segment.
+        // zero length edges (repeated points) are skipped, triangle doesn't like them.
+
+        REAL * pts = in.pointlist + start * 2;
+
+        for (int j = 0; j < bSize; j++){
+            int next = (j + 1) % bSize;
+            if (pts[j*2+0] == pts[next*2+0] && pts[j*2+1] == pts[next*2+1]) continue;
+            in.segmentlist[in.numberofsegments*2+0] = start + j;
+            in.segmentlist[in.numberofsegments*2+1] = start + next;
+            in.numberofsegments++;
+        }
+
+        float seedX, seedY;
+        if (i >= firstHole && findHoleSeed(i, rings, seedX, seedY)){
+            in.holelist[in.numberofholes*2+0] = seedX;
+            in.holelist[in.numberofholes*2+1] = seedY;
+            in.numberofholes++;
+        }
+    }
+
+    triangulateInput(in, angleConstraint, sizeConstraint, NULL);
+
+    return finishStats(startTime);
+}
+
+
+// every contour simplified into its own buffer (kept between calls), and a view of it.
+// a ring that comes out with less than 3 points is skipped by triangulateRings(), like one that came in that way.
+
+const vector < ofxTriangleMeshPoints > & ofxTriangleMeshCore::simplifyRings(const vector < ofxTriangleMeshPoints > & contours){
+
+    if (simplified.size() < contours.size()) simplified.resize(contours.size());
+    simplifiedRings.clear();
+
+    for (int i = 0; i < contours.size(); i++){
+        vector < double > & ring = simplified[i];
+        simplify.simplify(contours[i], ring);
+        simplifiedRings.push_back(ring.empty() ? ofxTriangleMeshPoints() : ofxTriangleMeshPoints(&ring[0], ring.size() / 2));
+    }
+
+    return simplifiedRings;
+}
+
+
+// the call is over: whatever wasn't spent inside triangle was spent in the wrapper.
+
+const ofxTriangleMeshStats & ofxTriangleMeshCore::finishStats(long long startTime){
+    stats.totalNanos = nanoTime() - startTime;
+    stats.wrapperNanos = stats.totalNanos - (stats.inputNanos + stats.delaunayNanos + stats.segmentNanos +
+                                             stats.holeNanos + stats.qualityNanos + stats.outputNanos);
+    return stats;
+}
+
+
+// runs triangle on a filled in triangulateio, and fills points / indices from the result.
+// if filterContour is set, the input has no segments, and triangles whose center is outside of that contour are dropped.
+
+void ofxTriangleMeshCore::triangulateInput(struct triangulateio & in, float angleConstraint, float sizeConstraint, const ofxTriangleMeshPoints * filterContour){
+
+    points.clear();
+    indices.clear();
+    stats = ofxTriangleMeshStats();
+    stats.contourPoints = contourPoints;
+    stats.inputPoints = in.numberofpoints;
+    bRefining = false;
+
+    // triangle would only complain (and print) about less than three points
+    if (in.numberofpoints < 3) return;
+
+    bool bConstrained = (filterContour == NULL);
+
+    struct triangulateio out;
+    memset(&out, 0, sizeof(out));
+
+    bool bConstrainAngle = false;
+    bool bConstrainSize = false;
+
+    if (angleConstraint > 0) bConstrainAngle = true;
+    if (sizeConstraint > 0) bConstrainSize = true;
+
+
+
+    // the settings go straight to triangle, the same ones the switches "zQ" and these would give
+    struct triangulateparams params;
+    triparamsinit(&params);
+
+    if (algorithm == OFX_TRIANGLE_MESH_INCREMENTAL){
+        params.algorithm = TRI_INCREMENTAL;
+        params.brio = 1;
+    }
+    if (algorithm == OFX_TRIANGLE_MESH_SWEEPLINE) params.algorithm = TRI_SWEEPLINE;
+    params.threads = numThreads;
+
+    params.nobisect = 1;            // Prohibits the insertion of Steiner points (extra points) on the mesh boundary. ("Y")
+
+    if (bConstrained == true){
+        params.poly = 1;            // triangulate the segments (PSLG), and carve away everything outside of them ("p")
+        params.nopolywritten = 1;   // don't hand the segments back, we don't use them ("P")
+    }
+
+    if (bConstrainAngle == true){
+        params.minangle = angleConstraint;
+    }
+
+    if (bConstrainSize == true){
+        params.maxarea = sizeConstraint;
+    }
+
+    if (sizing != NULL && sizing->isSetup()){
+        params.unsuitable = isTooBigForSizing;
+        params.unsuitabledata = (void *) sizing;
+    }
+
+    params.steiner = maxSteinerPoints;
+
+    // with an arena, the memory of the last call all goes back now (the output has been copied out of it)
+    workspace.rewind();
+
+    // the rest of the budget is the workspace's
+    triworkspacebudget(workspace.getTriangleWorkspace(), maxTriangles, (long long) (maxMilliseconds * 1000000.0));
+
+    int status = triangulatePoints(&params, &in, &out, NULL, workspace.getTriangleWorkspace());
+
+    if (status != TRI_OK){
+        // nothing in out can be used, leave the mesh empty
+        stats.error = (ofxTriangleMeshError) status;
+        return;
+    }
+
+    // the filter looks at the contour once per triangle, so its edges are sorted into bands first.
+    // it's a copy, refine() filters with it again after the contour is gone.
+    bFilter = (filterContour != NULL);
+    if (bFilter) filterPolygon.setup(*filterContour);
+
+    readOutput(out);
+}
+
+
+// anytime refinement: triangle kept the mesh and its queue of bad triangles in the workspace,
+// and goes on from there.  the whole mesh comes back, and goes through the same filter / order as before.
+
+const ofxTriangleMeshStats & ofxTriangleMeshCore::refine(int maxSteinerPoints, float maxMilliseconds){
+
+    if (!bRefining) return stats;
+
+    long long startTime = nanoTime();
+
+    int inputPoints = stats.inputPoints;
+    points.clear();
+    indices.clear();
+    stats = ofxTriangleMeshStats();
+    stats.contourPoints = contourPoints;
+    stats.inputPoints = inputPoints;
+    bRefining = false;
+
+    struct triangulateio out;
+    memset(&out, 0, sizeof(out));
+
+    // maxMilliseconds is for the whole call, but triangle only stops refining: the mesh is written out again
+    // after that, which takes about as long as last time.  refining gets what's left, and at least half,
+    // so a mesh that takes longer than a frame to write out still gets somewhere.
+    long long refineNanos = (long long) (maxMilliseconds * 1000000.0);
+    if (refineNanos > 0) refineNanos = max(refineNanos - outputCostNanos, refineNanos / 2);
+
+    triworkspacebudget(workspace.getTriangleWorkspace(), maxTriangles, refineNanos);
+
+    int status = trirefine(workspace.getTriangleWorkspace(), maxSteinerPoints, &out);
+
+    if (status != TRI_OK){
+        stats.error = (ofxTriangleMeshError) status;
+        return finishStats(startTime);
+    }
+
+    readOutput(out);
+
+    return finishStats(startTime);
+}
+
+
+// triangle's output (and stats) -> points / indices, dropping the triangles outside of filterPolygon if bFilter
+
+void ofxTriangleMeshCore::readOutput(struct triangulateio & out){
+
+    long long startTime = nanoTime();
+
+    struct triangulatestats triStats;
+    triworkspacestats(workspace.getTriangleWorkspace(), &triStats);
+
+    stats.inputNanos = triStats.inputnanoseconds;
+    stats.delaunayNanos = triStats.delaunaynanoseconds;
+    stats.segmentNanos = triStats.segmentnanoseconds;
+    stats.holeNanos = triStats.holenanoseconds;
+    stats.qualityNanos = triStats.qualitynanoseconds;
+    stats.outputNanos = triStats.outputnanoseconds;
+    stats.incircleTests = triStats.incirclecount;
+    stats.orientationTests = triStats.counterclockcount;
+    stats.hyperbolaTests = triStats.hyperbolacount;
+    stats.circumcenters = triStats.circumcentercount;
+    stats.circleTops = triStats.circletopcount;
+    stats.steinerPoints = triStats.steinerpoints;
+    stats.vertexPoolBytes = triStats.vertexpoolbytes;
+    stats.trianglePoolBytes = triStats.trianglepoolbytes;
+    stats.subsegPoolBytes = triStats.subsegpoolbytes;
+    stats.viriPoolBytes = triStats.viripoolbytes;
+    stats.badSubsegPoolBytes = triStats.badsubsegpoolbytes;
+    stats.badTrianglePoolBytes = triStats.badtrianglepoolbytes;
+    stats.flipStackerPoolBytes = triStats.flipstackerpoolbytes;
+    stats.splayNodePoolBytes = triStats.splaynodepoolbytes;
+    stats.allocations = triStats.allocations;
+    stats.allocatedBytes = triStats.allocatedbytes;
+    stats.bOutOfBudget = triStats.outofbudget != 0;
+    bRefining = trirefining(workspace.getTriangleWorkspace()) != 0;
+
+
+    // remap[i] says what output point triangle's point i became, -1 = not used by any triangle we kept.
+    // a flat table instead of maps: one slot per triangle point, no allocation per point.
+
+    vector < int > & remap = workspace.remap;
+    remap.assign(out.numberofpoints, -1);
+
+    // the kept triangles go straight into indices, still with triangle's indices (fixed up below)
+
+    for (int i = 0; i < out.numberoftriangles; i++) {
+
+        int * index = &out.trianglelist[i * 3];
+
+        // here we check if a triangle is "inside" a contour to drop non inner triangles
+        // (in constrained mode triangle already removed the outside ones)
+        // (the center is worked out in floats, like the points we hand back)
+
+        if (bFilter){
+            float cx = 0, cy = 0;
+            for (int j = 0; j < 3; j++){
+                cx += (float) out.pointlist[index[j] * 2 + 0];
+                cy += (float) out.pointlist[index[j] * 2 + 1];
+            }
+            if (!filterPolygon.isInside(cx / 3, cy / 3)) continue;
+        }
+
+        // mark the good points
+        for (int j = 0; j < 3; j++){
+            remap[index[j]] = 0;
+            indices.push_back(index[j]);
+        }
+    }
+
+    // put all good points in points and handle the remapping of indices.
+    // the indices stored above were for all points, but since we drop triangles, we
+    // can drop non used points, and then remap all the indces.
+    // that happens here:
+
+    // (walking the table in order keeps the points in the same order as triangle's output)
+
+    int nPts = 0;
+    for (int i = 0; i < out.numberofpoints; i++){
+        if (remap[i] < 0) continue;
+        remap[i] = nPts++;
+        points.push_back(out.pointlist[i * 2 + 0]);
+        points.push_back(out.pointlist[i * 2 + 1]);
+    }
+
+    // now, with the new, potentially smaller group of points, update all the indices so they point right:
+
+    for (int i = 0; i < indices.size(); i++){
+        indices[i] = remap[indices[i]];
+    }
+
+    stats.triangles = getNumTriangles();
+
+    // both measured with the cache size the order is made for, so the two numbers can be compared
+
+    if (bVertexCacheOrder && !indices.empty()){
+        stats.acmrBefore = order.getACMR(indices, nPts, vertexCacheSize);
+        order.optimize(points, indices, vertexCacheSize);
+        stats.acmrAfter = order.getACMR(indices, nPts, vertexCacheSize);
+    }
+
+    // what handing this mesh back cost, triangle's part and ours.  the next refine() takes it off its time.
+    outputCostNanos = stats.outputNanos + (nanoTime() - startTime);
+
+    // nothing to free: the output arrays belong to the workspace, and get reused next time.
+}
+
+
+// find a point inside of "ring" that is not inside the shape (even-odd over all rings), ie, a point in a hole.
+// we cut the ring with a horizontal line between two of its vertices, and look at the pieces of that line
+// that are inside the ring, split up by all of the other rings.  an island sitting inside of a hole
+// makes a piece "inside" again, so we take the widest piece that has an even number of crossings to its left.
+
+bool ofxTriangleMeshCore::findHoleSeed(int whichRing, const vector < ofxTriangleMeshPoints > & rings, float & seedX, float & seedY){
+
+    const ofxTriangleMeshPoints & ring = rings[whichRing];
+    int N = ring.size();
+
+    vector < float > & ys = workspace.ys;
+    vector < pair < float, float > > & gaps = workspace.gaps;
+    vector < float > & ringX = workspace.ringX;
+    vector < float > & allX = workspace.allX;
+
+    ys.clear();
+    for (int i = 0; i < N; i++) ys.push_back(ring.y(i));
+    sort(ys.begin(), ys.end());
+
+    // try the scanlines through the biggest vertical gaps first
+    gaps.clear();
+    for (int i = 1; i < N; i++){
+        if (ys[i] > ys[i-1]) gaps.push_back(make_pair(ys[i] - ys[i-1], (ys[i] + ys[i-1]) * 0.5f));
+    }
+    sort(gaps.rbegin(), gaps.rend());
+
+    for (int g = 0; g < gaps.size() && g < 4; g++){
+
+        float y = gaps[g].second;
+
+        ringX.clear();
+        allX.clear();
+
+        for (int r = 0; r < rings.size(); r++){
+            const ofxTriangleMeshPoints & other = rings[r];
+            int M = other.size();
+            if (M < 3) continue;
+            for (int i = 0; i < M; i++){
+                float x1 = other.x(i), y1 = other.y(i);
+                float x2 = other.x((i + 1) % M), y2 = other.y((i + 1) % M);
+                if (y > min(y1,y2) && y <= max(y1,y2) && y1 != y2){
+                    float x = (y-y1)*(x2-x1)/(y2-y1)+x1;
+                    allX.push_back(x);
+                    if (r == whichRing) ringX.push_back(x);
+                }
+            }
+        }
+
+        sort(ringX.begin(), ringX.end());
+        sort(allX.begin(), allX.end());
+
+        float bestWidth = 0;
+
+        for (int i = 0; i + 1 < ringX.size(); i += 2){
+            for (int j = 0; j + 1 < allX.size(); j++){
+                // piece [allX[j], allX[j+1]] has j+1 crossings to its left
+                if (j % 2 == 0) continue;
+                float x0 = max(allX[j], ringX[i]);
+                float x1 = min(allX[j+1], ringX[i+1]);
+                if (x1 - x0 > bestWidth){
+                    bestWidth = x1 - x0;
+                    seedX = (x0 + x1) * 0.5f;
+                    seedY = y;
+                }
+            }
+        }
+
+        if (bestWidth > 0) return true;
+    }
+
+    return false;
+}
+
+
+// Point inside polygon by Theo / paul bourke (even-odd)
+
+bool ofxTriangleMeshCore::isPointInsidePolygon(const ofxTriangleMeshPoints & polygon, float x, float y)
+{
+    int counter = 0;
+    int i;
+    int N = polygon.size();
+    double xinters;
+    float p1x, p1y, p2x, p2y;
+
+    if (N == 0) return false;
+
+    p1x = polygon.x(0);
+    p1y = polygon.y(0);
+
+    for (i=1;i<=N;i++)
+    {
+        p2x = polygon.x(i % N);
+        p2y = polygon.y(i % N);
+        if (y > min(p1y,p2y)) {
+            if (y <= max(p1y,p2y)) {
+                if (x <= max(p1x,p2x)) {
+                    if (p1y != p2y) {
+                        xinters = (y-p1y)*(p2x-p1x)/(p2y-p1y)+p1x;
+                        if (p1x == p2x || x <= xinters){
+                            counter++;
+						}
+                    }
+                }
+            }
+        }
+        p1x = p2x;
+        p1y = p2y;
+    }
+	return counter % 2 != 0;
+}
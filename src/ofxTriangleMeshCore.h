@@ -0,0 +1,282 @@
+/*!
+
+ ofxTriangleMeshCore
+
+ the part of ofxTriangleMesh that talks to triangle, without any openFrameworks types,
+ so it can be built and benchmarked on its own (see CMakeLists.txt and bench/).
+
+ points go in as ofxTriangleMeshPoints views, the result comes out as flat buffers:
+ points (x0 y0 x1 y1 ...) for every point used by a triangle, and 3 indices into them per triangle.
+ ofxTriangleMesh is a thin layer on top that turns these into an ofMesh, meshTriangles, etc.
+
+*/
+
+#pragma once
+
+#include "ofxTriangleMeshWorkspace.h"
+#include "ofxTriangleMeshOrder.h"
+#include "ofxTriangleMeshPolygon.h"
+#include "ofxTriangleMeshSizing.h"
+#include "ofxTriangleMeshSimplify.h"
+#include <vector>
+#include <cstddef>
+
+
+struct triangulateio;
+
+
+// how triangulate() decides which triangles are inside the contour:
+//
+// OFX_TRIANGLE_MESH_FILTER_CENTROIDS : the points are triangulated on their own (unconstrained delaunay) and
+//                                      every output triangle whose center is outside the contour is dropped.
+//                                      this is the original behavior, but the test is (triangles x contour points),
+//                                      which gets slow for big contours (5k+ points).
+//
+// OFX_TRIANGLE_MESH_CONSTRAINED      : the contour edges are passed to triangle as segments (the "p" switch), so the
+//                                      edges of the contour are always edges of the mesh and triangle eats away the
+//                                      outside itself, in linear time.  no post filtering is needed.
+
+enum ofxTriangleMeshMode {
+    OFX_TRIANGLE_MESH_FILTER_CENTROIDS,
+    OFX_TRIANGLE_MESH_CONSTRAINED
+};
+
+
+// how triangle builds the delaunay triangulation.  all give the same mesh (but for ties between points on a circle).
+//
+// OFX_TRIANGLE_MESH_DIVIDE_AND_CONQUER : the default, and the fastest for most inputs.
+// OFX_TRIANGLE_MESH_INCREMENTAL        : one point after the other, in a randomized order sorted along a hilbert curve
+//                                        (triangle's "b" switch), so each point is found by a short walk from the last.
+//                                        about as fast as divide and conquer on big point clouds.
+// OFX_TRIANGLE_MESH_SWEEPLINE          : fortune's sweepline ("F").  not exact everywhere.
+
+enum ofxTriangleMeshAlgorithm {
+    OFX_TRIANGLE_MESH_DIVIDE_AND_CONQUER,
+    OFX_TRIANGLE_MESH_INCREMENTAL,
+    OFX_TRIANGLE_MESH_SWEEPLINE
+};
+
+
+// a view of xy points that live somewhere else, so they can go to triangle without being copied first.
+// the first point's x is at data, its y yOffset bytes after it, and the next point starts stride bytes later.
+// that covers ofPolyline, vectors of glm::vec2 / ofVec2f / cv::Point2f, or a plain interleaved array:
+//
+//      ofxTriangleMeshPoints(polyline.getVertices())                           // any vector of things with .x and .y
+//      ofxTriangleMeshPoints(&myVec2s[0].x, myVec2s.size(), sizeof(myVec2s[0]))
+//      ofxTriangleMeshPoints(xyArray, count)                                   // x0 y0 x1 y1 ...
+//
+// for separate x and y arrays (x0 x1 x2 ... y0 y1 y2 ...) use the constructor with yOffset, in bytes.
+// nothing is owned, the points have to stay alive until triangulate() returns.
+
+struct ofxTriangleMeshPoints {
+
+    ofxTriangleMeshPoints();
+    ofxTriangleMeshPoints(const float * xy, int count, int stride = 2 * sizeof(float), int yOffset = sizeof(float));
+    ofxTriangleMeshPoints(const double * xy, int count, int stride = 2 * sizeof(double), int yOffset = sizeof(double));
+
+    template < class T >
+    ofxTriangleMeshPoints(const std::vector < T > & points){
+        *this = points.empty() ? ofxTriangleMeshPoints() :
+                ofxTriangleMeshPoints(&points[0].x, points.size(), sizeof(T), (const char *) &points[0].y - (const char *) &points[0].x);
+    }
+
+    int size() const { return count; }
+
+    double x(int i) const {
+        const char * p = data + (size_t) i * stride;
+        return bDouble ? *(const double *) p : *(const float *) p;
+    }
+    double y(int i) const {
+        const char * p = data + (size_t) i * stride + yOffset;
+        return bDouble ? *(const double *) p : *(const float *) p;
+    }
+
+    const char * data;
+    int count;
+    int stride;
+    int yOffset;
+    bool bDouble;
+};
+
+
+
+// what went wrong, if anything (stats.error).  triangle used to end the whole program instead.
+// after an error the mesh is empty, and the next call works as usual.  (same numbers as triangle's TRI_ codes)
+
+enum ofxTriangleMeshError {
+    OFX_TRIANGLE_MESH_OK,
+    OFX_TRIANGLE_MESH_ERROR_INPUT,          // triangle couldn't use the points (all the same, too few, ...)
+    OFX_TRIANGLE_MESH_ERROR_MEMORY,         // out of memory
+    OFX_TRIANGLE_MESH_ERROR_INTERNAL        // triangle found a bug in itself
+};
+
+
+
+// what the last triangulation did, for profiling (nothing is printed).
+// times are nanoseconds on a monotonic clock.  the triangle phases are the ones its "V" switch reports,
+// wrapperNanos is everything around triangle: copying the input, finding hole seeds, filtering, output buffers.
+
+struct ofxTriangleMeshStats {
+
+    ofxTriangleMeshStats();
+
+    long long inputNanos;           // triangle reading the points
+    long long delaunayNanos;        // the delaunay triangulation itself
+    long long segmentNanos;         // inserting the contour segments (constrained mode)
+    long long holeNanos;            // eating away holes and the outside (constrained mode)
+    long long qualityNanos;         // adding steiner points for the angle / size constraints
+    long long outputNanos;          // triangle writing its output arrays
+    long long wrapperNanos;
+    long long totalNanos;           // the whole call
+
+    long incircleTests;             // geometric predicates triangle evaluated
+    long orientationTests;
+    long hyperbolaTests;
+    long circumcenters;
+    long circleTops;
+
+    int contourPoints;              // the points of the contours, and what's left of them after setSimplify()
+    int inputPoints;
+    int steinerPoints;              // points triangle added
+    int triangles;                  // triangles kept
+
+    size_t vertexPoolBytes;         // the most memory each of triangle's pools had in use
+    size_t trianglePoolBytes;
+    size_t subsegPoolBytes;
+    size_t viriPoolBytes;
+    size_t badSubsegPoolBytes;
+    size_t badTrianglePoolBytes;
+    size_t flipStackerPoolBytes;
+    size_t splayNodePoolBytes;
+
+    long allocations;               // blocks of memory triangle took (from malloc() or the workspace's arena) during the call
+    size_t allocatedBytes;
+
+    ofxTriangleMeshError error;
+    bool bOutOfBudget;              // the budget ran out, so the angle / size constraints may not be met everywhere
+    bool bCached;                   // the mesh came out of a cache (see ofxTriangleMeshCache.h), triangle wasn't called
+
+    float acmrBefore;               // with setVertexCacheOrder(): points transformed per triangle in triangle's order,
+    float acmrAfter;                // and after reordering (see ofxTriangleMeshOrder.h).  0 when it's off.
+};
+
+
+
+class ofxTriangleMeshCore {
+
+    public :
+
+        ofxTriangleMeshCore();
+
+        // same parameters as ofxTriangleMesh: -1 = don't use constraint,
+        // angleConstraint is the minimum angle (20-30 is good), sizeConstraint the maximum triangle area.
+
+        // each call hands back the stats of that call (same as getStats() afterwards)
+
+        const ofxTriangleMeshStats & triangulate(const ofxTriangleMeshPoints & contour, float angleConstraint = -1, float sizeConstraint = -1);
+
+        // several contours (and holes) in one go, always constrained, whatever the mode is.
+        const ofxTriangleMeshStats & triangulate(const std::vector < ofxTriangleMeshPoints > & outlines, const std::vector < ofxTriangleMeshPoints > & holes, float angleConstraint = -1, float sizeConstraint = -1);
+
+        // every ring becomes a closed loop of segments.  rings from firstHole on are holes, and get a seed point
+        // in an empty (even-odd) area so triangle knows where to start eating.  firstHole = 0 means "find out".
+        const ofxTriangleMeshStats & triangulateRings(const std::vector < ofxTriangleMeshPoints > & rings, int firstHole, float angleConstraint = -1, float sizeConstraint = -1);
+
+        const ofxTriangleMeshStats & getStats() const { return stats; }
+
+        void setMode(ofxTriangleMeshMode mode);
+        ofxTriangleMeshMode getMode();
+
+        void setAlgorithm(ofxTriangleMeshAlgorithm algorithm);
+        ofxTriangleMeshAlgorithm getAlgorithm() const { return algorithm; }
+
+        // divide and conquer on several threads, for big point clouds: 1 = one thread (the default), 0 = one per core.
+        // the mesh is the same for any number of threads.
+        void setThreads(int numThreads);
+        int getThreads() const { return numThreads; }
+
+        // a hard limit on the work the angle / size constraints can cause (-1 = no limit):
+        // at most this many points added, this many triangles, and this much time for the whole call.
+        // when one runs out, refining stops and you get the mesh as it is at that point (see stats.bOutOfBudget).
+        // handy with angles above ~34, where triangle might never finish.
+        void setBudget(int maxSteinerPoints, int maxTriangles = -1, float maxMilliseconds = -1);
+
+        // after a triangulation the budget cut short (any of its limits), go on refining where it stopped: at most this many
+        // more points and this much time (-1 = no limit, instead of setBudget()'s), and the triangle limit of setBudget().  every call hands back the whole
+        // mesh, a bit better than the last one, so an app can show a coarse mesh at once and refine it every frame
+        // until isRefining() says it's done.  stats.steinerPoints counts all the points added so far.
+        // handing the whole mesh back takes time in proportion to its size, and comes out of maxMilliseconds.  once that
+        // alone takes longer than maxMilliseconds, a call takes that long plus half of maxMilliseconds of refining.
+        const ofxTriangleMeshStats & refine(int maxSteinerPoints = -1, float maxMilliseconds = -1);
+        bool isRefining() const { return bRefining; }
+
+        // the mesh in points / indices isn't the one triangle has anymore (ofxTriangleMesh puts cached, live and
+        // batch meshes there), so refine() has nothing to go on with
+        void stopRefining();
+
+        // reorder the triangles for the gpu's vertex cache (of cacheSize points), and number the points in the order
+        // they are first used, after every triangulation.  off by default, see ofxTriangleMeshOrder.h.
+        void setVertexCacheOrder(bool bOrder, int cacheSize = 32);
+        bool getVertexCacheOrder() const { return bVertexCacheOrder; }
+
+        // a maximum triangle area that changes over the shape, on top of sizeConstraint (NULL = none, the default).
+        // not copied: it has to stay alive, and unchanged, while this triangulates or refines.  see ofxTriangleMeshSizing.h
+        void setSizing(const ofxTriangleMeshSizing * sizing);
+        const ofxTriangleMeshSizing * getSizing() const { return sizing; }
+
+        // fewer points on every contour before it's triangulated, within tolerance of the original (0 = off, the default),
+        // and with maxEdgeLength, long edges split again with points of the original.  see ofxTriangleMeshSimplify.h
+        void setSimplify(float tolerance, ofxTriangleMeshSimplifyMethod method = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER, float maxEdgeLength = -1);
+
+        int getNumTriangles() const { return indices.size() / 3; }
+
+        // the reference point in polygon test (even-odd), walks every edge.  for lots of points, see ofxTriangleMeshPolygon.h
+        static bool isPointInsidePolygon(const ofxTriangleMeshPoints & polygon, float x, float y);
+
+        void clear();
+
+        std::vector < float > points;               // x0 y0 x1 y1 ... of the points used by the triangles, in triangle's order
+        std::vector < unsigned int > indices;       // 3 per triangle, into points
+
+        ofxTriangleMeshMode mode;
+        ofxTriangleMeshAlgorithm algorithm;
+        int numThreads;
+        ofxTriangleMeshStats stats;
+
+        int maxSteinerPoints;
+        int maxTriangles;
+        float maxMilliseconds;
+
+        bool bVertexCacheOrder;
+        int vertexCacheSize;
+        ofxTriangleMeshOrder order;
+
+        const ofxTriangleMeshSizing * sizing;
+
+        ofxTriangleMeshSimplify simplify;
+
+        // triangle's memory and our buffers, kept between calls so re-meshing every frame doesn't allocate.
+        // workspace.getMemoryUsage() tells you how big it got, workspace.release() gives it back.
+        ofxTriangleMeshWorkspace workspace;
+
+    protected:
+
+        void triangulateInput(struct triangulateio & in, float angleConstraint, float sizeConstraint, const ofxTriangleMeshPoints * filterContour);
+        void readOutput(struct triangulateio & out);
+        const ofxTriangleMeshStats & finishStats(long long startTime);
+        bool findHoleSeed(int whichRing, const std::vector < ofxTriangleMeshPoints > & rings, float & seedX, float & seedY);
+        const std::vector < ofxTriangleMeshPoints > & simplifyRings(const std::vector < ofxTriangleMeshPoints > & contours);
+
+        std::vector < ofxTriangleMeshPoints > rings;    // the contours of the current call, kept so it isn't reallocated every time
+        int contourPoints;                              // the points that came in, for stats.contourPoints
+
+        // with setSimplify(): the points of every simplified ring, and views of them
+        std::vector < std::vector < double > > simplified;
+        std::vector < ofxTriangleMeshPoints > simplifiedRings;
+
+        ofxTriangleMeshPolygon filterPolygon;           // the contour of the centroid filter, set up once per call
+        bool bFilter;                                   // the last triangulation is filtered with filterPolygon
+        bool bRefining;                                 // triangle can go on refining the last triangulation
+        long long outputCostNanos;                      // what writing out and reading the last mesh took
+
+};
@@ -0,0 +1,368 @@
+#include "ofxTriangleMeshLive.h"
+#include "triangle.h"
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+
+
+static long long nanoTime(){
+    return chrono::duration_cast < chrono::nanoseconds > (chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ofxTriangleMeshLive::ofxTriangleMeshLive(){
+    maxChange = 0.25;
+    numEdits = -1;
+    bEdited = false;
+}
+
+void ofxTriangleMeshLive::setMaxChange(float fraction){
+    maxChange = max(fraction, 0.0f);
+}
+
+bool ofxTriangleMeshLive::isLive(){
+    return triliveactive(workspace.getTriangleWorkspace()) != 0;
+}
+
+void ofxTriangleMeshLive::clear(){
+    points.clear();
+    indices.clear();
+    stats = ofxTriangleMeshStats();
+    rings.clear();
+    numEdits = -1;
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::triangulate(const ofxTriangleMeshPoints & contour){
+    oneRing.clear();
+    oneRing.push_back(contour);
+    return triangulate(oneRing);
+}
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::triangulate(const vector < ofxTriangleMeshPoints > & rings){
+    long long startTime = nanoTime();
+    startOver(rings);
+    return finishStats(startTime);
+}
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::update(const ofxTriangleMeshPoints & contour){
+    oneRing.clear();
+    oneRing.push_back(contour);
+    return update(oneRing);
+}
+
+
+// every ring is diffed against its last frame, and the difference is made with edits.
+// if any of that doesn't work out, whatever was edited so far doesn't matter: we start over.
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::update(const vector < ofxTriangleMeshPoints > & rings){
+
+    long long startTime = nanoTime();
+
+    if (bEdited || rings.size() != this->rings.size() || !isLive()){
+        startOver(rings);
+        return finishStats(startTime);
+    }
+
+    stats = ofxTriangleMeshStats();
+
+    int nPts = 0;
+    for (int i = 0; i < this->rings.size(); i++) nPts += this->rings[i].ids.size();
+    int maxEdits = (int) (maxChange * nPts);
+
+    numEdits = 0;
+    for (int i = 0; i < rings.size(); i++){
+        copyRing(rings[i], newXY);
+        if (!editRing(this->rings[i], newXY, maxEdits)){
+            startOver(rings);
+            return finishStats(startTime);
+        }
+    }
+
+    stats.delaunayNanos = nanoTime() - startTime;
+    for (int i = 0; i < this->rings.size(); i++) stats.inputPoints += this->rings[i].ids.size();
+
+    writeOutput();
+    return finishStats(startTime);
+}
+
+
+int ofxTriangleMeshLive::addPoint(float x, float y){
+    int id;
+    bEdited = true;
+    if (triliveinsert(workspace.getTriangleWorkspace(), x, y, &id) != TRI_OK) return -1;
+    return id;
+}
+
+bool ofxTriangleMeshLive::removePoint(int id){
+    bEdited = true;
+    return trilivedelete(workspace.getTriangleWorkspace(), id) == TRI_OK;
+}
+
+bool ofxTriangleMeshLive::movePoint(int id, float x, float y){
+    bEdited = true;
+    return trilivemove(workspace.getTriangleWorkspace(), id, x, y) == TRI_OK;
+}
+
+bool ofxTriangleMeshLive::addSegment(int id1, int id2){
+    bEdited = true;
+    return trilivesegment(workspace.getTriangleWorkspace(), id1, id2) == TRI_OK;
+}
+
+bool ofxTriangleMeshLive::removeSegment(int id1, int id2){
+    bEdited = true;
+    return triliveunsegment(workspace.getTriangleWorkspace(), id1, id2) == TRI_OK;
+}
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::updateOutput(){
+    long long startTime = nanoTime();
+    stats = ofxTriangleMeshStats();
+    writeOutput();
+    return finishStats(startTime);
+}
+
+
+// the rings' points (without repeats) and their edges go to triangle in one go, inside a frame
+// with as much room again around the shape on every side, so it can move around for a while.
+
+void ofxTriangleMeshLive::startOver(const vector < ofxTriangleMeshPoints > & rings){
+
+    points.clear();
+    indices.clear();
+    stats = ofxTriangleMeshStats();
+    numEdits = -1;
+    bEdited = false;
+
+    vector < double > & pointlist = workspace.pointlist;
+    vector < int > & segmentlist = workspace.segmentlist;
+    pointlist.clear();
+    segmentlist.clear();
+
+    this->rings.resize(rings.size());
+
+    for (int i = 0; i < rings.size(); i++){
+
+        ring & r = this->rings[i];
+        copyRing(rings[i], r.xy);
+        r.ids.clear();
+
+        int bSize = r.xy.size() / 2;
+        if (bSize < 3){
+            r.xy.clear();
+            continue;
+        }
+
+        int start = pointlist.size() / 2;
+        for (int j = 0; j < bSize; j++){
+            pointlist.push_back(r.xy[j*2+0]);
+            pointlist.push_back(r.xy[j*2+1]);
+            segmentlist.push_back(start + j);
+            segmentlist.push_back(start + (j + 1) % bSize);
+            r.ids.push_back(start + j);
+        }
+    }
+
+    stats.inputPoints = pointlist.size() / 2;
+
+    // triangle would only complain about less than three points
+    if (stats.inputPoints < 3) return;
+
+    double xmin = pointlist[0], xmax = pointlist[0];
+    double ymin = pointlist[1], ymax = pointlist[1];
+    for (int i = 0; i < pointlist.size(); i += 2){
+        xmin = min(xmin, pointlist[i]);
+        xmax = max(xmax, pointlist[i]);
+        ymin = min(ymin, pointlist[i+1]);
+        ymax = max(ymax, pointlist[i+1]);
+    }
+    double margin = max(xmax - xmin, ymax - ymin) + 1;
+
+    struct triangulateio in;
+    memset(&in, 0, sizeof(in));
+    in.pointlist = &pointlist[0];
+    in.numberofpoints = pointlist.size() / 2;
+    in.segmentlist = &segmentlist[0];
+    in.numberofsegments = segmentlist.size() / 2;
+
+    struct triangulateworkspace * ws = workspace.getTriangleWorkspace();
+    int status = trilivebegin(ws, &in, xmin - margin, ymin - margin, xmax + margin, ymax + margin);
+
+    if (status != TRI_OK){
+        stats.error = (ofxTriangleMeshError) status;
+        return;
+    }
+
+    struct triangulatestats triStats;
+    triworkspacestats(ws, &triStats);
+
+    stats.inputNanos = triStats.inputnanoseconds;
+    stats.delaunayNanos = triStats.delaunaynanoseconds;
+    stats.segmentNanos = triStats.segmentnanoseconds;
+    stats.holeNanos = triStats.holenanoseconds;
+    stats.incircleTests = triStats.incirclecount;
+    stats.orientationTests = triStats.counterclockcount;
+    stats.vertexPoolBytes = triStats.vertexpoolbytes;
+    stats.trianglePoolBytes = triStats.trianglepoolbytes;
+    stats.subsegPoolBytes = triStats.subsegpoolbytes;
+    stats.viriPoolBytes = triStats.viripoolbytes;
+    stats.allocations = triStats.allocations;
+    stats.allocatedBytes = triStats.allocatedbytes;
+
+    writeOutput();
+}
+
+
+// one ring, from the last frame's points to these.
+//
+// - as many points as before : the ones that aren't where they were moved, and triangle takes their edges along
+// - otherwise                : the points that are the same at the start and at the end stay, the old ones
+//                              between them are deleted (with their edges), the new ones inserted,
+//                              and chained up to the points either side of the change
+//
+// false = that didn't work, or it would take more than maxEdits edits (counted over all rings).
+
+bool ofxTriangleMeshLive::editRing(ring & r, vector < double > & xy, int maxEdits){
+
+    int nOld = r.ids.size();
+    int nNew = xy.size() / 2;
+
+    if (nOld < 3 || nNew < 3) return nOld < 3 && nNew < 3;
+
+    struct triangulateworkspace * ws = workspace.getTriangleWorkspace();
+
+    if (nOld == nNew){
+
+        for (int i = 0; i < nNew; i++){
+            if (r.xy[i*2+0] != xy[i*2+0] || r.xy[i*2+1] != xy[i*2+1]) numEdits++;
+        }
+        if (numEdits > maxEdits) return false;
+
+        for (int i = 0; i < nNew; i++){
+            if (r.xy[i*2+0] == xy[i*2+0] && r.xy[i*2+1] == xy[i*2+1]) continue;
+            if (trilivemove(ws, r.ids[i], xy[i*2+0], xy[i*2+1]) != TRI_OK) return false;
+        }
+
+    } else {
+
+        int p = 0;
+        while (p < nOld && p < nNew && r.xy[p*2+0] == xy[p*2+0] && r.xy[p*2+1] == xy[p*2+1]) p++;
+
+        int s = 0;
+        while (s < nOld - p && s < nNew - p &&
+               r.xy[(nOld-1-s)*2+0] == xy[(nNew-1-s)*2+0] && r.xy[(nOld-1-s)*2+1] == xy[(nNew-1-s)*2+1]) s++;
+
+        int removed = nOld - p - s;
+        int added = nNew - p - s;
+
+        numEdits += max(removed, added);
+        if (p + s < 2 || numEdits > maxEdits) return false;
+
+        // the points either side of the change (the ring wraps around)
+        int before = r.ids[p > 0 ? p - 1 : nOld - 1];
+        int after = r.ids[s > 0 ? nOld - s : 0];
+
+        for (int i = p; i < nOld - s; i++){
+            if (trilivedelete(ws, r.ids[i]) != TRI_OK) return false;
+        }
+        if (removed == 0 && triliveunsegment(ws, before, after) != TRI_OK) return false;
+
+        newIds.clear();
+        for (int i = p; i < nNew - s; i++){
+            int id;
+            if (triliveinsert(ws, xy[i*2+0], xy[i*2+1], &id) != TRI_OK) return false;
+            newIds.push_back(id);
+        }
+
+        int prev = before;
+        for (int i = 0; i < newIds.size(); i++){
+            if (trilivesegment(ws, prev, newIds[i]) != TRI_OK) return false;
+            prev = newIds[i];
+        }
+        if (trilivesegment(ws, prev, after) != TRI_OK) return false;
+
+        r.ids.erase(r.ids.begin() + p, r.ids.begin() + (nOld - s));
+        r.ids.insert(r.ids.begin() + p, newIds.begin(), newIds.end());
+    }
+
+    // the new points are the old ones next time (and the old buffer is filled next time)
+    r.xy.swap(xy);
+    return true;
+}
+
+
+// the points of a ring, leaving out repeats: a point the same as the one before it,
+// and the first point again at the end (a closed polyline).
+
+void ofxTriangleMeshLive::copyRing(const ofxTriangleMeshPoints & contour, vector < double > & xy){
+
+    xy.clear();
+
+    for (int i = 0; i < contour.size(); i++){
+        double x = contour.x(i);
+        double y = contour.y(i);
+        if (!xy.empty() && x == xy[xy.size() - 2] && y == xy[xy.size() - 1]) continue;
+        xy.push_back(x);
+        xy.push_back(y);
+    }
+
+    while (xy.size() > 2 && xy[0] == xy[xy.size() - 2] && xy[1] == xy[xy.size() - 1]){
+        xy.resize(xy.size() - 2);
+    }
+}
+
+
+// triangle's mesh -> points / indices, leaving out the points no triangle uses (same as ofxTriangleMeshCore)
+
+bool ofxTriangleMeshLive::writeOutput(){
+
+    long long startTime = nanoTime();
+
+    points.clear();
+    indices.clear();
+
+    struct triangulateio out;
+    memset(&out, 0, sizeof(out));
+
+    int status = trilivewrite(workspace.getTriangleWorkspace(), &out);
+
+    if (status != TRI_OK){
+        stats.error = (ofxTriangleMeshError) status;
+        return false;
+    }
+
+    vector < int > & remap = workspace.remap;
+    remap.assign(out.numberofpoints, -1);
+
+    for (int i = 0; i < out.numberoftriangles * 3; i++){
+        remap[out.trianglelist[i]] = 0;
+        indices.push_back(out.trianglelist[i]);
+    }
+
+    int nPts = 0;
+    for (int i = 0; i < out.numberofpoints; i++){
+        if (remap[i] < 0) continue;
+        remap[i] = nPts++;
+        points.push_back(out.pointlist[i * 2 + 0]);
+        points.push_back(out.pointlist[i * 2 + 1]);
+    }
+
+    for (int i = 0; i < indices.size(); i++){
+        indices[i] = remap[indices[i]];
+    }
+
+    stats.triangles = getNumTriangles();
+    stats.outputNanos += nanoTime() - startTime;
+    return true;
+}
+
+
+const ofxTriangleMeshStats & ofxTriangleMeshLive::finishStats(long long startTime){
+    stats.contourPoints = stats.inputPoints;        // nothing is simplified here
+    stats.totalNanos = nanoTime() - startTime;
+    stats.wrapperNanos = stats.totalNanos - (stats.inputNanos + stats.delaunayNanos + stats.segmentNanos +
+                                             stats.holeNanos + stats.qualityNanos + stats.outputNanos);
+    return stats;
+}
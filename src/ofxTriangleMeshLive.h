@@ -0,0 +1,103 @@
+/*!
+
+ ofxTriangleMeshLive
+
+ keeps the mesh of a contour alive from one frame to the next, for contours that only change a little
+ every frame (a tracked blob, a shape being drawn).  update() compares the new contour with the last one,
+ and only the points that changed are taken out of triangle's mesh and put back in, so triangle only
+ touches the triangles around them.  a few changed points cost a few local edits instead of a whole new mesh.
+
+ the mesh is the constrained delaunay triangulation of the contour (or rings, filled even-odd), the same
+ as ofxTriangleMeshCore in OFX_TRIANGLE_MESH_CONSTRAINED mode without an angle or size constraint.
+ (adding steiner points for those isn't a local change, so there aren't any here.)
+
+ when too much changed (see setMaxChange()), or a change can't be made in place (a point left the frame
+ around the mesh, landed on another point or on an edge, or edges cross), it starts over from scratch.
+
+ the edit functions (addPoint() ...) work on triangle's mesh directly, for anything that isn't a list of rings.
+ use either them or update(): after editing by hand, the next update() starts over.
+
+*/
+
+#pragma once
+
+#include "ofxTriangleMeshCore.h"
+#include <vector>
+
+
+class ofxTriangleMeshLive {
+
+    public :
+
+        ofxTriangleMeshLive();
+
+        // from scratch
+        const ofxTriangleMeshStats & triangulate(const ofxTriangleMeshPoints & contour);
+        const ofxTriangleMeshStats & triangulate(const std::vector < ofxTriangleMeshPoints > & rings);
+
+        // the next frame: the same number of rings, in the same order.
+        // the first call (or one with a different number of rings) is a triangulate().
+        const ofxTriangleMeshStats & update(const ofxTriangleMeshPoints & contour);
+        const ofxTriangleMeshStats & update(const std::vector < ofxTriangleMeshPoints > & rings);
+
+        // the stats of a call.  starting over fills them in like ofxTriangleMeshCore does,
+        // for the edits delaunayNanos is the time spent editing, outputNanos the time spent writing the mesh out.
+        const ofxTriangleMeshStats & getStats() const { return stats; }
+
+        // how many points the last update() changed (moved, added or removed), -1 if it started over
+        int getNumEdits() const { return numEdits; }
+
+        // the most points (as a fraction of all of them) an update() changes in place, 0.25 by default.
+        // more than that, and starting over is quicker.
+        void setMaxChange(float fraction);
+        float getMaxChange() const { return maxChange; }
+
+        // editing triangle's mesh by hand.  points are known by the id addPoint() hands back
+        // (after triangulate(), the points of the rings are 0, 1, 2 ... in order, repeated points left out).
+        // these return false (-1) and change nothing if they can't be done, except that a point that
+        // couldn't be moved is gone.  the mesh is only written out by updateOutput().
+        int addPoint(float x, float y);
+        bool removePoint(int id);
+        bool movePoint(int id, float x, float y);
+        bool addSegment(int id1, int id2);
+        bool removeSegment(int id1, int id2);
+        const ofxTriangleMeshStats & updateOutput();
+
+        // false before the first triangulate(), and after anything ended the mesh (edges crossing, an error).
+        bool isLive();
+
+        int getNumTriangles() const { return indices.size() / 3; }
+
+        void clear();
+
+        std::vector < float > points;               // x0 y0 x1 y1 ... of the points used by the triangles
+        std::vector < unsigned int > indices;       // 3 per triangle, into points
+
+        ofxTriangleMeshStats stats;
+
+        // holds triangle's mesh between frames
+        ofxTriangleMeshWorkspace workspace;
+
+    protected:
+
+        struct ring {
+            std::vector < double > xy;              // the points of the last frame, without repeats
+            std::vector < int > ids;                // and their ids in triangle's mesh
+        };
+
+        void startOver(const std::vector < ofxTriangleMeshPoints > & rings);
+        bool editRing(ring & r, std::vector < double > & xy, int maxEdits);
+        void copyRing(const ofxTriangleMeshPoints & contour, std::vector < double > & xy);
+        bool writeOutput();
+        const ofxTriangleMeshStats & finishStats(long long startTime);
+
+        std::vector < ring > rings;
+        std::vector < double > newXY;
+        std::vector < int > newIds;
+        std::vector < ofxTriangleMeshPoints > oneRing;
+
+        float maxChange;
+        int numEdits;
+        bool bEdited;                               // edited by hand since the rings were last known
+
+};
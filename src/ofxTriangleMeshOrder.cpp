@@ -0,0 +1,221 @@
+#include "ofxTriangleMeshOrder.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+
+
+ofxTriangleMeshOrder::ofxTriangleMeshOrder(){
+    cacheSize = 32;
+}
+
+
+// forsyth's score: the last triangle's 3 points get a flat 0.75 (whichever goes first doesn't matter),
+// after that it falls off with the position in the cache.  points with few triangles left get a boost,
+// so lone triangles are picked up before they get stranded.  no triangles left = never wanted again.
+
+float ofxTriangleMeshOrder::getPointScore(int point) const {
+
+    int left = trianglesLeft[point];
+    if (left == 0) return -1;
+
+    int position = cachePosition[point];
+    float score = (position >= 0) ? positionScores[position] : 0;
+
+    return score + ((left < valenceScores.size()) ? valenceScores[left] : 2.0f / sqrtf((float) left));
+}
+
+
+void ofxTriangleMeshOrder::optimize(vector < float > & points, vector < unsigned int > & indices, int cacheSize){
+
+    int nTriangles = indices.size() / 3;
+    int nPoints = points.size() / 2;
+    if (nTriangles == 0) return;
+
+    // the scores are looked up, they're needed for every point in the cache after every triangle
+
+    if (max(cacheSize, 4) != this->cacheSize || positionScores.empty()){
+        this->cacheSize = max(cacheSize, 4);
+        positionScores.resize(this->cacheSize);
+        for (int i = 0; i < this->cacheSize; i++){
+            positionScores[i] = (i < 3) ? 0.75f : powf(1.0f - (float) (i - 3) / (this->cacheSize - 3), 1.5f);
+        }
+        valenceScores.resize(32);
+        valenceScores[0] = 0;
+        for (int i = 1; i < valenceScores.size(); i++) valenceScores[i] = 2.0f / sqrtf((float) i);
+    }
+
+    // every point's triangles, in one flat array (counted, then filled in)
+
+    trianglesLeft.assign(nPoints, 0);
+    for (int i = 0; i < nTriangles * 3; i++) trianglesLeft[indices[i]]++;
+
+    triangleStart.resize(nPoints + 1);
+    triangleStart[0] = 0;
+    for (int i = 0; i < nPoints; i++) triangleStart[i + 1] = triangleStart[i] + trianglesLeft[i];
+
+    renumber.assign(triangleStart.begin(), triangleStart.end() - 1);     // where the next triangle of a point goes
+    pointTriangles.resize(nTriangles * 3);
+    for (int i = 0; i < nTriangles * 3; i++) pointTriangles[renumber[indices[i]]++] = i / 3;
+
+    cachePosition.assign(nPoints, -1);
+    pointScore.resize(nPoints);
+    for (int i = 0; i < nPoints; i++) pointScore[i] = getPointScore(i);
+
+    // the first triangle is the best one overall (the one with the loneliest points)
+    int best = 0;
+    triangleScore.resize(nTriangles);
+    for (int i = 0; i < nTriangles; i++){
+        const unsigned int * tri = &indices[i * 3];
+        triangleScore[i] = pointScore[tri[0]] + pointScore[tri[1]] + pointScore[tri[2]];
+        if (triangleScore[i] > triangleScore[best]) best = i;
+    }
+
+    newIndices.resize(nTriangles * 3);
+    cache.clear();
+    int nextUnused = 0;
+
+    for (int emitted = 0; emitted < nTriangles; emitted++){
+
+        // nothing in the cache has a triangle left: carry on with the first triangle that's still to go
+        if (best < 0){
+            while (triangleScore[nextUnused] < 0) nextUnused++;
+            best = nextUnused;
+        }
+
+        const unsigned int * tri = &indices[best * 3];
+        triangleScore[best] = -1;
+
+        nextCache.clear();
+
+        for (int j = 0; j < 3; j++){
+
+            int point = tri[j];
+            newIndices[emitted * 3 + j] = point;
+
+            // take the triangle out of the point's list (the ones still to go are kept at the front)
+            int * list = &pointTriangles[triangleStart[point]];
+            int last = --trianglesLeft[point];
+            for (int k = 0; k <= last; k++){
+                if (list[k] == best){
+                    swap(list[k], list[last]);
+                    break;
+                }
+            }
+
+            nextCache.push_back(point);
+        }
+
+        // the triangle's points go to the front, the rest move back.  whatever is pushed past the end
+        // is still scored once, so its triangles lose the cache bonus.
+
+        for (int i = 0; i < cache.size(); i++){
+            if (cache[i] != (int) tri[0] && cache[i] != (int) tri[1] && cache[i] != (int) tri[2]) nextCache.push_back(cache[i]);
+        }
+
+        for (int i = 0; i < nextCache.size(); i++){
+            int point = nextCache[i];
+            cachePosition[point] = (i < this->cacheSize) ? i : -1;
+            pointScore[point] = getPointScore(point);
+        }
+
+        // only triangles of points in the cache can have changed, and the next triangle is the best of them
+
+        best = -1;
+        float bestScore = -1;
+
+        for (int i = 0; i < nextCache.size(); i++){
+            int point = nextCache[i];
+            const int * list = &pointTriangles[triangleStart[point]];
+            for (int k = 0; k < trianglesLeft[point]; k++){
+                int t = list[k];
+                const unsigned int * other = &indices[t * 3];
+                float score = pointScore[other[0]] + pointScore[other[1]] + pointScore[other[2]];
+                triangleScore[t] = score;
+                if (score > bestScore){
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > this->cacheSize) nextCache.resize(this->cacheSize);
+        cache.swap(nextCache);
+    }
+
+    // number the points in the order the triangles use them.  points no triangle uses go last.
+
+    renumber.assign(nPoints, -1);
+    newPoints.resize(nPoints * 2);
+    int nNumbered = 0;
+
+    for (int i = 0; i < nTriangles * 3; i++){
+        int point = newIndices[i];
+        if (renumber[point] < 0){
+            renumber[point] = nNumbered;
+            newPoints[nNumbered * 2 + 0] = points[point * 2 + 0];
+            newPoints[nNumbered * 2 + 1] = points[point * 2 + 1];
+            nNumbered++;
+        }
+        newIndices[i] = renumber[point];
+    }
+
+    for (int i = 0; i < nPoints; i++){
+        if (renumber[i] >= 0) continue;
+        newPoints[nNumbered * 2 + 0] = points[i * 2 + 0];
+        newPoints[nNumbered * 2 + 1] = points[i * 2 + 1];
+        nNumbered++;
+    }
+
+    // swapped, not copied: the old buffers become the scratch of the next call
+    indices.swap(newIndices);
+    points.swap(newPoints);
+}
+
+
+// a point is in the fifo if fewer than cacheSize misses came after the one that put it there
+
+float ofxTriangleMeshOrder::getACMR(const vector < unsigned int > & indices, int numPoints, int cacheSize){
+
+    int nTriangles = indices.size() / 3;
+    if (nTriangles == 0) return 0;
+
+    missedAt.assign(numPoints, -1);
+    int misses = 0;
+
+    for (int i = 0; i < nTriangles * 3; i++){
+        int & at = missedAt[indices[i]];
+        if (at < 0 || misses - at > cacheSize){
+            at = misses++;
+        }
+    }
+
+    return (float) misses / nTriangles;
+}
+
+
+size_t ofxTriangleMeshOrder::getMemoryUsage() const {
+    return (triangleStart.capacity() + pointTriangles.capacity() + trianglesLeft.capacity() + cachePosition.capacity() +
+            cache.capacity() + nextCache.capacity() + renumber.capacity() + missedAt.capacity()) * sizeof(int) +
+           (pointScore.capacity() + triangleScore.capacity() + newPoints.capacity() +
+            positionScores.capacity() + valenceScores.capacity()) * sizeof(float) +
+           newIndices.capacity() * sizeof(unsigned int);
+}
+
+void ofxTriangleMeshOrder::release(){
+    vector < int >().swap(triangleStart);
+    vector < int >().swap(pointTriangles);
+    vector < int >().swap(trianglesLeft);
+    vector < int >().swap(cachePosition);
+    vector < float >().swap(pointScore);
+    vector < float >().swap(triangleScore);
+    vector < float >().swap(positionScores);
+    vector < float >().swap(valenceScores);
+    vector < int >().swap(cache);
+    vector < int >().swap(nextCache);
+    vector < unsigned int >().swap(newIndices);
+    vector < float >().swap(newPoints);
+    vector < int >().swap(renumber);
+    vector < int >().swap(missedAt);
+}
@@ -0,0 +1,68 @@
+/*!
+
+ ofxTriangleMeshOrder
+
+ puts the triangles of a mesh in an order that is kind to the gpu's vertex cache, and then numbers the
+ points in the order the triangles first use them, so the vertex buffer is read front to back too.
+
+ triangle hands its triangles back in whatever order its data structures had them, which is close to random
+ for the cache: every triangle's points have most likely been pushed out since they were last used.
+ the reordering is tom forsyth's "linear-speed vertex cache optimisation": the next triangle is always the
+ best scoring one that uses a point still in a (simulated) lru cache, where points score higher the more
+ recently they were used and the fewer triangles they have left.  linear time, no gpu needed.
+
+ how good an order is, is the acmr (average cache miss ratio): points that had to be transformed per triangle,
+ simulated on a fifo cache like the one in the hardware.  0.5 is the best a big grid can do, 3 the worst.
+
+ ofxTriangleMeshCore runs it at the end of every triangulation when setVertexCacheOrder() is on, and puts the
+ acmr before and after in its stats.  it can also be used on its own, on any flat points / indices buffers.
+ the scratch memory is kept between calls, like a workspace.  not thread safe, use one per thread.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+
+class ofxTriangleMeshOrder {
+
+    public :
+
+        ofxTriangleMeshOrder();
+
+        // reorders indices (3 per triangle) for a cache of cacheSize points, and renumbers the points
+        // (x0 y0 x1 y1 ...) in first use order.  the triangles keep their winding.
+        void optimize(std::vector < float > & points, std::vector < unsigned int > & indices, int cacheSize = 32);
+
+        // points transformed per triangle on a fifo cache of cacheSize points, 0 for no triangles
+        float getACMR(const std::vector < unsigned int > & indices, int numPoints, int cacheSize = 32);
+
+        // bytes held by the scratch buffers, release() gives them back
+        size_t getMemoryUsage() const;
+        void release();
+
+    protected:
+
+        float getPointScore(int point) const;
+
+        std::vector < int > triangleStart;          // per point: where its triangles start in pointTriangles
+        std::vector < int > pointTriangles;         // the triangles of every point, the ones still to go first
+        std::vector < int > trianglesLeft;          // per point: how many of its triangles haven't been emitted
+        std::vector < int > cachePosition;          // per point: where it is in the lru cache, -1 = not in it
+        std::vector < float > pointScore;
+        std::vector < float > positionScores;       // the score of every place in the cache
+        std::vector < float > valenceScores;        // the boost for the first few numbers of triangles left
+        std::vector < float > triangleScore;        // -1 once the triangle is emitted
+        std::vector < int > cache, nextCache;
+
+        std::vector < unsigned int > newIndices;    // the reordered triangles, and the renumbering
+        std::vector < float > newPoints;
+        std::vector < int > renumber;
+
+        std::vector < int > missedAt;               // per point: the miss that last put it in the fifo
+
+        int cacheSize;
+
+};
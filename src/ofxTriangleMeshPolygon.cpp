@@ -0,0 +1,238 @@
+#include "ofxTriangleMeshPolygon.h"
+#include "ofxTriangleMeshCore.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define POLYGON_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define POLYGON_LANES 4
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define POLYGON_LANES 4
+#else
+#define POLYGON_LANES 1
+#endif
+
+using namespace std;
+
+
+// one group of edges: ymin, ymax, xmax, x1, y1, dx, dy, each POLYGON_LANES wide
+#define GROUP_FLOATS (7 * POLYGON_LANES)
+
+
+
+// the reference, one edge per lane: a crossing if y is in (ymin, ymax], x isn't right of the edge's
+// right end, and x is left of (or on) where the edge crosses y.  the crossing is worked out in floats,
+// in the same order as isPointInsidePolygon() does it, so every edge gives the same answer.
+// the padding at the end of a band has ymin = ymax = infinity, which never counts.
+
+static bool isOddCrossings(const float * group, int numGroups, float x, float y){
+
+#if defined(__AVX2__)
+
+    __m256 px = _mm256_set1_ps(x);
+    __m256 py = _mm256_set1_ps(y);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 odd = zero;
+
+    for (int i = 0; i < numGroups; i++, group += GROUP_FLOATS){
+        __m256 inY = _mm256_and_ps(_mm256_cmp_ps(py, _mm256_loadu_ps(group), _CMP_GT_OQ),
+                                   _mm256_cmp_ps(py, _mm256_loadu_ps(group + 8), _CMP_LE_OQ));
+        __m256 hit = _mm256_and_ps(inY, _mm256_cmp_ps(px, _mm256_loadu_ps(group + 16), _CMP_LE_OQ));
+        __m256 dx = _mm256_loadu_ps(group + 40);
+        __m256 xinters = _mm256_add_ps(_mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(py, _mm256_loadu_ps(group + 32)), dx),
+                                                     _mm256_loadu_ps(group + 48)), _mm256_loadu_ps(group + 24));
+        __m256 left = _mm256_or_ps(_mm256_cmp_ps(dx, zero, _CMP_EQ_OQ), _mm256_cmp_ps(px, xinters, _CMP_LE_OQ));
+        odd = _mm256_xor_ps(odd, _mm256_and_ps(hit, left));
+    }
+
+    int mask = _mm256_movemask_ps(odd);
+
+#elif POLYGON_LANES == 4 && !defined(__ARM_NEON)
+
+    __m128 px = _mm_set1_ps(x);
+    __m128 py = _mm_set1_ps(y);
+    __m128 zero = _mm_setzero_ps();
+    __m128 odd = zero;
+
+    for (int i = 0; i < numGroups; i++, group += GROUP_FLOATS){
+        __m128 inY = _mm_and_ps(_mm_cmpgt_ps(py, _mm_loadu_ps(group)), _mm_cmple_ps(py, _mm_loadu_ps(group + 4)));
+        __m128 hit = _mm_and_ps(inY, _mm_cmple_ps(px, _mm_loadu_ps(group + 8)));
+        __m128 dx = _mm_loadu_ps(group + 20);
+        __m128 xinters = _mm_add_ps(_mm_div_ps(_mm_mul_ps(_mm_sub_ps(py, _mm_loadu_ps(group + 16)), dx),
+                                               _mm_loadu_ps(group + 24)), _mm_loadu_ps(group + 12));
+        __m128 left = _mm_or_ps(_mm_cmpeq_ps(dx, zero), _mm_cmple_ps(px, xinters));
+        odd = _mm_xor_ps(odd, _mm_and_ps(hit, left));
+    }
+
+    int mask = _mm_movemask_ps(odd);
+
+#elif POLYGON_LANES == 4
+
+    float32x4_t px = vdupq_n_f32(x);
+    float32x4_t py = vdupq_n_f32(y);
+    float32x4_t zero = vdupq_n_f32(0);
+    uint32x4_t odd = vdupq_n_u32(0);
+
+    for (int i = 0; i < numGroups; i++, group += GROUP_FLOATS){
+        uint32x4_t inY = vandq_u32(vcgtq_f32(py, vld1q_f32(group)), vcleq_f32(py, vld1q_f32(group + 4)));
+        uint32x4_t hit = vandq_u32(inY, vcleq_f32(px, vld1q_f32(group + 8)));
+        float32x4_t dx = vld1q_f32(group + 20);
+        float32x4_t xinters = vaddq_f32(vdivq_f32(vmulq_f32(vsubq_f32(py, vld1q_f32(group + 16)), dx),
+                                                  vld1q_f32(group + 24)), vld1q_f32(group + 12));
+        uint32x4_t left = vorrq_u32(vceqq_f32(dx, zero), vcleq_f32(px, xinters));
+        odd = veorq_u32(odd, vandq_u32(hit, left));
+    }
+
+    int mask = vaddvq_u32(vandq_u32(odd, vdupq_n_u32(1))) & 1;
+
+#else
+
+    int mask = 0;
+
+    for (int i = 0; i < numGroups; i++, group += GROUP_FLOATS){
+        if (y > group[0] && y <= group[1] && x <= group[2]){
+            float xinters = (y - group[4]) * group[5] / group[6] + group[3];
+            if (group[5] == 0 || x <= xinters) mask ^= 1;
+        }
+    }
+
+#endif
+
+    // every lane has its own count, the total is odd if an odd number of lanes are
+    int bits = 0;
+    for (; mask != 0; mask &= mask - 1) bits++;
+    return (bits & 1) != 0;
+}
+
+
+ofxTriangleMeshPolygon::ofxTriangleMeshPolygon(){
+    minY = maxY = maxX = 0;
+    bandScale = 0;
+    numBands = 0;
+}
+
+ofxTriangleMeshPolygon::ofxTriangleMeshPolygon(const ofxTriangleMeshPoints & polygon){
+    setup(polygon);
+}
+
+int ofxTriangleMeshPolygon::getLanes(){
+    return POLYGON_LANES;
+}
+
+
+// about one band per edge: a horizontal line crosses only a few edges of a contour, so most bands
+// end up with one or two groups.  an edge goes into every band its y range (ymin, ymax] reaches into.
+
+void ofxTriangleMeshPolygon::setup(const ofxTriangleMeshPoints & polygon){
+
+    int N = polygon.size();
+
+    edges.clear();
+    bandStart.assign(1, 0);
+    numBands = 0;
+    minY = maxY = maxX = 0;
+    bandScale = 0;
+
+    if (N == 0) return;
+
+    // the points as the reference reads them, in floats
+    minY = maxY = (float) polygon.y(0);
+    maxX = (float) polygon.x(0);
+    for (int i = 1; i < N; i++){
+        minY = min(minY, (float) polygon.y(i));
+        maxY = max(maxY, (float) polygon.y(i));
+        maxX = max(maxX, (float) polygon.x(i));
+    }
+
+    numBands = max(N, 1);
+    bandScale = (maxY > minY) ? numBands / (maxY - minY) : 0;
+
+    // count the edges of every band, then make room for them (padded to whole groups), then fill them in
+
+    bandFill.assign(numBands, 0);
+
+    for (int pass = 0; pass < 2; pass++){
+
+        float p1x = (float) polygon.x(0);
+        float p1y = (float) polygon.y(0);
+
+        for (int i = 1; i <= N; i++){
+
+            float p2x = (float) polygon.x(i % N);
+            float p2y = (float) polygon.y(i % N);
+
+            if (p1y != p2y){
+
+                float ymin = min(p1y, p2y);
+                float ymax = max(p1y, p2y);
+                int first = min((int) ((ymin - minY) * bandScale), numBands - 1);
+                int last = min((int) ((ymax - minY) * bandScale), numBands - 1);
+
+                for (int b = first; b <= last; b++){
+                    if (pass == 0){
+                        bandFill[b]++;
+                        continue;
+                    }
+                    float * group = &edges[(size_t) (bandStart[b] + bandFill[b] / POLYGON_LANES) * GROUP_FLOATS];
+                    int lane = bandFill[b] % POLYGON_LANES;
+                    group[0 * POLYGON_LANES + lane] = ymin;
+                    group[1 * POLYGON_LANES + lane] = ymax;
+                    group[2 * POLYGON_LANES + lane] = max(p1x, p2x);
+                    group[3 * POLYGON_LANES + lane] = p1x;
+                    group[4 * POLYGON_LANES + lane] = p1y;
+                    group[5 * POLYGON_LANES + lane] = p2x - p1x;
+                    group[6 * POLYGON_LANES + lane] = p2y - p1y;
+                    bandFill[b]++;
+                }
+            }
+
+            p1x = p2x;
+            p1y = p2y;
+        }
+
+        if (pass == 0){
+            bandStart.resize(numBands + 1);
+            for (int b = 0; b < numBands; b++){
+                bandStart[b + 1] = bandStart[b] + (bandFill[b] + POLYGON_LANES - 1) / POLYGON_LANES;
+                bandFill[b] = 0;
+            }
+
+            // everything starts out as padding
+            edges.assign((size_t) bandStart[numBands] * GROUP_FLOATS, 1.0f);
+            for (int g = 0; g < bandStart[numBands]; g++){
+                for (int lane = 0; lane < 2 * POLYGON_LANES; lane++) edges[(size_t) g * GROUP_FLOATS + lane] = INFINITY;
+            }
+        }
+    }
+}
+
+
+// outside the bounding box (but for the left side) no edge can count, whatever the reference computes
+
+bool ofxTriangleMeshPolygon::isInside(float x, float y) const {
+
+    if (!(y > minY && y <= maxY && x <= maxX)) return false;
+
+    int b = min((int) ((y - minY) * bandScale), numBands - 1);
+    return isOddCrossings(&edges[(size_t) bandStart[b] * GROUP_FLOATS], bandStart[b + 1] - bandStart[b], x, y);
+}
+
+void ofxTriangleMeshPolygon::isInside(const ofxTriangleMeshPoints & points, unsigned char * inside) const {
+    for (int i = 0; i < points.size(); i++){
+        inside[i] = isInside((float) points.x(i), (float) points.y(i)) ? 1 : 0;
+    }
+}
+
+void ofxTriangleMeshPolygon::isInside(const ofxTriangleMeshPoints & points, vector < unsigned char > & inside) const {
+    inside.resize(points.size());
+    if (!inside.empty()) isInside(points, &inside[0]);
+}
+
+
+size_t ofxTriangleMeshPolygon::getMemoryUsage() const {
+    return edges.capacity() * sizeof(float) + (bandStart.capacity() + bandFill.capacity()) * sizeof(int);
+}
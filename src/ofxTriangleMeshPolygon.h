@@ -0,0 +1,60 @@
+/*!
+
+ ofxTriangleMeshPolygon
+
+ a polygon made ready for lots of point in polygon tests: the same answers as
+ ofxTriangleMeshCore::isPointInsidePolygon() (which stays the reference), without walking every edge per point.
+
+ setup() cuts the polygon's height into bands and lists, for every band, the edges that reach into it,
+ so a point only looks at the edges of its own band: a handful instead of all of them.  the edges of a band
+ are tested a few at a time with simd (8 with avx2, 4 with sse2 or neon on 64 bit arm, see CMakeLists.txt),
+ with the same float math as the reference, one edge per lane.
+
+ isInside() with an ofxTriangleMeshPoints classifies a whole array of points in one call, say every particle
+ against a tracked blob, every frame.  ofxTriangleMeshCore uses one to filter triangles by their centers.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+
+struct ofxTriangleMeshPoints;
+
+
+class ofxTriangleMeshPolygon {
+
+    public :
+
+        ofxTriangleMeshPolygon();
+        ofxTriangleMeshPolygon(const ofxTriangleMeshPoints & polygon);
+
+        // (re)builds the bands for a closed polygon.  the points are copied, they don't have to stay alive.
+        void setup(const ofxTriangleMeshPoints & polygon);
+
+        bool isInside(float x, float y) const;
+
+        // inside[i] = 1 if point i is inside, 0 if not.  inside has room for points.size() answers.
+        void isInside(const ofxTriangleMeshPoints & points, unsigned char * inside) const;
+        void isInside(const ofxTriangleMeshPoints & points, std::vector < unsigned char > & inside) const;
+
+        // the edges tested at once (1 without simd)
+        static int getLanes();
+
+        size_t getMemoryUsage() const;
+
+    protected:
+
+        // the edges of every band, in groups of getLanes(), every value of a group next to each other:
+        // ymin, ymax, xmax, x1, y1, dx, dy.  horizontal edges never count, so they aren't kept at all.
+        std::vector < float > edges;
+        std::vector < int > bandStart;      // the first group of every band, and one past the last
+        std::vector < int > bandFill;       // setup only: edges put in every band so far
+
+        float minY, maxY, maxX;
+        float bandScale;                    // bands per unit of height
+        int numBands;
+
+};
@@ -0,0 +1,280 @@
+#include "ofxTriangleMeshSimplify.h"
+#include "ofxTriangleMeshCore.h"
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+using namespace std;
+
+
+typedef pair < double, int > areaEntry;
+
+
+// the distance from p to the segment a - b (not the line through it), squared
+static double getSegmentDistance2(const double * p, const double * a, const double * b){
+    double dx = b[0] - a[0];
+    double dy = b[1] - a[1];
+    double length2 = dx * dx + dy * dy;
+    double t = (length2 > 0) ? ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / length2 : 0;
+    t = min(max(t, 0.0), 1.0);
+    double ex = a[0] + t * dx - p[0];
+    double ey = a[1] + t * dy - p[1];
+    return ex * ex + ey * ey;
+}
+
+
+ofxTriangleMeshSimplify::ofxTriangleMeshSimplify(){
+    tolerance = 0;
+    method = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER;
+    maxEdgeLength = -1;
+}
+
+void ofxTriangleMeshSimplify::setup(float tolerance, ofxTriangleMeshSimplifyMethod method, float maxEdgeLength){
+    this->tolerance = tolerance;
+    this->method = method;
+    this->maxEdgeLength = maxEdgeLength;
+}
+
+
+void ofxTriangleMeshSimplify::simplify(const ofxTriangleMeshPoints & ring, vector < double > & out){
+
+    int N = ring.size();
+
+    xy.resize(max(N, 1) * 2);
+    for (int i = 0; i < N; i++){
+        xy[i * 2 + 0] = ring.x(i);
+        xy[i * 2 + 1] = ring.y(i);
+    }
+
+    out.clear();
+
+    if (!isEnabled() || N < 4){
+        out.insert(out.end(), xy.begin(), xy.begin() + N * 2);
+        return;
+    }
+
+    keep.assign(N, 0);
+    if (method == OFX_TRIANGLE_MESH_VISVALINGAM) visvalingam();
+    else douglasPeucker();
+
+    if (maxEdgeLength <= 0){
+        for (int i = 0; i < N; i++){
+            if (!keep[i]) continue;
+            out.push_back(xy[i * 2 + 0]);
+            out.push_back(xy[i * 2 + 1]);
+        }
+        return;
+    }
+
+    // how far along the ring every point is, the last one is all the way around
+
+    arcLength.resize(N + 1);
+    arcLength[0] = 0;
+    for (int i = 0; i < N; i++){
+        int j = (i + 1) % N;
+        arcLength[i + 1] = arcLength[i] + hypot(xy[j * 2 + 0] - xy[i * 2 + 0], xy[j * 2 + 1] - xy[i * 2 + 1]);
+    }
+
+    int first = 0;
+    while (!keep[first]) first++;
+
+    int from = first;
+    do {
+        int to = (from + 1) % N;
+        while (!keep[to]) to = (to + 1) % N;
+        addPoints(from, to, out);
+        from = to;
+    } while (from != first);
+}
+
+
+// a closed ring is two open spans: from the first point to the one farthest from it, and back.
+// the spans are split at their worst point until every point is within tolerance of its span.
+
+void ofxTriangleMeshSimplify::douglasPeucker(){
+
+    int N = keep.size();
+    double tolerance2 = (double) tolerance * tolerance;
+
+    int far = 1;
+    double farthest = -1;
+    for (int i = 1; i < N; i++){
+        double dx = xy[i * 2 + 0] - xy[0];
+        double dy = xy[i * 2 + 1] - xy[1];
+        if (dx * dx + dy * dy > farthest){
+            farthest = dx * dx + dy * dy;
+            far = i;
+        }
+    }
+
+    keep[0] = keep[far] = 1;
+    int numKept = 2;
+
+    // (N stands for point 0 again, at the end of the second span)
+    stack.clear();
+    stack.push_back(0);
+    stack.push_back(far);
+    stack.push_back(far);
+    stack.push_back(N);
+
+    while (!stack.empty()){
+
+        int last = stack.back();
+        stack.pop_back();
+        int first = stack.back();
+        stack.pop_back();
+
+        const double * a = &xy[first * 2];
+        const double * b = &xy[(last % N) * 2];
+
+        int worst = -1;
+        double worstDistance2 = tolerance2;
+        for (int i = first + 1; i < last; i++){
+            double distance2 = getSegmentDistance2(&xy[i * 2], a, b);
+            if (distance2 > worstDistance2){
+                worstDistance2 = distance2;
+                worst = i;
+            }
+        }
+
+        if (worst < 0) continue;
+
+        keep[worst] = 1;
+        numKept++;
+        stack.push_back(first);
+        stack.push_back(worst);
+        stack.push_back(worst);
+        stack.push_back(last);
+    }
+
+    // a ring thinner than tolerance: it still stays a triangle, with the point farthest from the other two
+    if (numKept < 3){
+        int widest = -1;
+        double widestDistance2 = -1;
+        for (int i = 1; i < N; i++){
+            if (keep[i]) continue;
+            double distance2 = getSegmentDistance2(&xy[i * 2], &xy[0], &xy[far * 2]);
+            if (distance2 > widestDistance2){
+                widestDistance2 = distance2;
+                widest = i;
+            }
+        }
+        keep[widest] = 1;
+    }
+}
+
+
+double ofxTriangleMeshSimplify::getArea(int point) const {
+    const double * a = &xy[prev[point] * 2];
+    const double * b = &xy[point * 2];
+    const double * c = &xy[next[point] * 2];
+    return fabs((b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1])) * 0.5;
+}
+
+
+// the point with the smallest triangle goes first, then its neighbors' triangles are worked out again.
+// they never get smaller than the one that just went, so points go in order of their area, as visvalingam has it.
+// the heap isn't updated in place: a point that changed gets a new entry, and the old one is skipped when it comes up.
+
+void ofxTriangleMeshSimplify::visvalingam(){
+
+    int N = keep.size();
+    double limit = (double) tolerance * tolerance;
+
+    prev.resize(N);
+    next.resize(N);
+    area.resize(N);
+    for (int i = 0; i < N; i++){
+        prev[i] = (i + N - 1) % N;
+        next[i] = (i + 1) % N;
+    }
+
+    heap.clear();
+    for (int i = 0; i < N; i++){
+        area[i] = getArea(i);
+        heap.push_back(areaEntry(area[i], i));
+    }
+    make_heap(heap.begin(), heap.end(), greater < areaEntry >());
+
+    int numLeft = N;
+
+    while (numLeft > 3 && !heap.empty()){
+
+        pop_heap(heap.begin(), heap.end(), greater < areaEntry >());
+        areaEntry smallest = heap.back();
+        heap.pop_back();
+
+        int point = smallest.second;
+        if (prev[point] < 0 || smallest.first != area[point]) continue;
+        if (smallest.first >= limit) break;
+
+        int before = prev[point];
+        int after = next[point];
+        next[before] = after;
+        prev[after] = before;
+        prev[point] = next[point] = -1;
+        numLeft--;
+
+        area[before] = max(getArea(before), smallest.first);
+        heap.push_back(areaEntry(area[before], before));
+        push_heap(heap.begin(), heap.end(), greater < areaEntry >());
+
+        area[after] = max(getArea(after), smallest.first);
+        heap.push_back(areaEntry(area[after], after));
+        push_heap(heap.begin(), heap.end(), greater < areaEntry >());
+    }
+
+    for (int i = 0; i < N; i++) keep[i] = (prev[i] >= 0);
+}
+
+
+// point from, and if the contour from there to point to is longer than maxEdgeLength, evenly spaced points on it
+// in between (by how far along it they are).  no piece is longer along the contour, so no edge is longer either.
+
+void ofxTriangleMeshSimplify::addPoints(int from, int to, vector < double > & out){
+
+    int N = keep.size();
+
+    out.push_back(xy[from * 2 + 0]);
+    out.push_back(xy[from * 2 + 1]);
+
+    // around the end of the ring, the points and lengths go on from N
+    int end = (to > from) ? to : to + N;
+    double start = arcLength[from];
+    double span = arcLength[end % N] + ((end >= N) ? arcLength[N] : 0) - start;
+
+    int pieces = (int) ceil(span / maxEdgeLength);
+    if (pieces < 2) return;
+
+    int j = from;
+    for (int k = 1; k < pieces; k++){
+
+        double along = start + span * k / pieces;
+        while (j + 1 < end && arcLength[(j + 1) % N] + ((j + 1 >= N) ? arcLength[N] : 0) < along) j++;
+
+        double at = arcLength[j % N] + ((j >= N) ? arcLength[N] : 0);
+        double segment = arcLength[j % N + 1] - arcLength[j % N];
+        double t = (segment > 0) ? min(max((along - at) / segment, 0.0), 1.0) : 0;
+        const double * a = &xy[(j % N) * 2];
+        const double * b = &xy[((j + 1) % N) * 2];
+        out.push_back(a[0] + (b[0] - a[0]) * t);
+        out.push_back(a[1] + (b[1] - a[1]) * t);
+    }
+}
+
+
+size_t ofxTriangleMeshSimplify::getMemoryUsage() const {
+    return (xy.capacity() + arcLength.capacity() + area.capacity()) * sizeof(double) + keep.capacity() +
+           (stack.capacity() + prev.capacity() + next.capacity()) * sizeof(int) + heap.capacity() * sizeof(areaEntry);
+}
+
+void ofxTriangleMeshSimplify::release(){
+    vector < double >().swap(xy);
+    vector < double >().swap(arcLength);
+    vector < unsigned char >().swap(keep);
+    vector < int >().swap(stack);
+    vector < int >().swap(prev);
+    vector < int >().swap(next);
+    vector < double >().swap(area);
+    vector < areaEntry >().swap(heap);
+}
@@ -0,0 +1,88 @@
+/*!
+
+ ofxTriangleMeshSimplify
+
+ fewer points on a contour before it's triangulated.  a contour resampled at an even spacing (or traced from an
+ image, a point per pixel) has as many points along a straight edge as around a curve, and every one of them
+ costs triangle: in the delaunay, as a segment, and as a place where refining has to add more small triangles.
+
+ the methods, for closed rings:
+
+ OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER : keeps the point farthest from the line between two kept points, as long as
+                                     it's more than tolerance away.  no point of the contour ends up farther than
+                                     tolerance from the simplified one.
+ OFX_TRIANGLE_MESH_VISVALINGAM     : drops the point that makes the smallest triangle with its neighbors, while that
+                                     area is below tolerance * tolerance.  smoother, keeps more of the overall shape,
+                                     and more points for the same tolerance (3 drops about as many as 1 above).
+
+ with maxEdgeLength, edges longer than that are split again, with the new points taken from the original contour
+ (so they're on it, not on the straight edge).  the simplification has already put the points where the contour
+ bends, so this only adds points along the flatter stretches: the spacing follows the curvature, dense on curves,
+ maxEdgeLength on the straights.  triangle can't add points on the boundary ("Y"), so long edges would otherwise
+ limit how good the triangles along them can get.
+
+ a ring always keeps at least 3 points.  a simplified ring can cross itself (or another ring) where two parts of it
+ are closer than tolerance; in constrained mode triangle meshes that, with a point where the edges cross.
+ ofxTriangleMeshCore runs it on every contour when setSimplify() is on, stats.contourPoints says how many points
+ went in.  the scratch memory is kept between calls.  not thread safe, use one per thread.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+
+struct ofxTriangleMeshPoints;
+
+
+enum ofxTriangleMeshSimplifyMethod {
+    OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER,
+    OFX_TRIANGLE_MESH_VISVALINGAM
+};
+
+
+class ofxTriangleMeshSimplify {
+
+    public :
+
+        ofxTriangleMeshSimplify();
+
+        // tolerance is a distance, 0 or less turns it off (the default).  maxEdgeLength -1 = don't resample.
+        void setup(float tolerance, ofxTriangleMeshSimplifyMethod method = OFX_TRIANGLE_MESH_DOUGLAS_PEUCKER, float maxEdgeLength = -1);
+
+        bool isEnabled() const { return tolerance > 0; }
+        float getTolerance() const { return tolerance; }
+        ofxTriangleMeshSimplifyMethod getMethod() const { return method; }
+        float getMaxEdgeLength() const { return maxEdgeLength; }
+
+        // the closed ring, simplified, into out (x0 y0 x1 y1 ...).  the kept points are in the same order.
+        // off, or with less than 4 points, the ring is copied as it is.
+        void simplify(const ofxTriangleMeshPoints & ring, std::vector < double > & out);
+
+        // bytes held by the scratch buffers, release() gives them back
+        size_t getMemoryUsage() const;
+        void release();
+
+    protected:
+
+        void douglasPeucker();
+        void visvalingam();
+        double getArea(int point) const;
+        void addPoints(int from, int to, std::vector < double > & out);
+
+        float tolerance;
+        ofxTriangleMeshSimplifyMethod method;
+        float maxEdgeLength;
+
+        std::vector < double > xy;                  // the ring, and how far along it every point is
+        std::vector < double > arcLength;
+        std::vector < unsigned char > keep;         // per point: still in the simplified ring
+        std::vector < int > stack;                  // douglas peucker: the spans still to look at, first / last
+        std::vector < int > prev, next;             // visvalingam: the ring of points that are left
+        std::vector < double > area;                // visvalingam: the area of every point's triangle
+        std::vector < std::pair < double, int > > heap;     // visvalingam: smallest area first, stale ones skipped
+
+};
@@ -0,0 +1,97 @@
+#include "ofxTriangleMeshSizing.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace std;
+
+
+static atomic < unsigned int > lastVersion(0);
+
+
+ofxTriangleMeshSizing::ofxTriangleMeshSizing(){
+    width = height = 0;
+    x0 = y0 = 0;
+    scaleX = scaleY = 0;
+    version = 0;
+}
+
+
+void ofxTriangleMeshSizing::setup(const float * maxAreas, int width, int height, float x, float y, float w, float h){
+
+    clear();
+    if (width <= 0 || height <= 0) return;
+
+    this->width = width;
+    this->height = height;
+    x0 = x;
+    y0 = y;
+    scaleX = (w > 0) ? width / w : 0;
+    scaleY = (h > 0) ? height / h : 0;
+
+    areas.resize((size_t) (width + 1) * (height + 1));
+    for (int j = 0; j <= height; j++){
+        const float * row = maxAreas + (size_t) min(j, height - 1) * width;
+        float * padded = &areas[(size_t) j * (width + 1)];
+        for (int i = 0; i < width; i++) padded[i] = (row[i] > 0) ? row[i] : INFINITY;
+        padded[width] = padded[width - 1];
+    }
+
+    version = ++lastVersion;
+}
+
+
+void ofxTriangleMeshSizing::setupFromDensity(const float * density, int width, int height, int channels, float x, float y, float w, float h,
+                                             float minArea, float maxArea){
+
+    vector < float > limits((size_t) max(width, 0) * max(height, 0));
+    float ratio = (maxArea > 0) ? minArea / maxArea : 0;
+
+    for (size_t i = 0; i < limits.size(); i++){
+        float d = min(max(density[i * max(channels, 1)], 0.0f), 1.0f);
+        limits[i] = maxArea * powf(ratio, d);
+    }
+
+    if (limits.empty()) clear();
+    else setup(&limits[0], width, height, x, y, w, h);
+}
+
+
+void ofxTriangleMeshSizing::clear(){
+    areas.clear();
+    width = height = 0;
+    version = 0;
+}
+
+
+// bilinear between the centers of the 4 cells around (x, y).  clamped to the centers of the outer cells,
+// where the padding makes the second pair of samples the same as the first.
+
+float ofxTriangleMeshSizing::getMaxArea(float x, float y) const {
+
+    if (areas.empty()) return INFINITY;
+
+    float fx = min(max((x - x0) * scaleX - 0.5f, 0.0f), (float) (width - 1));
+    float fy = min(max((y - y0) * scaleY - 0.5f, 0.0f), (float) (height - 1));
+    int ix = (int) fx;
+    int iy = (int) fy;
+    float tx = fx - ix;
+    float ty = fy - iy;
+
+    const float * cell = &areas[(size_t) iy * (width + 1) + ix];
+    float top = cell[0] + (cell[1] - cell[0]) * tx;
+    float bottom = cell[width + 1] + (cell[width + 2] - cell[width + 1]) * tx;
+    return top + (bottom - top) * ty;
+}
+
+
+bool ofxTriangleMeshSizing::isTooBig(const double * a, const double * b, const double * c, double area) const {
+    float cx = (float) ((a[0] + b[0] + c[0]) / 3);
+    float cy = (float) ((a[1] + b[1] + c[1]) / 3);
+    return area > getMaxArea(cx, cy);
+}
+
+
+size_t ofxTriangleMeshSizing::getMemoryUsage() const {
+    return areas.capacity() * sizeof(float);
+}
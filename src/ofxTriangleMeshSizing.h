@@ -0,0 +1,62 @@
+/*!
+
+ ofxTriangleMeshSizing
+
+ a maximum triangle area that changes over the shape: small triangles where there's detail, big ones elsewhere.
+ one sizeConstraint for the whole shape has to be as small as the smallest triangles anywhere, so it spends
+ most of its triangles where nobody needs them.  a sizing field typically gets the same detail with 3-10x fewer.
+
+ the field is a grid of limits over a rectangle, sampled bilinearly (the value of a cell is the limit at its center,
+ outside the rectangle the nearest cell's).  setupFromDensity() makes one from a density map, say a grayscale
+ image of where the detail is (ofxTriangleMesh::setSizing() takes an ofFloatPixels).
+
+ triangle asks about every triangle refinement makes (its "u" switch, with this as the test instead of the demo
+ triunsuitable() compiled into it): a triangle is too big if its area is above the limit at its center.
+ that's a few multiplies and 4 reads, so millions of tests are fine.  the grid is only read while meshing,
+ so batch threads can share one.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+
+class ofxTriangleMeshSizing {
+
+    public :
+
+        ofxTriangleMeshSizing();
+
+        // width x height limits, row by row, spread over the rectangle x, y, w, h.  0 or less = no limit there.
+        void setup(const float * maxAreas, int width, int height, float x, float y, float w, float h);
+
+        // from a density map (every channels-th float is used, 0..1): 1 gets minArea, 0 maxArea,
+        // and in between the areas go from one to the other geometrically, so the edges change evenly.
+        void setupFromDensity(const float * density, int width, int height, int channels, float x, float y, float w, float h,
+                              float minArea, float maxArea);
+
+        void clear();
+        bool isSetup() const { return !areas.empty(); }
+
+        float getMaxArea(float x, float y) const;
+
+        // the test triangle makes, for the corners (x, y pairs) and area of a triangle
+        bool isTooBig(const double * a, const double * b, const double * c, double area) const;
+
+        // different after every setup(), so a cached mesh made with another field isn't taken for this one's
+        unsigned int getVersion() const { return version; }
+
+        size_t getMemoryUsage() const;
+
+    protected:
+
+        // a row and a column more than the grid (copies of the last ones), so the lookup never has to check
+        std::vector < float > areas;
+        int width, height;
+        float x0, y0;
+        float scaleX, scaleY;                   // cells per unit
+        unsigned int version;
+
+};
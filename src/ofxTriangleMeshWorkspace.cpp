@@ -0,0 +1,91 @@
+#include "ofxTriangleMeshWorkspace.h"
+#include "triangle.h"
+
+
+
+ofxTriangleMeshWorkspace::ofxTriangleMeshWorkspace(){
+    triangle = NULL;
+    arena = NULL;
+    arenaChunkBytes = 0;
+}
+
+ofxTriangleMeshWorkspace::~ofxTriangleMeshWorkspace(){
+    release();
+}
+
+ofxTriangleMeshWorkspace::ofxTriangleMeshWorkspace(const ofxTriangleMeshWorkspace & other){
+    triangle = NULL;
+    arena = NULL;
+    arenaChunkBytes = other.arenaChunkBytes;
+}
+
+ofxTriangleMeshWorkspace & ofxTriangleMeshWorkspace::operator=(const ofxTriangleMeshWorkspace & other){
+    // keep our own memory, there's nothing in the other one we need.  only the allocator setting comes over,
+    // and if it changes, ours goes and is made again (the other way) next time it's asked for.
+    if (other.arenaChunkBytes != arenaChunkBytes) setArena(other.arenaChunkBytes);
+    return *this;
+}
+
+struct triangulateworkspace * ofxTriangleMeshWorkspace::getTriangleWorkspace(){
+    if (triangle == NULL){
+        triangle = triworkspacenew();
+        if (arenaChunkBytes > 0){
+            arena = triarenanew((int) arenaChunkBytes);
+            if (arena != NULL){
+                struct triallocator allocator;
+                triarenaallocator(arena, &allocator);
+                triworkspaceallocator(triangle, &allocator);
+            }
+        }
+    }
+    return triangle;
+}
+
+void ofxTriangleMeshWorkspace::setArena(size_t chunkBytes){
+    release();
+    arenaChunkBytes = chunkBytes;
+}
+
+// triangle forgets its pools and arrays (they're the arena's), then the arena starts over from its first chunk
+
+void ofxTriangleMeshWorkspace::rewind(){
+    if (triangle == NULL || arena == NULL) return;
+    triworkspaceforget(triangle);
+    triarenareset(arena);
+}
+
+size_t ofxTriangleMeshWorkspace::getMemoryUsage(){
+
+    size_t bytes = sizeof(ofxTriangleMeshWorkspace);
+
+    // with an arena, what triangle holds is in the arena's chunks
+    if (arena != NULL) bytes += triarenabytes(arena);
+    else if (triangle != NULL) bytes += triworkspacebytes(triangle);
+
+    bytes += pointlist.capacity() * sizeof(double);
+    bytes += segmentlist.capacity() * sizeof(int);
+    bytes += holelist.capacity() * sizeof(double);
+    bytes += remap.capacity() * sizeof(int);
+    bytes += (ys.capacity() + ringX.capacity() + allX.capacity()) * sizeof(float);
+    bytes += gaps.capacity() * sizeof(std::pair < float, float >);
+
+    return bytes;
+}
+
+void ofxTriangleMeshWorkspace::release(){
+
+    if (triangle != NULL) triworkspacefree(triangle);
+    triangle = NULL;
+    if (arena != NULL) triarenafree(arena);
+    arena = NULL;
+
+    // swap with empty vectors, clear() would keep the memory
+    std::vector < double >().swap(pointlist);
+    std::vector < int >().swap(segmentlist);
+    std::vector < double >().swap(holelist);
+    std::vector < int >().swap(remap);
+    std::vector < float >().swap(ys);
+    std::vector < float >().swap(ringX);
+    std::vector < float >().swap(allX);
+    std::vector < std::pair < float, float > >().swap(gaps);
+}
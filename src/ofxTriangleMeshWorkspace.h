@@ -0,0 +1,73 @@
+/*!
+
+ ofxTriangleMeshWorkspace
+
+ everything a triangulation needs that can be kept between calls:
+ triangle's memory pools and output arrays, and the input / scratch buffers the wrapper fills.
+
+ the first few calls grow it, after that re-meshing shapes of about the same size
+ (say, every frame at 60fps) doesn't touch the heap at all.
+
+ with setArena(), triangle's memory comes out of a few big chunks instead of malloc(), and every
+ triangulation (ofxTriangleMeshCore::triangulate()) takes all of it back at once when it starts.
+ that's for shapes that keep changing size: the chunks are kept, nothing is freed piece by piece.
+
+ every ofxTriangleMesh has one of these.  a workspace is not thread safe, use one per thread:
+ triangle itself keeps nothing in globals, so meshes on different threads can triangulate at the same time.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+
+struct triangulateworkspace;
+struct triarena;
+
+
+class ofxTriangleMeshWorkspace {
+
+    public :
+
+        ofxTriangleMeshWorkspace();
+        ~ofxTriangleMeshWorkspace();
+
+        // copies don't share anything, they start out empty and grow their own memory.  both take the arena setting.
+        ofxTriangleMeshWorkspace(const ofxTriangleMeshWorkspace & other);
+        ofxTriangleMeshWorkspace & operator=(const ofxTriangleMeshWorkspace & other);
+
+        // bytes held right now.  nothing is given back until release(), so this is also the high water mark.
+        size_t getMemoryUsage();
+
+        // give all of the memory back (it will grow again on the next triangulation)
+        void release();
+
+        // take triangle's memory from an arena with chunks of (at least) chunkBytes, 0 = malloc() (the default).
+        // gives all of the memory back first.  rewind() empties the arena, in one go.
+        void setArena(size_t chunkBytes);
+        size_t getArena() const { return arenaChunkBytes; }
+        void rewind();
+
+        // triangle's side, created on first use
+        struct triangulateworkspace * getTriangleWorkspace();
+
+        // input for triangle
+        std::vector < double > pointlist;
+        std::vector < int > segmentlist;
+        std::vector < double > holelist;
+
+        // scratch for the wrapper
+        std::vector < int > remap;                              // triangle's point index -> output index
+        std::vector < float > ys, ringX, allX;                  // hole seed search
+        std::vector < std::pair < float, float > > gaps;
+
+    protected:
+
+        struct triangulateworkspace * triangle;
+        struct triarena * arena;
+        size_t arenaChunkBytes;
+
+};